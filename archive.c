@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archive.h"
+#include "file.h"
+#include "hash.h"
+#include "lz4.h"
+
+/// Chunk of a chunked blob, compressed or decompressed by a job
+struct archive_chunk {
+    const uint8_t *source;
+    size_t source_size;
+    uint8_t *destination;
+    size_t destination_size;
+
+    /// Stored size once compressed
+    size_t result_size;
+    bool success;
+};
+
+/// @param[in] size Uncompressed
+/// @return Number of chunks `size` bytes are split into
+static size_t archive_chunks_count(uint64_t size) {
+    return (size + ARCHIVE_CHUNK_SIZE - 1) / ARCHIVE_CHUNK_SIZE;
+}
+
+/// @param[in] archive
+/// @param[in] entry
+/// @return `true` if `entry` lies within the file
+static bool archive_entry_valid(
+    const struct archive *archive, const struct archive_entry *entry
+) {
+    const struct archive_header *header = (const struct archive_header *) (
+        archive->content
+    );
+
+    if (
+        entry->offset % ARCHIVE_ALIGNMENT != 0 ||
+        entry->offset > archive->content_size ||
+        entry->size > archive->content_size - entry->offset
+    ) {
+        return false;
+    }
+
+    if (
+        entry->name_offset > header->names_size ||
+        entry->name_size > header->names_size - entry->name_offset
+    ) {
+        return false;
+    }
+
+    switch (entry->compression) {
+    case ARCHIVE_COMPRESSION_NONE:
+        return entry->uncompressed_size == entry->size;
+    case ARCHIVE_COMPRESSION_LZ4:
+        return true;
+    case ARCHIVE_COMPRESSION_LZ4_CHUNKED:
+        return entry->size >= sizeof(uint32_t) * archive_chunks_count(
+            entry->uncompressed_size
+        );
+    default:
+        return false;
+    }
+}
+
+bool archive_open(const char *filename, struct archive *archive) {
+    *archive = (struct archive){};
+
+    if (!file_map(filename, &archive->content, &archive->content_size)) {
+        fprintf(stderr, "archive_open: file_map failed\n");
+        return false;
+    }
+
+    const struct archive_header *header = (const struct archive_header *) (
+        archive->content
+    );
+    if (
+        archive->content_size < sizeof(*header) ||
+        header->magic != ARCHIVE_MAGIC ||
+        header->version != ARCHIVE_VERSION
+    ) {
+        fprintf(stderr, "archive_open: \"%s\" is not an archive\n", filename);
+        goto cleanup;
+    }
+
+    // The mapping is page aligned, so aligned offsets make aligned entries
+    size_t entries_size = sizeof(struct archive_entry) * header->entries_count;
+    if (
+        header->entries_offset % ARCHIVE_ALIGNMENT != 0 ||
+        header->entries_offset > archive->content_size ||
+        entries_size > archive->content_size - header->entries_offset ||
+        header->names_offset > archive->content_size ||
+        header->names_size > archive->content_size - header->names_offset
+    ) {
+        fprintf(stderr, "archive_open: \"%s\" is truncated\n", filename);
+        goto cleanup;
+    }
+
+    archive->entries = (const struct archive_entry *) (
+        archive->content + header->entries_offset
+    );
+    archive->entries_count = header->entries_count;
+    archive->names = (const char *) archive->content + header->names_offset;
+
+    for (uint32_t i = 0; i < archive->entries_count; i++) {
+        if (
+            !archive_entry_valid(archive, &archive->entries[i]) ||
+            (i > 0 && archive->entries[i - 1].hash > archive->entries[i].hash)
+        ) {
+            fprintf(
+                stderr, "archive_open: entry %u of \"%s\" is invalid\n", i, filename
+            );
+            goto cleanup;
+        }
+    }
+
+    return true;
+
+cleanup:
+    archive_close(archive);
+
+    return false;
+}
+
+void archive_close(struct archive *archive) {
+    file_unmap(archive->content, archive->content_size);
+
+    *archive = (struct archive){};
+}
+
+const struct archive_entry *archive_find(
+    const struct archive *archive, const char *name
+) {
+    size_t name_size = strlen(name);
+    uint64_t hash = hash_bytes(name, name_size, HASH_SEED);
+
+    // First entry with a hash that is not less than `hash`
+    uint32_t low = 0;
+    uint32_t high = archive->entries_count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (archive->entries[middle].hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    // Colliding hashes are next to each other
+    for (uint32_t i = low; i < archive->entries_count; i++) {
+        const struct archive_entry *entry = &archive->entries[i];
+        if (entry->hash != hash) {
+            break;
+        }
+        if (
+            entry->name_size == name_size &&
+            memcmp(&archive->names[entry->name_offset], name, name_size) == 0
+        ) {
+            return entry;
+        }
+    }
+
+    return nullptr;
+}
+
+const uint8_t *archive_blob(
+    const struct archive *archive, const struct archive_entry *entry
+) {
+    return archive->content + entry->offset;
+}
+
+bool archive_read(
+    const struct archive *archive, const struct archive_entry *entry, uint8_t *data
+) {
+    return archive_decode(nullptr, entry, archive_blob(archive, entry), data);
+}
+
+/// Runs `function` on every chunk and waits for all of them
+/// @param[in,out] jobs May be `nullptr` to run them on the calling thread
+/// @param[in] function
+/// @param[in,out] chunks
+/// @param[in] chunks_count
+static void archive_chunks_run(
+    struct jobs *jobs,
+    jobs_function function,
+    struct archive_chunk *chunks,
+    size_t chunks_count
+) {
+    struct jobs_counter counter = {};
+    for (size_t i = 0; i < chunks_count; i++) {
+        if (jobs == nullptr || !jobs_submit(jobs, function, &chunks[i], &counter)) {
+            function(&chunks[i]);
+        }
+    }
+
+    if (jobs != nullptr) {
+        jobs_counter_wait(jobs, &counter);
+    }
+}
+
+/// @param[in,out] argument `struct archive_chunk`
+static void archive_chunk_encode(void *argument) {
+    struct archive_chunk *chunk = argument;
+
+    // Chunks that do not shrink are stored as is
+    chunk->result_size = lz4_compress(
+        chunk->source, chunk->source_size, chunk->destination, chunk->source_size - 1
+    );
+    if (chunk->result_size == 0) {
+        memcpy(chunk->destination, chunk->source, chunk->source_size);
+        chunk->result_size = chunk->source_size;
+    }
+}
+
+size_t archive_encode_bound(size_t size) {
+    return sizeof(uint32_t) * archive_chunks_count(size) + size;
+}
+
+size_t archive_encode(
+    struct jobs *jobs, const uint8_t *content, size_t content_size, uint8_t *blob
+) {
+    size_t chunks_count = archive_chunks_count(content_size);
+    size_t table_size = sizeof(uint32_t) * chunks_count;
+    if (chunks_count == 0) {
+        return 0;
+    }
+
+    struct archive_chunk *chunks = malloc(sizeof(chunks[0]) * chunks_count);
+    if (chunks == nullptr) {
+        fprintf(stderr, "archive_encode: malloc failed\n");
+        return 0;
+    }
+
+    // Every chunk is compressed in place of its uncompressed bytes, which it
+    // never outgrows, then moved down behind the previous one
+    for (size_t i = 0; i < chunks_count; i++) {
+        size_t offset = ARCHIVE_CHUNK_SIZE * i;
+        size_t size = content_size - offset;
+        chunks[i] = (struct archive_chunk){
+            .source = content + offset,
+            .source_size = size < ARCHIVE_CHUNK_SIZE ? size : ARCHIVE_CHUNK_SIZE,
+            .destination = blob + table_size + offset,
+        };
+    }
+
+    archive_chunks_run(jobs, archive_chunk_encode, chunks, chunks_count);
+
+    size_t blob_size = table_size;
+    for (size_t i = 0; i < chunks_count; i++) {
+        uint32_t stored_size = (uint32_t) chunks[i].result_size;
+        memcpy(blob + sizeof(stored_size) * i, &stored_size, sizeof(stored_size));
+        memmove(blob + blob_size, chunks[i].destination, stored_size);
+        blob_size += stored_size;
+    }
+
+    free(chunks);
+
+    return blob_size;
+}
+
+/// @param[in,out] argument `struct archive_chunk`
+static void archive_chunk_decode(void *argument) {
+    struct archive_chunk *chunk = argument;
+
+    if (chunk->source_size == chunk->destination_size) {
+        memcpy(chunk->destination, chunk->source, chunk->source_size);
+        chunk->success = true;
+        return;
+    }
+
+    chunk->success = lz4_decompress(
+        chunk->source, chunk->source_size, chunk->destination, chunk->destination_size
+    );
+}
+
+/// @param[in,out] jobs
+/// @param[in] entry
+/// @param[in] blob
+/// @param[out] data
+/// @return `true` on success and `false` otherwise
+static bool archive_chunks_decode(
+    struct jobs *jobs,
+    const struct archive_entry *entry,
+    const uint8_t *blob,
+    uint8_t *data
+) {
+    size_t chunks_count = archive_chunks_count(entry->uncompressed_size);
+    size_t table_size = sizeof(uint32_t) * chunks_count;
+    if (entry->size < table_size) {
+        fprintf(stderr, "archive_chunks_decode: chunk table is truncated\n");
+        return false;
+    }
+    if (chunks_count == 0) {
+        return true;
+    }
+
+    struct archive_chunk *chunks = malloc(sizeof(chunks[0]) * chunks_count);
+    if (chunks == nullptr) {
+        fprintf(stderr, "archive_chunks_decode: malloc failed\n");
+        return false;
+    }
+
+    bool success = false;
+
+    uint64_t offset = table_size;
+    for (size_t i = 0; i < chunks_count; i++) {
+        uint32_t stored_size;
+        memcpy(&stored_size, blob + sizeof(stored_size) * i, sizeof(stored_size));
+
+        size_t size = entry->uncompressed_size - ARCHIVE_CHUNK_SIZE * i;
+        if (size > ARCHIVE_CHUNK_SIZE) {
+            size = ARCHIVE_CHUNK_SIZE;
+        }
+        if (stored_size > size || stored_size > entry->size - offset) {
+            fprintf(stderr, "archive_chunks_decode: chunk %zu is invalid\n", i);
+            goto cleanup;
+        }
+
+        chunks[i] = (struct archive_chunk){
+            .source = blob + offset,
+            .source_size = stored_size,
+            .destination = data + ARCHIVE_CHUNK_SIZE * i,
+            .destination_size = size,
+        };
+        offset += stored_size;
+    }
+
+    archive_chunks_run(jobs, archive_chunk_decode, chunks, chunks_count);
+
+    for (size_t i = 0; i < chunks_count; i++) {
+        if (!chunks[i].success) {
+            fprintf(stderr, "archive_chunks_decode: lz4_decompress(%zu) failed\n", i);
+            goto cleanup;
+        }
+    }
+
+    success = true;
+
+cleanup:
+    free(chunks);
+
+    return success;
+}
+
+bool archive_decode(
+    struct jobs *jobs,
+    const struct archive_entry *entry,
+    const uint8_t *blob,
+    uint8_t *data
+) {
+    switch (entry->compression) {
+    case ARCHIVE_COMPRESSION_NONE:
+        memcpy(data, blob, entry->size);
+        return true;
+    case ARCHIVE_COMPRESSION_LZ4:
+        if (!lz4_decompress(blob, entry->size, data, entry->uncompressed_size)) {
+            fprintf(stderr, "archive_decode: lz4_decompress failed\n");
+            return false;
+        }
+        return true;
+    case ARCHIVE_COMPRESSION_LZ4_CHUNKED:
+        if (!archive_chunks_decode(jobs, entry, blob, data)) {
+            fprintf(stderr, "archive_decode: archive_chunks_decode failed\n");
+            return false;
+        }
+        return true;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "jobs.h"
+
+/// "VTAR"
+constexpr uint32_t ARCHIVE_MAGIC = 0x52415456;
+constexpr uint32_t ARCHIVE_VERSION = 1;
+/// Alignment of every blob in the file, enough for any texel block or vertex
+/// attribute to be copied straight into a staging buffer
+constexpr uint64_t ARCHIVE_ALIGNMENT = 16;
+/// Uncompressed size of every chunk of an `ARCHIVE_COMPRESSION_LZ4_CHUNKED`
+/// blob but the last
+constexpr size_t ARCHIVE_CHUNK_SIZE = 256 << 10;
+
+enum archive_compression {
+    ARCHIVE_COMPRESSION_NONE,
+    /// A single LZ4 block
+    ARCHIVE_COMPRESSION_LZ4,
+    /// LZ4 blocks of `ARCHIVE_CHUNK_SIZE` bytes each that decompress
+    /// independently. The blob starts with the stored size of every chunk as a
+    /// `uint32_t`, followed by the chunks. Chunks stored at their uncompressed
+    /// size did not compress and are stored as is.
+    ARCHIVE_COMPRESSION_LZ4_CHUNKED,
+};
+
+/// Start of an archive file. All integers are little endian, and the file is
+/// laid out as the header, the entries, the names and then the blobs.
+struct archive_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entries_count;
+    uint32_t names_size;
+    uint64_t entries_offset;
+    uint64_t names_offset;
+};
+
+/// Blob in an archive. Entries are sorted by `hash`, then by name.
+struct archive_entry {
+    /// `hash_bytes` of the name
+    uint64_t hash;
+    /// Multiple of `ARCHIVE_ALIGNMENT` from the start of the file
+    uint64_t offset;
+    /// Bytes stored in the file
+    uint64_t size;
+    /// Bytes once decompressed, equal to `size` when not compressed
+    uint64_t uncompressed_size;
+    /// Range of the name in the names, which are not terminated
+    uint32_t name_offset;
+    uint32_t name_size;
+    /// `enum archive_compression`
+    uint32_t compression;
+    uint32_t reserved;
+};
+
+/// Archive file mapped into memory
+struct archive {
+    const uint8_t *content;
+    size_t content_size;
+
+    const struct archive_entry *entries;
+    uint32_t entries_count;
+    const char *names;
+};
+
+/// @param[in] filename
+/// @param[out] archive
+/// @return `true` on success and `false` otherwise
+/// @note Every entry is validated against the file size, so that lookups and
+/// reads need no bounds checks of their own
+/// @note Caller is responsible to call `archive_close` after successful return
+bool archive_open(const char *filename, struct archive *archive);
+
+/// @param[in,out] archive
+/// @note `archive` and every entry and blob taken from it will be invalid
+/// after this function has been called
+void archive_close(struct archive *archive);
+
+/// @param[in] archive
+/// @param[in] name
+/// @return Entry named `name`, `nullptr` if there is none
+/// @note Binary search on the hash, without allocation
+const struct archive_entry *archive_find(
+    const struct archive *archive, const char *name
+);
+
+/// @param[in] archive
+/// @param[in] entry
+/// @return The bytes of `entry` as stored, valid until `archive_close`
+const uint8_t *archive_blob(
+    const struct archive *archive, const struct archive_entry *entry
+);
+
+/// @param[in] archive
+/// @param[in] entry
+/// @param[out] data `entry->uncompressed_size` bytes
+/// @return `true` on success and `false` otherwise
+/// @note Decompresses on the calling thread, see `archive_decode`
+bool archive_read(
+    const struct archive *archive, const struct archive_entry *entry, uint8_t *data
+);
+
+/// @param[in] size
+/// @return Largest blob `archive_encode` can make of `size` bytes
+size_t archive_encode_bound(size_t size);
+
+/// Compresses into an `ARCHIVE_COMPRESSION_LZ4_CHUNKED` blob
+/// @param[in,out] jobs Compresses the chunks in parallel, may be `nullptr`
+/// @param[in] content
+/// @param[in] content_size
+/// @param[out] blob `archive_encode_bound(content_size)` bytes
+/// @return Size of `blob`, zero on failure
+size_t archive_encode(
+    struct jobs *jobs, const uint8_t *content, size_t content_size, uint8_t *blob
+);
+
+/// @param[in,out] jobs Decompresses the chunks of a chunked blob in parallel,
+/// may be `nullptr`
+/// @param[in] entry
+/// @param[in] blob Stored bytes of `entry`, from `archive_blob` or read from the
+/// file by other means. Not trusted.
+/// @param[out] data `entry->uncompressed_size` bytes, e.g. mapped staging
+/// memory that the chunks are decompressed straight into
+/// @return `true` on success and `false` otherwise
+bool archive_decode(
+    struct jobs *jobs,
+    const struct archive_entry *entry,
+    const uint8_t *blob,
+    uint8_t *data
+);
+
+#endif
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archive.h"
+#include "file.h"
+#include "hash.h"
+#include "jobs.h"
+#include "lz4.h"
+
+/// File going into the archive
+struct archivepack_file {
+    const char *name;
+    uint8_t *content;
+    size_t content_size;
+
+    struct archive_entry entry;
+    /// What is stored, either `content` or `compressed`
+    const uint8_t *blob;
+    uint8_t *compressed;
+};
+
+/// @param[in] a
+/// @param[in] b
+/// @return Order of the entries in the archive
+static int archivepack_file_compare(const void *a, const void *b) {
+    const struct archivepack_file *file_a = a;
+    const struct archivepack_file *file_b = b;
+
+    if (file_a->entry.hash != file_b->entry.hash) {
+        return file_a->entry.hash < file_b->entry.hash ? -1 : 1;
+    }
+
+    return strcmp(file_a->name, file_b->name);
+}
+
+/// @param[in] offset
+/// @return `offset` rounded up to `ARCHIVE_ALIGNMENT`
+static uint64_t archivepack_align(uint64_t offset) {
+    return (offset + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT;
+}
+
+/// @param[in,out] jobs Compresses the chunks of large files in parallel
+/// @param[in,out] file
+/// @param[in] compress Store compressed if that makes the file smaller
+/// @return `true` on success and `false` otherwise
+static bool archivepack_file_load(
+    struct jobs *jobs, struct archivepack_file *file, bool compress
+) {
+    if (!file_read(file->name, &file->content, &file->content_size)) {
+        fprintf(stderr, "archivepack_file_load: file_read failed\n");
+        return false;
+    }
+
+    file->entry = (struct archive_entry){
+        .hash = hash_bytes(file->name, strlen(file->name), HASH_SEED),
+        .size = file->content_size,
+        .uncompressed_size = file->content_size,
+        .name_size = (uint32_t) strlen(file->name),
+        .compression = ARCHIVE_COMPRESSION_NONE,
+    };
+    file->blob = file->content;
+
+    if (!compress || file->content_size == 0) {
+        return true;
+    }
+
+    // Files of several chunks can be decompressed on several threads
+    bool chunked = file->content_size > ARCHIVE_CHUNK_SIZE;
+    size_t capacity = chunked
+        ? archive_encode_bound(file->content_size)
+        : lz4_compress_bound(file->content_size);
+    file->compressed = malloc(capacity);
+    if (file->compressed == nullptr) {
+        fprintf(stderr, "archivepack_file_load: malloc failed\n");
+        return false;
+    }
+
+    size_t compressed_size = chunked
+        ? archive_encode(jobs, file->content, file->content_size, file->compressed)
+        : lz4_compress(file->content, file->content_size, file->compressed, capacity);
+    if (compressed_size > 0 && compressed_size < file->content_size) {
+        file->entry.size = compressed_size;
+        file->entry.compression = chunked
+            ? ARCHIVE_COMPRESSION_LZ4_CHUNKED
+            : ARCHIVE_COMPRESSION_LZ4;
+        file->blob = file->compressed;
+    }
+
+    return true;
+}
+
+/// @param[in] filename
+/// @param[in,out] files Sorted into archive order
+/// @param[in] files_count
+/// @return `true` on success and `false` otherwise
+static bool archivepack_write(
+    const char *filename, struct archivepack_file *files, size_t files_count
+) {
+    bool success = false;
+
+    qsort(files, files_count, sizeof(files[0]), archivepack_file_compare);
+    for (size_t i = 1; i < files_count; i++) {
+        if (strcmp(files[i - 1].name, files[i].name) == 0) {
+            fprintf(
+                stderr, "archivepack_write: \"%s\" is listed twice\n", files[i].name
+            );
+            return false;
+        }
+    }
+
+    uint64_t names_size = 0;
+    for (size_t i = 0; i < files_count; i++) {
+        files[i].entry.name_offset = (uint32_t) names_size;
+        names_size += files[i].entry.name_size;
+    }
+
+    struct archive_header header = {
+        .magic = ARCHIVE_MAGIC,
+        .version = ARCHIVE_VERSION,
+        .entries_count = (uint32_t) files_count,
+        .names_size = (uint32_t) names_size,
+        .entries_offset = sizeof(struct archive_header),
+    };
+    header.names_offset =
+        header.entries_offset + sizeof(struct archive_entry) * files_count;
+
+    uint64_t size = archivepack_align(header.names_offset + names_size);
+    for (size_t i = 0; i < files_count; i++) {
+        files[i].entry.offset = size;
+        size = archivepack_align(size + files[i].entry.size);
+    }
+
+    // Padding stays zeroed so that archives are reproducible
+    uint8_t *content = calloc(size, 1);
+    if (content == nullptr) {
+        fprintf(stderr, "archivepack_write: malloc failed\n");
+        return false;
+    }
+
+    memcpy(content, &header, sizeof(header));
+    for (size_t i = 0; i < files_count; i++) {
+        const struct archivepack_file *file = &files[i];
+        memcpy(
+            content + header.entries_offset + sizeof(file->entry) * i,
+            &file->entry,
+            sizeof(file->entry)
+        );
+        memcpy(
+            content + header.names_offset + file->entry.name_offset,
+            file->name,
+            file->entry.name_size
+        );
+        memcpy(content + file->entry.offset, file->blob, file->entry.size);
+    }
+
+    if (!file_write(filename, content, size)) {
+        fprintf(stderr, "archivepack_write: file_write failed\n");
+        goto cleanup;
+    }
+
+    uint64_t stored = 0;
+    uint64_t uncompressed = 0;
+    for (size_t i = 0; i < files_count; i++) {
+        stored += files[i].entry.size;
+        uncompressed += files[i].entry.uncompressed_size;
+    }
+    fprintf(
+        stderr,
+        "archivepack: %zu files, %llu of %llu bytes stored, %llu bytes written\n",
+        files_count,
+        (unsigned long long) stored,
+        (unsigned long long) uncompressed,
+        (unsigned long long) size
+    );
+
+    success = true;
+
+cleanup:
+    free(content);
+
+    return success;
+}
+
+int main(int argc, char *argv[]) {
+    int success = EXIT_FAILURE;
+
+    bool compress = false;
+    int first = 1;
+    if (first < argc && strcmp(argv[first], "--lz4") == 0) {
+        compress = true;
+        first++;
+    }
+    if (argc - first < 2) {
+        fprintf(stderr, "usage: %s [--lz4] ARCHIVE FILE...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct jobs jobs;
+    if (!jobs_create(&jobs, 0)) {
+        fprintf(stderr, "main: jobs_create failed\n");
+        return EXIT_FAILURE;
+    }
+
+    // Files are stored under the paths they are given as
+    size_t files_count = (size_t) (argc - first - 1);
+    struct archivepack_file *files = calloc(files_count, sizeof(files[0]));
+    if (files == nullptr) {
+        fprintf(stderr, "main: malloc failed\n");
+        jobs_destroy(&jobs);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < files_count; i++) {
+        files[i].name = argv[first + 1 + i];
+        if (!archivepack_file_load(&jobs, &files[i], compress)) {
+            fprintf(
+                stderr, "main: archivepack_file_load(\"%s\") failed\n", files[i].name
+            );
+            goto cleanup;
+        }
+    }
+
+    if (!archivepack_write(argv[first], files, files_count)) {
+        fprintf(stderr, "main: archivepack_write failed\n");
+        goto cleanup;
+    }
+
+    success = EXIT_SUCCESS;
+
+cleanup:
+    for (size_t i = 0; i < files_count; i++) {
+        free(files[i].compressed);
+        free(files[i].content);
+    }
+    free(files);
+    jobs_destroy(&jobs);
+
+    return success;
+}
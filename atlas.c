@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atlas.h"
+
+/// @param[in,out] array
+/// @param[in] element_size
+/// @param[in] count
+/// @param[in,out] capacity
+/// @return `true` if `array` has room for one more element
+static bool atlas_reserve(
+    void **array, size_t element_size, size_t count, size_t *capacity
+) {
+    if (count < *capacity) {
+        return true;
+    }
+
+    size_t new_capacity = *capacity * 2 + 8;
+    void *new_array = realloc(*array, element_size * new_capacity);
+    if (new_array == nullptr) {
+        return false;
+    }
+
+    *array = new_array;
+    *capacity = new_capacity;
+
+    return true;
+}
+
+/// @param[in] atlas
+/// @param[in,out] page
+static void atlas_page_clear(const struct atlas *atlas, struct atlas_page *page) {
+    page->spans[0] = (struct atlas_span){
+        .width = atlas->width,
+    };
+    page->spans_count = 1;
+    page->area = 0;
+}
+
+/// @param[in] atlas
+/// @param[in] page
+/// @param[in] index Span the left edge of the rectangle is placed at
+/// @param[in] width Including padding
+/// @param[in] height Including padding
+/// @param[out] y Lowest the rectangle can go without overlapping the skyline
+/// @return `true` if the rectangle fits at `index` and `false` otherwise
+static bool atlas_page_fit(
+    const struct atlas *atlas,
+    const struct atlas_page *page,
+    size_t index,
+    uint32_t width,
+    uint32_t height,
+    uint32_t *y
+) {
+    if (page->spans[index].x + width > atlas->width) {
+        return false;
+    }
+
+    // The spans reach the right edge, so they cover the rectangle before
+    // running out
+    uint32_t top = 0;
+    uint32_t remaining = width;
+    for (size_t i = index; remaining > 0; i++) {
+        const struct atlas_span *span = &page->spans[i];
+        top = span->y > top ? span->y : top;
+        if (top + height > atlas->height) {
+            return false;
+        }
+        remaining = span->width < remaining ? remaining - span->width : 0;
+    }
+
+    *y = top;
+
+    return true;
+}
+
+/// Raises the skyline over a rectangle placed at span `index`
+/// @param[in,out] page
+/// @param[in] index
+/// @param[in] y
+/// @param[in] width Including padding
+/// @param[in] height Including padding
+/// @return `true` on success and `false` otherwise
+static bool atlas_page_place(
+    struct atlas_page *page, size_t index, uint32_t y, uint32_t width, uint32_t height
+) {
+    if (!atlas_reserve(
+        (void **) &page->spans,
+        sizeof(page->spans[0]),
+        page->spans_count,
+        &page->spans_capacity
+    )) {
+        fprintf(stderr, "atlas_page_place: realloc failed\n");
+        return false;
+    }
+
+    uint32_t x = page->spans[index].x;
+    memmove(
+        &page->spans[index + 1],
+        &page->spans[index],
+        sizeof(page->spans[0]) * (page->spans_count - index)
+    );
+    page->spans[index] = (struct atlas_span){
+        .x = x,
+        .y = y + height,
+        .width = width,
+    };
+    page->spans_count++;
+
+    // Spans now below the rectangle shrink from the left or go away
+    size_t i = index + 1;
+    while (i < page->spans_count) {
+        struct atlas_span *span = &page->spans[i];
+        if (span->x >= x + width) {
+            break;
+        }
+
+        uint32_t covered = x + width - span->x;
+        if (span->width > covered) {
+            span->x += covered;
+            span->width -= covered;
+            break;
+        }
+
+        memmove(
+            &page->spans[i],
+            &page->spans[i + 1],
+            sizeof(page->spans[0]) * (page->spans_count - i - 1)
+        );
+        page->spans_count--;
+    }
+
+    // Neighbors of the same height become one span, so that wide rectangles
+    // see the room they have
+    i = index > 0 ? index - 1 : 0;
+    while (i + 1 < page->spans_count && i <= index + 1) {
+        if (page->spans[i].y != page->spans[i + 1].y) {
+            i++;
+            continue;
+        }
+
+        page->spans[i].width += page->spans[i + 1].width;
+        memmove(
+            &page->spans[i + 1],
+            &page->spans[i + 2],
+            sizeof(page->spans[0]) * (page->spans_count - i - 2)
+        );
+        page->spans_count--;
+    }
+
+    return true;
+}
+
+/// @param[in,out] atlas
+/// @return `true` on success and `false` otherwise
+static bool atlas_page_add(struct atlas *atlas) {
+    if (!atlas_reserve(
+        (void **) &atlas->pages,
+        sizeof(atlas->pages[0]),
+        atlas->pages_count,
+        &atlas->pages_capacity
+    )) {
+        fprintf(stderr, "atlas_page_add: realloc failed\n");
+        return false;
+    }
+
+    struct atlas_page *page = &atlas->pages[atlas->pages_count];
+    *page = (struct atlas_page){};
+    if (!atlas_reserve(
+        (void **) &page->spans, sizeof(page->spans[0]), 0, &page->spans_capacity
+    )) {
+        fprintf(stderr, "atlas_page_add: realloc failed\n");
+        return false;
+    }
+    atlas_page_clear(atlas, page);
+    atlas->pages_count++;
+
+    return true;
+}
+
+void atlas_create(
+    uint32_t width, uint32_t height, uint32_t padding, struct atlas *atlas
+) {
+    *atlas = (struct atlas){
+        .width = width,
+        .height = height,
+        .padding = padding,
+    };
+}
+
+void atlas_destroy(struct atlas *atlas) {
+    for (size_t i = 0; i < atlas->pages_count; i++) {
+        free(atlas->pages[i].spans);
+    }
+    free(atlas->pages);
+
+    *atlas = (struct atlas){};
+}
+
+bool atlas_insert(
+    struct atlas *atlas, uint32_t width, uint32_t height, struct atlas_rect *rect
+) {
+    uint32_t padded_width = width + atlas->padding;
+    uint32_t padded_height = height + atlas->padding;
+    if (padded_width > atlas->width || padded_height > atlas->height) {
+        fprintf(
+            stderr, "atlas_insert: %ux%u does not fit into a page\n", width, height
+        );
+        return false;
+    }
+
+    // Earlier pages are filled up first, each at its lowest spot
+    for (size_t i = 0; ; i++) {
+        if (i == atlas->pages_count && !atlas_page_add(atlas)) {
+            fprintf(stderr, "atlas_insert: atlas_page_add failed\n");
+            return false;
+        }
+
+        struct atlas_page *page = &atlas->pages[i];
+        size_t best_index = SIZE_MAX;
+        uint32_t best_y = UINT32_MAX;
+        for (size_t j = 0; j < page->spans_count; j++) {
+            uint32_t y;
+            if (
+                atlas_page_fit(atlas, page, j, padded_width, padded_height, &y) &&
+                y < best_y
+            ) {
+                best_index = j;
+                best_y = y;
+            }
+        }
+        if (best_index == SIZE_MAX) {
+            continue;
+        }
+
+        uint32_t x = page->spans[best_index].x;
+        if (!atlas_page_place(page, best_index, best_y, padded_width, padded_height)) {
+            fprintf(stderr, "atlas_insert: atlas_page_place failed\n");
+            return false;
+        }
+        page->area += (uint64_t) width * height;
+
+        *rect = (struct atlas_rect){
+            .page = (uint32_t) i,
+            .x = x,
+            .y = best_y,
+            .width = width,
+            .height = height,
+        };
+
+        return true;
+    }
+}
+
+void atlas_clear(struct atlas *atlas) {
+    for (size_t i = 0; i < atlas->pages_count; i++) {
+        atlas_page_clear(atlas, &atlas->pages[i]);
+    }
+}
+
+double atlas_occupancy(const struct atlas *atlas) {
+    if (atlas->pages_count == 0) {
+        return 0.0;
+    }
+
+    uint64_t area = 0;
+    for (size_t i = 0; i < atlas->pages_count; i++) {
+        area += atlas->pages[i].area;
+    }
+
+    return (double) area / ((double) atlas->width * atlas->height * atlas->pages_count);
+}
@@ -0,0 +1,80 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Horizontal span of a page's skyline, the top edge of everything packed
+/// below it
+struct atlas_span {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+};
+
+struct atlas_page {
+    /// Sorted by `x`, covering the whole width of the page without gaps, and
+    /// neighbors never have the same height
+    struct atlas_span *spans;
+    size_t spans_count;
+    size_t spans_capacity;
+    /// Texels taken by the rectangles packed into the page, without padding
+    uint64_t area;
+};
+
+/// Rectangle packed into an atlas
+struct atlas_rect {
+    uint32_t page;
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+
+/// Packs rectangles into pages of one size as they arrive, without knowing
+/// the ones still to come. Each page keeps a skyline, and every rectangle goes
+/// where its top edge ends up lowest. A page is added when no page has room.
+struct atlas {
+    uint32_t width;
+    uint32_t height;
+    /// Kept free to the right of and below every rectangle, so that filtering
+    /// never reads a neighbor
+    uint32_t padding;
+
+    struct atlas_page *pages;
+    size_t pages_count;
+    size_t pages_capacity;
+};
+
+/// @param[in] width Of every page
+/// @param[in] height Of every page
+/// @param[in] padding
+/// @param[out] atlas Without pages
+/// @note Caller is responsible to call `atlas_destroy` after `atlas` is no
+/// longer needed
+void atlas_create(
+    uint32_t width, uint32_t height, uint32_t padding, struct atlas *atlas
+);
+
+/// @param[in,out] atlas
+void atlas_destroy(struct atlas *atlas);
+
+/// @param[in,out] atlas
+/// @param[in] width
+/// @param[in] height
+/// @param[out] rect
+/// @return `true` on success and `false` if the rectangle and its padding are
+/// larger than a page or memory runs out
+bool atlas_insert(
+    struct atlas *atlas, uint32_t width, uint32_t height, struct atlas_rect *rect
+);
+
+/// Empties every page and keeps them
+/// @param[in,out] atlas
+void atlas_clear(struct atlas *atlas);
+
+/// @param[in] atlas
+/// @return Share of the texels of every page taken by rectangles
+double atlas_occupancy(const struct atlas *atlas);
+
+#endif
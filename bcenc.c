@@ -0,0 +1,993 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "bcenc.h"
+
+/// Rows of blocks encoded by one job
+constexpr uint32_t BCENC_JOB_ROWS = 8;
+/// Endpoints refitted to the indices they produced
+constexpr uint32_t BCENC_REFINE_ITERATIONS = 2;
+/// Power iterations towards the principal axis of a block
+constexpr uint32_t BCENC_AXIS_ITERATIONS = 8;
+
+/// Interpolation weights of BC7 4 bit indices, out of 64
+static const uint32_t BCENC_BC7_WEIGHTS[16] = {
+    0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64,
+};
+
+/// 4x4 texels with one row of 16 values per channel, laid out for the
+/// kernels to load four or eight texels of a channel at once
+struct bcenc_texels {
+    alignas(32) float channels[4][16];
+};
+
+/// @param[in] texels
+/// @param[in] palette Values of every channel, also of channels the format
+/// does not store, which are zero in `texels` and `palette` alike
+/// @param[in] palette_count At most 16
+/// @param[out] indices Nearest palette entry of every texel, the first one
+/// on ties
+/// @return Sum of the squared distances of every texel to its entry
+typedef float (*bcenc_fit_function)(
+    const struct bcenc_texels *texels,
+    const float (*palette)[4],
+    uint32_t palette_count,
+    uint8_t indices[16]
+);
+
+/// Rows of blocks of one image encoded by one job
+struct bcenc_rows {
+    enum bcenc_format format;
+    bcenc_fit_function fit;
+    const uint8_t *rgba;
+    uint32_t width;
+    uint32_t height;
+    uint32_t first_row;
+    uint32_t rows_count;
+    uint8_t *blocks;
+};
+
+/// Writes bits of a block from the least significant bit of its first byte
+struct bcenc_bits {
+    uint8_t *data;
+    uint32_t position;
+};
+
+static float bcenc_fit_scalar(
+    const struct bcenc_texels *texels,
+    const float (*palette)[4],
+    uint32_t palette_count,
+    uint8_t indices[16]
+) {
+    float error = 0.0f;
+    for (uint32_t i = 0; i < 16; i++) {
+        float best = INFINITY;
+        for (uint32_t p = 0; p < palette_count; p++) {
+            float distance = 0.0f;
+            for (uint32_t c = 0; c < 4; c++) {
+                float difference = texels->channels[c][i] - palette[p][c];
+                distance += difference * difference;
+            }
+            if (distance < best) {
+                best = distance;
+                indices[i] = (uint8_t) p;
+            }
+        }
+        error += best;
+    }
+
+    return error;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/// Four texels at a time, SSE2 is part of every x86-64 processor
+__attribute__((target("sse2")))
+static float bcenc_fit_sse2(
+    const struct bcenc_texels *texels,
+    const float (*palette)[4],
+    uint32_t palette_count,
+    uint8_t indices[16]
+) {
+    alignas(16) float bests[16];
+    alignas(16) float best_indices[16];
+    for (uint32_t i = 0; i < 16; i += 4) {
+        __m128 channels[4];
+        for (uint32_t c = 0; c < 4; c++) {
+            channels[c] = _mm_load_ps(&texels->channels[c][i]);
+        }
+
+        __m128 best = _mm_set1_ps(INFINITY);
+        __m128 best_index = _mm_setzero_ps();
+        for (uint32_t p = 0; p < palette_count; p++) {
+            __m128 distance = _mm_setzero_ps();
+            for (uint32_t c = 0; c < 4; c++) {
+                __m128 difference = _mm_sub_ps(channels[c], _mm_set1_ps(palette[p][c]));
+                distance = _mm_add_ps(distance, _mm_mul_ps(difference, difference));
+            }
+            __m128 less = _mm_cmplt_ps(distance, best);
+            best = _mm_min_ps(distance, best);
+            best_index = _mm_or_ps(
+                _mm_and_ps(less, _mm_set1_ps((float) p)),
+                _mm_andnot_ps(less, best_index)
+            );
+        }
+        _mm_store_ps(&bests[i], best);
+        _mm_store_ps(&best_indices[i], best_index);
+    }
+
+    // Summed in texel order like the scalar kernel, so that all kernels
+    // produce the same blocks
+    float error = 0.0f;
+    for (uint32_t i = 0; i < 16; i++) {
+        error += bests[i];
+        indices[i] = (uint8_t) best_indices[i];
+    }
+
+    return error;
+}
+
+/// Eight texels at a time
+__attribute__((target("avx2")))
+static float bcenc_fit_avx2(
+    const struct bcenc_texels *texels,
+    const float (*palette)[4],
+    uint32_t palette_count,
+    uint8_t indices[16]
+) {
+    alignas(32) float bests[16];
+    alignas(32) float best_indices[16];
+    for (uint32_t i = 0; i < 16; i += 8) {
+        __m256 channels[4];
+        for (uint32_t c = 0; c < 4; c++) {
+            channels[c] = _mm256_load_ps(&texels->channels[c][i]);
+        }
+
+        __m256 best = _mm256_set1_ps(INFINITY);
+        __m256 best_index = _mm256_setzero_ps();
+        for (uint32_t p = 0; p < palette_count; p++) {
+            __m256 distance = _mm256_setzero_ps();
+            for (uint32_t c = 0; c < 4; c++) {
+                __m256 difference = _mm256_sub_ps(
+                    channels[c], _mm256_set1_ps(palette[p][c])
+                );
+                distance = _mm256_add_ps(
+                    distance, _mm256_mul_ps(difference, difference)
+                );
+            }
+            __m256 less = _mm256_cmp_ps(distance, best, _CMP_LT_OQ);
+            best = _mm256_min_ps(distance, best);
+            best_index = _mm256_blendv_ps(best_index, _mm256_set1_ps((float) p), less);
+        }
+        _mm256_store_ps(&bests[i], best);
+        _mm256_store_ps(&best_indices[i], best_index);
+    }
+
+    float error = 0.0f;
+    for (uint32_t i = 0; i < 16; i++) {
+        error += bests[i];
+        indices[i] = (uint8_t) best_indices[i];
+    }
+
+    return error;
+}
+
+#endif
+
+/// @return Fastest kernel the processor runs
+static bcenc_fit_function bcenc_fit_select(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        return bcenc_fit_avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return bcenc_fit_sse2;
+    }
+#endif
+
+    return bcenc_fit_scalar;
+}
+
+const char *bcenc_kernel_name(void) {
+    bcenc_fit_function fit = bcenc_fit_select();
+#if defined(__x86_64__) || defined(__i386__)
+    if (fit == bcenc_fit_avx2) {
+        return "avx2";
+    }
+    if (fit == bcenc_fit_sse2) {
+        return "sse2";
+    }
+#endif
+
+    return fit == bcenc_fit_scalar ? "scalar" : "unknown";
+}
+
+uint32_t bcenc_block_size(enum bcenc_format format) {
+    return format == BCENC_FORMAT_BC1 ? 8 : 16;
+}
+
+uint64_t bcenc_size(enum bcenc_format format, uint32_t width, uint32_t height) {
+    uint64_t blocks_x = ((uint64_t) width + 3) / 4;
+    uint64_t blocks_y = ((uint64_t) height + 3) / 4;
+
+    return blocks_x * blocks_y * bcenc_block_size(format);
+}
+
+enum bcenc_format bcenc_format_choose(const uint8_t *rgba, size_t texels_count) {
+    for (size_t i = 0; i < texels_count; i++) {
+        if (rgba[4 * i + 3] != 255) {
+            return BCENC_FORMAT_BC7;
+        }
+    }
+
+    return BCENC_FORMAT_BC1;
+}
+
+/// @param[in,out] bits
+/// @param[in] value
+/// @param[in] count Bits of `value` written, least significant first
+static void bcenc_bits_write(struct bcenc_bits *bits, uint32_t value, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        bits->data[bits->position / 8] |= (uint8_t) (
+            ((value >> i) & 1) << (bits->position % 8)
+        );
+        bits->position++;
+    }
+}
+
+/// @param[in,out] bits
+/// @param[in] count
+/// @return The next `count` bits
+static uint32_t bcenc_bits_read(struct bcenc_bits *bits, uint32_t count) {
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t bit = (bits->data[bits->position / 8] >> (bits->position % 8)) & 1;
+        value |= bit << i;
+        bits->position++;
+    }
+
+    return value;
+}
+
+/// @param[in] value
+/// @return `value` rounded and clamped to `[0, 255]`
+static float bcenc_clamp(float value) {
+    return value < 0.0f ? 0.0f : value > 255.0f ? 255.0f : roundf(value);
+}
+
+/// @param[in] texels
+/// @param[in] channels_count Leading channels taken into account
+/// @param[out] endpoints Ends of the segment along the principal axis that
+/// covers every texel
+static void bcenc_endpoints_fit(
+    const struct bcenc_texels *texels, uint32_t channels_count, float endpoints[2][4]
+) {
+    float mean[4] = {};
+    float minimum[4];
+    float maximum[4];
+    for (uint32_t c = 0; c < channels_count; c++) {
+        minimum[c] = INFINITY;
+        maximum[c] = -INFINITY;
+        for (uint32_t i = 0; i < 16; i++) {
+            float value = texels->channels[c][i];
+            mean[c] += value;
+            minimum[c] = fminf(minimum[c], value);
+            maximum[c] = fmaxf(maximum[c], value);
+        }
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[4][4] = {};
+    for (uint32_t i = 0; i < 16; i++) {
+        for (uint32_t a = 0; a < channels_count; a++) {
+            for (uint32_t b = 0; b < channels_count; b++) {
+                covariance[a][b] += (texels->channels[a][i] - mean[a]) *
+                    (texels->channels[b][i] - mean[b]);
+            }
+        }
+    }
+
+    // The diagonal of the bounding box is usually close to the principal
+    // axis already
+    float axis[4] = {};
+    for (uint32_t c = 0; c < channels_count; c++) {
+        axis[c] = maximum[c] - minimum[c];
+    }
+    for (uint32_t iteration = 0; iteration < BCENC_AXIS_ITERATIONS; iteration++) {
+        float next[4] = {};
+        float length = 0.0f;
+        for (uint32_t a = 0; a < channels_count; a++) {
+            for (uint32_t b = 0; b < channels_count; b++) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            length = fmaxf(length, fabsf(next[a]));
+        }
+        if (length == 0.0f) {
+            break;
+        }
+        for (uint32_t c = 0; c < channels_count; c++) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float length_squared = 0.0f;
+    for (uint32_t c = 0; c < channels_count; c++) {
+        length_squared += axis[c] * axis[c];
+    }
+
+    float t_minimum = 0.0f;
+    float t_maximum = 0.0f;
+    if (length_squared > 0.0f) {
+        t_minimum = INFINITY;
+        t_maximum = -INFINITY;
+        for (uint32_t i = 0; i < 16; i++) {
+            float t = 0.0f;
+            for (uint32_t c = 0; c < channels_count; c++) {
+                t += (texels->channels[c][i] - mean[c]) * axis[c];
+            }
+            t /= length_squared;
+            t_minimum = fminf(t_minimum, t);
+            t_maximum = fmaxf(t_maximum, t);
+        }
+    }
+
+    for (uint32_t c = 0; c < 4; c++) {
+        endpoints[0][c] = c < channels_count
+            ? bcenc_clamp(mean[c] + t_minimum * axis[c])
+            : 0.0f;
+        endpoints[1][c] = c < channels_count
+            ? bcenc_clamp(mean[c] + t_maximum * axis[c])
+            : 0.0f;
+    }
+}
+
+/// Moves the endpoints to the least squares fit of the texels for the
+/// positions along the segment their indices select
+/// @param[in] texels
+/// @param[in] channels_count
+/// @param[in] indices
+/// @param[in] weights Position of each index between the endpoints
+/// @param[in,out] endpoints Unchanged if every texel has the same position
+static void bcenc_endpoints_refine(
+    const struct bcenc_texels *texels,
+    uint32_t channels_count,
+    const uint8_t indices[16],
+    const float *weights,
+    float endpoints[2][4]
+) {
+    float aa = 0.0f;
+    float ab = 0.0f;
+    float bb = 0.0f;
+    float ax[4] = {};
+    float bx[4] = {};
+    for (uint32_t i = 0; i < 16; i++) {
+        float b = weights[indices[i]];
+        float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t c = 0; c < channels_count; c++) {
+            ax[c] += a * texels->channels[c][i];
+            bx[c] += b * texels->channels[c][i];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (fabsf(determinant) < 1e-6f) {
+        return;
+    }
+
+    for (uint32_t c = 0; c < channels_count; c++) {
+        endpoints[0][c] = bcenc_clamp((bb * ax[c] - ab * bx[c]) / determinant);
+        endpoints[1][c] = bcenc_clamp((aa * bx[c] - ab * ax[c]) / determinant);
+    }
+}
+
+/// @param[in] color
+/// @return `color` rounded to RGB565
+static uint16_t bcenc_rgb565(const float color[4]) {
+    uint32_t r = (uint32_t) roundf(color[0] * 31.0f / 255.0f);
+    uint32_t g = (uint32_t) roundf(color[1] * 63.0f / 255.0f);
+    uint32_t b = (uint32_t) roundf(color[2] * 31.0f / 255.0f);
+
+    return (uint16_t) (r << 11 | g << 5 | b);
+}
+
+/// @param[in] color
+/// @param[out] rgb Expanded to 8 bits per channel
+static void bcenc_rgb565_expand(uint16_t color, uint32_t rgb[3]) {
+    uint32_t r = color >> 11;
+    uint32_t g = (color >> 5) & 63;
+    uint32_t b = color & 31;
+    rgb[0] = r << 3 | r >> 2;
+    rgb[1] = g << 2 | g >> 4;
+    rgb[2] = b << 3 | b >> 2;
+}
+
+/// @param[in] colors
+/// @param[out] palette Four RGB entries, or three and black when
+/// `colors[0] <= colors[1]`
+static void bcenc_bc1_palette(const uint16_t colors[2], uint32_t palette[4][3]) {
+    bcenc_rgb565_expand(colors[0], palette[0]);
+    bcenc_rgb565_expand(colors[1], palette[1]);
+    for (uint32_t c = 0; c < 3; c++) {
+        if (colors[0] > colors[1]) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+/// @param[in] texels Alpha is ignored
+/// @param[in] fit
+/// @param[out] block 8 bytes
+static void bcenc_bc1_encode(
+    const struct bcenc_texels *texels, bcenc_fit_function fit, uint8_t *block
+) {
+    static const float weights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+    struct bcenc_texels rgb = *texels;
+    memset(rgb.channels[3], 0, sizeof(rgb.channels[3]));
+
+    float endpoints[2][4];
+    bcenc_endpoints_fit(&rgb, 3, endpoints);
+
+    uint16_t best_colors[2] = {};
+    uint8_t best_indices[16] = {};
+    float best_error = INFINITY;
+    for (uint32_t iteration = 0; iteration <= BCENC_REFINE_ITERATIONS; iteration++) {
+        // Only the four color mode is written, which needs the first color to
+        // be the larger one
+        uint16_t colors[2] = {
+            bcenc_rgb565(endpoints[0]),
+            bcenc_rgb565(endpoints[1]),
+        };
+        if (colors[0] < colors[1]) {
+            uint16_t color = colors[0];
+            colors[0] = colors[1];
+            colors[1] = color;
+        }
+
+        uint32_t palette_rgb[4][3];
+        bcenc_bc1_palette(colors, palette_rgb);
+        float palette[4][4] = {};
+        uint32_t palette_count = colors[0] > colors[1] ? 4 : 1;
+        for (uint32_t p = 0; p < palette_count; p++) {
+            for (uint32_t c = 0; c < 3; c++) {
+                palette[p][c] = (float) palette_rgb[p][c];
+            }
+        }
+
+        uint8_t indices[16];
+        float error = fit(&rgb, palette, palette_count, indices);
+        if (error < best_error) {
+            best_error = error;
+            best_colors[0] = colors[0];
+            best_colors[1] = colors[1];
+            memcpy(best_indices, indices, sizeof(indices));
+        }
+        if (error == 0.0f || palette_count == 1) {
+            break;
+        }
+
+        // The indices are relative to the colors in the order they were
+        // stored in
+        float ordered[2][4] = {};
+        uint32_t rgb_values[3];
+        for (uint32_t e = 0; e < 2; e++) {
+            bcenc_rgb565_expand(colors[e], rgb_values);
+            for (uint32_t c = 0; c < 3; c++) {
+                ordered[e][c] = (float) rgb_values[c];
+            }
+        }
+        memcpy(endpoints, ordered, sizeof(ordered));
+        bcenc_endpoints_refine(&rgb, 3, indices, weights, endpoints);
+    }
+
+    uint32_t selectors = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        selectors |= (uint32_t) best_indices[i] << (2 * i);
+    }
+    block[0] = (uint8_t) best_colors[0];
+    block[1] = (uint8_t) (best_colors[0] >> 8);
+    block[2] = (uint8_t) best_colors[1];
+    block[3] = (uint8_t) (best_colors[1] >> 8);
+    for (uint32_t i = 0; i < 4; i++) {
+        block[4 + i] = (uint8_t) (selectors >> (8 * i));
+    }
+}
+
+/// @param[in] alphas
+/// @param[out] palette Eight entries, or six and both extremes when
+/// `alphas[0] <= alphas[1]`
+static void bcenc_alpha_palette(const uint8_t alphas[2], uint32_t palette[8]) {
+    palette[0] = alphas[0];
+    palette[1] = alphas[1];
+    if (alphas[0] > alphas[1]) {
+        for (uint32_t i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * alphas[0] + i * alphas[1]) / 7;
+        }
+    } else {
+        for (uint32_t i = 1; i < 5; i++) {
+            palette[i + 1] = ((5 - i) * alphas[0] + i * alphas[1]) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+/// @param[in] texels Only alpha is read
+/// @param[in] fit
+/// @param[out] block 8 bytes
+static void bcenc_alpha_encode(
+    const struct bcenc_texels *texels, bcenc_fit_function fit, uint8_t *block
+) {
+    struct bcenc_texels alpha = {};
+    memcpy(alpha.channels[3], texels->channels[3], sizeof(alpha.channels[3]));
+
+    float minimum = 255.0f;
+    float maximum = 0.0f;
+    for (uint32_t i = 0; i < 16; i++) {
+        minimum = fminf(minimum, alpha.channels[3][i]);
+        maximum = fmaxf(maximum, alpha.channels[3][i]);
+    }
+
+    // Only the eight value mode is written, equal extremes need one entry
+    uint8_t alphas[2] = {(uint8_t) maximum, (uint8_t) minimum};
+    uint8_t indices[16] = {};
+    if (alphas[0] > alphas[1]) {
+        uint32_t palette_alpha[8];
+        bcenc_alpha_palette(alphas, palette_alpha);
+        float palette[8][4] = {};
+        for (uint32_t p = 0; p < 8; p++) {
+            palette[p][3] = (float) palette_alpha[p];
+        }
+        fit(&alpha, palette, 8, indices);
+    }
+
+    memset(block, 0, 8);
+    block[0] = alphas[0];
+    block[1] = alphas[1];
+    struct bcenc_bits bits = {.data = block, .position = 16};
+    for (uint32_t i = 0; i < 16; i++) {
+        bcenc_bits_write(&bits, indices[i], 3);
+    }
+}
+
+/// @param[in] value
+/// @param[out] quantized Seven bits
+/// @param[out] pbit
+/// @return Squared error of `(quantized << 1 | pbit)` against `value`, with
+/// the p-bit that minimizes it
+static float bcenc_bc7_quantize(
+    const float value[4], uint32_t quantized[4], uint32_t *pbit
+) {
+    float best_error = INFINITY;
+    for (uint32_t p = 0; p < 2; p++) {
+        uint32_t candidate[4];
+        float error = 0.0f;
+        for (uint32_t c = 0; c < 4; c++) {
+            float q = roundf((value[c] - (float) p) / 2.0f);
+            candidate[c] = (uint32_t) (q < 0.0f ? 0.0f : q > 127.0f ? 127.0f : q);
+            float difference = (float) (candidate[c] << 1 | p) - value[c];
+            error += difference * difference;
+        }
+        if (error < best_error) {
+            best_error = error;
+            memcpy(quantized, candidate, sizeof(candidate));
+            *pbit = p;
+        }
+    }
+
+    return best_error;
+}
+
+/// @param[in] endpoints 8 bit values of both endpoints
+/// @param[out] palette
+static void bcenc_bc7_palette(const uint32_t endpoints[2][4], float palette[16][4]) {
+    for (uint32_t p = 0; p < 16; p++) {
+        for (uint32_t c = 0; c < 4; c++) {
+            palette[p][c] = (float) (
+                ((64 - BCENC_BC7_WEIGHTS[p]) * endpoints[0][c] +
+                    BCENC_BC7_WEIGHTS[p] * endpoints[1][c] + 32) >> 6
+            );
+        }
+    }
+}
+
+/// @param[in] texels
+/// @param[in] fit
+/// @param[out] block 16 bytes in mode 6
+static void bcenc_bc7_encode(
+    const struct bcenc_texels *texels, bcenc_fit_function fit, uint8_t *block
+) {
+    float weights[16];
+    for (uint32_t p = 0; p < 16; p++) {
+        weights[p] = (float) BCENC_BC7_WEIGHTS[p] / 64.0f;
+    }
+
+    float endpoints[2][4];
+    bcenc_endpoints_fit(texels, 4, endpoints);
+
+    uint32_t best_quantized[2][4] = {};
+    uint32_t best_pbits[2] = {};
+    uint8_t best_indices[16] = {};
+    float best_error = INFINITY;
+    for (uint32_t iteration = 0; iteration <= BCENC_REFINE_ITERATIONS; iteration++) {
+        uint32_t quantized[2][4];
+        uint32_t pbits[2];
+        uint32_t values[2][4];
+        for (uint32_t e = 0; e < 2; e++) {
+            bcenc_bc7_quantize(endpoints[e], quantized[e], &pbits[e]);
+            for (uint32_t c = 0; c < 4; c++) {
+                values[e][c] = quantized[e][c] << 1 | pbits[e];
+            }
+        }
+
+        float palette[16][4];
+        bcenc_bc7_palette(values, palette);
+        uint8_t indices[16];
+        float error = fit(texels, palette, 16, indices);
+        if (error < best_error) {
+            best_error = error;
+            memcpy(best_quantized, quantized, sizeof(quantized));
+            memcpy(best_pbits, pbits, sizeof(pbits));
+            memcpy(best_indices, indices, sizeof(indices));
+        }
+        if (error == 0.0f) {
+            break;
+        }
+
+        for (uint32_t e = 0; e < 2; e++) {
+            for (uint32_t c = 0; c < 4; c++) {
+                endpoints[e][c] = (float) values[e][c];
+            }
+        }
+        bcenc_endpoints_refine(texels, 4, indices, weights, endpoints);
+    }
+
+    // The first index is stored without its most significant bit, which the
+    // endpoints are swapped to make zero
+    if (best_indices[0] >= 8) {
+        for (uint32_t c = 0; c < 4; c++) {
+            uint32_t value = best_quantized[0][c];
+            best_quantized[0][c] = best_quantized[1][c];
+            best_quantized[1][c] = value;
+        }
+        uint32_t pbit = best_pbits[0];
+        best_pbits[0] = best_pbits[1];
+        best_pbits[1] = pbit;
+        for (uint32_t i = 0; i < 16; i++) {
+            best_indices[i] = (uint8_t) (15 - best_indices[i]);
+        }
+    }
+
+    memset(block, 0, 16);
+    struct bcenc_bits bits = {.data = block};
+    bcenc_bits_write(&bits, 1 << 6, 7);
+    for (uint32_t c = 0; c < 4; c++) {
+        bcenc_bits_write(&bits, best_quantized[0][c], 7);
+        bcenc_bits_write(&bits, best_quantized[1][c], 7);
+    }
+    bcenc_bits_write(&bits, best_pbits[0], 1);
+    bcenc_bits_write(&bits, best_pbits[1], 1);
+    for (uint32_t i = 0; i < 16; i++) {
+        bcenc_bits_write(&bits, best_indices[i], i == 0 ? 3 : 4);
+    }
+}
+
+/// @param[in,out] argument `struct bcenc_rows`
+static void bcenc_rows_encode(void *argument) {
+    const struct bcenc_rows *rows = argument;
+    uint32_t blocks_x = (rows->width + 3) / 4;
+    uint32_t block_size = bcenc_block_size(rows->format);
+
+    uint32_t rows_end = rows->first_row + rows->rows_count;
+    for (uint32_t row = rows->first_row; row < rows_end; row++) {
+        for (uint32_t column = 0; column < blocks_x; column++) {
+            struct bcenc_texels texels;
+            for (uint32_t i = 0; i < 16; i++) {
+                uint32_t x = column * 4 + i % 4;
+                uint32_t y = row * 4 + i / 4;
+                x = x < rows->width ? x : rows->width - 1;
+                y = y < rows->height ? y : rows->height - 1;
+                const uint8_t *texel = rows->rgba + 4 * ((size_t) rows->width * y + x);
+                for (uint32_t c = 0; c < 4; c++) {
+                    texels.channels[c][i] = (float) texel[c];
+                }
+            }
+
+            uint8_t *block = rows->blocks +
+                ((size_t) blocks_x * row + column) * block_size;
+            switch (rows->format) {
+            case BCENC_FORMAT_BC1:
+                bcenc_bc1_encode(&texels, rows->fit, block);
+                break;
+            case BCENC_FORMAT_BC3:
+                bcenc_alpha_encode(&texels, rows->fit, block);
+                bcenc_bc1_encode(&texels, rows->fit, block + 8);
+                break;
+            case BCENC_FORMAT_BC7:
+                bcenc_bc7_encode(&texels, rows->fit, block);
+                break;
+            }
+        }
+    }
+}
+
+bool bcenc_encode(
+    struct jobs *jobs,
+    enum bcenc_format format,
+    const uint8_t *rgba,
+    uint32_t width,
+    uint32_t height,
+    uint8_t *blocks
+) {
+    if (width == 0 || height == 0) {
+        return true;
+    }
+
+    uint32_t blocks_y = (height + 3) / 4;
+    size_t jobs_count = (blocks_y + BCENC_JOB_ROWS - 1) / BCENC_JOB_ROWS;
+    struct bcenc_rows *rows = malloc(sizeof(rows[0]) * jobs_count);
+    if (rows == nullptr) {
+        fprintf(stderr, "bcenc_encode: malloc failed\n");
+        return false;
+    }
+
+    bcenc_fit_function fit = bcenc_fit_select();
+    struct jobs_counter counter = {};
+    for (size_t i = 0; i < jobs_count; i++) {
+        uint32_t first_row = (uint32_t) i * BCENC_JOB_ROWS;
+        rows[i] = (struct bcenc_rows){
+            .format = format,
+            .fit = fit,
+            .rgba = rgba,
+            .width = width,
+            .height = height,
+            .first_row = first_row,
+            .rows_count = blocks_y - first_row < BCENC_JOB_ROWS
+                ? blocks_y - first_row
+                : BCENC_JOB_ROWS,
+            .blocks = blocks,
+        };
+        if (
+            jobs == nullptr ||
+            !jobs_submit(jobs, bcenc_rows_encode, &rows[i], &counter)
+        ) {
+            bcenc_rows_encode(&rows[i]);
+        }
+    }
+
+    if (jobs != nullptr) {
+        jobs_counter_wait(jobs, &counter);
+    }
+    free(rows);
+
+    return true;
+}
+
+/// @param[in] block 8 bytes
+/// @param[out] texels 16 RGB texels, alpha is left as it is
+static void bcenc_bc1_decode(const uint8_t *block, uint8_t texels[16][4]) {
+    uint16_t colors[2] = {
+        (uint16_t) (block[0] | block[1] << 8),
+        (uint16_t) (block[2] | block[3] << 8),
+    };
+    uint32_t palette[4][3];
+    bcenc_bc1_palette(colors, palette);
+
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t index = (block[4 + i / 4] >> (2 * (i % 4))) & 3;
+        for (uint32_t c = 0; c < 3; c++) {
+            texels[i][c] = (uint8_t) palette[index][c];
+        }
+    }
+}
+
+/// @param[in] block 8 bytes
+/// @param[out] texels Only alpha is written
+static void bcenc_alpha_decode(const uint8_t *block, uint8_t texels[16][4]) {
+    uint32_t palette[8];
+    bcenc_alpha_palette(block, palette);
+
+    struct bcenc_bits bits = {.data = (uint8_t *) block, .position = 16};
+    for (uint32_t i = 0; i < 16; i++) {
+        texels[i][3] = (uint8_t) palette[bcenc_bits_read(&bits, 3)];
+    }
+}
+
+/// @param[in] block 16 bytes
+/// @param[out] texels
+/// @return `true` on success and `false` if `block` is not in mode 6
+static bool bcenc_bc7_decode(const uint8_t *block, uint8_t texels[16][4]) {
+    struct bcenc_bits bits = {.data = (uint8_t *) block};
+    if (bcenc_bits_read(&bits, 7) != 1 << 6) {
+        return false;
+    }
+
+    uint32_t quantized[2][4];
+    for (uint32_t c = 0; c < 4; c++) {
+        quantized[0][c] = bcenc_bits_read(&bits, 7);
+        quantized[1][c] = bcenc_bits_read(&bits, 7);
+    }
+    uint32_t pbits[2];
+    pbits[0] = bcenc_bits_read(&bits, 1);
+    pbits[1] = bcenc_bits_read(&bits, 1);
+
+    uint32_t values[2][4];
+    for (uint32_t e = 0; e < 2; e++) {
+        for (uint32_t c = 0; c < 4; c++) {
+            values[e][c] = quantized[e][c] << 1 | pbits[e];
+        }
+    }
+    float palette[16][4];
+    bcenc_bc7_palette(values, palette);
+
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t index = bcenc_bits_read(&bits, i == 0 ? 3 : 4);
+        for (uint32_t c = 0; c < 4; c++) {
+            texels[i][c] = (uint8_t) palette[index][c];
+        }
+    }
+
+    return true;
+}
+
+bool bcenc_decode(
+    enum bcenc_format format,
+    const uint8_t *blocks,
+    uint32_t width,
+    uint32_t height,
+    uint8_t *rgba
+) {
+    uint32_t blocks_x = (width + 3) / 4;
+    uint32_t blocks_y = (height + 3) / 4;
+    uint32_t block_size = bcenc_block_size(format);
+
+    for (uint32_t row = 0; row < blocks_y; row++) {
+        for (uint32_t column = 0; column < blocks_x; column++) {
+            const uint8_t *block = blocks +
+                ((size_t) blocks_x * row + column) * block_size;
+
+            uint8_t texels[16][4];
+            memset(texels, 255, sizeof(texels));
+            switch (format) {
+            case BCENC_FORMAT_BC1:
+                bcenc_bc1_decode(block, texels);
+                break;
+            case BCENC_FORMAT_BC3:
+                bcenc_alpha_decode(block, texels);
+                bcenc_bc1_decode(block + 8, texels);
+                break;
+            case BCENC_FORMAT_BC7:
+                if (!bcenc_bc7_decode(block, texels)) {
+                    fprintf(stderr, "bcenc_decode: unsupported BC7 mode\n");
+                    return false;
+                }
+                break;
+            }
+
+            for (uint32_t i = 0; i < 16; i++) {
+                uint32_t x = column * 4 + i % 4;
+                uint32_t y = row * 4 + i / 4;
+                if (x < width && y < height) {
+                    memcpy(rgba + 4 * ((size_t) width * y + x), texels[i], 4);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+double bcenc_psnr(
+    const uint8_t *a, const uint8_t *b, size_t texels_count, uint32_t channels_count
+) {
+    double error = 0.0;
+    for (size_t i = 0; i < texels_count; i++) {
+        for (uint32_t c = 0; c < channels_count; c++) {
+            double difference = (double) a[4 * i + c] - (double) b[4 * i + c];
+            error += difference * difference;
+        }
+    }
+    if (error == 0.0) {
+        return INFINITY;
+    }
+
+    double values_count = (double) texels_count * channels_count;
+    return 10.0 * log10(255.0 * 255.0 * values_count / error);
+}
+
+bool bcenc_ktx2_encode(
+    struct jobs *jobs,
+    const struct ktx2 *ktx2,
+    enum bcenc_format format,
+    uint8_t **content,
+    size_t *content_size
+) {
+    bool srgb = ktx2->format == VK_FORMAT_R8G8B8A8_SRGB;
+    if (!srgb && ktx2->format != VK_FORMAT_R8G8B8A8_UNORM) {
+        fprintf(stderr, "bcenc_ktx2_encode: source is not RGBA8\n");
+        return false;
+    }
+    // Block compressed images can neither be blitted nor stored to
+    if (ktx2->mips_generate) {
+        fprintf(stderr, "bcenc_ktx2_encode: mips must be generated beforehand\n");
+        return false;
+    }
+
+    static const VkFormat formats[][2] = {
+        [BCENC_FORMAT_BC1] = {
+            VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+            VK_FORMAT_BC1_RGBA_SRGB_BLOCK,
+        },
+        [BCENC_FORMAT_BC3] = {VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK},
+        [BCENC_FORMAT_BC7] = {VK_FORMAT_BC7_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK},
+    };
+    struct ktx2 compressed = *ktx2;
+    compressed.content = nullptr;
+    compressed.content_size = 0;
+    compressed.format = formats[format][srgb];
+    ktx2_format_block(compressed.format, &compressed.block);
+
+    bool success = false;
+    uint8_t *levels[KTX2_MAX_LEVELS] = {};
+
+    // Every layer, face and slice of a level is an image of its own
+    uint32_t images_count = (ktx2->layers_count > 0 ? ktx2->layers_count : 1) *
+        ktx2->faces_count;
+    for (uint32_t level = 0; level < ktx2->levels_count; level++) {
+        uint32_t width = ktx2->width >> level > 0 ? ktx2->width >> level : 1;
+        uint32_t height = ktx2->height >> level > 0 ? ktx2->height >> level : 1;
+        uint32_t depth = ktx2->depth >> level > 0 ? ktx2->depth >> level : 1;
+        uint64_t source_size = 4 * (uint64_t) width * height;
+        uint64_t image_size = bcenc_size(format, width, height);
+
+        levels[level] = malloc(image_size * images_count * depth);
+        if (levels[level] == nullptr) {
+            fprintf(stderr, "bcenc_ktx2_encode: malloc failed\n");
+            goto cleanup;
+        }
+
+        const uint8_t *source = ktx2->content + ktx2->levels[level].offset;
+        for (uint64_t i = 0; i < (uint64_t) images_count * depth; i++) {
+            if (!bcenc_encode(
+                jobs,
+                format,
+                source + source_size * i,
+                width,
+                height,
+                levels[level] + image_size * i
+            )) {
+                fprintf(stderr, "bcenc_ktx2_encode: bcenc_encode failed\n");
+                goto cleanup;
+            }
+        }
+    }
+
+    if (!ktx2_encode(
+        &compressed, (const uint8_t *const *) levels, content, content_size
+    )) {
+        fprintf(stderr, "bcenc_ktx2_encode: ktx2_encode failed\n");
+        goto cleanup;
+    }
+
+    success = true;
+
+cleanup:
+    for (uint32_t level = 0; level < KTX2_MAX_LEVELS; level++) {
+        free(levels[level]);
+    }
+
+    return success;
+}
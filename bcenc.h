@@ -0,0 +1,100 @@
+#ifndef BCENC_H
+#define BCENC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "jobs.h"
+#include "ktx2.h"
+
+/// Block compressed formats of 4x4 texel blocks
+enum bcenc_format {
+    /// Opaque RGB in 8 bytes, two RGB565 endpoints and 2 bit indices
+    BCENC_FORMAT_BC1,
+    /// BC1 color after 8 bytes of alpha with 3 bit indices
+    BCENC_FORMAT_BC3,
+    /// RGBA in 16 bytes, only mode 6 with 7 bit endpoints and 4 bit indices
+    /// is written
+    BCENC_FORMAT_BC7,
+};
+
+/// @param[in] format
+/// @return Bytes per block
+uint32_t bcenc_block_size(enum bcenc_format format);
+
+/// @param[in] format
+/// @param[in] width
+/// @param[in] height
+/// @return Bytes of an image of `width`x`height` texels in `format`
+uint64_t bcenc_size(enum bcenc_format format, uint32_t width, uint32_t height);
+
+/// @return Instruction set of the kernel that matches texels to palettes on
+/// this processor, e.g. "avx2"
+const char *bcenc_kernel_name(void);
+
+/// @param[in] rgba
+/// @param[in] texels_count
+/// @return `BCENC_FORMAT_BC1` if every texel is opaque and `BCENC_FORMAT_BC7`
+/// otherwise
+enum bcenc_format bcenc_format_choose(const uint8_t *rgba, size_t texels_count);
+
+/// @param[in,out] jobs Encodes rows of blocks in parallel, may be `nullptr`
+/// @param[in] format
+/// @param[in] rgba Texels of 4 bytes, rows tightly packed
+/// @param[in] width
+/// @param[in] height
+/// @param[out] blocks `bcenc_size(format, width, height)` bytes, blocks past
+/// the edges repeat the last row and column
+/// @return `true` on success and `false` otherwise
+bool bcenc_encode(
+    struct jobs *jobs,
+    enum bcenc_format format,
+    const uint8_t *rgba,
+    uint32_t width,
+    uint32_t height,
+    uint8_t *blocks
+);
+
+/// @param[in] format
+/// @param[in] blocks
+/// @param[in] width
+/// @param[in] height
+/// @param[out] rgba `4 * width * height` bytes
+/// @return `true` on success and `false` if a BC7 block is in another mode
+/// than the one `bcenc_encode` writes
+bool bcenc_decode(
+    enum bcenc_format format,
+    const uint8_t *blocks,
+    uint32_t width,
+    uint32_t height,
+    uint8_t *rgba
+);
+
+/// @param[in] a RGBA8 texels
+/// @param[in] b RGBA8 texels
+/// @param[in] texels_count
+/// @param[in] channels_count Leading channels compared, e.g. three for BC1
+/// @return Peak signal to noise ratio of `b` against `a` in decibels,
+/// `INFINITY` if they are equal
+double bcenc_psnr(
+    const uint8_t *a, const uint8_t *b, size_t texels_count, uint32_t channels_count
+);
+
+/// Compresses every image of an RGBA8 KTX2 file
+/// @param[in,out] jobs May be `nullptr`
+/// @param[in] ktx2 In `VK_FORMAT_R8G8B8A8_UNORM` or `VK_FORMAT_R8G8B8A8_SRGB`,
+/// with every level present
+/// @param[in] format
+/// @param[out] content KTX2 file in the matching block compressed format
+/// @param[out] content_size
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to free `content` after successful return
+bool bcenc_ktx2_encode(
+    struct jobs *jobs,
+    const struct ktx2 *ktx2,
+    enum bcenc_format format,
+    uint8_t **content,
+    size_t *content_size
+);
+
+#endif
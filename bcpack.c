@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bcenc.h"
+#include "file.h"
+#include "jobs.h"
+#include "ktx2.h"
+#include "stats.h"
+
+/// Decodes the first image of the base level of `compressed` and compares it
+/// against the same image of `source`
+/// @param[in] source
+/// @param[in] compressed
+/// @param[in] format
+/// @param[out] psnr
+/// @return `true` on success and `false` otherwise
+static bool bcpack_psnr(
+    const struct ktx2 *source,
+    const struct ktx2 *compressed,
+    enum bcenc_format format,
+    double *psnr
+) {
+    size_t texels_count = (size_t) source->width * source->height;
+    uint8_t *decoded = malloc(4 * texels_count);
+    if (decoded == nullptr) {
+        fprintf(stderr, "bcpack_psnr: malloc failed\n");
+        return false;
+    }
+
+    if (!bcenc_decode(
+        format,
+        compressed->content + compressed->levels[0].offset,
+        compressed->width,
+        compressed->height,
+        decoded
+    )) {
+        fprintf(stderr, "bcpack_psnr: bcenc_decode failed\n");
+        free(decoded);
+        return false;
+    }
+
+    // BC1 is only written opaque, so its alpha is left out
+    *psnr = bcenc_psnr(
+        source->content + source->levels[0].offset,
+        decoded,
+        texels_count,
+        format == BCENC_FORMAT_BC1 ? 3 : 4
+    );
+    free(decoded);
+
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    static const char *const options[] = {
+        [BCENC_FORMAT_BC1] = "--bc1",
+        [BCENC_FORMAT_BC3] = "--bc3",
+        [BCENC_FORMAT_BC7] = "--bc7",
+    };
+    constexpr size_t options_count = sizeof(options) / sizeof(options[0]);
+    int success = EXIT_FAILURE;
+
+    // Without an option the format follows the alpha of the base level
+    bool automatic = true;
+    enum bcenc_format format = BCENC_FORMAT_BC1;
+    int first = 1;
+    for (size_t i = 0; first < argc && i < options_count; i++) {
+        if (strcmp(argv[first], options[i]) == 0) {
+            automatic = false;
+            format = (enum bcenc_format) i;
+            first++;
+            break;
+        }
+    }
+    if (argc - first != 2) {
+        fprintf(stderr, "usage: %s [--bc1|--bc3|--bc7] INPUT OUTPUT\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    uint8_t *source_content = nullptr;
+    size_t source_size;
+    uint8_t *content = nullptr;
+    size_t content_size;
+
+    struct jobs jobs;
+    if (!jobs_create(&jobs, 0)) {
+        fprintf(stderr, "main: jobs_create failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!file_read(argv[first], &source_content, &source_size)) {
+        fprintf(stderr, "main: file_read(\"%s\") failed\n", argv[first]);
+        goto cleanup;
+    }
+    struct ktx2 source;
+    if (!ktx2_parse(source_content, source_size, &source)) {
+        fprintf(stderr, "main: ktx2_parse failed\n");
+        goto cleanup;
+    }
+
+    if (automatic) {
+        format = bcenc_format_choose(
+            source.content + source.levels[0].offset, source.levels[0].size / 4
+        );
+    }
+
+    uint64_t start_time = stats_time_now();
+    if (!bcenc_ktx2_encode(&jobs, &source, format, &content, &content_size)) {
+        fprintf(stderr, "main: bcenc_ktx2_encode failed\n");
+        goto cleanup;
+    }
+    uint64_t duration = stats_time_now() - start_time;
+
+    struct ktx2 compressed;
+    if (!ktx2_parse(content, content_size, &compressed)) {
+        fprintf(stderr, "main: ktx2_parse failed\n");
+        goto cleanup;
+    }
+    double psnr;
+    if (!bcpack_psnr(&source, &compressed, format, &psnr)) {
+        fprintf(stderr, "main: bcpack_psnr failed\n");
+        goto cleanup;
+    }
+
+    if (!file_write(argv[first + 1], content, content_size)) {
+        fprintf(stderr, "main: file_write(\"%s\") failed\n", argv[first + 1]);
+        goto cleanup;
+    }
+
+    uint64_t texels_size = 0;
+    for (uint32_t level = 0; level < source.levels_count; level++) {
+        texels_size += source.levels[level].size;
+    }
+    fprintf(
+        stderr,
+        "bcpack: %s, %zu of %zu bytes written, %.1f MB/s with %s, %.2f dB\n",
+        options[format] + 2,
+        content_size,
+        source_size,
+        1.0e3 * (double) texels_size / (double) (duration > 0 ? duration : 1),
+        bcenc_kernel_name(),
+        psnr
+    );
+
+    success = EXIT_SUCCESS;
+
+cleanup:
+    free(content);
+    free(source_content);
+    jobs_destroy(&jobs);
+
+    return success;
+}
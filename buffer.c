@@ -0,0 +1,122 @@
+#include <stdio.h>
+
+#include "buffer.h"
+
+bool buffer_memorytype_find(
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    uint32_t type_bits,
+    VkMemoryPropertyFlags properties,
+    uint32_t *type_index
+) {
+    for (uint32_t i = 0; i < memory_properties->memoryTypeCount; i++) {
+        if (
+            (type_bits & (1u << i)) != 0 &&
+            (memory_properties->memoryTypes[i].propertyFlags & properties) == properties
+        ) {
+            *type_index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool buffer_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags required,
+    VkMemoryPropertyFlags preferred,
+    struct buffer *buffer
+) {
+    *buffer = (struct buffer){
+        .size = size,
+    };
+
+    VkBufferCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    if (vkCreateBuffer(device, &create_info, nullptr, &buffer->buffer) != VK_SUCCESS) {
+        fprintf(stderr, "buffer_create: vkCreateBuffer failed\n");
+        return false;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, buffer->buffer, &requirements);
+
+    uint32_t type_index;
+    if (
+        !buffer_memorytype_find(
+            memory_properties,
+            requirements.memoryTypeBits,
+            required | preferred,
+            &type_index
+        ) &&
+        !buffer_memorytype_find(
+            memory_properties, requirements.memoryTypeBits, required, &type_index
+        )
+    ) {
+        fprintf(stderr, "buffer_create: no suitable memory type\n");
+        goto cleanup;
+    }
+
+    VkMemoryAllocateFlagsInfo flags_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+        .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR,
+    };
+
+    VkMemoryAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = (
+            (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR) != 0 ?
+            &flags_info :
+            nullptr
+        ),
+        .allocationSize = requirements.size,
+        .memoryTypeIndex = type_index,
+    };
+
+    if (vkAllocateMemory(
+        device, &allocate_info, nullptr, &buffer->memory
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "buffer_create: vkAllocateMemory failed\n");
+        goto cleanup;
+    }
+
+    if (vkBindBufferMemory(device, buffer->buffer, buffer->memory, 0) != VK_SUCCESS) {
+        fprintf(stderr, "buffer_create: vkBindBufferMemory failed\n");
+        goto cleanup;
+    }
+
+    VkMemoryPropertyFlags type_properties = (
+        memory_properties->memoryTypes[type_index].propertyFlags
+    );
+    if ((type_properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
+        if (vkMapMemory(
+            device, buffer->memory, 0, VK_WHOLE_SIZE, 0, &buffer->mapped
+        ) != VK_SUCCESS) {
+            fprintf(stderr, "buffer_create: vkMapMemory failed\n");
+            goto cleanup;
+        }
+    }
+
+    return true;
+
+cleanup:
+    buffer_destroy(device, buffer);
+
+    return false;
+}
+
+void buffer_destroy(VkDevice device, struct buffer *buffer) {
+    // Freeing the memory unmaps it
+    vkDestroyBuffer(device, buffer->buffer, nullptr);
+    vkFreeMemory(device, buffer->memory, nullptr);
+
+    *buffer = (struct buffer){};
+}
@@ -0,0 +1,59 @@
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+/// `VkBuffer` bound to a dedicated allocation, persistently mapped when the
+/// memory is host visible
+struct buffer {
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    /// `nullptr` unless the memory is host visible
+    void *mapped;
+};
+
+/// @param[in] memory_properties
+/// @param[in] type_bits `VkMemoryRequirements::memoryTypeBits`
+/// @param[in] properties
+/// @param[out] type_index
+/// @return `true` if a memory type has every flag in `properties` and
+/// `false` otherwise
+bool buffer_memorytype_find(
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    uint32_t type_bits,
+    VkMemoryPropertyFlags properties,
+    uint32_t *type_index
+);
+
+/// @param[in] device
+/// @param[in] memory_properties
+/// @param[in] size
+/// @param[in] usage
+/// @param[in] required Properties the memory must have
+/// @param[in] preferred Properties tried first in addition to `required`,
+/// e.g. `VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT` for host visible memory that
+/// the device reads often
+/// @param[out] buffer
+/// @return `true` on success and `false` otherwise
+/// @note Memory of buffers with `VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT` is
+/// allocated with `VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT`
+/// @note Caller is responsible to call `buffer_destroy` after successful return
+bool buffer_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags required,
+    VkMemoryPropertyFlags preferred,
+    struct buffer *buffer
+);
+
+/// @param[in] device
+/// @param[in,out] buffer
+/// @note `buffer` will be invalid after this function has been called
+void buffer_destroy(VkDevice device, struct buffer *buffer);
+
+#endif
@@ -0,0 +1,1003 @@
+#include <float.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bvh.h"
+
+/// Candidate splits along each axis are between bins of equal width
+constexpr size_t BVH_BINS = 16;
+/// Subtrees of at most this many objects are built by one job, and nodes of
+/// more are binned by several
+constexpr size_t BVH_JOB_OBJECTS = 1 << 14;
+/// From this depth on every split halves the objects, so that no tree of up to
+/// `2^32` objects gets deeper than `BVH_DEPTH_MAX`
+constexpr uint32_t BVH_DEPTH_HALVES = BVH_DEPTH_MAX - 32;
+/// Cost of visiting a node, relative to testing one object
+constexpr float BVH_TRAVERSAL_COST = 1.0f;
+/// Rounding error the plane tests of nodes allow for, relative to the largest
+/// term, so that a node is never culled while one of its objects is not
+constexpr float BVH_PLANE_SLACK = 8.0f * FLT_EPSILON;
+/// Smallest exponent of a quantization step, steps are normal floats
+constexpr int32_t BVH_EXPONENT_MIN = -126;
+constexpr int32_t BVH_EXPONENT_MAX = 127;
+
+/// Node of the tree while it is built, before it is flattened
+struct bvh_build_node {
+    struct bvh_bounds bounds;
+    /// First of the two adjacent children of inner nodes, or the first
+    /// reference a leaf holds
+    uint32_t index;
+    /// Objects of a leaf, zero for inner nodes
+    uint32_t count;
+};
+
+/// Object while the tree is built, moved around with the bounds the build
+/// reads so that every pass over a node reads memory in order
+struct bvh_reference {
+    struct bvh_bounds bounds;
+    uint32_t index;
+};
+
+/// Bounds of a range of references, and of their centers doubled
+struct bvh_range {
+    struct bvh_bounds bounds;
+    struct bvh_bounds centers;
+};
+
+/// How the centers of a node are sorted into bins
+struct bvh_binning {
+    /// Whether the centers are binned along each axis
+    bool axes[3];
+    /// Bins per unit along each axis
+    float scales[3];
+    /// Bounds of the centers, doubled
+    struct bvh_bounds centers;
+    uint32_t bins_count;
+};
+
+/// Bounds and counts of the references in every bin along every axis
+struct bvh_bins {
+    struct bvh_bounds bounds[3][BVH_BINS];
+    uint32_t counts[3][BVH_BINS];
+};
+
+/// References of a large node binned by one job
+struct bvh_bin_job {
+    const struct bvh_reference *references;
+    uint32_t count;
+    const struct bvh_binning *binning;
+    struct bvh_bins bins;
+};
+
+struct bvh_builder;
+
+/// Subtree built by one job
+struct bvh_task {
+    struct bvh_builder *builder;
+    uint32_t node;
+    uint32_t first;
+    uint32_t count;
+    uint32_t depth;
+    struct bvh_range range;
+};
+
+struct bvh_builder {
+    /// May be `nullptr`
+    struct jobs *jobs;
+    /// Of every object, reordered so that every node holds a range of them
+    struct bvh_reference *references;
+
+    /// Children are allocated in pairs from any job
+    struct bvh_build_node *nodes;
+    atomic_size_t nodes_count;
+
+    /// Subtrees of at most `task_objects` objects left for jobs
+    struct bvh_task *tasks;
+    size_t tasks_count;
+    size_t task_objects;
+};
+
+/// Node still to be written out, second children remember their parent, which
+/// points to them
+struct bvh_flatten_entry {
+    uint32_t node;
+    uint32_t parent;
+    uint32_t depth;
+};
+
+/// Node still to be visited by a frustum query
+struct bvh_frustum_entry {
+    uint32_t node;
+    /// Planes the node is not yet known to be entirely inside of
+    uint32_t planes;
+};
+
+/// Node still to be visited by a ray
+struct bvh_ray_entry {
+    uint32_t node;
+    /// Along the ray to where it enters the node
+    float distance;
+};
+
+/// @param[out] bounds Empty, growing it by anything gives that
+static void bvh_bounds_empty(struct bvh_bounds *bounds) {
+    for (size_t c = 0; c < 3; c++) {
+        bounds->min[c] = INFINITY;
+        bounds->max[c] = -INFINITY;
+    }
+}
+
+/// Compares instead of calling `fminf` and `fmaxf`, which handle NaN and are
+/// not inlined, as builds spend most of their time here
+/// @param[in,out] bounds
+/// @param[in] other
+static void bvh_bounds_grow(
+    struct bvh_bounds *bounds, const struct bvh_bounds *other
+) {
+    for (size_t c = 0; c < 3; c++) {
+        bounds->min[c] = other->min[c] < bounds->min[c] ? other->min[c] : bounds->min[c];
+        bounds->max[c] = other->max[c] > bounds->max[c] ? other->max[c] : bounds->max[c];
+    }
+}
+
+/// @param[in] bounds
+/// @return Half the surface area, zero for empty bounds
+static float bvh_bounds_area(const struct bvh_bounds *bounds) {
+    float size[3];
+    for (size_t c = 0; c < 3; c++) {
+        float extent = bounds->max[c] - bounds->min[c];
+        size[c] = extent > 0.0f ? extent : 0.0f;
+    }
+
+    return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+/// @param[in] objects
+/// @param[in] index
+/// @param[out] bounds The smaller of the box of the object and the box around
+/// its sphere. An object that either of them puts outside a plane is culled,
+/// so both are as good for queries.
+static void bvh_object_bounds(
+    const struct cull_objects *objects, uint32_t index, struct bvh_bounds *bounds
+) {
+    const float center[3] = {
+        objects->center_x[index], objects->center_y[index], objects->center_z[index],
+    };
+    float extent[3] = {
+        objects->extent_x[index], objects->extent_y[index], objects->extent_z[index],
+    };
+    float radius = objects->radius[index];
+    float area = extent[0] * extent[1] + extent[1] * extent[2] + extent[2] * extent[0];
+    if (radius * radius * 3.0f < area) {
+        extent[0] = radius;
+        extent[1] = radius;
+        extent[2] = radius;
+    }
+
+    for (size_t c = 0; c < 3; c++) {
+        bounds->min[c] = center[c] - extent[c];
+        bounds->max[c] = center[c] + extent[c];
+    }
+}
+
+/// @param[in] exponent In `[BVH_EXPONENT_MIN, BVH_EXPONENT_MAX]`
+/// @return `2^exponent`, built from its bits
+static float bvh_step(int32_t exponent) {
+    uint32_t bits = (uint32_t) (exponent + 127) << 23;
+    float step;
+    memcpy(&step, &bits, sizeof(step));
+
+    return step;
+}
+
+/// Quantizes the bounds of both children of an inner node
+/// @param[in,out] node
+/// @param[in] children
+static void bvh_node_quantize(
+    struct bvh_node *node, const struct bvh_bounds *children[2]
+) {
+    for (size_t c = 0; c < 3; c++) {
+        float min = fminf(children[0]->min[c], children[1]->min[c]);
+        float max = fmaxf(children[0]->max[c], children[1]->max[c]);
+
+        // Smallest step that reaches from one end to the other in 255 of them,
+        // from the exponent bits rather than `frexpf` as refits run this for
+        // every node
+        float quantum = (max - min) / 255.0f;
+        uint32_t bits;
+        memcpy(&bits, &quantum, sizeof(bits));
+        int32_t exponent = (int32_t) ((bits >> 23) & 0xff) - 126;
+        exponent = exponent < BVH_EXPONENT_MIN ? BVH_EXPONENT_MIN : exponent;
+        exponent = exponent > BVH_EXPONENT_MAX ? BVH_EXPONENT_MAX : exponent;
+        while (
+            exponent < BVH_EXPONENT_MAX && min + 255.0f * bvh_step(exponent) < max
+        ) {
+            exponent++;
+        }
+        float step = bvh_step(exponent);
+        node->origin[c] = min;
+        node->exponents[c] = (int8_t) exponent;
+
+        // Rounded outwards as the queries decode them, rounding included
+        for (size_t child = 0; child < 2; child++) {
+            float low = (children[child]->min[c] - min) / step;
+            float high = (children[child]->max[c] - min) / step;
+            int32_t low_steps = low > 0.0f ? low < 255.0f ? (int32_t) low : 255 : 0;
+            int32_t high_steps = high > 0.0f ? high < 255.0f ? (int32_t) high : 255 : 0;
+            while (
+                low_steps > 0 &&
+                min + (float) low_steps * step > children[child]->min[c]
+            ) {
+                low_steps--;
+            }
+            while (
+                high_steps < 255 &&
+                min + (float) high_steps * step < children[child]->max[c]
+            ) {
+                high_steps++;
+            }
+            node->child_min[child][c] = (uint8_t) low_steps;
+            node->child_max[child][c] = (uint8_t) high_steps;
+        }
+    }
+}
+
+/// @param[in] node Inner node
+/// @param[in] child Zero or one
+/// @param[out] bounds Contain those of the child
+static void bvh_child_bounds(
+    const struct bvh_node *node, size_t child, struct bvh_bounds *bounds
+) {
+    for (size_t c = 0; c < 3; c++) {
+        float step = bvh_step(node->exponents[c]);
+        bounds->min[c] = node->origin[c] + (float) node->child_min[child][c] * step;
+        bounds->max[c] = node->origin[c] + (float) node->child_max[child][c] * step;
+    }
+}
+
+/// @param[in] reference
+/// @param[in] axis
+/// @param[in] binning
+/// @return Bin the center of the object falls into
+static uint32_t bvh_bin(
+    const struct bvh_reference *reference, size_t axis, const struct bvh_binning *binning
+) {
+    float center = reference->bounds.min[axis] + reference->bounds.max[axis];
+    float offset = center - binning->centers.min[axis];
+    uint32_t bin = (uint32_t) (offset * binning->scales[axis]);
+
+    return bin < binning->bins_count ? bin : binning->bins_count - 1;
+}
+
+/// @param[in] references
+/// @param[in] count
+/// @param[in] binning
+/// @param[out] bins
+static void bvh_references_bin(
+    const struct bvh_reference *references,
+    uint32_t count,
+    const struct bvh_binning *binning,
+    struct bvh_bins *bins
+) {
+    for (size_t axis = 0; axis < 3; axis++) {
+        for (uint32_t bin = 0; bin < binning->bins_count; bin++) {
+            bvh_bounds_empty(&bins->bounds[axis][bin]);
+            bins->counts[axis][bin] = 0;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        for (size_t axis = 0; axis < 3; axis++) {
+            if (binning->axes[axis]) {
+                uint32_t bin = bvh_bin(&references[i], axis, binning);
+                bvh_bounds_grow(&bins->bounds[axis][bin], &references[i].bounds);
+                bins->counts[axis][bin]++;
+            }
+        }
+    }
+}
+
+/// @param[in,out] argument `struct bvh_bin_job`
+static void bvh_bin_job_run(void *argument) {
+    struct bvh_bin_job *job = argument;
+    bvh_references_bin(job->references, job->count, job->binning, &job->bins);
+}
+
+/// Bins the references of a node, in parallel when there are many
+/// @param[in,out] builder
+/// @param[in] references
+/// @param[in] count
+/// @param[in] binning
+/// @param[out] bins
+static void bvh_node_bin(
+    struct bvh_builder *builder,
+    const struct bvh_reference *references,
+    uint32_t count,
+    const struct bvh_binning *binning,
+    struct bvh_bins *bins
+) {
+    size_t jobs_count = (count + BVH_JOB_OBJECTS - 1) / BVH_JOB_OBJECTS;
+    struct bvh_bin_job *bin_jobs = builder->jobs != nullptr && jobs_count > 1
+        ? malloc(sizeof(bin_jobs[0]) * jobs_count)
+        : nullptr;
+    if (bin_jobs == nullptr) {
+        bvh_references_bin(references, count, binning, bins);
+        return;
+    }
+
+    struct jobs_counter counter = {};
+    for (size_t i = 0; i < jobs_count; i++) {
+        size_t first = i * BVH_JOB_OBJECTS;
+        bin_jobs[i] = (struct bvh_bin_job){
+            .references = references + first,
+            .count = (uint32_t) (
+                count - first < BVH_JOB_OBJECTS ? count - first : BVH_JOB_OBJECTS
+            ),
+            .binning = binning,
+        };
+        if (!jobs_submit(builder->jobs, bvh_bin_job_run, &bin_jobs[i], &counter)) {
+            bvh_bin_job_run(&bin_jobs[i]);
+        }
+    }
+    jobs_counter_wait(builder->jobs, &counter);
+
+    *bins = bin_jobs[0].bins;
+    for (size_t i = 1; i < jobs_count; i++) {
+        for (size_t axis = 0; axis < 3; axis++) {
+            for (uint32_t bin = 0; bin < binning->bins_count; bin++) {
+                const struct bvh_bins *job_bins = &bin_jobs[i].bins;
+                bvh_bounds_grow(&bins->bounds[axis][bin], &job_bins->bounds[axis][bin]);
+                bins->counts[axis][bin] += job_bins->counts[axis][bin];
+            }
+        }
+    }
+    free(bin_jobs);
+}
+
+/// @param[in,out] range
+/// @param[in] reference
+static void bvh_range_grow(
+    struct bvh_range *range, const struct bvh_reference *reference
+) {
+    bvh_bounds_grow(&range->bounds, &reference->bounds);
+    for (size_t c = 0; c < 3; c++) {
+        float center = reference->bounds.min[c] + reference->bounds.max[c];
+        range->centers.min[c] = center < range->centers.min[c]
+            ? center
+            : range->centers.min[c];
+        range->centers.max[c] = center > range->centers.max[c]
+            ? center
+            : range->centers.max[c];
+    }
+}
+
+/// Finds the split of the surface area heuristic among up to `BVH_BINS - 1`
+/// candidates along each axis, and reorders the references accordingly. Nodes
+/// of few objects take about one bin per object, as most nodes are small and
+/// sweeping empty bins would cost them more than the binning itself.
+/// @param[in,out] builder
+/// @param[in] first
+/// @param[in] count At least two
+/// @param[in] depth
+/// @param[in] range Of the objects
+/// @param[out] children Ranges of the objects left and right of the split
+/// @return Objects left of the split, zero when a leaf is cheaper
+static uint32_t bvh_split(
+    struct bvh_builder *builder,
+    uint32_t first,
+    uint32_t count,
+    uint32_t depth,
+    const struct bvh_range *range,
+    struct bvh_range children[2]
+) {
+    struct bvh_reference *references = builder->references + first;
+
+    // Axes along which every center is in the same place are not binned
+    struct bvh_binning binning = {
+        .centers = range->centers,
+        .bins_count = count < BVH_BINS ? count : BVH_BINS,
+    };
+    bool binned = false;
+    for (size_t axis = 0; axis < 3; axis++) {
+        float extent = range->centers.max[axis] - range->centers.min[axis];
+        binning.axes[axis] = depth < BVH_DEPTH_HALVES && extent > 0.0f;
+        binning.scales[axis] = binning.axes[axis]
+            ? (float) binning.bins_count / extent
+            : 0.0f;
+        binned = binned || binning.axes[axis];
+    }
+
+    float best_cost = INFINITY;
+    size_t best_axis = 0;
+    uint32_t best_bin = 0;
+    struct bvh_bins bins;
+    if (binned) {
+        bvh_node_bin(builder, references, count, &binning, &bins);
+    }
+    for (size_t axis = 0; axis < 3; axis++) {
+        if (!binning.axes[axis]) {
+            continue;
+        }
+
+        // Areas and counts right of every candidate, then sweep from the left
+        float right_areas[BVH_BINS];
+        uint32_t right_counts[BVH_BINS];
+        struct bvh_bounds right;
+        bvh_bounds_empty(&right);
+        uint32_t right_count = 0;
+        for (uint32_t bin = binning.bins_count - 1; bin > 0; bin--) {
+            bvh_bounds_grow(&right, &bins.bounds[axis][bin]);
+            right_count += bins.counts[axis][bin];
+            right_areas[bin] = bvh_bounds_area(&right);
+            right_counts[bin] = right_count;
+        }
+
+        struct bvh_bounds left;
+        bvh_bounds_empty(&left);
+        uint32_t left_count = 0;
+        for (uint32_t bin = 0; bin < binning.bins_count - 1; bin++) {
+            bvh_bounds_grow(&left, &bins.bounds[axis][bin]);
+            left_count += bins.counts[axis][bin];
+            if (left_count == 0 || right_counts[bin + 1] == 0) {
+                continue;
+            }
+
+            float cost = bvh_bounds_area(&left) * (float) left_count +
+                right_areas[bin + 1] * (float) right_counts[bin + 1];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = bin;
+            }
+        }
+    }
+
+    // Costs are left multiplied by the area of the node, which cancels out
+    float area = bvh_bounds_area(&range->bounds);
+    if (
+        count <= BVH_LEAF_OBJECTS &&
+        (float) count * area <= BVH_TRAVERSAL_COST * area + best_cost
+    ) {
+        return 0;
+    }
+
+    for (size_t child = 0; child < 2; child++) {
+        bvh_bounds_empty(&children[child].bounds);
+        bvh_bounds_empty(&children[child].centers);
+    }
+
+    // Too deep, or every center in the same place
+    if (best_cost == INFINITY) {
+        for (uint32_t i = 0; i < count; i++) {
+            bvh_range_grow(&children[i < count / 2 ? 0 : 1], &references[i]);
+        }
+        return count / 2;
+    }
+
+    // Every reference is looked at once, where it is decided on
+    uint32_t left_count = 0;
+    uint32_t right_first = count;
+    while (left_count < right_first) {
+        if (bvh_bin(&references[left_count], best_axis, &binning) <= best_bin) {
+            bvh_range_grow(&children[0], &references[left_count]);
+            left_count++;
+        } else {
+            right_first--;
+            bvh_range_grow(&children[1], &references[left_count]);
+            struct bvh_reference reference = references[left_count];
+            references[left_count] = references[right_first];
+            references[right_first] = reference;
+        }
+    }
+
+    return left_count;
+}
+
+/// @param[in,out] builder
+/// @param[in] node Allocated but not yet written
+/// @param[in] first
+/// @param[in] count At least one
+/// @param[in] depth Of `node`
+/// @param[in] range Of the objects
+/// @param[in] deferring Whether small enough subtrees are left for jobs
+static void bvh_subtree_build(
+    struct bvh_builder *builder,
+    uint32_t node,
+    uint32_t first,
+    uint32_t count,
+    uint32_t depth,
+    const struct bvh_range *range,
+    bool deferring
+) {
+    if (deferring && count <= builder->task_objects) {
+        builder->tasks[builder->tasks_count] = (struct bvh_task){
+            .builder = builder,
+            .node = node,
+            .first = first,
+            .count = count,
+            .depth = depth,
+            .range = *range,
+        };
+        builder->tasks_count++;
+        return;
+    }
+
+    struct bvh_range children[2];
+    uint32_t left_count = count > 1
+        ? bvh_split(builder, first, count, depth, range, children)
+        : 0;
+    struct bvh_build_node *build_node = &builder->nodes[node];
+    build_node->bounds = range->bounds;
+    if (left_count == 0) {
+        build_node->index = first;
+        build_node->count = count;
+        return;
+    }
+
+    uint32_t index = (uint32_t) atomic_fetch_add(&builder->nodes_count, 2);
+    build_node->index = index;
+    build_node->count = 0;
+    bvh_subtree_build(
+        builder, index, first, left_count, depth + 1, &children[0], deferring
+    );
+    bvh_subtree_build(
+        builder,
+        index + 1,
+        first + left_count,
+        count - left_count,
+        depth + 1,
+        &children[1],
+        deferring
+    );
+}
+
+/// @param[in,out] argument `struct bvh_task`
+static void bvh_task_build(void *argument) {
+    const struct bvh_task *task = argument;
+    bvh_subtree_build(
+        task->builder,
+        task->node,
+        task->first,
+        task->count,
+        task->depth,
+        &task->range,
+        false
+    );
+}
+
+/// Writes the built tree out in depth first order, so that the first child of
+/// every inner node follows it
+/// @param[in] builder
+/// @param[in,out] bvh With room for every node
+static void bvh_flatten(const struct bvh_builder *builder, struct bvh *bvh) {
+    struct bvh_flatten_entry stack[BVH_DEPTH_MAX + 1];
+    size_t stack_count = 0;
+    stack[stack_count++] = (struct bvh_flatten_entry){
+        .parent = UINT32_MAX, .depth = 1,
+    };
+
+    size_t next = 0;
+    bvh->depth = 0;
+    while (stack_count > 0) {
+        struct bvh_flatten_entry entry = stack[--stack_count];
+        uint32_t index = (uint32_t) next++;
+        if (entry.parent != UINT32_MAX) {
+            bvh->nodes[entry.parent].index = index;
+        }
+        bvh->depth = entry.depth > bvh->depth ? entry.depth : bvh->depth;
+
+        const struct bvh_build_node *build_node = &builder->nodes[entry.node];
+        bvh->bounds[index] = build_node->bounds;
+        bvh->nodes[index] = (struct bvh_node){
+            .count = (uint8_t) build_node->count,
+            .index = build_node->index,
+        };
+        if (build_node->count == 0) {
+            stack[stack_count++] = (struct bvh_flatten_entry){
+                .node = build_node->index + 1,
+                .parent = index,
+                .depth = entry.depth + 1,
+            };
+            stack[stack_count++] = (struct bvh_flatten_entry){
+                .node = build_node->index,
+                .parent = UINT32_MAX,
+                .depth = entry.depth + 1,
+            };
+        }
+    }
+
+    for (size_t i = 0; i < bvh->nodes_count; i++) {
+        if (bvh->nodes[i].count == 0) {
+            const struct bvh_bounds *children[2] = {
+                &bvh->bounds[i + 1], &bvh->bounds[bvh->nodes[i].index],
+            };
+            bvh_node_quantize(&bvh->nodes[i], children);
+        }
+    }
+}
+
+bool bvh_build(struct jobs *jobs, const struct cull_objects *objects, struct bvh *bvh) {
+    *bvh = (struct bvh){};
+    if (objects->count == 0) {
+        return true;
+    }
+    if (objects->count > UINT32_MAX / 2) {
+        fprintf(stderr, "bvh_build: too many objects\n");
+        return false;
+    }
+
+    bool success = false;
+    uint32_t count = (uint32_t) objects->count;
+    size_t task_objects = jobs == nullptr ? count : BVH_JOB_OBJECTS;
+    // Subtrees too large for a job have disjoint objects at every depth, and
+    // each of them leaves at most two subtrees for jobs
+    size_t tasks_capacity = 2 * BVH_DEPTH_MAX * (count / task_objects + 1);
+    struct bvh_builder builder = {
+        .jobs = jobs,
+        .references = malloc(sizeof(builder.references[0]) * count),
+        .nodes = malloc(sizeof(builder.nodes[0]) * (2 * (size_t) count - 1)),
+        .tasks = malloc(sizeof(builder.tasks[0]) * tasks_capacity),
+        .task_objects = task_objects,
+    };
+    struct jobs_counter counter = {};
+    bvh->indices = malloc(sizeof(bvh->indices[0]) * count);
+    bvh->indices_count = count;
+    if (
+        builder.references == nullptr ||
+        builder.nodes == nullptr ||
+        builder.tasks == nullptr ||
+        bvh->indices == nullptr
+    ) {
+        fprintf(stderr, "bvh_build: malloc failed\n");
+        goto cleanup;
+    }
+
+    struct bvh_range range;
+    bvh_bounds_empty(&range.bounds);
+    bvh_bounds_empty(&range.centers);
+    for (uint32_t i = 0; i < count; i++) {
+        builder.references[i].index = i;
+        bvh_object_bounds(objects, i, &builder.references[i].bounds);
+        bvh_range_grow(&range, &builder.references[i]);
+    }
+    atomic_init(&builder.nodes_count, 1);
+
+    // The top of the tree is split on this thread, binning large nodes on the
+    // jobs, until subtrees are small enough to be built by one job each
+    bvh_subtree_build(&builder, 0, 0, count, 1, &range, true);
+    for (size_t i = 0; i < builder.tasks_count; i++) {
+        if (
+            jobs == nullptr ||
+            !jobs_submit(jobs, bvh_task_build, &builder.tasks[i], &counter)
+        ) {
+            bvh_task_build(&builder.tasks[i]);
+        }
+    }
+    if (jobs != nullptr) {
+        jobs_counter_wait(jobs, &counter);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        bvh->indices[i] = builder.references[i].index;
+    }
+
+    bvh->nodes_count = atomic_load(&builder.nodes_count);
+    bvh->nodes = malloc(sizeof(bvh->nodes[0]) * bvh->nodes_count);
+    bvh->bounds = malloc(sizeof(bvh->bounds[0]) * bvh->nodes_count);
+    if (bvh->nodes == nullptr || bvh->bounds == nullptr) {
+        fprintf(stderr, "bvh_build: malloc failed\n");
+        goto cleanup;
+    }
+    bvh_flatten(&builder, bvh);
+
+    success = true;
+
+cleanup:
+    free(builder.tasks);
+    free(builder.nodes);
+    free(builder.references);
+    if (!success) {
+        bvh_destroy(bvh);
+    }
+
+    return success;
+}
+
+void bvh_destroy(struct bvh *bvh) {
+    free(bvh->indices);
+    free(bvh->bounds);
+    free(bvh->nodes);
+}
+
+void bvh_refit(struct bvh *bvh, const struct cull_objects *objects) {
+    // Children come after their parents, so walking backwards finishes them
+    // before their parents need them
+    for (size_t i = bvh->nodes_count; i-- > 0;) {
+        struct bvh_node *node = &bvh->nodes[i];
+        struct bvh_bounds *bounds = &bvh->bounds[i];
+        if (node->count > 0) {
+            bvh_bounds_empty(bounds);
+            for (uint32_t j = 0; j < node->count; j++) {
+                struct bvh_bounds object_bounds;
+                uint32_t object = bvh->indices[node->index + j];
+                bvh_object_bounds(objects, object, &object_bounds);
+                bvh_bounds_grow(bounds, &object_bounds);
+            }
+            continue;
+        }
+
+        const struct bvh_bounds *children[2] = {
+            &bvh->bounds[i + 1], &bvh->bounds[node->index],
+        };
+        *bounds = *children[0];
+        bvh_bounds_grow(bounds, children[1]);
+        bvh_node_quantize(node, children);
+    }
+}
+
+/// @param[in] bounds
+/// @param[in] frustum
+/// @param[in,out] planes Those to test, planes the bounds are entirely inside
+/// of are removed
+/// @return Whether the bounds are inside every plane tested
+static bool bvh_bounds_frustum(
+    const struct bvh_bounds *bounds, const struct cull_frustum *frustum, uint32_t *planes
+) {
+    for (size_t p = 0; p < 6; p++) {
+        if (!(*planes & (1u << p))) {
+            continue;
+        }
+
+        // Distances of the corners furthest in front and behind
+        const float *plane = frustum->planes[p];
+        float front = plane[3];
+        float back = plane[3];
+        float magnitude = fabsf(plane[3]);
+        for (size_t c = 0; c < 3; c++) {
+            float low = plane[c] * bounds->min[c];
+            float high = plane[c] * bounds->max[c];
+            front += low > high ? low : high;
+            back += low < high ? low : high;
+            magnitude += fabsf(low) > fabsf(high) ? fabsf(low) : fabsf(high);
+        }
+
+        float slack = BVH_PLANE_SLACK * magnitude;
+        if (front < -slack) {
+            return false;
+        }
+        if (back > slack) {
+            *planes &= ~(1u << p);
+        }
+    }
+
+    return true;
+}
+
+void bvh_frustum(
+    const struct bvh *bvh,
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    uint32_t *visible,
+    size_t *visible_count
+) {
+    *visible_count = 0;
+    uint32_t planes = CULL_PLANES_ALL;
+    if (
+        bvh->nodes_count == 0 ||
+        !bvh_bounds_frustum(&bvh->bounds[0], frustum, &planes)
+    ) {
+        return;
+    }
+
+    struct bvh_frustum_entry stack[BVH_DEPTH_MAX + 1];
+    size_t stack_count = 0;
+    stack[stack_count++] = (struct bvh_frustum_entry){.planes = planes};
+
+    while (stack_count > 0) {
+        struct bvh_frustum_entry entry = stack[--stack_count];
+        const struct bvh_node *node = &bvh->nodes[entry.node];
+        if (node->count > 0) {
+            // Nothing left to test once a node is inside every plane
+            for (uint32_t j = 0; j < node->count; j++) {
+                uint32_t index = bvh->indices[node->index + j];
+                visible[*visible_count] = index;
+                *visible_count += entry.planes == 0 ||
+                    cull_object_visible(objects, frustum, entry.planes, index);
+            }
+            continue;
+        }
+
+        const uint32_t children[2] = {entry.node + 1, node->index};
+        for (size_t child = 0; child < 2; child++) {
+            struct bvh_bounds bounds;
+            bvh_child_bounds(node, child, &bounds);
+            uint32_t child_planes = entry.planes;
+            if (
+                child_planes == 0 ||
+                bvh_bounds_frustum(&bounds, frustum, &child_planes)
+            ) {
+                stack[stack_count++] = (struct bvh_frustum_entry){
+                    .node = children[child], .planes = child_planes,
+                };
+            }
+        }
+    }
+}
+
+/// @param[in] bounds
+/// @param[in] origin
+/// @param[in] inverse_direction
+/// @param[in] max_distance
+/// @param[out] distance Where the ray enters the bounds, zero when the origin
+/// is inside them
+/// @return Whether the ray enters the bounds within `max_distance`
+static bool bvh_bounds_ray(
+    const struct bvh_bounds *bounds,
+    const float origin[3],
+    const float inverse_direction[3],
+    float max_distance,
+    float *distance
+) {
+    float enter = 0.0f;
+    float exit = max_distance;
+    for (size_t c = 0; c < 3; c++) {
+        float low = (bounds->min[c] - origin[c]) * inverse_direction[c];
+        float high = (bounds->max[c] - origin[c]) * inverse_direction[c];
+        enter = fmaxf(enter, fminf(low, high));
+        exit = fminf(exit, fmaxf(low, high));
+    }
+    *distance = enter;
+
+    return enter <= exit;
+}
+
+bool bvh_ray(
+    const struct bvh *bvh,
+    const struct cull_objects *objects,
+    const float origin[3],
+    const float direction[3],
+    float max_distance,
+    uint32_t *index,
+    float *distance
+) {
+    const float inverse_direction[3] = {
+        1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2],
+    };
+    float entered;
+    if (
+        bvh->nodes_count == 0 ||
+        !bvh_bounds_ray(
+            &bvh->bounds[0], origin, inverse_direction, max_distance, &entered
+        )
+    ) {
+        return false;
+    }
+
+    struct bvh_ray_entry stack[BVH_DEPTH_MAX + 1];
+    size_t stack_count = 0;
+    stack[stack_count++] = (struct bvh_ray_entry){.distance = entered};
+
+    bool hit = false;
+    float nearest = max_distance;
+    while (stack_count > 0) {
+        struct bvh_ray_entry entry = stack[--stack_count];
+        if (entry.distance > nearest) {
+            continue;
+        }
+
+        const struct bvh_node *node = &bvh->nodes[entry.node];
+        if (node->count > 0) {
+            for (uint32_t j = 0; j < node->count; j++) {
+                uint32_t object = bvh->indices[node->index + j];
+                struct bvh_bounds bounds;
+                bvh_object_bounds(objects, object, &bounds);
+                bool entered_object = bvh_bounds_ray(
+                    &bounds, origin, inverse_direction, nearest, &entered
+                );
+                if (entered_object && (!hit || entered < nearest)) {
+                    hit = true;
+                    nearest = entered;
+                    *index = object;
+                }
+            }
+            continue;
+        }
+
+        // The nearer child goes on top, so that it is visited first
+        const uint32_t children[2] = {entry.node + 1, node->index};
+        float distances[2];
+        bool entered_children[2];
+        for (size_t child = 0; child < 2; child++) {
+            struct bvh_bounds bounds;
+            bvh_child_bounds(node, child, &bounds);
+            entered_children[child] = bvh_bounds_ray(
+                &bounds, origin, inverse_direction, nearest, &distances[child]
+            );
+        }
+        size_t near = distances[1] < distances[0] ? 1 : 0;
+        for (size_t i = 0; i < 2; i++) {
+            size_t child = i == 0 ? 1 - near : near;
+            if (entered_children[child]) {
+                stack[stack_count++] = (struct bvh_ray_entry){
+                    .node = children[child], .distance = distances[child],
+                };
+            }
+        }
+    }
+
+    if (hit) {
+        *distance = nearest;
+    }
+
+    return hit;
+}
+
+/// @param[in] bounds
+/// @param[in] center
+/// @param[in] radius
+/// @return Whether the bounds come within `radius` of `center`
+static bool bvh_bounds_sphere(
+    const struct bvh_bounds *bounds, const float center[3], float radius
+) {
+    float distance = 0.0f;
+    for (size_t c = 0; c < 3; c++) {
+        float below = bounds->min[c] - center[c];
+        float above = center[c] - bounds->max[c];
+        float outside = below > above ? below : above;
+        distance += outside > 0.0f ? outside * outside : 0.0f;
+    }
+
+    return distance <= radius * radius;
+}
+
+void bvh_sphere(
+    const struct bvh *bvh,
+    const struct cull_objects *objects,
+    const float center[3],
+    float radius,
+    uint32_t *indices,
+    size_t capacity,
+    size_t *count
+) {
+    *count = 0;
+    if (
+        bvh->nodes_count == 0 ||
+        !bvh_bounds_sphere(&bvh->bounds[0], center, radius)
+    ) {
+        return;
+    }
+
+    uint32_t stack[BVH_DEPTH_MAX + 1];
+    size_t stack_count = 0;
+    stack[stack_count++] = 0;
+
+    while (stack_count > 0) {
+        uint32_t index = stack[--stack_count];
+        const struct bvh_node *node = &bvh->nodes[index];
+        if (node->count > 0) {
+            for (uint32_t j = 0; j < node->count; j++) {
+                uint32_t object = bvh->indices[node->index + j];
+                struct bvh_bounds bounds;
+                bvh_object_bounds(objects, object, &bounds);
+                if (bvh_bounds_sphere(&bounds, center, radius)) {
+                    if (*count < capacity) {
+                        indices[*count] = object;
+                    }
+                    (*count)++;
+                }
+            }
+            continue;
+        }
+
+        const uint32_t children[2] = {index + 1, node->index};
+        for (size_t child = 0; child < 2; child++) {
+            struct bvh_bounds bounds;
+            bvh_child_bounds(node, child, &bounds);
+            if (bvh_bounds_sphere(&bounds, center, radius)) {
+                stack[stack_count++] = children[child];
+            }
+        }
+    }
+}
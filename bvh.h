@@ -0,0 +1,133 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cull.h"
+#include "jobs.h"
+
+/// Objects a leaf holds at most
+constexpr uint32_t BVH_LEAF_OBJECTS = 8;
+/// No leaf is deeper than this, which bounds the stacks of every query
+constexpr uint32_t BVH_DEPTH_MAX = 64;
+
+/// Axis aligned box
+struct bvh_bounds {
+    float min[3];
+    float max[3];
+};
+
+/// Node of a tree flattened in depth first order, two of them to a cache line.
+/// The bounds of both children are stored in the parent, quantized to eight
+/// bits per plane on a grid of power of two steps from `origin` and rounded
+/// outwards, so a query decides which children to visit without touching them.
+struct bvh_node {
+    /// Corner of the grid the children are quantized on
+    float origin[3];
+    /// Steps of the grid are `2^exponents[i]` along axis `i`
+    int8_t exponents[3];
+    /// Objects of a leaf, zero for inner nodes
+    uint8_t count;
+    /// Bounds of the first and second child in steps from `origin`
+    uint8_t child_min[2][3];
+    uint8_t child_max[2][3];
+    /// Second child of inner nodes, whose first child follows them directly, or
+    /// the first entry of `indices` a leaf holds
+    uint32_t index;
+};
+
+/// Bounding volume hierarchy over the objects of a `struct cull_objects`, to
+/// cull, pick and find objects near a point without visiting all of them. The
+/// box of an object is the smaller of its box and the box around its sphere.
+struct bvh {
+    struct bvh_node *nodes;
+    /// Full precision bounds of every node, which refits start from and the
+    /// root is tested against
+    struct bvh_bounds *bounds;
+    size_t nodes_count;
+
+    /// Objects in the order the leaves refer to them
+    uint32_t *indices;
+    size_t indices_count;
+
+    /// Of the deepest leaf, the root being at depth one
+    uint32_t depth;
+};
+
+/// Builds the tree top down, splitting where the surface area heuristic finds
+/// it cheapest among binned candidates. Subtrees of few enough objects are
+/// built in parallel.
+/// @param[in,out] jobs May be `nullptr`
+/// @param[in] objects
+/// @param[out] bvh
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `bvh_destroy` after successful return
+bool bvh_build(struct jobs *jobs, const struct cull_objects *objects, struct bvh *bvh);
+
+/// @param[in,out] bvh
+/// @note `bvh` will be invalid after this function has been called
+void bvh_destroy(struct bvh *bvh);
+
+/// Updates the bounds of every node after objects moved, keeping the structure
+/// of the tree. Queries get slower the further objects move from where they
+/// were when it was built.
+/// @param[in,out] bvh
+/// @param[in] objects The objects it was built from, none added or removed
+void bvh_refit(struct bvh *bvh, const struct cull_objects *objects);
+
+/// Finds the objects `cull_objects_test` finds, skipping subtrees outside a
+/// plane and the tests of planes a subtree is entirely inside of
+/// @param[in] bvh
+/// @param[in] objects
+/// @param[in] frustum
+/// @param[out] visible `objects->count` entries, of which the first
+/// `visible_count` are the indices of the visible objects in no certain order
+/// @param[out] visible_count
+void bvh_frustum(
+    const struct bvh *bvh,
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    uint32_t *visible,
+    size_t *visible_count
+);
+
+/// Finds the object whose box a ray enters first
+/// @param[in] bvh
+/// @param[in] objects
+/// @param[in] origin
+/// @param[in] direction Need not be unit length, distances are in its units
+/// @param[in] max_distance Objects entered further away are not hit
+/// @param[out] index Of the object, left as it is when nothing is hit
+/// @param[out] distance Along the ray to where it enters the box, zero when the
+/// origin is inside it
+/// @return Whether an object is hit
+bool bvh_ray(
+    const struct bvh *bvh,
+    const struct cull_objects *objects,
+    const float origin[3],
+    const float direction[3],
+    float max_distance,
+    uint32_t *index,
+    float *distance
+);
+
+/// Finds the objects whose box comes within `radius` of `center`
+/// @param[in] bvh
+/// @param[in] objects
+/// @param[in] center
+/// @param[in] radius
+/// @param[out] indices
+/// @param[in] capacity Entries of `indices`
+/// @param[out] count Objects found, of which the first `capacity` are written
+void bvh_sphere(
+    const struct bvh *bvh,
+    const struct cull_objects *objects,
+    const float center[3],
+    float radius,
+    uint32_t *indices,
+    size_t capacity,
+    size_t *count
+);
+
+#endif
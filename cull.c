@@ -0,0 +1,601 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "cull.h"
+
+/// Objects tested by one job, a multiple of `CULL_WIDTH`
+constexpr size_t CULL_JOB_OBJECTS = 1 << 16;
+/// Components of every object, each one an array of `capacity` floats
+constexpr size_t CULL_COMPONENTS = 7;
+
+/// @param[in] objects
+/// @param[in] frustum
+/// @param[in] first Multiple of `CULL_WIDTH`
+/// @param[in] count Multiple of `CULL_WIDTH`
+/// @param[out] visible `count` entries, the visible ones are written from the
+/// start
+/// @return Number of visible objects
+typedef size_t (*cull_function)(
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    size_t first,
+    size_t count,
+    uint32_t *visible
+);
+
+/// An object is outside a plane when its center lies further behind it than
+/// the smaller of the radius and the projected extent of the box, so the
+/// sphere and the box are tested at once. Every kernel evaluates this in the
+/// same order without fused multiply adds, so they all agree to the bit.
+bool cull_object_visible(
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    uint32_t planes,
+    uint32_t index
+) {
+    bool inside = true;
+    for (size_t p = 0; p < 6; p++) {
+        if (!(planes & (1u << p))) {
+            continue;
+        }
+
+        const float *plane = frustum->planes[p];
+        float distance = plane[0] * objects->center_x[index] +
+            plane[1] * objects->center_y[index] +
+            plane[2] * objects->center_z[index] +
+            plane[3];
+        float extent = fabsf(plane[0]) * objects->extent_x[index] +
+            fabsf(plane[1]) * objects->extent_y[index] +
+            fabsf(plane[2]) * objects->extent_z[index];
+        float radius = objects->radius[index];
+        float reach = radius < extent ? radius : extent;
+        inside = inside && !(distance < -reach);
+    }
+
+    return inside;
+}
+
+static size_t cull_scalar(
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    size_t first,
+    size_t count,
+    uint32_t *visible
+) {
+    size_t visible_count = 0;
+    for (size_t i = first; i < first + count; i++) {
+        visible[visible_count] = (uint32_t) i;
+        visible_count += cull_object_visible(
+            objects, frustum, CULL_PLANES_ALL, (uint32_t) i
+        );
+    }
+
+    return visible_count;
+}
+
+/// @param[in] mask Bit `j` is set when object `first + j` is visible
+/// @param[in] first
+/// @param[out] visible
+/// @return Number of visible objects
+static size_t cull_compact(uint32_t mask, size_t first, uint32_t *visible) {
+    size_t visible_count = 0;
+    for (size_t j = 0; j < CULL_WIDTH; j++) {
+        visible[visible_count] = (uint32_t) (first + j);
+        visible_count += (mask >> j) & 1;
+    }
+
+    return visible_count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/// Indices of the set bits of every eight bit mask, one per byte from the
+/// lowest, for `_mm256_permutevar8x32_epi32`
+static uint64_t cull_permutations[256];
+static once_flag cull_permutations_once = ONCE_FLAG_INIT;
+
+static void cull_permutations_build(void) {
+    for (uint32_t mask = 0; mask < 256; mask++) {
+        uint64_t permutation = 0;
+        uint32_t count = 0;
+        for (uint32_t j = 0; j < 8; j++) {
+            if (mask & (1u << j)) {
+                permutation |= (uint64_t) j << (8 * count);
+                count++;
+            }
+        }
+        cull_permutations[mask] = permutation;
+    }
+}
+
+/// @param[in] objects
+/// @param[in] i
+/// @param[in] planes Normal, offset and absolute normal of every plane
+/// @return Bit `j` set when object `i + j` is outside a plane
+__attribute__((target("sse2")))
+static uint32_t cull_sse2_outside(
+    const struct cull_objects *objects, size_t i, const __m128 planes[6][7]
+) {
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 center_x = _mm_load_ps(&objects->center_x[i]);
+    __m128 center_y = _mm_load_ps(&objects->center_y[i]);
+    __m128 center_z = _mm_load_ps(&objects->center_z[i]);
+    __m128 radius = _mm_load_ps(&objects->radius[i]);
+    __m128 extent_x = _mm_load_ps(&objects->extent_x[i]);
+    __m128 extent_y = _mm_load_ps(&objects->extent_y[i]);
+    __m128 extent_z = _mm_load_ps(&objects->extent_z[i]);
+
+    __m128 outside = _mm_setzero_ps();
+    for (size_t p = 0; p < 6; p++) {
+        __m128 distance = _mm_add_ps(
+            _mm_add_ps(
+                _mm_add_ps(
+                    _mm_mul_ps(planes[p][0], center_x),
+                    _mm_mul_ps(planes[p][1], center_y)
+                ),
+                _mm_mul_ps(planes[p][2], center_z)
+            ),
+            planes[p][3]
+        );
+        __m128 extent = _mm_add_ps(
+            _mm_add_ps(
+                _mm_mul_ps(planes[p][4], extent_x), _mm_mul_ps(planes[p][5], extent_y)
+            ),
+            _mm_mul_ps(planes[p][6], extent_z)
+        );
+        __m128 reach = _mm_xor_ps(_mm_min_ps(radius, extent), sign);
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, reach));
+    }
+
+    return (uint32_t) _mm_movemask_ps(outside);
+}
+
+__attribute__((target("sse2")))
+static size_t cull_sse2(
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    size_t first,
+    size_t count,
+    uint32_t *visible
+) {
+    __m128 planes[6][7];
+    for (size_t p = 0; p < 6; p++) {
+        for (size_t c = 0; c < 4; c++) {
+            planes[p][c] = _mm_set1_ps(frustum->planes[p][c]);
+        }
+        for (size_t c = 0; c < 3; c++) {
+            planes[p][4 + c] = _mm_set1_ps(fabsf(frustum->planes[p][c]));
+        }
+    }
+
+    size_t visible_count = 0;
+    for (size_t i = first; i < first + count; i += CULL_WIDTH) {
+        uint32_t outside = cull_sse2_outside(objects, i, planes) |
+            cull_sse2_outside(objects, i + 4, planes) << 4;
+        visible_count += cull_compact(~outside & 0xff, i, &visible[visible_count]);
+    }
+
+    return visible_count;
+}
+
+__attribute__((target("avx2")))
+static size_t cull_avx2(
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    size_t first,
+    size_t count,
+    uint32_t *visible
+) {
+    __m256 planes[6][7];
+    for (size_t p = 0; p < 6; p++) {
+        for (size_t c = 0; c < 4; c++) {
+            planes[p][c] = _mm256_set1_ps(frustum->planes[p][c]);
+        }
+        for (size_t c = 0; c < 3; c++) {
+            planes[p][4 + c] = _mm256_set1_ps(fabsf(frustum->planes[p][c]));
+        }
+    }
+
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t visible_count = 0;
+    for (size_t i = first; i < first + count; i += CULL_WIDTH) {
+        __m256 center_x = _mm256_load_ps(&objects->center_x[i]);
+        __m256 center_y = _mm256_load_ps(&objects->center_y[i]);
+        __m256 center_z = _mm256_load_ps(&objects->center_z[i]);
+        __m256 radius = _mm256_load_ps(&objects->radius[i]);
+        __m256 extent_x = _mm256_load_ps(&objects->extent_x[i]);
+        __m256 extent_y = _mm256_load_ps(&objects->extent_y[i]);
+        __m256 extent_z = _mm256_load_ps(&objects->extent_z[i]);
+
+        __m256 outside = _mm256_setzero_ps();
+        for (size_t p = 0; p < 6; p++) {
+            __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(
+                    _mm256_add_ps(
+                        _mm256_mul_ps(planes[p][0], center_x),
+                        _mm256_mul_ps(planes[p][1], center_y)
+                    ),
+                    _mm256_mul_ps(planes[p][2], center_z)
+                ),
+                planes[p][3]
+            );
+            __m256 extent = _mm256_add_ps(
+                _mm256_add_ps(
+                    _mm256_mul_ps(planes[p][4], extent_x),
+                    _mm256_mul_ps(planes[p][5], extent_y)
+                ),
+                _mm256_mul_ps(planes[p][6], extent_z)
+            );
+            __m256 reach = _mm256_xor_ps(_mm256_min_ps(radius, extent), sign);
+            outside = _mm256_or_ps(
+                outside, _mm256_cmp_ps(distance, reach, _CMP_LT_OQ)
+            );
+        }
+
+        uint32_t mask = ~(uint32_t) _mm256_movemask_ps(outside) & 0xff;
+        __m256i permutation = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((const __m128i *) &cull_permutations[mask])
+        );
+        __m256i indices = _mm256_add_epi32(
+            _mm256_set1_epi32((int) i), _mm256_permutevar8x32_epi32(lanes, permutation)
+        );
+        _mm256_storeu_si256((__m256i *) &visible[visible_count], indices);
+        visible_count += (size_t) __builtin_popcount(mask);
+    }
+
+    return visible_count;
+}
+
+#endif
+
+#if defined(__aarch64__)
+
+/// @param[in] objects
+/// @param[in] i
+/// @param[in] planes Normal, offset and absolute normal of every plane
+/// @return Bit `j` set when object `i + j` is outside a plane
+static uint32_t cull_neon_outside(
+    const struct cull_objects *objects, size_t i, const float32x4_t planes[6][7]
+) {
+    float32x4_t center_x = vld1q_f32(&objects->center_x[i]);
+    float32x4_t center_y = vld1q_f32(&objects->center_y[i]);
+    float32x4_t center_z = vld1q_f32(&objects->center_z[i]);
+    float32x4_t radius = vld1q_f32(&objects->radius[i]);
+    float32x4_t extent_x = vld1q_f32(&objects->extent_x[i]);
+    float32x4_t extent_y = vld1q_f32(&objects->extent_y[i]);
+    float32x4_t extent_z = vld1q_f32(&objects->extent_z[i]);
+
+    uint32x4_t outside = vdupq_n_u32(0);
+    for (size_t p = 0; p < 6; p++) {
+        float32x4_t distance = vaddq_f32(
+            vaddq_f32(
+                vaddq_f32(
+                    vmulq_f32(planes[p][0], center_x), vmulq_f32(planes[p][1], center_y)
+                ),
+                vmulq_f32(planes[p][2], center_z)
+            ),
+            planes[p][3]
+        );
+        float32x4_t extent = vaddq_f32(
+            vaddq_f32(
+                vmulq_f32(planes[p][4], extent_x), vmulq_f32(planes[p][5], extent_y)
+            ),
+            vmulq_f32(planes[p][6], extent_z)
+        );
+        float32x4_t reach = vnegq_f32(vminq_f32(radius, extent));
+        outside = vorrq_u32(outside, vcltq_f32(distance, reach));
+    }
+
+    const uint32x4_t bits = {1, 2, 4, 8};
+    return vaddvq_u32(vandq_u32(outside, bits));
+}
+
+static size_t cull_neon(
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    size_t first,
+    size_t count,
+    uint32_t *visible
+) {
+    float32x4_t planes[6][7];
+    for (size_t p = 0; p < 6; p++) {
+        for (size_t c = 0; c < 4; c++) {
+            planes[p][c] = vdupq_n_f32(frustum->planes[p][c]);
+        }
+        for (size_t c = 0; c < 3; c++) {
+            planes[p][4 + c] = vdupq_n_f32(fabsf(frustum->planes[p][c]));
+        }
+    }
+
+    size_t visible_count = 0;
+    for (size_t i = first; i < first + count; i += CULL_WIDTH) {
+        uint32_t outside = cull_neon_outside(objects, i, planes) |
+            cull_neon_outside(objects, i + 4, planes) << 4;
+        visible_count += cull_compact(~outside & 0xff, i, &visible[visible_count]);
+    }
+
+    return visible_count;
+}
+
+#endif
+
+bool cull_kernel_supported(enum cull_kernel kernel) {
+    switch (kernel) {
+    case CULL_KERNEL_SCALAR:
+        return true;
+#if defined(__x86_64__) || defined(__i386__)
+    case CULL_KERNEL_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case CULL_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__aarch64__)
+    case CULL_KERNEL_NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+enum cull_kernel cull_kernel_best(void) {
+    const enum cull_kernel kernels[] = {
+        CULL_KERNEL_AVX2, CULL_KERNEL_NEON, CULL_KERNEL_SSE2
+    };
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        if (cull_kernel_supported(kernels[i])) {
+            return kernels[i];
+        }
+    }
+
+    return CULL_KERNEL_SCALAR;
+}
+
+const char *cull_kernel_name(enum cull_kernel kernel) {
+    switch (kernel) {
+    case CULL_KERNEL_SCALAR:
+        return "scalar";
+    case CULL_KERNEL_SSE2:
+        return "sse2";
+    case CULL_KERNEL_AVX2:
+        return "avx2";
+    case CULL_KERNEL_NEON:
+        return "neon";
+    default:
+        return "unknown";
+    }
+}
+
+/// @param[in] kernel Supported
+/// @return Function testing objects with `kernel`
+static cull_function cull_function_get(enum cull_kernel kernel) {
+    switch (kernel) {
+#if defined(__x86_64__) || defined(__i386__)
+    case CULL_KERNEL_SSE2:
+        return cull_sse2;
+    case CULL_KERNEL_AVX2:
+        call_once(&cull_permutations_once, cull_permutations_build);
+        return cull_avx2;
+#endif
+#if defined(__aarch64__)
+    case CULL_KERNEL_NEON:
+        return cull_neon;
+#endif
+    default:
+        return cull_scalar;
+    }
+}
+
+void cull_objects_destroy(struct cull_objects *objects) {
+    free(objects->center_x);
+}
+
+/// Moves every component into one new allocation of `capacity` floats each,
+/// aligned for the loads of the widest kernel
+/// @param[in,out] objects
+/// @param[in] capacity Multiple of `CULL_WIDTH`
+/// @return `true` on success and `false` otherwise
+static bool cull_objects_grow(struct cull_objects *objects, size_t capacity) {
+    float *data = aligned_alloc(32, sizeof(float) * CULL_COMPONENTS * capacity);
+    if (data == nullptr) {
+        fprintf(stderr, "cull_objects_grow: aligned_alloc failed\n");
+        return false;
+    }
+
+    float *components[CULL_COMPONENTS] = {
+        objects->center_x,
+        objects->center_y,
+        objects->center_z,
+        objects->radius,
+        objects->extent_x,
+        objects->extent_y,
+        objects->extent_z,
+    };
+    for (size_t c = 0; c < CULL_COMPONENTS; c++) {
+        float *component = data + c * capacity;
+        if (objects->count > 0) {
+            memcpy(component, components[c], sizeof(float) * objects->count);
+        }
+        // A radius of negative infinity is outside every plane, the rest zero
+        float padding = c == 3 ? -INFINITY : 0.0f;
+        for (size_t i = objects->count; i < capacity; i++) {
+            component[i] = padding;
+        }
+        components[c] = component;
+    }
+    free(objects->center_x);
+
+    objects->center_x = components[0];
+    objects->center_y = components[1];
+    objects->center_z = components[2];
+    objects->radius = components[3];
+    objects->extent_x = components[4];
+    objects->extent_y = components[5];
+    objects->extent_z = components[6];
+    objects->capacity = capacity;
+
+    return true;
+}
+
+bool cull_objects_add(
+    struct cull_objects *objects,
+    const float center[3],
+    float radius,
+    const float extent[3],
+    uint32_t *index
+) {
+    if (objects->count == UINT32_MAX) {
+        fprintf(stderr, "cull_objects_add: too many objects\n");
+        return false;
+    }
+    if (
+        objects->count == objects->capacity &&
+        !cull_objects_grow(objects, objects->capacity * 2 + CULL_WIDTH)
+    ) {
+        return false;
+    }
+
+    *index = (uint32_t) objects->count;
+    objects->count++;
+    cull_objects_set(objects, *index, center, radius, extent);
+
+    return true;
+}
+
+void cull_objects_set(
+    struct cull_objects *objects,
+    uint32_t index,
+    const float center[3],
+    float radius,
+    const float extent[3]
+) {
+    objects->center_x[index] = center[0];
+    objects->center_y[index] = center[1];
+    objects->center_z[index] = center[2];
+    objects->radius[index] = radius;
+    objects->extent_x[index] = extent[0];
+    objects->extent_y[index] = extent[1];
+    objects->extent_z[index] = extent[2];
+}
+
+void cull_frustum_extract(
+    const float view_projection[16], struct cull_frustum *frustum
+) {
+    // Rows of the matrix, clip space keeps -w <= x, y <= w and 0 <= z <= w
+    float rows[4][4];
+    for (size_t row = 0; row < 4; row++) {
+        for (size_t column = 0; column < 4; column++) {
+            rows[row][column] = view_projection[4 * column + row];
+        }
+    }
+
+    for (size_t c = 0; c < 4; c++) {
+        frustum->planes[0][c] = rows[3][c] + rows[0][c];
+        frustum->planes[1][c] = rows[3][c] - rows[0][c];
+        frustum->planes[2][c] = rows[3][c] + rows[1][c];
+        frustum->planes[3][c] = rows[3][c] - rows[1][c];
+        frustum->planes[4][c] = rows[2][c];
+        frustum->planes[5][c] = rows[3][c] - rows[2][c];
+    }
+
+    for (size_t p = 0; p < 6; p++) {
+        float *plane = frustum->planes[p];
+        float length = sqrtf(
+            plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]
+        );
+        if (length > 0.0f) {
+            for (size_t c = 0; c < 4; c++) {
+                plane[c] /= length;
+            }
+        }
+    }
+}
+
+/// Range of objects one job tests
+struct cull_range {
+    cull_function function;
+    const struct cull_objects *objects;
+    const struct cull_frustum *frustum;
+    size_t first;
+    size_t count;
+    /// Entries from `first` on
+    uint32_t *visible;
+    size_t visible_count;
+};
+
+/// @param[in,out] argument `struct cull_range`
+static void cull_range_test(void *argument) {
+    struct cull_range *range = argument;
+    range->visible_count = range->function(
+        range->objects, range->frustum, range->first, range->count, range->visible
+    );
+}
+
+bool cull_objects_test(
+    struct jobs *jobs,
+    enum cull_kernel kernel,
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    uint32_t *visible,
+    size_t *visible_count
+) {
+    *visible_count = 0;
+    if (objects->count == 0) {
+        return true;
+    }
+
+    cull_function function = cull_function_get(kernel);
+    size_t count = (objects->count + CULL_WIDTH - 1) / CULL_WIDTH * CULL_WIDTH;
+    if (jobs == nullptr || count <= CULL_JOB_OBJECTS) {
+        *visible_count = function(objects, frustum, 0, count, visible);
+        return true;
+    }
+
+    size_t jobs_count = (count + CULL_JOB_OBJECTS - 1) / CULL_JOB_OBJECTS;
+    struct cull_range *ranges = malloc(sizeof(ranges[0]) * jobs_count);
+    if (ranges == nullptr) {
+        fprintf(stderr, "cull_objects_test: malloc failed\n");
+        return false;
+    }
+
+    struct jobs_counter counter = {};
+    for (size_t i = 0; i < jobs_count; i++) {
+        size_t first = i * CULL_JOB_OBJECTS;
+        ranges[i] = (struct cull_range){
+            .function = function,
+            .objects = objects,
+            .frustum = frustum,
+            .first = first,
+            .count = count - first < CULL_JOB_OBJECTS ? count - first : CULL_JOB_OBJECTS,
+            .visible = &visible[first],
+        };
+        if (!jobs_submit(jobs, cull_range_test, &ranges[i], &counter)) {
+            cull_range_test(&ranges[i]);
+        }
+    }
+    jobs_counter_wait(jobs, &counter);
+
+    // Every range wrote from its own first object on, close the gaps between
+    for (size_t i = 0; i < jobs_count; i++) {
+        memmove(
+            &visible[*visible_count],
+            ranges[i].visible,
+            sizeof(visible[0]) * ranges[i].visible_count
+        );
+        *visible_count += ranges[i].visible_count;
+    }
+    free(ranges);
+
+    return true;
+}
@@ -0,0 +1,133 @@
+#ifndef CULL_H
+#define CULL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "jobs.h"
+
+/// Objects every kernel tests per iteration, arrays are padded to a multiple
+/// of it so that no kernel has a remainder loop
+constexpr size_t CULL_WIDTH = 8;
+
+/// Instruction sets objects can be tested with
+enum cull_kernel {
+    CULL_KERNEL_SCALAR,
+    /// Two times four objects, SSE2 is part of every x86-64 processor
+    CULL_KERNEL_SSE2,
+    /// Eight objects, with the visible ones compacted by a permutation
+    CULL_KERNEL_AVX2,
+    /// Two times four objects, NEON is part of every AArch64 processor
+    CULL_KERNEL_NEON,
+    CULL_KERNELS_COUNT,
+};
+
+/// Mask of every plane of a frustum
+constexpr uint32_t CULL_PLANES_ALL = 0x3f;
+
+/// Six planes `a * x + b * y + c * z + d` of unit normals pointing inwards,
+/// left, right, bottom, top, near and far
+struct cull_frustum {
+    float planes[6][4];
+};
+
+/// Bounds of objects stored as one array per component, so that kernels load
+/// the same component of `CULL_WIDTH` objects at once. Each object has a
+/// sphere and an axis aligned box around the same center, and is culled when
+/// either of them is outside a plane.
+struct cull_objects {
+    float *center_x;
+    float *center_y;
+    float *center_z;
+    float *radius;
+    /// Half the size of the box along each axis
+    float *extent_x;
+    float *extent_y;
+    float *extent_z;
+    size_t count;
+    /// Multiple of `CULL_WIDTH`, entries past `count` are never visible
+    size_t capacity;
+};
+
+/// @param[in,out] objects
+/// @note `objects` will be invalid after this function has been called
+void cull_objects_destroy(struct cull_objects *objects);
+
+/// @param[in,out] objects Zero-initialized before the first object
+/// @param[in] center
+/// @param[in] radius
+/// @param[in] extent Half the size of the box along each axis
+/// @param[out] index Of the object, as it is written to visible lists
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `cull_objects_destroy` after
+/// successful return
+bool cull_objects_add(
+    struct cull_objects *objects,
+    const float center[3],
+    float radius,
+    const float extent[3],
+    uint32_t *index
+);
+
+/// Moves an object
+/// @param[in,out] objects
+/// @param[in] index
+/// @param[in] center
+/// @param[in] radius
+/// @param[in] extent
+void cull_objects_set(
+    struct cull_objects *objects,
+    uint32_t index,
+    const float center[3],
+    float radius,
+    const float extent[3]
+);
+
+/// @param[in] view_projection Column major, with depth from zero to one
+/// @param[out] frustum
+void cull_frustum_extract(const float view_projection[16], struct cull_frustum *frustum);
+
+/// Tests one object the way every kernel does
+/// @param[in] objects
+/// @param[in] frustum
+/// @param[in] planes Bit `p` set to test plane `p`, e.g. `CULL_PLANES_ALL`
+/// @param[in] index
+/// @return Whether the object is inside every plane tested
+bool cull_object_visible(
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    uint32_t planes,
+    uint32_t index
+);
+
+/// @param[in] kernel
+/// @return Whether the processor can run `kernel`
+bool cull_kernel_supported(enum cull_kernel kernel);
+
+/// @return Fastest kernel the processor runs
+enum cull_kernel cull_kernel_best(void);
+
+/// @param[in] kernel
+/// @return Name of the instruction set of `kernel`, e.g. "avx2"
+const char *cull_kernel_name(enum cull_kernel kernel);
+
+/// Tests every object against every plane of `frustum`. Ranges of objects are
+/// tested in parallel when there are many.
+/// @param[in,out] jobs May be `nullptr`
+/// @param[in] kernel Must be supported
+/// @param[in] objects
+/// @param[in] frustum
+/// @param[out] visible `objects->capacity` entries, of which the first
+/// `visible_count` are the indices of the visible objects in ascending order
+/// @param[out] visible_count
+/// @return `true` on success and `false` otherwise
+bool cull_objects_test(
+    struct jobs *jobs,
+    enum cull_kernel kernel,
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    uint32_t *visible,
+    size_t *visible_count
+);
+
+#endif
@@ -0,0 +1,626 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debugdraw.h"
+#include "spirv.h"
+
+#ifndef NDEBUG
+
+/// Vertex inputs of `shaders/debug_vertex.glsl`
+enum debugdraw_input {
+    DEBUGDRAW_INPUT_POSITION,
+    DEBUGDRAW_INPUT_COLOR,
+    DEBUGDRAW_INPUTS_COUNT,
+};
+
+/// Segments of each circle of a sphere
+constexpr size_t DEBUGDRAW_SPHERE_SEGMENTS = 16;
+constexpr float DEBUGDRAW_TAU = 6.28318530718f;
+
+/// Handed out to every debug draw in turn, zero is never used
+static atomic_uint_fast64_t debugdraw_next_id = 1;
+
+/// Buffer the calling thread appended to last, and the id of its debug draw
+static thread_local struct debugdraw_buffer *debugdraw_thread_buffer;
+static thread_local uint64_t debugdraw_thread_id;
+
+/// @param[in,out] debugdraw
+/// @param[in] vertex_code
+/// @param[in] vertex_code_size
+/// @param[in] fragment_code
+/// @param[in] fragment_code_size
+/// @param[in,out] layoutcache
+/// @return `true` on success and `false` otherwise
+static bool debugdraw_layout_create(
+    struct debugdraw *debugdraw,
+    const uint8_t *vertex_code,
+    size_t vertex_code_size,
+    const uint8_t *fragment_code,
+    size_t fragment_code_size,
+    struct layoutcache *layoutcache
+) {
+    struct spirv_reflection vertex_reflection;
+    struct spirv_reflection fragment_reflection;
+    if (
+        !spirv_reflect(vertex_code, vertex_code_size, &vertex_reflection) ||
+        !spirv_reflect(fragment_code, fragment_code_size, &fragment_reflection)
+    ) {
+        fprintf(stderr, "debugdraw_layout_create: spirv_reflect failed\n");
+        return false;
+    }
+
+    struct spirv_reflection reflection = {};
+    if (
+        !spirv_reflection_merge(&reflection, &vertex_reflection) ||
+        !spirv_reflection_merge(&reflection, &fragment_reflection)
+    ) {
+        fprintf(stderr, "debugdraw_layout_create: spirv_reflection_merge failed\n");
+        return false;
+    }
+    if (
+        reflection.bindings_count != 0 ||
+        reflection.inputs_count != DEBUGDRAW_INPUTS_COUNT ||
+        reflection.push_constants.size != 16 * sizeof(float)
+    ) {
+        fprintf(stderr, "debugdraw_layout_create: unexpected shader interface\n");
+        return false;
+    }
+
+    // Without descriptors the layout is the same whatever flags the cache
+    // creates set layouts with
+    if (!layoutcache_pipelinelayout_get(
+        layoutcache, &reflection, &debugdraw->layout, nullptr, nullptr
+    )) {
+        fprintf(
+            stderr, "debugdraw_layout_create: layoutcache_pipelinelayout_get failed\n"
+        );
+        return false;
+    }
+
+    VkShaderModuleCreateInfo vertex_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pCode = (const uint32_t *) vertex_code,
+        .codeSize = vertex_code_size,
+    };
+    if (vkCreateShaderModule(
+        debugdraw->device, &vertex_info, nullptr, &debugdraw->vertex_shadermodule
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "debugdraw_layout_create: vkCreateShaderModule failed\n");
+        return false;
+    }
+
+    VkShaderModuleCreateInfo fragment_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pCode = (const uint32_t *) fragment_code,
+        .codeSize = fragment_code_size,
+    };
+    if (vkCreateShaderModule(
+        debugdraw->device, &fragment_info, nullptr, &debugdraw->fragment_shadermodule
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "debugdraw_layout_create: vkCreateShaderModule failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] debugdraw
+/// @param[in] render_pass
+/// @return `true` on success and `false` otherwise
+static bool debugdraw_pipeline_create(
+    struct debugdraw *debugdraw, VkRenderPass render_pass
+) {
+    VkPipelineShaderStageCreateInfo stages[] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = debugdraw->vertex_shadermodule,
+            .pName = "main",
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = debugdraw->fragment_shadermodule,
+            .pName = "main",
+        },
+    };
+
+    VkVertexInputBindingDescription binding = {
+        .binding = 0,
+        .stride = sizeof(struct debugdraw_vertex),
+        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+    };
+    VkVertexInputAttributeDescription attributes[DEBUGDRAW_INPUTS_COUNT] = {
+        [DEBUGDRAW_INPUT_POSITION] = {
+            .location = DEBUGDRAW_INPUT_POSITION,
+            .format = VK_FORMAT_R32G32B32_SFLOAT,
+            .offset = offsetof(struct debugdraw_vertex, position),
+        },
+        [DEBUGDRAW_INPUT_COLOR] = {
+            .location = DEBUGDRAW_INPUT_COLOR,
+            .format = VK_FORMAT_R8G8B8A8_UNORM,
+            .offset = offsetof(struct debugdraw_vertex, color),
+        },
+    };
+    VkPipelineVertexInputStateCreateInfo vertex_input = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .pVertexBindingDescriptions = &binding,
+        .vertexBindingDescriptionCount = 1,
+        .pVertexAttributeDescriptions = attributes,
+        .vertexAttributeDescriptionCount = DEBUGDRAW_INPUTS_COUNT,
+    };
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST,
+    };
+    VkPipelineViewportStateCreateInfo viewport = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+    VkPipelineRasterizationStateCreateInfo rasterization = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = VK_CULL_MODE_NONE,
+        .frontFace = VK_FRONT_FACE_CLOCKWISE,
+        .lineWidth = 1.0f,
+    };
+    VkPipelineMultisampleStateCreateInfo multisample = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .minSampleShading = 1.0f,
+    };
+
+    VkDynamicState dynamic_states[] = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+    };
+    VkPipelineDynamicStateCreateInfo dynamic_state = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .pDynamicStates = dynamic_states,
+        .dynamicStateCount = sizeof(dynamic_states) / sizeof(dynamic_states[0]),
+    };
+
+    VkPipelineColorBlendAttachmentState blend_attachment = {
+        .colorWriteMask = (
+            VK_COLOR_COMPONENT_R_BIT |
+            VK_COLOR_COMPONENT_G_BIT |
+            VK_COLOR_COMPONENT_B_BIT |
+            VK_COLOR_COMPONENT_A_BIT
+        ),
+        .blendEnable = VK_TRUE,
+        .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+        .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+        .colorBlendOp = VK_BLEND_OP_ADD,
+        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+        .alphaBlendOp = VK_BLEND_OP_ADD,
+    };
+    VkPipelineColorBlendStateCreateInfo color_blend = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .pAttachments = &blend_attachment,
+        .attachmentCount = 1,
+    };
+
+    VkGraphicsPipelineCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pStages = stages,
+        .stageCount = sizeof(stages) / sizeof(stages[0]),
+        .pVertexInputState = &vertex_input,
+        .pInputAssemblyState = &input_assembly,
+        .pViewportState = &viewport,
+        .pRasterizationState = &rasterization,
+        .pMultisampleState = &multisample,
+        .pColorBlendState = &color_blend,
+        .pDynamicState = &dynamic_state,
+        .layout = debugdraw->layout,
+        .renderPass = render_pass,
+        .subpass = 0,
+        .basePipelineIndex = -1,
+    };
+
+    if (vkCreateGraphicsPipelines(
+        debugdraw->device, VK_NULL_HANDLE, 1, &create_info, nullptr, &debugdraw->pipeline
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "debugdraw_pipeline_create: vkCreateGraphicsPipelines failed\n");
+        debugdraw->pipeline = VK_NULL_HANDLE;
+        return false;
+    }
+
+    return true;
+}
+
+bool debugdraw_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    VkRenderPass render_pass,
+    struct layoutcache *layoutcache,
+    const uint8_t *vertex_code,
+    size_t vertex_code_size,
+    const uint8_t *fragment_code,
+    size_t fragment_code_size,
+    size_t capacity,
+    uint32_t frames_count,
+    struct debugdraw *debugdraw
+) {
+    *debugdraw = (struct debugdraw){
+        .device = device,
+        .capacity = capacity,
+        .frames_count = frames_count,
+        .id = atomic_fetch_add(&debugdraw_next_id, 1),
+    };
+
+    if (!debugdraw_layout_create(
+        debugdraw,
+        vertex_code,
+        vertex_code_size,
+        fragment_code,
+        fragment_code_size,
+        layoutcache
+    )) {
+        fprintf(stderr, "debugdraw_create: debugdraw_layout_create failed\n");
+        goto cleanup;
+    }
+
+    if (!debugdraw_pipeline_create(debugdraw, render_pass)) {
+        fprintf(stderr, "debugdraw_create: debugdraw_pipeline_create failed\n");
+        goto cleanup;
+    }
+
+    if (!buffer_create(
+        device,
+        memory_properties,
+        sizeof(struct debugdraw_vertex) * capacity * frames_count,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &debugdraw->ring
+    )) {
+        fprintf(stderr, "debugdraw_create: buffer_create failed\n");
+        goto cleanup;
+    }
+
+    return true;
+
+cleanup:
+    debugdraw_destroy(debugdraw);
+
+    return false;
+}
+
+void debugdraw_destroy(struct debugdraw *debugdraw) {
+    struct debugdraw_buffer *buffer = atomic_load(&debugdraw->buffers);
+    while (buffer != nullptr) {
+        struct debugdraw_buffer *next = buffer->next;
+        free(buffer->vertices[0]);
+        free(buffer->vertices[1]);
+        free(buffer);
+        buffer = next;
+    }
+
+    buffer_destroy(debugdraw->device, &debugdraw->ring);
+    vkDestroyPipeline(debugdraw->device, debugdraw->pipeline, nullptr);
+    vkDestroyShaderModule(debugdraw->device, debugdraw->fragment_shadermodule, nullptr);
+    vkDestroyShaderModule(debugdraw->device, debugdraw->vertex_shadermodule, nullptr);
+
+    *debugdraw = (struct debugdraw){};
+}
+
+/// @param[in,out] debugdraw
+/// @return Buffer of the calling thread, `nullptr` when memory runs out
+static struct debugdraw_buffer *debugdraw_buffer_get(struct debugdraw *debugdraw) {
+    if (debugdraw_thread_id == debugdraw->id) {
+        return debugdraw_thread_buffer;
+    }
+
+    // Only threads that switch between debug draws get here more than once
+    thrd_t thread = thrd_current();
+    struct debugdraw_buffer *buffer = atomic_load_explicit(
+        &debugdraw->buffers, memory_order_acquire
+    );
+    while (buffer != nullptr && !thrd_equal(buffer->thread, thread)) {
+        buffer = buffer->next;
+    }
+
+    if (buffer == nullptr) {
+        buffer = malloc(sizeof(*buffer));
+        if (buffer == nullptr) {
+            fprintf(stderr, "debugdraw_buffer_get: malloc failed\n");
+            return nullptr;
+        }
+        *buffer = (struct debugdraw_buffer){
+            .thread = thread,
+            .next = atomic_load_explicit(&debugdraw->buffers, memory_order_relaxed),
+        };
+        while (!atomic_compare_exchange_weak_explicit(
+            &debugdraw->buffers,
+            &buffer->next,
+            buffer,
+            memory_order_release,
+            memory_order_relaxed
+        )) {
+        }
+    }
+
+    debugdraw_thread_buffer = buffer;
+    debugdraw_thread_id = debugdraw->id;
+
+    return buffer;
+}
+
+/// @param[in,out] debugdraw
+/// @param[in] count
+/// @param[out] buffer Of the calling thread, appending until
+/// `debugdraw_vertices_commit` when room was made
+/// @return Room for `count` vertices in the buffer of the calling thread,
+/// `nullptr` when memory runs out
+static struct debugdraw_vertex *debugdraw_vertices_append(
+    struct debugdraw *debugdraw, size_t count, struct debugdraw_buffer **buffer
+) {
+    *buffer = debugdraw_buffer_get(debugdraw);
+    if (*buffer == nullptr) {
+        return nullptr;
+    }
+    struct debugdraw_buffer *thread_buffer = *buffer;
+
+    // Announces the side before checking it is still current. Either the
+    // flip in `debugdraw_record` sees the announcement and waits for the
+    // commit, or this sees the flip and moves to the other side.
+    uint32_t side = atomic_load_explicit(&debugdraw->side, memory_order_acquire);
+    for (;;) {
+        atomic_store(&thread_buffer->appending, side + 1);
+        uint32_t current = atomic_load(&debugdraw->side);
+        if (current == side) {
+            break;
+        }
+        side = current;
+    }
+
+    if (
+        thread_buffer->vertices_count[side] + count >
+        thread_buffer->vertices_capacity[side]
+    ) {
+        size_t capacity = thread_buffer->vertices_capacity[side] * 2 + count;
+        struct debugdraw_vertex *vertices = realloc(
+            thread_buffer->vertices[side], sizeof(vertices[0]) * capacity
+        );
+        if (vertices == nullptr) {
+            fprintf(stderr, "debugdraw_vertices_append: realloc failed\n");
+            atomic_store_explicit(&thread_buffer->appending, 0, memory_order_release);
+            return nullptr;
+        }
+        thread_buffer->vertices[side] = vertices;
+        thread_buffer->vertices_capacity[side] = capacity;
+    }
+
+    struct debugdraw_vertex *vertices = (
+        &thread_buffer->vertices[side][thread_buffer->vertices_count[side]]
+    );
+    thread_buffer->vertices_count[side] += count;
+
+    return vertices;
+}
+
+/// Publishes the vertices appended last to `debugdraw_record`
+/// @param[in,out] buffer
+static void debugdraw_vertices_commit(struct debugdraw_buffer *buffer) {
+    atomic_store_explicit(&buffer->appending, 0, memory_order_release);
+}
+
+/// @param[out] vertices Two vertices
+/// @param[in] from
+/// @param[in] to
+/// @param[in] color
+static void debugdraw_segment(
+    struct debugdraw_vertex *vertices,
+    const float from[3],
+    const float to[3],
+    uint32_t color
+) {
+    vertices[0] = (struct debugdraw_vertex){
+        .position = {from[0], from[1], from[2]},
+        .color = color,
+    };
+    vertices[1] = (struct debugdraw_vertex){
+        .position = {to[0], to[1], to[2]},
+        .color = color,
+    };
+}
+
+void debugdraw_line(
+    struct debugdraw *debugdraw, const float from[3], const float to[3], uint32_t color
+) {
+    struct debugdraw_buffer *buffer;
+    struct debugdraw_vertex *vertices = debugdraw_vertices_append(debugdraw, 2, &buffer);
+    if (vertices == nullptr) {
+        return;
+    }
+
+    debugdraw_segment(vertices, from, to, color);
+    debugdraw_vertices_commit(buffer);
+}
+
+/// Corners are numbered by bits, the lowest for x
+/// @param[in,out] debugdraw
+/// @param[in] corners
+/// @param[in] color
+static void debugdraw_corners(
+    struct debugdraw *debugdraw, const float corners[8][3], uint32_t color
+) {
+    struct debugdraw_buffer *buffer;
+    struct debugdraw_vertex *vertices = debugdraw_vertices_append(
+        debugdraw, 24, &buffer
+    );
+    if (vertices == nullptr) {
+        return;
+    }
+
+    // Every edge joins two corners that differ in one bit
+    size_t edges_count = 0;
+    for (size_t i = 0; i < 8; i++) {
+        for (size_t bit = 1; bit < 8; bit <<= 1) {
+            if ((i & bit) == 0) {
+                debugdraw_segment(
+                    &vertices[2 * edges_count++], corners[i], corners[i | bit], color
+                );
+            }
+        }
+    }
+    debugdraw_vertices_commit(buffer);
+}
+
+void debugdraw_box(
+    struct debugdraw *debugdraw, const float min[3], const float max[3], uint32_t color
+) {
+    float corners[8][3];
+    for (size_t i = 0; i < 8; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            corners[i][j] = (i >> j) & 1 ? max[j] : min[j];
+        }
+    }
+
+    debugdraw_corners(debugdraw, corners, color);
+}
+
+void debugdraw_sphere(
+    struct debugdraw *debugdraw, const float center[3], float radius, uint32_t color
+) {
+    struct debugdraw_buffer *buffer;
+    struct debugdraw_vertex *vertices = debugdraw_vertices_append(
+        debugdraw, 3 * 2 * DEBUGDRAW_SPHERE_SEGMENTS, &buffer
+    );
+    if (vertices == nullptr) {
+        return;
+    }
+
+    for (size_t axis = 0; axis < 3; axis++) {
+        size_t u = (axis + 1) % 3;
+        size_t v = (axis + 2) % 3;
+        for (size_t i = 0; i < DEBUGDRAW_SPHERE_SEGMENTS; i++) {
+            float angles[2] = {
+                DEBUGDRAW_TAU * (float) i / DEBUGDRAW_SPHERE_SEGMENTS,
+                DEBUGDRAW_TAU * (float) (i + 1) / DEBUGDRAW_SPHERE_SEGMENTS,
+            };
+            float points[2][3];
+            for (size_t j = 0; j < 2; j++) {
+                points[j][axis] = center[axis];
+                points[j][u] = center[u] + radius * cosf(angles[j]);
+                points[j][v] = center[v] + radius * sinf(angles[j]);
+            }
+            debugdraw_segment(vertices, points[0], points[1], color);
+            vertices += 2;
+        }
+    }
+    debugdraw_vertices_commit(buffer);
+}
+
+void debugdraw_frustum(
+    struct debugdraw *debugdraw, const float inverse_view_projection[16], uint32_t color
+) {
+    const float *m = inverse_view_projection;
+
+    float corners[8][3];
+    for (size_t i = 0; i < 8; i++) {
+        float clip[4] = {
+            i & 1 ? 1.0f : -1.0f,
+            i & 2 ? 1.0f : -1.0f,
+            i & 4 ? 1.0f : 0.0f,
+            1.0f,
+        };
+        float position[4];
+        for (size_t row = 0; row < 4; row++) {
+            position[row] = (
+                m[row] * clip[0] +
+                m[4 + row] * clip[1] +
+                m[8 + row] * clip[2] +
+                m[12 + row] * clip[3]
+            );
+        }
+        for (size_t j = 0; j < 3; j++) {
+            corners[i][j] = position[j] / position[3];
+        }
+    }
+
+    debugdraw_corners(debugdraw, corners, color);
+}
+
+void debugdraw_record(
+    struct debugdraw *debugdraw,
+    VkCommandBuffer command_buffer,
+    VkExtent2D extent,
+    const float view_projection[16]
+) {
+    VkDeviceSize ring_offset = (
+        sizeof(struct debugdraw_vertex) * debugdraw->capacity * debugdraw->frame
+    );
+    struct debugdraw_vertex *ring = (struct debugdraw_vertex *) (
+        (uint8_t *) debugdraw->ring.mapped + ring_offset
+    );
+
+    // Whole lines only, what does not fit is dropped
+    size_t count = 0;
+    size_t dropped_count = 0;
+    // Threads go on appending into the arrays emptied the frame before
+    uint32_t side = atomic_load_explicit(&debugdraw->side, memory_order_relaxed);
+    atomic_store(&debugdraw->side, side ^ 1);
+
+    struct debugdraw_buffer *buffer = atomic_load_explicit(
+        &debugdraw->buffers, memory_order_acquire
+    );
+    for (; buffer != nullptr; buffer = buffer->next) {
+        // Only an append that started before the flip can still be writing
+        while (atomic_load_explicit(
+            &buffer->appending, memory_order_acquire
+        ) == side + 1) {
+            thrd_yield();
+        }
+
+        size_t recorded_count = buffer->vertices_count[side];
+        size_t copied = recorded_count;
+        if (copied > debugdraw->capacity - count) {
+            copied = (debugdraw->capacity - count) & ~(size_t) 1;
+        }
+        memcpy(&ring[count], buffer->vertices[side], sizeof(ring[0]) * copied);
+        count += copied;
+        dropped_count += recorded_count - copied;
+        buffer->vertices_count[side] = 0;
+    }
+    debugdraw->vertices_count = count;
+    debugdraw->dropped_count = dropped_count;
+
+    if (count == 0) {
+        return;
+    }
+
+    VkViewport viewport = {
+        .width = (float) extent.width,
+        .height = (float) extent.height,
+        .maxDepth = 1.0f,
+    };
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    VkRect2D scissor = {
+        .extent = extent,
+    };
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+    vkCmdBindPipeline(
+        command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, debugdraw->pipeline
+    );
+    vkCmdPushConstants(
+        command_buffer,
+        debugdraw->layout,
+        VK_SHADER_STAGE_VERTEX_BIT,
+        0,
+        16 * sizeof(float),
+        view_projection
+    );
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &debugdraw->ring.buffer, &ring_offset);
+    vkCmdDraw(command_buffer, (uint32_t) count, 1, 0, 0);
+
+    debugdraw->frame = (debugdraw->frame + 1) % debugdraw->frames_count;
+}
+
+#endif
@@ -0,0 +1,244 @@
+#ifndef DEBUGDRAW_H
+#define DEBUGDRAW_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <threads.h>
+
+#include <vulkan/vulkan.h>
+
+#include "buffer.h"
+#include "layoutcache.h"
+
+/// Whether debug geometry is drawn at all, every function below does nothing
+/// when `NDEBUG` is defined as it is for release builds
+#ifdef NDEBUG
+constexpr bool DEBUGDRAW_ENABLED = false;
+#else
+constexpr bool DEBUGDRAW_ENABLED = true;
+#endif
+
+/// Vertex of `shaders/debug_vertex.glsl`
+struct debugdraw_vertex {
+    float position[3];
+    /// `VK_FORMAT_R8G8B8A8_UNORM`
+    uint32_t color;
+};
+
+/// Lines one thread appended, in two arrays. The thread appends to the one
+/// `debugdraw::side` picks, while `debugdraw_record` copies and empties the
+/// other, so neither ever touches an array the other may be reallocating.
+struct debugdraw_buffer {
+    thrd_t thread;
+    struct debugdraw_vertex *vertices[2];
+    size_t vertices_count[2];
+    size_t vertices_capacity[2];
+    /// One more than the array the thread is appending to, zero between
+    /// appends. Storing zero publishes the vertices appended.
+    _Atomic uint32_t appending;
+    struct debugdraw_buffer *next;
+};
+
+/// Immediate mode lines for debugging, appended from any thread and drawn with
+/// the next frame. Every thread appends into a buffer of its own without
+/// locking, and buffers are added to a list with a compare and swap the first
+/// time a thread appends. `debugdraw_record` flips `side`, waits out appends
+/// that started before the flip, merges the arrays the threads left into a
+/// persistently mapped ring and draws all of them with one line list draw.
+struct debugdraw {
+    VkDevice device;
+
+    VkShaderModule vertex_shadermodule;
+    VkShaderModule fragment_shadermodule;
+    /// Owned by the layout cache
+    VkPipelineLayout layout;
+    VkPipeline pipeline;
+
+    /// `capacity` vertices for each of `frames_count` frames
+    struct buffer ring;
+    size_t capacity;
+    uint32_t frames_count;
+    /// Part of `ring` the next frame writes
+    uint32_t frame;
+
+    /// Tells the buffers threads remember apart from those of an earlier
+    /// debug draw at the same address
+    uint64_t id;
+    _Atomic(struct debugdraw_buffer *) buffers;
+    /// Array of every buffer threads append to, the other one is recorded
+    _Atomic uint32_t side;
+
+    /// Vertices the last `debugdraw_record` drew
+    size_t vertices_count;
+    /// Vertices the last `debugdraw_record` left out for lack of capacity
+    size_t dropped_count;
+};
+
+#ifndef NDEBUG
+
+/// @param[in] device
+/// @param[in] memory_properties
+/// @param[in] render_pass Subpass 0 is drawn into
+/// @param[in,out] layoutcache
+/// @param[in] vertex_code SPIR-V of `shaders/debug_vertex.glsl`
+/// @param[in] vertex_code_size
+/// @param[in] fragment_code SPIR-V of `shaders/debug_fragment.glsl`
+/// @param[in] fragment_code_size
+/// @param[in] capacity Vertices per frame, two for each line
+/// @param[in] frames_count Frames that can be in flight at once
+/// @param[out] debugdraw
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `debugdraw_destroy` after successful
+/// return
+bool debugdraw_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    VkRenderPass render_pass,
+    struct layoutcache *layoutcache,
+    const uint8_t *vertex_code,
+    size_t vertex_code_size,
+    const uint8_t *fragment_code,
+    size_t fragment_code_size,
+    size_t capacity,
+    uint32_t frames_count,
+    struct debugdraw *debugdraw
+);
+
+/// @param[in,out] debugdraw
+/// @note The device must be idle and no thread may append anymore
+void debugdraw_destroy(struct debugdraw *debugdraw);
+
+/// @param[in,out] debugdraw
+/// @param[in] from
+/// @param[in] to
+/// @param[in] color RGBA8 with red in the lowest byte
+/// @note Lines are dropped when memory runs out
+void debugdraw_line(
+    struct debugdraw *debugdraw, const float from[3], const float to[3], uint32_t color
+);
+
+/// @param[in,out] debugdraw
+/// @param[in] min Corner of the axis aligned box
+/// @param[in] max Opposite corner
+/// @param[in] color
+void debugdraw_box(
+    struct debugdraw *debugdraw, const float min[3], const float max[3], uint32_t color
+);
+
+/// Draws a circle around each axis
+/// @param[in,out] debugdraw
+/// @param[in] center
+/// @param[in] radius
+/// @param[in] color
+void debugdraw_sphere(
+    struct debugdraw *debugdraw, const float center[3], float radius, uint32_t color
+);
+
+/// Draws the edges of the volume a view projection keeps
+/// @param[in,out] debugdraw
+/// @param[in] inverse_view_projection Column major, maps clip space with depth
+/// from zero to one back to where the lines are drawn
+/// @param[in] color
+void debugdraw_frustum(
+    struct debugdraw *debugdraw, const float inverse_view_projection[16], uint32_t color
+);
+
+/// Copies the lines of every thread into the ring, empties their buffers and
+/// records one draw of all of them
+/// @param[in,out] debugdraw
+/// @param[in] command_buffer Inside subpass 0 of the render pass
+/// @param[in] extent Of the framebuffer
+/// @param[in] view_projection Column major
+/// @note Lines a thread appends while this runs go into the next frame
+void debugdraw_record(
+    struct debugdraw *debugdraw,
+    VkCommandBuffer command_buffer,
+    VkExtent2D extent,
+    const float view_projection[16]
+);
+
+#else
+
+static inline bool debugdraw_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    VkRenderPass render_pass,
+    struct layoutcache *layoutcache,
+    const uint8_t *vertex_code,
+    size_t vertex_code_size,
+    const uint8_t *fragment_code,
+    size_t fragment_code_size,
+    size_t capacity,
+    uint32_t frames_count,
+    struct debugdraw *debugdraw
+) {
+    (void) device;
+    (void) memory_properties;
+    (void) render_pass;
+    (void) layoutcache;
+    (void) vertex_code;
+    (void) vertex_code_size;
+    (void) fragment_code;
+    (void) fragment_code_size;
+    (void) capacity;
+    (void) frames_count;
+    *debugdraw = (struct debugdraw){};
+
+    return true;
+}
+
+static inline void debugdraw_destroy(struct debugdraw *debugdraw) {
+    (void) debugdraw;
+}
+
+static inline void debugdraw_line(
+    struct debugdraw *debugdraw, const float from[3], const float to[3], uint32_t color
+) {
+    (void) debugdraw;
+    (void) from;
+    (void) to;
+    (void) color;
+}
+
+static inline void debugdraw_box(
+    struct debugdraw *debugdraw, const float min[3], const float max[3], uint32_t color
+) {
+    (void) debugdraw;
+    (void) min;
+    (void) max;
+    (void) color;
+}
+
+static inline void debugdraw_sphere(
+    struct debugdraw *debugdraw, const float center[3], float radius, uint32_t color
+) {
+    (void) debugdraw;
+    (void) center;
+    (void) radius;
+    (void) color;
+}
+
+static inline void debugdraw_frustum(
+    struct debugdraw *debugdraw, const float inverse_view_projection[16], uint32_t color
+) {
+    (void) debugdraw;
+    (void) inverse_view_projection;
+    (void) color;
+}
+
+static inline void debugdraw_record(
+    struct debugdraw *debugdraw,
+    VkCommandBuffer command_buffer,
+    VkExtent2D extent,
+    const float view_projection[16]
+) {
+    (void) debugdraw;
+    (void) command_buffer;
+    (void) extent;
+    (void) view_projection;
+}
+
+#endif
+
+#endif
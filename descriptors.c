@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "descriptors.h"
+
+/// @param[in,out] descriptors
+/// @param[in] memory_properties
+/// @param[in] buffer_properties
+/// @return `true` on success and `false` otherwise
+static bool descriptors_buffer_create(
+    struct descriptors *descriptors,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    const VkPhysicalDeviceDescriptorBufferPropertiesEXT *buffer_properties
+) {
+    VkDevice device = descriptors->device;
+
+    struct {
+        const char *name;
+        PFN_vkVoidFunction *function;
+    } functions[] = {
+        {
+            "vkGetBufferDeviceAddressKHR",
+            (PFN_vkVoidFunction *) &descriptors->vkGetBufferDeviceAddressKHR,
+        },
+        {
+            "vkGetDescriptorSetLayoutSizeEXT",
+            (PFN_vkVoidFunction *) &descriptors->vkGetDescriptorSetLayoutSizeEXT,
+        },
+        {
+            "vkGetDescriptorSetLayoutBindingOffsetEXT",
+            (PFN_vkVoidFunction *) (
+                &descriptors->vkGetDescriptorSetLayoutBindingOffsetEXT
+            ),
+        },
+        {
+            "vkGetDescriptorEXT",
+            (PFN_vkVoidFunction *) &descriptors->vkGetDescriptorEXT,
+        },
+        {
+            "vkCmdBindDescriptorBuffersEXT",
+            (PFN_vkVoidFunction *) &descriptors->vkCmdBindDescriptorBuffersEXT,
+        },
+        {
+            "vkCmdSetDescriptorBufferOffsetsEXT",
+            (PFN_vkVoidFunction *) &descriptors->vkCmdSetDescriptorBufferOffsetsEXT,
+        },
+    };
+
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
+        *functions[i].function = vkGetDeviceProcAddr(device, functions[i].name);
+        if (*functions[i].function == nullptr) {
+            fprintf(
+                stderr, "descriptors_buffer_create: %s not found\n", functions[i].name
+            );
+            return false;
+        }
+    }
+
+    VkDeviceSize setlayout_size;
+    descriptors->vkGetDescriptorSetLayoutSizeEXT(
+        device, descriptors->setlayout, &setlayout_size
+    );
+    descriptors->vkGetDescriptorSetLayoutBindingOffsetEXT(
+        device,
+        descriptors->setlayout,
+        descriptors->binding,
+        &descriptors->binding_offset
+    );
+
+    // Offsets passed to `vkCmdSetDescriptorBufferOffsetsEXT` must be aligned
+    VkDeviceSize alignment = buffer_properties->descriptorBufferOffsetAlignment;
+    descriptors->set_stride = (setlayout_size + alignment - 1) / alignment * alignment;
+    descriptors->descriptor_size = buffer_properties->uniformBufferDescriptorSize;
+
+    // The device reads the descriptors on every draw, so they are kept in
+    // device local memory the host can write to directly
+    if (!buffer_create(
+        device,
+        memory_properties,
+        descriptors->set_stride * descriptors->sets_capacity,
+        (
+            VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |
+            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR
+        ),
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &descriptors->buffer
+    )) {
+        fprintf(stderr, "descriptors_buffer_create: buffer_create failed\n");
+        return false;
+    }
+
+    descriptors->buffer_address = descriptors->vkGetBufferDeviceAddressKHR(
+        device,
+        &(VkBufferDeviceAddressInfo){
+            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR,
+            .buffer = descriptors->buffer.buffer,
+        }
+    );
+
+    return true;
+}
+
+/// @param[in,out] descriptors
+/// @return `true` on success and `false` otherwise
+static bool descriptors_pool_create(struct descriptors *descriptors) {
+    VkDescriptorPoolCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = descriptors->sets_capacity,
+        .pPoolSizes = &(VkDescriptorPoolSize){
+            .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorCount = descriptors->sets_capacity,
+        },
+        .poolSizeCount = 1,
+    };
+
+    if (vkCreateDescriptorPool(
+        descriptors->device, &create_info, nullptr, &descriptors->pool
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "descriptors_pool_create: vkCreateDescriptorPool failed\n");
+        return false;
+    }
+
+    descriptors->sets = calloc(descriptors->sets_capacity, sizeof(descriptors->sets[0]));
+    descriptors->setlayouts = malloc(
+        sizeof(descriptors->setlayouts[0]) * descriptors->sets_capacity
+    );
+    descriptors->writes = malloc(
+        sizeof(descriptors->writes[0]) * descriptors->sets_capacity
+    );
+    if (
+        descriptors->sets == nullptr ||
+        descriptors->setlayouts == nullptr ||
+        descriptors->writes == nullptr
+    ) {
+        fprintf(stderr, "descriptors_pool_create: malloc failed\n");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < descriptors->sets_capacity; i++) {
+        descriptors->setlayouts[i] = descriptors->setlayout;
+    }
+
+    return true;
+}
+
+bool descriptors_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    const VkPhysicalDeviceDescriptorBufferPropertiesEXT *buffer_properties,
+    VkDescriptorSetLayout setlayout,
+    uint32_t binding,
+    uint32_t sets_capacity,
+    struct descriptors *descriptors
+) {
+    *descriptors = (struct descriptors){
+        .device = device,
+        .setlayout = setlayout,
+        .binding = binding,
+        .sets_capacity = sets_capacity,
+        .buffer_enabled = buffer_properties != nullptr,
+    };
+
+    if (descriptors->buffer_enabled) {
+        if (!descriptors_buffer_create(
+            descriptors, memory_properties, buffer_properties
+        )) {
+            fprintf(stderr, "descriptors_create: descriptors_buffer_create failed\n");
+            goto cleanup;
+        }
+    } else if (!descriptors_pool_create(descriptors)) {
+        fprintf(stderr, "descriptors_create: descriptors_pool_create failed\n");
+        goto cleanup;
+    }
+
+    return true;
+
+cleanup:
+    descriptors_destroy(descriptors);
+
+    return false;
+}
+
+void descriptors_destroy(struct descriptors *descriptors) {
+    buffer_destroy(descriptors->device, &descriptors->buffer);
+    vkDestroyDescriptorPool(descriptors->device, descriptors->pool, nullptr);
+    free(descriptors->writes);
+    free(descriptors->setlayouts);
+    free(descriptors->sets);
+
+    *descriptors = (struct descriptors){};
+}
+
+bool descriptors_write(
+    struct descriptors *descriptors,
+    const VkDescriptorBufferInfo *uniform_buffers,
+    uint32_t count
+) {
+    if (count > descriptors->sets_capacity) {
+        fprintf(stderr, "descriptors_write: count (%u) is out of bounds\n", count);
+        return false;
+    }
+
+    if (descriptors->buffer_enabled) {
+        uint8_t *sets = descriptors->buffer.mapped;
+
+        // Neighbouring sets usually point into the same buffer
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceAddress buffer_address = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (uniform_buffers[i].buffer != buffer) {
+                buffer = uniform_buffers[i].buffer;
+                buffer_address = descriptors->vkGetBufferDeviceAddressKHR(
+                    descriptors->device,
+                    &(VkBufferDeviceAddressInfo){
+                        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR,
+                        .buffer = buffer,
+                    }
+                );
+            }
+
+            VkDescriptorAddressInfoEXT address_info = {
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT,
+                .address = buffer_address + uniform_buffers[i].offset,
+                .range = uniform_buffers[i].range,
+                .format = VK_FORMAT_UNDEFINED,
+            };
+
+            descriptors->vkGetDescriptorEXT(
+                descriptors->device,
+                &(VkDescriptorGetInfoEXT){
+                    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+                    .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                    .data.pUniformBuffer = &address_info,
+                },
+                descriptors->descriptor_size,
+                sets + descriptors->set_stride * i + descriptors->binding_offset
+            );
+        }
+
+        return true;
+    }
+
+    if (vkResetDescriptorPool(descriptors->device, descriptors->pool, 0) != VK_SUCCESS) {
+        fprintf(stderr, "descriptors_write: vkResetDescriptorPool failed\n");
+        return false;
+    }
+
+    if (count == 0) {
+        return true;
+    }
+
+    VkDescriptorSetAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = descriptors->pool,
+        .pSetLayouts = descriptors->setlayouts,
+        .descriptorSetCount = count,
+    };
+
+    if (vkAllocateDescriptorSets(
+        descriptors->device, &allocate_info, descriptors->sets
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "descriptors_write: vkAllocateDescriptorSets failed\n");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        descriptors->writes[i] = (VkWriteDescriptorSet){
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptors->sets[i],
+            .dstBinding = descriptors->binding,
+            .dstArrayElement = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorCount = 1,
+            .pBufferInfo = &uniform_buffers[i],
+        };
+    }
+
+    vkUpdateDescriptorSets(descriptors->device, count, descriptors->writes, 0, nullptr);
+
+    return true;
+}
+
+void descriptors_begin(
+    const struct descriptors *descriptors, VkCommandBuffer command_buffer
+) {
+    if (!descriptors->buffer_enabled) {
+        return;
+    }
+
+    VkDescriptorBufferBindingInfoEXT binding_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+        .address = descriptors->buffer_address,
+        .usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT,
+    };
+    descriptors->vkCmdBindDescriptorBuffersEXT(command_buffer, 1, &binding_info);
+}
+
+void descriptors_bind(
+    const struct descriptors *descriptors,
+    VkCommandBuffer command_buffer,
+    VkPipelineLayout layout,
+    uint32_t set,
+    uint32_t index
+) {
+    if (descriptors->buffer_enabled) {
+        uint32_t buffer_index = 0;
+        VkDeviceSize offset = descriptors->set_stride * index;
+        descriptors->vkCmdSetDescriptorBufferOffsetsEXT(
+            command_buffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            layout,
+            set,
+            1,
+            &buffer_index,
+            &offset
+        );
+        return;
+    }
+
+    vkCmdBindDescriptorSets(
+        command_buffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        layout,
+        set,
+        1,
+        &descriptors->sets[index],
+        0,
+        nullptr
+    );
+}
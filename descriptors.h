@@ -0,0 +1,105 @@
+#ifndef DESCRIPTORS_H
+#define DESCRIPTORS_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "buffer.h"
+
+/// Array of descriptor sets of one set layout holding a single uniform buffer.
+/// With `VK_EXT_descriptor_buffer` the descriptors are written straight into a
+/// host visible buffer, one set after the other, and bound by offset.
+/// Otherwise the sets are allocated from a pool and written with
+/// `vkUpdateDescriptorSets`.
+struct descriptors {
+    VkDevice device;
+    VkDescriptorSetLayout setlayout;
+    uint32_t binding;
+    uint32_t sets_capacity;
+
+    /// Whether descriptors are kept in `buffer` instead of `sets`
+    bool buffer_enabled;
+
+    VkDescriptorPool pool;
+    VkDescriptorSet *sets;
+    /// `setlayout` once per set, for allocating every set in one call
+    VkDescriptorSetLayout *setlayouts;
+    VkWriteDescriptorSet *writes;
+
+    struct buffer buffer;
+    VkDeviceAddress buffer_address;
+    /// Distance between two sets in `buffer`
+    VkDeviceSize set_stride;
+    VkDeviceSize binding_offset;
+    size_t descriptor_size;
+
+    PFN_vkGetBufferDeviceAddressKHR vkGetBufferDeviceAddressKHR;
+    PFN_vkGetDescriptorSetLayoutSizeEXT vkGetDescriptorSetLayoutSizeEXT;
+    PFN_vkGetDescriptorSetLayoutBindingOffsetEXT
+        vkGetDescriptorSetLayoutBindingOffsetEXT;
+    PFN_vkGetDescriptorEXT vkGetDescriptorEXT;
+    PFN_vkCmdBindDescriptorBuffersEXT vkCmdBindDescriptorBuffersEXT;
+    PFN_vkCmdSetDescriptorBufferOffsetsEXT vkCmdSetDescriptorBufferOffsetsEXT;
+};
+
+/// @param[in] device
+/// @param[in] memory_properties
+/// @param[in] buffer_properties `nullptr` to use descriptor sets, otherwise
+/// `device` must be created with `VK_EXT_descriptor_buffer` enabled
+/// @param[in] setlayout Created with
+/// `VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT` exactly when
+/// `buffer_properties` is not `nullptr`
+/// @param[in] binding Uniform buffer binding of `setlayout`
+/// @param[in] sets_capacity
+/// @param[out] descriptors
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `descriptors_destroy` after successful
+/// return
+bool descriptors_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    const VkPhysicalDeviceDescriptorBufferPropertiesEXT *buffer_properties,
+    VkDescriptorSetLayout setlayout,
+    uint32_t binding,
+    uint32_t sets_capacity,
+    struct descriptors *descriptors
+);
+
+/// @param[in,out] descriptors
+/// @note The device must be idle
+void descriptors_destroy(struct descriptors *descriptors);
+
+/// @param[in,out] descriptors
+/// @param[in] uniform_buffers Uniform buffer of each set, `range` must not be
+/// `VK_WHOLE_SIZE`
+/// @param[in] count At most `sets_capacity`
+/// @return `true` on success and `false` otherwise
+/// @note Replaces every set, so no submitted work may still use them
+bool descriptors_write(
+    struct descriptors *descriptors,
+    const VkDescriptorBufferInfo *uniform_buffers,
+    uint32_t count
+);
+
+/// @param[in] descriptors
+/// @param[in] command_buffer
+/// @note Must be recorded before the first `descriptors_bind`
+void descriptors_begin(
+    const struct descriptors *descriptors, VkCommandBuffer command_buffer
+);
+
+/// @param[in] descriptors
+/// @param[in] command_buffer
+/// @param[in] layout
+/// @param[in] set Set number of `setlayout` in `layout`
+/// @param[in] index Set written by the last `descriptors_write`
+void descriptors_bind(
+    const struct descriptors *descriptors,
+    VkCommandBuffer command_buffer,
+    VkPipelineLayout layout,
+    uint32_t set,
+    uint32_t index
+);
+
+#endif
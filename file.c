@@ -0,0 +1,134 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "file.h"
+
+bool file_read(const char *filename, uint8_t **content, size_t *content_size) {
+    bool success = false;
+
+    FILE *file = nullptr;
+    uint8_t *read_buffer = nullptr;
+
+    file = fopen(filename, "rb");
+    if (file == nullptr) {
+        fprintf(stderr, "file_read: fopen(\"%s\", \"rb\") failed\n", filename);
+        goto cleanup;
+    }
+
+    if (fseek(file, 0, SEEK_END) != 0) {
+        fprintf(stderr, "file_read: fseek(fd, 0, SEEK_END) failed\n");
+        goto cleanup;
+    }
+
+    size_t file_size = ftell(file);
+    if (file_size == -1) {
+        fprintf(stderr, "file_read: ftell(file) failed\n");
+        goto cleanup;
+    }
+
+    rewind(file);
+
+    read_buffer = malloc(sizeof(uint8_t) * file_size);
+    if (read_buffer == nullptr) {
+        fprintf(stderr, "file_read: malloc failed\n");
+        goto cleanup;
+    }
+
+    if (fread(read_buffer, file_size, 1, file) != 1) {
+        fprintf(stderr, "file_read: fread failed\n");
+        goto cleanup;
+    }
+
+    *content = read_buffer;
+    *content_size = file_size;
+
+    success = true;
+
+cleanup:
+    if (!success) {
+        free(read_buffer);
+    }
+
+    if (file != nullptr) {
+        fclose(file);
+    }
+
+    return success;
+}
+
+bool file_map(const char *filename, const uint8_t **content, size_t *content_size) {
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "file_map: open(\"%s\", O_RDONLY) failed\n", filename);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        fprintf(stderr, "file_map: fstat failed\n");
+        close(fd);
+        return false;
+    }
+
+    // `mmap` rejects empty mappings, an empty file maps to no content
+    void *mapping = nullptr;
+    if (status.st_size > 0) {
+        mapping = mmap(nullptr, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            fprintf(stderr, "file_map: mmap failed\n");
+            close(fd);
+            return false;
+        }
+    }
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+
+    *content = mapping;
+    *content_size = (size_t) status.st_size;
+
+    return true;
+}
+
+void file_unmap(const uint8_t *content, size_t content_size) {
+    if (content_size > 0) {
+        munmap((void *) content, content_size);
+    }
+}
+
+bool file_exists(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+bool file_write(const char *filename, const uint8_t *content, size_t content_size) {
+    FILE *file = fopen(filename, "wb");
+    if (file == nullptr) {
+        fprintf(stderr, "file_write: fopen(\"%s\", \"wb\") failed\n", filename);
+        return false;
+    }
+
+    bool success = fwrite(content, content_size, 1, file) == 1;
+    if (!success) {
+        fprintf(stderr, "file_write: fwrite failed\n");
+    }
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "file_write: fclose failed\n");
+        success = false;
+    }
+
+    return success;
+}
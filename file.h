@@ -0,0 +1,37 @@
+#ifndef FILE_H
+#define FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @param[in] filename
+/// @param[out] content
+/// @param[out] content_size
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible for freeing `content` after it is no longer needed
+bool file_read(const char *filename, uint8_t **content, size_t *content_size);
+
+/// @param[in] filename
+/// @param[out] content Read-only view of the whole file
+/// @param[out] content_size
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `file_unmap` after successful return
+bool file_map(const char *filename, const uint8_t **content, size_t *content_size);
+
+/// @param[in] content
+/// @param[in] content_size
+/// @note `content` will be invalid after this function has been called
+void file_unmap(const uint8_t *content, size_t content_size);
+
+/// @param[in] filename
+/// @return `true` if `filename` can be opened for reading
+bool file_exists(const char *filename);
+
+/// @param[in] filename
+/// @param[in] content
+/// @param[in] content_size
+/// @return `true` on success and `false` otherwise
+/// @note Existing files are truncated
+bool file_write(const char *filename, const uint8_t *content, size_t content_size);
+
+#endif
@@ -0,0 +1,1399 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "gpucull.h"
+#include "spirv.h"
+
+/// Bindings of `shaders/gpucull.glsl`
+enum gpucull_binding {
+    GPUCULL_BINDING_CAMERA,
+    GPUCULL_BINDING_OBJECTS,
+    GPUCULL_BINDING_VISIBILITY,
+    GPUCULL_BINDING_DRAWS,
+    GPUCULL_BINDING_COUNTS,
+    GPUCULL_BINDING_PYRAMID,
+    GPUCULL_BINDINGS_COUNT,
+};
+
+/// Bindings of `shaders/hiz.glsl`
+enum gpucull_hiz_binding {
+    GPUCULL_HIZ_BINDING_SOURCE,
+    GPUCULL_HIZ_BINDING_DESTINATION,
+    GPUCULL_HIZ_BINDINGS_COUNT,
+};
+
+constexpr VkFormat GPUCULL_DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
+constexpr VkFormat GPUCULL_PYRAMID_FORMAT = VK_FORMAT_R32_SFLOAT;
+/// Invocations of a workgroup of `shaders/gpucull.glsl`
+constexpr uint32_t GPUCULL_WORKGROUP_SIZE = 64;
+/// Texels along each axis of a workgroup of `shaders/hiz.glsl`
+constexpr uint32_t GPUCULL_HIZ_WORKGROUP_SIZE = 8;
+
+/// @param[in] size
+/// @return Size of the next level of the pyramid
+static uint32_t gpucull_level_extent(uint32_t size) {
+    return size >> 1 > 0 ? size >> 1 : 1;
+}
+
+bool gpucull_supported(VkPhysicalDevice physicaldevice) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(
+        physicaldevice, GPUCULL_DEPTH_FORMAT, &properties
+    );
+    VkFormatFeatureFlags features = (
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+    );
+
+    return (properties.optimalTilingFeatures & features) == features;
+}
+
+/// @param[in] device
+/// @param[in] code
+/// @param[in] code_size
+/// @param[out] shadermodule
+/// @return `true` on success and `false` otherwise
+static bool gpucull_shadermodule_create(
+    VkDevice device, const uint8_t *code, size_t code_size, VkShaderModule *shadermodule
+) {
+    VkShaderModuleCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pCode = (const uint32_t *) code,
+        .codeSize = code_size,
+    };
+    if (vkCreateShaderModule(
+        device, &create_info, nullptr, shadermodule
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "gpucull_shadermodule_create: vkCreateShaderModule failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] gpucull
+/// @param[in,out] layoutcache
+/// @param[in] code
+/// @param[in] code_size
+/// @param[in] bindings_count
+/// @param[in] push_constants_size
+/// @param[out] shadermodule
+/// @param[out] layout
+/// @param[out] setlayout
+/// @param[out] pipeline
+/// @return `true` on success and `false` otherwise
+static bool gpucull_computepipeline_create(
+    struct gpucull *gpucull,
+    struct layoutcache *layoutcache,
+    const uint8_t *code,
+    size_t code_size,
+    uint32_t bindings_count,
+    uint32_t push_constants_size,
+    VkShaderModule *shadermodule,
+    VkPipelineLayout *layout,
+    VkDescriptorSetLayout *setlayout,
+    VkPipeline *pipeline
+) {
+    struct spirv_reflection reflection;
+    if (!spirv_reflect(code, code_size, &reflection)) {
+        fprintf(stderr, "gpucull_computepipeline_create: spirv_reflect failed\n");
+        return false;
+    }
+    if (
+        reflection.stages != VK_SHADER_STAGE_COMPUTE_BIT ||
+        reflection.bindings_count != bindings_count ||
+        reflection.push_constants.size != push_constants_size
+    ) {
+        fprintf(
+            stderr, "gpucull_computepipeline_create: unexpected shader interface\n"
+        );
+        return false;
+    }
+
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS];
+    uint32_t setlayouts_count;
+    if (!layoutcache_pipelinelayout_get(
+        layoutcache, &reflection, layout, setlayouts, &setlayouts_count
+    )) {
+        fprintf(
+            stderr,
+            "gpucull_computepipeline_create: layoutcache_pipelinelayout_get failed\n"
+        );
+        return false;
+    }
+    *setlayout = setlayouts[0];
+
+    if (!gpucull_shadermodule_create(gpucull->device, code, code_size, shadermodule)) {
+        fprintf(
+            stderr,
+            "gpucull_computepipeline_create: gpucull_shadermodule_create failed\n"
+        );
+        return false;
+    }
+
+    VkComputePipelineCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = *shadermodule,
+            .pName = "main",
+        },
+        .layout = *layout,
+    };
+    if (vkCreateComputePipelines(
+        gpucull->device, VK_NULL_HANDLE, 1, &create_info, nullptr, pipeline
+    ) != VK_SUCCESS) {
+        fprintf(
+            stderr, "gpucull_computepipeline_create: vkCreateComputePipelines failed\n"
+        );
+        *pipeline = VK_NULL_HANDLE;
+        return false;
+    }
+
+    return true;
+}
+
+/// Both passes have the same subpass and dependencies, so that they are
+/// compatible and share the framebuffers and the pipeline
+/// @param[in,out] gpucull
+/// @param[in] color_format
+/// @param[in] early Whether to clear instead of load
+/// @param[out] render_pass
+/// @return `true` on success and `false` otherwise
+static bool gpucull_renderpass_create(
+    struct gpucull *gpucull, VkFormat color_format, bool early, VkRenderPass *render_pass
+) {
+    VkAttachmentDescription attachments[] = {
+        {
+            .format = color_format,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = early ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = early
+                ? VK_IMAGE_LAYOUT_UNDEFINED
+                : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        },
+        // The late pass only tests against the depth, which is not needed
+        // after it
+        {
+            .format = GPUCULL_DEPTH_FORMAT,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = early ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD,
+            .storeOp = early
+                ? VK_ATTACHMENT_STORE_OP_STORE
+                : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = early
+                ? VK_IMAGE_LAYOUT_UNDEFINED
+                : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+            .finalLayout = early
+                ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        },
+    };
+
+    VkAttachmentReference color_reference = {
+        .attachment = 0,
+        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    };
+    VkAttachmentReference depth_reference = {
+        .attachment = 1,
+        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+    };
+    VkSubpassDescription subpass = {
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .pColorAttachments = &color_reference,
+        .colorAttachmentCount = 1,
+        .pDepthStencilAttachment = &depth_reference,
+    };
+
+    // The depth is written after the reduction of the frame before has read
+    // it, and read by the reduction after the early pass has written it
+    VkPipelineStageFlags attachment_stages = (
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+        VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT
+    );
+    VkAccessFlags attachment_writes = (
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+    );
+    VkSubpassDependency dependencies[] = {
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = attachment_stages | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            .srcAccessMask = attachment_writes,
+            .dstStageMask = attachment_stages,
+            .dstAccessMask = (
+                attachment_writes |
+                VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+            ),
+        },
+        {
+            .srcSubpass = 0,
+            .dstSubpass = VK_SUBPASS_EXTERNAL,
+            .srcStageMask = attachment_stages,
+            .srcAccessMask = attachment_writes,
+            .dstStageMask = (
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+            ),
+            .dstAccessMask = (
+                VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                VK_ACCESS_SHADER_READ_BIT
+            ),
+        },
+    };
+
+    VkRenderPassCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .pAttachments = attachments,
+        .attachmentCount = sizeof(attachments) / sizeof(attachments[0]),
+        .pSubpasses = &subpass,
+        .subpassCount = 1,
+        .pDependencies = dependencies,
+        .dependencyCount = sizeof(dependencies) / sizeof(dependencies[0]),
+    };
+    if (vkCreateRenderPass(
+        gpucull->device, &create_info, nullptr, render_pass
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "gpucull_renderpass_create: vkCreateRenderPass failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] gpucull
+/// @param[in,out] layoutcache
+/// @param[in] shaders
+/// @return `true` on success and `false` otherwise
+static bool gpucull_drawpipeline_create(
+    struct gpucull *gpucull,
+    struct layoutcache *layoutcache,
+    const struct gpucull_shaders *shaders
+) {
+    struct spirv_reflection vertex_reflection;
+    struct spirv_reflection fragment_reflection;
+    if (
+        !spirv_reflect(shaders->vertex, shaders->vertex_size, &vertex_reflection) ||
+        !spirv_reflect(shaders->fragment, shaders->fragment_size, &fragment_reflection)
+    ) {
+        fprintf(stderr, "gpucull_drawpipeline_create: spirv_reflect failed\n");
+        return false;
+    }
+
+    struct spirv_reflection reflection = {};
+    if (
+        !spirv_reflection_merge(&reflection, &vertex_reflection) ||
+        !spirv_reflection_merge(&reflection, &fragment_reflection)
+    ) {
+        fprintf(stderr, "gpucull_drawpipeline_create: spirv_reflection_merge failed\n");
+        return false;
+    }
+    if (
+        reflection.bindings_count != 1 ||
+        reflection.inputs_count != 0 ||
+        reflection.push_constants.size != 16 * sizeof(float)
+    ) {
+        fprintf(stderr, "gpucull_drawpipeline_create: unexpected shader interface\n");
+        return false;
+    }
+
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS];
+    uint32_t setlayouts_count;
+    if (!layoutcache_pipelinelayout_get(
+        layoutcache,
+        &reflection,
+        &gpucull->draw_layout,
+        setlayouts,
+        &setlayouts_count
+    )) {
+        fprintf(
+            stderr,
+            "gpucull_drawpipeline_create: layoutcache_pipelinelayout_get failed\n"
+        );
+        return false;
+    }
+    gpucull->draw_setlayout = setlayouts[0];
+
+    if (
+        !gpucull_shadermodule_create(
+            gpucull->device,
+            shaders->vertex,
+            shaders->vertex_size,
+            &gpucull->vertex_shadermodule
+        ) ||
+        !gpucull_shadermodule_create(
+            gpucull->device,
+            shaders->fragment,
+            shaders->fragment_size,
+            &gpucull->fragment_shadermodule
+        )
+    ) {
+        fprintf(
+            stderr, "gpucull_drawpipeline_create: gpucull_shadermodule_create failed\n"
+        );
+        return false;
+    }
+
+    VkPipelineShaderStageCreateInfo stages[] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = gpucull->vertex_shadermodule,
+            .pName = "main",
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = gpucull->fragment_shadermodule,
+            .pName = "main",
+        },
+    };
+
+    VkPipelineVertexInputStateCreateInfo vertex_input = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+    };
+    VkPipelineInputAssemblyStateCreateInfo input_assembly = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+    };
+    VkPipelineViewportStateCreateInfo viewport = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+    VkPipelineRasterizationStateCreateInfo rasterization = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = VK_CULL_MODE_NONE,
+        .frontFace = VK_FRONT_FACE_CLOCKWISE,
+        .lineWidth = 1.0f,
+    };
+    VkPipelineMultisampleStateCreateInfo multisample = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .minSampleShading = 1.0f,
+    };
+    VkPipelineDepthStencilStateCreateInfo depth_stencil = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = VK_TRUE,
+        .depthWriteEnable = VK_TRUE,
+        .depthCompareOp = VK_COMPARE_OP_LESS,
+        .maxDepthBounds = 1.0f,
+    };
+
+    VkDynamicState dynamic_states[] = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+    };
+    VkPipelineDynamicStateCreateInfo dynamic_state = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .pDynamicStates = dynamic_states,
+        .dynamicStateCount = sizeof(dynamic_states) / sizeof(dynamic_states[0]),
+    };
+
+    VkPipelineColorBlendAttachmentState blend_attachment = {
+        .colorWriteMask = (
+            VK_COLOR_COMPONENT_R_BIT |
+            VK_COLOR_COMPONENT_G_BIT |
+            VK_COLOR_COMPONENT_B_BIT |
+            VK_COLOR_COMPONENT_A_BIT
+        ),
+    };
+    VkPipelineColorBlendStateCreateInfo color_blend = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .pAttachments = &blend_attachment,
+        .attachmentCount = 1,
+    };
+
+    VkGraphicsPipelineCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pStages = stages,
+        .stageCount = sizeof(stages) / sizeof(stages[0]),
+        .pVertexInputState = &vertex_input,
+        .pInputAssemblyState = &input_assembly,
+        .pViewportState = &viewport,
+        .pRasterizationState = &rasterization,
+        .pMultisampleState = &multisample,
+        .pDepthStencilState = &depth_stencil,
+        .pColorBlendState = &color_blend,
+        .pDynamicState = &dynamic_state,
+        .layout = gpucull->draw_layout,
+        .renderPass = gpucull->early_pass,
+        .subpass = 0,
+        .basePipelineIndex = -1,
+    };
+    if (vkCreateGraphicsPipelines(
+        gpucull->device,
+        VK_NULL_HANDLE,
+        1,
+        &create_info,
+        nullptr,
+        &gpucull->draw_pipeline
+    ) != VK_SUCCESS) {
+        fprintf(
+            stderr, "gpucull_drawpipeline_create: vkCreateGraphicsPipelines failed\n"
+        );
+        gpucull->draw_pipeline = VK_NULL_HANDLE;
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in] device
+/// @param[in] memory_properties
+/// @param[in] format
+/// @param[in] extent
+/// @param[in] levels_count
+/// @param[in] usage
+/// @param[out] image
+/// @param[out] memory
+/// @return `true` on success and `false` otherwise
+static bool gpucull_image_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    VkFormat format,
+    VkExtent2D extent,
+    uint32_t levels_count,
+    VkImageUsageFlags usage,
+    VkImage *image,
+    VkDeviceMemory *memory
+) {
+    VkImageCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = format,
+        .extent = {
+            .width = extent.width,
+            .height = extent.height,
+            .depth = 1,
+        },
+        .mipLevels = levels_count,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    if (vkCreateImage(device, &create_info, nullptr, image) != VK_SUCCESS) {
+        fprintf(stderr, "gpucull_image_create: vkCreateImage failed\n");
+        return false;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, *image, &requirements);
+
+    uint32_t type_index;
+    if (
+        !buffer_memorytype_find(
+            memory_properties,
+            requirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            &type_index
+        ) &&
+        !buffer_memorytype_find(
+            memory_properties, requirements.memoryTypeBits, 0, &type_index
+        )
+    ) {
+        fprintf(stderr, "gpucull_image_create: no suitable memory type\n");
+        return false;
+    }
+
+    VkMemoryAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = requirements.size,
+        .memoryTypeIndex = type_index,
+    };
+    if (vkAllocateMemory(device, &allocate_info, nullptr, memory) != VK_SUCCESS) {
+        fprintf(stderr, "gpucull_image_create: vkAllocateMemory failed\n");
+        return false;
+    }
+
+    if (vkBindImageMemory(device, *image, *memory, 0) != VK_SUCCESS) {
+        fprintf(stderr, "gpucull_image_create: vkBindImageMemory failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in] device
+/// @param[in] image
+/// @param[in] format
+/// @param[in] aspect
+/// @param[in] first_level
+/// @param[in] levels_count
+/// @param[out] view
+/// @return `true` on success and `false` otherwise
+static bool gpucull_view_create(
+    VkDevice device,
+    VkImage image,
+    VkFormat format,
+    VkImageAspectFlags aspect,
+    uint32_t first_level,
+    uint32_t levels_count,
+    VkImageView *view
+) {
+    VkImageViewCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = format,
+        .subresourceRange = {
+            .aspectMask = aspect,
+            .baseMipLevel = first_level,
+            .levelCount = levels_count,
+            .layerCount = 1,
+        },
+    };
+    if (vkCreateImageView(device, &create_info, nullptr, view) != VK_SUCCESS) {
+        fprintf(stderr, "gpucull_view_create: vkCreateImageView failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// Creates the depth buffer, the pyramid reduced from it and the framebuffers
+/// @param[in,out] gpucull
+/// @param[in] memory_properties
+/// @param[in] views
+/// @param[in] views_count
+/// @return `true` on success and `false` otherwise
+static bool gpucull_targets_create(
+    struct gpucull *gpucull,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    const VkImageView *views,
+    size_t views_count
+) {
+    if (!gpucull_image_create(
+        gpucull->device,
+        memory_properties,
+        GPUCULL_DEPTH_FORMAT,
+        gpucull->extent,
+        1,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        &gpucull->depth,
+        &gpucull->depth_memory
+    )) {
+        fprintf(stderr, "gpucull_targets_create: gpucull_image_create(depth) failed\n");
+        return false;
+    }
+    if (!gpucull_view_create(
+        gpucull->device,
+        gpucull->depth,
+        GPUCULL_DEPTH_FORMAT,
+        VK_IMAGE_ASPECT_DEPTH_BIT,
+        0,
+        1,
+        &gpucull->depth_view
+    )) {
+        fprintf(stderr, "gpucull_targets_create: gpucull_view_create(depth) failed\n");
+        return false;
+    }
+
+    // Down to a single texel, starting at half the depth buffer
+    VkExtent2D pyramid_extent = {
+        .width = gpucull_level_extent(gpucull->extent.width),
+        .height = gpucull_level_extent(gpucull->extent.height),
+    };
+    gpucull->levels_count = 1;
+    for (
+        uint32_t width = pyramid_extent.width, height = pyramid_extent.height;
+        (width > 1 || height > 1) && gpucull->levels_count < GPUCULL_MAX_LEVELS;
+        gpucull->levels_count++
+    ) {
+        width = gpucull_level_extent(width);
+        height = gpucull_level_extent(height);
+    }
+
+    if (!gpucull_image_create(
+        gpucull->device,
+        memory_properties,
+        GPUCULL_PYRAMID_FORMAT,
+        pyramid_extent,
+        gpucull->levels_count,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        &gpucull->pyramid,
+        &gpucull->pyramid_memory
+    )) {
+        fprintf(
+            stderr, "gpucull_targets_create: gpucull_image_create(pyramid) failed\n"
+        );
+        return false;
+    }
+    if (!gpucull_view_create(
+        gpucull->device,
+        gpucull->pyramid,
+        GPUCULL_PYRAMID_FORMAT,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        0,
+        gpucull->levels_count,
+        &gpucull->pyramid_view
+    )) {
+        fprintf(stderr, "gpucull_targets_create: gpucull_view_create(pyramid) failed\n");
+        return false;
+    }
+    for (uint32_t level = 0; level < gpucull->levels_count; level++) {
+        if (!gpucull_view_create(
+            gpucull->device,
+            gpucull->pyramid,
+            GPUCULL_PYRAMID_FORMAT,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            level,
+            1,
+            &gpucull->level_views[level]
+        )) {
+            fprintf(
+                stderr,
+                "gpucull_targets_create: gpucull_view_create(%u) failed\n",
+                level
+            );
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < views_count; i++) {
+        VkImageView attachments[] = {views[i], gpucull->depth_view};
+        VkFramebufferCreateInfo create_info = {
+            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            .renderPass = gpucull->early_pass,
+            .pAttachments = attachments,
+            .attachmentCount = sizeof(attachments) / sizeof(attachments[0]),
+            .width = gpucull->extent.width,
+            .height = gpucull->extent.height,
+            .layers = 1,
+        };
+        if (vkCreateFramebuffer(
+            gpucull->device, &create_info, nullptr, &gpucull->framebuffers[i]
+        ) != VK_SUCCESS) {
+            fprintf(
+                stderr, "gpucull_targets_create: vkCreateFramebuffer(%zu) failed\n", i
+            );
+            return false;
+        }
+        gpucull->framebuffers_count++;
+    }
+
+    return true;
+}
+
+/// @param[in,out] gpucull
+/// @param[in] memory_properties
+/// @return `true` on success and `false` otherwise
+static bool gpucull_buffers_create(
+    struct gpucull *gpucull, const VkPhysicalDeviceMemoryProperties *memory_properties
+) {
+    VkMemoryPropertyFlags host = (
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+    struct {
+        struct buffer *buffer;
+        VkDeviceSize size;
+        VkBufferUsageFlags usage;
+        VkMemoryPropertyFlags required;
+    } buffers[] = {
+        {
+            &gpucull->camera,
+            sizeof(struct gpucull_camera),
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            host,
+        },
+        {
+            &gpucull->objects,
+            2 * 4 * sizeof(float) * gpucull->capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            host,
+        },
+        {
+            &gpucull->visibility,
+            sizeof(uint32_t) * gpucull->capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            0,
+        },
+        {
+            &gpucull->draws,
+            2 * sizeof(VkDrawIndirectCommand) * gpucull->capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            0,
+        },
+        // Read back by the host once the frame is done
+        {
+            &gpucull->counts,
+            sizeof(struct gpucull_counts),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            host,
+        },
+    };
+
+    for (size_t i = 0; i < sizeof(buffers) / sizeof(buffers[0]); i++) {
+        if (!buffer_create(
+            gpucull->device,
+            memory_properties,
+            buffers[i].size,
+            buffers[i].usage,
+            buffers[i].required,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            buffers[i].buffer
+        )) {
+            fprintf(stderr, "gpucull_buffers_create: buffer_create(%zu) failed\n", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/// Allocates every set and points them at the buffers and images
+/// @param[in,out] gpucull
+/// @return `true` on success and `false` otherwise
+static bool gpucull_sets_allocate(struct gpucull *gpucull) {
+    VkDescriptorPoolSize pool_sizes[] = {
+        {
+            .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorCount = 1,
+        },
+        {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 5,
+        },
+        {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1 + GPUCULL_MAX_LEVELS,
+        },
+        {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = GPUCULL_MAX_LEVELS,
+        },
+    };
+    VkDescriptorPoolCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = 2 + GPUCULL_MAX_LEVELS,
+        .pPoolSizes = pool_sizes,
+        .poolSizeCount = sizeof(pool_sizes) / sizeof(pool_sizes[0]),
+    };
+    if (vkCreateDescriptorPool(
+        gpucull->device, &create_info, nullptr, &gpucull->pool
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "gpucull_sets_allocate: vkCreateDescriptorPool failed\n");
+        return false;
+    }
+
+    VkDescriptorSetLayout setlayouts[2 + GPUCULL_MAX_LEVELS] = {
+        gpucull->cull_setlayout,
+        gpucull->draw_setlayout,
+    };
+    for (uint32_t level = 0; level < gpucull->levels_count; level++) {
+        setlayouts[2 + level] = gpucull->hiz_setlayout;
+    }
+    VkDescriptorSet sets[2 + GPUCULL_MAX_LEVELS];
+    VkDescriptorSetAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = gpucull->pool,
+        .pSetLayouts = setlayouts,
+        .descriptorSetCount = 2 + gpucull->levels_count,
+    };
+    if (vkAllocateDescriptorSets(gpucull->device, &allocate_info, sets) != VK_SUCCESS) {
+        fprintf(stderr, "gpucull_sets_allocate: vkAllocateDescriptorSets failed\n");
+        return false;
+    }
+    gpucull->cull_set = sets[0];
+    gpucull->draw_set = sets[1];
+    for (uint32_t level = 0; level < gpucull->levels_count; level++) {
+        gpucull->hiz_sets[level] = sets[2 + level];
+    }
+
+    VkDescriptorBufferInfo buffer_infos[GPUCULL_BINDINGS_COUNT] = {
+        [GPUCULL_BINDING_CAMERA] = {
+            .buffer = gpucull->camera.buffer,
+            .range = VK_WHOLE_SIZE,
+        },
+        [GPUCULL_BINDING_OBJECTS] = {
+            .buffer = gpucull->objects.buffer,
+            .range = VK_WHOLE_SIZE,
+        },
+        [GPUCULL_BINDING_VISIBILITY] = {
+            .buffer = gpucull->visibility.buffer,
+            .range = VK_WHOLE_SIZE,
+        },
+        [GPUCULL_BINDING_DRAWS] = {
+            .buffer = gpucull->draws.buffer,
+            .range = VK_WHOLE_SIZE,
+        },
+        [GPUCULL_BINDING_COUNTS] = {
+            .buffer = gpucull->counts.buffer,
+            .range = VK_WHOLE_SIZE,
+        },
+    };
+    VkDescriptorImageInfo pyramid_info = {
+        .imageView = gpucull->pyramid_view,
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+    };
+    VkWriteDescriptorSet writes[] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = gpucull->cull_set,
+            .dstBinding = GPUCULL_BINDING_CAMERA,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorCount = 1,
+            .pBufferInfo = &buffer_infos[GPUCULL_BINDING_CAMERA],
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = gpucull->cull_set,
+            .dstBinding = GPUCULL_BINDING_OBJECTS,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = GPUCULL_BINDING_PYRAMID - GPUCULL_BINDING_OBJECTS,
+            .pBufferInfo = &buffer_infos[GPUCULL_BINDING_OBJECTS],
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = gpucull->cull_set,
+            .dstBinding = GPUCULL_BINDING_PYRAMID,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+            .pImageInfo = &pyramid_info,
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = gpucull->draw_set,
+            .dstBinding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .pBufferInfo = &buffer_infos[GPUCULL_BINDING_OBJECTS],
+        },
+    };
+    vkUpdateDescriptorSets(
+        gpucull->device, sizeof(writes) / sizeof(writes[0]), writes, 0, nullptr
+    );
+
+    // Level 0 is reduced from the depth buffer, every other level from the
+    // level above it
+    for (uint32_t level = 0; level < gpucull->levels_count; level++) {
+        VkDescriptorImageInfo image_infos[GPUCULL_HIZ_BINDINGS_COUNT] = {
+            [GPUCULL_HIZ_BINDING_SOURCE] = level == 0
+                ? (VkDescriptorImageInfo){
+                    .imageView = gpucull->depth_view,
+                    .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                }
+                : (VkDescriptorImageInfo){
+                    .imageView = gpucull->level_views[level - 1],
+                    .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+                },
+            [GPUCULL_HIZ_BINDING_DESTINATION] = {
+                .imageView = gpucull->level_views[level],
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            },
+        };
+        VkWriteDescriptorSet level_writes[GPUCULL_HIZ_BINDINGS_COUNT] = {
+            [GPUCULL_HIZ_BINDING_SOURCE] = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = gpucull->hiz_sets[level],
+                .dstBinding = GPUCULL_HIZ_BINDING_SOURCE,
+                .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                .descriptorCount = 1,
+                .pImageInfo = &image_infos[GPUCULL_HIZ_BINDING_SOURCE],
+            },
+            [GPUCULL_HIZ_BINDING_DESTINATION] = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = gpucull->hiz_sets[level],
+                .dstBinding = GPUCULL_HIZ_BINDING_DESTINATION,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .descriptorCount = 1,
+                .pImageInfo = &image_infos[GPUCULL_HIZ_BINDING_DESTINATION],
+            },
+        };
+        vkUpdateDescriptorSets(
+            gpucull->device, GPUCULL_HIZ_BINDINGS_COUNT, level_writes, 0, nullptr
+        );
+    }
+
+    return true;
+}
+
+bool gpucull_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    struct layoutcache *layoutcache,
+    const struct gpucull_shaders *shaders,
+    VkFormat color_format,
+    VkExtent2D extent,
+    const VkImageView *views,
+    size_t views_count,
+    size_t capacity,
+    struct gpucull *gpucull
+) {
+    *gpucull = (struct gpucull){
+        .device = device,
+        .extent = extent,
+        .capacity = capacity,
+    };
+
+    if (views_count > GPUCULL_MAX_FRAMEBUFFERS || capacity == 0) {
+        fprintf(stderr, "gpucull_create: views_count or capacity is out of bounds\n");
+        goto cleanup;
+    }
+
+    gpucull->vkCmdDrawIndirectCountKHR = (PFN_vkCmdDrawIndirectCountKHR) (
+        vkGetDeviceProcAddr(device, "vkCmdDrawIndirectCountKHR")
+    );
+    if (gpucull->vkCmdDrawIndirectCountKHR == nullptr) {
+        fprintf(stderr, "gpucull_create: vkCmdDrawIndirectCountKHR not found\n");
+        goto cleanup;
+    }
+
+    if (
+        !gpucull_renderpass_create(gpucull, color_format, true, &gpucull->early_pass) ||
+        !gpucull_renderpass_create(gpucull, color_format, false, &gpucull->late_pass)
+    ) {
+        fprintf(stderr, "gpucull_create: gpucull_renderpass_create failed\n");
+        goto cleanup;
+    }
+
+    if (!gpucull_computepipeline_create(
+        gpucull,
+        layoutcache,
+        shaders->cull,
+        shaders->cull_size,
+        GPUCULL_BINDINGS_COUNT,
+        sizeof(struct gpucull_cull),
+        &gpucull->cull_shadermodule,
+        &gpucull->cull_layout,
+        &gpucull->cull_setlayout,
+        &gpucull->cull_pipeline
+    )) {
+        fprintf(stderr, "gpucull_create: gpucull_computepipeline_create(cull) failed\n");
+        goto cleanup;
+    }
+
+    if (!gpucull_computepipeline_create(
+        gpucull,
+        layoutcache,
+        shaders->hiz,
+        shaders->hiz_size,
+        GPUCULL_HIZ_BINDINGS_COUNT,
+        sizeof(struct gpucull_level),
+        &gpucull->hiz_shadermodule,
+        &gpucull->hiz_layout,
+        &gpucull->hiz_setlayout,
+        &gpucull->hiz_pipeline
+    )) {
+        fprintf(stderr, "gpucull_create: gpucull_computepipeline_create(hiz) failed\n");
+        goto cleanup;
+    }
+
+    if (!gpucull_drawpipeline_create(gpucull, layoutcache, shaders)) {
+        fprintf(stderr, "gpucull_create: gpucull_drawpipeline_create failed\n");
+        goto cleanup;
+    }
+
+    if (!gpucull_targets_create(gpucull, memory_properties, views, views_count)) {
+        fprintf(stderr, "gpucull_create: gpucull_targets_create failed\n");
+        goto cleanup;
+    }
+
+    if (!gpucull_buffers_create(gpucull, memory_properties)) {
+        fprintf(stderr, "gpucull_create: gpucull_buffers_create failed\n");
+        goto cleanup;
+    }
+
+    if (!gpucull_sets_allocate(gpucull)) {
+        fprintf(stderr, "gpucull_create: gpucull_sets_allocate failed\n");
+        goto cleanup;
+    }
+
+    return true;
+
+cleanup:
+    gpucull_destroy(gpucull);
+
+    return false;
+}
+
+void gpucull_destroy(struct gpucull *gpucull) {
+    VkDevice device = gpucull->device;
+
+    vkDestroyDescriptorPool(device, gpucull->pool, nullptr);
+    buffer_destroy(device, &gpucull->counts);
+    buffer_destroy(device, &gpucull->draws);
+    buffer_destroy(device, &gpucull->visibility);
+    buffer_destroy(device, &gpucull->objects);
+    buffer_destroy(device, &gpucull->camera);
+    for (size_t i = 0; i < gpucull->framebuffers_count; i++) {
+        vkDestroyFramebuffer(device, gpucull->framebuffers[i], nullptr);
+    }
+    for (uint32_t level = 0; level < GPUCULL_MAX_LEVELS; level++) {
+        vkDestroyImageView(device, gpucull->level_views[level], nullptr);
+    }
+    vkDestroyImageView(device, gpucull->pyramid_view, nullptr);
+    vkDestroyImage(device, gpucull->pyramid, nullptr);
+    vkFreeMemory(device, gpucull->pyramid_memory, nullptr);
+    vkDestroyImageView(device, gpucull->depth_view, nullptr);
+    vkDestroyImage(device, gpucull->depth, nullptr);
+    vkFreeMemory(device, gpucull->depth_memory, nullptr);
+    vkDestroyPipeline(device, gpucull->draw_pipeline, nullptr);
+    vkDestroyPipeline(device, gpucull->hiz_pipeline, nullptr);
+    vkDestroyPipeline(device, gpucull->cull_pipeline, nullptr);
+    vkDestroyShaderModule(device, gpucull->fragment_shadermodule, nullptr);
+    vkDestroyShaderModule(device, gpucull->vertex_shadermodule, nullptr);
+    vkDestroyShaderModule(device, gpucull->hiz_shadermodule, nullptr);
+    vkDestroyShaderModule(device, gpucull->cull_shadermodule, nullptr);
+    vkDestroyRenderPass(device, gpucull->late_pass, nullptr);
+    vkDestroyRenderPass(device, gpucull->early_pass, nullptr);
+
+    *gpucull = (struct gpucull){};
+}
+
+bool gpucull_objects_set(struct gpucull *gpucull, const struct cull_objects *objects) {
+    if (objects->count > gpucull->capacity) {
+        fprintf(
+            stderr,
+            "gpucull_objects_set: objects->count (%zu) is out of bounds\n",
+            objects->count
+        );
+        return false;
+    }
+
+    float *mapped = gpucull->objects.mapped;
+    for (size_t i = 0; i < objects->count; i++) {
+        float object[8] = {
+            objects->center_x[i],
+            objects->center_y[i],
+            objects->center_z[i],
+            objects->radius[i],
+            objects->extent_x[i],
+            objects->extent_y[i],
+            objects->extent_z[i],
+            0.0f,
+        };
+        memcpy(&mapped[8 * i], object, sizeof(object));
+    }
+    gpucull->objects_count = objects->count;
+    gpucull->visibility_reset = true;
+
+    return true;
+}
+
+/// @param[in] gpucull
+/// @param[in] command_buffer
+/// @param[in] phase
+static void gpucull_cull_record(
+    const struct gpucull *gpucull,
+    VkCommandBuffer command_buffer,
+    enum gpucull_phase phase
+) {
+    struct gpucull_cull cull = {
+        .objects_count = (uint32_t) gpucull->objects_count,
+        .phase = phase,
+        .depth_width = (int32_t) gpucull->extent.width,
+        .depth_height = (int32_t) gpucull->extent.height,
+        .levels_count = gpucull->levels_count,
+    };
+
+    vkCmdBindPipeline(
+        command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, gpucull->cull_pipeline
+    );
+    vkCmdBindDescriptorSets(
+        command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        gpucull->cull_layout,
+        0,
+        1,
+        &gpucull->cull_set,
+        0,
+        nullptr
+    );
+    vkCmdPushConstants(
+        command_buffer,
+        gpucull->cull_layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(cull),
+        &cull
+    );
+    vkCmdDispatch(
+        command_buffer,
+        (cull.objects_count + GPUCULL_WORKGROUP_SIZE - 1) / GPUCULL_WORKGROUP_SIZE,
+        1,
+        1
+    );
+
+    // The draws are read as indirect commands, and the late phase reads the
+    // visibility the early phase left, while the host reads the counts once
+    // the frame is done
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = (
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+            VK_ACCESS_SHADER_READ_BIT |
+            VK_ACCESS_HOST_READ_BIT
+        ),
+    };
+    vkCmdPipelineBarrier(
+        command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+            VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+}
+
+/// @param[in] gpucull
+/// @param[in] command_buffer
+/// @param[in] framebuffer_index
+/// @param[in] phase
+/// @param[in] view_projection
+static void gpucull_draw_record(
+    const struct gpucull *gpucull,
+    VkCommandBuffer command_buffer,
+    uint32_t framebuffer_index,
+    enum gpucull_phase phase,
+    const float view_projection[16]
+) {
+    VkClearValue clear_values[] = {
+        {
+            .color = {
+                {0.0f, 0.0f, 0.0f, 1.0f},
+            },
+        },
+        {
+            .depthStencil = {
+                .depth = 1.0f,
+            },
+        },
+    };
+    VkRenderPassBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .renderPass = phase == GPUCULL_PHASE_EARLY
+            ? gpucull->early_pass
+            : gpucull->late_pass,
+        .framebuffer = gpucull->framebuffers[framebuffer_index],
+        .renderArea = {
+            .offset = {0, 0},
+            .extent = gpucull->extent,
+        },
+        .pClearValues = clear_values,
+        .clearValueCount = sizeof(clear_values) / sizeof(clear_values[0]),
+    };
+    vkCmdBeginRenderPass(command_buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport viewport = {
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = (float) gpucull->extent.width,
+        .height = (float) gpucull->extent.height,
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    VkRect2D scissor = {
+        .offset = {0, 0},
+        .extent = gpucull->extent,
+    };
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+    vkCmdBindPipeline(
+        command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gpucull->draw_pipeline
+    );
+    vkCmdBindDescriptorSets(
+        command_buffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        gpucull->draw_layout,
+        0,
+        1,
+        &gpucull->draw_set,
+        0,
+        nullptr
+    );
+    vkCmdPushConstants(
+        command_buffer,
+        gpucull->draw_layout,
+        VK_SHADER_STAGE_VERTEX_BIT,
+        0,
+        16 * sizeof(float),
+        view_projection
+    );
+
+    // The late draws follow a whole set of early ones, however many of those
+    // were written
+    VkDeviceSize draws_offset = phase == GPUCULL_PHASE_EARLY
+        ? 0
+        : sizeof(VkDrawIndirectCommand) * gpucull->objects_count;
+    VkDeviceSize count_offset = phase == GPUCULL_PHASE_EARLY
+        ? offsetof(struct gpucull_counts, early_draws)
+        : offsetof(struct gpucull_counts, late_draws);
+    gpucull->vkCmdDrawIndirectCountKHR(
+        command_buffer,
+        gpucull->draws.buffer,
+        draws_offset,
+        gpucull->counts.buffer,
+        count_offset,
+        (uint32_t) gpucull->objects_count,
+        sizeof(VkDrawIndirectCommand)
+    );
+
+    vkCmdEndRenderPass(command_buffer);
+}
+
+/// Reduces the depth the early pass left into every level of the pyramid
+/// @param[in] gpucull
+/// @param[in] command_buffer
+static void gpucull_pyramid_record(
+    const struct gpucull *gpucull, VkCommandBuffer command_buffer
+) {
+    vkCmdBindPipeline(
+        command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, gpucull->hiz_pipeline
+    );
+
+    struct gpucull_level level = {
+        .width = (int32_t) gpucull->extent.width,
+        .height = (int32_t) gpucull->extent.height,
+    };
+    for (uint32_t i = 0; i < gpucull->levels_count; i++) {
+        level.source_width = level.width;
+        level.source_height = level.height;
+        level.width = (int32_t) gpucull_level_extent((uint32_t) level.width);
+        level.height = (int32_t) gpucull_level_extent((uint32_t) level.height);
+
+        vkCmdBindDescriptorSets(
+            command_buffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            gpucull->hiz_layout,
+            0,
+            1,
+            &gpucull->hiz_sets[i],
+            0,
+            nullptr
+        );
+        vkCmdPushConstants(
+            command_buffer,
+            gpucull->hiz_layout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(level),
+            &level
+        );
+        vkCmdDispatch(
+            command_buffer,
+            ((uint32_t) level.width + GPUCULL_HIZ_WORKGROUP_SIZE - 1) /
+                GPUCULL_HIZ_WORKGROUP_SIZE,
+            ((uint32_t) level.height + GPUCULL_HIZ_WORKGROUP_SIZE - 1) /
+                GPUCULL_HIZ_WORKGROUP_SIZE,
+            1
+        );
+
+        // Each level is read by the next one, and all of them by the late
+        // phase
+        VkMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        };
+        vkCmdPipelineBarrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr
+        );
+    }
+}
+
+void gpucull_record(
+    struct gpucull *gpucull,
+    VkCommandBuffer command_buffer,
+    uint32_t framebuffer_index,
+    const float view_projection[16]
+) {
+    struct gpucull_camera *camera = gpucull->camera.mapped;
+    memcpy(camera->view_projection, view_projection, sizeof(camera->view_projection));
+    struct cull_frustum frustum;
+    cull_frustum_extract(view_projection, &frustum);
+    memcpy(camera->planes, frustum.planes, sizeof(camera->planes));
+
+    if (gpucull->visibility_reset) {
+        vkCmdFillBuffer(
+            command_buffer, gpucull->visibility.buffer, 0, VK_WHOLE_SIZE, 0
+        );
+        gpucull->visibility_reset = false;
+    }
+    vkCmdFillBuffer(command_buffer, gpucull->counts.buffer, 0, VK_WHOLE_SIZE, 0);
+
+    // The draws of the frame before are done being read, and the pyramid is
+    // rebuilt from scratch, but is bound in the general layout all along
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+    VkImageMemoryBarrier pyramid_barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = gpucull->pyramid,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .levelCount = gpucull->levels_count,
+            .layerCount = 1,
+        },
+    };
+    vkCmdPipelineBarrier(
+        command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT |
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        1,
+        &pyramid_barrier
+    );
+
+    gpucull_cull_record(gpucull, command_buffer, GPUCULL_PHASE_EARLY);
+    gpucull_draw_record(
+        gpucull, command_buffer, framebuffer_index, GPUCULL_PHASE_EARLY, view_projection
+    );
+    gpucull_pyramid_record(gpucull, command_buffer);
+    gpucull_cull_record(gpucull, command_buffer, GPUCULL_PHASE_LATE);
+    gpucull_draw_record(
+        gpucull, command_buffer, framebuffer_index, GPUCULL_PHASE_LATE, view_projection
+    );
+}
+
+void gpucull_counts_read(const struct gpucull *gpucull, struct gpucull_counts *counts) {
+    memcpy(counts, gpucull->counts.mapped, sizeof(*counts));
+}
@@ -0,0 +1,211 @@
+#ifndef GPUCULL_H
+#define GPUCULL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "buffer.h"
+#include "cull.h"
+#include "layoutcache.h"
+
+/// Levels of the depth pyramid, enough for a depth buffer 65536 texels wide
+constexpr uint32_t GPUCULL_MAX_LEVELS = 16;
+/// Framebuffers, one per swapchain image
+constexpr size_t GPUCULL_MAX_FRAMEBUFFERS = 16;
+
+/// SPIR-V of the shaders the culler is built from
+struct gpucull_shaders {
+    /// `shaders/gpucull.glsl`
+    const uint8_t *cull;
+    size_t cull_size;
+    /// `shaders/hiz.glsl`
+    const uint8_t *hiz;
+    size_t hiz_size;
+    /// `shaders/gpucull_vertex.glsl`
+    const uint8_t *vertex;
+    size_t vertex_size;
+    /// `shaders/gpucull_fragment.glsl`
+    const uint8_t *fragment;
+    size_t fragment_size;
+};
+
+/// `Cull` push constant block of `shaders/gpucull.glsl`
+struct gpucull_cull {
+    uint32_t objects_count;
+    /// `GPUCULL_PHASE_EARLY` or `GPUCULL_PHASE_LATE`
+    uint32_t phase;
+    int32_t depth_width;
+    int32_t depth_height;
+    uint32_t levels_count;
+};
+
+/// Phases of `shaders/gpucull.glsl`
+enum gpucull_phase {
+    /// Draws the objects visible the frame before
+    GPUCULL_PHASE_EARLY,
+    /// Tests every object against the depth pyramid and draws the ones that
+    /// became visible
+    GPUCULL_PHASE_LATE,
+};
+
+/// `Level` push constant block of `shaders/hiz.glsl`
+struct gpucull_level {
+    int32_t source_width;
+    int32_t source_height;
+    int32_t width;
+    int32_t height;
+};
+
+/// `Camera` uniform block of `shaders/gpucull.glsl`
+struct gpucull_camera {
+    float view_projection[16];
+    float planes[6][4];
+};
+
+/// `Counts` storage block of `shaders/gpucull.glsl`, as the last frame left it
+struct gpucull_counts {
+    /// Objects visible the frame before that were drawn before the pyramid
+    uint32_t early_draws;
+    /// Objects that were hidden the frame before and drawn after the pyramid
+    uint32_t late_draws;
+    uint32_t frustum_culled;
+    /// Objects in the frustum behind the depth of the early draws
+    uint32_t occluded;
+};
+
+/// Two phase occlusion culling on the device. The objects visible last frame
+/// are drawn first, a depth pyramid is reduced from their depth, and every
+/// object is tested against it, after which the ones that became visible are
+/// drawn as well. Draws are written by compute shaders and issued with
+/// `vkCmdDrawIndirectCountKHR`, so the host never sees which objects are
+/// drawn. Objects are drawn as their boxes, generated in the vertex shader.
+struct gpucull {
+    VkDevice device;
+    PFN_vkCmdDrawIndirectCountKHR vkCmdDrawIndirectCountKHR;
+
+    VkExtent2D extent;
+    /// Clears the color and depth, and leaves the depth to be sampled
+    VkRenderPass early_pass;
+    /// Loads the color and depth, and leaves the color to be drawn over
+    VkRenderPass late_pass;
+    VkFramebuffer framebuffers[GPUCULL_MAX_FRAMEBUFFERS];
+    size_t framebuffers_count;
+
+    VkImage depth;
+    VkDeviceMemory depth_memory;
+    VkImageView depth_view;
+    /// Farthest depth of each texel of the depth buffer and every level
+    /// reduced from it, each level half the size of the one above
+    VkImage pyramid;
+    VkDeviceMemory pyramid_memory;
+    /// Every level, which the cull shader reads
+    VkImageView pyramid_view;
+    /// One level each, which the reduction writes and then reads
+    VkImageView level_views[GPUCULL_MAX_LEVELS];
+    uint32_t levels_count;
+
+    VkShaderModule cull_shadermodule;
+    VkShaderModule hiz_shadermodule;
+    VkShaderModule vertex_shadermodule;
+    VkShaderModule fragment_shadermodule;
+    /// Owned by the layout cache
+    VkPipelineLayout cull_layout;
+    VkPipelineLayout hiz_layout;
+    VkPipelineLayout draw_layout;
+    VkDescriptorSetLayout cull_setlayout;
+    VkDescriptorSetLayout hiz_setlayout;
+    VkDescriptorSetLayout draw_setlayout;
+    VkPipeline cull_pipeline;
+    VkPipeline hiz_pipeline;
+    VkPipeline draw_pipeline;
+
+    VkDescriptorPool pool;
+    VkDescriptorSet cull_set;
+    /// Reducing level `i - 1`, or the depth buffer, into level `i`
+    VkDescriptorSet hiz_sets[GPUCULL_MAX_LEVELS];
+    VkDescriptorSet draw_set;
+
+    /// `Camera` uniform block of `shaders/gpucull.glsl`, written by every
+    /// `gpucull_record`
+    struct buffer camera;
+    /// Center and radius, then extent, of every object
+    struct buffer objects;
+    /// Whether each object was visible the last frame
+    struct buffer visibility;
+    /// The draws of the early phase, then those of the late phase
+    struct buffer draws;
+    /// `struct gpucull_counts`
+    struct buffer counts;
+    size_t capacity;
+    size_t objects_count;
+    /// Cleared by the next `gpucull_record` once the objects changed
+    bool visibility_reset;
+};
+
+/// @param[in] physicaldevice
+/// @return Whether the depth buffer can be both drawn into and sampled
+bool gpucull_supported(VkPhysicalDevice physicaldevice);
+
+/// @param[in] device With `VK_KHR_draw_indirect_count`, `multiDrawIndirect`
+/// and `drawIndirectFirstInstance` enabled
+/// @param[in] memory_properties
+/// @param[in,out] layoutcache Without set layout flags
+/// @param[in] shaders
+/// @param[in] color_format Of the swapchain images
+/// @param[in] extent Of the swapchain images
+/// @param[in] views Of the swapchain images
+/// @param[in] views_count At most `GPUCULL_MAX_FRAMEBUFFERS`
+/// @param[in] capacity Objects that can be culled at once
+/// @param[out] gpucull
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `gpucull_destroy` after successful
+/// return
+bool gpucull_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    struct layoutcache *layoutcache,
+    const struct gpucull_shaders *shaders,
+    VkFormat color_format,
+    VkExtent2D extent,
+    const VkImageView *views,
+    size_t views_count,
+    size_t capacity,
+    struct gpucull *gpucull
+);
+
+/// @param[in,out] gpucull
+/// @note The device must be idle
+void gpucull_destroy(struct gpucull *gpucull);
+
+/// Replaces the objects, all of which count as hidden the frame before
+/// @param[in,out] gpucull
+/// @param[in] objects At most `capacity`
+/// @return `true` on success and `false` otherwise
+/// @note Command buffers recorded earlier must have finished executing
+bool gpucull_objects_set(struct gpucull *gpucull, const struct cull_objects *objects);
+
+/// Records culling and drawing the objects into a swapchain image in both
+/// phases, clearing it first
+/// @param[in,out] gpucull
+/// @param[in] command_buffer Recording, outside of a render pass
+/// @param[in] framebuffer_index Of the swapchain image
+/// @param[in] view_projection Column major, with depth from zero to one
+/// @note The swapchain image is left in
+/// `VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL` for a render pass that loads it
+/// @note Rewrites the camera, so command buffers recorded earlier must have
+/// finished executing
+void gpucull_record(
+    struct gpucull *gpucull,
+    VkCommandBuffer command_buffer,
+    uint32_t framebuffer_index,
+    const float view_projection[16]
+);
+
+/// @param[in] gpucull
+/// @param[out] counts Of the last command buffer `gpucull_record` recorded
+/// into, which must have finished executing
+void gpucull_counts_read(const struct gpucull *gpucull, struct gpucull_counts *counts);
+
+#endif
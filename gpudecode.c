@@ -0,0 +1,288 @@
+#include <stdio.h>
+
+#include "gpudecode.h"
+#include "spirv.h"
+
+/// Bindings of `shaders/decompress.glsl`
+enum gpudecode_binding {
+    GPUDECODE_BINDING_SOURCE,
+    GPUDECODE_BINDING_DESTINATION,
+    GPUDECODE_BINDING_STATUS,
+    GPUDECODE_BINDINGS_COUNT,
+};
+
+/// @param[in,out] gpudecode
+/// @param[in,out] layoutcache
+/// @param[in] code
+/// @param[in] code_size
+/// @return `true` on success and `false` otherwise
+static bool gpudecode_pipeline_create(
+    struct gpudecode *gpudecode,
+    struct layoutcache *layoutcache,
+    const uint8_t *code,
+    size_t code_size
+) {
+    struct spirv_reflection reflection;
+    if (!spirv_reflect(code, code_size, &reflection)) {
+        fprintf(stderr, "gpudecode_pipeline_create: spirv_reflect failed\n");
+        return false;
+    }
+    if (
+        reflection.stages != VK_SHADER_STAGE_COMPUTE_BIT ||
+        reflection.bindings_count != GPUDECODE_BINDINGS_COUNT ||
+        reflection.push_constants.size != sizeof(struct gpudecode_blob)
+    ) {
+        fprintf(stderr, "gpudecode_pipeline_create: unexpected shader interface\n");
+        return false;
+    }
+
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS];
+    uint32_t setlayouts_count;
+    if (!layoutcache_pipelinelayout_get(
+        layoutcache,
+        &reflection,
+        &gpudecode->layout,
+        setlayouts,
+        &setlayouts_count
+    )) {
+        fprintf(
+            stderr, "gpudecode_pipeline_create: layoutcache_pipelinelayout_get failed\n"
+        );
+        return false;
+    }
+    gpudecode->setlayout = setlayouts[0];
+
+    VkShaderModuleCreateInfo shadermodule_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pCode = (const uint32_t *) code,
+        .codeSize = code_size,
+    };
+    if (vkCreateShaderModule(
+        gpudecode->device, &shadermodule_info, nullptr, &gpudecode->shadermodule
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "gpudecode_pipeline_create: vkCreateShaderModule failed\n");
+        return false;
+    }
+
+    VkComputePipelineCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = gpudecode->shadermodule,
+            .pName = "main",
+        },
+        .layout = gpudecode->layout,
+    };
+    if (vkCreateComputePipelines(
+        gpudecode->device, VK_NULL_HANDLE, 1, &create_info, nullptr, &gpudecode->pipeline
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "gpudecode_pipeline_create: vkCreateComputePipelines failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] gpudecode
+/// @return `true` on success and `false` otherwise
+static bool gpudecode_set_allocate(struct gpudecode *gpudecode) {
+    VkDescriptorPoolCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = 1,
+        .pPoolSizes = &(VkDescriptorPoolSize){
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = GPUDECODE_BINDINGS_COUNT,
+        },
+        .poolSizeCount = 1,
+    };
+    if (vkCreateDescriptorPool(
+        gpudecode->device, &create_info, nullptr, &gpudecode->pool
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "gpudecode_set_allocate: vkCreateDescriptorPool failed\n");
+        return false;
+    }
+
+    VkDescriptorSetAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = gpudecode->pool,
+        .pSetLayouts = &gpudecode->setlayout,
+        .descriptorSetCount = 1,
+    };
+    if (vkAllocateDescriptorSets(
+        gpudecode->device, &allocate_info, &gpudecode->set
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "gpudecode_set_allocate: vkAllocateDescriptorSets failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool gpudecode_create(
+    VkDevice device,
+    struct layoutcache *layoutcache,
+    const uint8_t *code,
+    size_t code_size,
+    struct gpudecode *gpudecode
+) {
+    *gpudecode = (struct gpudecode){
+        .device = device,
+    };
+
+    if (!gpudecode_pipeline_create(gpudecode, layoutcache, code, code_size)) {
+        fprintf(stderr, "gpudecode_create: gpudecode_pipeline_create failed\n");
+        goto cleanup;
+    }
+
+    if (!gpudecode_set_allocate(gpudecode)) {
+        fprintf(stderr, "gpudecode_create: gpudecode_set_allocate failed\n");
+        goto cleanup;
+    }
+
+    return true;
+
+cleanup:
+    gpudecode_destroy(gpudecode);
+
+    return false;
+}
+
+void gpudecode_destroy(struct gpudecode *gpudecode) {
+    vkDestroyDescriptorPool(gpudecode->device, gpudecode->pool, nullptr);
+    vkDestroyPipeline(gpudecode->device, gpudecode->pipeline, nullptr);
+    vkDestroyShaderModule(gpudecode->device, gpudecode->shadermodule, nullptr);
+
+    *gpudecode = (struct gpudecode){};
+}
+
+VkDeviceSize gpudecode_buffer_size(uint64_t size) {
+    return (size + sizeof(uint32_t) - 1) / sizeof(uint32_t) * sizeof(uint32_t);
+}
+
+bool gpudecode_record(
+    struct gpudecode *gpudecode,
+    VkCommandBuffer command_buffer,
+    const struct archive_entry *entry,
+    VkBuffer source,
+    VkBuffer destination,
+    VkBuffer status
+) {
+    // Positions in the shader are 32 bits wide, and empty buffers cannot be
+    // bound
+    if (
+        entry->compression != ARCHIVE_COMPRESSION_LZ4_CHUNKED ||
+        entry->uncompressed_size == 0 ||
+        gpudecode_buffer_size(entry->size) > UINT32_MAX ||
+        gpudecode_buffer_size(entry->uncompressed_size) > UINT32_MAX
+    ) {
+        return false;
+    }
+
+    struct gpudecode_blob blob = {
+        .size = (uint32_t) entry->size,
+        .uncompressed_size = (uint32_t) entry->uncompressed_size,
+        .chunks_count = (uint32_t) (
+            (entry->uncompressed_size + ARCHIVE_CHUNK_SIZE - 1) / ARCHIVE_CHUNK_SIZE
+        ),
+    };
+    if (entry->size < sizeof(uint32_t) * blob.chunks_count) {
+        return false;
+    }
+
+    VkDescriptorBufferInfo buffer_infos[GPUDECODE_BINDINGS_COUNT] = {
+        [GPUDECODE_BINDING_SOURCE] = {
+            .buffer = source,
+            .range = gpudecode_buffer_size(entry->size),
+        },
+        [GPUDECODE_BINDING_DESTINATION] = {
+            .buffer = destination,
+            .range = gpudecode_buffer_size(entry->uncompressed_size),
+        },
+        [GPUDECODE_BINDING_STATUS] = {
+            .buffer = status,
+            .range = sizeof(uint32_t),
+        },
+    };
+    VkWriteDescriptorSet write = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = gpudecode->set,
+        .dstBinding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = GPUDECODE_BINDINGS_COUNT,
+        .pBufferInfo = buffer_infos,
+    };
+    vkUpdateDescriptorSets(gpudecode->device, 1, &write, 0, nullptr);
+
+    // Bytes are combined into their words with atomic ORs, so every word
+    // starts out zero
+    vkCmdFillBuffer(
+        command_buffer,
+        destination,
+        0,
+        buffer_infos[GPUDECODE_BINDING_DESTINATION].range,
+        0
+    );
+    vkCmdFillBuffer(command_buffer, status, 0, sizeof(uint32_t), 0);
+
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(
+        command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+
+    vkCmdBindPipeline(
+        command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, gpudecode->pipeline
+    );
+    vkCmdBindDescriptorSets(
+        command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        gpudecode->layout,
+        0,
+        1,
+        &gpudecode->set,
+        0,
+        nullptr
+    );
+    vkCmdPushConstants(
+        command_buffer,
+        gpudecode->layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(blob),
+        &blob
+    );
+    vkCmdDispatch(command_buffer, blob.chunks_count, 1, 1);
+
+    barrier = (VkMemoryBarrier){
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_HOST_READ_BIT,
+    };
+    vkCmdPipelineBarrier(
+        command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+
+    return true;
+}
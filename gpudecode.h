@@ -0,0 +1,87 @@
+#ifndef GPUDECODE_H
+#define GPUDECODE_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "archive.h"
+#include "layoutcache.h"
+
+/// `Blob` push constant block of `shaders/decompress.glsl`
+struct gpudecode_blob {
+    uint32_t size;
+    uint32_t uncompressed_size;
+    uint32_t chunks_count;
+};
+
+/// Compute pipeline that decompresses `ARCHIVE_COMPRESSION_LZ4_CHUNKED` blobs
+/// on the device, one workgroup per chunk, so that compressed assets can be
+/// uploaded as they are stored and expanded where they are used. The output
+/// is identical to `archive_decode`, which remains the fallback for devices
+/// without the pipeline and for every other compression.
+struct gpudecode {
+    VkDevice device;
+
+    VkShaderModule shadermodule;
+    /// Owned by the layout cache
+    VkPipelineLayout layout;
+    VkDescriptorSetLayout setlayout;
+    VkPipeline pipeline;
+
+    VkDescriptorPool pool;
+    VkDescriptorSet set;
+};
+
+/// @param[in] device
+/// @param[in,out] layoutcache Without set layout flags
+/// @param[in] code SPIR-V of `shaders/decompress.glsl`
+/// @param[in] code_size
+/// @param[out] gpudecode
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `gpudecode_destroy` after successful
+/// return
+bool gpudecode_create(
+    VkDevice device,
+    struct layoutcache *layoutcache,
+    const uint8_t *code,
+    size_t code_size,
+    struct gpudecode *gpudecode
+);
+
+/// @param[in,out] gpudecode
+/// @note The device must be idle
+void gpudecode_destroy(struct gpudecode *gpudecode);
+
+/// @param[in] size
+/// @return Bytes a buffer needs to hold `size` bytes for the shader, which
+/// reads and writes whole words
+VkDeviceSize gpudecode_buffer_size(uint64_t size);
+
+/// Records clearing `destination` and `status`, then decompressing `source`
+/// into `destination` and counting the chunks that failed in `status`
+/// @param[in,out] gpudecode
+/// @param[in] command_buffer Recording, on a queue that supports compute
+/// @param[in] entry
+/// @param[in] source Storage buffer holding the blob, of at least
+/// `gpudecode_buffer_size(entry->size)` bytes
+/// @param[in] destination Storage and transfer destination buffer of at least
+/// `gpudecode_buffer_size(entry->uncompressed_size)` bytes
+/// @param[in] status Storage and transfer destination buffer of at least four
+/// bytes, a `uint32_t` that is zero after execution on success
+/// @return `true` on success and `false` if `entry` cannot be decompressed on
+/// the device, in which case nothing is recorded
+/// @note Writes to `source` before the command buffer are made visible to the
+/// shader, and `destination` is made visible to every later command
+/// @note Rewrites the one descriptor set, so command buffers recorded earlier
+/// must have finished executing
+bool gpudecode_record(
+    struct gpudecode *gpudecode,
+    VkCommandBuffer command_buffer,
+    const struct archive_entry *entry,
+    VkBuffer source,
+    VkBuffer destination,
+    VkBuffer status
+);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr uint64_t HASH_SEED = 0xcbf29ce484222325u;
+
+/// 64-bit FNV-1a
+/// @param[in] data
+/// @param[in] size
+/// @param[in] hash `HASH_SEED`, or the result of a previous call to chain
+/// several buffers into one hash
+/// @return Updated hash
+static inline uint64_t hash_bytes(const void *data, size_t size, uint64_t hash) {
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3u;
+    }
+
+    return hash;
+}
+
+#endif
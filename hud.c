@@ -0,0 +1,407 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hud.h"
+#include "stats.h"
+
+constexpr char HUD_GLYPH_FIRST = ' ';
+constexpr uint32_t HUD_FONT_WIDTH = 5;
+constexpr uint32_t HUD_FONT_HEIGHT = 7;
+
+/// Rows of every glyph top to bottom, the leftmost pixel in bit 4
+static const uint8_t HUD_FONT[HUD_GLYPHS_COUNT][HUD_FONT_HEIGHT] = {
+    [' ' - HUD_GLYPH_FIRST] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    ['!' - HUD_GLYPH_FIRST] = {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04},
+    ['"' - HUD_GLYPH_FIRST] = {0x0a, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00},
+    ['#' - HUD_GLYPH_FIRST] = {0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a},
+    ['$' - HUD_GLYPH_FIRST] = {0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04},
+    ['%' - HUD_GLYPH_FIRST] = {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03},
+    ['&' - HUD_GLYPH_FIRST] = {0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d},
+    ['\'' - HUD_GLYPH_FIRST] = {0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00},
+    ['(' - HUD_GLYPH_FIRST] = {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02},
+    [')' - HUD_GLYPH_FIRST] = {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08},
+    ['*' - HUD_GLYPH_FIRST] = {0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00},
+    ['+' - HUD_GLYPH_FIRST] = {0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00},
+    [',' - HUD_GLYPH_FIRST] = {0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08},
+    ['-' - HUD_GLYPH_FIRST] = {0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00},
+    ['.' - HUD_GLYPH_FIRST] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c},
+    ['/' - HUD_GLYPH_FIRST] = {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00},
+    ['0' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e},
+    ['1' - HUD_GLYPH_FIRST] = {0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e},
+    ['2' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f},
+    ['3' - HUD_GLYPH_FIRST] = {0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e},
+    ['4' - HUD_GLYPH_FIRST] = {0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02},
+    ['5' - HUD_GLYPH_FIRST] = {0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e},
+    ['6' - HUD_GLYPH_FIRST] = {0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e},
+    ['7' - HUD_GLYPH_FIRST] = {0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},
+    ['8' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e},
+    ['9' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c},
+    [':' - HUD_GLYPH_FIRST] = {0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00},
+    [';' - HUD_GLYPH_FIRST] = {0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08},
+    ['<' - HUD_GLYPH_FIRST] = {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02},
+    ['=' - HUD_GLYPH_FIRST] = {0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00},
+    ['>' - HUD_GLYPH_FIRST] = {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08},
+    ['?' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04},
+    ['@' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e},
+    ['A' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11},
+    ['B' - HUD_GLYPH_FIRST] = {0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e},
+    ['C' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e},
+    ['D' - HUD_GLYPH_FIRST] = {0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c},
+    ['E' - HUD_GLYPH_FIRST] = {0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f},
+    ['F' - HUD_GLYPH_FIRST] = {0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10},
+    ['G' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f},
+    ['H' - HUD_GLYPH_FIRST] = {0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11},
+    ['I' - HUD_GLYPH_FIRST] = {0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e},
+    ['J' - HUD_GLYPH_FIRST] = {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c},
+    ['K' - HUD_GLYPH_FIRST] = {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},
+    ['L' - HUD_GLYPH_FIRST] = {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f},
+    ['M' - HUD_GLYPH_FIRST] = {0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11},
+    ['N' - HUD_GLYPH_FIRST] = {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11},
+    ['O' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e},
+    ['P' - HUD_GLYPH_FIRST] = {0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10},
+    ['Q' - HUD_GLYPH_FIRST] = {0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d},
+    ['R' - HUD_GLYPH_FIRST] = {0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11},
+    ['S' - HUD_GLYPH_FIRST] = {0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e},
+    ['T' - HUD_GLYPH_FIRST] = {0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},
+    ['U' - HUD_GLYPH_FIRST] = {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e},
+    ['V' - HUD_GLYPH_FIRST] = {0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04},
+    ['W' - HUD_GLYPH_FIRST] = {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a},
+    ['X' - HUD_GLYPH_FIRST] = {0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11},
+    ['Y' - HUD_GLYPH_FIRST] = {0x11, 0x11, 0x0a, 0x04, 0x04, 0x04, 0x04},
+    ['Z' - HUD_GLYPH_FIRST] = {0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f},
+    ['[' - HUD_GLYPH_FIRST] = {0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e},
+    ['\\' - HUD_GLYPH_FIRST] = {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00},
+    [']' - HUD_GLYPH_FIRST] = {0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e},
+    ['^' - HUD_GLYPH_FIRST] = {0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00},
+    ['_' - HUD_GLYPH_FIRST] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f},
+};
+
+/// Texels per font pixel in the atlas
+constexpr uint32_t HUD_SDF_SCALE = 4;
+/// Font pixels around every glyph that the distance field fades out in
+constexpr uint32_t HUD_SDF_BORDER = 1;
+/// Distance in texels at which the field reaches zero or one
+constexpr float HUD_SDF_SPREAD = 4.0f;
+constexpr uint32_t HUD_GLYPH_WIDTH = (
+    (HUD_FONT_WIDTH + 2 * HUD_SDF_BORDER) * HUD_SDF_SCALE
+);
+constexpr uint32_t HUD_GLYPH_HEIGHT = (
+    (HUD_FONT_HEIGHT + 2 * HUD_SDF_BORDER) * HUD_SDF_SCALE
+);
+constexpr uint32_t HUD_SOLID_SIZE = 4;
+
+/// Screen pixels per font pixel
+constexpr float HUD_PIXEL = 2.0f;
+constexpr float HUD_ADVANCE = 6 * HUD_PIXEL;
+constexpr float HUD_LINE_HEIGHT = 10 * HUD_PIXEL;
+constexpr float HUD_MARGIN = 8.0f;
+/// Characters of a line, including the terminating null character
+constexpr size_t HUD_LINE_LENGTH = 33;
+/// Frame time at the top of the graphs, that of 30 frames per second
+constexpr uint64_t HUD_GRAPH_TIME = 1000000000 / 30;
+constexpr float HUD_GRAPH_HEIGHT = 64.0f;
+/// Width of every frame in the graphs, the bars leave a pixel between them
+constexpr float HUD_GRAPH_STEP = 3.0f;
+constexpr float HUD_WIDTH = HUD_GRAPH_STEP * HUD_HISTORY;
+constexpr size_t HUD_MAX_LINES = 4 + VK_MAX_MEMORY_HEAPS;
+/// Sprites `hud_draw` appends at most, the panel, the line at 60 frames per
+/// second, two bars per frame and the text
+constexpr size_t HUD_MAX_SPRITES = 2 + 2 * HUD_HISTORY + HUD_MAX_LINES * HUD_LINE_LENGTH;
+
+constexpr uint32_t HUD_COLOR_PANEL = 0xb0000000;
+constexpr uint32_t HUD_COLOR_TEXT = 0xffffffff;
+constexpr uint32_t HUD_COLOR_LINE = 0x80ffffff;
+constexpr uint32_t HUD_COLOR_FAST = 0xff40d040;
+constexpr uint32_t HUD_COLOR_SLOW = 0xff40d0e0;
+constexpr uint32_t HUD_COLOR_SLOWER = 0xff4040e0;
+constexpr uint32_t HUD_COLOR_GPU = 0xffff9050;
+
+/// @param[in] glyph
+/// @param[in] x In font pixels, may be outside the glyph
+/// @param[in] y In font pixels, may be outside the glyph
+/// @return Whether the pixel is set
+static bool hud_font_pixel(size_t glyph, int32_t x, int32_t y) {
+    if (
+        x < 0 ||
+        y < 0 ||
+        x >= (int32_t) HUD_FONT_WIDTH ||
+        y >= (int32_t) HUD_FONT_HEIGHT
+    ) {
+        return false;
+    }
+
+    return (HUD_FONT[glyph][y] >> (HUD_FONT_WIDTH - 1 - (uint32_t) x)) & 1;
+}
+
+/// Builds the distance field of a glyph by measuring the distance from every
+/// texel to the nearest pixel of the other kind, which is cheap enough at
+/// this size to do for every texel
+/// @param[in] glyph
+/// @param[out] rgba `HUD_GLYPH_WIDTH` by `HUD_GLYPH_HEIGHT` texels, white with
+/// the distance in alpha and the edge at one half
+static void hud_glyph_build(size_t glyph, uint8_t *rgba) {
+    int32_t border = (int32_t) HUD_SDF_BORDER;
+
+    for (uint32_t ty = 0; ty < HUD_GLYPH_HEIGHT; ty++) {
+        for (uint32_t tx = 0; tx < HUD_GLYPH_WIDTH; tx++) {
+            float px = ((float) tx + 0.5f) / HUD_SDF_SCALE - (float) border;
+            float py = ((float) ty + 0.5f) / HUD_SDF_SCALE - (float) border;
+            bool inside = hud_font_pixel(
+                glyph, (int32_t) floorf(px), (int32_t) floorf(py)
+            );
+
+            float nearest = INFINITY;
+            for (int32_t y = -border; y < (int32_t) HUD_FONT_HEIGHT + border; y++) {
+                for (int32_t x = -border; x < (int32_t) HUD_FONT_WIDTH + border; x++) {
+                    if (hud_font_pixel(glyph, x, y) == inside) {
+                        continue;
+                    }
+
+                    float dx = fmaxf(fmaxf((float) x - px, px - (float) (x + 1)), 0.0f);
+                    float dy = fmaxf(fmaxf((float) y - py, py - (float) (y + 1)), 0.0f);
+                    nearest = fminf(nearest, dx * dx + dy * dy);
+                }
+            }
+
+            float distance = sqrtf(nearest) * HUD_SDF_SCALE;
+            float alpha = (
+                0.5f + (inside ? distance : -distance) / (2.0f * HUD_SDF_SPREAD)
+            );
+            alpha = fminf(fmaxf(alpha, 0.0f), 1.0f);
+
+            uint8_t *texel = &rgba[4 * ((size_t) ty * HUD_GLYPH_WIDTH + tx)];
+            texel[0] = UINT8_MAX;
+            texel[1] = UINT8_MAX;
+            texel[2] = UINT8_MAX;
+            texel[3] = (uint8_t) lrintf(alpha * UINT8_MAX);
+        }
+    }
+}
+
+bool hud_create(struct sprites *sprites, struct hud *hud) {
+    *hud = (struct hud){};
+
+    uint8_t rgba[4 * HUD_GLYPH_WIDTH * HUD_GLYPH_HEIGHT];
+    for (size_t i = 0; i < HUD_GLYPHS_COUNT; i++) {
+        hud_glyph_build(i, rgba);
+        if (!sprites_image_add(
+            sprites, HUD_GLYPH_WIDTH, HUD_GLYPH_HEIGHT, rgba, &hud->glyphs[i]
+        )) {
+            fprintf(stderr, "hud_create: sprites_image_add failed\n");
+            return false;
+        }
+    }
+
+    // Fully inside everywhere, so distance field shading keeps it opaque
+    memset(rgba, UINT8_MAX, 4 * HUD_SOLID_SIZE * HUD_SOLID_SIZE);
+    if (!sprites_image_add(sprites, HUD_SOLID_SIZE, HUD_SOLID_SIZE, rgba, &hud->solid)) {
+        fprintf(stderr, "hud_create: sprites_image_add failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in] hud
+/// @param[in,out] sprites
+/// @param[in] x
+/// @param[in] y
+/// @param[in] width
+/// @param[in] height
+/// @param[in] color
+static void hud_rect(
+    const struct hud *hud,
+    struct sprites *sprites,
+    float x,
+    float y,
+    float width,
+    float height,
+    uint32_t color
+) {
+    sprites_draw(sprites, hud->solid, x, y, width, height, color, SPRITES_BLEND_SDF);
+}
+
+/// @param[in] hud
+/// @param[in,out] sprites
+/// @param[in] x Left edge of the first character
+/// @param[in] y Top edge of the line
+/// @param[in] text
+static void hud_text(
+    const struct hud *hud, struct sprites *sprites, float x, float y, const char *text
+) {
+    // Glyph quads reach over the border the distance field fades out in
+    float border = HUD_SDF_BORDER * HUD_PIXEL;
+    float width = (float) HUD_GLYPH_WIDTH / HUD_SDF_SCALE * HUD_PIXEL;
+    float height = (float) HUD_GLYPH_HEIGHT / HUD_SDF_SCALE * HUD_PIXEL;
+
+    for (const char *c = text; *c != '\0'; c++, x += HUD_ADVANCE) {
+        char character = *c >= 'a' && *c <= 'z' ? *c - 'a' + 'A' : *c;
+        if (character == ' ') {
+            continue;
+        }
+        if (
+            character < HUD_GLYPH_FIRST ||
+            character >= HUD_GLYPH_FIRST + (int) HUD_GLYPHS_COUNT
+        ) {
+            character = '?';
+        }
+
+        sprites_draw(
+            sprites,
+            hud->glyphs[character - HUD_GLYPH_FIRST],
+            x - border,
+            y - border,
+            width,
+            height,
+            HUD_COLOR_TEXT,
+            SPRITES_BLEND_SDF
+        );
+    }
+}
+
+/// @param[in] time In nanoseconds
+/// @return `time` in milliseconds
+static double hud_milliseconds(uint64_t time) {
+    return (double) time / 1.0e6;
+}
+
+bool hud_draw(struct hud *hud, struct sprites *sprites, const struct hud_frame *frame) {
+    uint64_t start_time = stats_time_now();
+
+    // Checked once up front so that a HUD is either drawn whole or not at all
+    if (sprites->capacity - sprites->instances_count < HUD_MAX_SPRITES) {
+        fprintf(stderr, "hud_draw: out of sprites\n");
+        return false;
+    }
+    size_t instances_count = sprites->instances_count;
+
+    hud->frame_times[hud->history_next] = frame->frame_time;
+    hud->gpu_times[hud->history_next] = frame->gpu_time;
+    hud->history_next = (hud->history_next + 1) % HUD_HISTORY;
+    if (hud->history_count < HUD_HISTORY) {
+        hud->history_count++;
+    }
+
+    char lines[HUD_MAX_LINES][HUD_LINE_LENGTH];
+    size_t lines_count = 0;
+    snprintf(
+        lines[lines_count++],
+        HUD_LINE_LENGTH,
+        "FRAME %6.2f MS %6.1f FPS",
+        hud_milliseconds(frame->frame_time),
+        frame->frame_time > 0 ? 1.0e9 / (double) frame->frame_time : 0.0
+    );
+    if (frame->gpu_time > 0) {
+        snprintf(
+            lines[lines_count++],
+            HUD_LINE_LENGTH,
+            "CPU %6.2f MS GPU %6.2f MS",
+            hud_milliseconds(frame->cpu_time),
+            hud_milliseconds(frame->gpu_time)
+        );
+        snprintf(
+            lines[lines_count++],
+            HUD_LINE_LENGTH,
+            "SCENE %6.2f SPRITES %6.2f MS",
+            hud_milliseconds(frame->gpu_scene_time),
+            hud_milliseconds(frame->gpu_time - frame->gpu_scene_time)
+        );
+    } else {
+        snprintf(
+            lines[lines_count++],
+            HUD_LINE_LENGTH,
+            "CPU %6.2f MS GPU N/A",
+            hud_milliseconds(frame->cpu_time)
+        );
+    }
+    for (uint32_t i = 0; i < frame->heaps_count; i++) {
+        unsigned size = (unsigned) (frame->heap_sizes[i] >> 20);
+        unsigned usage = (unsigned) (frame->heap_usages[i] >> 20);
+        if (usage > 0) {
+            snprintf(
+                lines[lines_count++],
+                HUD_LINE_LENGTH,
+                "HEAP %u %6u / %6u MB",
+                i,
+                usage,
+                size
+            );
+        } else {
+            snprintf(lines[lines_count++], HUD_LINE_LENGTH, "HEAP %u %6u MB", i, size);
+        }
+    }
+    snprintf(
+        lines[lines_count++],
+        HUD_LINE_LENGTH,
+        "HUD %5.3f MS %4zu SPRITES",
+        hud_milliseconds(hud->cost),
+        hud->sprites_count
+    );
+
+    float x = HUD_MARGIN;
+    float y = HUD_MARGIN;
+    float text_height = HUD_LINE_HEIGHT * (float) lines_count;
+    hud_rect(
+        hud,
+        sprites,
+        x,
+        y,
+        HUD_WIDTH + 2 * HUD_MARGIN,
+        text_height + HUD_GRAPH_HEIGHT + 3 * HUD_MARGIN,
+        HUD_COLOR_PANEL
+    );
+    x += HUD_MARGIN;
+    y += HUD_MARGIN;
+
+    for (size_t i = 0; i < lines_count; i++) {
+        hud_text(hud, sprites, x, y + HUD_LINE_HEIGHT * (float) i, lines[i]);
+    }
+    y += text_height + HUD_MARGIN;
+
+    // Bars grow up from the bottom, newest on the right, with the device time
+    // of each frame over its frame time
+    float bottom = y + HUD_GRAPH_HEIGHT;
+    for (size_t i = 0; i < hud->history_count; i++) {
+        size_t index = (
+            (hud->history_next + HUD_HISTORY - hud->history_count + i) % HUD_HISTORY
+        );
+        float bar_x = x + HUD_WIDTH - HUD_GRAPH_STEP * (float) (hud->history_count - i);
+
+        uint64_t frame_time = hud->frame_times[index];
+        uint32_t color = (
+            frame_time <= HUD_GRAPH_TIME / 2 ? HUD_COLOR_FAST :
+            frame_time <= HUD_GRAPH_TIME ? HUD_COLOR_SLOW :
+            HUD_COLOR_SLOWER
+        );
+        float height = HUD_GRAPH_HEIGHT * fminf(
+            (float) frame_time / (float) HUD_GRAPH_TIME, 1.0f
+        );
+        hud_rect(
+            hud, sprites, bar_x, bottom - height, HUD_GRAPH_STEP - 1.0f, height, color
+        );
+
+        float gpu_height = HUD_GRAPH_HEIGHT * fminf(
+            (float) hud->gpu_times[index] / (float) HUD_GRAPH_TIME, 1.0f
+        );
+        if (gpu_height > 0.0f) {
+            hud_rect(
+                hud,
+                sprites,
+                bar_x,
+                bottom - gpu_height,
+                HUD_GRAPH_STEP - 1.0f,
+                gpu_height,
+                HUD_COLOR_GPU
+            );
+        }
+    }
+    hud_rect(
+        hud, sprites, x, y + HUD_GRAPH_HEIGHT / 2, HUD_WIDTH, 1.0f, HUD_COLOR_LINE
+    );
+
+    hud->sprites_count = sprites->instances_count - instances_count;
+    hud->cost = stats_time_now() - start_time;
+
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "sprites.h"
+
+/// Printable ASCII from space to underscore, lowercase letters are drawn as
+/// uppercase ones
+constexpr size_t HUD_GLYPHS_COUNT = 64;
+/// Frames the graphs reach back
+constexpr size_t HUD_HISTORY = 128;
+
+/// What the HUD shows of a frame, all times in nanoseconds
+struct hud_frame {
+    /// Between the presents of the frame and the one before it
+    uint64_t frame_time;
+    /// From acquiring the swapchain image to submitting
+    uint64_t cpu_time;
+    /// Zero when the device does not write timestamps
+    uint64_t gpu_time;
+    /// Device time until the scene was drawn, before the sprites
+    uint64_t gpu_scene_time;
+
+    uint32_t heaps_count;
+    VkDeviceSize heap_sizes[VK_MAX_MEMORY_HEAPS];
+    /// Zero without `VK_EXT_memory_budget`
+    VkDeviceSize heap_usages[VK_MAX_MEMORY_HEAPS];
+};
+
+/// Frame statistics drawn over everything else as sprites. Text is drawn from
+/// signed distance fields of an embedded bitmap font, built into the sprite
+/// atlas when the HUD is created, so text, graphs and the panel behind them
+/// all end up in the one instanced draw of `SPRITES_BLEND_SDF`.
+struct hud {
+    /// Nothing is drawn or measured otherwise
+    bool enabled;
+
+    /// Sprite images of the glyphs, from space on
+    uint32_t glyphs[HUD_GLYPHS_COUNT];
+    /// Opaque sprite image the panel and graphs are drawn with
+    uint32_t solid;
+
+    /// Times of the last `HUD_HISTORY` frames, `history_next` being the oldest
+    /// once the graphs are full
+    uint64_t frame_times[HUD_HISTORY];
+    uint64_t gpu_times[HUD_HISTORY];
+    size_t history_next;
+    size_t history_count;
+
+    /// Host time the last `hud_draw` took
+    uint64_t cost;
+    /// Sprites the last `hud_draw` appended
+    size_t sprites_count;
+};
+
+/// Builds the glyphs and adds them to the sprite atlas
+/// @param[in,out] sprites
+/// @param[out] hud Disabled
+/// @return `true` on success and `false` otherwise
+/// @note The images stay in the atlas for as long as `sprites` lives, there is
+/// nothing to destroy
+bool hud_create(struct sprites *sprites, struct hud *hud);
+
+/// Adds `frame` to the graphs and appends the HUD to the current frame of
+/// `sprites`, along with what the previous call cost
+/// @param[in,out] hud
+/// @param[in,out] sprites
+/// @param[in] frame
+/// @return `true` on success and `false` if `sprites` ran out of capacity
+bool hud_draw(struct hud *hud, struct sprites *sprites, const struct hud_frame *frame);
+
+#endif
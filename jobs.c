@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "jobs.h"
+
+constexpr size_t JOBS_INITIAL_QUEUE_CAPACITY = 256;
+
+static thread_local size_t jobs_worker_index_value;
+
+struct jobs_worker_start {
+    struct jobs *jobs;
+    size_t index;
+};
+
+/// @param[in,out] jobs
+/// @param[out] job
+/// @return `true` if a job was dequeued
+/// @note Caller must hold `jobs->mutex`
+static bool jobs_queue_pop(struct jobs *jobs, struct jobs_job *job) {
+    if (jobs->queue_count == 0) {
+        return false;
+    }
+
+    *job = jobs->queue[jobs->queue_head];
+    jobs->queue_head = (jobs->queue_head + 1) % jobs->queue_capacity;
+    jobs->queue_count--;
+
+    return true;
+}
+
+/// @param[in,out] jobs
+/// @param[in] job
+static void jobs_job_run(struct jobs *jobs, const struct jobs_job *job) {
+    job->function(job->argument);
+
+    if (job->counter != nullptr) {
+        atomic_fetch_sub_explicit(&job->counter->pending, 1, memory_order_release);
+    }
+
+    mtx_lock(&jobs->mutex);
+    cnd_broadcast(&jobs->job_finished);
+    mtx_unlock(&jobs->mutex);
+}
+
+static int jobs_worker_main(void *argument) {
+    struct jobs_worker_start start = *(struct jobs_worker_start *) argument;
+    free(argument);
+
+    struct jobs *jobs = start.jobs;
+    jobs_worker_index_value = start.index;
+
+    for (;;) {
+        struct jobs_job job;
+
+        mtx_lock(&jobs->mutex);
+        while (!jobs_queue_pop(jobs, &job)) {
+            if (jobs->stopping) {
+                mtx_unlock(&jobs->mutex);
+                return 0;
+            }
+            cnd_wait(&jobs->job_available, &jobs->mutex);
+        }
+        mtx_unlock(&jobs->mutex);
+
+        jobs_job_run(jobs, &job);
+    }
+}
+
+bool jobs_create(struct jobs *jobs, size_t threads_count) {
+    *jobs = (struct jobs){};
+
+    if (threads_count == 0) {
+        long processors_count = sysconf(_SC_NPROCESSORS_ONLN);
+        threads_count = processors_count > 1 ? (size_t) processors_count - 1 : 1;
+    }
+    if (threads_count > JOBS_MAX_THREADS) {
+        threads_count = JOBS_MAX_THREADS;
+    }
+
+    jobs->queue = malloc(sizeof(jobs->queue[0]) * JOBS_INITIAL_QUEUE_CAPACITY);
+    if (jobs->queue == nullptr) {
+        fprintf(stderr, "jobs_create: malloc failed\n");
+        return false;
+    }
+    jobs->queue_capacity = JOBS_INITIAL_QUEUE_CAPACITY;
+
+    if (
+        mtx_init(&jobs->mutex, mtx_plain) != thrd_success ||
+        cnd_init(&jobs->job_available) != thrd_success ||
+        cnd_init(&jobs->job_finished) != thrd_success
+    ) {
+        fprintf(stderr, "jobs_create: failed to create synchronization objects\n");
+        free(jobs->queue);
+        return false;
+    }
+
+    for (size_t i = 0; i < threads_count; i++) {
+        struct jobs_worker_start *start = malloc(sizeof(*start));
+        if (start == nullptr) {
+            fprintf(stderr, "jobs_create: malloc failed\n");
+            jobs_destroy(jobs);
+            return false;
+        }
+        *start = (struct jobs_worker_start){
+            .jobs = jobs,
+            .index = i + 1,
+        };
+
+        if (thrd_create(
+            &jobs->threads[i], jobs_worker_main, start
+        ) != thrd_success) {
+            fprintf(stderr, "jobs_create: thrd_create(%zu) failed\n", i);
+            free(start);
+            jobs_destroy(jobs);
+            return false;
+        }
+        jobs->threads_count++;
+    }
+
+    return true;
+}
+
+void jobs_destroy(struct jobs *jobs) {
+    if (jobs->queue == nullptr) {
+        return;
+    }
+
+    mtx_lock(&jobs->mutex);
+    jobs->stopping = true;
+    cnd_broadcast(&jobs->job_available);
+    mtx_unlock(&jobs->mutex);
+
+    for (size_t i = 0; i < jobs->threads_count; i++) {
+        thrd_join(jobs->threads[i], nullptr);
+    }
+
+    cnd_destroy(&jobs->job_finished);
+    cnd_destroy(&jobs->job_available);
+    mtx_destroy(&jobs->mutex);
+    free(jobs->queue);
+
+    *jobs = (struct jobs){};
+}
+
+/// @param[in,out] jobs
+/// @return `true` on success and `false` otherwise
+/// @note Caller must hold `jobs->mutex`
+static bool jobs_queue_grow(struct jobs *jobs) {
+    size_t capacity = jobs->queue_capacity * 2;
+    struct jobs_job *queue = malloc(sizeof(queue[0]) * capacity);
+    if (queue == nullptr) {
+        return false;
+    }
+
+    for (size_t i = 0; i < jobs->queue_count; i++) {
+        queue[i] = jobs->queue[(jobs->queue_head + i) % jobs->queue_capacity];
+    }
+
+    free(jobs->queue);
+    jobs->queue = queue;
+    jobs->queue_capacity = capacity;
+    jobs->queue_head = 0;
+
+    return true;
+}
+
+bool jobs_submit(
+    struct jobs *jobs,
+    jobs_function function,
+    void *argument,
+    struct jobs_counter *counter
+) {
+    mtx_lock(&jobs->mutex);
+
+    if (jobs->queue_count == jobs->queue_capacity && !jobs_queue_grow(jobs)) {
+        mtx_unlock(&jobs->mutex);
+        fprintf(stderr, "jobs_submit: failed to grow queue\n");
+        return false;
+    }
+
+    if (counter != nullptr) {
+        atomic_fetch_add_explicit(&counter->pending, 1, memory_order_relaxed);
+    }
+
+    size_t tail = (jobs->queue_head + jobs->queue_count) % jobs->queue_capacity;
+    jobs->queue[tail] = (struct jobs_job){
+        .function = function,
+        .argument = argument,
+        .counter = counter,
+    };
+    jobs->queue_count++;
+
+    cnd_signal(&jobs->job_available);
+    mtx_unlock(&jobs->mutex);
+
+    return true;
+}
+
+bool jobs_counter_done(struct jobs_counter *counter) {
+    return atomic_load_explicit(&counter->pending, memory_order_acquire) == 0;
+}
+
+void jobs_counter_wait(struct jobs *jobs, struct jobs_counter *counter) {
+    mtx_lock(&jobs->mutex);
+    while (!jobs_counter_done(counter)) {
+        struct jobs_job job;
+        if (jobs_queue_pop(jobs, &job)) {
+            mtx_unlock(&jobs->mutex);
+            jobs_job_run(jobs, &job);
+            mtx_lock(&jobs->mutex);
+        } else {
+            cnd_wait(&jobs->job_finished, &jobs->mutex);
+        }
+    }
+    mtx_unlock(&jobs->mutex);
+}
+
+size_t jobs_worker_index(void) {
+    return jobs_worker_index_value;
+}
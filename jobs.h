@@ -0,0 +1,76 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <threads.h>
+
+constexpr size_t JOBS_MAX_THREADS = 64;
+
+typedef void (*jobs_function)(void *argument);
+
+/// Number of outstanding jobs in a group. Zero-initialize before first use.
+struct jobs_counter {
+    atomic_size_t pending;
+};
+
+struct jobs_job {
+    jobs_function function;
+    void *argument;
+    struct jobs_counter *counter;
+};
+
+/// Fixed pool of worker threads fed from a single FIFO queue
+struct jobs {
+    thrd_t threads[JOBS_MAX_THREADS];
+    size_t threads_count;
+
+    mtx_t mutex;
+    cnd_t job_available;
+    cnd_t job_finished;
+
+    struct jobs_job *queue;
+    size_t queue_capacity;
+    size_t queue_head;
+    size_t queue_count;
+
+    bool stopping;
+};
+
+/// @param[out] jobs
+/// @param[in] threads_count Number of workers, zero picks one per processor
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `jobs_destroy` after successful return
+bool jobs_create(struct jobs *jobs, size_t threads_count);
+
+/// @param[in,out] jobs
+/// @note Jobs still queued are run to completion before the workers exit
+void jobs_destroy(struct jobs *jobs);
+
+/// @param[in,out] jobs
+/// @param[in] function
+/// @param[in] argument
+/// @param[in,out] counter Incremented now and decremented once the job has
+/// run, may be `nullptr`
+/// @return `true` on success and `false` otherwise
+bool jobs_submit(
+    struct jobs *jobs,
+    jobs_function function,
+    void *argument,
+    struct jobs_counter *counter
+);
+
+/// @param[in] counter
+/// @return `true` if every job submitted with `counter` has run
+bool jobs_counter_done(struct jobs_counter *counter);
+
+/// @param[in,out] jobs
+/// @param[in,out] counter
+/// @note The calling thread runs queued jobs while it waits
+void jobs_counter_wait(struct jobs *jobs, struct jobs_counter *counter);
+
+/// @return Index of the calling worker in `[1, threads_count]`, or zero when
+/// called from a thread that is not a worker
+size_t jobs_worker_index(void);
+
+#endif
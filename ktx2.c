@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ktx2.h"
+
+static const uint8_t KTX2_IDENTIFIER[12] = {
+    0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n',
+};
+
+/// `KHR_DF_MODEL_*` of the Khronos data format specification
+enum ktx2_model {
+    KTX2_MODEL_RGBSDA = 1,
+    KTX2_MODEL_BC1A = 128,
+    KTX2_MODEL_BC2 = 129,
+    KTX2_MODEL_BC3 = 130,
+    KTX2_MODEL_BC4 = 131,
+    KTX2_MODEL_BC5 = 132,
+    KTX2_MODEL_BC6H = 133,
+    KTX2_MODEL_BC7 = 134,
+};
+
+/// `KHR_DF_TRANSFER_*`
+enum ktx2_transfer {
+    KTX2_TRANSFER_LINEAR = 1,
+    KTX2_TRANSFER_SRGB = 2,
+};
+
+struct ktx2_format {
+    VkFormat format;
+    struct ktx2_block block;
+    enum ktx2_model model;
+    enum ktx2_transfer transfer;
+};
+
+static const struct ktx2_format KTX2_FORMATS[] = {
+    {VK_FORMAT_R8_UNORM, {1, 1, 1, 1}, KTX2_MODEL_RGBSDA, KTX2_TRANSFER_LINEAR},
+    {VK_FORMAT_R8_SRGB, {1, 1, 1, 1}, KTX2_MODEL_RGBSDA, KTX2_TRANSFER_SRGB},
+    {VK_FORMAT_R8G8_UNORM, {1, 1, 2, 1}, KTX2_MODEL_RGBSDA, KTX2_TRANSFER_LINEAR},
+    {VK_FORMAT_R8G8B8A8_UNORM, {1, 1, 4, 1}, KTX2_MODEL_RGBSDA, KTX2_TRANSFER_LINEAR},
+    {VK_FORMAT_R8G8B8A8_SRGB, {1, 1, 4, 1}, KTX2_MODEL_RGBSDA, KTX2_TRANSFER_SRGB},
+    {VK_FORMAT_B8G8R8A8_UNORM, {1, 1, 4, 1}, KTX2_MODEL_RGBSDA, KTX2_TRANSFER_LINEAR},
+    {VK_FORMAT_B8G8R8A8_SRGB, {1, 1, 4, 1}, KTX2_MODEL_RGBSDA, KTX2_TRANSFER_SRGB},
+    {
+        VK_FORMAT_A2B10G10R10_UNORM_PACK32,
+        {1, 1, 4, 4},
+        KTX2_MODEL_RGBSDA,
+        KTX2_TRANSFER_LINEAR,
+    },
+    {
+        VK_FORMAT_B10G11R11_UFLOAT_PACK32,
+        {1, 1, 4, 4},
+        KTX2_MODEL_RGBSDA,
+        KTX2_TRANSFER_LINEAR,
+    },
+    {VK_FORMAT_R16_SFLOAT, {1, 1, 2, 2}, KTX2_MODEL_RGBSDA, KTX2_TRANSFER_LINEAR},
+    {VK_FORMAT_R16G16_SFLOAT, {1, 1, 4, 2}, KTX2_MODEL_RGBSDA, KTX2_TRANSFER_LINEAR},
+    {
+        VK_FORMAT_R16G16B16A16_SFLOAT,
+        {1, 1, 8, 2},
+        KTX2_MODEL_RGBSDA,
+        KTX2_TRANSFER_LINEAR,
+    },
+    {VK_FORMAT_R32_SFLOAT, {1, 1, 4, 4}, KTX2_MODEL_RGBSDA, KTX2_TRANSFER_LINEAR},
+    {
+        VK_FORMAT_R32G32B32A32_SFLOAT,
+        {1, 1, 16, 4},
+        KTX2_MODEL_RGBSDA,
+        KTX2_TRANSFER_LINEAR,
+    },
+    {
+        VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+        {4, 4, 8, 1},
+        KTX2_MODEL_BC1A,
+        KTX2_TRANSFER_LINEAR,
+    },
+    {VK_FORMAT_BC1_RGBA_SRGB_BLOCK, {4, 4, 8, 1}, KTX2_MODEL_BC1A, KTX2_TRANSFER_SRGB},
+    {VK_FORMAT_BC2_UNORM_BLOCK, {4, 4, 16, 1}, KTX2_MODEL_BC2, KTX2_TRANSFER_LINEAR},
+    {VK_FORMAT_BC2_SRGB_BLOCK, {4, 4, 16, 1}, KTX2_MODEL_BC2, KTX2_TRANSFER_SRGB},
+    {VK_FORMAT_BC3_UNORM_BLOCK, {4, 4, 16, 1}, KTX2_MODEL_BC3, KTX2_TRANSFER_LINEAR},
+    {VK_FORMAT_BC3_SRGB_BLOCK, {4, 4, 16, 1}, KTX2_MODEL_BC3, KTX2_TRANSFER_SRGB},
+    {VK_FORMAT_BC4_UNORM_BLOCK, {4, 4, 8, 1}, KTX2_MODEL_BC4, KTX2_TRANSFER_LINEAR},
+    {VK_FORMAT_BC5_UNORM_BLOCK, {4, 4, 16, 1}, KTX2_MODEL_BC5, KTX2_TRANSFER_LINEAR},
+    {
+        VK_FORMAT_BC6H_UFLOAT_BLOCK,
+        {4, 4, 16, 1},
+        KTX2_MODEL_BC6H,
+        KTX2_TRANSFER_LINEAR,
+    },
+    {VK_FORMAT_BC7_UNORM_BLOCK, {4, 4, 16, 1}, KTX2_MODEL_BC7, KTX2_TRANSFER_LINEAR},
+    {VK_FORMAT_BC7_SRGB_BLOCK, {4, 4, 16, 1}, KTX2_MODEL_BC7, KTX2_TRANSFER_SRGB},
+};
+
+/// @param[in] format
+/// @return Entry of `format` in `KTX2_FORMATS`, `nullptr` if there is none
+static const struct ktx2_format *ktx2_format_find(VkFormat format) {
+    for (size_t i = 0; i < sizeof(KTX2_FORMATS) / sizeof(KTX2_FORMATS[0]); i++) {
+        if (KTX2_FORMATS[i].format == format) {
+            return &KTX2_FORMATS[i];
+        }
+    }
+
+    return nullptr;
+}
+
+bool ktx2_format_block(VkFormat format, struct ktx2_block *block) {
+    const struct ktx2_format *entry = ktx2_format_find(format);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    *block = entry->block;
+
+    return true;
+}
+
+/// @param[in] size
+/// @param[in] level
+/// @return Size of `level` in a chain starting at `size`
+static uint32_t ktx2_level_extent(uint32_t size, uint32_t level) {
+    uint32_t extent = level < 32 ? size >> level : 0;
+
+    return extent > 0 ? extent : 1;
+}
+
+uint64_t ktx2_level_image_size(
+    const struct ktx2_block *block,
+    uint32_t width,
+    uint32_t height,
+    uint32_t depth,
+    uint32_t level
+) {
+    uint64_t blocks_x = (ktx2_level_extent(width, level) + block->width - 1) /
+        block->width;
+    uint64_t blocks_y = (ktx2_level_extent(height, level) + block->height - 1) /
+        block->height;
+
+    return blocks_x * blocks_y * ktx2_level_extent(depth, level) * block->size;
+}
+
+uint32_t ktx2_levels_max(const struct ktx2 *ktx2) {
+    uint32_t size = ktx2->width;
+    if (ktx2->height > size) {
+        size = ktx2->height;
+    }
+    if (ktx2->depth > size) {
+        size = ktx2->depth;
+    }
+
+    uint32_t levels_count = 1;
+    while (size > 1) {
+        size >>= 1;
+        levels_count++;
+    }
+
+    return levels_count;
+}
+
+/// @param[in] ktx2
+/// @param[in] level
+/// @return Bytes `level` of `ktx2` holds
+static uint64_t ktx2_level_size(const struct ktx2 *ktx2, uint32_t level) {
+    uint32_t layers_count = ktx2->layers_count > 0 ? ktx2->layers_count : 1;
+
+    return ktx2_level_image_size(
+        &ktx2->block, ktx2->width, ktx2->height, ktx2->depth, level
+    ) * layers_count * ktx2->faces_count;
+}
+
+uint64_t ktx2_level_alignment(const struct ktx2_block *block) {
+    // The least common multiple of the block size and four
+    uint32_t alignment = block->size;
+    while (alignment % 4 != 0) {
+        alignment += block->size;
+    }
+
+    return alignment;
+}
+
+bool ktx2_parse(const uint8_t *content, size_t content_size, struct ktx2 *ktx2) {
+    *ktx2 = (struct ktx2){
+        .content = content,
+        .content_size = content_size,
+    };
+
+    struct ktx2_header header;
+    if (content_size < sizeof(header)) {
+        fprintf(stderr, "ktx2_parse: header is truncated\n");
+        return false;
+    }
+    memcpy(&header, content, sizeof(header));
+    if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        fprintf(stderr, "ktx2_parse: content is not KTX2\n");
+        return false;
+    }
+
+    ktx2->format = (VkFormat) header.format;
+    if (!ktx2_format_block(ktx2->format, &ktx2->block)) {
+        fprintf(stderr, "ktx2_parse: format (%u) is not supported\n", header.format);
+        return false;
+    }
+    if (header.supercompression != 0) {
+        fprintf(
+            stderr,
+            "ktx2_parse: supercompression (%u) is not supported\n",
+            header.supercompression
+        );
+        return false;
+    }
+
+    ktx2->width = header.width;
+    ktx2->height = header.height > 0 ? header.height : 1;
+    ktx2->depth = header.depth > 0 ? header.depth : 1;
+    ktx2->layers_count = header.layers_count;
+    ktx2->faces_count = header.faces_count;
+    ktx2->mips_generate = header.levels_count == 0;
+    ktx2->levels_count = header.levels_count > 0 ? header.levels_count : 1;
+
+    // Vulkan has no arrays of 3D images, and cube faces are square
+    if (
+        ktx2->width == 0 ||
+        (ktx2->depth > 1 && (ktx2->layers_count > 0 || header.height == 0)) ||
+        (ktx2->faces_count != 1 && ktx2->faces_count != 6) ||
+        (
+            ktx2->faces_count == 6 &&
+            (ktx2->width != ktx2->height || ktx2->depth > 1)
+        )
+    ) {
+        fprintf(stderr, "ktx2_parse: extent is invalid\n");
+        return false;
+    }
+    if (
+        ktx2->levels_count > KTX2_MAX_LEVELS ||
+        ktx2->levels_count > ktx2_levels_max(ktx2)
+    ) {
+        fprintf(
+            stderr,
+            "ktx2_parse: levels_count (%u) is out of bounds\n",
+            ktx2->levels_count
+        );
+        return false;
+    }
+
+    size_t index_size = sizeof(struct ktx2_level_index) * ktx2->levels_count;
+    if (content_size - sizeof(header) < index_size) {
+        fprintf(stderr, "ktx2_parse: level index is truncated\n");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < ktx2->levels_count; i++) {
+        struct ktx2_level_index index;
+        memcpy(&index, content + sizeof(header) + sizeof(index) * i, sizeof(index));
+
+        if (
+            index.offset > content_size ||
+            index.size > content_size - index.offset ||
+            index.size != index.uncompressed_size ||
+            index.size != ktx2_level_size(ktx2, i)
+        ) {
+            fprintf(stderr, "ktx2_parse: level %u is invalid\n", i);
+            return false;
+        }
+
+        ktx2->levels[i] = (struct ktx2_level){
+            .offset = index.offset,
+            .size = index.size,
+        };
+    }
+
+    return true;
+}
+
+/// @param[in] format
+/// @param[out] dfd Data format descriptor of `format` without samples, seven
+/// words long
+static void ktx2_dfd_write(const struct ktx2_format *format, uint8_t *dfd) {
+    const struct ktx2_block *block = &format->block;
+    uint32_t words[] = {
+        // Total size, then a basic descriptor block of version 2
+        7 * sizeof(uint32_t),
+        0,
+        2 | 24 << 16,
+        format->model | 1 << 8 | format->transfer << 16,
+        (block->width - 1) | (block->height - 1) << 8,
+        block->size,
+        0,
+    };
+
+    memcpy(dfd, words, sizeof(words));
+}
+
+bool ktx2_encode(
+    const struct ktx2 *ktx2,
+    const uint8_t *const levels[],
+    uint8_t **content,
+    size_t *content_size
+) {
+    const struct ktx2_format *format = ktx2_format_find(ktx2->format);
+    if (format == nullptr) {
+        fprintf(stderr, "ktx2_encode: format (%d) is not supported\n", ktx2->format);
+        return false;
+    }
+    if (
+        ktx2->width == 0 ||
+        ktx2->height == 0 ||
+        ktx2->depth == 0 ||
+        (ktx2->faces_count != 1 && ktx2->faces_count != 6)
+    ) {
+        fprintf(stderr, "ktx2_encode: extent is invalid\n");
+        return false;
+    }
+    if (ktx2->levels_count == 0 || ktx2->levels_count > KTX2_MAX_LEVELS) {
+        fprintf(
+            stderr,
+            "ktx2_encode: levels_count (%u) is out of bounds\n",
+            ktx2->levels_count
+        );
+        return false;
+    }
+
+    struct ktx2_header header = {
+        .format = (uint32_t) ktx2->format,
+        .type_size = format->block.type_size,
+        .width = ktx2->width,
+        .height = ktx2->height,
+        .depth = ktx2->depth > 1 ? ktx2->depth : 0,
+        .layers_count = ktx2->layers_count,
+        .faces_count = ktx2->faces_count,
+        .levels_count = ktx2->mips_generate ? 0 : ktx2->levels_count,
+        .dfd_offset = (uint32_t) (
+            sizeof(struct ktx2_header) +
+            sizeof(struct ktx2_level_index) * ktx2->levels_count
+        ),
+        .dfd_size = 7 * sizeof(uint32_t),
+    };
+    memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+
+    // Levels are stored smallest first
+    struct ktx2_level_index indices[KTX2_MAX_LEVELS];
+    uint64_t alignment = ktx2_level_alignment(&format->block);
+    uint64_t size = header.dfd_offset + header.dfd_size;
+    for (uint32_t i = ktx2->levels_count; i-- > 0;) {
+        uint64_t level_size = ktx2_level_size(ktx2, i);
+        size = (size + alignment - 1) / alignment * alignment;
+        indices[i] = (struct ktx2_level_index){
+            .offset = size,
+            .size = level_size,
+            .uncompressed_size = level_size,
+        };
+        size += level_size;
+    }
+
+    // Padding stays zeroed so that files are reproducible
+    uint8_t *data = calloc(size, 1);
+    if (data == nullptr) {
+        fprintf(stderr, "ktx2_encode: malloc failed\n");
+        return false;
+    }
+
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + sizeof(header), indices, sizeof(indices[0]) * ktx2->levels_count);
+    ktx2_dfd_write(format, data + header.dfd_offset);
+    for (uint32_t i = 0; i < ktx2->levels_count; i++) {
+        memcpy(data + indices[i].offset, levels[i], indices[i].size);
+    }
+
+    *content = data;
+    *content_size = size;
+
+    return true;
+}
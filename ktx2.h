@@ -0,0 +1,136 @@
+#ifndef KTX2_H
+#define KTX2_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+/// Enough for a 32768 pixel wide mip chain
+constexpr uint8_t KTX2_MAX_LEVELS = 16;
+
+/// Fixed part of a KTX2 file, followed by one `ktx2_level_index` per level.
+/// All integers are little endian.
+struct ktx2_header {
+    uint8_t identifier[12];
+    uint32_t format;
+    uint32_t type_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t layers_count;
+    uint32_t faces_count;
+    uint32_t levels_count;
+    uint32_t supercompression;
+    uint32_t dfd_offset;
+    uint32_t dfd_size;
+    uint32_t kvd_offset;
+    uint32_t kvd_size;
+    uint64_t sgd_offset;
+    uint64_t sgd_size;
+};
+
+struct ktx2_level_index {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t uncompressed_size;
+};
+
+/// Texels of a format that are stored together
+struct ktx2_block {
+    uint32_t width;
+    uint32_t height;
+    /// Bytes per block
+    uint32_t size;
+    /// Bytes per component for the byte order of the file, one for
+    /// compressed formats
+    uint32_t type_size;
+};
+
+/// Mip level of a KTX2 file. Holds every layer, then every face, then every
+/// depth slice of the level, tightly packed.
+struct ktx2_level {
+    /// From the start of the file
+    uint64_t offset;
+    uint64_t size;
+};
+
+/// KTX2 file in memory, usually a mapping of the file. Only files without
+/// supercompression are supported, so that every level can be copied into a
+/// staging buffer as it is.
+struct ktx2 {
+    const uint8_t *content;
+    size_t content_size;
+
+    VkFormat format;
+    struct ktx2_block block;
+    uint32_t width;
+    /// At least one, 1D textures are loaded as 2D textures of one row
+    uint32_t height;
+    /// At least one, also for 1D and 2D textures
+    uint32_t depth;
+    /// Zero unless the texture is an array
+    uint32_t layers_count;
+    /// Six for cube maps, one otherwise
+    uint32_t faces_count;
+    /// Set when the file asks for its mip chain to be generated after loading,
+    /// `levels` then only holds the base level
+    bool mips_generate;
+    /// Largest level first
+    struct ktx2_level levels[KTX2_MAX_LEVELS];
+    uint32_t levels_count;
+};
+
+/// @param[in] format
+/// @param[out] block
+/// @return `true` if `format` is one of the formats textures are loaded in
+bool ktx2_format_block(VkFormat format, struct ktx2_block *block);
+
+/// @param[in] block
+/// @param[in] width
+/// @param[in] height
+/// @param[in] depth
+/// @param[in] level
+/// @return Bytes of one image of `level` in a chain starting at the given size
+uint64_t ktx2_level_image_size(
+    const struct ktx2_block *block,
+    uint32_t width,
+    uint32_t height,
+    uint32_t depth,
+    uint32_t level
+);
+
+/// @param[in] block
+/// @return Alignment of every level in a file, which also suits copies from a
+/// buffer into an image
+uint64_t ktx2_level_alignment(const struct ktx2_block *block);
+
+/// @param[in] ktx2
+/// @return Number of levels in a full mip chain of the extent of `ktx2`
+uint32_t ktx2_levels_max(const struct ktx2 *ktx2);
+
+/// @param[in] content
+/// @param[in] content_size
+/// @param[out] ktx2 Points into `content`
+/// @return `true` on success and `false` otherwise
+/// @note Every level is validated against the size of `content` and against
+/// the size its format and extent call for
+bool ktx2_parse(const uint8_t *content, size_t content_size, struct ktx2 *ktx2);
+
+/// @param[in] ktx2 `content` and the level offsets are ignored, every level
+/// must have the size its format and extent call for
+/// @param[in] levels Data of each level
+/// @param[out] content
+/// @param[out] content_size
+/// @return `true` on success and `false` otherwise
+/// @note The data format descriptor only carries the color model and
+/// transfer function, readers take everything else from the format
+/// @note Caller is responsible to free `content` after successful return
+bool ktx2_encode(
+    const struct ktx2 *ktx2,
+    const uint8_t *const levels[],
+    uint8_t **content,
+    size_t *content_size
+);
+
+#endif
@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+#include "layoutcache.h"
+
+void layoutcache_create(
+    VkDevice device,
+    VkDescriptorSetLayoutCreateFlags setlayout_flags,
+    struct layoutcache *layoutcache
+) {
+    *layoutcache = (struct layoutcache){
+        .device = device,
+        .setlayout_flags = setlayout_flags,
+    };
+}
+
+void layoutcache_destroy(struct layoutcache *layoutcache) {
+    for (size_t i = 0; i < layoutcache->pipelinelayouts_count; i++) {
+        vkDestroyPipelineLayout(
+            layoutcache->device, layoutcache->pipelinelayouts[i].layout, nullptr
+        );
+    }
+    for (size_t i = 0; i < layoutcache->setlayouts_count; i++) {
+        vkDestroyDescriptorSetLayout(
+            layoutcache->device, layoutcache->setlayouts[i].setlayout, nullptr
+        );
+    }
+    free(layoutcache->pipelinelayouts);
+    free(layoutcache->setlayouts);
+
+    *layoutcache = (struct layoutcache){};
+}
+
+/// @param[in,out] array
+/// @param[in] element_size
+/// @param[in] count
+/// @param[in,out] capacity
+/// @return `true` if `array` has room for one more element
+static bool layoutcache_reserve(
+    void **array, size_t element_size, size_t count, size_t *capacity
+) {
+    if (count < *capacity) {
+        return true;
+    }
+
+    size_t new_capacity = *capacity * 2 + 8;
+    void *new_array = realloc(*array, element_size * new_capacity);
+    if (new_array == nullptr) {
+        return false;
+    }
+
+    *array = new_array;
+    *capacity = new_capacity;
+
+    return true;
+}
+
+/// @param[in] bindings
+/// @param[in] bindings_count
+/// @return Structural hash, `pImmutableSamplers` is not supported
+static uint64_t layoutcache_bindings_hash(
+    const VkDescriptorSetLayoutBinding *bindings, uint32_t bindings_count
+) {
+    uint64_t hash = HASH_SEED;
+    for (uint32_t i = 0; i < bindings_count; i++) {
+        hash = hash_bytes(&bindings[i].binding, sizeof(bindings[i].binding), hash);
+        hash = hash_bytes(
+            &bindings[i].descriptorType, sizeof(bindings[i].descriptorType), hash
+        );
+        hash = hash_bytes(
+            &bindings[i].descriptorCount, sizeof(bindings[i].descriptorCount), hash
+        );
+        hash = hash_bytes(&bindings[i].stageFlags, sizeof(bindings[i].stageFlags), hash);
+    }
+
+    return hash;
+}
+
+/// @param[in] lhs
+/// @param[in] rhs
+/// @param[in] bindings_count
+/// @return `true` if both binding lists describe the same layout
+static bool layoutcache_bindings_equal(
+    const VkDescriptorSetLayoutBinding *lhs,
+    const VkDescriptorSetLayoutBinding *rhs,
+    uint32_t bindings_count
+) {
+    for (uint32_t i = 0; i < bindings_count; i++) {
+        if (
+            lhs[i].binding != rhs[i].binding ||
+            lhs[i].descriptorType != rhs[i].descriptorType ||
+            lhs[i].descriptorCount != rhs[i].descriptorCount ||
+            lhs[i].stageFlags != rhs[i].stageFlags
+        ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool layoutcache_setlayout_get(
+    struct layoutcache *layoutcache,
+    const VkDescriptorSetLayoutBinding *bindings,
+    uint32_t bindings_count,
+    VkDescriptorSetLayout *setlayout
+) {
+    if (bindings_count > SPIRV_MAX_BINDINGS) {
+        fprintf(stderr, "layoutcache_setlayout_get: too many bindings\n");
+        return false;
+    }
+
+    uint64_t hash = layoutcache_bindings_hash(bindings, bindings_count);
+
+    for (size_t i = 0; i < layoutcache->setlayouts_count; i++) {
+        const struct layoutcache_setlayout *entry = &layoutcache->setlayouts[i];
+        if (
+            entry->hash == hash &&
+            entry->bindings_count == bindings_count &&
+            layoutcache_bindings_equal(entry->bindings, bindings, bindings_count)
+        ) {
+            *setlayout = entry->setlayout;
+            return true;
+        }
+    }
+
+    if (!layoutcache_reserve(
+        (void **) &layoutcache->setlayouts,
+        sizeof(layoutcache->setlayouts[0]),
+        layoutcache->setlayouts_count,
+        &layoutcache->setlayouts_capacity
+    )) {
+        fprintf(stderr, "layoutcache_setlayout_get: realloc failed\n");
+        return false;
+    }
+
+    struct layoutcache_setlayout *entry = (
+        &layoutcache->setlayouts[layoutcache->setlayouts_count]
+    );
+    *entry = (struct layoutcache_setlayout){
+        .hash = hash,
+        .bindings_count = bindings_count,
+    };
+    if (bindings_count > 0) {
+        memcpy(entry->bindings, bindings, sizeof(bindings[0]) * bindings_count);
+    }
+
+    VkDescriptorSetLayoutCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .flags = layoutcache->setlayout_flags,
+        .pBindings = entry->bindings,
+        .bindingCount = bindings_count,
+    };
+
+    if (vkCreateDescriptorSetLayout(
+        layoutcache->device, &create_info, nullptr, &entry->setlayout
+    ) != VK_SUCCESS) {
+        fprintf(
+            stderr, "layoutcache_setlayout_get: vkCreateDescriptorSetLayout failed\n"
+        );
+        return false;
+    }
+    layoutcache->setlayouts_count++;
+
+    *setlayout = entry->setlayout;
+
+    return true;
+}
+
+bool layoutcache_pipelinelayout_get(
+    struct layoutcache *layoutcache,
+    const struct spirv_reflection *reflection,
+    VkPipelineLayout *layout,
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS],
+    uint32_t *setlayouts_count
+) {
+    struct layoutcache_pipelinelayout key = {
+        .push_constants = reflection->push_constants,
+    };
+
+    // Bindings are sorted by set, so each set is a contiguous run
+    uint32_t first = 0;
+    while (first < reflection->bindings_count) {
+        uint32_t set = reflection->bindings[first].set;
+        if (set >= LAYOUTCACHE_MAX_SETS) {
+            fprintf(
+                stderr, "layoutcache_pipelinelayout_get: set %u is out of bounds\n", set
+            );
+            return false;
+        }
+
+        VkDescriptorSetLayoutBinding bindings[SPIRV_MAX_BINDINGS];
+        uint32_t bindings_count = 0;
+        for (
+            uint32_t i = first;
+            i < reflection->bindings_count && reflection->bindings[i].set == set;
+            i++
+        ) {
+            const struct spirv_binding *binding = &reflection->bindings[i];
+            bindings[bindings_count++] = (VkDescriptorSetLayoutBinding){
+                .binding = binding->binding,
+                .descriptorType = binding->type,
+                .descriptorCount = binding->count,
+                .stageFlags = binding->stages,
+            };
+        }
+
+        // Sets skipped by the shaders still need a layout, an empty one
+        for (uint32_t i = key.setlayouts_count; i < set; i++) {
+            if (!layoutcache_setlayout_get(
+                layoutcache, nullptr, 0, &key.setlayouts[i]
+            )) {
+                return false;
+            }
+        }
+
+        if (!layoutcache_setlayout_get(
+            layoutcache, bindings, bindings_count, &key.setlayouts[set]
+        )) {
+            return false;
+        }
+        key.setlayouts_count = set + 1;
+
+        first += bindings_count;
+    }
+
+    uint64_t hash = HASH_SEED;
+    hash = hash_bytes(
+        key.setlayouts, sizeof(key.setlayouts[0]) * key.setlayouts_count, hash
+    );
+    hash = hash_bytes(&key.push_constants.stageFlags, sizeof(uint32_t), hash);
+    hash = hash_bytes(&key.push_constants.offset, sizeof(uint32_t), hash);
+    hash = hash_bytes(&key.push_constants.size, sizeof(uint32_t), hash);
+    key.hash = hash;
+
+    if (setlayouts != nullptr) {
+        memcpy(setlayouts, key.setlayouts, sizeof(key.setlayouts[0]) * key.setlayouts_count);
+    }
+    if (setlayouts_count != nullptr) {
+        *setlayouts_count = key.setlayouts_count;
+    }
+
+    for (size_t i = 0; i < layoutcache->pipelinelayouts_count; i++) {
+        const struct layoutcache_pipelinelayout *entry = &layoutcache->pipelinelayouts[i];
+        if (
+            entry->hash == key.hash &&
+            entry->setlayouts_count == key.setlayouts_count &&
+            memcmp(
+                entry->setlayouts,
+                key.setlayouts,
+                sizeof(key.setlayouts[0]) * key.setlayouts_count
+            ) == 0 &&
+            entry->push_constants.stageFlags == key.push_constants.stageFlags &&
+            entry->push_constants.offset == key.push_constants.offset &&
+            entry->push_constants.size == key.push_constants.size
+        ) {
+            *layout = entry->layout;
+            return true;
+        }
+    }
+
+    if (!layoutcache_reserve(
+        (void **) &layoutcache->pipelinelayouts,
+        sizeof(layoutcache->pipelinelayouts[0]),
+        layoutcache->pipelinelayouts_count,
+        &layoutcache->pipelinelayouts_capacity
+    )) {
+        fprintf(stderr, "layoutcache_pipelinelayout_get: realloc failed\n");
+        return false;
+    }
+
+    VkPipelineLayoutCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pSetLayouts = key.setlayouts,
+        .setLayoutCount = key.setlayouts_count,
+        .pPushConstantRanges = &key.push_constants,
+        .pushConstantRangeCount = key.push_constants.size != 0 ? 1 : 0,
+    };
+
+    if (vkCreatePipelineLayout(
+        layoutcache->device, &create_info, nullptr, &key.layout
+    ) != VK_SUCCESS) {
+        fprintf(
+            stderr, "layoutcache_pipelinelayout_get: vkCreatePipelineLayout failed\n"
+        );
+        return false;
+    }
+
+    layoutcache->pipelinelayouts[layoutcache->pipelinelayouts_count++] = key;
+    *layout = key.layout;
+
+    return true;
+}
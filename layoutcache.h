@@ -0,0 +1,91 @@
+#ifndef LAYOUTCACHE_H
+#define LAYOUTCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "spirv.h"
+
+constexpr uint8_t LAYOUTCACHE_MAX_SETS = 4;
+
+struct layoutcache_setlayout {
+    uint64_t hash;
+    VkDescriptorSetLayoutBinding bindings[SPIRV_MAX_BINDINGS];
+    uint32_t bindings_count;
+
+    VkDescriptorSetLayout setlayout;
+};
+
+struct layoutcache_pipelinelayout {
+    uint64_t hash;
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS];
+    uint32_t setlayouts_count;
+    VkPushConstantRange push_constants;
+
+    VkPipelineLayout layout;
+};
+
+/// Descriptor set layouts and pipeline layouts deduplicated by their
+/// structure, so programs with the same interface share the same objects
+struct layoutcache {
+    VkDevice device;
+    /// Every set layout is created with these flags
+    VkDescriptorSetLayoutCreateFlags setlayout_flags;
+
+    struct layoutcache_setlayout *setlayouts;
+    size_t setlayouts_count;
+    size_t setlayouts_capacity;
+
+    struct layoutcache_pipelinelayout *pipelinelayouts;
+    size_t pipelinelayouts_count;
+    size_t pipelinelayouts_capacity;
+};
+
+/// @param[in] device
+/// @param[in] setlayout_flags E.g.
+/// `VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT`
+/// @param[out] layoutcache
+/// @note Caller is responsible to call `layoutcache_destroy` after
+/// `layoutcache` is no longer needed
+void layoutcache_create(
+    VkDevice device,
+    VkDescriptorSetLayoutCreateFlags setlayout_flags,
+    struct layoutcache *layoutcache
+);
+
+/// @param[in,out] layoutcache
+/// @note Every layout handed out by `layoutcache` becomes invalid
+void layoutcache_destroy(struct layoutcache *layoutcache);
+
+/// @param[in,out] layoutcache
+/// @param[in] bindings Sorted by binding number
+/// @param[in] bindings_count
+/// @param[out] setlayout
+/// @return `true` on success and `false` otherwise
+/// @note `setlayout` is owned by `layoutcache`
+bool layoutcache_setlayout_get(
+    struct layoutcache *layoutcache,
+    const VkDescriptorSetLayoutBinding *bindings,
+    uint32_t bindings_count,
+    VkDescriptorSetLayout *setlayout
+);
+
+/// @param[in,out] layoutcache
+/// @param[in] reflection Merged interface of every stage of a program
+/// @param[out] layout
+/// @param[out] setlayouts May be `nullptr`, otherwise receives one set layout
+/// per set up to the highest set used
+/// @param[out] setlayouts_count May be `nullptr`
+/// @return `true` on success and `false` otherwise
+/// @note `layout` is owned by `layoutcache`
+bool layoutcache_pipelinelayout_get(
+    struct layoutcache *layoutcache,
+    const struct spirv_reflection *reflection,
+    VkPipelineLayout *layout,
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS],
+    uint32_t *setlayouts_count
+);
+
+#endif
@@ -0,0 +1,254 @@
+#include <string.h>
+
+#include "lz4.h"
+
+constexpr size_t LZ4_MIN_MATCH = 4;
+/// The last match has to start this many bytes before the end of the block
+constexpr size_t LZ4_MATCH_LIMIT = 12;
+/// The last bytes of a block are always literals
+constexpr size_t LZ4_LAST_LITERALS = 5;
+constexpr size_t LZ4_MAX_OFFSET = 65535;
+constexpr uint32_t LZ4_HASH_BITS = 12;
+
+size_t lz4_compress_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+/// @param[in] data
+/// @return Four bytes read without alignment requirements
+static uint32_t lz4_read32(const uint8_t *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+
+    return value;
+}
+
+/// @param[in,out] output
+/// @param[in] output_end
+/// @param[in] length Remainder of a length after the 15 in its token
+/// @return `true` if the length fit
+static bool lz4_length_write(
+    uint8_t **output, const uint8_t *output_end, size_t length
+) {
+    for (; length >= 255; length -= 255) {
+        if (*output == output_end) {
+            return false;
+        }
+        *(*output)++ = 255;
+    }
+    if (*output == output_end) {
+        return false;
+    }
+    *(*output)++ = (uint8_t) length;
+
+    return true;
+}
+
+/// @param[in,out] output
+/// @param[in] output_end
+/// @param[in] literals
+/// @param[in] literals_size
+/// @param[in] offset Zero for the last sequence, which has no match
+/// @param[in] match_size
+/// @return `true` if the sequence fit
+static bool lz4_sequence_write(
+    uint8_t **output,
+    const uint8_t *output_end,
+    const uint8_t *literals,
+    size_t literals_size,
+    size_t offset,
+    size_t match_size
+) {
+    if (*output == output_end) {
+        return false;
+    }
+
+    size_t match_length = offset > 0 ? match_size - LZ4_MIN_MATCH : 0;
+    uint8_t *token = (*output)++;
+    *token = (uint8_t) (
+        (literals_size < 15 ? literals_size : 15) << 4 |
+        (match_length < 15 ? match_length : 15)
+    );
+
+    if (
+        literals_size >= 15 &&
+        !lz4_length_write(output, output_end, literals_size - 15)
+    ) {
+        return false;
+    }
+    if ((size_t) (output_end - *output) < literals_size) {
+        return false;
+    }
+    memcpy(*output, literals, literals_size);
+    *output += literals_size;
+
+    if (offset == 0) {
+        return true;
+    }
+
+    if (output_end - *output < 2) {
+        return false;
+    }
+    *(*output)++ = (uint8_t) offset;
+    *(*output)++ = (uint8_t) (offset >> 8);
+
+    if (
+        match_length >= 15 &&
+        !lz4_length_write(output, output_end, match_length - 15)
+    ) {
+        return false;
+    }
+
+    return true;
+}
+
+size_t lz4_compress(
+    const uint8_t *source,
+    size_t source_size,
+    uint8_t *destination,
+    size_t destination_capacity
+) {
+    // Positions of the last occurrence of each hashed four bytes
+    uint32_t table[1u << LZ4_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    uint8_t *output = destination;
+    const uint8_t *output_end = destination + destination_capacity;
+
+    size_t anchor = 0;
+    size_t position = 1;
+    size_t limit = source_size > LZ4_MATCH_LIMIT ? source_size - LZ4_MATCH_LIMIT : 0;
+    while (position < limit) {
+        uint32_t sequence = lz4_read32(&source[position]);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = (uint32_t) position;
+
+        if (
+            position - candidate > LZ4_MAX_OFFSET ||
+            lz4_read32(&source[candidate]) != sequence
+        ) {
+            position++;
+            continue;
+        }
+
+        // Extend backwards over literals and forwards up to the last literals
+        while (
+            position > anchor &&
+            candidate > 0 &&
+            source[position - 1] == source[candidate - 1]
+        ) {
+            position--;
+            candidate--;
+        }
+        size_t match_size = LZ4_MIN_MATCH;
+        while (
+            position + match_size < source_size - LZ4_LAST_LITERALS &&
+            source[candidate + match_size] == source[position + match_size]
+        ) {
+            match_size++;
+        }
+
+        if (!lz4_sequence_write(
+            &output,
+            output_end,
+            &source[anchor],
+            position - anchor,
+            position - candidate,
+            match_size
+        )) {
+            return 0;
+        }
+
+        position += match_size;
+        anchor = position;
+    }
+
+    if (!lz4_sequence_write(
+        &output, output_end, &source[anchor], source_size - anchor, 0, 0
+    )) {
+        return 0;
+    }
+
+    return (size_t) (output - destination);
+}
+
+bool lz4_decompress(
+    const uint8_t *source,
+    size_t source_size,
+    uint8_t *destination,
+    size_t destination_size
+) {
+    const uint8_t *input = source;
+    const uint8_t *input_end = source + source_size;
+    uint8_t *output = destination;
+    const uint8_t *output_end = destination + destination_size;
+
+    while (input < input_end) {
+        uint8_t token = *input++;
+
+        size_t literals_size = token >> 4;
+        if (literals_size == 15) {
+            uint8_t byte;
+            do {
+                if (input == input_end) {
+                    return false;
+                }
+                byte = *input++;
+                literals_size += byte;
+            } while (byte == 255);
+        }
+        if (
+            literals_size > (size_t) (input_end - input) ||
+            literals_size > (size_t) (output_end - output)
+        ) {
+            return false;
+        }
+        memcpy(output, input, literals_size);
+        input += literals_size;
+        output += literals_size;
+
+        // The last sequence ends after its literals
+        if (input == input_end) {
+            break;
+        }
+
+        if (input_end - input < 2) {
+            return false;
+        }
+        size_t offset = (size_t) input[0] | (size_t) input[1] << 8;
+        input += 2;
+        if (offset == 0 || offset > (size_t) (output - destination)) {
+            return false;
+        }
+
+        size_t match_size = token & 15;
+        if (match_size == 15) {
+            uint8_t byte;
+            do {
+                if (input == input_end) {
+                    return false;
+                }
+                byte = *input++;
+                match_size += byte;
+            } while (byte == 255);
+        }
+        match_size += LZ4_MIN_MATCH;
+        if (match_size > (size_t) (output_end - output)) {
+            return false;
+        }
+
+        // Matches may overlap the bytes they produce to repeat a pattern
+        const uint8_t *match = output - offset;
+        if (offset >= match_size) {
+            memcpy(output, match, match_size);
+            output += match_size;
+        } else {
+            for (size_t i = 0; i < match_size; i++) {
+                *output++ = match[i];
+            }
+        }
+    }
+
+    return output == output_end;
+}
@@ -0,0 +1,38 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @param[in] size
+/// @return Largest size `size` bytes can compress to
+size_t lz4_compress_bound(size_t size);
+
+/// Compresses into the LZ4 block format with a single greedy pass, which is
+/// fast but compresses less than the reference high compression mode
+/// @param[in] source
+/// @param[in] source_size
+/// @param[out] destination
+/// @param[in] destination_capacity
+/// @return Compressed size, zero if it does not fit `destination_capacity`
+size_t lz4_compress(
+    const uint8_t *source,
+    size_t source_size,
+    uint8_t *destination,
+    size_t destination_capacity
+);
+
+/// @param[in] source LZ4 block, not trusted
+/// @param[in] source_size
+/// @param[out] destination
+/// @param[in] destination_size Exact decompressed size
+/// @return `true` if `source` decompressed to exactly `destination_size`
+/// bytes and `false` if it is malformed
+bool lz4_decompress(
+    const uint8_t *source,
+    size_t source_size,
+    uint8_t *destination,
+    size_t destination_size
+);
+
+#endif
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -8,83 +9,226 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include "archive.h"
+#include "bcenc.h"
+#include "buffer.h"
+#include "bvh.h"
+#include "cull.h"
+#include "debugdraw.h"
+#include "descriptors.h"
+#include "file.h"
+#include "gpucull.h"
+#include "gpudecode.h"
+#include "jobs.h"
+#include "ktx2.h"
+#include "hud.h"
+#include "layoutcache.h"
+#include "mesh.h"
+#include "meshimport.h"
+#include "meshlod.h"
+#include "mipgen.h"
+#include "occlusion.h"
+#include "pipeline.h"
+#include "samplercache.h"
+#include "shaderobjects.h"
+#include "sprites.h"
+#include "staging.h"
+#include "stats.h"
+#include "streaming.h"
+#include "texture.h"
+#include "variantcache.h"
+
 constexpr uint16_t MAX_TMP_BUFFER = 256;
 
-/// @param[in] filename
-/// @param[out] content
-/// @param[out] content_size
-/// @return `true` on success and `false` otherwise
-/// @note Caller is responsible for freeing `content` after it is no longer needed
-static bool file_read(const char *filename, uint8_t **content, size_t *content_size) {
-    bool success = false;
+constexpr uint8_t MAX_SWAPCHAIN_IMAGES = 10;
 
-    FILE *file = nullptr;
-    uint8_t *read_buffer = nullptr;
+constexpr char PIPELINE_CACHE_FILENAME[] = "./pipeline_cache.bin";
 
-    file = fopen(filename, "rb");
-    if (file == nullptr) {
-        fprintf(stderr, "file_read: fopen(\"%s\", \"rb\") failed\n", filename);
-        goto cleanup;
-    }
+/// Packed by `archivepack`, assets are read from loose files when it is missing
+constexpr char ASSETS_FILENAME[] = "./assets.pak";
 
-    if (fseek(file, 0, SEEK_END) != 0) {
-        fprintf(stderr, "file_read: fseek(fd, 0, SEEK_END) failed\n");
-        goto cleanup;
-    }
+/// Specialization constants declared by the shaders in `shaders/`
+enum shader_constant {
+    SHADER_CONSTANT_GRAYSCALE,
+    SHADER_CONSTANT_NOISE_OCTAVES,
+    /// Must match `pipeline_state::vertexformat`
+    SHADER_CONSTANT_QUANTIZED_VERTICES,
+    SHADER_CONSTANT_COUNT,
+};
 
-    size_t file_size = ftell(file);
-    if (file_size == -1) {
-        fprintf(stderr, "file_read: ftell(file) failed\n");
-        goto cleanup;
-    }
+/// Values cycled through by the `N` key
+constexpr uint32_t SHADER_NOISE_OCTAVES[] = {0, 1, 2, 4, 8};
+constexpr size_t SHADER_NOISE_OCTAVES_COUNT = (
+    sizeof(SHADER_NOISE_OCTAVES) / sizeof(SHADER_NOISE_OCTAVES[0])
+);
+
+/// Values cycled through by the `C` key
+constexpr VkCullModeFlags CULL_MODES[] = {
+    VK_CULL_MODE_BACK_BIT,
+    VK_CULL_MODE_FRONT_BIT,
+    VK_CULL_MODE_NONE,
+};
+constexpr size_t CULL_MODES_COUNT = sizeof(CULL_MODES) / sizeof(CULL_MODES[0]);
 
-    rewind(file);
+/// Every combination of constants and state the keys can switch between
+constexpr size_t SCENE_VARIANTS_COUNT = (
+    2 * SHADER_NOISE_OCTAVES_COUNT * CULL_MODES_COUNT * 2 * 2
+);
 
-    read_buffer = malloc(sizeof(uint8_t) * file_size);
-    if (read_buffer == nullptr) {
-        fprintf(stderr, "file_read: malloc failed\n");
-        goto cleanup;
-    }
+/// `Material` uniform block of `shaders/fragment.glsl`
+struct material {
+    float color[4];
+};
 
-    if (fread(read_buffer, file_size, 1, file) != 1) {
-        fprintf(stderr, "file_read: fread failed\n");
-        goto cleanup;
-    }
+/// Materials of the benchmark scene, each with a descriptor set of its own
+constexpr uint32_t MATERIALS_COUNT = 1024;
 
-    *content = read_buffer;
-    *content_size = file_size;
+/// Staging ring every upload goes through
+constexpr VkDeviceSize UPLOAD_RING_SIZE = 64 << 20;
 
-    success = true;
+/// Sprites a frame can draw, enough for the sprite benchmark
+constexpr size_t SPRITES_CAPACITY = 1 << 17;
 
-cleanup:
-    if (!success) {
-        free(read_buffer);
-    }
+/// Debug line vertices a frame can draw
+constexpr size_t DEBUGDRAW_CAPACITY = 1 << 16;
 
-    fclose(file);
+/// Resolution occluders are rasterized at on the CPU
+constexpr uint32_t OCCLUSION_WIDTH = 320;
+constexpr uint32_t OCCLUSION_HEIGHT = 180;
 
-    return success;
-}
+/// Objects that can be culled on the device at once
+constexpr size_t GPUCULL_CAPACITY = 1 << 16;
 
-constexpr uint8_t MAX_SWAPCHAIN_IMAGES = 10;
+/// Error in pixels the level of detail a mesh is drawn at may have
+constexpr float LOD_THRESHOLD = 1.0f;
+
+/// View projection of the scene, whose positions are in clip space already
+static const float VIEW_PROJECTION[16] = {
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f,
+};
+
+/// Stored bytes of an archive entry decompressed on the job system, so that
+/// frames keep being drawn meanwhile
+struct vulkan_decode {
+    struct jobs *jobs;
+    const struct archive_entry *entry;
+    /// `nullptr` when nothing is decompressed
+    uint8_t *blob;
+    /// `entry->uncompressed_size` bytes
+    uint8_t *data;
+    bool success;
+    uint64_t time;
+    struct jobs_counter counter;
+};
 
 struct vulkan {
     const char *application_name;
     bool enable_validation_layers;
+    /// Draw with `VK_EXT_shader_object` instead of pipelines where supported
+    bool shaderobjects_requested;
+    /// Set up both backends so they can be compared
+    bool benchmark;
+    /// OBJ or glTF binary file to draw instead of the triangle, may be
+    /// `nullptr`
+    const char *mesh_filename;
 
     GLFWwindow *window;
+    struct jobs *jobs;
+    /// `ASSETS_FILENAME`, empty when it is missing
+    struct archive archive;
+    struct streaming *streaming;
 
     VkInstance instance;
     VkSurfaceKHR surface;
     VkPhysicalDevice physicaldevice;
+    VkPhysicalDeviceProperties physicaldevice_properties;
+    VkPhysicalDeviceMemoryProperties memory_properties;
     VkDevice device;
     VkSwapchainKHR swapchain;
     VkRenderPass render_pass;
-    VkPipelineLayout pipeline_layout;
-    VkPipeline graphics_pipeline;
+    /// Compatible with `render_pass`, loading what `gpucull` drew instead of
+    /// clearing it
+    VkRenderPass render_pass_load;
+    struct layoutcache layoutcache;
+    /// For the descriptor sets `gpudecode`, `mipgen`, `sprites` and `gpucull`
+    /// allocate from pools. Set layouts of `layoutcache` are created for
+    /// descriptor buffers when those are supported, and descriptor sets cannot
+    /// be allocated with such layouts.
+    struct layoutcache descriptorset_layoutcache;
+    struct pipeline_program program;
+    struct variantcache variantcache;
+    struct pipeline_variant scene_variants[SCENE_VARIANTS_COUNT];
+    /// Time spent until every scene variant could be drawn
+    uint64_t variantcache_startup_time;
+
+    bool shaderobjects_supported;
+    bool shaderobjects_enabled;
+    struct shaderobjects shaderobjects;
+    uint64_t shaderobjects_startup_time;
+
+    struct buffer materials;
+    VkDescriptorBufferInfo material_uniforms[MATERIALS_COUNT];
+    /// Set `i` holds `material_uniforms[i]`
+    struct descriptors descriptors;
+    /// Materials whose descriptors are written every frame
+    uint32_t materials_count;
+
+    /// Triangle, or the mesh from `mesh_filename` once it has streamed in,
+    /// the scene is drawn with
+    struct mesh mesh;
+    /// Levels of detail in the index buffer of `mesh`, none for the triangle
+    struct meshlod mesh_lod;
+    /// Level of `mesh_lod` the last recorded frame drew
+    size_t mesh_level;
+    /// Read of `mesh_filename` still in flight, zero when there is none
+    uint64_t mesh_read;
+    uint64_t mesh_read_time;
+    /// Of the mesh read once it completed, when it is in the archive
+    struct vulkan_decode mesh_decode;
+
+    /// When non-zero each frame draws this many times, cycling through
+    /// `scene_variants` and the first `materials_count` materials instead of
+    /// drawing `variant` once
+    size_t benchmark_draws;
+    /// When set the `benchmark_draws` draw this mesh instead, all with the
+    /// same variant and material
+    const struct mesh *benchmark_mesh;
+    /// `variant` reading `VERTEXFORMAT_FLOAT32` vertices
+    struct pipeline_variant float32_variant;
+    struct pipeline_variant variant;
     VkCommandPool command_pool;
     VkCommandBuffer command_buffer;
 
+    /// Uploads are written into the ring and copied from there by the device
+    struct staging staging;
+    struct samplercache samplercache;
+    struct mipgen mipgen;
+    struct sprites sprites;
+    /// Empty in release builds
+    struct debugdraw debugdraw;
+    /// Depth of the occluders, rasterized on the CPU before each frame is
+    /// recorded so that draws hidden behind them are never emitted
+    struct occlusion occlusion;
+    /// Triangles in the space of `VIEW_PROJECTION` that hide what is behind
+    /// them, nothing is tested against `occlusion` while there are none
+    const float *occluder_positions;
+    const uint32_t *occluder_indices;
+    size_t occluder_indices_count;
+    /// Draws the last recorded frame left out as hidden
+    size_t occlusion_culled;
+    /// Objects culled against the depth of what was drawn before the scene,
+    /// on the device, nothing is drawn while there are none
+    struct gpucull gpucull;
+    /// View projection the objects of `gpucull` are culled and drawn with
+    float gpucull_view_projection[16];
+    /// Of the last completed frame that culled on the device
+    struct gpucull_counts gpucull_counts;
+    /// Whether `gpucull_counts` will be read once the frame fence signals
+    bool gpucull_pending;
+
     VkFormat swapchain_image_format;
     VkExtent2D swapchain_extent;
 
@@ -106,6 +250,49 @@ struct vulkan {
     VkSemaphore swapchain_image_available;
     VkSemaphore render_finished;
     VkFence frame_in_flight;
+    /// Staging space the frame in flight copies from, given back once its
+    /// fence signals
+    uint64_t frame_staging_serial;
+    bool frame_staging_pending;
+
+    /// Brackets the commands of each frame on the device and marks where the
+    /// scene ends, unset where the device cannot write timestamps
+    VkQueryPool timestamps;
+    /// Whether frames write `timestamps`, only while they are looked at
+    bool timestamps_enabled;
+    /// Whether `timestamps` will hold results once the frame fence signals
+    bool timestamps_pending;
+    /// Device time of the last completed frame in nanoseconds
+    uint64_t gpu_time;
+    /// Part of `gpu_time` until the scene was drawn, before the sprites
+    uint64_t gpu_scene_time;
+
+    /// Lets the HUD show how much of each heap is in use
+    bool memory_budget_supported;
+
+    bool present_wait_supported;
+    PFN_vkWaitForPresentKHR vkWaitForPresentKHR;
+
+    bool pipeline_library_supported;
+
+    bool storageimage_write_supported;
+
+    bool texturecompression_bc_supported;
+
+    /// Draws issued with `vkCmdDrawIndirectCountKHR` and a depth buffer that
+    /// can be sampled, which `gpucull` needs
+    bool gpucull_supported;
+
+    bool descriptorbuffer_supported;
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorbuffer_properties;
+
+    /// Mask of `pipeline_dynamic` supported by the device
+    uint32_t pipeline_dynamic;
+    PFN_vkCmdSetPrimitiveTopologyEXT vkCmdSetPrimitiveTopologyEXT;
+    PFN_vkCmdSetCullModeEXT vkCmdSetCullModeEXT;
+    PFN_vkCmdSetFrontFaceEXT vkCmdSetFrontFaceEXT;
+    PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonModeEXT;
+    PFN_vkCmdSetColorBlendEnableEXT vkCmdSetColorBlendEnableEXT;
 };
 
 /// @param[in] validation_layers
@@ -171,7 +358,7 @@ static bool vulkan_instance_create(struct vulkan *vulkan) {
         .pApplicationName = vulkan->application_name,
         .applicationVersion = VK_MAKE_VERSION(0, 1, 0),
         .pEngineName = "No engine",
-        .apiVersion = VK_API_VERSION_1_0,
+        .apiVersion = VK_API_VERSION_1_1,
     };
 
     VkInstanceCreateInfo create_info = {
@@ -232,6 +419,12 @@ static bool vulkan_physicaldevice_find(struct vulkan *vulkan) {
     vkEnumeratePhysicalDevices(vulkan->instance, &device_count, devices);
 
     vulkan->physicaldevice = devices[0];
+    vkGetPhysicalDeviceProperties(
+        vulkan->physicaldevice, &vulkan->physicaldevice_properties
+    );
+    vkGetPhysicalDeviceMemoryProperties(
+        vulkan->physicaldevice, &vulkan->memory_properties
+    );
 
     return true;
 }
@@ -256,9 +449,12 @@ static bool vulkan_queuefamily_find(struct vulkan *vulkan) {
         vulkan->physicaldevice, &queuefamily_count, queuefamilies
     );
 
+    // Compute work is recorded alongside the frame, and a family supporting
+    // both is guaranteed wherever there is one supporting graphics
+    constexpr VkQueueFlags graphics_flags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
     bool found_graphics_queuefamily = false;
     for (uint32_t i = 0; i < queuefamily_count; i++) {
-        if (queuefamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        if ((queuefamilies[i].queueFlags & graphics_flags) == graphics_flags) {
             vulkan->graphics_queuefamily_index = i;
             found_graphics_queuefamily = true;
             break;
@@ -282,6 +478,24 @@ static bool vulkan_queuefamily_find(struct vulkan *vulkan) {
     return found_graphics_queuefamily && found_present_queuefamily;
 }
 
+/// @param[in] available_extensions
+/// @param[in] available_extensions_count
+/// @param[in] extension_name
+/// @return `true` if `extension_name` is among `available_extensions`
+static bool vulkan_extension_find(
+    const VkExtensionProperties available_extensions[],
+    size_t available_extensions_count,
+    const char *extension_name
+) {
+    for (size_t i = 0; i < available_extensions_count; i++) {
+        if (strcmp(available_extensions[i].extensionName, extension_name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /// @param[in,out] vulkan
 /// @return `true` on success and `false` otherwise
 static bool vulkan_device_create(struct vulkan *vulkan) {
@@ -330,34 +544,317 @@ static bool vulkan_device_create(struct vulkan *vulkan) {
         vulkan->physicaldevice, nullptr, &extension_count, available_extensions
     );
 
-    bool found_swapchain_extension = false;
-    for (uint32_t i = 0; i < extension_count; i++) {
-        if (strcmp(
-            available_extensions[i].extensionName,
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME
-        ) == 0) {
-            found_swapchain_extension = true;
-        }
-    }
-    if (!found_swapchain_extension) {
+    if (!vulkan_extension_find(
+        available_extensions, extension_count, VK_KHR_SWAPCHAIN_EXTENSION_NAME
+    )) {
         fprintf(
             stderr, "vulkan_device_create: swapchain extension not found\n"
         );
         return false;
     }
 
-    const char *device_extensions[] = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+    const char *device_extensions[MAX_TMP_BUFFER];
+    size_t device_extensions_count = 0;
+    device_extensions[device_extensions_count++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+
+    VkPhysicalDeviceBufferDeviceAddressFeaturesKHR buffer_address_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR,
+    };
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorbuffer_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+        .pNext = &buffer_address_features,
+    };
+    VkPhysicalDeviceShaderObjectFeaturesEXT shaderobject_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT,
+        .pNext = &descriptorbuffer_features,
+    };
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamic_state3_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
+        .pNext = &shaderobject_features,
+    };
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynamic_state_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT,
+        .pNext = &dynamic_state3_features,
+    };
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipeline_library_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+        .pNext = &dynamic_state_features,
+    };
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        .pNext = &pipeline_library_features,
+    };
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .pNext = &present_wait_features,
+    };
+    VkPhysicalDeviceFeatures2 features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &present_id_features,
+    };
+    if (vulkan->physicaldevice_properties.apiVersion >= VK_API_VERSION_1_1) {
+        vkGetPhysicalDeviceFeatures2(vulkan->physicaldevice, &features);
+    } else {
+        vkGetPhysicalDeviceFeatures(vulkan->physicaldevice, &features.features);
+    }
+
+    // Enabled features are chained separately from the queried ones so that
+    // only what is actually used gets turned on.
+    void *enabled_features = nullptr;
+
+    vulkan->present_wait_supported = (
+        vulkan_extension_find(
+            available_extensions, extension_count, VK_KHR_PRESENT_ID_EXTENSION_NAME
+        ) &&
+        vulkan_extension_find(
+            available_extensions, extension_count, VK_KHR_PRESENT_WAIT_EXTENSION_NAME
+        ) &&
+        present_id_features.presentId == VK_TRUE &&
+        present_wait_features.presentWait == VK_TRUE
+    );
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_enable = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        .presentWait = VK_TRUE,
+    };
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_enable = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .pNext = &present_wait_enable,
+        .presentId = VK_TRUE,
+    };
+    if (vulkan->present_wait_supported) {
+        device_extensions[device_extensions_count++] = VK_KHR_PRESENT_ID_EXTENSION_NAME;
+        device_extensions[device_extensions_count++] = VK_KHR_PRESENT_WAIT_EXTENSION_NAME;
+        present_wait_enable.pNext = enabled_features;
+        enabled_features = &present_id_enable;
+    }
+
+    vulkan->memory_budget_supported = (
+        vulkan->physicaldevice_properties.apiVersion >= VK_API_VERSION_1_1 &&
+        vulkan_extension_find(
+            available_extensions, extension_count, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME
+        )
+    );
+    if (vulkan->memory_budget_supported) {
+        device_extensions[device_extensions_count++] = (
+            VK_EXT_MEMORY_BUDGET_EXTENSION_NAME
+        );
+    }
+
+    // Lets the downsampler write storage images of any format
+    vulkan->storageimage_write_supported = (
+        features.features.shaderStorageImageWriteWithoutFormat == VK_TRUE
+    );
+
+    // Lets textures be block compressed at load time
+    vulkan->texturecompression_bc_supported = (
+        features.features.textureCompressionBC == VK_TRUE
+    );
+
+    // Lets objects be culled and drawn on the device without the host knowing
+    // how many draws there are
+    vulkan->gpucull_supported = (
+        vulkan_extension_find(
+            available_extensions,
+            extension_count,
+            VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME
+        ) &&
+        features.features.multiDrawIndirect == VK_TRUE &&
+        features.features.drawIndirectFirstInstance == VK_TRUE &&
+        gpucull_supported(vulkan->physicaldevice)
+    );
+    if (vulkan->gpucull_supported) {
+        device_extensions[device_extensions_count++] = (
+            VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME
+        );
+    }
+
+    vulkan->pipeline_library_supported = (
+        vulkan_extension_find(
+            available_extensions, extension_count, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME
+        ) &&
+        vulkan_extension_find(
+            available_extensions,
+            extension_count,
+            VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME
+        ) &&
+        pipeline_library_features.graphicsPipelineLibrary == VK_TRUE
+    );
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipeline_library_enable = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+        .graphicsPipelineLibrary = VK_TRUE,
+    };
+    if (vulkan->pipeline_library_supported) {
+        device_extensions[device_extensions_count++] = (
+            VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME
+        );
+        device_extensions[device_extensions_count++] = (
+            VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME
+        );
+        pipeline_library_enable.pNext = enabled_features;
+        enabled_features = &pipeline_library_enable;
+    }
+
+    // Topology, cull mode and front face come as a set, polygon mode and blend
+    // enable are separate features of the third extension
+    vulkan->pipeline_dynamic = 0;
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynamic_state_enable = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT,
+        .extendedDynamicState = VK_TRUE,
+    };
+    if (
+        vulkan_extension_find(
+            available_extensions,
+            extension_count,
+            VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME
+        ) &&
+        dynamic_state_features.extendedDynamicState == VK_TRUE
+    ) {
+        vulkan->pipeline_dynamic |= (
+            PIPELINE_DYNAMIC_TOPOLOGY |
+            PIPELINE_DYNAMIC_CULL_MODE |
+            PIPELINE_DYNAMIC_FRONT_FACE
+        );
+        device_extensions[device_extensions_count++] = (
+            VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME
+        );
+        dynamic_state_enable.pNext = enabled_features;
+        enabled_features = &dynamic_state_enable;
+    }
+
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamic_state3_enable = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
+        .extendedDynamicState3PolygonMode = (
+            dynamic_state3_features.extendedDynamicState3PolygonMode
+        ),
+        .extendedDynamicState3ColorBlendEnable = (
+            dynamic_state3_features.extendedDynamicState3ColorBlendEnable
+        ),
+    };
+    if (
+        vulkan_extension_find(
+            available_extensions,
+            extension_count,
+            VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME
+        ) &&
+        (
+            dynamic_state3_enable.extendedDynamicState3PolygonMode == VK_TRUE ||
+            dynamic_state3_enable.extendedDynamicState3ColorBlendEnable == VK_TRUE
+        )
+    ) {
+        if (dynamic_state3_enable.extendedDynamicState3PolygonMode == VK_TRUE) {
+            vulkan->pipeline_dynamic |= PIPELINE_DYNAMIC_POLYGON_MODE;
+        }
+        if (dynamic_state3_enable.extendedDynamicState3ColorBlendEnable == VK_TRUE) {
+            vulkan->pipeline_dynamic |= PIPELINE_DYNAMIC_BLEND_ENABLE;
+        }
+        device_extensions[device_extensions_count++] = (
+            VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME
+        );
+        dynamic_state3_enable.pNext = enabled_features;
+        enabled_features = &dynamic_state3_enable;
+    }
+
+    // Dynamic rendering and what it depends on are only enabled because the
+    // extension requires them, drawing still uses the render pass
+    const char *shaderobject_extensions[] = {
+        VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+        VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+        VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+        VK_EXT_SHADER_OBJECT_EXTENSION_NAME,
+    };
+    size_t shaderobject_extensions_count = (
+        sizeof(shaderobject_extensions) / sizeof(shaderobject_extensions[0])
+    );
+    vulkan->shaderobjects_supported = (
+        (vulkan->shaderobjects_requested || vulkan->benchmark) &&
+        shaderobject_features.shaderObject == VK_TRUE
+    );
+    for (size_t i = 0; i < shaderobject_extensions_count; i++) {
+        vulkan->shaderobjects_supported = vulkan->shaderobjects_supported && (
+            vulkan_extension_find(
+                available_extensions, extension_count, shaderobject_extensions[i]
+            )
+        );
+    }
+    VkPhysicalDeviceShaderObjectFeaturesEXT shaderobject_enable = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT,
+        .shaderObject = VK_TRUE,
+    };
+    if (vulkan->shaderobjects_supported) {
+        for (size_t i = 0; i < shaderobject_extensions_count; i++) {
+            device_extensions[device_extensions_count++] = shaderobject_extensions[i];
+        }
+        shaderobject_enable.pNext = enabled_features;
+        enabled_features = &shaderobject_enable;
+    }
+
+    // Descriptor indexing and synchronization2 are only enabled because the
+    // extension requires them
+    const char *descriptorbuffer_extensions[] = {
+        VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
+        VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
+        VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+        VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME,
     };
-    size_t device_extensions_count = (
-        sizeof(device_extensions) / sizeof(device_extensions[0])
+    size_t descriptorbuffer_extensions_count = (
+        sizeof(descriptorbuffer_extensions) / sizeof(descriptorbuffer_extensions[0])
     );
+    vulkan->descriptorbuffer_supported = (
+        descriptorbuffer_features.descriptorBuffer == VK_TRUE &&
+        buffer_address_features.bufferDeviceAddress == VK_TRUE
+    );
+    for (size_t i = 0; i < descriptorbuffer_extensions_count; i++) {
+        vulkan->descriptorbuffer_supported = vulkan->descriptorbuffer_supported && (
+            vulkan_extension_find(
+                available_extensions, extension_count, descriptorbuffer_extensions[i]
+            )
+        );
+    }
+    VkPhysicalDeviceBufferDeviceAddressFeaturesKHR buffer_address_enable = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR,
+        .bufferDeviceAddress = VK_TRUE,
+    };
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorbuffer_enable = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+        .pNext = &buffer_address_enable,
+        .descriptorBuffer = VK_TRUE,
+    };
+    if (vulkan->descriptorbuffer_supported) {
+        for (size_t i = 0; i < descriptorbuffer_extensions_count; i++) {
+            device_extensions[device_extensions_count++] = (
+                descriptorbuffer_extensions[i]
+            );
+        }
+        buffer_address_enable.pNext = enabled_features;
+        enabled_features = &descriptorbuffer_enable;
+
+        vulkan->descriptorbuffer_properties = (
+            (VkPhysicalDeviceDescriptorBufferPropertiesEXT){
+                .sType = (
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT
+                ),
+            }
+        );
+        vkGetPhysicalDeviceProperties2(
+            vulkan->physicaldevice,
+            &(VkPhysicalDeviceProperties2){
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                .pNext = &vulkan->descriptorbuffer_properties,
+            }
+        );
+    }
 
     VkDeviceCreateInfo create_info = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = enabled_features,
         .pQueueCreateInfos = queue_create_infos,
         .queueCreateInfoCount = queue_create_infos_count,
-        .pEnabledFeatures = &(VkPhysicalDeviceFeatures){},
+        .pEnabledFeatures = &(VkPhysicalDeviceFeatures){
+            .shaderStorageImageWriteWithoutFormat = vulkan->storageimage_write_supported,
+            .textureCompressionBC = vulkan->texturecompression_bc_supported,
+            .multiDrawIndirect = vulkan->gpucull_supported,
+            .drawIndirectFirstInstance = vulkan->gpucull_supported,
+        },
         .ppEnabledExtensionNames = device_extensions,
         .enabledExtensionCount = device_extensions_count,
     };
@@ -377,6 +874,52 @@ static bool vulkan_device_create(struct vulkan *vulkan) {
         vulkan->device, vulkan->present_queuefamily_index, 0, &vulkan->present_queue
     );
 
+    if (vulkan->present_wait_supported) {
+        vulkan->vkWaitForPresentKHR = (PFN_vkWaitForPresentKHR) vkGetDeviceProcAddr(
+            vulkan->device, "vkWaitForPresentKHR"
+        );
+        vulkan->present_wait_supported = vulkan->vkWaitForPresentKHR != nullptr;
+    }
+
+    if (vulkan->pipeline_dynamic & PIPELINE_DYNAMIC_TOPOLOGY) {
+        vulkan->vkCmdSetPrimitiveTopologyEXT = (PFN_vkCmdSetPrimitiveTopologyEXT) (
+            vkGetDeviceProcAddr(vulkan->device, "vkCmdSetPrimitiveTopologyEXT")
+        );
+        vulkan->vkCmdSetCullModeEXT = (PFN_vkCmdSetCullModeEXT) vkGetDeviceProcAddr(
+            vulkan->device, "vkCmdSetCullModeEXT"
+        );
+        vulkan->vkCmdSetFrontFaceEXT = (PFN_vkCmdSetFrontFaceEXT) vkGetDeviceProcAddr(
+            vulkan->device, "vkCmdSetFrontFaceEXT"
+        );
+        if (
+            vulkan->vkCmdSetPrimitiveTopologyEXT == nullptr ||
+            vulkan->vkCmdSetCullModeEXT == nullptr ||
+            vulkan->vkCmdSetFrontFaceEXT == nullptr
+        ) {
+            vulkan->pipeline_dynamic &= ~(uint32_t) (
+                PIPELINE_DYNAMIC_TOPOLOGY |
+                PIPELINE_DYNAMIC_CULL_MODE |
+                PIPELINE_DYNAMIC_FRONT_FACE
+            );
+        }
+    }
+    if (vulkan->pipeline_dynamic & PIPELINE_DYNAMIC_POLYGON_MODE) {
+        vulkan->vkCmdSetPolygonModeEXT = (PFN_vkCmdSetPolygonModeEXT) (
+            vkGetDeviceProcAddr(vulkan->device, "vkCmdSetPolygonModeEXT")
+        );
+        if (vulkan->vkCmdSetPolygonModeEXT == nullptr) {
+            vulkan->pipeline_dynamic &= ~(uint32_t) PIPELINE_DYNAMIC_POLYGON_MODE;
+        }
+    }
+    if (vulkan->pipeline_dynamic & PIPELINE_DYNAMIC_BLEND_ENABLE) {
+        vulkan->vkCmdSetColorBlendEnableEXT = (PFN_vkCmdSetColorBlendEnableEXT) (
+            vkGetDeviceProcAddr(vulkan->device, "vkCmdSetColorBlendEnableEXT")
+        );
+        if (vulkan->vkCmdSetColorBlendEnableEXT == nullptr) {
+            vulkan->pipeline_dynamic &= ~(uint32_t) PIPELINE_DYNAMIC_BLEND_ENABLE;
+        }
+    }
+
     return true;
 }
 
@@ -625,16 +1168,23 @@ static bool vulkan_shadermodule_create(
 }
 
 /// @param[in,out] vulkan
+/// @param[in] load Whether to draw over what the image holds, which must be in
+/// `VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL`, instead of clearing it
+/// @param[out] render_pass
 /// @return `true` on success and `false` otherwise
-static bool vulkan_renderpass_create(struct vulkan *vulkan) {
+static bool vulkan_renderpass_create(
+    struct vulkan *vulkan, bool load, VkRenderPass *render_pass
+) {
     VkAttachmentDescription color_attachment = {
         .format = vulkan->swapchain_image_format,
         .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .loadOp = load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
         .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
         .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = load
+            ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+            : VK_IMAGE_LAYOUT_UNDEFINED,
         .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
     };
 
@@ -649,13 +1199,17 @@ static bool vulkan_renderpass_create(struct vulkan *vulkan) {
         .colorAttachmentCount = 1,
     };
 
+    // Compatible render passes have the same dependencies, so both wait for
+    // the color written before them
     VkSubpassDependency subpass_dependency = {
         .srcSubpass = VK_SUBPASS_EXTERNAL,
         .dstSubpass = 0,
         .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .srcAccessMask = 0,
+        .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
         .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstAccessMask = (
+            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+        ),
     };
 
     VkRenderPassCreateInfo render_pass_create_info = {
@@ -669,7 +1223,7 @@ static bool vulkan_renderpass_create(struct vulkan *vulkan) {
     };
 
     if (vkCreateRenderPass(
-        vulkan->device, &render_pass_create_info, nullptr, &vulkan->render_pass
+        vulkan->device, &render_pass_create_info, nullptr, render_pass
     ) != VK_SUCCESS) {
         fprintf(stderr, "vulkan_renderpass_create: vkCreateRenderPass failed\n");
         return false;
@@ -678,226 +1232,803 @@ static bool vulkan_renderpass_create(struct vulkan *vulkan) {
     return true;
 }
 
+/// @param[in] vulkan
+/// @param[in] name Path relative to the working directory
+/// @param[out] content
+/// @param[out] content_size
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to free `content` after successful return
+static bool vulkan_asset_read(
+    const struct vulkan *vulkan,
+    const char *name,
+    uint8_t **content,
+    size_t *content_size
+) {
+    if (vulkan->archive.content == nullptr) {
+        char filename[MAX_TMP_BUFFER];
+        snprintf(filename, sizeof(filename), "./%s", name);
+
+        return file_read(filename, content, content_size);
+    }
+
+    const struct archive_entry *entry = archive_find(&vulkan->archive, name);
+    if (entry == nullptr) {
+        fprintf(stderr, "vulkan_asset_read: \"%s\" is not in the archive\n", name);
+        return false;
+    }
+
+    // One spare byte so that empty assets still get an allocation
+    uint8_t *data = malloc(entry->uncompressed_size + 1);
+    if (data == nullptr) {
+        fprintf(stderr, "vulkan_asset_read: malloc failed\n");
+        return false;
+    }
+
+    const uint8_t *blob = archive_blob(&vulkan->archive, entry);
+    if (!archive_decode(vulkan->jobs, entry, blob, data)) {
+        fprintf(stderr, "vulkan_asset_read: archive_decode failed\n");
+        free(data);
+        return false;
+    }
+
+    *content = data;
+    *content_size = entry->uncompressed_size;
+
+    return true;
+}
+
+/// @param[in] variants
+/// @param[in] variants_count At most `SCENE_VARIANTS_COUNT + 2`
+/// @param[in] dynamic Mask of `pipeline_dynamic`
+/// @return Distinct pipelines `variants` need when the state covered by
+/// `dynamic` is set on the command buffer
+static size_t vulkan_variants_distinct(
+    const struct pipeline_variant *variants, size_t variants_count, uint32_t dynamic
+) {
+    uint64_t hashes[SCENE_VARIANTS_COUNT + 2];
+    size_t hashes_count = 0;
+    for (size_t i = 0; i < variants_count; i++) {
+        struct pipeline_variant variant = variants[i];
+        pipeline_state_dynamic_set(&variant.state, dynamic);
+        uint64_t hash = pipeline_variant_hash(&variant);
+
+        size_t j = 0;
+        while (j < hashes_count && hashes[j] != hash) {
+            j++;
+        }
+        if (j == hashes_count) {
+            hashes[hashes_count++] = hash;
+        }
+    }
+
+    return hashes_count;
+}
+
 /// @param[in,out] vulkan
 /// @return `true` on success and `false` otherwise
 static bool vulkan_graphicspipeline_create(struct vulkan *vulkan) {
-    bool success = false;
-
-    uint8_t *vertex_shader_code = nullptr;
-    uint8_t *fragment_shader_code = nullptr;
-    VkShaderModule vertex_shadermodule = VK_NULL_HANDLE;
-    VkShaderModule fragment_shadermodule = VK_NULL_HANDLE;
+    struct pipeline_program *program = &vulkan->program;
 
-    size_t vertex_shader_code_size;
-    if (!file_read(
-        "./shaders/vertex.spv", &vertex_shader_code, &vertex_shader_code_size
+    if (!vulkan_asset_read(
+        vulkan, "shaders/vertex.spv", &program->vertex_code, &program->vertex_code_size
     )) {
         fprintf(
             stderr,
-            "vulkan_graphicspipeline_create: file_read(\"vertex.spv\") failed\n"
+            "vulkan_graphicspipeline_create: "
+            "vulkan_asset_read(\"vertex.spv\") failed\n"
         );
-        goto cleanup;
+        return false;
     }
 
-    size_t fragment_shader_code_size;
-    if (!file_read(
-        "./shaders/fragment.spv", &fragment_shader_code, &fragment_shader_code_size
+    if (!vulkan_asset_read(
+        vulkan,
+        "shaders/fragment.spv",
+        &program->fragment_code,
+        &program->fragment_code_size
     )) {
         fprintf(
             stderr,
             "vulkan_graphicspipeline_create: "
-            "file_read(\"fragment.spv\") failed\n"
+            "vulkan_asset_read(\"fragment.spv\") failed\n"
         );
-        goto cleanup;
+        return false;
     }
 
+    pipeline_program_hash(program);
+
     if (!vulkan_shadermodule_create(
-        vulkan, vertex_shader_code, vertex_shader_code_size, &vertex_shadermodule
+        vulkan,
+        program->vertex_code,
+        program->vertex_code_size,
+        &program->vertex_shadermodule
     )) {
         fprintf(
             stderr,
             "vulkan_graphicspipeline_create: "
             "vulkan_shader_module_create(vertex_shader_code) failed\n"
         );
-        goto cleanup;
+        return false;
     }
 
     if (!vulkan_shadermodule_create(
-        vulkan, fragment_shader_code, fragment_shader_code_size, &fragment_shadermodule
+        vulkan,
+        program->fragment_code,
+        program->fragment_code_size,
+        &program->fragment_shadermodule
     )) {
         fprintf(
             stderr,
             "vulkan_graphicspipeline_create: "
             "vulkan_shader_module_create(fragment_shader_code) failed\n"
         );
-        goto cleanup;
+        return false;
     }
 
-    VkPipelineShaderStageCreateInfo shader_stages[] = {
-        {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .stage = VK_SHADER_STAGE_VERTEX_BIT,
-            .module = vertex_shadermodule,
-            .pName = "main",
-        },
-        {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-            .module = fragment_shadermodule,
-            .pName = "main",
-        },
-    };
-    size_t shader_stages_count = sizeof(shader_stages) / sizeof(shader_stages[0]);
-
-    VkDynamicState dynamic_states[] = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
-    size_t dynamic_states_count = sizeof(dynamic_states) / sizeof(dynamic_states[0]);
+    struct spirv_reflection vertex_reflection;
+    if (!spirv_reflect(
+        program->vertex_code, program->vertex_code_size, &vertex_reflection
+    )) {
+        fprintf(
+            stderr, "vulkan_graphicspipeline_create: spirv_reflect(vertex) failed\n"
+        );
+        return false;
+    }
 
-    VkPipelineDynamicStateCreateInfo dynamic_state = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-        .pDynamicStates = dynamic_states,
-        .dynamicStateCount = dynamic_states_count,
-    };
+    struct spirv_reflection fragment_reflection;
+    if (!spirv_reflect(
+        program->fragment_code, program->fragment_code_size, &fragment_reflection
+    )) {
+        fprintf(
+            stderr, "vulkan_graphicspipeline_create: spirv_reflect(fragment) failed\n"
+        );
+        return false;
+    }
 
-    VkPipelineVertexInputStateCreateInfo vertex_input = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .pVertexBindingDescriptions = nullptr,
-        .vertexBindingDescriptionCount = 0,
-        .pVertexAttributeDescriptions = nullptr,
-        .vertexAttributeDescriptionCount = 0,
-    };
+    program->reflection = (struct spirv_reflection){};
+    if (
+        !spirv_reflection_merge(&program->reflection, &vertex_reflection) ||
+        !spirv_reflection_merge(&program->reflection, &fragment_reflection)
+    ) {
+        fprintf(
+            stderr, "vulkan_graphicspipeline_create: spirv_reflection_merge failed\n"
+        );
+        return false;
+    }
 
-    VkPipelineInputAssemblyStateCreateInfo input_assembly = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-        .primitiveRestartEnable = VK_FALSE,
-    };
+    // Descriptor buffers need the flag on every set layout and pipeline that
+    // is used with them
+    layoutcache_create(
+        vulkan->device,
+        (
+            vulkan->descriptorbuffer_supported ?
+            VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT :
+            0
+        ),
+        &vulkan->layoutcache
+    );
+    layoutcache_create(vulkan->device, 0, &vulkan->descriptorset_layoutcache);
 
-    VkPipelineViewportStateCreateInfo viewport_state = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .viewportCount = 1,
-        .scissorCount = 1,
-    };
+    if (!layoutcache_pipelinelayout_get(
+        &vulkan->layoutcache, &program->reflection, &program->layout, nullptr, nullptr
+    )) {
+        fprintf(
+            stderr,
+            "vulkan_graphicspipeline_create: layoutcache_pipelinelayout_get failed\n"
+        );
+        return false;
+    }
 
-    VkPipelineRasterizationStateCreateInfo rasterizer = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-        .depthClampEnable = VK_FALSE,
-        .rasterizerDiscardEnable = VK_FALSE,
-        .polygonMode = VK_POLYGON_MODE_FILL,
-        .lineWidth = 1.0f,
-        .cullMode = VK_CULL_MODE_BACK_BIT,
-        .frontFace = VK_FRONT_FACE_CLOCKWISE,
-        .depthBiasEnable = VK_FALSE,
-        .depthBiasConstantFactor = 0.0f,
-        .depthBiasClamp = 0.0f,
-        .depthBiasSlopeFactor = 0.0f,
-    };
+    uint64_t start_time = stats_time_now();
 
-    VkPipelineMultisampleStateCreateInfo multisampling = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-        .sampleShadingEnable = VK_FALSE,
-        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-        .minSampleShading = 1.0f,
-        .pSampleMask = nullptr,
-        .alphaToCoverageEnable = VK_FALSE,
-        .alphaToOneEnable = VK_FALSE,
-    };
+    if (!variantcache_create(
+        vulkan->device,
+        &vulkan->physicaldevice_properties,
+        vulkan->render_pass,
+        vulkan->pipeline_library_supported,
+        vulkan->pipeline_dynamic,
+        vulkan->jobs,
+        PIPELINE_CACHE_FILENAME,
+        &vulkan->variantcache
+    )) {
+        fprintf(stderr, "vulkan_graphicspipeline_create: variantcache_create failed\n");
+        return false;
+    }
 
-    VkPipelineColorBlendAttachmentState color_blend_attachment = {
-        .colorWriteMask = (
-            VK_COLOR_COMPONENT_R_BIT |
-            VK_COLOR_COMPONENT_G_BIT |
-            VK_COLOR_COMPONENT_B_BIT |
-            VK_COLOR_COMPONENT_A_BIT
-        ),
-        .blendEnable = VK_TRUE,
-        .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
-        .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
-        .colorBlendOp = VK_BLEND_OP_ADD,
-        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-        .alphaBlendOp = VK_BLEND_OP_ADD,
-    };
-
-    VkPipelineColorBlendStateCreateInfo color_blend = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        .logicOpEnable = VK_FALSE,
-        .logicOp = VK_LOGIC_OP_COPY,
-        .pAttachments = &color_blend_attachment,
-        .attachmentCount = 1,
-        .blendConstants = {
-            0.0f,
-            0.0f,
-            0.0f,
-            0.0f,
+    vulkan->variant = (struct pipeline_variant){
+        .program = program,
+        .constants = {
+            .values = {
+                [SHADER_CONSTANT_GRAYSCALE] = VK_FALSE,
+                [SHADER_CONSTANT_NOISE_OCTAVES] = 0,
+                [SHADER_CONSTANT_QUANTIZED_VERTICES] = VK_TRUE,
+            },
+            .count = SHADER_CONSTANT_COUNT,
+        },
+        .state = {
+            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+            .polygon_mode = VK_POLYGON_MODE_FILL,
+            .cull_mode = VK_CULL_MODE_BACK_BIT,
+            .front_face = VK_FRONT_FACE_CLOCKWISE,
+            .blend_enable = VK_TRUE,
+            .vertexformat = VERTEXFORMAT_QUANTIZED,
+            .flags = (
+                vulkan->descriptorbuffer_supported ?
+                VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT :
+                0
+            ),
         },
     };
 
-    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .pSetLayouts = nullptr,
-        .setLayoutCount = 0,
-        .pPushConstantRanges = nullptr,
-        .pushConstantRangeCount = 0,
-    };
+    size_t scene_variants_count = 0;
+    for (uint32_t grayscale = 0; grayscale < 2; grayscale++) {
+        for (size_t i = 0; i < SHADER_NOISE_OCTAVES_COUNT; i++) {
+            for (size_t j = 0; j < CULL_MODES_COUNT; j++) {
+                for (uint32_t clockwise = 0; clockwise < 2; clockwise++) {
+                    for (uint32_t blend = 0; blend < 2; blend++) {
+                        struct pipeline_variant *variant = (
+                            &vulkan->scene_variants[scene_variants_count++]
+                        );
+                        *variant = vulkan->variant;
+                        variant->constants.values[SHADER_CONSTANT_GRAYSCALE] = grayscale;
+                        variant->constants.values[SHADER_CONSTANT_NOISE_OCTAVES] = (
+                            SHADER_NOISE_OCTAVES[i]
+                        );
+                        variant->state.cull_mode = CULL_MODES[j];
+                        variant->state.front_face = (
+                            clockwise ?
+                            VK_FRONT_FACE_CLOCKWISE :
+                            VK_FRONT_FACE_COUNTER_CLOCKWISE
+                        );
+                        variant->state.blend_enable = blend;
+                    }
+                }
+            }
+        }
+    }
 
-    if (vkCreatePipelineLayout(
-        vulkan->device, &pipeline_layout_create_info, nullptr, &vulkan->pipeline_layout
-    ) != VK_SUCCESS) {
-        fprintf(
-            stderr, "vulkan_graphicspipeline_create: vkCreatePipelineLayout failed\n"
-        );
-        goto cleanup;
+    vulkan->float32_variant = vulkan->variant;
+    vulkan->float32_variant.constants.values[SHADER_CONSTANT_QUANTIZED_VERTICES] = (
+        VK_FALSE
+    );
+    vulkan->float32_variant.state.vertexformat = VERTEXFORMAT_FLOAT32;
+
+    // Queue every variant the application can switch to, the default one goes
+    // first so the fallback below is picked up by a worker right away
+    struct pipeline_variant variants[2 + SCENE_VARIANTS_COUNT];
+    variants[0] = vulkan->variant;
+    variants[1] = vulkan->float32_variant;
+    memcpy(&variants[2], vulkan->scene_variants, sizeof(vulkan->scene_variants));
+
+    if (!variantcache_prewarm(
+        &vulkan->variantcache, variants, sizeof(variants) / sizeof(variants[0])
+    )) {
+        fprintf(stderr, "vulkan_graphicspipeline_create: variantcache_prewarm failed\n");
+        return false;
     }
 
-    VkGraphicsPipelineCreateInfo pipeline_create_info = {
-        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .pStages = shader_stages,
-        .stageCount = shader_stages_count,
-        .pVertexInputState = &vertex_input,
-        .pInputAssemblyState = &input_assembly,
-        .pViewportState = &viewport_state,
-        .pRasterizationState = &rasterizer,
-        .pMultisampleState = &multisampling,
-        .pDepthStencilState = nullptr,
-        .pColorBlendState = &color_blend,
-        .pDynamicState = &dynamic_state,
-        .layout = vulkan->pipeline_layout,
-        .renderPass = vulkan->render_pass,
-        .subpass = 0,
-        .basePipelineHandle = VK_NULL_HANDLE,
-        .basePipelineIndex = -1,
-    };
-
-    if (vkCreateGraphicsPipelines(
-        vulkan->device,
-        VK_NULL_HANDLE,
-        1,
-        &pipeline_create_info,
-        nullptr,
-        &vulkan->graphics_pipeline
-    ) != VK_SUCCESS) {
+    fprintf(
+        stderr,
+        "vulkan_graphicspipeline_create: %zu variants need %zu pipelines without "
+        "dynamic state and %zu with it (dynamic state mask 0x%x)\n",
+        sizeof(variants) / sizeof(variants[0]),
+        vulkan_variants_distinct(variants, sizeof(variants) / sizeof(variants[0]), 0),
+        vulkan_variants_distinct(
+            variants, sizeof(variants) / sizeof(variants[0]), vulkan->pipeline_dynamic
+        ),
+        vulkan->pipeline_dynamic
+    );
+
+    // Only the pipeline the first frame draws with is waited for
+    if (!variantcache_fallback_set(&vulkan->variantcache, &vulkan->variant)) {
         fprintf(
-            stderr, "vulkan_graphicspipeline_create: vkCreateGraphicsPipelines failed\n"
+            stderr, "vulkan_graphicspipeline_create: variantcache_fallback_set failed\n"
         );
         return false;
     }
 
-    success = true;
+    // A fair comparison needs every variant, not just the first one
+    if (vulkan->benchmark) {
+        variantcache_wait(&vulkan->variantcache);
+    }
+    vulkan->variantcache_startup_time = stats_time_now() - start_time;
 
-cleanup:
-    vkDestroyShaderModule(vulkan->device, fragment_shadermodule, nullptr);
-    vkDestroyShaderModule(vulkan->device, vertex_shadermodule, nullptr);
-    free(fragment_shader_code);
-    free(vertex_shader_code);
+    if (vulkan->shaderobjects_supported) {
+        start_time = stats_time_now();
 
-    return success;
-}
+        if (!shaderobjects_create(
+            vulkan->device, &vulkan->layoutcache, program, &vulkan->shaderobjects
+        )) {
+            fprintf(
+                stderr, "vulkan_graphicspipeline_create: shaderobjects_create failed\n"
+            );
+            return false;
+        }
 
-/// @param[in,out] vulkan
-/// @return `true` on success and `false` otherwise
+        if (!shaderobjects_prewarm(
+            &vulkan->shaderobjects, variants, sizeof(variants) / sizeof(variants[0])
+        )) {
+            fprintf(
+                stderr, "vulkan_graphicspipeline_create: shaderobjects_prewarm failed\n"
+            );
+            return false;
+        }
+
+        vulkan->shaderobjects_startup_time = stats_time_now() - start_time;
+        vulkan->shaderobjects_enabled = vulkan->shaderobjects_requested;
+    }
+
+    return true;
+}
+
+/// @param[in,out] vulkan
+/// @return `true` on success and `false` otherwise
+static bool vulkan_materials_create(struct vulkan *vulkan) {
+    VkDeviceSize alignment = (
+        vulkan->physicaldevice_properties.limits.minUniformBufferOffsetAlignment
+    );
+    VkDeviceSize stride = (
+        (sizeof(struct material) + alignment - 1) / alignment * alignment
+    );
+
+    if (!buffer_create(
+        vulkan->device,
+        &vulkan->memory_properties,
+        stride * MATERIALS_COUNT,
+        (
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+            (
+                vulkan->descriptorbuffer_supported ?
+                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR :
+                0
+            )
+        ),
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &vulkan->materials
+    )) {
+        fprintf(stderr, "vulkan_materials_create: buffer_create failed\n");
+        return false;
+    }
+
+    // The first material leaves the vertex colors as they are, the others
+    // tint them by a color derived from their index
+    for (uint32_t i = 0; i < MATERIALS_COUNT; i++) {
+        struct material material = {
+            .color = {1.0f, 1.0f, 1.0f, 1.0f},
+        };
+        if (i > 0) {
+            uint32_t hash = i * 2654435761u;
+            for (uint32_t j = 0; j < 3; j++) {
+                material.color[j] = 0.5f + (float) ((hash >> (8 * j)) & 0xff) / 510.0f;
+            }
+        }
+
+        memcpy(
+            (uint8_t *) vulkan->materials.mapped + stride * i,
+            &material,
+            sizeof(material)
+        );
+        vulkan->material_uniforms[i] = (VkDescriptorBufferInfo){
+            .buffer = vulkan->materials.buffer,
+            .offset = stride * i,
+            .range = sizeof(material),
+        };
+    }
+
+    VkPipelineLayout layout;
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS];
+    uint32_t setlayouts_count;
+    if (!layoutcache_pipelinelayout_get(
+        &vulkan->layoutcache,
+        &vulkan->program.reflection,
+        &layout,
+        setlayouts,
+        &setlayouts_count
+    )) {
+        fprintf(
+            stderr, "vulkan_materials_create: layoutcache_pipelinelayout_get failed\n"
+        );
+        return false;
+    }
+
+    if (!descriptors_create(
+        vulkan->device,
+        &vulkan->memory_properties,
+        (
+            vulkan->descriptorbuffer_supported ?
+            &vulkan->descriptorbuffer_properties :
+            nullptr
+        ),
+        setlayouts[0],
+        0,
+        MATERIALS_COUNT,
+        &vulkan->descriptors
+    )) {
+        fprintf(stderr, "vulkan_materials_create: descriptors_create failed\n");
+        return false;
+    }
+    vulkan->materials_count = 1;
+
+    return true;
+}
+
+/// Centers an imported mesh in view. Files are y up with counter-clockwise
+/// front faces, the application draws y down with the viewer looking down the
+/// positive z axis and clockwise front faces.
+/// @param[in,out] meshimport
+static void vulkan_mesh_fit(struct meshimport *meshimport) {
+    float min[3] = {INFINITY, INFINITY, INFINITY};
+    float max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (uint32_t i = 0; i < meshimport->vertices_count; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            min[j] = fminf(min[j], meshimport->vertices[i].position[j]);
+            max[j] = fmaxf(max[j], meshimport->vertices[i].position[j]);
+        }
+    }
+
+    // Fill 90 % of the screen, and the depth range from front to back
+    float extent = fmaxf(max[0] - min[0], max[1] - min[1]);
+    float scale = extent > 0.0f ? 1.8f / extent : 1.0f;
+    float depth = max[2] - min[2] > 0.0f ? 1.0f / (max[2] - min[2]) : 1.0f;
+
+    for (uint32_t i = 0; i < meshimport->vertices_count; i++) {
+        struct vertexformat_vertex *vertex = &meshimport->vertices[i];
+        vertex->position[0] = (vertex->position[0] - (min[0] + max[0]) / 2.0f) * scale;
+        vertex->position[1] = -(vertex->position[1] - (min[1] + max[1]) / 2.0f) * scale;
+        vertex->position[2] = (max[2] - vertex->position[2]) * depth;
+        // Rotated half a turn around the x axis along with the positions
+        vertex->normal[1] = -vertex->normal[1];
+        vertex->normal[2] = -vertex->normal[2];
+    }
+
+    for (uint32_t i = 0; i + 2 < meshimport->indices_count; i += 3) {
+        uint32_t index = meshimport->indices[i + 1];
+        meshimport->indices[i + 1] = meshimport->indices[i + 2];
+        meshimport->indices[i + 2] = index;
+    }
+}
+
+/// Replaces the triangle with the mesh from `mesh_filename`
+/// @param[in,out] vulkan
+/// @param[in] content
+/// @param[in] content_size
+/// @return `true` on success and `false` otherwise
+static bool vulkan_mesh_import(
+    struct vulkan *vulkan, const uint8_t *content, size_t content_size
+) {
+    bool success = false;
+
+    uint64_t start_time = stats_time_now();
+    struct meshimport meshimport;
+    if (!meshimport_parse(vulkan->jobs, content, content_size, &meshimport)) {
+        fprintf(stderr, "vulkan_mesh_import: meshimport_parse failed\n");
+        return false;
+    }
+    uint64_t load_time = stats_time_now();
+
+    vulkan_mesh_fit(&meshimport);
+
+    struct meshoptimize_stats before;
+    struct meshoptimize_stats after;
+    if (!meshimport_optimize(&meshimport, &before, &after)) {
+        fprintf(stderr, "vulkan_mesh_import: meshimport_optimize failed\n");
+        goto cleanup;
+    }
+    uint64_t optimize_time = stats_time_now();
+
+    fprintf(
+        stderr,
+        "vulkan_mesh_import: %u vertices, %u triangles, read in %.3f ms, parsed "
+        "in %.3f ms and optimized in %.3f ms\n",
+        meshimport.vertices_count,
+        meshimport.indices_count / 3,
+        (double) (start_time - vulkan->mesh_read_time) / 1e6,
+        (double) (load_time - start_time) / 1e6,
+        (double) (optimize_time - load_time) / 1e6
+    );
+    fprintf(
+        stderr,
+        "vulkan_mesh_import: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f "
+        "(%u entry FIFO cache)\n",
+        before.acmr,
+        after.acmr,
+        before.atvr,
+        after.atvr,
+        MESHOPTIMIZE_FIFO_SIZE
+    );
+
+    // The levels go into the same index buffer after the first one
+    struct meshlod meshlod;
+    if (!meshlod_create(
+        meshimport.vertices,
+        meshimport.vertices_count,
+        &meshimport.indices,
+        &meshimport.indices_count,
+        &meshlod
+    )) {
+        fprintf(stderr, "vulkan_mesh_import: meshlod_create failed\n");
+        goto cleanup;
+    }
+    const struct meshlod_level *coarsest = &meshlod.levels[meshlod.levels_count - 1];
+    fprintf(
+        stderr,
+        "vulkan_mesh_import: %zu levels of detail down to %u triangles with an "
+        "error of %.5f, built in %.3f ms\n",
+        meshlod.levels_count,
+        coarsest->indices_count / 3,
+        (double) coarsest->error,
+        (double) (stats_time_now() - optimize_time) / 1e6
+    );
+
+    struct mesh mesh;
+    if (!mesh_create(
+        vulkan->device,
+        &vulkan->memory_properties,
+        vulkan->variant.state.vertexformat,
+        meshimport.vertices,
+        meshimport.vertices_count,
+        meshimport.indices,
+        meshimport.indices_count,
+        &mesh
+    )) {
+        fprintf(stderr, "vulkan_mesh_import: mesh_create failed\n");
+        goto cleanup;
+    }
+
+    // The triangle may still be read by the frame in flight
+    vkDeviceWaitIdle(vulkan->device);
+    mesh_destroy(vulkan->device, &vulkan->mesh);
+    vulkan->mesh = mesh;
+    vulkan->mesh_lod = meshlod;
+    vulkan->mesh_level = 0;
+
+    success = true;
+
+cleanup:
+    meshimport_destroy(&meshimport);
+
+    return success;
+}
+
+/// @param[in,out] vulkan
+/// @return `true` on success and `false` otherwise
+/// @note The triangle is drawn until the mesh from `mesh_filename` has
+/// streamed in
+static bool vulkan_mesh_create(struct vulkan *vulkan) {
+    if (vulkan->mesh_filename != nullptr) {
+        // Meshes in the archive stream in compressed and are decompressed once
+        // the read completes
+        struct streaming_request request = {.filename = vulkan->mesh_filename};
+        const struct archive_entry *entry = nullptr;
+        if (vulkan->archive.content != nullptr) {
+            entry = archive_find(&vulkan->archive, vulkan->mesh_filename);
+        }
+        if (entry != nullptr) {
+            request = (struct streaming_request){
+                .filename = ASSETS_FILENAME,
+                .offset = entry->offset,
+                .size = entry->size,
+                .user = (void *) entry,
+            };
+        }
+
+        vulkan->mesh_read_time = stats_time_now();
+        if (!streaming_read(vulkan->streaming, &request, &vulkan->mesh_read)) {
+            fprintf(stderr, "vulkan_mesh_create: streaming_read failed\n");
+            return false;
+        }
+    }
+
+    static const struct vertexformat_vertex vertices[] = {
+        {
+            .position = {0.0f, -0.5f, 0.0f},
+            .normal = {0.0f, 0.0f, -1.0f},
+            .uv = {0.5f, 0.0f},
+            .color = {1.0f, 0.0f, 0.0f, 1.0f},
+        },
+        {
+            .position = {0.5f, 0.5f, 0.0f},
+            .normal = {0.0f, 0.0f, -1.0f},
+            .uv = {1.0f, 1.0f},
+            .color = {0.0f, 1.0f, 0.0f, 1.0f},
+        },
+        {
+            .position = {-0.5f, 0.5f, 0.0f},
+            .normal = {0.0f, 0.0f, -1.0f},
+            .uv = {0.0f, 1.0f},
+            .color = {0.0f, 0.0f, 1.0f, 1.0f},
+        },
+    };
+    static const uint32_t indices[] = {0, 1, 2};
+
+    if (!mesh_create(
+        vulkan->device,
+        &vulkan->memory_properties,
+        vulkan->variant.state.vertexformat,
+        vertices,
+        sizeof(vertices) / sizeof(vertices[0]),
+        indices,
+        sizeof(indices) / sizeof(indices[0]),
+        &vulkan->mesh
+    )) {
+        fprintf(stderr, "vulkan_mesh_create: mesh_create failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] argument `struct vulkan_decode`
+static void vulkan_decode_run(void *argument) {
+    struct vulkan_decode *decode = argument;
+
+    uint64_t start_time = stats_time_now();
+    decode->success = archive_decode(
+        decode->jobs, decode->entry, decode->blob, decode->data
+    );
+    decode->time = stats_time_now() - start_time;
+}
+
+/// Starts decompressing a completed read of an archive blob on the job system
+/// @param[in,out] vulkan
+/// @param[in,out] completion `user` is the `struct archive_entry` of the blob,
+/// `data` is taken over by `mesh_decode`
+/// @return `true` on success and `false` otherwise
+/// @note `vulkan_upload_decoded` imports the mesh once it is decompressed
+static bool vulkan_upload_decode(
+    struct vulkan *vulkan, struct streaming_completion *completion
+) {
+    const struct archive_entry *entry = completion->user;
+
+    // One spare byte so that empty assets still get an allocation
+    uint8_t *data = malloc(entry->uncompressed_size + 1);
+    if (data == nullptr) {
+        fprintf(stderr, "vulkan_upload_decode: malloc failed\n");
+        return false;
+    }
+
+    vulkan->mesh_decode = (struct vulkan_decode){
+        .jobs = vulkan->jobs,
+        .entry = entry,
+        .blob = completion->data,
+        .data = data,
+    };
+    if (!jobs_submit(
+        vulkan->jobs,
+        vulkan_decode_run,
+        &vulkan->mesh_decode,
+        &vulkan->mesh_decode.counter
+    )) {
+        fprintf(stderr, "vulkan_upload_decode: jobs_submit failed\n");
+        vulkan->mesh_decode = (struct vulkan_decode){};
+        free(data);
+        return false;
+    }
+    completion->data = nullptr;
+
+    return true;
+}
+
+/// Imports the mesh once `mesh_decode` has run
+/// @param[in,out] vulkan
+/// @param[in] wait Whether to wait for the decompression instead of leaving it
+/// to a later call
+/// @return `true` on success and `false` otherwise
+static bool vulkan_upload_decoded(struct vulkan *vulkan, bool wait) {
+    struct vulkan_decode *decode = &vulkan->mesh_decode;
+    if (decode->blob == nullptr) {
+        return true;
+    }
+    if (wait) {
+        jobs_counter_wait(vulkan->jobs, &decode->counter);
+    } else if (!jobs_counter_done(&decode->counter)) {
+        return true;
+    }
+
+    bool success = decode->success;
+    if (!success) {
+        fprintf(stderr, "vulkan_upload_decoded: archive_decode failed\n");
+    } else {
+        fprintf(
+            stderr,
+            "vulkan_upload_decoded: %llu of %llu bytes decompressed in %.3f ms\n",
+            (unsigned long long) decode->entry->size,
+            (unsigned long long) decode->entry->uncompressed_size,
+            (double) decode->time / 1e6
+        );
+        success = vulkan_mesh_import(
+            vulkan, decode->data, decode->entry->uncompressed_size
+        );
+        if (!success) {
+            fprintf(stderr, "vulkan_upload_decoded: vulkan_mesh_import failed\n");
+        }
+    }
+
+    free(decode->data);
+    free(decode->blob);
+    *decode = (struct vulkan_decode){};
+
+    return success;
+}
+
+/// @param[in,out] vulkan
+/// @param[in,out] completion Its data is freed
+/// @return `true` on success and `false` otherwise
+static bool vulkan_upload(
+    struct vulkan *vulkan, struct streaming_completion *completion
+) {
+    bool success = true;
+
+    if (completion->id == vulkan->mesh_read) {
+        vulkan->mesh_read = 0;
+        if (completion->status != STREAMING_STATUS_DONE) {
+            fprintf(stderr, "vulkan_upload: \"%s\" failed\n", vulkan->mesh_filename);
+            success = false;
+        } else if (completion->user != nullptr) {
+            if (!vulkan_upload_decode(vulkan, completion)) {
+                fprintf(stderr, "vulkan_upload: vulkan_upload_decode failed\n");
+                success = false;
+            }
+        } else if (!vulkan_mesh_import(vulkan, completion->data, completion->size)) {
+            fprintf(stderr, "vulkan_upload: vulkan_mesh_import failed\n");
+            success = false;
+        }
+    }
+
+    free(completion->data);
+
+    return success;
+}
+
+/// Takes what has finished streaming in without waiting for the rest
+/// @param[in,out] vulkan
+/// @return `true` on success and `false` otherwise
+static bool vulkan_uploads_poll(struct vulkan *vulkan) {
+    bool success = true;
+
+    struct streaming_completion completions[16];
+    size_t count = streaming_poll(
+        vulkan->streaming, completions, sizeof(completions) / sizeof(completions[0])
+    );
+    for (size_t i = 0; i < count; i++) {
+        if (!vulkan_upload(vulkan, &completions[i])) {
+            fprintf(stderr, "vulkan_uploads_poll: vulkan_upload failed\n");
+            success = false;
+        }
+    }
+
+    if (!vulkan_upload_decoded(vulkan, false)) {
+        fprintf(stderr, "vulkan_uploads_poll: vulkan_upload_decoded failed\n");
+        success = false;
+    }
+
+    return success;
+}
+
+/// @param[in,out] vulkan
+/// @return `true` on success and `false` otherwise
+/// @note Blocks until every read has streamed in and been decompressed
+static bool vulkan_uploads_wait(struct vulkan *vulkan) {
+    bool success = true;
+
+    struct streaming_completion completion;
+    while (streaming_wait(vulkan->streaming, &completion)) {
+        if (!vulkan_upload(vulkan, &completion)) {
+            fprintf(stderr, "vulkan_uploads_wait: vulkan_upload failed\n");
+            success = false;
+        }
+    }
+
+    if (!vulkan_upload_decoded(vulkan, true)) {
+        fprintf(stderr, "vulkan_uploads_wait: vulkan_upload_decoded failed\n");
+        success = false;
+    }
+
+    return success;
+}
+
+/// @param[in,out] vulkan
+/// @return `true` on success and `false` otherwise
 static bool vulkan_framebuffers_create(struct vulkan *vulkan) {
     for (size_t i = 0; i < vulkan->swapchain_imageviews_count; i++) {
         VkFramebufferCreateInfo create_info = {
@@ -965,74 +2096,83 @@ static bool vulkan_commandbuffer_allocate(struct vulkan *vulkan) {
     return true;
 }
 
-/// @param[in] vulkan
-/// @param[in] command_buffer
-/// @param[in] framebuffer_index
+/// @param[in,out] vulkan
 /// @return `true` on success and `false` otherwise
-static bool vulkan_commandbuffer_record(
-    const struct vulkan *vulkan,
-    VkCommandBuffer command_buffer,
-    uint32_t framebuffer_index
-) {
-    VkCommandBufferBeginInfo begin_info = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = 0,
-        .pInheritanceInfo = nullptr,
-    };
-
-    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
-        fprintf(stderr, "vulkan_commandbuffer_record: vkBeginCommandBuffer failed\n");
+static bool vulkan_textures_create(struct vulkan *vulkan) {
+    if (!staging_create(
+        vulkan->device, &vulkan->memory_properties, UPLOAD_RING_SIZE, &vulkan->staging
+    )) {
+        fprintf(stderr, "vulkan_textures_create: staging_create failed\n");
         return false;
     }
 
-    VkClearValue clear_color = {
-        .color = {
-            {0.0f, 0.0f, 0.0f, 1.0f},
-        },
-    };
-
-    VkRenderPassBeginInfo render_pass_begin_info = {
-        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-        .renderPass = vulkan->render_pass,
-        .framebuffer = vulkan->swapchain_framebuffers[framebuffer_index],
-        .renderArea = {
-            .offset = {0, 0},
-            .extent = vulkan->swapchain_extent,
-        },
-        .pClearValues = &clear_color,
-        .clearValueCount = 1,
-    };
-
-    vkCmdBeginRenderPass(
-        command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE
-    );
+    samplercache_create(vulkan->device, &vulkan->samplercache);
 
-    vkCmdBindPipeline(
-        command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan->graphics_pipeline
+    // Without the shader only blits generate mips
+    uint8_t *code = nullptr;
+    size_t code_size = 0;
+    if (
+        vulkan->storageimage_write_supported &&
+        !vulkan_asset_read(vulkan, "shaders/downsample.spv", &code, &code_size)
+    ) {
+        code = nullptr;
+    }
+    bool success = mipgen_create(
+        vulkan->device,
+        vulkan->physicaldevice,
+        &vulkan->memory_properties,
+        &vulkan->descriptorset_layoutcache,
+        code,
+        code_size,
+        &vulkan->mipgen
     );
+    free(code);
+    if (!success) {
+        fprintf(stderr, "vulkan_textures_create: mipgen_create failed\n");
+        return false;
+    }
 
-    VkViewport viewport = {
-        .x = 0.0f,
-        .y = 0.0f,
-        .width = (float) vulkan->swapchain_extent.width,
-        .height = (float) vulkan->swapchain_extent.height,
-        .minDepth = 0.0f,
-        .maxDepth = 1.0f,
-    };
-    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
-
-    VkRect2D scissor = {
-        .offset = {0, 0},
-        .extent = vulkan->swapchain_extent,
-    };
-    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+    return true;
+}
 
-    vkCmdDraw(command_buffer, 3, 1, 0, 0);
+/// Block compresses an RGBA8 KTX2 file where the device samples BC formats,
+/// into BC1 if its base level is opaque and BC7 otherwise
+/// @param[in] vulkan
+/// @param[in] source
+/// @param[out] content Compressed file, `nullptr` if `source` is kept
+/// @param[out] ktx2 Parsed from `content`, or `source` if it is kept
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to free `content` after successful return
+static bool vulkan_texture_compress(
+    const struct vulkan *vulkan,
+    const struct ktx2 *source,
+    uint8_t **content,
+    struct ktx2 *ktx2
+) {
+    *content = nullptr;
+    *ktx2 = *source;
 
-    vkCmdEndRenderPass(command_buffer);
+    bool rgba8 = (
+        source->format == VK_FORMAT_R8G8B8A8_UNORM ||
+        source->format == VK_FORMAT_R8G8B8A8_SRGB
+    );
+    if (!vulkan->texturecompression_bc_supported || !rgba8 || source->mips_generate) {
+        return true;
+    }
 
-    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
-        fprintf(stderr, "vulkan_commandbuffer_record: vkEndCommandBuffer failed\n");
+    enum bcenc_format format = bcenc_format_choose(
+        source->content + source->levels[0].offset, source->levels[0].size / 4
+    );
+    size_t content_size;
+    if (!bcenc_ktx2_encode(vulkan->jobs, source, format, content, &content_size)) {
+        fprintf(stderr, "vulkan_texture_compress: bcenc_ktx2_encode failed\n");
+        *content = nullptr;
+        return false;
+    }
+    if (!ktx2_parse(*content, content_size, ktx2)) {
+        fprintf(stderr, "vulkan_texture_compress: ktx2_parse failed\n");
+        free(*content);
+        *content = nullptr;
         return false;
     }
 
@@ -1041,17 +2181,488 @@ static bool vulkan_commandbuffer_record(
 
 /// @param[in,out] vulkan
 /// @return `true` on success and `false` otherwise
-static bool vulkan_synchronizationobjects_create(struct vulkan *vulkan) {
-    VkSemaphoreCreateInfo semaphore_create_info = {
-        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-    };
+static bool vulkan_sprites_create(struct vulkan *vulkan) {
+    bool success = false;
 
-    if (vkCreateSemaphore(
-        vulkan->device,
-        &semaphore_create_info,
-        nullptr,
-        &vulkan->swapchain_image_available
-    ) != VK_SUCCESS) {
+    uint8_t *vertex_code = nullptr;
+    size_t vertex_code_size;
+    uint8_t *fragment_code = nullptr;
+    size_t fragment_code_size;
+    if (!vulkan_asset_read(
+        vulkan, "shaders/sprite_vertex.spv", &vertex_code, &vertex_code_size
+    )) {
+        fprintf(
+            stderr,
+            "vulkan_sprites_create: vulkan_asset_read(\"sprite_vertex.spv\") failed\n"
+        );
+        goto cleanup;
+    }
+    if (!vulkan_asset_read(
+        vulkan, "shaders/sprite_fragment.spv", &fragment_code, &fragment_code_size
+    )) {
+        fprintf(
+            stderr,
+            "vulkan_sprites_create: "
+            "vulkan_asset_read(\"sprite_fragment.spv\") failed\n"
+        );
+        goto cleanup;
+    }
+
+    // Every frame waits for the previous one before it is recorded, so one
+    // part of the ring is never read while it is written
+    if (!sprites_create(
+        vulkan->device,
+        &vulkan->memory_properties,
+        vulkan->render_pass,
+        &vulkan->descriptorset_layoutcache,
+        &vulkan->samplercache,
+        vertex_code,
+        vertex_code_size,
+        fragment_code,
+        fragment_code_size,
+        SPRITES_CAPACITY,
+        1,
+        &vulkan->sprites
+    )) {
+        fprintf(stderr, "vulkan_sprites_create: sprites_create failed\n");
+        goto cleanup;
+    }
+
+    success = true;
+
+cleanup:
+    free(fragment_code);
+    free(vertex_code);
+
+    return success;
+}
+
+/// @param[in,out] vulkan
+/// @return `true` on success and `false` otherwise
+/// @note Does nothing in release builds
+static bool vulkan_debugdraw_create(struct vulkan *vulkan) {
+    if (!DEBUGDRAW_ENABLED) {
+        return true;
+    }
+
+    bool success = false;
+
+    uint8_t *vertex_code = nullptr;
+    size_t vertex_code_size;
+    uint8_t *fragment_code = nullptr;
+    size_t fragment_code_size;
+    if (!vulkan_asset_read(
+        vulkan, "shaders/debug_vertex.spv", &vertex_code, &vertex_code_size
+    )) {
+        fprintf(
+            stderr,
+            "vulkan_debugdraw_create: vulkan_asset_read(\"debug_vertex.spv\") failed\n"
+        );
+        goto cleanup;
+    }
+    if (!vulkan_asset_read(
+        vulkan, "shaders/debug_fragment.spv", &fragment_code, &fragment_code_size
+    )) {
+        fprintf(
+            stderr,
+            "vulkan_debugdraw_create: "
+            "vulkan_asset_read(\"debug_fragment.spv\") failed\n"
+        );
+        goto cleanup;
+    }
+
+    if (!debugdraw_create(
+        vulkan->device,
+        &vulkan->memory_properties,
+        vulkan->render_pass,
+        &vulkan->layoutcache,
+        vertex_code,
+        vertex_code_size,
+        fragment_code,
+        fragment_code_size,
+        DEBUGDRAW_CAPACITY,
+        1,
+        &vulkan->debugdraw
+    )) {
+        fprintf(stderr, "vulkan_debugdraw_create: debugdraw_create failed\n");
+        goto cleanup;
+    }
+
+    success = true;
+
+cleanup:
+    free(fragment_code);
+    free(vertex_code);
+
+    return success;
+}
+
+/// Leaves `gpucull` empty where the device cannot cull
+/// @param[in,out] vulkan
+/// @return `true` on success and `false` otherwise
+static bool vulkan_gpucull_create(struct vulkan *vulkan) {
+    if (!vulkan->gpucull_supported) {
+        return true;
+    }
+
+    bool success = false;
+
+    const char *names[] = {
+        "shaders/gpucull.spv",
+        "shaders/hiz.spv",
+        "shaders/gpucull_vertex.spv",
+        "shaders/gpucull_fragment.spv",
+    };
+    constexpr size_t names_count = sizeof(names) / sizeof(names[0]);
+    uint8_t *codes[names_count] = {};
+    size_t code_sizes[names_count];
+    for (size_t i = 0; i < names_count; i++) {
+        if (!vulkan_asset_read(vulkan, names[i], &codes[i], &code_sizes[i])) {
+            fprintf(
+                stderr,
+                "vulkan_gpucull_create: vulkan_asset_read(\"%s\") failed\n",
+                names[i]
+            );
+            goto cleanup;
+        }
+    }
+
+    struct gpucull_shaders shaders = {
+        .cull = codes[0],
+        .cull_size = code_sizes[0],
+        .hiz = codes[1],
+        .hiz_size = code_sizes[1],
+        .vertex = codes[2],
+        .vertex_size = code_sizes[2],
+        .fragment = codes[3],
+        .fragment_size = code_sizes[3],
+    };
+    if (!gpucull_create(
+        vulkan->device,
+        &vulkan->memory_properties,
+        &vulkan->descriptorset_layoutcache,
+        &shaders,
+        vulkan->swapchain_image_format,
+        vulkan->swapchain_extent,
+        vulkan->swapchain_imageviews,
+        vulkan->swapchain_imageviews_count,
+        GPUCULL_CAPACITY,
+        &vulkan->gpucull
+    )) {
+        fprintf(stderr, "vulkan_gpucull_create: gpucull_create failed\n");
+        goto cleanup;
+    }
+
+    success = true;
+
+cleanup:
+    for (size_t i = 0; i < names_count; i++) {
+        free(codes[i]);
+    }
+
+    return success;
+}
+
+/// @param[in,out] vulkan
+/// @param[in] command_buffer Inside the render pass
+/// @param[in] variant
+/// @return `true` on success and `false` otherwise
+static bool vulkan_variant_bind(
+    struct vulkan *vulkan,
+    VkCommandBuffer command_buffer,
+    const struct pipeline_variant *variant
+) {
+    if (vulkan->shaderobjects_enabled) {
+        if (!shaderobjects_bind(
+            &vulkan->shaderobjects, command_buffer, vulkan->swapchain_extent, variant
+        )) {
+            fprintf(stderr, "vulkan_variant_bind: shaderobjects_bind failed\n");
+            return false;
+        }
+        return true;
+    }
+
+    vkCmdBindPipeline(
+        command_buffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        variantcache_get(&vulkan->variantcache, variant)
+    );
+
+    const struct pipeline_state *state = &variant->state;
+    if (vulkan->pipeline_dynamic & PIPELINE_DYNAMIC_TOPOLOGY) {
+        vulkan->vkCmdSetPrimitiveTopologyEXT(command_buffer, state->topology);
+        vulkan->vkCmdSetCullModeEXT(command_buffer, state->cull_mode);
+        vulkan->vkCmdSetFrontFaceEXT(command_buffer, state->front_face);
+    }
+    if (vulkan->pipeline_dynamic & PIPELINE_DYNAMIC_POLYGON_MODE) {
+        vulkan->vkCmdSetPolygonModeEXT(command_buffer, state->polygon_mode);
+    }
+    if (vulkan->pipeline_dynamic & PIPELINE_DYNAMIC_BLEND_ENABLE) {
+        vulkan->vkCmdSetColorBlendEnableEXT(command_buffer, 0, 1, &state->blend_enable);
+    }
+
+    return true;
+}
+
+/// @param[in] vulkan
+/// @return Whether frames cull and draw the objects of `gpucull` before the
+/// scene
+static bool vulkan_gpucull_enabled(const struct vulkan *vulkan) {
+    return vulkan->gpucull_supported && vulkan->gpucull.objects_count > 0;
+}
+
+/// @param[in] vulkan
+/// @param[in] mesh
+/// @return Whether the bounds of `mesh` may be visible past the occluders
+static bool vulkan_mesh_visible(const struct vulkan *vulkan, const struct mesh *mesh) {
+    return vulkan->occluder_indices_count == 0 || occlusion_box_visible(
+        &vulkan->occlusion, VIEW_PROJECTION, mesh->bounds_min, mesh->bounds_max
+    );
+}
+
+/// Picks the level of detail of `mesh` for the frame being recorded
+/// @param[in,out] vulkan
+static void vulkan_mesh_level_select(struct vulkan *vulkan) {
+    if (vulkan->mesh_lod.levels_count == 0) {
+        return;
+    }
+
+    // `VIEW_PROJECTION` has no perspective, so a unit covers the same pixels
+    // wherever the mesh is
+    float pixels_per_unit = 0.5f * VIEW_PROJECTION[5] *
+        (float) vulkan->swapchain_extent.height;
+    vulkan->mesh_level = meshlod_select(
+        &vulkan->mesh_lod,
+        pixels_per_unit,
+        LOD_THRESHOLD,
+        MESHLOD_HYSTERESIS,
+        vulkan->mesh_level
+    );
+}
+
+/// Draws `mesh` at the level of detail `vulkan_mesh_level_select` picked
+/// @param[in] vulkan
+/// @param[in] command_buffer
+/// @return `true` on success and `false` otherwise
+static bool vulkan_mesh_draw(
+    const struct vulkan *vulkan, VkCommandBuffer command_buffer
+) {
+    if (vulkan->mesh_lod.levels_count == 0) {
+        mesh_draw(&vulkan->mesh, command_buffer);
+        return true;
+    }
+
+    const struct meshlod_level *level = &vulkan->mesh_lod.levels[vulkan->mesh_level];
+    if (!mesh_draw_range(
+        &vulkan->mesh, command_buffer, level->first_index, level->indices_count
+    )) {
+        fprintf(stderr, "vulkan_mesh_draw: mesh_draw_range failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] vulkan
+/// @param[in] command_buffer
+/// @param[in] framebuffer_index
+/// @return `true` on success and `false` otherwise
+static bool vulkan_commandbuffer_record(
+    struct vulkan *vulkan,
+    VkCommandBuffer command_buffer,
+    uint32_t framebuffer_index
+) {
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = 0,
+        .pInheritanceInfo = nullptr,
+    };
+
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        fprintf(stderr, "vulkan_commandbuffer_record: vkBeginCommandBuffer failed\n");
+        return false;
+    }
+
+    if (vulkan->timestamps_enabled) {
+        vkCmdResetQueryPool(command_buffer, vulkan->timestamps, 0, 3);
+        vkCmdWriteTimestamp(
+            command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vulkan->timestamps, 0
+        );
+    }
+
+    // Atlas pages that gained images are copied before anything draws
+    if (!sprites_upload(&vulkan->sprites, &vulkan->staging, command_buffer)) {
+        fprintf(stderr, "vulkan_commandbuffer_record: sprites_upload failed\n");
+        return false;
+    }
+
+    // Culled objects are drawn first, clearing the image, and the scene over
+    // them
+    bool gpucull_enabled = vulkan_gpucull_enabled(vulkan);
+    if (gpucull_enabled) {
+        gpucull_record(
+            &vulkan->gpucull,
+            command_buffer,
+            framebuffer_index,
+            vulkan->gpucull_view_projection
+        );
+    }
+
+    VkClearValue clear_color = {
+        .color = {
+            {0.0f, 0.0f, 0.0f, 1.0f},
+        },
+    };
+
+    VkRenderPassBeginInfo render_pass_begin_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .renderPass = gpucull_enabled ? vulkan->render_pass_load : vulkan->render_pass,
+        .framebuffer = vulkan->swapchain_framebuffers[framebuffer_index],
+        .renderArea = {
+            .offset = {0, 0},
+            .extent = vulkan->swapchain_extent,
+        },
+        .pClearValues = &clear_color,
+        .clearValueCount = 1,
+    };
+
+    vkCmdBeginRenderPass(
+        command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE
+    );
+
+    if (!vulkan->shaderobjects_enabled) {
+        VkViewport viewport = {
+            .x = 0.0f,
+            .y = 0.0f,
+            .width = (float) vulkan->swapchain_extent.width,
+            .height = (float) vulkan->swapchain_extent.height,
+            .minDepth = 0.0f,
+            .maxDepth = 1.0f,
+        };
+        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+        VkRect2D scissor = {
+            .offset = {0, 0},
+            .extent = vulkan->swapchain_extent,
+        };
+        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+    }
+
+    descriptors_begin(&vulkan->descriptors, command_buffer);
+
+    vulkan_mesh_level_select(vulkan);
+
+    // Every draw of a frame draws the same mesh, so one test decides for all
+    vulkan->occlusion_culled = 0;
+    const struct mesh *scene_mesh = vulkan->benchmark_mesh != nullptr
+        ? vulkan->benchmark_mesh
+        : &vulkan->mesh;
+    if (!vulkan_mesh_visible(vulkan, scene_mesh)) {
+        vulkan->occlusion_culled = vulkan->benchmark_draws > 0
+            ? vulkan->benchmark_draws
+            : 1;
+    } else if (vulkan->benchmark_mesh != nullptr) {
+        const struct mesh *mesh = vulkan->benchmark_mesh;
+        const struct pipeline_variant *variant = (
+            mesh->format == VERTEXFORMAT_FLOAT32 ?
+            &vulkan->float32_variant :
+            &vulkan->variant
+        );
+        if (!vulkan_variant_bind(vulkan, command_buffer, variant)) {
+            return false;
+        }
+        descriptors_bind(
+            &vulkan->descriptors, command_buffer, vulkan->program.layout, 0, 0
+        );
+        mesh_bind(mesh, command_buffer, vulkan->program.layout);
+        for (size_t i = 0; i < vulkan->benchmark_draws; i++) {
+            mesh_draw(mesh, command_buffer);
+        }
+    } else if (vulkan->benchmark_draws > 0) {
+        mesh_bind(&vulkan->mesh, command_buffer, vulkan->program.layout);
+
+        uint32_t bound_material = UINT32_MAX;
+        for (size_t i = 0; i < vulkan->benchmark_draws; i++) {
+            const struct pipeline_variant *variant = (
+                &vulkan->scene_variants[i % SCENE_VARIANTS_COUNT]
+            );
+            if (!vulkan_variant_bind(vulkan, command_buffer, variant)) {
+                return false;
+            }
+
+            // Every variant shares the program layout, so a set stays bound
+            // across pipeline and shader changes
+            uint32_t material = i % vulkan->materials_count;
+            if (material != bound_material) {
+                descriptors_bind(
+                    &vulkan->descriptors,
+                    command_buffer,
+                    vulkan->program.layout,
+                    0,
+                    material
+                );
+                bound_material = material;
+            }
+            if (!vulkan_mesh_draw(vulkan, command_buffer)) {
+                return false;
+            }
+        }
+    } else {
+        if (!vulkan_variant_bind(vulkan, command_buffer, &vulkan->variant)) {
+            return false;
+        }
+        descriptors_bind(
+            &vulkan->descriptors, command_buffer, vulkan->program.layout, 0, 0
+        );
+        mesh_bind(&vulkan->mesh, command_buffer, vulkan->program.layout);
+        if (!vulkan_mesh_draw(vulkan, command_buffer)) {
+            return false;
+        }
+    }
+
+    // Debug lines go over the scene but under the sprites
+    debugdraw_record(
+        &vulkan->debugdraw, command_buffer, vulkan->swapchain_extent, VIEW_PROJECTION
+    );
+
+    if (vulkan->timestamps_enabled) {
+        vkCmdWriteTimestamp(
+            command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vulkan->timestamps, 2
+        );
+    }
+
+    // Sprites go over the scene
+    sprites_record(&vulkan->sprites, command_buffer, vulkan->swapchain_extent);
+
+    vkCmdEndRenderPass(command_buffer);
+
+    if (vulkan->timestamps_enabled) {
+        vkCmdWriteTimestamp(
+            command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vulkan->timestamps, 1
+        );
+    }
+
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+        fprintf(stderr, "vulkan_commandbuffer_record: vkEndCommandBuffer failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] vulkan
+/// @return `true` on success and `false` otherwise
+static bool vulkan_synchronizationobjects_create(struct vulkan *vulkan) {
+    VkSemaphoreCreateInfo semaphore_create_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+    };
+
+    if (vkCreateSemaphore(
+        vulkan->device,
+        &semaphore_create_info,
+        nullptr,
+        &vulkan->swapchain_image_available
+    ) != VK_SUCCESS) {
         fprintf(
             stderr,
             "vulkan_scynhronizationobjects_create: "
@@ -1071,262 +2682,3261 @@ static bool vulkan_synchronizationobjects_create(struct vulkan *vulkan) {
         return false;
     }
 
-    VkFenceCreateInfo frames_in_flight_create_info = {
-        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        .flags = VK_FENCE_CREATE_SIGNALED_BIT,
-    };
+    VkFenceCreateInfo frames_in_flight_create_info = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+    };
+
+    if (vkCreateFence(
+        vulkan->device, &frames_in_flight_create_info, nullptr, &vulkan->frame_in_flight
+    ) != VK_SUCCESS) {
+        fprintf(
+            stderr,
+            "vulkan_scynhronizationobjects_create: "
+            "vkCreateFence(frames_in_flight) failed"
+        );
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] vulkan
+/// @return `true` on success and `false` otherwise
+/// @note Leaves `timestamps` unset if the device cannot write timestamps on
+/// the graphics queue
+static bool vulkan_timestamps_create(struct vulkan *vulkan) {
+    const VkPhysicalDeviceLimits *limits = &vulkan->physicaldevice_properties.limits;
+    if (limits->timestampComputeAndGraphics != VK_TRUE) {
+        return true;
+    }
+
+    VkQueryPoolCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = 3,
+    };
+
+    if (vkCreateQueryPool(
+        vulkan->device, &create_info, nullptr, &vulkan->timestamps
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "vulkan_timestamps_create: vkCreateQueryPool failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// Timestamps of a single frame on its way from input sampling to the display.
+/// All times come from `stats_time_now` and zero means "not recorded".
+struct frame_packet {
+    uint64_t index;
+    uint64_t present_id;
+
+    uint64_t input_time;
+    uint64_t acquire_time;
+    uint64_t descriptors_time;
+    uint64_t record_time;
+    uint64_t submit_time;
+    uint64_t present_time;
+    uint64_t present_done_time;
+};
+
+/// @param[in,out] vulkan
+/// @param[in,out] packet
+/// @return `true` on success and `false` otherwise
+static bool vulkan_frame_draw(struct vulkan *vulkan, struct frame_packet *packet) {
+    variantcache_update(&vulkan->variantcache);
+
+    vkWaitForFences(vulkan->device, 1, &vulkan->frame_in_flight, VK_TRUE, UINT32_MAX);
+    vkResetFences(vulkan->device, 1, &vulkan->frame_in_flight);
+
+    if (vulkan->frame_staging_pending) {
+        staging_release(&vulkan->staging, vulkan->frame_staging_serial);
+        vulkan->frame_staging_pending = false;
+    }
+
+    // The fence has signaled, so the previous frame wrote every timestamp
+    if (vulkan->timestamps_pending) {
+        uint64_t timestamps[3];
+        if (vkGetQueryPoolResults(
+            vulkan->device,
+            vulkan->timestamps,
+            0,
+            3,
+            sizeof(timestamps),
+            timestamps,
+            sizeof(timestamps[0]),
+            VK_QUERY_RESULT_64_BIT
+        ) == VK_SUCCESS) {
+            float period = vulkan->physicaldevice_properties.limits.timestampPeriod;
+            vulkan->gpu_time = (uint64_t) (
+                (double) (timestamps[1] - timestamps[0]) * period
+            );
+            vulkan->gpu_scene_time = (uint64_t) (
+                (double) (timestamps[2] - timestamps[0]) * period
+            );
+        }
+        vulkan->timestamps_pending = false;
+    }
+
+    if (vulkan->gpucull_pending) {
+        gpucull_counts_read(&vulkan->gpucull, &vulkan->gpucull_counts);
+        vulkan->gpucull_pending = false;
+    }
+
+    uint32_t swapchain_image_index;
+    if (vkAcquireNextImageKHR(
+        vulkan->device,
+        vulkan->swapchain,
+        UINT32_MAX,
+        vulkan->swapchain_image_available,
+        VK_NULL_HANDLE,
+        &swapchain_image_index
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "vulkan_frame_draw: vkAcquireNextImageKHR failed\n");
+        return false;
+    }
+    packet->acquire_time = stats_time_now();
+
+    // Rewritten every frame the way per-frame data would be, which is the cost
+    // the descriptor backends are compared by
+    if (!descriptors_write(
+        &vulkan->descriptors, vulkan->material_uniforms, vulkan->materials_count
+    )) {
+        fprintf(stderr, "vulkan_frame_draw: descriptors_write failed\n");
+        return false;
+    }
+    packet->descriptors_time = stats_time_now();
+
+    if (vkResetCommandBuffer(vulkan->command_buffer, 0) != VK_SUCCESS) {
+        fprintf(stderr, "vulkan_frame_draw: vkResetCommandBuffer failed\n");
+        return false;
+    }
+
+    if (vulkan->occluder_indices_count > 0) {
+        occlusion_clear(&vulkan->occlusion);
+        if (!occlusion_render(
+            vulkan->jobs,
+            &vulkan->occlusion,
+            VIEW_PROJECTION,
+            vulkan->occluder_positions,
+            vulkan->occluder_indices,
+            vulkan->occluder_indices_count
+        )) {
+            fprintf(stderr, "vulkan_frame_draw: occlusion_render failed\n");
+            return false;
+        }
+    }
+
+    if (!vulkan_commandbuffer_record(
+        vulkan, vulkan->command_buffer, swapchain_image_index
+    )) {
+        fprintf(stderr, "vulkan_frame_draw: vulkan_commandbuffer failed\n");
+        return false;
+    }
+    packet->record_time = stats_time_now();
+
+    VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pWaitSemaphores = &vulkan->swapchain_image_available,
+        .waitSemaphoreCount = 1,
+        .pWaitDstStageMask = &(VkPipelineStageFlags){
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        },
+        .pCommandBuffers = &vulkan->command_buffer,
+        .commandBufferCount = 1,
+        .pSignalSemaphores = &vulkan->render_finished,
+        .signalSemaphoreCount = 1,
+    };
+
+    if (vkQueueSubmit(
+        vulkan->graphics_queue, 1, &submit_info, vulkan->frame_in_flight
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "vulkan_frame_draw: vkQueueSubmit failed\n");
+        return false;
+    }
+    vulkan->timestamps_pending = vulkan->timestamps_enabled;
+    vulkan->gpucull_pending = vulkan_gpucull_enabled(vulkan);
+
+    if (!staging_submit(&vulkan->staging, &vulkan->frame_staging_serial)) {
+        fprintf(stderr, "vulkan_frame_draw: staging_submit failed\n");
+        return false;
+    }
+    vulkan->frame_staging_pending = true;
+    packet->submit_time = stats_time_now();
+
+    VkPresentIdKHR present_id = {
+        .sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+        .pPresentIds = &packet->present_id,
+        .swapchainCount = 1,
+    };
+
+    VkPresentInfoKHR present_info = {
+        .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+        .pNext = vulkan->present_wait_supported ? &present_id : nullptr,
+        .pWaitSemaphores = &vulkan->render_finished,
+        .waitSemaphoreCount = 1,
+        .pSwapchains = &vulkan->swapchain,
+        .swapchainCount = 1,
+        .pImageIndices = &swapchain_image_index,
+        .pResults = nullptr,
+    };
+
+    if (vkQueuePresentKHR(vulkan->present_queue, &present_info) != VK_SUCCESS) {
+        fprintf(stderr, "vulkan_frame_draw: vkQueuePresentKHR failed\n");
+        return false;
+    }
+    packet->present_time = stats_time_now();
+
+    return true;
+}
+
+/// @param[in] vulkan
+/// @param[in] present_id
+/// @return `true` if the presentation tagged with `present_id` has reached the
+/// display and `false` if it is still pending
+/// @note Never blocks; requires `present_wait_supported`
+static bool vulkan_present_done(const struct vulkan *vulkan, uint64_t present_id) {
+    return vulkan->vkWaitForPresentKHR(
+        vulkan->device, vulkan->swapchain, present_id, 0
+    ) == VK_SUCCESS;
+}
+
+/// @param[in,out] vulkan
+/// @return `true` on success and `false` otherwise
+static bool vulkan_init(struct vulkan *vulkan) {
+    if (!vulkan_instance_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_instance_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_surface_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_surface_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_physicaldevice_find(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_physicaldevice_find failed\n");
+        return false;
+    }
+
+    if (!vulkan_queuefamily_find(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_queuefamily_find failed\n");
+        return false;
+    }
+
+    if (!vulkan_device_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_device_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_swapchain_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_swapchain_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_imageviews_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_imageviews_create failed\n");
+        return false;
+    }
+
+    if (
+        !vulkan_renderpass_create(vulkan, false, &vulkan->render_pass) ||
+        !vulkan_renderpass_create(vulkan, true, &vulkan->render_pass_load)
+    ) {
+        fprintf(stderr, "vulkan_init: vulkan_renderpass_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_graphicspipeline_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_graphicspipeline_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_materials_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_materials_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_mesh_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_mesh_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_framebuffers_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_framebuffers_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_commandpool_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_commandpool_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_commandbuffer_allocate(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_commandbuffer_allocate failed\n");
+        return false;
+    }
+
+    if (!vulkan_textures_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_textures_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_sprites_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_sprites_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_debugdraw_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_debugdraw_create failed\n");
+        return false;
+    }
+
+    if (!occlusion_create(OCCLUSION_WIDTH, OCCLUSION_HEIGHT, &vulkan->occlusion)) {
+        fprintf(stderr, "vulkan_init: occlusion_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_gpucull_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_gpucull_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_synchronizationobjects_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_synchronizationobjects_create failed\n");
+        return false;
+    }
+
+    if (!vulkan_timestamps_create(vulkan)) {
+        fprintf(stderr, "vulkan_init: vulkan_timestamps_create failed\n");
+        return false;
+    }
+    vulkan->timestamps_enabled = (
+        vulkan->benchmark && vulkan->timestamps != VK_NULL_HANDLE
+    );
+
+    return true;
+}
+
+struct application_config {
+    const char *title;
+    int width;
+    int height;
+
+    bool debug;
+    bool shader_objects;
+    bool benchmark;
+    const char *mesh;
+    /// Show the HUD from the start instead of after pressing H
+    bool hud;
+};
+
+constexpr uint8_t MAX_PENDING_PRESENTS = 16;
+
+struct application_latency {
+    struct stats_series input_to_acquire;
+    struct stats_series input_to_submit;
+    struct stats_series input_to_present;
+    struct stats_series input_to_present_done;
+    struct stats_series frame_interval;
+};
+
+struct application {
+    GLFWwindow *window;
+
+    struct jobs jobs;
+    struct streaming streaming;
+    struct vulkan vulkan;
+    struct hud hud;
+    /// Draw the bounds of the mesh with debug lines, in debug builds
+    bool bounds_enabled;
+
+    uint64_t frame_index;
+    uint64_t last_present_time;
+
+    /// Arrival time of the newest input event not yet consumed by a frame
+    uint64_t input_time;
+
+    /// Frames carrying input whose presentation has not completed yet, oldest
+    /// first
+    struct frame_packet pending_presents[MAX_PENDING_PRESENTS];
+    size_t pending_presents_count;
+
+    struct application_latency latency;
+};
+
+/// @param[in,out] application
+/// @param[in] enabled
+static void application_hud_enable(struct application *application, bool enabled) {
+    struct vulkan *vulkan = &application->vulkan;
+
+    // Timestamps are only written while someone looks at them
+    application->hud.enabled = enabled;
+    vulkan->timestamps_enabled = (
+        (vulkan->benchmark || enabled) && vulkan->timestamps != VK_NULL_HANDLE
+    );
+    if (enabled) {
+        vulkan->gpu_time = 0;
+        vulkan->gpu_scene_time = 0;
+    }
+}
+
+/// @param[in] window
+static void application_input_record(GLFWwindow *window) {
+    struct application *application = glfwGetWindowUserPointer(window);
+    application->input_time = stats_time_now();
+}
+
+static void application_key_callback(
+    GLFWwindow *window, int key, int scancode, int action, int mods
+) {
+    (void) scancode;
+    (void) mods;
+    application_input_record(window);
+
+    if (action != GLFW_PRESS) {
+        return;
+    }
+
+    struct application *application = glfwGetWindowUserPointer(window);
+    uint32_t *constants = application->vulkan.variant.constants.values;
+    struct pipeline_state *state = &application->vulkan.variant.state;
+
+    switch (key) {
+    case GLFW_KEY_B:
+        state->blend_enable = !state->blend_enable;
+        break;
+    case GLFW_KEY_C:
+        for (size_t i = 0; i < CULL_MODES_COUNT; i++) {
+            if (CULL_MODES[i] == state->cull_mode) {
+                state->cull_mode = CULL_MODES[(i + 1) % CULL_MODES_COUNT];
+                break;
+            }
+        }
+        break;
+    case GLFW_KEY_F:
+        state->front_face = (
+            state->front_face == VK_FRONT_FACE_CLOCKWISE ?
+            VK_FRONT_FACE_COUNTER_CLOCKWISE :
+            VK_FRONT_FACE_CLOCKWISE
+        );
+        break;
+    case GLFW_KEY_D:
+        application->bounds_enabled = !application->bounds_enabled;
+        break;
+    case GLFW_KEY_G:
+        constants[SHADER_CONSTANT_GRAYSCALE] = !constants[SHADER_CONSTANT_GRAYSCALE];
+        break;
+    case GLFW_KEY_H:
+        application_hud_enable(application, !application->hud.enabled);
+        break;
+    case GLFW_KEY_N:
+        // Cycles through 0, 1, 2, 4 and 8 octaves
+        if (constants[SHADER_CONSTANT_NOISE_OCTAVES] == 0) {
+            constants[SHADER_CONSTANT_NOISE_OCTAVES] = 1;
+        } else if (constants[SHADER_CONSTANT_NOISE_OCTAVES] < 8) {
+            constants[SHADER_CONSTANT_NOISE_OCTAVES] *= 2;
+        } else {
+            constants[SHADER_CONSTANT_NOISE_OCTAVES] = 0;
+        }
+        break;
+    }
+}
+
+static void application_mousebutton_callback(
+    GLFWwindow *window, int button, int action, int mods
+) {
+    (void) button;
+    (void) action;
+    (void) mods;
+    application_input_record(window);
+}
+
+static void application_cursorpos_callback(GLFWwindow *window, double x, double y) {
+    (void) x;
+    (void) y;
+    application_input_record(window);
+}
+
+static void application_scroll_callback(GLFWwindow *window, double x, double y) {
+    (void) x;
+    (void) y;
+    application_input_record(window);
+}
+
+/// @param[in] config
+/// @param[out] application
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `application_destroy` after
+/// `application` is no longer needed
+static bool application_create(
+    const struct application_config *config,
+    struct application *application
+) {
+    if (glfwInit() != GLFW_TRUE) {
+        fprintf(stderr, "application_create: glfwInit failed\n");
+        return false;
+    }
+
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+
+    GLFWwindow *window = glfwCreateWindow(
+        config->width,
+        config->height,
+        config->title,
+        nullptr,
+        nullptr
+    );
+    if (window == nullptr) {
+        fprintf(stderr, "application_create: glfwCreateWindow failed\n");
+        return false;
+    }
+
+    application->window = window;
+    application->vulkan.window = window;
+
+    if (!jobs_create(&application->jobs, 0)) {
+        fprintf(stderr, "application_create: jobs_create failed\n");
+        return false;
+    }
+    application->vulkan.jobs = &application->jobs;
+
+    if (!streaming_create(&application->streaming)) {
+        fprintf(stderr, "application_create: streaming_create failed\n");
+        return false;
+    }
+    application->vulkan.streaming = &application->streaming;
+    fprintf(
+        stderr,
+        "application_create: streaming with %s\n",
+        application->streaming.uring ? "io_uring" : "pread"
+    );
+
+    if (
+        file_exists(ASSETS_FILENAME) &&
+        !archive_open(ASSETS_FILENAME, &application->vulkan.archive)
+    ) {
+        fprintf(stderr, "application_create: archive_open failed\n");
+        return false;
+    }
+
+    application->latency = (struct application_latency){
+        .input_to_acquire.name = "latency input->acquire",
+        .input_to_submit.name = "latency input->submit",
+        .input_to_present.name = "latency input->present",
+        .input_to_present_done.name = "latency input->present done",
+        .frame_interval.name = "frame interval",
+    };
+
+    glfwSetWindowUserPointer(window, application);
+    glfwSetKeyCallback(window, application_key_callback);
+    glfwSetMouseButtonCallback(window, application_mousebutton_callback);
+    glfwSetCursorPosCallback(window, application_cursorpos_callback);
+    glfwSetScrollCallback(window, application_scroll_callback);
+    application->vulkan.application_name = config->title;
+    application->vulkan.enable_validation_layers = config->debug;
+    application->vulkan.shaderobjects_requested = config->shader_objects;
+    application->vulkan.benchmark = config->benchmark;
+    application->vulkan.mesh_filename = config->mesh;
+
+    if (!vulkan_init(&application->vulkan)) {
+        fprintf(stderr, "application_create: vulkan_init failed\n");
+        return false;
+    }
+
+    if (!hud_create(&application->vulkan.sprites, &application->hud)) {
+        fprintf(stderr, "application_create: hud_create failed\n");
+        return false;
+    }
+    application_hud_enable(application, config->hud);
+
+    return true;
+}
+
+/// @param[in,out] application
+/// @note `application` will be invalid after this function has been called
+static void application_destroy(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+
+    if (vulkan->device != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(vulkan->device);
+    }
+
+    vkDestroySemaphore(vulkan->device, vulkan->swapchain_image_available, nullptr);
+    vkDestroySemaphore(vulkan->device, vulkan->render_finished, nullptr);
+    vkDestroyFence(vulkan->device, vulkan->frame_in_flight, nullptr);
+    vkDestroyQueryPool(vulkan->device, vulkan->timestamps, nullptr);
+    if (vulkan->gpucull_supported) {
+        gpucull_destroy(&vulkan->gpucull);
+    }
+    occlusion_destroy(&vulkan->occlusion);
+    debugdraw_destroy(&vulkan->debugdraw);
+    sprites_destroy(&vulkan->sprites);
+    mipgen_destroy(&vulkan->mipgen);
+    samplercache_destroy(&vulkan->samplercache);
+    staging_destroy(&vulkan->staging);
+    vkDestroyCommandPool(vulkan->device, vulkan->command_pool, nullptr);
+    for (size_t i = 0; i < application->vulkan.swapchain_framebuffers_count; i++) {
+      vkDestroyFramebuffer(vulkan->device, vulkan->swapchain_framebuffers[i], nullptr);
+    }
+    if (vulkan->shaderobjects_supported) {
+        shaderobjects_destroy(&vulkan->shaderobjects);
+    }
+    mesh_destroy(vulkan->device, &vulkan->mesh);
+    descriptors_destroy(&vulkan->descriptors);
+    buffer_destroy(vulkan->device, &vulkan->materials);
+    variantcache_destroy(&vulkan->variantcache, PIPELINE_CACHE_FILENAME);
+    pipeline_program_destroy(vulkan->device, &vulkan->program);
+    layoutcache_destroy(&vulkan->descriptorset_layoutcache);
+    layoutcache_destroy(&vulkan->layoutcache);
+    vkDestroyRenderPass(vulkan->device, vulkan->render_pass_load, nullptr);
+    vkDestroyRenderPass(vulkan->device, vulkan->render_pass, nullptr);
+    for (size_t i = 0; i < vulkan->swapchain_imageviews_count; i++) {
+      vkDestroyImageView(vulkan->device, vulkan->swapchain_imageviews[i], nullptr);
+    }
+    vkDestroySwapchainKHR(vulkan->device, vulkan->swapchain, nullptr);
+    vkDestroyDevice(vulkan->device, nullptr);
+    vkDestroySurfaceKHR(vulkan->instance, vulkan->surface, nullptr);
+    vkDestroyInstance(vulkan->instance, nullptr);
+    // The decompression still reads its entry from the archive
+    if (vulkan->mesh_decode.blob != nullptr) {
+        jobs_counter_wait(vulkan->jobs, &vulkan->mesh_decode.counter);
+        free(vulkan->mesh_decode.data);
+        free(vulkan->mesh_decode.blob);
+    }
+    archive_close(&vulkan->archive);
+    streaming_destroy(&application->streaming);
+    jobs_destroy(&application->jobs);
+    glfwDestroyWindow(application->window);
+    glfwTerminate();
+}
+
+/// @param[in,out] application
+/// @param[in] packet
+static void application_frame_record(
+    struct application *application, const struct frame_packet *packet
+) {
+    struct application_latency *latency = &application->latency;
+
+    if (application->last_present_time != 0) {
+        stats_series_record(
+            &latency->frame_interval,
+            packet->present_time - application->last_present_time
+        );
+    }
+    application->last_present_time = packet->present_time;
+
+    if (packet->input_time == 0) {
+        return;
+    }
+
+    stats_series_record(
+        &latency->input_to_acquire, packet->acquire_time - packet->input_time
+    );
+    stats_series_record(
+        &latency->input_to_submit, packet->submit_time - packet->input_time
+    );
+    stats_series_record(
+        &latency->input_to_present, packet->present_time - packet->input_time
+    );
+
+    if (!application->vulkan.present_wait_supported) {
+        return;
+    }
+
+    if (application->pending_presents_count == MAX_PENDING_PRESENTS) {
+        memmove(
+            &application->pending_presents[0],
+            &application->pending_presents[1],
+            sizeof(application->pending_presents[0]) * (MAX_PENDING_PRESENTS - 1)
+        );
+        application->pending_presents_count--;
+    }
+    application->pending_presents[application->pending_presents_count++] = *packet;
+}
+
+/// @param[in,out] application
+/// @note Completion time is observed when polled, so it is accurate to within
+/// one iteration of the main loop
+static void application_presents_poll(struct application *application) {
+    size_t done_count = 0;
+
+    for (size_t i = 0; i < application->pending_presents_count; i++) {
+        struct frame_packet *packet = &application->pending_presents[i];
+        if (!vulkan_present_done(&application->vulkan, packet->present_id)) {
+            break;
+        }
+
+        packet->present_done_time = stats_time_now();
+        stats_series_record(
+            &application->latency.input_to_present_done,
+            packet->present_done_time - packet->input_time
+        );
+        done_count++;
+    }
+
+    application->pending_presents_count -= done_count;
+    memmove(
+        &application->pending_presents[0],
+        &application->pending_presents[done_count],
+        sizeof(application->pending_presents[0]) * application->pending_presents_count
+    );
+}
+
+/// @param[in] application
+/// @param[in] stream
+static void application_latency_report(
+    const struct application *application, FILE *stream
+) {
+    const struct application_latency *latency = &application->latency;
+
+    stats_series_report(&latency->frame_interval, stream);
+    stats_series_report(&latency->input_to_acquire, stream);
+    stats_series_report(&latency->input_to_submit, stream);
+    stats_series_report(&latency->input_to_present, stream);
+    if (application->vulkan.present_wait_supported) {
+        stats_series_report(&latency->input_to_present_done, stream);
+    }
+}
+
+/// @param[in] vulkan
+/// @param[out] frame Receives the size and, where known, the usage of every
+/// heap
+static void vulkan_heaps_query(const struct vulkan *vulkan, struct hud_frame *frame) {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+    };
+    if (vulkan->memory_budget_supported) {
+        // Usage changes as memory is allocated, so it is queried every time
+        vkGetPhysicalDeviceMemoryProperties2(
+            vulkan->physicaldevice,
+            &(VkPhysicalDeviceMemoryProperties2){
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+                .pNext = &budget,
+            }
+        );
+    }
+
+    const VkPhysicalDeviceMemoryProperties *properties = &vulkan->memory_properties;
+    frame->heaps_count = properties->memoryHeapCount;
+    for (uint32_t i = 0; i < properties->memoryHeapCount; i++) {
+        frame->heap_sizes[i] = properties->memoryHeaps[i].size;
+        frame->heap_usages[i] = budget.heapUsage[i];
+    }
+}
+
+/// Appends the HUD to the frame after `packet`
+/// @param[in,out] application
+/// @param[in] packet Frame just presented, before `application_frame_record`
+/// @return `true` on success and `false` otherwise
+static bool application_hud_draw(
+    struct application *application, const struct frame_packet *packet
+) {
+    struct vulkan *vulkan = &application->vulkan;
+
+    // Device times arrive a frame late, so they lag the host times by one
+    struct hud_frame frame = {
+        .frame_time = (
+            application->last_present_time != 0 ?
+            packet->present_time - application->last_present_time :
+            0
+        ),
+        .cpu_time = packet->submit_time - packet->acquire_time,
+        .gpu_time = vulkan->gpu_time,
+        .gpu_scene_time = vulkan->gpu_scene_time,
+    };
+    vulkan_heaps_query(vulkan, &frame);
+
+    if (!hud_draw(&application->hud, &vulkan->sprites, &frame)) {
+        fprintf(stderr, "application_hud_draw: hud_draw failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// Draws the bounding box of the mesh and the sphere around it
+/// @param[in,out] vulkan
+static void vulkan_bounds_draw(struct vulkan *vulkan) {
+    const struct mesh *mesh = &vulkan->mesh;
+
+    float center[3];
+    float radius = 0.0f;
+    for (size_t i = 0; i < 3; i++) {
+        center[i] = 0.5f * (mesh->bounds_min[i] + mesh->bounds_max[i]);
+        float extent = 0.5f * (mesh->bounds_max[i] - mesh->bounds_min[i]);
+        radius += extent * extent;
+    }
+
+    debugdraw_box(&vulkan->debugdraw, mesh->bounds_min, mesh->bounds_max, 0xff00ff00);
+    debugdraw_sphere(&vulkan->debugdraw, center, sqrtf(radius), 0xff00ffff);
+}
+
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_mainloop(struct application *application) {
+    while (!glfwWindowShouldClose(application->window)) {
+        glfwPollEvents();
+
+        if (!vulkan_uploads_poll(&application->vulkan)) {
+            fprintf(stderr, "application_mainloop: vulkan_uploads_poll failed\n");
+        }
+
+        if (application->bounds_enabled) {
+            vulkan_bounds_draw(&application->vulkan);
+        }
+
+        struct frame_packet packet = {
+            .index = application->frame_index,
+            .present_id = application->frame_index + 1,
+            .input_time = application->input_time,
+        };
+        application->frame_index++;
+        application->input_time = 0;
+
+        if (!vulkan_frame_draw(&application->vulkan, &packet)) {
+            fprintf(stderr, "application_mainloop: vulkan_drawframe failed\n");
+            continue;
+        }
+
+        if (
+            application->hud.enabled &&
+            !application_hud_draw(application, &packet)
+        ) {
+            fprintf(stderr, "application_mainloop: application_hud_draw failed\n");
+        }
+
+        application_frame_record(application, &packet);
+        if (application->vulkan.present_wait_supported) {
+            application_presents_poll(application);
+        }
+    }
+
+    application_latency_report(application, stderr);
+
+    return true;
+}
+
+constexpr size_t BENCHMARK_FRAMES = 256;
+constexpr size_t BENCHMARK_DRAWS = 4096;
+
+/// @param[in,out] application
+/// @param[out] update Descriptor writing time of each frame, may be `nullptr`
+/// @param[out] record Command buffer recording time of each frame
+/// @param[out] gpu Device time of each frame, may be `nullptr`
+/// @return `true` on success and `false` otherwise
+/// @note Only samples are added, the series have to be named by the caller
+static bool application_benchmark_frames(
+    struct application *application,
+    struct stats_series *update,
+    struct stats_series *record,
+    struct stats_series *gpu
+) {
+    struct vulkan *vulkan = &application->vulkan;
+
+    for (size_t i = 0; i < BENCHMARK_FRAMES; i++) {
+        glfwPollEvents();
+
+        struct frame_packet packet = {
+            .index = application->frame_index,
+            .present_id = application->frame_index + 1,
+        };
+        application->frame_index++;
+
+        if (!vulkan_frame_draw(vulkan, &packet)) {
+            fprintf(stderr, "application_benchmark_frames: vulkan_frame_draw failed\n");
+            return false;
+        }
+        if (update != nullptr) {
+            stats_series_record(update, packet.descriptors_time - packet.acquire_time);
+        }
+        stats_series_record(record, packet.record_time - packet.descriptors_time);
+
+        // Device times arrive a frame late, the first one belongs to whatever
+        // was drawn before
+        if (gpu != nullptr && vulkan->timestamps != VK_NULL_HANDLE && i > 0) {
+            stats_series_record(gpu, vulkan->gpu_time);
+        }
+    }
+
+    vkDeviceWaitIdle(vulkan->device);
+
+    return true;
+}
+
+/// Writes the materials into classic descriptor sets without drawing with
+/// them, since pipelines created for descriptor buffers cannot use sets
+/// @param[in,out] application
+/// @param[out] update Descriptor writing time of each frame
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_descriptorsets(
+    struct application *application, struct stats_series *update
+) {
+    struct vulkan *vulkan = &application->vulkan;
+    bool success = false;
+
+    // Set layouts for descriptor sets must not have the descriptor buffer flag
+    struct layoutcache layoutcache;
+    layoutcache_create(vulkan->device, 0, &layoutcache);
+    struct descriptors descriptors = {};
+
+    VkPipelineLayout layout;
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS];
+    uint32_t setlayouts_count;
+    if (!layoutcache_pipelinelayout_get(
+        &layoutcache, &vulkan->program.reflection, &layout, setlayouts, &setlayouts_count
+    )) {
+        fprintf(
+            stderr,
+            "application_benchmark_descriptorsets: "
+            "layoutcache_pipelinelayout_get failed\n"
+        );
+        goto cleanup;
+    }
+
+    if (!descriptors_create(
+        vulkan->device,
+        &vulkan->memory_properties,
+        nullptr,
+        setlayouts[0],
+        0,
+        MATERIALS_COUNT,
+        &descriptors
+    )) {
+        fprintf(
+            stderr, "application_benchmark_descriptorsets: descriptors_create failed\n"
+        );
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < BENCHMARK_FRAMES; i++) {
+        uint64_t start_time = stats_time_now();
+        if (!descriptors_write(
+            &descriptors, vulkan->material_uniforms, MATERIALS_COUNT
+        )) {
+            fprintf(
+                stderr,
+                "application_benchmark_descriptorsets: descriptors_write failed\n"
+            );
+            goto cleanup;
+        }
+        stats_series_record(update, stats_time_now() - start_time);
+    }
+
+    success = true;
+
+cleanup:
+    descriptors_destroy(&descriptors);
+    layoutcache_destroy(&layoutcache);
+
+    return success;
+}
+
+constexpr uint32_t BENCHMARK_GRID_SIZE = 512;
+constexpr size_t BENCHMARK_MESH_DRAWS = 16;
+
+/// Builds a `BENCHMARK_GRID_SIZE` squared grid of vertices displaced into a
+/// wave, with normals, UVs and colors that vary per vertex so that nothing
+/// quantizes trivially
+/// @param[out] vertices `BENCHMARK_GRID_SIZE * BENCHMARK_GRID_SIZE` vertices
+/// @param[out] indices `6 * (BENCHMARK_GRID_SIZE - 1) ^ 2` indices
+static void application_benchmark_grid(
+    struct vertexformat_vertex *vertices, uint32_t *indices
+) {
+    constexpr uint32_t size = BENCHMARK_GRID_SIZE;
+
+    for (uint32_t row = 0; row < size; row++) {
+        for (uint32_t column = 0; column < size; column++) {
+            float u = (float) column / (float) (size - 1);
+            float v = (float) row / (float) (size - 1);
+            float x = -0.9f + 1.8f * u;
+            float y = -0.9f + 1.8f * v;
+
+            float dzdx = 2.0f * cosf(8.0f * x) * cosf(8.0f * y);
+            float dzdy = -2.0f * sinf(8.0f * x) * sinf(8.0f * y);
+            float length = sqrtf(dzdx * dzdx + dzdy * dzdy + 1.0f);
+
+            vertices[row * size + column] = (struct vertexformat_vertex){
+                .position = {x, y, 0.25f + 0.25f * sinf(8.0f * x) * cosf(8.0f * y)},
+                .normal = {dzdx / length, dzdy / length, -1.0f / length},
+                .uv = {u, v},
+                .color = {u, v, 1.0f - u, 1.0f},
+            };
+        }
+    }
+
+    // Clockwise like the triangle the rest of the application draws
+    size_t index = 0;
+    for (uint32_t row = 0; row + 1 < size; row++) {
+        for (uint32_t column = 0; column + 1 < size; column++) {
+            uint32_t corner = row * size + column;
+            indices[index++] = corner;
+            indices[index++] = corner + 1;
+            indices[index++] = corner + size;
+            indices[index++] = corner + 1;
+            indices[index++] = corner + size + 1;
+            indices[index++] = corner + size;
+        }
+    }
+}
+
+/// Draws the same grid from float32 and from quantized vertices
+/// `BENCHMARK_MESH_DRAWS` times per frame, so vertex fetch dominates the
+/// device time
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_vertices(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series record[VERTEXFORMAT_COUNT] = {
+        [VERTEXFORMAT_FLOAT32] = {.name = "float32 vertices record"},
+        [VERTEXFORMAT_QUANTIZED] = {.name = "quantized vertices record"},
+    };
+    static struct stats_series gpu[VERTEXFORMAT_COUNT] = {
+        [VERTEXFORMAT_FLOAT32] = {.name = "float32 vertices gpu"},
+        [VERTEXFORMAT_QUANTIZED] = {.name = "quantized vertices gpu"},
+    };
+    static const enum vertexformat formats[] = {
+        VERTEXFORMAT_FLOAT32,
+        VERTEXFORMAT_QUANTIZED,
+    };
+    bool success = false;
+
+    constexpr uint32_t vertices_count = BENCHMARK_GRID_SIZE * BENCHMARK_GRID_SIZE;
+    constexpr uint32_t indices_count = (
+        6 * (BENCHMARK_GRID_SIZE - 1) * (BENCHMARK_GRID_SIZE - 1)
+    );
+    struct vertexformat_vertex *vertices = malloc(sizeof(vertices[0]) * vertices_count);
+    uint32_t *indices = malloc(sizeof(indices[0]) * indices_count);
+    struct mesh meshes[VERTEXFORMAT_COUNT] = {};
+    if (vertices == nullptr || indices == nullptr) {
+        fprintf(stderr, "application_benchmark_vertices: malloc failed\n");
+        goto cleanup;
+    }
+
+    application_benchmark_grid(vertices, indices);
+
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        enum vertexformat format = formats[i];
+        if (!mesh_create(
+            vulkan->device,
+            &vulkan->memory_properties,
+            format,
+            vertices,
+            vertices_count,
+            indices,
+            indices_count,
+            &meshes[format]
+        )) {
+            fprintf(stderr, "application_benchmark_vertices: mesh_create failed\n");
+            goto cleanup;
+        }
+    }
+
+    vulkan->benchmark_draws = BENCHMARK_MESH_DRAWS;
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        enum vertexformat format = formats[i];
+
+        vulkan->benchmark_mesh = &meshes[format];
+        if (!application_benchmark_frames(
+            application, nullptr, &record[format], &gpu[format]
+        )) {
+            vulkan->benchmark_mesh = nullptr;
+            goto cleanup;
+        }
+        vulkan->benchmark_mesh = nullptr;
+
+        size_t stride = vertexformat_stride(format);
+        fprintf(
+            stderr,
+            "%s vertices: %zu bytes per vertex, %.1f KiB\n",
+            format == VERTEXFORMAT_FLOAT32 ? "float32" : "quantized",
+            stride,
+            (double) (stride * vertices_count) / 1024.0
+        );
+        stats_series_report(&record[format], stderr);
+
+        if (vulkan->timestamps == VK_NULL_HANDLE) {
+            fprintf(stderr, "gpu timestamps: not supported\n");
+            continue;
+        }
+        stats_series_report(&gpu[format], stderr);
+        uint64_t median = stats_series_median(&gpu[format]);
+        if (median > 0) {
+            fprintf(
+                stderr,
+                "%s vertices: %.1f M vertices/s\n",
+                format == VERTEXFORMAT_FLOAT32 ? "float32" : "quantized",
+                (double) indices_count * BENCHMARK_MESH_DRAWS / (double) median * 1e3
+            );
+        }
+    }
+
+    success = true;
+
+cleanup:
+    vulkan->benchmark_draws = 0;
+    for (size_t i = 0; i < VERTEXFORMAT_COUNT; i++) {
+        mesh_destroy(vulkan->device, &meshes[i]);
+    }
+    free(indices);
+    free(vertices);
+
+    return success;
+}
+
+constexpr size_t BENCHMARK_DECODE_RUNS = 32;
+
+/// Uploads a chunked archive blob as it is stored into a buffer the device
+/// reads and decompresses it there with `shaders/decompress.glsl`
+/// @param[in,out] application
+/// @param[in] entry
+/// @param[in] blob
+/// @param[in] content What `blob` decompresses to
+/// @return `true` on success and `false` otherwise
+/// @note Measures nothing when the device cannot decompress `entry`, which
+/// then stays with `archive_decode`
+static bool application_benchmark_gpudecode(
+    struct application *application,
+    const struct archive_entry *entry,
+    const uint8_t *blob,
+    const uint8_t *content
+) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series upload = {.name = "decode gpu"};
+    static struct stats_series dispatch = {.name = "decode gpu dispatch"};
+    bool success = false;
+
+    uint8_t *code = nullptr;
+    size_t code_size;
+    struct gpudecode gpudecode = {};
+    struct buffer source = {};
+    struct buffer destination = {};
+    struct buffer status = {};
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+
+    if (
+        !vulkan_asset_read(vulkan, "shaders/decompress.spv", &code, &code_size) ||
+        !gpudecode_create(
+            vulkan->device,
+            &vulkan->descriptorset_layoutcache,
+            code,
+            code_size,
+            &gpudecode
+        )
+    ) {
+        fprintf(stderr, "gpu decode: not supported\n");
+        success = true;
+        goto cleanup;
+    }
+
+    // The blob is written straight into memory the device reads, and the
+    // output is read back to be compared
+    struct {
+        struct buffer *buffer;
+        VkDeviceSize size;
+        VkBufferUsageFlags usage;
+    } buffers[] = {
+        {
+            &source,
+            gpudecode_buffer_size(entry->size),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        },
+        {
+            &destination,
+            gpudecode_buffer_size(entry->uncompressed_size),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        },
+        {
+            &status,
+            sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        },
+    };
+    for (size_t i = 0; i < sizeof(buffers) / sizeof(buffers[0]); i++) {
+        if (!buffer_create(
+            vulkan->device,
+            &vulkan->memory_properties,
+            buffers[i].size,
+            buffers[i].usage,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            buffers[i].buffer
+        )) {
+            fprintf(stderr, "application_benchmark_gpudecode: buffer_create failed\n");
+            goto cleanup;
+        }
+    }
+
+    VkCommandBufferAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = vulkan->command_pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    if (vkAllocateCommandBuffers(
+        vulkan->device, &allocate_info, &command_buffer
+    ) != VK_SUCCESS) {
+        fprintf(
+            stderr, "application_benchmark_gpudecode: vkAllocateCommandBuffers failed\n"
+        );
+        goto cleanup;
+    }
+
+    VkFenceCreateInfo fence_info = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    };
+    if (vkCreateFence(vulkan->device, &fence_info, nullptr, &fence) != VK_SUCCESS) {
+        fprintf(stderr, "application_benchmark_gpudecode: vkCreateFence failed\n");
+        goto cleanup;
+    }
+
+    // The timestamps of the last frame are about to be overwritten
+    vkDeviceWaitIdle(vulkan->device);
+    vulkan->timestamps_pending = false;
+
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+    };
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        fprintf(
+            stderr, "application_benchmark_gpudecode: vkBeginCommandBuffer failed\n"
+        );
+        goto cleanup;
+    }
+    if (vulkan->timestamps != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(command_buffer, vulkan->timestamps, 0, 2);
+        vkCmdWriteTimestamp(
+            command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vulkan->timestamps, 0
+        );
+    }
+    bool recorded = gpudecode_record(
+        &gpudecode,
+        command_buffer,
+        entry,
+        source.buffer,
+        destination.buffer,
+        status.buffer
+    );
+    if (vulkan->timestamps != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(
+            command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vulkan->timestamps, 1
+        );
+    }
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+        fprintf(stderr, "application_benchmark_gpudecode: vkEndCommandBuffer failed\n");
+        goto cleanup;
+    }
+    if (!recorded) {
+        fprintf(stderr, "gpu decode: blob is not supported\n");
+        success = true;
+        goto cleanup;
+    }
+
+    VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pCommandBuffers = &command_buffer,
+        .commandBufferCount = 1,
+    };
+    for (size_t i = 0; i < BENCHMARK_DECODE_RUNS; i++) {
+        uint64_t start_time = stats_time_now();
+        memcpy(source.mapped, blob, entry->size);
+        if (vkQueueSubmit(
+            vulkan->graphics_queue, 1, &submit_info, fence
+        ) != VK_SUCCESS) {
+            fprintf(stderr, "application_benchmark_gpudecode: vkQueueSubmit failed\n");
+            goto cleanup;
+        }
+        vkWaitForFences(vulkan->device, 1, &fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(vulkan->device, 1, &fence);
+        stats_series_record(&upload, stats_time_now() - start_time);
+
+        uint64_t timestamps[2];
+        if (vulkan->timestamps != VK_NULL_HANDLE && vkGetQueryPoolResults(
+            vulkan->device,
+            vulkan->timestamps,
+            0,
+            2,
+            sizeof(timestamps),
+            timestamps,
+            sizeof(timestamps[0]),
+            VK_QUERY_RESULT_64_BIT
+        ) == VK_SUCCESS) {
+            stats_series_record(&dispatch, (uint64_t) (
+                (double) (timestamps[1] - timestamps[0]) *
+                vulkan->physicaldevice_properties.limits.timestampPeriod
+            ));
+        }
+    }
+
+    uint32_t failed_chunks = *(const uint32_t *) status.mapped;
+    if (failed_chunks != 0) {
+        fprintf(
+            stderr,
+            "application_benchmark_gpudecode: %u chunks failed to decode\n",
+            failed_chunks
+        );
+        goto cleanup;
+    }
+    if (memcmp(destination.mapped, content, entry->uncompressed_size) != 0) {
+        fprintf(stderr, "application_benchmark_gpudecode: decoded content differs\n");
+        goto cleanup;
+    }
+
+    struct stats_series *series[] = {&upload, &dispatch};
+    for (size_t i = 0; i < sizeof(series) / sizeof(series[0]); i++) {
+        if (series[i] == &dispatch && vulkan->timestamps == VK_NULL_HANDLE) {
+            fprintf(stderr, "gpu timestamps: not supported\n");
+            continue;
+        }
+        stats_series_report(series[i], stderr);
+        fprintf(
+            stderr,
+            "%s: %.2f GB/s\n",
+            series[i]->name,
+            (double) entry->uncompressed_size / (double) stats_series_median(series[i])
+        );
+    }
+
+    success = true;
+
+cleanup:
+    vkDestroyFence(vulkan->device, fence, nullptr);
+    if (command_buffer != VK_NULL_HANDLE) {
+        vkFreeCommandBuffers(vulkan->device, vulkan->command_pool, 1, &command_buffer);
+    }
+    buffer_destroy(vulkan->device, &status);
+    buffer_destroy(vulkan->device, &destination);
+    buffer_destroy(vulkan->device, &source);
+    if (gpudecode.device != VK_NULL_HANDLE) {
+        gpudecode_destroy(&gpudecode);
+    }
+    free(code);
+
+    return success;
+}
+
+/// Decompresses the benchmark grid as one chunked archive blob into mapped
+/// staging memory, on the calling thread and on the job system, then on the
+/// device
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_decode(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series serial = {.name = "decode 1 thread"};
+    static struct stats_series parallel = {.name = "decode jobs"};
+    bool success = false;
+
+    constexpr uint32_t vertices_count = BENCHMARK_GRID_SIZE * BENCHMARK_GRID_SIZE;
+    constexpr uint32_t indices_count = (
+        6 * (BENCHMARK_GRID_SIZE - 1) * (BENCHMARK_GRID_SIZE - 1)
+    );
+    size_t vertices_size = sizeof(struct vertexformat_vertex) * vertices_count;
+    size_t content_size = vertices_size + sizeof(uint32_t) * indices_count;
+
+    uint8_t *content = malloc(content_size);
+    uint8_t *blob = malloc(archive_encode_bound(content_size));
+    struct buffer staging = {};
+    if (content == nullptr || blob == nullptr) {
+        fprintf(stderr, "application_benchmark_decode: malloc failed\n");
+        goto cleanup;
+    }
+
+    application_benchmark_grid(
+        (struct vertexformat_vertex *) content, (uint32_t *) (content + vertices_size)
+    );
+
+    struct archive_entry entry = {
+        .size = archive_encode(vulkan->jobs, content, content_size, blob),
+        .uncompressed_size = content_size,
+        .compression = ARCHIVE_COMPRESSION_LZ4_CHUNKED,
+    };
+    if (entry.size == 0) {
+        fprintf(stderr, "application_benchmark_decode: archive_encode failed\n");
+        goto cleanup;
+    }
+
+    if (!buffer_create(
+        vulkan->device,
+        &vulkan->memory_properties,
+        content_size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        0,
+        &staging
+    )) {
+        fprintf(stderr, "application_benchmark_decode: buffer_create failed\n");
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < BENCHMARK_DECODE_RUNS; i++) {
+        uint64_t start_time = stats_time_now();
+        if (!archive_decode(nullptr, &entry, blob, staging.mapped)) {
+            fprintf(stderr, "application_benchmark_decode: archive_decode failed\n");
+            goto cleanup;
+        }
+        uint64_t serial_time = stats_time_now();
+        if (!archive_decode(vulkan->jobs, &entry, blob, staging.mapped)) {
+            fprintf(stderr, "application_benchmark_decode: archive_decode failed\n");
+            goto cleanup;
+        }
+        stats_series_record(&serial, serial_time - start_time);
+        stats_series_record(&parallel, stats_time_now() - serial_time);
+    }
+
+    if (memcmp(staging.mapped, content, content_size) != 0) {
+        fprintf(stderr, "application_benchmark_decode: decoded content differs\n");
+        goto cleanup;
+    }
+
+    fprintf(
+        stderr,
+        "decode: %.1f MiB in %zu chunks compressed to %.1f MiB, %zu workers\n",
+        (double) content_size / (1024.0 * 1024.0),
+        (content_size + ARCHIVE_CHUNK_SIZE - 1) / ARCHIVE_CHUNK_SIZE,
+        (double) entry.size / (1024.0 * 1024.0),
+        application->jobs.threads_count
+    );
+    struct stats_series *series[] = {&serial, &parallel};
+    for (size_t i = 0; i < sizeof(series) / sizeof(series[0]); i++) {
+        stats_series_report(series[i], stderr);
+        fprintf(
+            stderr,
+            "%s: %.2f GB/s\n",
+            series[i]->name,
+            (double) content_size / (double) stats_series_median(series[i])
+        );
+    }
+
+    if (!application_benchmark_gpudecode(application, &entry, blob, content)) {
+        fprintf(
+            stderr,
+            "application_benchmark_decode: application_benchmark_gpudecode failed\n"
+        );
+        goto cleanup;
+    }
+
+    success = true;
+
+cleanup:
+    buffer_destroy(vulkan->device, &staging);
+    free(blob);
+    free(content);
+
+    return success;
+}
+
+constexpr uint32_t BENCHMARK_TEXTURE_SIZE = 1024;
+constexpr size_t BENCHMARK_TEXTURES_COUNT = 8;
+constexpr size_t BENCHMARK_TEXTURE_RUNS = 32;
+
+/// Uploads `BENCHMARK_TEXTURES_COUNT` textures of one KTX2 file through the
+/// staging ring, all of them batched into one submission
+/// @param[in,out] application
+/// @param[in] ktx2 With every level present
+/// @param[in,out] series Time of each upload
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_upload(
+    struct application *application,
+    const struct ktx2 *ktx2,
+    struct stats_series *series
+) {
+    struct vulkan *vulkan = &application->vulkan;
+    bool success = false;
+
+    struct texture textures[BENCHMARK_TEXTURES_COUNT] = {};
+    struct texture_upload uploads[BENCHMARK_TEXTURES_COUNT];
+    VkSampler samplers[BENCHMARK_TEXTURES_COUNT];
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+
+    uint64_t upload_size = 0;
+    for (size_t i = 0; i < BENCHMARK_TEXTURES_COUNT; i++) {
+        if (!texture_create(
+            vulkan->device, &vulkan->memory_properties, ktx2, 0, &textures[i]
+        )) {
+            fprintf(stderr, "application_benchmark_upload: texture_create failed\n");
+            goto cleanup;
+        }
+        uploads[i] = (struct texture_upload){
+            .texture = &textures[i],
+            .ktx2 = ktx2,
+        };
+        for (uint32_t level = 0; level < ktx2->levels_count; level++) {
+            upload_size += ktx2->levels[level].size;
+        }
+    }
+
+    // Textures sampled the same way share one sampler
+    struct samplercache_state sampler_state = {
+        .mag_filter = VK_FILTER_LINEAR,
+        .min_filter = VK_FILTER_LINEAR,
+        .mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        .address_mode_u = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .address_mode_v = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .address_mode_w = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .max_lod = VK_LOD_CLAMP_NONE,
+    };
+    for (size_t i = 0; i < BENCHMARK_TEXTURES_COUNT; i++) {
+        if (!samplercache_get(&vulkan->samplercache, &sampler_state, &samplers[i])) {
+            fprintf(stderr, "application_benchmark_upload: samplercache_get failed\n");
+            goto cleanup;
+        }
+        if (samplers[i] != samplers[0]) {
+            fprintf(stderr, "application_benchmark_upload: samplers differ\n");
+            goto cleanup;
+        }
+    }
+
+    VkCommandBufferAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = vulkan->command_pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    if (vkAllocateCommandBuffers(
+        vulkan->device, &allocate_info, &command_buffer
+    ) != VK_SUCCESS) {
+        fprintf(
+            stderr, "application_benchmark_upload: vkAllocateCommandBuffers failed\n"
+        );
+        goto cleanup;
+    }
+
+    VkFenceCreateInfo fence_info = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    };
+    if (vkCreateFence(vulkan->device, &fence_info, nullptr, &fence) != VK_SUCCESS) {
+        fprintf(stderr, "application_benchmark_upload: vkCreateFence failed\n");
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < BENCHMARK_TEXTURE_RUNS; i++) {
+        uint64_t start_time = stats_time_now();
+
+        VkCommandBufferBeginInfo begin_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+            fprintf(
+                stderr, "application_benchmark_upload: vkBeginCommandBuffer failed\n"
+            );
+            goto cleanup;
+        }
+        if (!texture_upload(
+            &vulkan->staging, command_buffer, uploads, BENCHMARK_TEXTURES_COUNT
+        )) {
+            fprintf(stderr, "application_benchmark_upload: texture_upload failed\n");
+            goto cleanup;
+        }
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+            fprintf(
+                stderr, "application_benchmark_upload: vkEndCommandBuffer failed\n"
+            );
+            goto cleanup;
+        }
+
+        uint64_t serial;
+        if (!staging_submit(&vulkan->staging, &serial)) {
+            fprintf(stderr, "application_benchmark_upload: staging_submit failed\n");
+            goto cleanup;
+        }
+        VkSubmitInfo submit_info = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pCommandBuffers = &command_buffer,
+            .commandBufferCount = 1,
+        };
+        bool submitted = vkQueueSubmit(
+            vulkan->graphics_queue, 1, &submit_info, fence
+        ) == VK_SUCCESS;
+        if (submitted) {
+            vkWaitForFences(vulkan->device, 1, &fence, VK_TRUE, UINT64_MAX);
+            vkResetFences(vulkan->device, 1, &fence);
+        }
+        staging_release(&vulkan->staging, serial);
+        if (!submitted) {
+            fprintf(stderr, "application_benchmark_upload: vkQueueSubmit failed\n");
+            goto cleanup;
+        }
+
+        stats_series_record(series, stats_time_now() - start_time);
+    }
+
+    fprintf(
+        stderr,
+        "%s: %zu of %ux%u with %u levels, %.1f MiB per upload\n",
+        series->name,
+        BENCHMARK_TEXTURES_COUNT,
+        ktx2->width,
+        ktx2->height,
+        ktx2->levels_count,
+        (double) upload_size / (1024.0 * 1024.0)
+    );
+    stats_series_report(series, stderr);
+    fprintf(
+        stderr,
+        "%s: %.2f GB/s\n",
+        series->name,
+        (double) upload_size / (double) stats_series_median(series)
+    );
+
+    success = true;
+
+cleanup:
+    vkDestroyFence(vulkan->device, fence, nullptr);
+    if (command_buffer != VK_NULL_HANDLE) {
+        vkFreeCommandBuffers(vulkan->device, vulkan->command_pool, 1, &command_buffer);
+    }
+    for (size_t i = 0; i < BENCHMARK_TEXTURES_COUNT; i++) {
+        texture_destroy(vulkan->device, &textures[i]);
+    }
+
+    return success;
+}
+
+/// Uploads RGBA8 textures with full mip chains, and the same textures block
+/// compressed where the device samples BC formats
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_textures(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series upload = {.name = "texture upload"};
+    static struct stats_series upload_bc = {.name = "texture upload bc"};
+    bool success = false;
+
+    struct ktx2 description = {
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .width = BENCHMARK_TEXTURE_SIZE,
+        .height = BENCHMARK_TEXTURE_SIZE,
+        .depth = 1,
+        .faces_count = 1,
+    };
+    ktx2_format_block(description.format, &description.block);
+    description.levels_count = ktx2_levels_max(&description);
+
+    uint8_t *texels = nullptr;
+    uint8_t *content = nullptr;
+    uint8_t *compressed_content = nullptr;
+    size_t content_size;
+    const uint8_t *levels[KTX2_MAX_LEVELS];
+
+    // Every level is a checkerboard with squares of eight texels
+    uint64_t texels_size = ktx2_level_image_size(
+        &description.block, description.width, description.height, 1, 0
+    );
+    texels = malloc(texels_size);
+    if (texels == nullptr) {
+        fprintf(stderr, "application_benchmark_textures: malloc failed\n");
+        goto cleanup;
+    }
+    for (uint32_t y = 0; y < BENCHMARK_TEXTURE_SIZE; y++) {
+        for (uint32_t x = 0; x < BENCHMARK_TEXTURE_SIZE; x++) {
+            uint8_t value = ((x ^ y) & 8) != 0 ? 255 : 0;
+            uint8_t *texel = texels + 4 * ((size_t) BENCHMARK_TEXTURE_SIZE * y + x);
+            texel[0] = value;
+            texel[1] = value;
+            texel[2] = value;
+            texel[3] = 255;
+        }
+    }
+
+    for (uint32_t i = 0; i < description.levels_count; i++) {
+        levels[i] = texels;
+    }
+
+    // Goes through a file in memory, as textures loaded from disk do
+    struct ktx2 ktx2;
+    if (!ktx2_encode(&description, levels, &content, &content_size)) {
+        fprintf(stderr, "application_benchmark_textures: ktx2_encode failed\n");
+        goto cleanup;
+    }
+    if (!ktx2_parse(content, content_size, &ktx2)) {
+        fprintf(stderr, "application_benchmark_textures: ktx2_parse failed\n");
+        goto cleanup;
+    }
+
+    if (!application_benchmark_upload(application, &ktx2, &upload)) {
+        fprintf(
+            stderr,
+            "application_benchmark_textures: application_benchmark_upload failed\n"
+        );
+        goto cleanup;
+    }
+
+    struct ktx2 compressed;
+    if (!vulkan_texture_compress(vulkan, &ktx2, &compressed_content, &compressed)) {
+        fprintf(
+            stderr, "application_benchmark_textures: vulkan_texture_compress failed\n"
+        );
+        goto cleanup;
+    }
+    if (compressed_content == nullptr) {
+        fprintf(stderr, "texture upload bc: not supported\n");
+    } else if (!application_benchmark_upload(application, &compressed, &upload_bc)) {
+        fprintf(
+            stderr,
+            "application_benchmark_textures: application_benchmark_upload failed\n"
+        );
+        goto cleanup;
+    }
+
+    success = true;
+
+cleanup:
+    free(compressed_content);
+    free(content);
+    free(texels);
+
+    return success;
+}
+
+constexpr size_t BENCHMARK_BCENC_RUNS = 8;
+
+/// Block compresses an RGBA8 image of `BENCHMARK_TEXTURE_SIZE` into every
+/// format on the job system, and reports the throughput and quality of each
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_bcenc(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series series[] = {
+        [BCENC_FORMAT_BC1] = {.name = "bcenc BC1"},
+        [BCENC_FORMAT_BC3] = {.name = "bcenc BC3"},
+        [BCENC_FORMAT_BC7] = {.name = "bcenc BC7"},
+    };
+    constexpr size_t formats_count = sizeof(series) / sizeof(series[0]);
+    bool success = false;
+
+    size_t texels_count = (size_t) BENCHMARK_TEXTURE_SIZE * BENCHMARK_TEXTURE_SIZE;
+    uint8_t *texels = malloc(4 * texels_count);
+    uint8_t *decoded = malloc(4 * texels_count);
+    uint8_t *blocks = malloc(
+        bcenc_size(BCENC_FORMAT_BC7, BENCHMARK_TEXTURE_SIZE, BENCHMARK_TEXTURE_SIZE)
+    );
+    if (texels == nullptr || decoded == nullptr || blocks == nullptr) {
+        fprintf(stderr, "application_benchmark_bcenc: malloc failed\n");
+        goto cleanup;
+    }
+
+    // Smooth gradients and noise with a soft edge in alpha, closer to a photo
+    // than the checkerboard the upload benchmark uses
+    uint32_t random = 1;
+    for (uint32_t y = 0; y < BENCHMARK_TEXTURE_SIZE; y++) {
+        for (uint32_t x = 0; x < BENCHMARK_TEXTURE_SIZE; x++) {
+            random = random * 1664525 + 1013904223;
+            int32_t noise = (int32_t) (random >> 28) - 8;
+            float u = (float) x / (float) BENCHMARK_TEXTURE_SIZE;
+            float v = (float) y / (float) BENCHMARK_TEXTURE_SIZE;
+            float values[4] = {
+                128.0f + 100.0f * sinf(6.0f * u + 3.0f * v),
+                128.0f + 100.0f * cosf(4.0f * v - 2.0f * u),
+                255.0f * u * v,
+                255.0f * fminf(fmaxf(8.0f * (u - 0.5f) + 0.5f, 0.0f), 1.0f),
+            };
+            uint8_t *texel = texels + 4 * ((size_t) BENCHMARK_TEXTURE_SIZE * y + x);
+            for (uint32_t c = 0; c < 4; c++) {
+                int32_t value = (int32_t) values[c] + (c < 3 ? noise : 0);
+                texel[c] = (uint8_t) (value < 0 ? 0 : value > 255 ? 255 : value);
+            }
+        }
+    }
+
+    fprintf(stderr, "bcenc: kernel %s\n", bcenc_kernel_name());
+    for (size_t format = 0; format < formats_count; format++) {
+        for (size_t i = 0; i < BENCHMARK_BCENC_RUNS; i++) {
+            uint64_t start_time = stats_time_now();
+            if (!bcenc_encode(
+                vulkan->jobs,
+                (enum bcenc_format) format,
+                texels,
+                BENCHMARK_TEXTURE_SIZE,
+                BENCHMARK_TEXTURE_SIZE,
+                blocks
+            )) {
+                fprintf(stderr, "application_benchmark_bcenc: bcenc_encode failed\n");
+                goto cleanup;
+            }
+            stats_series_record(&series[format], stats_time_now() - start_time);
+        }
+
+        if (!bcenc_decode(
+            (enum bcenc_format) format,
+            blocks,
+            BENCHMARK_TEXTURE_SIZE,
+            BENCHMARK_TEXTURE_SIZE,
+            decoded
+        )) {
+            fprintf(stderr, "application_benchmark_bcenc: bcenc_decode failed\n");
+            goto cleanup;
+        }
+        // BC1 is only written opaque, so its alpha is left out
+        uint32_t channels_count = format == BCENC_FORMAT_BC1 ? 3 : 4;
+
+        uint64_t median = stats_series_median(&series[format]);
+
+        stats_series_report(&series[format], stderr);
+        fprintf(
+            stderr,
+            "%s: %.1f MB/s, %.2f dB\n",
+            series[format].name,
+            4.0e3 * (double) texels_count / (double) median,
+            bcenc_psnr(texels, decoded, texels_count, channels_count)
+        );
+    }
+
+    success = true;
+
+cleanup:
+    free(blocks);
+    free(decoded);
+    free(texels);
+
+    return success;
+}
+
+constexpr size_t BENCHMARK_MIPGEN_RUNS = 32;
+
+/// Generates the mips of a texture of `BENCHMARK_TEXTURE_SIZE` with one
+/// dispatch and with a chain of blits, and compares their device time
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_mipgen(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series dispatch = {.name = "mipgen dispatch"};
+    static struct stats_series blit = {.name = "mipgen blit"};
+    bool success = false;
+
+    if (vulkan->timestamps == VK_NULL_HANDLE) {
+        fprintf(stderr, "gpu timestamps: not supported\n");
+        return true;
+    }
+
+    struct ktx2 ktx2 = {
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .width = BENCHMARK_TEXTURE_SIZE,
+        .height = BENCHMARK_TEXTURE_SIZE,
+        .depth = 1,
+        .faces_count = 1,
+        .mips_generate = true,
+        .levels_count = 1,
+    };
+    ktx2_format_block(ktx2.format, &ktx2.block);
+
+    struct texture texture = {};
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+
+    // Only the time to fill the chain matters, not what the base level holds
+    if (!texture_create(
+        vulkan->device,
+        &vulkan->memory_properties,
+        &ktx2,
+        mipgen_usage(&vulkan->mipgen, ktx2.format),
+        &texture
+    )) {
+        fprintf(stderr, "application_benchmark_mipgen: texture_create failed\n");
+        goto cleanup;
+    }
+
+    VkCommandBufferAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = vulkan->command_pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    if (vkAllocateCommandBuffers(
+        vulkan->device, &allocate_info, &command_buffer
+    ) != VK_SUCCESS) {
+        fprintf(
+            stderr, "application_benchmark_mipgen: vkAllocateCommandBuffers failed\n"
+        );
+        goto cleanup;
+    }
+
+    VkFenceCreateInfo fence_info = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    };
+    if (vkCreateFence(vulkan->device, &fence_info, nullptr, &fence) != VK_SUCCESS) {
+        fprintf(stderr, "application_benchmark_mipgen: vkCreateFence failed\n");
+        goto cleanup;
+    }
+
+    // The timestamps of the last frame are about to be overwritten
+    vkDeviceWaitIdle(vulkan->device);
+    vulkan->timestamps_pending = false;
+
+    bool dispatch_supported = (texture.usage & VK_IMAGE_USAGE_STORAGE_BIT) != 0;
+    for (size_t i = 0; i < 2 * BENCHMARK_MIPGEN_RUNS; i++) {
+        bool blitting = i >= BENCHMARK_MIPGEN_RUNS;
+        if (!blitting && !dispatch_supported) {
+            continue;
+        }
+
+        VkCommandBufferBeginInfo begin_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+            fprintf(
+                stderr, "application_benchmark_mipgen: vkBeginCommandBuffer failed\n"
+            );
+            goto cleanup;
+        }
+        vkCmdResetQueryPool(command_buffer, vulkan->timestamps, 0, 2);
+        vkCmdWriteTimestamp(
+            command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vulkan->timestamps, 0
+        );
+        bool recorded = blitting
+            ? mipgen_blit_record(&vulkan->mipgen, command_buffer, &texture)
+            : mipgen_record(&vulkan->mipgen, command_buffer, &texture);
+        vkCmdWriteTimestamp(
+            command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vulkan->timestamps, 1
+        );
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+            fprintf(stderr, "application_benchmark_mipgen: vkEndCommandBuffer failed\n");
+            goto cleanup;
+        }
+        if (!recorded) {
+            fprintf(stderr, "application_benchmark_mipgen: mips were not recorded\n");
+            goto cleanup;
+        }
+
+        VkSubmitInfo submit_info = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pCommandBuffers = &command_buffer,
+            .commandBufferCount = 1,
+        };
+        bool submitted = vkQueueSubmit(
+            vulkan->graphics_queue, 1, &submit_info, fence
+        ) == VK_SUCCESS;
+        if (submitted) {
+            vkWaitForFences(vulkan->device, 1, &fence, VK_TRUE, UINT64_MAX);
+            vkResetFences(vulkan->device, 1, &fence);
+        }
+        mipgen_reset(&vulkan->mipgen);
+        if (!submitted) {
+            fprintf(stderr, "application_benchmark_mipgen: vkQueueSubmit failed\n");
+            goto cleanup;
+        }
+
+        uint64_t timestamps[2];
+        if (vkGetQueryPoolResults(
+            vulkan->device,
+            vulkan->timestamps,
+            0,
+            2,
+            sizeof(timestamps),
+            timestamps,
+            sizeof(timestamps[0]),
+            VK_QUERY_RESULT_64_BIT
+        ) == VK_SUCCESS) {
+            stats_series_record(blitting ? &blit : &dispatch, (uint64_t) (
+                (double) (timestamps[1] - timestamps[0]) *
+                vulkan->physicaldevice_properties.limits.timestampPeriod
+            ));
+        }
+    }
+
+    fprintf(
+        stderr,
+        "mipgen: %ux%u with %u levels\n",
+        BENCHMARK_TEXTURE_SIZE,
+        BENCHMARK_TEXTURE_SIZE,
+        texture.levels_count
+    );
+    if (dispatch_supported) {
+        stats_series_report(&dispatch, stderr);
+    } else {
+        fprintf(stderr, "mipgen dispatch: not supported\n");
+    }
+    stats_series_report(&blit, stderr);
+
+    success = true;
+
+cleanup:
+    vkDestroyFence(vulkan->device, fence, nullptr);
+    if (command_buffer != VK_NULL_HANDLE) {
+        vkFreeCommandBuffers(vulkan->device, vulkan->command_pool, 1, &command_buffer);
+    }
+    texture_destroy(vulkan->device, &texture);
+
+    return success;
+}
+
+constexpr size_t BENCHMARK_SPRITES = 100000;
+constexpr size_t BENCHMARK_SPRITE_IMAGES = 256;
+
+/// Sprite the benchmark appends every frame
+struct benchmark_sprite {
+    uint32_t image;
+    float position[2];
+    float size[2];
+    uint32_t color;
+    enum sprites_blend blend;
+};
+
+/// Packs `BENCHMARK_SPRITE_IMAGES` images of different sizes into the atlas and
+/// draws `BENCHMARK_SPRITES` sprites of them over the scene every frame
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_sprites(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series append = {.name = "sprites append"};
+    static struct stats_series record = {.name = "sprites record"};
+    static struct stats_series gpu = {.name = "sprites gpu"};
+    bool success = false;
+
+    constexpr uint32_t image_size_max = 128;
+    uint32_t images[BENCHMARK_SPRITE_IMAGES];
+    uint8_t *texels = malloc(4 * image_size_max * image_size_max);
+    struct benchmark_sprite *benchmark_sprites = malloc(
+        sizeof(benchmark_sprites[0]) * BENCHMARK_SPRITES
+    );
+    if (texels == nullptr || benchmark_sprites == nullptr) {
+        fprintf(stderr, "application_benchmark_sprites: malloc failed\n");
+        goto cleanup;
+    }
+
+    // Discs with a soft edge, from 16 to 128 texels wide
+    uint32_t random = 1;
+    for (size_t i = 0; i < BENCHMARK_SPRITE_IMAGES; i++) {
+        random = random * 1664525 + 1013904223;
+        uint32_t width = 16 + (random >> 8) % (image_size_max - 15);
+        uint32_t height = 16 + (random >> 20) % (image_size_max - 15);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                float u = 2.0f * ((float) x + 0.5f) / (float) width - 1.0f;
+                float v = 2.0f * ((float) y + 0.5f) / (float) height - 1.0f;
+                float edge = 4.0f * (1.0f - sqrtf(u * u + v * v));
+                float alpha = fminf(fmaxf(edge, 0.0f), 1.0f);
+                uint8_t *texel = texels + 4 * ((size_t) width * y + x);
+                texel[0] = 255;
+                texel[1] = 255;
+                texel[2] = 255;
+                texel[3] = (uint8_t) (255.0f * alpha);
+            }
+        }
+        if (!sprites_image_add(&vulkan->sprites, width, height, texels, &images[i])) {
+            fprintf(stderr, "application_benchmark_sprites: sprites_image_add failed\n");
+            goto cleanup;
+        }
+    }
+
+    // Every eighth sprite is additive, the rest are blended over the others
+    for (size_t i = 0; i < BENCHMARK_SPRITES; i++) {
+        random = random * 1664525 + 1013904223;
+        float size = (float) (4 + (random >> 24) % 28);
+        random = random * 1664525 + 1013904223;
+        benchmark_sprites[i] = (struct benchmark_sprite){
+            .image = images[(random >> 8) % BENCHMARK_SPRITE_IMAGES],
+            .position = {
+                (float) ((random >> 4) % vulkan->swapchain_extent.width),
+                (float) ((random >> 16) % vulkan->swapchain_extent.height),
+            },
+            .size = {size, size},
+            .color = 0x80000000u | (random & 0x00ffffffu),
+            .blend = i % 8 == 0 ? SPRITES_BLEND_ADDITIVE : SPRITES_BLEND_ALPHA,
+        };
+    }
+
+    for (size_t i = 0; i < BENCHMARK_FRAMES; i++) {
+        glfwPollEvents();
+
+        uint64_t start_time = stats_time_now();
+        for (size_t j = 0; j < BENCHMARK_SPRITES; j++) {
+            const struct benchmark_sprite *sprite = &benchmark_sprites[j];
+            if (!sprites_draw(
+                &vulkan->sprites,
+                sprite->image,
+                sprite->position[0],
+                sprite->position[1],
+                sprite->size[0],
+                sprite->size[1],
+                sprite->color,
+                sprite->blend
+            )) {
+                fprintf(stderr, "application_benchmark_sprites: sprites_draw failed\n");
+                goto cleanup;
+            }
+        }
+        stats_series_record(&append, stats_time_now() - start_time);
+
+        struct frame_packet packet = {
+            .index = application->frame_index,
+            .present_id = application->frame_index + 1,
+        };
+        application->frame_index++;
+
+        if (!vulkan_frame_draw(vulkan, &packet)) {
+            fprintf(stderr, "application_benchmark_sprites: vulkan_frame_draw failed\n");
+            goto cleanup;
+        }
+        stats_series_record(&record, packet.record_time - packet.descriptors_time);
+
+        // Device times arrive a frame late, the first one belongs to whatever
+        // was drawn before
+        if (vulkan->timestamps != VK_NULL_HANDLE && i > 0) {
+            stats_series_record(&gpu, vulkan->gpu_time);
+        }
+    }
+
+    vkDeviceWaitIdle(vulkan->device);
+
+    fprintf(
+        stderr,
+        "sprites: %zu per frame in %zu draws, %zu pages %.0f%% occupied\n",
+        BENCHMARK_SPRITES,
+        vulkan->sprites.draws_count,
+        vulkan->sprites.atlas.pages_count,
+        100.0 * atlas_occupancy(&vulkan->sprites.atlas)
+    );
+    stats_series_report(&append, stderr);
+    stats_series_report(&record, stderr);
+    if (vulkan->timestamps != VK_NULL_HANDLE) {
+        stats_series_report(&gpu, stderr);
+    }
+
+    success = true;
+
+cleanup:
+    // Sprites left over from a failed frame are not drawn
+    vulkan->sprites.instances_count = 0;
+    free(benchmark_sprites);
+    free(texels);
+
+    return success;
+}
+
+constexpr size_t BENCHMARK_CULL_OBJECTS = 1 << 22;
+constexpr size_t BENCHMARK_CULL_RUNS = 32;
+
+/// Adds spheres and boxes up to ten units wide in a cube of two thousand units,
+/// with the box sometimes sticking out of the sphere and sometimes not
+/// @param[in] count
+/// @param[in,out] random State of the generator, advanced past the objects
+/// @param[out] objects
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `cull_objects_destroy` after
+/// successful return
+static bool application_benchmark_objects(
+    size_t count, uint32_t *random, struct cull_objects *objects
+) {
+    *objects = (struct cull_objects) {};
+    for (size_t i = 0; i < count; i++) {
+        float values[7];
+        for (size_t c = 0; c < 7; c++) {
+            *random = *random * 1664525 + 1013904223;
+            values[c] = (float) (*random >> 8) / (float) (1 << 24);
+        }
+        float center[3] = {
+            2000.0f * values[0] - 1000.0f,
+            2000.0f * values[1] - 1000.0f,
+            2000.0f * values[2] - 1000.0f,
+        };
+        float radius = 1.0f + 4.0f * values[3];
+        float extent[3] = {
+            radius * (0.25f + 0.5f * values[4]),
+            radius * (0.25f + 0.5f * values[5]),
+            radius * (0.25f + 0.5f * values[6]),
+        };
+        uint32_t index;
+        if (!cull_objects_add(objects, center, radius, extent, &index)) {
+            fprintf(stderr, "application_benchmark_objects: cull_objects_add failed\n");
+            cull_objects_destroy(objects);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Perspective looking down +z from the origin with a vertical field of view of
+/// 90 degrees, depth from zero at the near plane to one at the far plane
+/// @param[in] vulkan
+/// @param[out] view_projection Column major
+/// @param[out] frustum
+static void application_benchmark_camera(
+    const struct vulkan *vulkan, float view_projection[16], struct cull_frustum *frustum
+) {
+    constexpr float near = 0.1f;
+    constexpr float far = 1000.0f;
+    float aspect = (float) vulkan->swapchain_extent.width /
+        (float) vulkan->swapchain_extent.height;
+    const float camera[16] = {
+        1.0f / aspect, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, far / (far - near), 1.0f,
+        0.0f, 0.0f, -far * near / (far - near), 0.0f,
+    };
+    memcpy(view_projection, camera, sizeof(camera));
+    cull_frustum_extract(view_projection, frustum);
+}
+
+/// Frustum culls `BENCHMARK_CULL_OBJECTS` objects scattered around a camera
+/// with every kernel the processor runs on one thread, and with the fastest one
+/// on the job system, and checks that all of them keep the same objects
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_cull(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series series[] = {
+        [CULL_KERNEL_SCALAR] = {.name = "cull scalar"},
+        [CULL_KERNEL_SSE2] = {.name = "cull sse2"},
+        [CULL_KERNEL_AVX2] = {.name = "cull avx2"},
+        [CULL_KERNEL_NEON] = {.name = "cull neon"},
+    };
+    static struct stats_series threaded_series = {.name = "cull jobs"};
+    bool success = false;
+
+    struct cull_objects objects = {};
+    uint32_t *expected = nullptr;
+    uint32_t *visible = nullptr;
+
+    uint32_t random = 1;
+    if (!application_benchmark_objects(BENCHMARK_CULL_OBJECTS, &random, &objects)) {
+        fprintf(
+            stderr, "application_benchmark_cull: application_benchmark_objects failed\n"
+        );
+        goto cleanup;
+    }
+
+    expected = malloc(sizeof(expected[0]) * objects.capacity);
+    visible = malloc(sizeof(visible[0]) * objects.capacity);
+    if (expected == nullptr || visible == nullptr) {
+        fprintf(stderr, "application_benchmark_cull: malloc failed\n");
+        goto cleanup;
+    }
+
+    float view_projection[16];
+    struct cull_frustum frustum;
+    application_benchmark_camera(vulkan, view_projection, &frustum);
+
+    size_t expected_count = 0;
+    if (!cull_objects_test(
+        nullptr, CULL_KERNEL_SCALAR, &objects, &frustum, expected, &expected_count
+    )) {
+        fprintf(stderr, "application_benchmark_cull: cull_objects_test failed\n");
+        goto cleanup;
+    }
+
+    fprintf(
+        stderr,
+        "cull: %zu objects, %zu visible, kernel %s\n",
+        BENCHMARK_CULL_OBJECTS,
+        expected_count,
+        cull_kernel_name(cull_kernel_best())
+    );
+    for (size_t kernel = 0; kernel <= CULL_KERNELS_COUNT; kernel++) {
+        bool threaded = kernel == CULL_KERNELS_COUNT;
+        enum cull_kernel cull_kernel = threaded
+            ? cull_kernel_best()
+            : (enum cull_kernel) kernel;
+        struct stats_series *kernel_series = threaded ? &threaded_series : &series[kernel];
+        if (!cull_kernel_supported(cull_kernel)) {
+            continue;
+        }
+
+        size_t visible_count = 0;
+        for (size_t i = 0; i < BENCHMARK_CULL_RUNS; i++) {
+            uint64_t start_time = stats_time_now();
+            if (!cull_objects_test(
+                threaded ? vulkan->jobs : nullptr,
+                cull_kernel,
+                &objects,
+                &frustum,
+                visible,
+                &visible_count
+            )) {
+                fprintf(
+                    stderr, "application_benchmark_cull: cull_objects_test failed\n"
+                );
+                goto cleanup;
+            }
+            stats_series_record(kernel_series, stats_time_now() - start_time);
+        }
+
+        if (
+            visible_count != expected_count ||
+            memcmp(visible, expected, sizeof(visible[0]) * visible_count) != 0
+        ) {
+            fprintf(
+                stderr,
+                "application_benchmark_cull: %s disagrees with scalar\n",
+                kernel_series->name
+            );
+            goto cleanup;
+        }
+
+        stats_series_report(kernel_series, stderr);
+        fprintf(
+            stderr,
+            "%s: %.1f M objects/ms\n",
+            kernel_series->name,
+            (double) BENCHMARK_CULL_OBJECTS /
+                (double) stats_series_median(kernel_series)
+        );
+    }
+
+    success = true;
+
+cleanup:
+    free(visible);
+    free(expected);
+    cull_objects_destroy(&objects);
+
+    return success;
+}
+
+constexpr size_t BENCHMARK_BVH_OBJECTS = 1 << 20;
+constexpr size_t BENCHMARK_BVH_RUNS = 8;
+constexpr size_t BENCHMARK_BVH_QUERIES = 4096;
+constexpr size_t BENCHMARK_BVH_FOUND = 1024;
+
+/// Checks that a tree finds the objects a linear cull keeps
+/// @param[in] bvh
+/// @param[in] objects
+/// @param[in] frustum
+/// @param[out] visible `objects->capacity` entries
+/// @param[out] seen `objects->capacity` zeroed entries, zeroed again on return
+/// @param[out] visible_count
+/// @param[in] series Timing the tree
+/// @return `true` when both agree and `false` otherwise
+static bool application_benchmark_bvh_frustum(
+    const struct bvh *bvh,
+    const struct cull_objects *objects,
+    const struct cull_frustum *frustum,
+    uint32_t *visible,
+    uint8_t *seen,
+    size_t *visible_count,
+    struct stats_series *series
+) {
+    size_t expected_count = 0;
+    if (!cull_objects_test(
+        nullptr, cull_kernel_best(), objects, frustum, visible, &expected_count
+    )) {
+        fprintf(stderr, "application_benchmark_bvh_frustum: cull_objects_test failed\n");
+        return false;
+    }
+    for (size_t i = 0; i < expected_count; i++) {
+        seen[visible[i]] = 1;
+    }
+
+    for (size_t i = 0; i < BENCHMARK_BVH_RUNS; i++) {
+        uint64_t start_time = stats_time_now();
+        bvh_frustum(bvh, objects, frustum, visible, visible_count);
+        stats_series_record(series, stats_time_now() - start_time);
+    }
+
+    // Found objects are marked twice, so duplicates and objects the linear cull
+    // did not keep are both caught
+    bool agree = *visible_count == expected_count;
+    for (size_t i = 0; i < *visible_count; i++) {
+        agree = agree && seen[visible[i]] == 1;
+        seen[visible[i]] = 2;
+    }
+    memset(seen, 0, sizeof(seen[0]) * objects->capacity);
+    if (!agree) {
+        fprintf(stderr, "application_benchmark_bvh_frustum: bvh disagrees with cull\n");
+    }
+
+    return agree;
+}
+
+/// Builds a tree over `BENCHMARK_BVH_OBJECTS` objects on the job system, refits
+/// it after every object moved, and measures frustum culls checked against the
+/// linear cull, the first hits of rays from the camera and the objects near
+/// random points
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_bvh(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series build_series = {.name = "bvh build"};
+    static struct stats_series refit_series = {.name = "bvh refit"};
+    static struct stats_series frustum_series = {.name = "bvh frustum"};
+    static struct stats_series refitted_series = {.name = "bvh frustum refitted"};
+    static struct stats_series rays_series = {.name = "bvh rays"};
+    static struct stats_series spheres_series = {.name = "bvh spheres"};
+    bool success = false;
+
+    struct cull_objects objects = {};
+    struct bvh bvh = {};
+    uint32_t *visible = nullptr;
+    uint8_t *seen = nullptr;
+    uint32_t found[BENCHMARK_BVH_FOUND];
+
+    uint32_t random = 2;
+    if (!application_benchmark_objects(BENCHMARK_BVH_OBJECTS, &random, &objects)) {
+        fprintf(
+            stderr, "application_benchmark_bvh: application_benchmark_objects failed\n"
+        );
+        goto cleanup;
+    }
+
+    visible = malloc(sizeof(visible[0]) * objects.capacity);
+    seen = calloc(objects.capacity, sizeof(seen[0]));
+    if (visible == nullptr || seen == nullptr) {
+        fprintf(stderr, "application_benchmark_bvh: malloc failed\n");
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < BENCHMARK_BVH_RUNS; i++) {
+        bvh_destroy(&bvh);
+        uint64_t start_time = stats_time_now();
+        if (!bvh_build(vulkan->jobs, &objects, &bvh)) {
+            fprintf(stderr, "application_benchmark_bvh: bvh_build failed\n");
+            goto cleanup;
+        }
+        stats_series_record(&build_series, stats_time_now() - start_time);
+    }
+    fprintf(
+        stderr,
+        "bvh: %zu objects, %zu nodes, depth %u, %.1f MiB\n",
+        BENCHMARK_BVH_OBJECTS,
+        bvh.nodes_count,
+        bvh.depth,
+        (double) (
+            bvh.nodes_count * (sizeof(bvh.nodes[0]) + sizeof(bvh.bounds[0])) +
+            bvh.indices_count * sizeof(bvh.indices[0])
+        ) / (1024.0 * 1024.0)
+    );
+    stats_series_report(&build_series, stderr);
+
+    float view_projection[16];
+    struct cull_frustum frustum;
+    application_benchmark_camera(vulkan, view_projection, &frustum);
+    size_t visible_count = 0;
+    if (!application_benchmark_bvh_frustum(
+        &bvh, &objects, &frustum, visible, seen, &visible_count, &frustum_series
+    )) {
+        goto cleanup;
+    }
+    stats_series_report(&frustum_series, stderr);
+    fprintf(stderr, "bvh frustum: %zu visible\n", visible_count);
+
+    // Every object drifts by up to a unit along each axis per run, as they would
+    // over a few frames of a scene in motion
+    for (size_t i = 0; i < BENCHMARK_BVH_RUNS; i++) {
+        for (uint32_t index = 0; index < objects.count; index++) {
+            float center[3];
+            float *centers[3] = {objects.center_x, objects.center_y, objects.center_z};
+            for (size_t c = 0; c < 3; c++) {
+                random = random * 1664525 + 1013904223;
+                center[c] = centers[c][index] +
+                    2.0f * (float) (random >> 8) / (float) (1 << 24) - 1.0f;
+            }
+            const float extent[3] = {
+                objects.extent_x[index], objects.extent_y[index], objects.extent_z[index]
+            };
+            cull_objects_set(&objects, index, center, objects.radius[index], extent);
+        }
+
+        uint64_t start_time = stats_time_now();
+        bvh_refit(&bvh, &objects);
+        stats_series_record(&refit_series, stats_time_now() - start_time);
+    }
+    stats_series_report(&refit_series, stderr);
+
+    if (!application_benchmark_bvh_frustum(
+        &bvh, &objects, &frustum, visible, seen, &visible_count, &refitted_series
+    )) {
+        goto cleanup;
+    }
+    stats_series_report(&refitted_series, stderr);
+
+    // Rays from the camera into the frustum, and spheres the size of a small
+    // explosion anywhere in the scene
+    size_t hits = 0;
+    size_t spheres_found = 0;
+    for (size_t i = 0; i < BENCHMARK_BVH_RUNS; i++) {
+        uint32_t query_random = 3;
+        uint64_t start_time = stats_time_now();
+        for (size_t query = 0; query < BENCHMARK_BVH_QUERIES; query++) {
+            float values[2];
+            for (size_t c = 0; c < 2; c++) {
+                query_random = query_random * 1664525 + 1013904223;
+                values[c] = (float) (query_random >> 8) / (float) (1 << 24);
+            }
+            const float origin[3] = {0.0f, 0.0f, 0.0f};
+            const float direction[3] = {
+                2.0f * values[0] - 1.0f, 2.0f * values[1] - 1.0f, 1.0f
+            };
+            uint32_t index;
+            float distance;
+            hits += bvh_ray(
+                &bvh, &objects, origin, direction, 1000.0f, &index, &distance
+            );
+        }
+        stats_series_record(&rays_series, stats_time_now() - start_time);
+
+        start_time = stats_time_now();
+        for (size_t query = 0; query < BENCHMARK_BVH_QUERIES; query++) {
+            float center[3];
+            for (size_t c = 0; c < 3; c++) {
+                query_random = query_random * 1664525 + 1013904223;
+                center[c] = 2000.0f * (float) (query_random >> 8) / (float) (1 << 24) -
+                    1000.0f;
+            }
+            size_t count;
+            bvh_sphere(
+                &bvh, &objects, center, 20.0f, found, BENCHMARK_BVH_FOUND, &count
+            );
+            spheres_found += count;
+        }
+        stats_series_record(&spheres_series, stats_time_now() - start_time);
+    }
+    stats_series_report(&rays_series, stderr);
+    fprintf(
+        stderr,
+        "bvh rays: %zu queries, %.1f%% hit\n",
+        BENCHMARK_BVH_QUERIES,
+        100.0 * (double) hits / (double) (BENCHMARK_BVH_QUERIES * BENCHMARK_BVH_RUNS)
+    );
+    stats_series_report(&spheres_series, stderr);
+    fprintf(
+        stderr,
+        "bvh spheres: %zu queries, %.1f objects each\n",
+        BENCHMARK_BVH_QUERIES,
+        (double) spheres_found / (double) (BENCHMARK_BVH_QUERIES * BENCHMARK_BVH_RUNS)
+    );
+
+    success = true;
+
+cleanup:
+    free(seen);
+    free(visible);
+    bvh_destroy(&bvh);
+    cull_objects_destroy(&objects);
+
+    return success;
+}
+
+constexpr size_t BENCHMARK_OCCLUSION_OBJECTS = 1 << 16;
+constexpr size_t BENCHMARK_OCCLUDERS = 64;
+constexpr size_t BENCHMARK_OCCLUSION_RUNS = 32;
+
+/// Picks a slab up to fifty units wide over the view of
+/// `application_benchmark_camera`, between twenty and three hundred units away
+/// @param[in,out] random State of the generator, advanced past the slab
+/// @param[in] aspect Of the camera
+/// @param[out] center
+/// @param[out] extent Half the size of the slab along each axis
+static void application_benchmark_slab(
+    uint32_t *random, float aspect, float center[3], float extent[3]
+) {
+    float values[6];
+    for (size_t c = 0; c < 6; c++) {
+        *random = *random * 1664525 + 1013904223;
+        values[c] = (float) (*random >> 8) / (float) (1 << 24);
+    }
+    float z = 20.0f + 280.0f * values[0];
+    center[0] = (2.0f * values[1] - 1.0f) * z * aspect;
+    center[1] = (2.0f * values[2] - 1.0f) * z;
+    center[2] = z;
+    extent[0] = 5.0f + 20.0f * values[3];
+    extent[1] = 5.0f + 20.0f * values[4];
+    extent[2] = 1.0f + 4.0f * values[5];
+}
+
+/// Rasterizes `BENCHMARK_OCCLUDERS` walls in front of the camera and tests the
+/// objects left by frustum culling against them, with AVX2 on the job system
+/// and with the scalar code on one thread, and checks that both hide the same
+/// objects
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_occlusion(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series render_series[2] = {
+        {.name = "occlusion render scalar"},
+        {.name = "occlusion render avx2 jobs"},
+    };
+    static struct stats_series test_series[2] = {
+        {.name = "occlusion test scalar"},
+        {.name = "occlusion test avx2 jobs"},
+    };
+    static const uint32_t box_indices[36] = {
+        0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1,
+        2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3,
+    };
+    bool success = false;
+
+    struct cull_objects objects = {};
+    struct occlusion occlusion = {};
+    bool occlusion_created = false;
+    uint32_t *candidates = nullptr;
+    uint32_t *visible[2] = {};
+    float *depths = nullptr;
+    float positions[BENCHMARK_OCCLUDERS * 8 * 3];
+    uint32_t indices[BENCHMARK_OCCLUDERS * 36];
+
+    uint32_t random = 4;
+    if (!application_benchmark_objects(
+        BENCHMARK_OCCLUSION_OBJECTS, &random, &objects
+    )) {
+        fprintf(
+            stderr,
+            "application_benchmark_occlusion: application_benchmark_objects failed\n"
+        );
+        goto cleanup;
+    }
+
+    float view_projection[16];
+    struct cull_frustum frustum;
+    application_benchmark_camera(vulkan, view_projection, &frustum);
+    float aspect = 1.0f / view_projection[0];
+
+    for (size_t occluder = 0; occluder < BENCHMARK_OCCLUDERS; occluder++) {
+        float center[3];
+        float extent[3];
+        application_benchmark_slab(&random, aspect, center, extent);
+        for (uint32_t corner = 0; corner < 8; corner++) {
+            for (size_t c = 0; c < 3; c++) {
+                positions[3 * (8 * occluder + corner) + c] = center[c] +
+                    (corner & (1 << c) ? extent[c] : -extent[c]);
+            }
+        }
+        for (size_t i = 0; i < 36; i++) {
+            indices[36 * occluder + i] = 8 * (uint32_t) occluder + box_indices[i];
+        }
+    }
+
+    if (!occlusion_create(OCCLUSION_WIDTH, OCCLUSION_HEIGHT, &occlusion)) {
+        fprintf(stderr, "application_benchmark_occlusion: occlusion_create failed\n");
+        goto cleanup;
+    }
+    occlusion_created = true;
+
+    size_t pixels_count = (size_t) occlusion.width * occlusion.height;
+    candidates = malloc(sizeof(candidates[0]) * objects.capacity);
+    visible[0] = malloc(sizeof(visible[0][0]) * objects.capacity);
+    visible[1] = malloc(sizeof(visible[1][0]) * objects.capacity);
+    depths = malloc(sizeof(depths[0]) * pixels_count);
+    if (
+        candidates == nullptr ||
+        visible[0] == nullptr ||
+        visible[1] == nullptr ||
+        depths == nullptr
+    ) {
+        fprintf(stderr, "application_benchmark_occlusion: malloc failed\n");
+        goto cleanup;
+    }
+
+    size_t candidates_count = 0;
+    if (!cull_objects_test(
+        vulkan->jobs,
+        cull_kernel_best(),
+        &objects,
+        &frustum,
+        candidates,
+        &candidates_count
+    )) {
+        fprintf(stderr, "application_benchmark_occlusion: cull_objects_test failed\n");
+        goto cleanup;
+    }
+
+    bool avx2 = occlusion.avx2;
+    size_t visible_count[2] = {};
+    for (size_t kernel = 0; kernel < (avx2 ? 2 : 1); kernel++) {
+        struct jobs *jobs = kernel == 1 ? vulkan->jobs : nullptr;
+        occlusion.avx2 = kernel == 1;
+        for (size_t i = 0; i < BENCHMARK_OCCLUSION_RUNS; i++) {
+            uint64_t start_time = stats_time_now();
+            occlusion_clear(&occlusion);
+            if (!occlusion_render(
+                jobs,
+                &occlusion,
+                view_projection,
+                positions,
+                indices,
+                BENCHMARK_OCCLUDERS * 36
+            )) {
+                fprintf(
+                    stderr, "application_benchmark_occlusion: occlusion_render failed\n"
+                );
+                goto cleanup;
+            }
+            uint64_t render_time = stats_time_now();
+            stats_series_record(&render_series[kernel], render_time - start_time);
+
+            memcpy(
+                visible[kernel], candidates, sizeof(candidates[0]) * candidates_count
+            );
+            visible_count[kernel] = candidates_count;
+            if (!occlusion_objects_test(
+                jobs,
+                &occlusion,
+                view_projection,
+                &objects,
+                visible[kernel],
+                &visible_count[kernel]
+            )) {
+                fprintf(
+                    stderr,
+                    "application_benchmark_occlusion: occlusion_objects_test failed\n"
+                );
+                goto cleanup;
+            }
+            stats_series_record(&test_series[kernel], stats_time_now() - render_time);
+        }
+
+        if (kernel == 0) {
+            memcpy(depths, occlusion.depths, sizeof(depths[0]) * pixels_count);
+        } else if (
+            memcmp(depths, occlusion.depths, sizeof(depths[0]) * pixels_count) != 0 ||
+            visible_count[1] != visible_count[0] ||
+            memcmp(
+                visible[1], visible[0], sizeof(visible[0][0]) * visible_count[0]
+            ) != 0
+        ) {
+            fprintf(
+                stderr, "application_benchmark_occlusion: avx2 disagrees with scalar\n"
+            );
+            goto cleanup;
+        }
+    }
+
+    fprintf(
+        stderr,
+        "occlusion: %ux%u, %zu triangles, %zu of %zu objects left after frustum "
+        "culling, %zu after occlusion culling\n",
+        occlusion.width,
+        occlusion.height,
+        BENCHMARK_OCCLUDERS * 12,
+        candidates_count,
+        BENCHMARK_OCCLUSION_OBJECTS,
+        visible_count[0]
+    );
+    for (size_t kernel = 0; kernel < (avx2 ? 2 : 1); kernel++) {
+        stats_series_report(&render_series[kernel], stderr);
+        stats_series_report(&test_series[kernel], stderr);
+    }
+
+    success = true;
+
+cleanup:
+    free(depths);
+    free(visible[1]);
+    free(visible[0]);
+    free(candidates);
+    if (occlusion_created) {
+        occlusion_destroy(&occlusion);
+    }
+    cull_objects_destroy(&objects);
+
+    return success;
+}
+
+constexpr size_t BENCHMARK_GPUCULL_OBJECTS = GPUCULL_CAPACITY - BENCHMARK_OCCLUDERS;
+
+/// Culls `BENCHMARK_GPUCULL_OBJECTS` objects and `BENCHMARK_OCCLUDERS` slabs
+/// among them on the device while the camera turns, and reports how many
+/// objects each phase drew and how many were culled per frame
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_gpucull(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series gpu_series = {.name = "gpucull gpu"};
+
+    if (!vulkan->gpucull_supported) {
+        fprintf(stderr, "gpucull: not supported\n");
+        return true;
+    }
+
+    bool success = false;
+
+    struct cull_objects objects = {};
+
+    uint32_t random = 5;
+    if (!application_benchmark_objects(BENCHMARK_GPUCULL_OBJECTS, &random, &objects)) {
+        fprintf(
+            stderr,
+            "application_benchmark_gpucull: application_benchmark_objects failed\n"
+        );
+        goto cleanup;
+    }
+
+    float projection[16];
+    struct cull_frustum frustum;
+    application_benchmark_camera(vulkan, projection, &frustum);
+    float aspect = 1.0f / projection[0];
+
+    for (size_t occluder = 0; occluder < BENCHMARK_OCCLUDERS; occluder++) {
+        float center[3];
+        float extent[3];
+        application_benchmark_slab(&random, aspect, center, extent);
+        float radius = sqrtf(
+            extent[0] * extent[0] + extent[1] * extent[1] + extent[2] * extent[2]
+        );
+        uint32_t index;
+        if (!cull_objects_add(&objects, center, radius, extent, &index)) {
+            fprintf(stderr, "application_benchmark_gpucull: cull_objects_add failed\n");
+            goto cleanup;
+        }
+    }
+
+    vkDeviceWaitIdle(vulkan->device);
+    if (!gpucull_objects_set(&vulkan->gpucull, &objects)) {
+        fprintf(stderr, "application_benchmark_gpucull: gpucull_objects_set failed\n");
+        goto cleanup;
+    }
+
+    uint64_t early_draws = 0;
+    uint64_t late_draws = 0;
+    uint64_t frustum_culled = 0;
+    uint64_t occluded = 0;
+    for (size_t i = 0; i < BENCHMARK_FRAMES; i++) {
+        glfwPollEvents();
+
+        // Turns about the vertical axis, so that objects keep coming into view
+        float angle = 0.002f * (float) i;
+        const float view[16] = {
+            cosf(angle), 0.0f, -sinf(angle), 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            sinf(angle), 0.0f, cosf(angle), 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f,
+        };
+        for (size_t column = 0; column < 4; column++) {
+            for (size_t row = 0; row < 4; row++) {
+                float value = 0.0f;
+                for (size_t k = 0; k < 4; k++) {
+                    value += projection[4 * k + row] * view[4 * column + k];
+                }
+                vulkan->gpucull_view_projection[4 * column + row] = value;
+            }
+        }
+
+        struct frame_packet packet = {
+            .index = application->frame_index,
+            .present_id = application->frame_index + 1,
+        };
+        application->frame_index++;
+
+        if (!vulkan_frame_draw(vulkan, &packet)) {
+            fprintf(stderr, "application_benchmark_gpucull: vulkan_frame_draw failed\n");
+            goto cleanup;
+        }
+
+        // Counts and device times arrive a frame late, the first ones belong
+        // to whatever was drawn before
+        if (i > 0) {
+            early_draws += vulkan->gpucull_counts.early_draws;
+            late_draws += vulkan->gpucull_counts.late_draws;
+            frustum_culled += vulkan->gpucull_counts.frustum_culled;
+            occluded += vulkan->gpucull_counts.occluded;
+            if (vulkan->timestamps != VK_NULL_HANDLE) {
+                stats_series_record(&gpu_series, vulkan->gpu_time);
+            }
+        }
+    }
+
+    double frames = (double) (BENCHMARK_FRAMES - 1);
+    fprintf(
+        stderr,
+        "gpucull: %zu objects, per frame %.1f drawn early, %.1f drawn late, "
+        "%.1f frustum culled, %.1f occluded\n",
+        objects.count,
+        (double) early_draws / frames,
+        (double) late_draws / frames,
+        (double) frustum_culled / frames,
+        (double) occluded / frames
+    );
+    stats_series_report(&gpu_series, stderr);
+
+    success = true;
+
+cleanup:
+    // Nothing is culled on the device once the frames in flight are done
+    vkDeviceWaitIdle(vulkan->device);
+    vulkan->gpucull.objects_count = 0;
+    vulkan->gpucull_pending = false;
+    cull_objects_destroy(&objects);
+
+    return success;
+}
+
+constexpr size_t BENCHMARK_LOD_OBJECTS = 1 << 18;
+constexpr size_t BENCHMARK_LOD_FRAMES = 256;
+
+/// Builds the levels of detail of the benchmark grid, then scatters
+/// `BENCHMARK_LOD_OBJECTS` instances of it through a cube the camera moves
+/// into while bobbing back and forth, and picks the level of every object the
+/// culling pass keeps, with and without hysteresis. Level switches are counted
+/// for objects that stayed visible.
+/// @param[in,out] application
+/// @return `true` on success and `false` otherwise
+static bool application_benchmark_lod(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series series = {.name = "lod select"};
+    bool success = false;
+
+    uint32_t vertices_count = BENCHMARK_GRID_SIZE * BENCHMARK_GRID_SIZE;
+    uint32_t indices_count = 6 * (BENCHMARK_GRID_SIZE - 1) * (BENCHMARK_GRID_SIZE - 1);
+    struct vertexformat_vertex *vertices = malloc(sizeof(vertices[0]) * vertices_count);
+    uint32_t *indices = malloc(sizeof(indices[0]) * indices_count);
+    struct cull_objects objects = {};
+    uint32_t *visible = nullptr;
+    uint8_t *previous = nullptr;
+    // Whether each object was visible the frame before, and is now
+    bool *seen = nullptr;
+    bool *shown = nullptr;
+    // With `MESHLOD_HYSTERESIS` and without
+    uint8_t *levels[2] = {};
+    if (vertices == nullptr || indices == nullptr) {
+        fprintf(stderr, "application_benchmark_lod: malloc failed\n");
+        goto cleanup;
+    }
+
+    application_benchmark_grid(vertices, indices);
 
-    if (vkCreateFence(
-        vulkan->device, &frames_in_flight_create_info, nullptr, &vulkan->frame_in_flight
-    ) != VK_SUCCESS) {
+    uint64_t start_time = stats_time_now();
+    struct meshlod meshlod;
+    if (!meshlod_create(vertices, vertices_count, &indices, &indices_count, &meshlod)) {
+        fprintf(stderr, "application_benchmark_lod: meshlod_create failed\n");
+        goto cleanup;
+    }
+    fprintf(
+        stderr,
+        "lod: %zu levels built in %.3f ms\n",
+        meshlod.levels_count,
+        (double) (stats_time_now() - start_time) / 1e6
+    );
+    for (size_t i = 0; i < meshlod.levels_count; i++) {
         fprintf(
             stderr,
-            "vulkan_scynhronizationobjects_create: "
-            "vkCreateFence(frames_in_flight) failed"
+            "lod level %zu: %u triangles, error %.5f\n",
+            i,
+            meshlod.levels[i].indices_count / 3,
+            (double) meshlod.levels[i].error
         );
-        return false;
     }
 
-    return true;
-}
-
-/// @param[in] vulkan
-/// @return `true` on success and `false` otherwise
-static bool vulkan_frame_draw(const struct vulkan *vulkan) {
-    vkWaitForFences(vulkan->device, 1, &vulkan->frame_in_flight, VK_TRUE, UINT32_MAX);
-    vkResetFences(vulkan->device, 1, &vulkan->frame_in_flight);
-
-    uint32_t swapchain_image_index;
-    if (vkAcquireNextImageKHR(
-        vulkan->device,
-        vulkan->swapchain,
-        UINT32_MAX,
-        vulkan->swapchain_image_available,
-        VK_NULL_HANDLE,
-        &swapchain_image_index
-    ) != VK_SUCCESS) {
-        fprintf(stderr, "vulkan_frame_draw: vkAcquireNextImageKHR failed\n");
-        return false;
+    uint32_t random = 7;
+    if (!application_benchmark_objects(BENCHMARK_LOD_OBJECTS, &random, &objects)) {
+        fprintf(
+            stderr, "application_benchmark_lod: application_benchmark_objects failed\n"
+        );
+        goto cleanup;
     }
 
-    if (vkResetCommandBuffer(vulkan->command_buffer, 0) != VK_SUCCESS) {
-        fprintf(stderr, "vulkan_frame_draw: vkResetCommandBuffer failed\n");
-        return false;
+    // Gathered into a cube of two hundred units, so that many objects come
+    // close enough to the camera to need the finer levels
+    for (uint32_t index = 0; index < objects.count; index++) {
+        const float center[3] = {
+            0.1f * objects.center_x[index],
+            0.1f * objects.center_y[index],
+            0.1f * objects.center_z[index],
+        };
+        const float extent[3] = {
+            objects.extent_x[index], objects.extent_y[index], objects.extent_z[index]
+        };
+        cull_objects_set(&objects, index, center, objects.radius[index], extent);
     }
 
-    if (!vulkan_commandbuffer_record(
-        vulkan, vulkan->command_buffer, swapchain_image_index
-    )) {
-        fprintf(stderr, "vulkan_frame_draw: vulkan_commandbuffer failed\n");
-        return false;
+    visible = malloc(sizeof(visible[0]) * objects.capacity);
+    previous = malloc(sizeof(previous[0]) * objects.capacity);
+    seen = calloc(objects.capacity, sizeof(seen[0]));
+    shown = calloc(objects.capacity, sizeof(shown[0]));
+    levels[0] = calloc(objects.capacity, sizeof(levels[0][0]));
+    levels[1] = calloc(objects.capacity, sizeof(levels[1][0]));
+    if (
+        visible == nullptr ||
+        previous == nullptr ||
+        seen == nullptr ||
+        shown == nullptr ||
+        levels[0] == nullptr ||
+        levels[1] == nullptr
+    ) {
+        fprintf(stderr, "application_benchmark_lod: malloc failed\n");
+        goto cleanup;
     }
 
-    VkSubmitInfo submit_info = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pWaitSemaphores = &vulkan->swapchain_image_available,
-        .waitSemaphoreCount = 1,
-        .pWaitDstStageMask = &(VkPipelineStageFlags){
-            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        },
-        .pCommandBuffers = &vulkan->command_buffer,
-        .commandBufferCount = 1,
-        .pSignalSemaphores = &vulkan->render_finished,
-        .signalSemaphoreCount = 1,
-    };
+    float projection[16];
+    struct cull_frustum frustum;
+    application_benchmark_camera(vulkan, projection, &frustum);
+    float scale = 0.5f * projection[5] * (float) vulkan->swapchain_extent.height;
+
+    uint64_t visible_total = 0;
+    uint64_t full_triangles = 0;
+    uint64_t triangles[2] = {};
+    uint64_t switches[2] = {};
+    for (size_t frame = 0; frame < BENCHMARK_LOD_FRAMES; frame++) {
+        // Half a unit forward per frame, and a unit and a half back and forth,
+        // so that objects near a switching distance cross it again and again
+        float time = (float) frame;
+        float eye[3] = {0.0f, 0.0f, -100.0f + 0.5f * time + 1.5f * sinf(0.5f * time)};
+        float view_projection[16];
+        memcpy(view_projection, projection, sizeof(projection));
+        for (size_t row = 0; row < 4; row++) {
+            for (size_t k = 0; k < 3; k++) {
+                view_projection[12 + row] -= projection[4 * k + row] * eye[k];
+            }
+        }
+        cull_frustum_extract(view_projection, &frustum);
+
+        size_t visible_count = 0;
+        if (!cull_objects_test(
+            vulkan->jobs,
+            cull_kernel_best(),
+            &objects,
+            &frustum,
+            visible,
+            &visible_count
+        )) {
+            fprintf(stderr, "application_benchmark_lod: cull_objects_test failed\n");
+            goto cleanup;
+        }
+        visible_total += visible_count;
+        full_triangles += visible_count * (meshlod.levels[0].indices_count / 3);
+        memset(shown, 0, sizeof(shown[0]) * objects.capacity);
+        for (size_t i = 0; i < visible_count; i++) {
+            shown[visible[i]] = true;
+        }
 
-    if (vkQueueSubmit(
-        vulkan->graphics_queue, 1, &submit_info, vulkan->frame_in_flight
-    ) != VK_SUCCESS) {
-        fprintf(stderr, "vulkan_frame_draw: vkQueueSubmit failed\n");
-        return false;
+        for (size_t i = 0; i < 2; i++) {
+            memcpy(previous, levels[i], sizeof(previous[0]) * objects.capacity);
+            uint64_t select_time = stats_time_now();
+            triangles[i] += meshlod_select_objects(
+                &meshlod,
+                &objects,
+                visible,
+                visible_count,
+                eye,
+                scale,
+                LOD_THRESHOLD,
+                i == 0 ? MESHLOD_HYSTERESIS : 1.0f,
+                levels[i]
+            );
+            if (i == 0) {
+                stats_series_record(&series, stats_time_now() - select_time);
+            }
+            for (size_t j = 0; j < visible_count; j++) {
+                uint32_t index = visible[j];
+                switches[i] += seen[index] && levels[i][index] != previous[index];
+            }
+        }
+        memcpy(seen, shown, sizeof(seen[0]) * objects.capacity);
     }
 
-    VkPresentInfoKHR present_info = {
-        .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-        .pWaitSemaphores = &vulkan->render_finished,
-        .waitSemaphoreCount = 1,
-        .pSwapchains = &vulkan->swapchain,
-        .swapchainCount = 1,
-        .pImageIndices = &swapchain_image_index,
-        .pResults = nullptr,
-    };
+    double frames = (double) BENCHMARK_LOD_FRAMES;
+    fprintf(
+        stderr,
+        "lod: %zu objects, per frame %.1f visible, %.2f M triangles at full detail "
+        "and %.2f M at their levels, %.1f %% saved\n",
+        objects.count,
+        (double) visible_total / frames,
+        (double) full_triangles / frames / 1e6,
+        (double) triangles[0] / frames / 1e6,
+        100.0 * (1.0 - (double) triangles[0] / (double) full_triangles)
+    );
+    fprintf(
+        stderr,
+        "lod: per frame %.1f level switches with hysteresis and %.1f without\n",
+        (double) switches[0] / frames,
+        (double) switches[1] / frames
+    );
+    stats_series_report(&series, stderr);
 
-    if (vkQueuePresentKHR(vulkan->present_queue, &present_info) != VK_SUCCESS) {
-        fprintf(stderr, "vulkan_frame_draw: vkQueuePresentKHR failed\n");
-        return false;
-    }
+    success = true;
 
-    return true;
+cleanup:
+    free(levels[1]);
+    free(levels[0]);
+    free(shown);
+    free(seen);
+    free(previous);
+    free(visible);
+    cull_objects_destroy(&objects);
+    free(indices);
+    free(vertices);
+
+    return success;
 }
 
-/// @param[in,out] vulkan
+/// Compares pipelines against shader objects: the time until every scene
+/// variant can be drawn, and the cost of recording `BENCHMARK_DRAWS` draws per
+/// frame that each switch to another variant. Then compares descriptor buffers
+/// against descriptor sets on a scene where each draw also switches to another
+/// of `MATERIALS_COUNT` materials, and all of them are rewritten every frame.
+/// Finally compares float32 against quantized vertices, and decompression on
+/// one thread against the job system and against the device, and measures
+/// texture uploads, mip generation, block compression, sprite batching,
+/// frustum culling, bounding volume hierarchies, occlusion culling on the
+/// processor and on the device, and level of detail selection.
+/// @param[in,out] application
 /// @return `true` on success and `false` otherwise
-static bool vulkan_init(struct vulkan *vulkan) {
-    if (!vulkan_instance_create(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_instance_create failed\n");
-        return false;
-    }
+static bool application_benchmark(struct application *application) {
+    struct vulkan *vulkan = &application->vulkan;
+    static struct stats_series pipelines_record = {
+        .name = "pipelines record",
+    };
+    static struct stats_series shaderobjects_record = {
+        .name = "shader objects record",
+    };
+    static struct stats_series descriptorbuffer_update = {
+        .name = "descriptor buffer update",
+    };
+    static struct stats_series descriptorbuffer_record = {
+        .name = "descriptor buffer record",
+    };
+    static struct stats_series descriptorsets_update = {
+        .name = "descriptor sets update",
+    };
+    static struct stats_series descriptorsets_record = {
+        .name = "descriptor sets record",
+    };
 
-    if (!vulkan_surface_create(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_surface_create failed\n");
+    // Assets streaming in would replace what is being measured
+    if (!vulkan_uploads_wait(vulkan)) {
+        fprintf(stderr, "application_benchmark: vulkan_uploads_wait failed\n");
         return false;
     }
 
-    if (!vulkan_physicaldevice_find(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_physicaldevice_find failed\n");
-        return false;
-    }
+    fprintf(
+        stderr,
+        "benchmark: %zu variants, %u materials, %zu frames of %zu draws\n",
+        SCENE_VARIANTS_COUNT,
+        MATERIALS_COUNT,
+        BENCHMARK_FRAMES,
+        BENCHMARK_DRAWS
+    );
 
-    if (!vulkan_queuefamily_find(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_queuefamily_find failed\n");
-        return false;
-    }
+    vulkan->benchmark_draws = BENCHMARK_DRAWS;
 
-    if (!vulkan_device_create(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_device_create failed\n");
+    vulkan->shaderobjects_enabled = false;
+    if (!application_benchmark_frames(
+        application, nullptr, &pipelines_record, nullptr
+    )) {
         return false;
     }
+    fprintf(
+        stderr,
+        "pipelines startup: %.3f ms\n",
+        (double) vulkan->variantcache_startup_time / 1e6
+    );
+    stats_series_report(&pipelines_record, stderr);
 
-    if (!vulkan_swapchain_create(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_swapchain_create failed\n");
-        return false;
+    if (vulkan->shaderobjects_supported) {
+        vulkan->shaderobjects_enabled = true;
+        if (!application_benchmark_frames(
+            application, nullptr, &shaderobjects_record, nullptr
+        )) {
+            return false;
+        }
+        fprintf(
+            stderr,
+            "shader objects startup: %.3f ms\n",
+            (double) vulkan->shaderobjects_startup_time / 1e6
+        );
+        stats_series_report(&shaderobjects_record, stderr);
+    } else {
+        fprintf(stderr, "shader objects: not supported\n");
     }
+    vulkan->shaderobjects_enabled = vulkan->shaderobjects_requested;
 
-    if (!vulkan_imageviews_create(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_imageviews_create failed\n");
-        return false;
+    vulkan->materials_count = MATERIALS_COUNT;
+    if (vulkan->descriptorbuffer_supported) {
+        if (
+            !application_benchmark_frames(
+                application, &descriptorbuffer_update, &descriptorbuffer_record, nullptr
+            ) ||
+            !application_benchmark_descriptorsets(application, &descriptorsets_update)
+        ) {
+            return false;
+        }
+        stats_series_report(&descriptorbuffer_update, stderr);
+        stats_series_report(&descriptorbuffer_record, stderr);
+        stats_series_report(&descriptorsets_update, stderr);
+    } else {
+        if (!application_benchmark_frames(
+            application, &descriptorsets_update, &descriptorsets_record, nullptr
+        )) {
+            return false;
+        }
+        fprintf(stderr, "descriptor buffer: not supported\n");
+        stats_series_report(&descriptorsets_update, stderr);
+        stats_series_report(&descriptorsets_record, stderr);
     }
+    vulkan->materials_count = 1;
 
-    if (!vulkan_renderpass_create(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_renderpass_create failed\n");
+    vulkan->benchmark_draws = 0;
+
+    if (!application_benchmark_vertices(application)) {
+        fprintf(
+            stderr, "application_benchmark: application_benchmark_vertices failed\n"
+        );
         return false;
     }
 
-    if (!vulkan_graphicspipeline_create(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_graphicspipeline_create failed\n");
+    if (!application_benchmark_decode(application)) {
+        fprintf(
+            stderr, "application_benchmark: application_benchmark_decode failed\n"
+        );
         return false;
     }
 
-    if (!vulkan_framebuffers_create(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_framebuffers_create failed\n");
+    if (!application_benchmark_textures(application)) {
+        fprintf(
+            stderr, "application_benchmark: application_benchmark_textures failed\n"
+        );
         return false;
     }
 
-    if (!vulkan_commandpool_create(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_commandpool_create failed\n");
+    if (!application_benchmark_mipgen(application)) {
+        fprintf(
+            stderr, "application_benchmark: application_benchmark_mipgen failed\n"
+        );
         return false;
     }
 
-    if (!vulkan_commandbuffer_allocate(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_commandbuffer_allocate failed\n");
+    if (!application_benchmark_bcenc(application)) {
+        fprintf(
+            stderr, "application_benchmark: application_benchmark_bcenc failed\n"
+        );
         return false;
     }
 
-    if (!vulkan_synchronizationobjects_create(vulkan)) {
-        fprintf(stderr, "vulkan_init: vulkan_synchronizationobjects_create failed\n");
+    if (!application_benchmark_sprites(application)) {
+        fprintf(
+            stderr, "application_benchmark: application_benchmark_sprites failed\n"
+        );
         return false;
     }
 
-    return true;
-}
-
-struct application_config {
-    const char *title;
-    int width;
-    int height;
-
-    bool debug;
-};
-
-struct application {
-    GLFWwindow *window;
-
-    struct vulkan vulkan;
-};
-
-/// @param[in] config
-/// @param[out] application
-/// @return `true` on success and `false` otherwise
-/// @note Caller is responsible to call `application_destroy` after
-/// `application` is no longer needed
-static bool application_create(
-    const struct application_config *config,
-    struct application *application
-) {
-    if (glfwInit() != GLFW_TRUE) {
-        fprintf(stderr, "application_create: glfwInit failed\n");
+    if (!application_benchmark_cull(application)) {
+        fprintf(stderr, "application_benchmark: application_benchmark_cull failed\n");
         return false;
     }
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-
-    GLFWwindow *window = glfwCreateWindow(
-        config->width,
-        config->height,
-        config->title,
-        nullptr,
-        nullptr
-    );
-    if (window == nullptr) {
-        fprintf(stderr, "application_create: glfwCreateWindow failed\n");
+    if (!application_benchmark_bvh(application)) {
+        fprintf(stderr, "application_benchmark: application_benchmark_bvh failed\n");
         return false;
     }
 
-    application->window = window;
-    application->vulkan.window = window;
-    application->vulkan.application_name = config->title;
-    application->vulkan.enable_validation_layers = config->debug;
-
-    if (!vulkan_init(&application->vulkan)) {
-        fprintf(stderr, "application_create: vulkan_init failed\n");
+    if (!application_benchmark_occlusion(application)) {
+        fprintf(
+            stderr, "application_benchmark: application_benchmark_occlusion failed\n"
+        );
         return false;
     }
 
-    return true;
-}
-
-/// @param[in] application
-/// @note `application` will be invalid after this function has been called
-static void application_destroy(const struct application *application) {
-    const struct vulkan *vulkan = &application->vulkan;
-
-    vkDestroySemaphore(vulkan->device, vulkan->swapchain_image_available, nullptr);
-    vkDestroySemaphore(vulkan->device, vulkan->render_finished, nullptr);
-    vkDestroyFence(vulkan->device, vulkan->frame_in_flight, nullptr);
-    vkDestroyCommandPool(vulkan->device, vulkan->command_pool, nullptr);
-    for (size_t i = 0; i < application->vulkan.swapchain_framebuffers_count; i++) {
-      vkDestroyFramebuffer(vulkan->device, vulkan->swapchain_framebuffers[i], nullptr);
-    }
-    vkDestroyPipeline(vulkan->device, vulkan->graphics_pipeline, nullptr);
-    vkDestroyPipelineLayout(vulkan->device, vulkan->pipeline_layout, nullptr);
-    vkDestroyRenderPass(vulkan->device, vulkan->render_pass, nullptr);
-    for (size_t i = 0; i < vulkan->swapchain_imageviews_count; i++) {
-      vkDestroyImageView(vulkan->device, vulkan->swapchain_imageviews[i], nullptr);
+    if (!application_benchmark_gpucull(application)) {
+        fprintf(
+            stderr, "application_benchmark: application_benchmark_gpucull failed\n"
+        );
+        return false;
     }
-    vkDestroySwapchainKHR(vulkan->device, vulkan->swapchain, nullptr);
-    vkDestroyDevice(vulkan->device, nullptr);
-    vkDestroySurfaceKHR(vulkan->instance, vulkan->surface, nullptr);
-    vkDestroyInstance(vulkan->instance, nullptr);
-    glfwDestroyWindow(application->window);
-    glfwTerminate();
-}
-
-/// @param[in] application
-/// @return `true` on success and `false` otherwise
-static bool application_mainloop(const struct application *application) {
-    while (!glfwWindowShouldClose(application->window)) {
-        glfwPollEvents();
 
-        if (!vulkan_frame_draw(&application->vulkan)) {
-            fprintf(stderr, "application_mainloop: vulkan_drawframe failed\n");
-        }
+    if (!application_benchmark_lod(application)) {
+        fprintf(stderr, "application_benchmark: application_benchmark_lod failed\n");
+        return false;
     }
 
     return true;
 }
 
-int main(void) {
+int main(int argc, char *argv[]) {
     int success = EXIT_FAILURE;
 
     struct application application = {};
@@ -1337,12 +5947,37 @@ int main(void) {
         .debug = true,
     };
 
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--shader-objects") == 0) {
+            config.shader_objects = true;
+        } else if (strcmp(argv[i], "--benchmark") == 0) {
+            config.benchmark = true;
+            config.debug = false;
+        } else if (strcmp(argv[i], "--mesh") == 0 && i + 1 < argc) {
+            config.mesh = argv[++i];
+        } else if (strcmp(argv[i], "--hud") == 0) {
+            config.hud = true;
+        } else {
+            fprintf(
+                stderr,
+                "usage: %s [--shader-objects] [--benchmark] [--mesh FILE] [--hud]\n",
+                argv[0]
+            );
+            return EXIT_FAILURE;
+        }
+    }
+
     if (!application_create(&config, &application)) {
         fprintf(stderr, "main: application_create failed\n");
         goto cleanup;
     }
 
-    if (!application_mainloop(&application)) {
+    if (config.benchmark) {
+        if (!application_benchmark(&application)) {
+            fprintf(stderr, "main: application_benchmark failed\n");
+            goto cleanup;
+        }
+    } else if (!application_mainloop(&application)) {
         fprintf(stderr, "main: application_mainloop failed\n");
         goto cleanup;
     }
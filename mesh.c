@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "mesh.h"
+
+bool mesh_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    enum vertexformat format,
+    const struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    const uint32_t *indices,
+    uint32_t indices_count,
+    struct mesh *mesh
+) {
+    *mesh = (struct mesh){
+        .format = format,
+        .vertices_count = vertices_count,
+        .indices_count = indices_count,
+    };
+
+    vertexformat_decode_compute(format, vertices, vertices_count, &mesh->decode);
+    for (uint32_t i = 0; i < vertices_count; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            float position = vertices[i].position[j];
+            if (i == 0 || position < mesh->bounds_min[j]) {
+                mesh->bounds_min[j] = position;
+            }
+            if (i == 0 || position > mesh->bounds_max[j]) {
+                mesh->bounds_max[j] = position;
+            }
+        }
+    }
+
+    // Device local where the host can map it, so the benchmark measures vertex
+    // fetch and not transfers over the bus
+    if (!buffer_create(
+        device,
+        memory_properties,
+        vertexformat_stride(format) * vertices_count,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &mesh->vertices
+    )) {
+        fprintf(stderr, "mesh_create: buffer_create(vertices) failed\n");
+        goto cleanup;
+    }
+
+    if (!buffer_create(
+        device,
+        memory_properties,
+        sizeof(indices[0]) * indices_count,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &mesh->indices
+    )) {
+        fprintf(stderr, "mesh_create: buffer_create(indices) failed\n");
+        goto cleanup;
+    }
+
+    vertexformat_encode(
+        format, vertices, vertices_count, &mesh->decode, mesh->vertices.mapped
+    );
+    memcpy(mesh->indices.mapped, indices, sizeof(indices[0]) * indices_count);
+
+    return true;
+
+cleanup:
+    mesh_destroy(device, mesh);
+
+    return false;
+}
+
+void mesh_destroy(VkDevice device, struct mesh *mesh) {
+    buffer_destroy(device, &mesh->indices);
+    buffer_destroy(device, &mesh->vertices);
+
+    *mesh = (struct mesh){};
+}
+
+void mesh_bind(
+    const struct mesh *mesh, VkCommandBuffer command_buffer, VkPipelineLayout layout
+) {
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &mesh->vertices.buffer, &offset);
+    vkCmdBindIndexBuffer(command_buffer, mesh->indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdPushConstants(
+        command_buffer,
+        layout,
+        VK_SHADER_STAGE_VERTEX_BIT,
+        0,
+        sizeof(mesh->decode),
+        &mesh->decode
+    );
+}
+
+void mesh_draw(const struct mesh *mesh, VkCommandBuffer command_buffer) {
+    vkCmdDrawIndexed(command_buffer, mesh->indices_count, 1, 0, 0, 0);
+}
+
+bool mesh_draw_range(
+    const struct mesh *mesh,
+    VkCommandBuffer command_buffer,
+    uint32_t first_index,
+    uint32_t indices_count
+) {
+    // Also catches a range picked for a mesh that has been replaced since
+    if (
+        first_index > mesh->indices_count ||
+        indices_count > mesh->indices_count - first_index
+    ) {
+        fprintf(
+            stderr,
+            "mesh_draw_range: %u indices from %u are out of bounds\n",
+            indices_count,
+            first_index
+        );
+        return false;
+    }
+
+    vkCmdDrawIndexed(command_buffer, indices_count, 1, first_index, 0, 0);
+
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "buffer.h"
+#include "vertexformat.h"
+
+/// Indexed triangle list in a vertex and an index buffer the device can read
+struct mesh {
+    enum vertexformat format;
+    struct vertexformat_decode decode;
+    /// Axis aligned bounds of the positions, all zero without vertices
+    float bounds_min[3];
+    float bounds_max[3];
+
+    struct buffer vertices;
+    uint32_t vertices_count;
+
+    struct buffer indices;
+    uint32_t indices_count;
+};
+
+/// @param[in] device
+/// @param[in] memory_properties
+/// @param[in] format Anything but `VERTEXFORMAT_NONE`
+/// @param[in] vertices
+/// @param[in] vertices_count
+/// @param[in] indices
+/// @param[in] indices_count
+/// @param[out] mesh
+/// @return `true` on success and `false` otherwise
+/// @note Encodes `vertices` as `format` straight into host visible memory
+/// @note Caller is responsible to call `mesh_destroy` after successful return
+bool mesh_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    enum vertexformat format,
+    const struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    const uint32_t *indices,
+    uint32_t indices_count,
+    struct mesh *mesh
+);
+
+/// @param[in] device
+/// @param[in,out] mesh
+/// @note `mesh` will be invalid after this function has been called
+void mesh_destroy(VkDevice device, struct mesh *mesh);
+
+/// @param[in] mesh
+/// @param[in] command_buffer
+/// @param[in] layout Declares `vertexformat_decode` as vertex stage push
+/// constants at offset zero
+/// @note Binds the buffers and pushes the decode constants, any number of
+/// `mesh_draw` can follow
+void mesh_bind(
+    const struct mesh *mesh, VkCommandBuffer command_buffer, VkPipelineLayout layout
+);
+
+/// @param[in] mesh
+/// @param[in] command_buffer
+void mesh_draw(const struct mesh *mesh, VkCommandBuffer command_buffer);
+
+/// Draws part of the index buffer, e.g. one level of detail
+/// @param[in] mesh
+/// @param[in] command_buffer
+/// @param[in] first_index
+/// @param[in] indices_count
+/// @return `true` on success and `false` if the range does not lie within the
+/// `indices_count` of `mesh`
+bool mesh_draw_range(
+    const struct mesh *mesh,
+    VkCommandBuffer command_buffer,
+    uint32_t first_index,
+    uint32_t indices_count
+);
+
+#endif
@@ -0,0 +1,1610 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file.h"
+#include "meshimport.h"
+
+/// @param[in,out] array
+/// @param[in] element_size
+/// @param[in] count
+/// @param[in,out] capacity
+/// @return `true` if `array` has room for one more element
+static bool meshimport_reserve(
+    void **array, size_t element_size, size_t count, size_t *capacity
+) {
+    if (count < *capacity) {
+        return true;
+    }
+
+    size_t new_capacity = *capacity * 2 + 64;
+    void *new_array = realloc(*array, element_size * new_capacity);
+    if (new_array == nullptr) {
+        return false;
+    }
+
+    *array = new_array;
+    *capacity = new_capacity;
+
+    return true;
+}
+
+/// @param[in] a
+/// @param[in] b
+/// @param[in] c
+/// @param[out] normal Normal of the triangle by the right hand rule, twice its
+/// area in length
+static void meshimport_face_normal(
+    const float a[3], const float b[3], const float c[3], float normal[3]
+) {
+    float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+    normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+    normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+}
+
+/// @param[in,out] cursor Advanced past spaces and tabs
+/// @param[in] end
+static void meshimport_space_skip(const char **cursor, const char *end) {
+    while (*cursor < end && (**cursor == ' ' || **cursor == '\t' || **cursor == '\r')) {
+        (*cursor)++;
+    }
+}
+
+/// @param[in,out] cursor Advanced past the number
+/// @param[in] end
+/// @param[out] value
+/// @return `true` if a decimal integer was read
+static bool meshimport_integer(const char **cursor, const char *end, int64_t *value) {
+    const char *p = *cursor;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    if (p == end || *p < '0' || *p > '9') {
+        return false;
+    }
+
+    int64_t result = 0;
+    while (p < end && *p >= '0' && *p <= '9' && result < INT64_MAX / 10 - 10) {
+        result = result * 10 + (*p - '0');
+        p++;
+    }
+
+    *value = negative ? -result : result;
+    *cursor = p;
+
+    return true;
+}
+
+/// Locale independent and much faster than `strtof`, exact to within a unit
+/// in the last place of a float
+/// @param[in,out] cursor Advanced past the number
+/// @param[in] end
+/// @param[out] value
+/// @return `true` if a decimal floating point number was read
+static bool meshimport_float(const char **cursor, const char *end, float *value) {
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    constexpr int32_t powers_count = sizeof(powers) / sizeof(powers[0]);
+
+    const char *p = *cursor;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    // Digits beyond what the mantissa holds only shift the exponent
+    uint64_t mantissa = 0;
+    int32_t exponent = 0;
+    bool digits = false;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (mantissa < UINT64_MAX / 10 - 10) {
+            mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+        } else {
+            exponent++;
+        }
+        digits = true;
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (mantissa < UINT64_MAX / 10 - 10) {
+                mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+                exponent--;
+            }
+            digits = true;
+        }
+    }
+    if (!digits) {
+        return false;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *exponent_cursor = p + 1;
+        int64_t explicit_exponent;
+        if (meshimport_integer(&exponent_cursor, end, &explicit_exponent)) {
+            if (explicit_exponent > 1000) {
+                explicit_exponent = 1000;
+            } else if (explicit_exponent < -1000) {
+                explicit_exponent = -1000;
+            }
+            exponent += (int32_t) explicit_exponent;
+            p = exponent_cursor;
+        }
+    }
+
+    double result = (double) mantissa;
+    if (exponent > 0) {
+        result *= exponent < powers_count ? powers[exponent] : pow(10.0, exponent);
+    } else if (exponent < 0) {
+        result /= -exponent < powers_count ? powers[-exponent] : pow(10.0, -exponent);
+    }
+
+    *value = (float) (negative ? -result : result);
+    *cursor = p;
+
+    return true;
+}
+
+/// Attributes an OBJ face corner refers to
+enum meshimport_obj_attribute {
+    MESHIMPORT_OBJ_POSITION,
+    MESHIMPORT_OBJ_UV,
+    MESHIMPORT_OBJ_NORMAL,
+    MESHIMPORT_OBJ_ATTRIBUTES_COUNT,
+};
+
+/// A corner as written in the file, before the chunks know where they begin
+struct meshimport_obj_corner {
+    /// Zero based, relative to the chunk for relative indices
+    int64_t indices[MESHIMPORT_OBJ_ATTRIBUTES_COUNT];
+    /// Bit per attribute given by a negative index in the file
+    uint8_t relative;
+    /// Bit per attribute the corner refers to
+    uint8_t present;
+};
+
+/// `v` with the optional vertex color extension
+struct meshimport_obj_position {
+    float position[3];
+    float color[4];
+};
+
+struct meshimport_obj_uv {
+    float uv[2];
+};
+
+struct meshimport_obj_normal {
+    float normal[3];
+};
+
+/// Lines of the file one job parses, and then resolves to vertices
+struct meshimport_obj_chunk {
+    const char *begin;
+    const char *end;
+
+    struct meshimport_obj_position *positions;
+    size_t positions_count;
+    size_t positions_capacity;
+    struct meshimport_obj_uv *uvs;
+    size_t uvs_count;
+    size_t uvs_capacity;
+    struct meshimport_obj_normal *normals;
+    size_t normals_count;
+    size_t normals_capacity;
+    /// Three per triangle, polygons are split into fans
+    struct meshimport_obj_corner *corners;
+    size_t corners_count;
+    size_t corners_capacity;
+
+    /// Number of each attribute in the chunks before this one
+    size_t bases[MESHIMPORT_OBJ_ATTRIBUTES_COUNT];
+    /// First vertex this chunk resolves its corners to
+    size_t vertices_offset;
+    const struct meshimport_obj *obj;
+
+    bool success;
+};
+
+/// Attributes of every chunk, concatenated once all of them are parsed
+struct meshimport_obj {
+    struct meshimport_obj_position *positions;
+    size_t positions_count;
+    struct meshimport_obj_uv *uvs;
+    size_t uvs_count;
+    struct meshimport_obj_normal *normals;
+    size_t normals_count;
+
+    struct vertexformat_vertex *vertices;
+};
+
+/// @param[in,out] chunk
+/// @param[in,out] cursor
+/// @param[in] end
+/// @return `true` on success and `false` otherwise
+static bool meshimport_obj_face_parse(
+    struct meshimport_obj_chunk *chunk, const char **cursor, const char *end
+) {
+    const size_t counts[MESHIMPORT_OBJ_ATTRIBUTES_COUNT] = {
+        [MESHIMPORT_OBJ_POSITION] = chunk->positions_count,
+        [MESHIMPORT_OBJ_UV] = chunk->uvs_count,
+        [MESHIMPORT_OBJ_NORMAL] = chunk->normals_count,
+    };
+
+    struct meshimport_obj_corner first = {};
+    struct meshimport_obj_corner previous = {};
+    size_t corners = 0;
+    for (;;) {
+        meshimport_space_skip(cursor, end);
+        if (*cursor == end) {
+            break;
+        }
+
+        // `v`, `v/vt`, `v//vn` or `v/vt/vn`
+        struct meshimport_obj_corner corner = {};
+        for (size_t i = 0; i < MESHIMPORT_OBJ_ATTRIBUTES_COUNT; i++) {
+            if (i > 0) {
+                if (*cursor == end || **cursor != '/') {
+                    break;
+                }
+                (*cursor)++;
+            }
+
+            int64_t index;
+            if (!meshimport_integer(cursor, end, &index)) {
+                if (i == MESHIMPORT_OBJ_POSITION) {
+                    return false;
+                }
+                continue;
+            }
+            if (index == 0) {
+                return false;
+            }
+
+            corner.present |= 1u << i;
+            if (index > 0) {
+                corner.indices[i] = index - 1;
+            } else {
+                corner.indices[i] = (int64_t) counts[i] + index;
+                corner.relative |= 1u << i;
+            }
+        }
+
+        if (corners == 0) {
+            first = corner;
+        } else if (corners >= 2) {
+            // Room for three more corners
+            if (!meshimport_reserve(
+                (void **) &chunk->corners,
+                sizeof(chunk->corners[0]),
+                chunk->corners_count + 2,
+                &chunk->corners_capacity
+            )) {
+                return false;
+            }
+            chunk->corners[chunk->corners_count++] = first;
+            chunk->corners[chunk->corners_count++] = previous;
+            chunk->corners[chunk->corners_count++] = corner;
+        }
+        previous = corner;
+        corners++;
+    }
+
+    return corners >= 3;
+}
+
+/// @param[in,out] chunk
+/// @param[in] line
+/// @param[in] end
+/// @return `true` on success and `false` otherwise
+static bool meshimport_obj_line_parse(
+    struct meshimport_obj_chunk *chunk, const char *line, const char *end
+) {
+    const char *cursor = line;
+    meshimport_space_skip(&cursor, end);
+
+    const char *keyword = cursor;
+    while (cursor < end && *cursor != ' ' && *cursor != '\t') {
+        cursor++;
+    }
+    size_t keyword_size = (size_t) (cursor - keyword);
+
+    if (keyword_size == 1 && keyword[0] == 'v') {
+        if (!meshimport_reserve(
+            (void **) &chunk->positions,
+            sizeof(chunk->positions[0]),
+            chunk->positions_count,
+            &chunk->positions_capacity
+        )) {
+            return false;
+        }
+
+        float values[7];
+        size_t values_count = 0;
+        for (; values_count < 7; values_count++) {
+            meshimport_space_skip(&cursor, end);
+            if (!meshimport_float(&cursor, end, &values[values_count])) {
+                break;
+            }
+        }
+        if (values_count < 3) {
+            return false;
+        }
+
+        struct meshimport_obj_position *position = (
+            &chunk->positions[chunk->positions_count++]
+        );
+        *position = (struct meshimport_obj_position){
+            .position = {values[0], values[1], values[2]},
+            .color = {1.0f, 1.0f, 1.0f, 1.0f},
+        };
+        // A fourth value alone is the rarely used `w`
+        if (values_count >= 6) {
+            memcpy(position->color, &values[3], sizeof(float) * 3);
+        }
+    } else if (keyword_size == 2 && keyword[0] == 'v' && keyword[1] == 't') {
+        if (!meshimport_reserve(
+            (void **) &chunk->uvs,
+            sizeof(chunk->uvs[0]),
+            chunk->uvs_count,
+            &chunk->uvs_capacity
+        )) {
+            return false;
+        }
+
+        struct meshimport_obj_uv *uv = &chunk->uvs[chunk->uvs_count++];
+        *uv = (struct meshimport_obj_uv){};
+        for (size_t i = 0; i < 2; i++) {
+            meshimport_space_skip(&cursor, end);
+            if (!meshimport_float(&cursor, end, &uv->uv[i]) && i == 0) {
+                return false;
+            }
+        }
+        // OBJ puts the origin of texture coordinates at the bottom
+        uv->uv[1] = 1.0f - uv->uv[1];
+    } else if (keyword_size == 2 && keyword[0] == 'v' && keyword[1] == 'n') {
+        if (!meshimport_reserve(
+            (void **) &chunk->normals,
+            sizeof(chunk->normals[0]),
+            chunk->normals_count,
+            &chunk->normals_capacity
+        )) {
+            return false;
+        }
+
+        struct meshimport_obj_normal *normal = &chunk->normals[chunk->normals_count++];
+        for (size_t i = 0; i < 3; i++) {
+            meshimport_space_skip(&cursor, end);
+            if (!meshimport_float(&cursor, end, &normal->normal[i])) {
+                return false;
+            }
+        }
+    } else if (keyword_size == 1 && keyword[0] == 'f') {
+        return meshimport_obj_face_parse(chunk, &cursor, end);
+    }
+
+    // Groups, materials, smoothing groups, comments and empty lines
+    return true;
+}
+
+/// Parses the lines of a `meshimport_obj_chunk`
+/// @param[in,out] argument
+static void meshimport_obj_parse_job(void *argument) {
+    struct meshimport_obj_chunk *chunk = argument;
+
+    size_t line_number = 0;
+    const char *cursor = chunk->begin;
+    while (cursor < chunk->end) {
+        const char *line_end = memchr(cursor, '\n', (size_t) (chunk->end - cursor));
+        if (line_end == nullptr) {
+            line_end = chunk->end;
+        }
+
+        if (!meshimport_obj_line_parse(chunk, cursor, line_end)) {
+            fprintf(
+                stderr,
+                "meshimport_obj_parse_job: line %zu of chunk is malformed: %.*s\n",
+                line_number + 1,
+                (int) (line_end - cursor < 80 ? line_end - cursor : 80),
+                cursor
+            );
+            chunk->success = false;
+            return;
+        }
+
+        cursor = line_end + 1;
+        line_number++;
+    }
+
+    chunk->success = true;
+}
+
+/// Turns the corners of a `meshimport_obj_chunk` into vertices
+/// @param[in,out] argument
+static void meshimport_obj_resolve_job(void *argument) {
+    struct meshimport_obj_chunk *chunk = argument;
+    const struct meshimport_obj *obj = chunk->obj;
+    const size_t counts[MESHIMPORT_OBJ_ATTRIBUTES_COUNT] = {
+        [MESHIMPORT_OBJ_POSITION] = obj->positions_count,
+        [MESHIMPORT_OBJ_UV] = obj->uvs_count,
+        [MESHIMPORT_OBJ_NORMAL] = obj->normals_count,
+    };
+
+    chunk->success = false;
+
+    struct vertexformat_vertex *vertices = &obj->vertices[chunk->vertices_offset];
+    for (size_t i = 0; i < chunk->corners_count; i++) {
+        const struct meshimport_obj_corner *corner = &chunk->corners[i];
+
+        size_t indices[MESHIMPORT_OBJ_ATTRIBUTES_COUNT] = {};
+        for (size_t j = 0; j < MESHIMPORT_OBJ_ATTRIBUTES_COUNT; j++) {
+            if ((corner->present & (1u << j)) == 0) {
+                continue;
+            }
+
+            int64_t index = corner->indices[j];
+            if (corner->relative & (1u << j)) {
+                index += (int64_t) chunk->bases[j];
+            }
+            if (index < 0 || (size_t) index >= counts[j]) {
+                fprintf(
+                    stderr,
+                    "meshimport_obj_resolve_job: index %lld is out of bounds\n",
+                    (long long) index
+                );
+                return;
+            }
+            indices[j] = (size_t) index;
+        }
+
+        const struct meshimport_obj_position *position = (
+            &obj->positions[indices[MESHIMPORT_OBJ_POSITION]]
+        );
+        struct vertexformat_vertex *vertex = &vertices[i];
+        *vertex = (struct vertexformat_vertex){};
+        memcpy(vertex->position, position->position, sizeof(vertex->position));
+        memcpy(vertex->color, position->color, sizeof(vertex->color));
+        if (corner->present & (1u << MESHIMPORT_OBJ_UV)) {
+            memcpy(
+                vertex->uv, obj->uvs[indices[MESHIMPORT_OBJ_UV]].uv, sizeof(vertex->uv)
+            );
+        }
+        if (corner->present & (1u << MESHIMPORT_OBJ_NORMAL)) {
+            memcpy(
+                vertex->normal,
+                obj->normals[indices[MESHIMPORT_OBJ_NORMAL]].normal,
+                sizeof(vertex->normal)
+            );
+        }
+    }
+
+    chunk->success = true;
+}
+
+constexpr size_t MESHIMPORT_OBJ_CHUNK_SIZE = 1 << 20;
+
+/// @param[in,out] jobs
+/// @param[in] content
+/// @param[in] content_size
+/// @param[out] meshimport
+/// @return `true` on success and `false` otherwise
+static bool meshimport_obj_load(
+    struct jobs *jobs,
+    const uint8_t *content,
+    size_t content_size,
+    struct meshimport *meshimport
+) {
+    bool success = false;
+
+    const char *text = (const char *) content;
+    const char *text_end = text + content_size;
+
+    size_t chunks_count = content_size / MESHIMPORT_OBJ_CHUNK_SIZE + 1;
+    struct meshimport_obj obj = {};
+    struct meshimport_obj_chunk *chunks = calloc(chunks_count, sizeof(chunks[0]));
+    if (chunks == nullptr) {
+        fprintf(stderr, "meshimport_obj_load: malloc failed\n");
+        goto cleanup;
+    }
+
+    // Every chunk starts at the beginning of a line
+    for (size_t i = 0; i < chunks_count; i++) {
+        const char *begin = text + content_size / chunks_count * i;
+        if (i > 0) {
+            const char *newline = memchr(
+                begin - 1, '\n', (size_t) (text_end - begin + 1)
+            );
+            begin = newline != nullptr ? newline + 1 : text_end;
+        }
+        chunks[i].begin = begin;
+        if (i > 0) {
+            chunks[i - 1].end = begin;
+        }
+    }
+    chunks[chunks_count - 1].end = text_end;
+
+    struct jobs_counter parsed = {};
+    for (size_t i = 0; i < chunks_count; i++) {
+        if (!jobs_submit(jobs, meshimport_obj_parse_job, &chunks[i], &parsed)) {
+            fprintf(stderr, "meshimport_obj_load: jobs_submit failed\n");
+            meshimport_obj_parse_job(&chunks[i]);
+        }
+    }
+    jobs_counter_wait(jobs, &parsed);
+
+    // Relative indices and the vertices of each chunk can only be placed once
+    // the size of every chunk before it is known
+    size_t corners_count = 0;
+    for (size_t i = 0; i < chunks_count; i++) {
+        struct meshimport_obj_chunk *chunk = &chunks[i];
+        if (!chunk->success) {
+            fprintf(stderr, "meshimport_obj_load: meshimport_obj_parse_job failed\n");
+            goto cleanup;
+        }
+
+        chunk->bases[MESHIMPORT_OBJ_POSITION] = obj.positions_count;
+        chunk->bases[MESHIMPORT_OBJ_UV] = obj.uvs_count;
+        chunk->bases[MESHIMPORT_OBJ_NORMAL] = obj.normals_count;
+        chunk->vertices_offset = corners_count;
+        chunk->obj = &obj;
+
+        obj.positions_count += chunk->positions_count;
+        obj.uvs_count += chunk->uvs_count;
+        obj.normals_count += chunk->normals_count;
+        corners_count += chunk->corners_count;
+    }
+
+    if (corners_count == 0 || corners_count > UINT32_MAX) {
+        fprintf(stderr, "meshimport_obj_load: %zu corners\n", corners_count);
+        goto cleanup;
+    }
+
+    obj.positions = malloc(sizeof(obj.positions[0]) * (obj.positions_count + 1));
+    obj.uvs = malloc(sizeof(obj.uvs[0]) * (obj.uvs_count + 1));
+    obj.normals = malloc(sizeof(obj.normals[0]) * (obj.normals_count + 1));
+    obj.vertices = malloc(sizeof(obj.vertices[0]) * corners_count);
+    meshimport->indices = malloc(sizeof(meshimport->indices[0]) * corners_count);
+    if (
+        obj.positions == nullptr ||
+        obj.uvs == nullptr ||
+        obj.normals == nullptr ||
+        obj.vertices == nullptr ||
+        meshimport->indices == nullptr
+    ) {
+        fprintf(stderr, "meshimport_obj_load: malloc failed\n");
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < chunks_count; i++) {
+        const struct meshimport_obj_chunk *chunk = &chunks[i];
+        memcpy(
+            &obj.positions[chunk->bases[MESHIMPORT_OBJ_POSITION]],
+            chunk->positions,
+            sizeof(obj.positions[0]) * chunk->positions_count
+        );
+        memcpy(
+            &obj.uvs[chunk->bases[MESHIMPORT_OBJ_UV]],
+            chunk->uvs,
+            sizeof(obj.uvs[0]) * chunk->uvs_count
+        );
+        memcpy(
+            &obj.normals[chunk->bases[MESHIMPORT_OBJ_NORMAL]],
+            chunk->normals,
+            sizeof(obj.normals[0]) * chunk->normals_count
+        );
+    }
+
+    struct jobs_counter resolved = {};
+    for (size_t i = 0; i < chunks_count; i++) {
+        if (!jobs_submit(jobs, meshimport_obj_resolve_job, &chunks[i], &resolved)) {
+            fprintf(stderr, "meshimport_obj_load: jobs_submit failed\n");
+            meshimport_obj_resolve_job(&chunks[i]);
+        }
+    }
+    jobs_counter_wait(jobs, &resolved);
+
+    for (size_t i = 0; i < chunks_count; i++) {
+        if (!chunks[i].success) {
+            fprintf(stderr, "meshimport_obj_load: meshimport_obj_resolve_job failed\n");
+            goto cleanup;
+        }
+    }
+
+    // Every corner is its own vertex until they are deduplicated
+    for (size_t i = 0; i < corners_count; i++) {
+        meshimport->indices[i] = (uint32_t) i;
+    }
+    meshimport->vertices = obj.vertices;
+    meshimport->vertices_count = (uint32_t) corners_count;
+    meshimport->indices_count = (uint32_t) corners_count;
+    obj.vertices = nullptr;
+
+    success = true;
+
+cleanup:
+    free(obj.vertices);
+    free(obj.normals);
+    free(obj.uvs);
+    free(obj.positions);
+    if (chunks != nullptr) {
+        for (size_t i = 0; i < chunks_count; i++) {
+            free(chunks[i].corners);
+            free(chunks[i].normals);
+            free(chunks[i].uvs);
+            free(chunks[i].positions);
+        }
+    }
+    free(chunks);
+
+    return success;
+}
+
+constexpr uint32_t MESHIMPORT_JSON_MAX_DEPTH = 64;
+
+enum meshimport_json_type {
+    MESHIMPORT_JSON_OBJECT,
+    MESHIMPORT_JSON_ARRAY,
+    MESHIMPORT_JSON_STRING,
+    /// Number, `true`, `false` or `null`
+    MESHIMPORT_JSON_PRIMITIVE,
+};
+
+/// Value in a flattened JSON document. Object members are a string token
+/// followed by the value, and the children of a token directly follow it.
+struct meshimport_json_token {
+    enum meshimport_json_type type;
+    /// Byte range of the value, strings without their quotes
+    uint32_t begin;
+    uint32_t end;
+    /// Index of the first token after the children
+    uint32_t next;
+};
+
+struct meshimport_json {
+    const char *text;
+    uint32_t text_size;
+    uint32_t position;
+
+    struct meshimport_json_token *tokens;
+    size_t tokens_count;
+    size_t tokens_capacity;
+};
+
+/// @param[in,out] json
+static void meshimport_json_space_skip(struct meshimport_json *json) {
+    while (json->position < json->text_size) {
+        char c = json->text[json->position];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        json->position++;
+    }
+}
+
+/// @param[in,out] json
+/// @param[in] depth
+/// @return `true` if a value was appended with its children
+static bool meshimport_json_value_parse(struct meshimport_json *json, uint32_t depth) {
+    meshimport_json_space_skip(json);
+    if (json->position >= json->text_size || depth > MESHIMPORT_JSON_MAX_DEPTH) {
+        return false;
+    }
+
+    if (!meshimport_reserve(
+        (void **) &json->tokens,
+        sizeof(json->tokens[0]),
+        json->tokens_count,
+        &json->tokens_capacity
+    )) {
+        return false;
+    }
+    size_t index = json->tokens_count++;
+    struct meshimport_json_token token = {.begin = json->position};
+
+    char c = json->text[json->position];
+    if (c == '{' || c == '[') {
+        char close = c == '{' ? '}' : ']';
+        token.type = c == '{' ? MESHIMPORT_JSON_OBJECT : MESHIMPORT_JSON_ARRAY;
+        json->position++;
+
+        meshimport_json_space_skip(json);
+        bool first = true;
+        while (json->position < json->text_size && json->text[json->position] != close) {
+            if (!first) {
+                if (json->text[json->position] != ',') {
+                    return false;
+                }
+                json->position++;
+            }
+            first = false;
+
+            if (token.type == MESHIMPORT_JSON_OBJECT) {
+                meshimport_json_space_skip(json);
+                if (
+                    json->position >= json->text_size ||
+                    json->text[json->position] != '"' ||
+                    !meshimport_json_value_parse(json, depth + 1)
+                ) {
+                    return false;
+                }
+                meshimport_json_space_skip(json);
+                if (
+                    json->position >= json->text_size ||
+                    json->text[json->position] != ':'
+                ) {
+                    return false;
+                }
+                json->position++;
+            }
+
+            if (!meshimport_json_value_parse(json, depth + 1)) {
+                return false;
+            }
+            meshimport_json_space_skip(json);
+        }
+        if (json->position >= json->text_size) {
+            return false;
+        }
+        json->position++;
+        token.end = json->position;
+    } else if (c == '"') {
+        token.type = MESHIMPORT_JSON_STRING;
+        json->position++;
+        token.begin = json->position;
+        while (json->position < json->text_size && json->text[json->position] != '"') {
+            // Escapes are kept as they are, keys and names in glTF need none
+            if (json->text[json->position] == '\\') {
+                json->position++;
+            }
+            json->position++;
+        }
+        if (json->position >= json->text_size) {
+            return false;
+        }
+        token.end = json->position;
+        json->position++;
+    } else {
+        token.type = MESHIMPORT_JSON_PRIMITIVE;
+        while (json->position < json->text_size) {
+            c = json->text[json->position];
+            if (c == ',' || c == '}' || c == ']' || c == ' ' || c == '\n' || c == '\r') {
+                break;
+            }
+            json->position++;
+        }
+        token.end = json->position;
+        if (token.end == token.begin) {
+            return false;
+        }
+    }
+
+    token.next = (uint32_t) json->tokens_count;
+    json->tokens[index] = token;
+
+    return true;
+}
+
+/// @param[in] json
+/// @param[in] object Token index, may be `UINT32_MAX`
+/// @param[in] key
+/// @return Token index of the value of `key`, `UINT32_MAX` if there is none
+static uint32_t meshimport_json_member(
+    const struct meshimport_json *json, uint32_t object, const char *key
+) {
+    if (object == UINT32_MAX || json->tokens[object].type != MESHIMPORT_JSON_OBJECT) {
+        return UINT32_MAX;
+    }
+
+    size_t key_size = strlen(key);
+    uint32_t child = object + 1;
+    while (child < json->tokens[object].next) {
+        const struct meshimport_json_token *name = &json->tokens[child];
+        uint32_t value = child + 1;
+        if (
+            name->end - name->begin == key_size &&
+            memcmp(&json->text[name->begin], key, key_size) == 0
+        ) {
+            return value;
+        }
+        child = json->tokens[value].next;
+    }
+
+    return UINT32_MAX;
+}
+
+/// @param[in] json
+/// @param[in] array Token index, may be `UINT32_MAX`
+/// @param[in] index
+/// @return Token index of element `index`, `UINT32_MAX` if there is none
+static uint32_t meshimport_json_element(
+    const struct meshimport_json *json, uint32_t array, uint32_t index
+) {
+    if (array == UINT32_MAX || json->tokens[array].type != MESHIMPORT_JSON_ARRAY) {
+        return UINT32_MAX;
+    }
+
+    uint32_t child = array + 1;
+    for (uint32_t i = 0; child < json->tokens[array].next; i++) {
+        if (i == index) {
+            return child;
+        }
+        child = json->tokens[child].next;
+    }
+
+    return UINT32_MAX;
+}
+
+/// @param[in] json
+/// @param[in] object Token index, may be `UINT32_MAX`
+/// @param[in] key
+/// @param[in] fallback Returned if `key` is missing or not a number
+/// @return Value of `key` as an unsigned integer
+static uint64_t meshimport_json_uint(
+    const struct meshimport_json *json,
+    uint32_t object,
+    const char *key,
+    uint64_t fallback
+) {
+    uint32_t value = meshimport_json_member(json, object, key);
+    if (value == UINT32_MAX || json->tokens[value].type != MESHIMPORT_JSON_PRIMITIVE) {
+        return fallback;
+    }
+
+    const char *cursor = &json->text[json->tokens[value].begin];
+    int64_t result;
+    if (
+        !meshimport_integer(&cursor, &json->text[json->tokens[value].end], &result) ||
+        result < 0
+    ) {
+        return fallback;
+    }
+
+    return (uint64_t) result;
+}
+
+/// @param[in] json
+/// @param[in] token
+/// @param[in] string
+/// @return `true` if `token` is the string `string`
+static bool meshimport_json_equals(
+    const struct meshimport_json *json, uint32_t token, const char *string
+) {
+    if (token == UINT32_MAX || json->tokens[token].type != MESHIMPORT_JSON_STRING) {
+        return false;
+    }
+
+    size_t size = strlen(string);
+    return (
+        json->tokens[token].end - json->tokens[token].begin == size &&
+        memcmp(&json->text[json->tokens[token].begin], string, size) == 0
+    );
+}
+
+constexpr uint32_t GLB_MAGIC = 0x46546c67;
+constexpr uint32_t GLB_CHUNK_JSON = 0x4e4f534a;
+constexpr uint32_t GLB_CHUNK_BIN = 0x004e4942;
+
+constexpr uint32_t GLTF_BYTE = 5120;
+constexpr uint32_t GLTF_UNSIGNED_BYTE = 5121;
+constexpr uint32_t GLTF_SHORT = 5122;
+constexpr uint32_t GLTF_UNSIGNED_SHORT = 5123;
+constexpr uint32_t GLTF_UNSIGNED_INT = 5125;
+constexpr uint32_t GLTF_FLOAT = 5126;
+constexpr uint32_t GLTF_TRIANGLES = 4;
+/// Largest `byteStride` of a buffer view
+constexpr uint64_t GLTF_MAX_STRIDE = 252;
+
+/// Elements of a glTF accessor, resolved down to the binary chunk
+struct meshimport_accessor {
+    const uint8_t *data;
+    size_t stride;
+    uint32_t count;
+    uint32_t components;
+    uint32_t component_type;
+    bool normalized;
+};
+
+struct meshimport_glb {
+    struct meshimport_json json;
+    const uint8_t *bin;
+    size_t bin_size;
+};
+
+/// @param[in] component_type
+/// @return Size of one component in bytes, zero if unknown
+static size_t meshimport_component_size(uint32_t component_type) {
+    switch (component_type) {
+    case GLTF_BYTE:
+    case GLTF_UNSIGNED_BYTE:
+        return 1;
+    case GLTF_SHORT:
+    case GLTF_UNSIGNED_SHORT:
+        return 2;
+    case GLTF_UNSIGNED_INT:
+    case GLTF_FLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+/// @param[in] glb
+/// @param[in] index Accessor index in the document
+/// @param[out] accessor
+/// @return `true` on success and `false` otherwise
+static bool meshimport_accessor_get(
+    const struct meshimport_glb *glb,
+    uint64_t index,
+    struct meshimport_accessor *accessor
+) {
+    const struct meshimport_json *json = &glb->json;
+    uint32_t accessors = meshimport_json_member(json, 0, "accessors");
+    uint32_t object = meshimport_json_element(json, accessors, (uint32_t) index);
+    if (object == UINT32_MAX || index > UINT32_MAX) {
+        fprintf(
+            stderr,
+            "meshimport_accessor_get: accessor %llu not found\n",
+            (unsigned long long) index
+        );
+        return false;
+    }
+    if (meshimport_json_member(json, object, "sparse") != UINT32_MAX) {
+        fprintf(stderr, "meshimport_accessor_get: sparse accessors are not supported\n");
+        return false;
+    }
+
+    static const struct {
+        const char *name;
+        uint32_t components;
+    } types[] = {
+        {"SCALAR", 1},
+        {"VEC2", 2},
+        {"VEC3", 3},
+        {"VEC4", 4},
+    };
+    uint32_t type = meshimport_json_member(json, object, "type");
+    uint32_t components = 0;
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if (meshimport_json_equals(json, type, types[i].name)) {
+            components = types[i].components;
+        }
+    }
+
+    uint32_t normalized = meshimport_json_member(json, object, "normalized");
+    *accessor = (struct meshimport_accessor){
+        .count = (uint32_t) meshimport_json_uint(json, object, "count", 0),
+        .components = components,
+        .component_type = (uint32_t) meshimport_json_uint(
+            json, object, "componentType", 0
+        ),
+        .normalized = (
+            normalized != UINT32_MAX &&
+            json->tokens[normalized].end - json->tokens[normalized].begin == 4 &&
+            memcmp(&json->text[json->tokens[normalized].begin], "true", 4) == 0
+        ),
+    };
+
+    size_t element_size = (
+        meshimport_component_size(accessor->component_type) * accessor->components
+    );
+    if (element_size == 0) {
+        fprintf(stderr, "meshimport_accessor_get: unsupported accessor type\n");
+        return false;
+    }
+
+    uint32_t buffer_views = meshimport_json_member(json, 0, "bufferViews");
+    uint32_t view = meshimport_json_element(
+        json,
+        buffer_views,
+        (uint32_t) meshimport_json_uint(json, object, "bufferView", UINT32_MAX)
+    );
+    if (view == UINT32_MAX || meshimport_json_uint(json, view, "buffer", 0) != 0) {
+        fprintf(
+            stderr,
+            "meshimport_accessor_get: only views of the binary chunk are supported\n"
+        );
+        return false;
+    }
+
+    uint64_t view_offset = meshimport_json_uint(json, view, "byteOffset", 0);
+    uint64_t view_size = meshimport_json_uint(json, view, "byteLength", 0);
+    uint64_t offset = meshimport_json_uint(json, object, "byteOffset", 0);
+
+    // Elements are tightly packed unless the view says otherwise, in which
+    // case the stride has to be aligned and small like the specification asks
+    accessor->stride = element_size;
+    if (meshimport_json_member(json, view, "byteStride") != UINT32_MAX) {
+        uint64_t stride = meshimport_json_uint(json, view, "byteStride", 0);
+        if (stride < element_size || stride > GLTF_MAX_STRIDE || stride % 4 != 0) {
+            fprintf(stderr, "meshimport_accessor_get: invalid byte stride\n");
+            return false;
+        }
+        accessor->stride = (size_t) stride;
+    }
+
+    // Every bound is checked against what is left of the one around it, so
+    // that offsets from the file cannot wrap around. The span cannot wrap
+    // either, with a count of 32 bits and a stride of at most 252 bytes.
+    bool in_bounds = view_offset <= glb->bin_size &&
+        view_size <= glb->bin_size - view_offset &&
+        offset <= view_size;
+    if (in_bounds && accessor->count > 0) {
+        uint64_t span = (uint64_t) accessor->stride * (accessor->count - 1) +
+            element_size;
+        in_bounds = span <= view_size - offset;
+    }
+    if (!in_bounds) {
+        fprintf(stderr, "meshimport_accessor_get: accessor is out of bounds\n");
+        return false;
+    }
+
+    accessor->data = glb->bin + view_offset + offset;
+
+    return true;
+}
+
+/// @param[in] accessor
+/// @param[in] index
+/// @param[in] components
+/// @param[out] values `components` values, converted to float, missing
+/// components are left as they are
+static void meshimport_accessor_read(
+    const struct meshimport_accessor *accessor,
+    uint32_t index,
+    uint32_t components,
+    float *values
+) {
+    const uint8_t *element = accessor->data + accessor->stride * index;
+    for (uint32_t i = 0; i < components && i < accessor->components; i++) {
+        switch (accessor->component_type) {
+        case GLTF_FLOAT: {
+            memcpy(&values[i], element + i * 4, sizeof(float));
+            break;
+        }
+        case GLTF_UNSIGNED_BYTE: {
+            float value = (float) element[i];
+            values[i] = accessor->normalized ? value / 255.0f : value;
+            break;
+        }
+        case GLTF_BYTE: {
+            float value = (float) (int8_t) element[i];
+            values[i] = accessor->normalized ? fmaxf(value / 127.0f, -1.0f) : value;
+            break;
+        }
+        case GLTF_UNSIGNED_SHORT: {
+            uint16_t value;
+            memcpy(&value, element + i * 2, sizeof(value));
+            values[i] = accessor->normalized ? (float) value / 65535.0f : value;
+            break;
+        }
+        case GLTF_SHORT: {
+            int16_t value;
+            memcpy(&value, element + i * 2, sizeof(value));
+            values[i] = (
+                accessor->normalized ? fmaxf((float) value / 32767.0f, -1.0f) : value
+            );
+            break;
+        }
+        case GLTF_UNSIGNED_INT: {
+            uint32_t value;
+            memcpy(&value, element + i * 4, sizeof(value));
+            values[i] = (float) value;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+/// Triangle primitive of a glTF mesh and where it goes in the imported mesh
+struct meshimport_primitive {
+    struct meshimport_accessor positions;
+    struct meshimport_accessor normals;
+    struct meshimport_accessor uvs;
+    struct meshimport_accessor colors;
+    /// No indices when `data` is `nullptr`
+    struct meshimport_accessor indices;
+
+    uint32_t vertices_offset;
+    uint32_t indices_offset;
+    uint32_t indices_count;
+    struct meshimport *meshimport;
+
+    bool success;
+};
+
+/// Decodes a `meshimport_primitive`
+/// @param[in,out] argument
+static void meshimport_primitive_job(void *argument) {
+    struct meshimport_primitive *primitive = argument;
+    struct meshimport *meshimport = primitive->meshimport;
+    struct vertexformat_vertex *vertices = (
+        &meshimport->vertices[primitive->vertices_offset]
+    );
+    uint32_t *indices = &meshimport->indices[primitive->indices_offset];
+    uint32_t vertices_count = primitive->positions.count;
+
+    primitive->success = false;
+
+    for (uint32_t i = 0; i < vertices_count; i++) {
+        struct vertexformat_vertex *vertex = &vertices[i];
+        *vertex = (struct vertexformat_vertex){.color = {1.0f, 1.0f, 1.0f, 1.0f}};
+        meshimport_accessor_read(&primitive->positions, i, 3, vertex->position);
+        if (primitive->normals.data != nullptr) {
+            meshimport_accessor_read(&primitive->normals, i, 3, vertex->normal);
+        }
+        if (primitive->uvs.data != nullptr) {
+            meshimport_accessor_read(&primitive->uvs, i, 2, vertex->uv);
+        }
+        if (primitive->colors.data != nullptr) {
+            meshimport_accessor_read(&primitive->colors, i, 4, vertex->color);
+        }
+    }
+
+    for (uint32_t i = 0; i < primitive->indices_count; i++) {
+        uint32_t index = i;
+        if (primitive->indices.data != nullptr) {
+            const uint8_t *element = (
+                primitive->indices.data + primitive->indices.stride * i
+            );
+            switch (primitive->indices.component_type) {
+            case GLTF_UNSIGNED_BYTE:
+                index = element[0];
+                break;
+            case GLTF_UNSIGNED_SHORT: {
+                uint16_t value;
+                memcpy(&value, element, sizeof(value));
+                index = value;
+                break;
+            }
+            case GLTF_UNSIGNED_INT:
+                memcpy(&index, element, sizeof(index));
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (index >= vertices_count) {
+            fprintf(
+                stderr, "meshimport_primitive_job: index %u is out of bounds\n", index
+            );
+            return;
+        }
+        indices[i] = primitive->vertices_offset + index;
+    }
+
+    primitive->success = true;
+}
+
+/// @param[in] glb
+/// @param[in] object
+/// @param[in] key
+/// @param[out] accessor Left zeroed if `object` has no `key`
+/// @return `true` on success and `false` otherwise
+static bool meshimport_accessor_optional(
+    const struct meshimport_glb *glb,
+    uint32_t object,
+    const char *key,
+    struct meshimport_accessor *accessor
+) {
+    *accessor = (struct meshimport_accessor){};
+
+    uint64_t index = meshimport_json_uint(&glb->json, object, key, UINT64_MAX);
+    if (index == UINT64_MAX) {
+        return true;
+    }
+
+    return meshimport_accessor_get(glb, index, accessor);
+}
+
+/// @param[in,out] jobs
+/// @param[in] content
+/// @param[in] content_size
+/// @param[out] meshimport
+/// @return `true` on success and `false` otherwise
+static bool meshimport_glb_load(
+    struct jobs *jobs,
+    const uint8_t *content,
+    size_t content_size,
+    struct meshimport *meshimport
+) {
+    bool success = false;
+
+    struct meshimport_glb glb = {};
+    struct meshimport_primitive *primitives = nullptr;
+    size_t primitives_count = 0;
+    size_t primitives_capacity = 0;
+
+    // Header, then the JSON chunk and the optional binary chunk
+    uint32_t header[3];
+    uint32_t chunk[2];
+    if (content_size < sizeof(header) + sizeof(chunk)) {
+        fprintf(stderr, "meshimport_glb_load: file is truncated\n");
+        goto cleanup;
+    }
+    memcpy(header, content, sizeof(header));
+    memcpy(chunk, content + sizeof(header), sizeof(chunk));
+    size_t json_offset = sizeof(header) + sizeof(chunk);
+    if (
+        header[1] != 2 ||
+        chunk[1] != GLB_CHUNK_JSON ||
+        chunk[0] > content_size - json_offset
+    ) {
+        fprintf(stderr, "meshimport_glb_load: not a glTF 2.0 binary\n");
+        goto cleanup;
+    }
+
+    glb.json.text = (const char *) content + json_offset;
+    glb.json.text_size = chunk[0];
+
+    size_t bin_offset = json_offset + ((chunk[0] + 3) & ~3u);
+    if (bin_offset + sizeof(chunk) <= content_size) {
+        memcpy(chunk, content + bin_offset, sizeof(chunk));
+        bin_offset += sizeof(chunk);
+        if (chunk[1] == GLB_CHUNK_BIN && chunk[0] <= content_size - bin_offset) {
+            glb.bin = content + bin_offset;
+            glb.bin_size = chunk[0];
+        }
+    }
+
+    if (
+        !meshimport_json_value_parse(&glb.json, 0) ||
+        glb.json.tokens[0].type != MESHIMPORT_JSON_OBJECT
+    ) {
+        fprintf(stderr, "meshimport_glb_load: JSON chunk is malformed\n");
+        goto cleanup;
+    }
+
+    const struct meshimport_json *json = &glb.json;
+    uint32_t meshes = meshimport_json_member(json, 0, "meshes");
+    uint64_t vertices_count = 0;
+    uint64_t indices_count = 0;
+    for (uint32_t i = 0; ; i++) {
+        uint32_t mesh = meshimport_json_element(json, meshes, i);
+        if (mesh == UINT32_MAX) {
+            break;
+        }
+
+        uint32_t mesh_primitives = meshimport_json_member(json, mesh, "primitives");
+        for (uint32_t j = 0; ; j++) {
+            uint32_t object = meshimport_json_element(json, mesh_primitives, j);
+            if (object == UINT32_MAX) {
+                break;
+            }
+            if (meshimport_json_uint(json, object, "mode", 4) != GLTF_TRIANGLES) {
+                continue;
+            }
+
+            if (!meshimport_reserve(
+                (void **) &primitives,
+                sizeof(primitives[0]),
+                primitives_count,
+                &primitives_capacity
+            )) {
+                fprintf(stderr, "meshimport_glb_load: realloc failed\n");
+                goto cleanup;
+            }
+            struct meshimport_primitive *primitive = &primitives[primitives_count++];
+            *primitive = (struct meshimport_primitive){.meshimport = meshimport};
+
+            uint32_t attributes = meshimport_json_member(json, object, "attributes");
+            if (
+                meshimport_json_member(json, attributes, "POSITION") == UINT32_MAX ||
+                !meshimport_accessor_optional(
+                    &glb, attributes, "POSITION", &primitive->positions
+                ) ||
+                !meshimport_accessor_optional(
+                    &glb, attributes, "NORMAL", &primitive->normals
+                ) ||
+                !meshimport_accessor_optional(
+                    &glb, attributes, "TEXCOORD_0", &primitive->uvs
+                ) ||
+                !meshimport_accessor_optional(
+                    &glb, attributes, "COLOR_0", &primitive->colors
+                ) ||
+                !meshimport_accessor_optional(
+                    &glb, object, "indices", &primitive->indices
+                )
+            ) {
+                fprintf(
+                    stderr,
+                    "meshimport_glb_load: primitive %u of mesh %u is invalid\n",
+                    j,
+                    i
+                );
+                goto cleanup;
+            }
+
+            // Indices of any other type would be read as something they are
+            // not
+            uint32_t index_type = primitive->indices.component_type;
+            if (
+                primitive->indices.data != nullptr && (
+                    primitive->indices.components != 1 || (
+                        index_type != GLTF_UNSIGNED_BYTE &&
+                        index_type != GLTF_UNSIGNED_SHORT &&
+                        index_type != GLTF_UNSIGNED_INT
+                    )
+                )
+            ) {
+                fprintf(
+                    stderr, "meshimport_glb_load: indices are not unsigned scalars\n"
+                );
+                goto cleanup;
+            }
+
+            // Every attribute has as many elements as the positions
+            uint32_t count = primitive->positions.count;
+            const struct meshimport_accessor *attributes_accessors[] = {
+                &primitive->normals,
+                &primitive->uvs,
+                &primitive->colors,
+            };
+            bool attributes_valid = true;
+            for (size_t k = 0; k < 3; k++) {
+                const struct meshimport_accessor *accessor = attributes_accessors[k];
+                if (accessor->data != nullptr && accessor->count < count) {
+                    attributes_valid = false;
+                }
+            }
+            if (!attributes_valid) {
+                fprintf(stderr, "meshimport_glb_load: attributes are too short\n");
+                goto cleanup;
+            }
+
+            primitive->indices_count = count;
+            if (primitive->indices.data != nullptr) {
+                primitive->indices_count = primitive->indices.count;
+            }
+            primitive->indices_count -= primitive->indices_count % 3;
+            primitive->vertices_offset = (uint32_t) vertices_count;
+            primitive->indices_offset = (uint32_t) indices_count;
+
+            vertices_count += count;
+            indices_count += primitive->indices_count;
+            if (vertices_count > UINT32_MAX || indices_count > UINT32_MAX) {
+                fprintf(stderr, "meshimport_glb_load: mesh is too large\n");
+                goto cleanup;
+            }
+        }
+    }
+
+    if (indices_count == 0) {
+        fprintf(stderr, "meshimport_glb_load: no triangles found\n");
+        goto cleanup;
+    }
+
+    meshimport->vertices = malloc(sizeof(meshimport->vertices[0]) * vertices_count);
+    meshimport->indices = malloc(sizeof(meshimport->indices[0]) * indices_count);
+    if (meshimport->vertices == nullptr || meshimport->indices == nullptr) {
+        fprintf(stderr, "meshimport_glb_load: malloc failed\n");
+        goto cleanup;
+    }
+    meshimport->vertices_count = (uint32_t) vertices_count;
+    meshimport->indices_count = (uint32_t) indices_count;
+
+    struct jobs_counter decoded = {};
+    for (size_t i = 0; i < primitives_count; i++) {
+        if (!jobs_submit(jobs, meshimport_primitive_job, &primitives[i], &decoded)) {
+            fprintf(stderr, "meshimport_glb_load: jobs_submit failed\n");
+            meshimport_primitive_job(&primitives[i]);
+        }
+    }
+    jobs_counter_wait(jobs, &decoded);
+
+    for (size_t i = 0; i < primitives_count; i++) {
+        if (!primitives[i].success) {
+            fprintf(stderr, "meshimport_glb_load: meshimport_primitive_job failed\n");
+            goto cleanup;
+        }
+    }
+
+    success = true;
+
+cleanup:
+    free(primitives);
+    free(glb.json.tokens);
+
+    return success;
+}
+
+/// Gives vertices without a normal the average of the faces around them
+/// @param[in,out] meshimport
+/// @return `true` on success and `false` otherwise
+/// @note Flat normals, which glTF asks for, would keep every corner apart
+static bool meshimport_normals_generate(struct meshimport *meshimport) {
+    bool *missing = malloc(sizeof(missing[0]) * (meshimport->vertices_count + 1));
+    if (missing == nullptr) {
+        fprintf(stderr, "meshimport_normals_generate: malloc failed\n");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < meshimport->vertices_count; i++) {
+        const float *normal = meshimport->vertices[i].normal;
+        missing[i] = normal[0] == 0.0f && normal[1] == 0.0f && normal[2] == 0.0f;
+    }
+
+    // Area weighted, counter-clockwise faces are front faces in both formats
+    for (uint32_t i = 0; i + 2 < meshimport->indices_count; i += 3) {
+        struct vertexformat_vertex *corners[3];
+        for (size_t j = 0; j < 3; j++) {
+            corners[j] = &meshimport->vertices[meshimport->indices[i + j]];
+        }
+
+        float normal[3];
+        meshimport_face_normal(
+            corners[0]->position, corners[1]->position, corners[2]->position, normal
+        );
+        for (size_t j = 0; j < 3; j++) {
+            if (!missing[meshimport->indices[i + j]]) {
+                continue;
+            }
+            for (size_t k = 0; k < 3; k++) {
+                corners[j]->normal[k] += normal[k];
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < meshimport->vertices_count; i++) {
+        if (!missing[i]) {
+            continue;
+        }
+
+        float *normal = meshimport->vertices[i].normal;
+        float length = sqrtf(
+            normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]
+        );
+        for (size_t k = 0; k < 3; k++) {
+            normal[k] = length > 0.0f ? normal[k] / length : 0.0f;
+        }
+    }
+
+    free(missing);
+
+    return true;
+}
+
+bool meshimport_parse(
+    struct jobs *jobs,
+    const uint8_t *content,
+    size_t content_size,
+    struct meshimport *meshimport
+) {
+    *meshimport = (struct meshimport){};
+
+    bool success = false;
+
+    uint32_t magic = 0;
+    if (content_size >= sizeof(magic)) {
+        memcpy(&magic, content, sizeof(magic));
+    }
+
+    if (magic == GLB_MAGIC) {
+        if (!meshimport_glb_load(jobs, content, content_size, meshimport)) {
+            fprintf(stderr, "meshimport_parse: meshimport_glb_load failed\n");
+            goto cleanup;
+        }
+    } else if (!meshimport_obj_load(jobs, content, content_size, meshimport)) {
+        fprintf(stderr, "meshimport_parse: meshimport_obj_load failed\n");
+        goto cleanup;
+    }
+
+    if (!meshoptimize_deduplicate(
+        meshimport->vertices,
+        meshimport->vertices_count,
+        meshimport->indices,
+        meshimport->indices_count,
+        &meshimport->vertices_count
+    )) {
+        fprintf(stderr, "meshimport_parse: meshoptimize_deduplicate failed\n");
+        goto cleanup;
+    }
+
+    if (!meshimport_normals_generate(meshimport)) {
+        fprintf(stderr, "meshimport_parse: meshimport_normals_generate failed\n");
+        goto cleanup;
+    }
+
+    success = true;
+
+cleanup:
+    if (!success) {
+        meshimport_destroy(meshimport);
+    }
+
+    return success;
+}
+
+bool meshimport_load(
+    struct jobs *jobs, const char *filename, struct meshimport *meshimport
+) {
+    *meshimport = (struct meshimport){};
+
+    const uint8_t *content;
+    size_t content_size;
+    if (!file_map(filename, &content, &content_size)) {
+        fprintf(stderr, "meshimport_load: file_map failed\n");
+        return false;
+    }
+
+    bool success = meshimport_parse(jobs, content, content_size, meshimport);
+    if (!success) {
+        fprintf(stderr, "meshimport_load: meshimport_parse failed\n");
+    }
+
+    file_unmap(content, content_size);
+
+    return success;
+}
+
+bool meshimport_optimize(
+    struct meshimport *meshimport,
+    struct meshoptimize_stats *before,
+    struct meshoptimize_stats *after
+) {
+    if (!meshoptimize_analyze(
+        meshimport->indices,
+        meshimport->indices_count,
+        meshimport->vertices_count,
+        before
+    )) {
+        fprintf(stderr, "meshimport_optimize: meshoptimize_analyze(before) failed\n");
+        return false;
+    }
+
+    if (!meshoptimize_vertexcache(
+        meshimport->indices, meshimport->indices_count, meshimport->vertices_count
+    )) {
+        fprintf(stderr, "meshimport_optimize: meshoptimize_vertexcache failed\n");
+        return false;
+    }
+
+    if (!meshoptimize_overdraw(
+        meshimport->indices,
+        meshimport->indices_count,
+        meshimport->vertices,
+        meshimport->vertices_count
+    )) {
+        fprintf(stderr, "meshimport_optimize: meshoptimize_overdraw failed\n");
+        return false;
+    }
+
+    if (!meshoptimize_vertexfetch(
+        meshimport->vertices,
+        meshimport->vertices_count,
+        meshimport->indices,
+        meshimport->indices_count,
+        &meshimport->vertices_count
+    )) {
+        fprintf(stderr, "meshimport_optimize: meshoptimize_vertexfetch failed\n");
+        return false;
+    }
+
+    if (!meshoptimize_analyze(
+        meshimport->indices,
+        meshimport->indices_count,
+        meshimport->vertices_count,
+        after
+    )) {
+        fprintf(stderr, "meshimport_optimize: meshoptimize_analyze(after) failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+void meshimport_destroy(struct meshimport *meshimport) {
+    free(meshimport->indices);
+    free(meshimport->vertices);
+
+    *meshimport = (struct meshimport){};
+}
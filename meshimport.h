@@ -0,0 +1,66 @@
+#ifndef MESHIMPORT_H
+#define MESHIMPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "jobs.h"
+#include "meshoptimize.h"
+#include "vertexformat.h"
+
+/// Indexed triangle list as read from a mesh file
+struct meshimport {
+    struct vertexformat_vertex *vertices;
+    uint32_t vertices_count;
+
+    uint32_t *indices;
+    uint32_t indices_count;
+};
+
+/// @param[in,out] jobs Parses the content in parallel
+/// @param[in] content Wavefront OBJ, or binary glTF when it starts with the
+/// GLB magic
+/// @param[in] content_size
+/// @param[out] meshimport
+/// @return `true` on success and `false` otherwise
+/// @note Same as `meshimport_load`, for files that were read already
+/// @note Caller is responsible to call `meshimport_destroy` after successful
+/// return
+bool meshimport_parse(
+    struct jobs *jobs,
+    const uint8_t *content,
+    size_t content_size,
+    struct meshimport *meshimport
+);
+
+/// @param[in,out] jobs Parses the file in parallel
+/// @param[in] filename Wavefront OBJ, or binary glTF when the file starts with
+/// the GLB magic
+/// @param[out] meshimport
+/// @return `true` on success and `false` otherwise
+/// @note Vertices are deduplicated but otherwise left in file order. Of glTF
+/// files every triangle primitive of every mesh is imported, without node
+/// transforms or materials.
+/// @note Caller is responsible to call `meshimport_destroy` after successful
+/// return
+bool meshimport_load(
+    struct jobs *jobs, const char *filename, struct meshimport *meshimport
+);
+
+/// Reorders triangles for the post-transform cache and overdraw, then
+/// vertices for fetch locality
+/// @param[in,out] meshimport
+/// @param[out] before Cache efficiency in file order
+/// @param[out] after Cache efficiency once optimized
+/// @return `true` on success and `false` otherwise
+bool meshimport_optimize(
+    struct meshimport *meshimport,
+    struct meshoptimize_stats *before,
+    struct meshoptimize_stats *after
+);
+
+/// @param[in,out] meshimport
+/// @note `meshimport` will be invalid after this function has been called
+void meshimport_destroy(struct meshimport *meshimport);
+
+#endif
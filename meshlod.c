@@ -0,0 +1,648 @@
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+#include "meshlod.h"
+#include "meshoptimize.h"
+
+/// Levels are built while simplifying removes at least this fraction of the
+/// triangles of the level before
+constexpr float MESHLOD_MIN_REDUCTION = 0.2f;
+/// Levels with fewer triangles are not simplified any further
+constexpr uint32_t MESHLOD_MIN_TRIANGLES = 32;
+
+/// Sum of the squared distances to the planes of triangles, each weighted by
+/// the area of its triangle, as `p^T a p + 2 b^T p + c` with the symmetric
+/// matrix `a` stored as xx, xy, xz, yy, yz and zz
+struct garland_quadric {
+    double a[6];
+    double b[3];
+    double c;
+    /// Sum of the areas, so that errors are averaged over the planes
+    double weight;
+};
+
+/// Moving vertex `from` onto vertex `to`
+struct garland_collapse {
+    float cost;
+    uint32_t from;
+    uint32_t to;
+};
+
+/// @param[in,out] quadric
+/// @param[in] other Added to `quadric`
+static void garland_quadric_add(
+    struct garland_quadric *quadric, const struct garland_quadric *other
+) {
+    for (size_t i = 0; i < 6; i++) {
+        quadric->a[i] += other->a[i];
+    }
+    for (size_t i = 0; i < 3; i++) {
+        quadric->b[i] += other->b[i];
+    }
+    quadric->c += other->c;
+    quadric->weight += other->weight;
+}
+
+/// @param[in] p0
+/// @param[in] p1
+/// @param[in] p2
+/// @param[out] quadric Of the plane of the triangle, zero when it has no area
+static void garland_quadric_triangle(
+    const float p0[3],
+    const float p1[3],
+    const float p2[3],
+    struct garland_quadric *quadric
+) {
+    *quadric = (struct garland_quadric){};
+
+    double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    double n[3] = {
+        e1[1] * e2[2] - e1[2] * e2[1],
+        e1[2] * e2[0] - e1[0] * e2[2],
+        e1[0] * e2[1] - e1[1] * e2[0],
+    };
+    double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length == 0.0) {
+        return;
+    }
+    for (size_t i = 0; i < 3; i++) {
+        n[i] /= length;
+    }
+    double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+    double area = 0.5 * length;
+
+    quadric->a[0] = area * n[0] * n[0];
+    quadric->a[1] = area * n[0] * n[1];
+    quadric->a[2] = area * n[0] * n[2];
+    quadric->a[3] = area * n[1] * n[1];
+    quadric->a[4] = area * n[1] * n[2];
+    quadric->a[5] = area * n[2] * n[2];
+    for (size_t i = 0; i < 3; i++) {
+        quadric->b[i] = area * n[i] * d;
+    }
+    quadric->c = area * d * d;
+    quadric->weight = area;
+}
+
+/// @param[in] quadric
+/// @param[in] p
+/// @return Mean squared distance of `p` to the planes of `quadric`
+static float garland_quadric_error(
+    const struct garland_quadric *quadric, const float p[3]
+) {
+    if (quadric->weight == 0.0) {
+        return 0.0f;
+    }
+
+    double x = p[0];
+    double y = p[1];
+    double z = p[2];
+    const double *a = quadric->a;
+    double error = (
+        a[0] * x * x + a[3] * y * y + a[5] * z * z +
+        2.0 * (a[1] * x * y + a[2] * x * z + a[4] * y * z) +
+        2.0 * (quadric->b[0] * x + quadric->b[1] * y + quadric->b[2] * z) +
+        quadric->c
+    );
+
+    return (float) (fmax(error, 0.0) / quadric->weight);
+}
+
+/// @param[in] p0
+/// @param[in] p1
+/// @param[in] p2
+/// @param[out] normal Not normalized
+static void garland_normal(
+    const float p0[3], const float p1[3], const float p2[3], float normal[3]
+) {
+    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+/// @param[in] a
+/// @param[in] b
+/// @return Order of ascending cost
+static int garland_collapse_compare(const void *a, const void *b) {
+    const struct garland_collapse *collapse_a = a;
+    const struct garland_collapse *collapse_b = b;
+    if (collapse_a->cost != collapse_b->cost) {
+        return collapse_a->cost < collapse_b->cost ? -1 : 1;
+    }
+    return (collapse_a->from > collapse_b->from) - (collapse_a->from < collapse_b->from);
+}
+
+/// Finds the vertices that must not move, those that share their position
+/// with another vertex and those on an edge only one triangle has
+/// @param[in] vertices
+/// @param[in] vertices_count
+/// @param[in] indices
+/// @param[in] indices_count
+/// @param[out] locked `vertices_count` entries
+/// @return `true` on success and `false` otherwise
+static bool garland_lock(
+    const struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    const uint32_t *indices,
+    size_t indices_count,
+    bool *locked
+) {
+    bool success = false;
+
+    // Open addressing at a load factor of at most one half, once for the
+    // positions and once for the directed edges between them
+    size_t positions_size = 1;
+    while (positions_size < (size_t) vertices_count * 2) {
+        positions_size *= 2;
+    }
+    size_t edges_size = 1;
+    while (edges_size < indices_count * 2) {
+        edges_size *= 2;
+    }
+
+    uint32_t *positions = malloc(sizeof(positions[0]) * positions_size);
+    uint32_t *weld = malloc(sizeof(weld[0]) * vertices_count);
+    uint64_t *edges = malloc(sizeof(edges[0]) * edges_size);
+    if (positions == nullptr || weld == nullptr || edges == nullptr) {
+        fprintf(stderr, "garland_lock: malloc failed\n");
+        goto cleanup;
+    }
+    memset(positions, 0xff, sizeof(positions[0]) * positions_size);
+    memset(edges, 0xff, sizeof(edges[0]) * edges_size);
+    memset(locked, 0, sizeof(locked[0]) * vertices_count);
+
+    // Each vertex is welded to the first vertex at its position, which is
+    // locked along with it when there are several
+    for (uint32_t i = 0; i < vertices_count; i++) {
+        const float *position = vertices[i].position;
+        uint64_t hash = hash_bytes(position, sizeof(vertices[i].position), HASH_SEED);
+        size_t slot = hash & (positions_size - 1);
+        while (
+            positions[slot] != UINT32_MAX &&
+            memcmp(
+                vertices[positions[slot]].position,
+                position,
+                sizeof(vertices[i].position)
+            ) != 0
+        ) {
+            slot = (slot + 1) & (positions_size - 1);
+        }
+
+        if (positions[slot] == UINT32_MAX) {
+            positions[slot] = i;
+        } else {
+            locked[positions[slot]] = true;
+        }
+        weld[i] = positions[slot];
+    }
+
+    for (size_t i = 0; i + 2 < indices_count; i += 3) {
+        for (size_t j = 0; j < 3; j++) {
+            uint64_t key = (uint64_t) weld[indices[i + j]] << 32 |
+                weld[indices[i + (j + 1) % 3]];
+            size_t slot = hash_bytes(&key, sizeof(key), HASH_SEED) & (edges_size - 1);
+            while (edges[slot] != UINT64_MAX && edges[slot] != key) {
+                slot = (slot + 1) & (edges_size - 1);
+            }
+            edges[slot] = key;
+        }
+    }
+
+    // An edge no triangle runs along the other way is on a border
+    for (size_t i = 0; i < edges_size; i++) {
+        if (edges[i] == UINT64_MAX) {
+            continue;
+        }
+        uint32_t first = (uint32_t) (edges[i] >> 32);
+        uint32_t second = (uint32_t) edges[i];
+        uint64_t key = (uint64_t) second << 32 | first;
+        size_t slot = hash_bytes(&key, sizeof(key), HASH_SEED) & (edges_size - 1);
+        while (edges[slot] != UINT64_MAX && edges[slot] != key) {
+            slot = (slot + 1) & (edges_size - 1);
+        }
+        if (edges[slot] == UINT64_MAX) {
+            locked[first] = true;
+            locked[second] = true;
+        }
+    }
+
+    for (uint32_t i = 0; i < vertices_count; i++) {
+        locked[i] = locked[weld[i]];
+    }
+
+    success = true;
+
+cleanup:
+    free(edges);
+    free(weld);
+    free(positions);
+
+    return success;
+}
+
+bool meshlod_simplify(
+    const struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    uint32_t *indices,
+    size_t indices_count,
+    size_t target_count,
+    size_t *simplified_count,
+    float *error
+) {
+    *simplified_count = indices_count;
+    *error = 0.0f;
+    if (indices_count <= target_count) {
+        return true;
+    }
+
+    bool success = false;
+
+    struct garland_quadric *quadrics = calloc(vertices_count, sizeof(quadrics[0]));
+    bool *locked = malloc(sizeof(locked[0]) * vertices_count);
+    bool *touched = malloc(sizeof(touched[0]) * vertices_count);
+    uint32_t *remap = malloc(sizeof(remap[0]) * vertices_count);
+    uint32_t *offsets = malloc(sizeof(offsets[0]) * ((size_t) vertices_count + 1));
+    uint32_t *adjacency = malloc(sizeof(adjacency[0]) * indices_count);
+    struct garland_collapse *collapses = malloc(sizeof(collapses[0]) * vertices_count);
+    if (
+        quadrics == nullptr ||
+        locked == nullptr ||
+        touched == nullptr ||
+        remap == nullptr ||
+        offsets == nullptr ||
+        adjacency == nullptr ||
+        collapses == nullptr
+    ) {
+        fprintf(stderr, "meshlod_simplify: malloc failed\n");
+        goto cleanup;
+    }
+
+    if (!garland_lock(vertices, vertices_count, indices, indices_count, locked)) {
+        fprintf(stderr, "meshlod_simplify: garland_lock failed\n");
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i + 2 < indices_count; i += 3) {
+        struct garland_quadric quadric;
+        garland_quadric_triangle(
+            vertices[indices[i]].position,
+            vertices[indices[i + 1]].position,
+            vertices[indices[i + 2]].position,
+            &quadric
+        );
+        for (size_t j = 0; j < 3; j++) {
+            garland_quadric_add(&quadrics[indices[i + j]], &quadric);
+        }
+    }
+
+    // Each pass collapses the cheapest edges whose vertices no other collapse
+    // of the pass touched, so that every triangle changes at most once per
+    // corner and the flip test sees where its corners went
+    size_t count = indices_count - indices_count % 3;
+    float max_cost = 0.0f;
+    while (count > target_count) {
+        memset(offsets, 0, sizeof(offsets[0]) * ((size_t) vertices_count + 1));
+        for (size_t i = 0; i < count; i++) {
+            offsets[indices[i] + 1]++;
+        }
+        for (uint32_t i = 0; i < vertices_count; i++) {
+            offsets[i + 1] += offsets[i];
+        }
+        for (size_t i = 0; i < count; i++) {
+            adjacency[offsets[indices[i]]++] = (uint32_t) (i / 3);
+        }
+        for (uint32_t i = vertices_count; i > 0; i--) {
+            offsets[i] = offsets[i - 1];
+        }
+        offsets[0] = 0;
+
+        // Every edge between two triangles is seen once each way, and each
+        // vertex that can move keeps its cheapest edge
+        for (uint32_t i = 0; i < vertices_count; i++) {
+            collapses[i] = (struct garland_collapse){
+                .cost = FLT_MAX,
+                .from = i,
+                .to = i,
+            };
+        }
+        for (size_t i = 0; i < count; i++) {
+            uint32_t from = indices[i];
+            uint32_t to = indices[i - i % 3 + (i % 3 + 1) % 3];
+            if (locked[from] || from == to) {
+                continue;
+            }
+            float cost = garland_quadric_error(&quadrics[from], vertices[to].position);
+            if (cost < collapses[from].cost) {
+                collapses[from].cost = cost;
+                collapses[from].to = to;
+            }
+        }
+        size_t collapses_count = 0;
+        for (uint32_t i = 0; i < vertices_count; i++) {
+            if (collapses[i].to != i) {
+                collapses[collapses_count++] = collapses[i];
+            }
+        }
+        if (collapses_count == 0) {
+            break;
+        }
+        qsort(
+            collapses, collapses_count, sizeof(collapses[0]), garland_collapse_compare
+        );
+
+        for (uint32_t i = 0; i < vertices_count; i++) {
+            remap[i] = i;
+            touched[i] = false;
+        }
+
+        size_t triangles_count = count / 3;
+        size_t removed = 0;
+        size_t accepted = 0;
+        for (size_t i = 0; i < collapses_count; i++) {
+            if (triangles_count - removed <= target_count / 3) {
+                break;
+            }
+
+            const struct garland_collapse *collapse = &collapses[i];
+            uint32_t from = collapse->from;
+            uint32_t to = collapse->to;
+            if (touched[from] || touched[to]) {
+                continue;
+            }
+
+            // Triangles around `from` that keep their area must keep facing
+            // the same way
+            size_t degenerate = 0;
+            bool flips = false;
+            for (uint32_t j = offsets[from]; j < offsets[from + 1] && !flips; j++) {
+                const uint32_t *triangle = &indices[(size_t) adjacency[j] * 3];
+                uint32_t corners[3] = {
+                    remap[triangle[0]], remap[triangle[1]], remap[triangle[2]],
+                };
+                if (corners[0] == to || corners[1] == to || corners[2] == to) {
+                    degenerate++;
+                    continue;
+                }
+                if (
+                    corners[0] == corners[1] ||
+                    corners[1] == corners[2] ||
+                    corners[2] == corners[0]
+                ) {
+                    continue;
+                }
+
+                float before[3];
+                garland_normal(
+                    vertices[corners[0]].position,
+                    vertices[corners[1]].position,
+                    vertices[corners[2]].position,
+                    before
+                );
+                for (size_t k = 0; k < 3; k++) {
+                    if (corners[k] == from) {
+                        corners[k] = to;
+                    }
+                }
+                float after[3];
+                garland_normal(
+                    vertices[corners[0]].position,
+                    vertices[corners[1]].position,
+                    vertices[corners[2]].position,
+                    after
+                );
+                flips = (
+                    before[0] * after[0] + before[1] * after[1] + before[2] * after[2]
+                ) <= 0.0f;
+            }
+            if (flips) {
+                continue;
+            }
+
+            remap[from] = to;
+            touched[from] = true;
+            touched[to] = true;
+            garland_quadric_add(&quadrics[to], &quadrics[from]);
+            max_cost = fmaxf(max_cost, collapse->cost);
+            removed += degenerate;
+            accepted++;
+        }
+        if (accepted == 0) {
+            break;
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i += 3) {
+            uint32_t a = remap[indices[i]];
+            uint32_t b = remap[indices[i + 1]];
+            uint32_t c = remap[indices[i + 2]];
+            if (a == b || b == c || c == a) {
+                continue;
+            }
+            indices[kept++] = a;
+            indices[kept++] = b;
+            indices[kept++] = c;
+        }
+        count = kept;
+    }
+
+    *simplified_count = count;
+    *error = sqrtf(max_cost);
+
+    success = true;
+
+cleanup:
+    free(collapses);
+    free(adjacency);
+    free(offsets);
+    free(remap);
+    free(touched);
+    free(locked);
+    free(quadrics);
+
+    return success;
+}
+
+bool meshlod_create(
+    const struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    uint32_t **indices,
+    uint32_t *indices_count,
+    struct meshlod *meshlod
+) {
+    *meshlod = (struct meshlod){
+        .levels = {
+            {.first_index = 0, .indices_count = *indices_count, .error = 0.0f},
+        },
+        .levels_count = 1,
+    };
+
+    float min[3] = {INFINITY, INFINITY, INFINITY};
+    float max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (uint32_t i = 0; i < vertices_count; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            min[j] = fminf(min[j], vertices[i].position[j]);
+            max[j] = fmaxf(max[j], vertices[i].position[j]);
+        }
+    }
+    for (uint32_t i = 0; i < vertices_count; i++) {
+        float distance = 0.0f;
+        for (size_t j = 0; j < 3; j++) {
+            float offset = vertices[i].position[j] - 0.5f * (min[j] + max[j]);
+            distance += offset * offset;
+        }
+        meshlod->radius = fmaxf(meshlod->radius, sqrtf(distance));
+    }
+
+    if (*indices_count / 3 < MESHLOD_MIN_TRIANGLES) {
+        return true;
+    }
+
+    // Each level is simplified from a copy of the one before, since appending
+    // it may move the indices
+    uint32_t *level = malloc(sizeof(level[0]) * *indices_count);
+    if (level == nullptr) {
+        fprintf(stderr, "meshlod_create: malloc failed\n");
+        return false;
+    }
+
+    bool success = false;
+
+    while (meshlod->levels_count < MESHLOD_MAX_LEVELS) {
+        const struct meshlod_level *previous = &meshlod->levels[
+            meshlod->levels_count - 1
+        ];
+        if (previous->indices_count / 3 < MESHLOD_MIN_TRIANGLES) {
+            break;
+        }
+
+        memcpy(
+            level,
+            *indices + previous->first_index,
+            sizeof(level[0]) * previous->indices_count
+        );
+        size_t count;
+        float error;
+        if (!meshlod_simplify(
+            vertices,
+            vertices_count,
+            level,
+            previous->indices_count,
+            previous->indices_count / 6 * 3,
+            &count,
+            &error
+        )) {
+            fprintf(stderr, "meshlod_create: meshlod_simplify failed\n");
+            goto cleanup;
+        }
+        if (
+            (float) count >
+            (1.0f - MESHLOD_MIN_REDUCTION) * (float) previous->indices_count
+        ) {
+            break;
+        }
+
+        if (!meshoptimize_vertexcache(level, count, vertices_count)) {
+            fprintf(stderr, "meshlod_create: meshoptimize_vertexcache failed\n");
+            goto cleanup;
+        }
+
+        uint32_t *grown = realloc(
+            *indices, sizeof(grown[0]) * (*indices_count + count)
+        );
+        if (grown == nullptr) {
+            fprintf(stderr, "meshlod_create: realloc failed\n");
+            goto cleanup;
+        }
+        *indices = grown;
+        memcpy(*indices + *indices_count, level, sizeof(level[0]) * count);
+
+        // Each level is simplified from the one before, so the distances to
+        // the first level add up
+        meshlod->levels[meshlod->levels_count] = (struct meshlod_level){
+            .first_index = *indices_count,
+            .indices_count = (uint32_t) count,
+            .error = previous->error + error,
+        };
+        meshlod->levels_count++;
+        *indices_count += (uint32_t) count;
+    }
+
+    success = true;
+
+cleanup:
+    free(level);
+
+    return success;
+}
+
+size_t meshlod_select(
+    const struct meshlod *meshlod,
+    float pixels_per_unit,
+    float threshold,
+    float hysteresis,
+    size_t previous
+) {
+    // Errors grow with each level, so the last level under a threshold is the
+    // coarsest one
+    size_t ideal = 0;
+    size_t relaxed = 0;
+    for (size_t i = 1; i < meshlod->levels_count; i++) {
+        float pixels = meshlod->levels[i].error * pixels_per_unit;
+        if (pixels <= threshold) {
+            ideal = i;
+        }
+        if (pixels <= threshold * hysteresis) {
+            relaxed = i;
+        }
+    }
+
+    // Finer levels are picked at once, the previous level is kept while it is
+    // under the threshold
+    if (ideal <= previous) {
+        return ideal;
+    }
+    return relaxed > previous ? relaxed : previous;
+}
+
+uint64_t meshlod_select_objects(
+    const struct meshlod *meshlod,
+    const struct cull_objects *objects,
+    const uint32_t *visible,
+    size_t visible_count,
+    const float eye[3],
+    float scale,
+    float threshold,
+    float hysteresis,
+    uint8_t *levels
+) {
+    float radius = meshlod->radius > 0.0f ? meshlod->radius : 1.0f;
+
+    uint64_t triangles = 0;
+    for (size_t i = 0; i < visible_count; i++) {
+        uint32_t index = visible[i];
+        float dx = objects->center_x[index] - eye[0];
+        float dy = objects->center_y[index] - eye[1];
+        float dz = objects->center_z[index] - eye[2];
+        float distance = sqrtf(dx * dx + dy * dy + dz * dz) - objects->radius[index];
+
+        // Measured to the nearest point of the sphere, inside of which every
+        // error is too large
+        float pixels_per_unit = distance > 0.0f
+            ? scale * objects->radius[index] / (radius * distance)
+            : FLT_MAX;
+        size_t level = meshlod_select(
+            meshlod, pixels_per_unit, threshold, hysteresis, levels[index]
+        );
+        levels[index] = (uint8_t) level;
+        triangles += meshlod->levels[level].indices_count / 3;
+    }
+
+    return triangles;
+}
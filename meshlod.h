@@ -0,0 +1,127 @@
+#ifndef MESHLOD_H
+#define MESHLOD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cull.h"
+#include "vertexformat.h"
+
+/// Levels of detail of a mesh at most, the first one is the mesh itself
+constexpr size_t MESHLOD_MAX_LEVELS = 8;
+/// Fraction of the error threshold a coarser level has to be under before it
+/// replaces the level drawn the frame before
+constexpr float MESHLOD_HYSTERESIS = 0.75f;
+
+/// Triangles of one level of detail, a range of the shared index buffer
+struct meshlod_level {
+    uint32_t first_index;
+    uint32_t indices_count;
+    /// Distance the level may be from the surface of the first level, in
+    /// the units of the positions
+    float error;
+};
+
+/// Chain of levels of detail sharing the vertices of a mesh, each level about
+/// half the triangles of the one before
+struct meshlod {
+    struct meshlod_level levels[MESHLOD_MAX_LEVELS];
+    size_t levels_count;
+    /// Of the sphere around the center of the bounds of the positions
+    float radius;
+};
+
+/// Collapses edges in the order of the quadric error metric of Garland and
+/// Heckbert, moving one vertex of each edge onto the other. Vertices on open
+/// borders and on seams, where vertices share a position but differ
+/// otherwise, are never moved, so the outline and the attributes along seams
+/// are kept.
+/// @param[in] vertices
+/// @param[in] vertices_count
+/// @param[in,out] indices Triangle list, replaced by the simplified triangles
+/// @param[in] indices_count
+/// @param[in] target_count Indices to stop at or below, fewer may be left
+/// than that when many triangles collapse at once
+/// @param[out] simplified_count Indices left in `indices`
+/// @param[out] error Largest distance a collapse moved the surface by, as the
+/// root mean square over the planes it moved away from, in the units of the
+/// positions
+/// @return `true` on success and `false` otherwise
+/// @note Stops early once no edge can collapse without flipping a triangle
+bool meshlod_simplify(
+    const struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    uint32_t *indices,
+    size_t indices_count,
+    size_t target_count,
+    size_t *simplified_count,
+    float *error
+);
+
+/// Builds the chain of levels of a mesh, simplifying each level from the one
+/// before and reordering its triangles for the post-transform cache
+/// @param[in] vertices
+/// @param[in] vertices_count
+/// @param[in,out] indices Triangle list of the first level, allocated with
+/// `malloc`, reallocated with the indices of the other levels appended
+/// @param[in,out] indices_count
+/// @param[out] meshlod
+/// @return `true` on success and `false` otherwise
+/// @note Levels stop once simplifying no longer removes a fifth of the
+/// triangles
+bool meshlod_create(
+    const struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    uint32_t **indices,
+    uint32_t *indices_count,
+    struct meshlod *meshlod
+);
+
+/// Picks the coarsest level whose error projects to at most `threshold`
+/// pixels. Levels coarser than `previous` are only picked once their error is
+/// under `threshold * hysteresis`, so that a mesh near the switching distance
+/// does not pop back and forth.
+/// @param[in] meshlod
+/// @param[in] pixels_per_unit Pixels a unit of the positions covers at the
+/// mesh
+/// @param[in] threshold Error in pixels
+/// @param[in] hysteresis Between zero and one, e.g. `MESHLOD_HYSTERESIS`, one
+/// switches at `threshold` both ways
+/// @param[in] previous Level picked the frame before
+/// @return Level to draw
+size_t meshlod_select(
+    const struct meshlod *meshlod,
+    float pixels_per_unit,
+    float threshold,
+    float hysteresis,
+    size_t previous
+);
+
+/// Picks the level of each visible object, as the culling pass leaves them.
+/// Every object draws the mesh scaled so that the sphere around it is the
+/// sphere of the object.
+/// @param[in] meshlod
+/// @param[in] objects
+/// @param[in] visible Indices into `objects`
+/// @param[in] visible_count
+/// @param[in] eye Position of the camera
+/// @param[in] scale Pixels a unit covers at a distance of one, the height of
+/// the viewport over twice the tangent of half the vertical field of view
+/// @param[in] threshold Error in pixels
+/// @param[in] hysteresis As for `meshlod_select`
+/// @param[in,out] levels `objects->capacity` entries, the level of each
+/// object, read as the level the frame before and written for the visible ones
+/// @return Triangles the visible objects draw at their levels
+uint64_t meshlod_select_objects(
+    const struct meshlod *meshlod,
+    const struct cull_objects *objects,
+    const uint32_t *visible,
+    size_t visible_count,
+    const float eye[3],
+    float scale,
+    float threshold,
+    float hysteresis,
+    uint8_t *levels
+);
+
+#endif
@@ -0,0 +1,566 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+#include "meshoptimize.h"
+
+bool meshoptimize_deduplicate(
+    struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    uint32_t *indices,
+    size_t indices_count,
+    uint32_t *unique_count
+) {
+    if (vertices_count == 0) {
+        *unique_count = 0;
+        return true;
+    }
+
+    // Open addressing at a load factor of at most one half
+    size_t table_size = 1;
+    while (table_size < (size_t) vertices_count * 2) {
+        table_size *= 2;
+    }
+
+    uint32_t *table = malloc(sizeof(table[0]) * table_size);
+    uint32_t *remap = malloc(sizeof(remap[0]) * vertices_count);
+    if (table == nullptr || remap == nullptr) {
+        fprintf(stderr, "meshoptimize_deduplicate: malloc failed\n");
+        free(remap);
+        free(table);
+        return false;
+    }
+    memset(table, 0xff, sizeof(table[0]) * table_size);
+
+    // The table refers to compacted vertices, which are never overwritten
+    // since a vertex is only ever moved to a lower index
+    uint32_t unique = 0;
+    for (uint32_t i = 0; i < vertices_count; i++) {
+        uint64_t hash = hash_bytes(&vertices[i], sizeof(vertices[i]), HASH_SEED);
+        size_t slot = hash & (table_size - 1);
+        while (
+            table[slot] != UINT32_MAX &&
+            memcmp(&vertices[table[slot]], &vertices[i], sizeof(vertices[i])) != 0
+        ) {
+            slot = (slot + 1) & (table_size - 1);
+        }
+
+        if (table[slot] == UINT32_MAX) {
+            vertices[unique] = vertices[i];
+            table[slot] = unique;
+            unique++;
+        }
+        remap[i] = table[slot];
+    }
+
+    for (size_t i = 0; i < indices_count; i++) {
+        indices[i] = remap[indices[i]];
+    }
+
+    *unique_count = unique;
+
+    free(remap);
+    free(table);
+
+    return true;
+}
+
+constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+constexpr uint32_t FORSYTH_VALENCE_SCORES = 64;
+
+/// Per vertex state of `meshoptimize_vertexcache`
+struct forsyth_vertex {
+    /// Range of `forsyth::adjacency`, the first `remaining` entries are the
+    /// triangles not emitted yet
+    uint32_t adjacency_offset;
+    uint32_t remaining;
+    /// Position in the simulated cache, `-1` when not cached
+    int32_t cache_position;
+    float score;
+};
+
+struct forsyth {
+    struct forsyth_vertex *vertices;
+    uint32_t *adjacency;
+    float *triangle_scores;
+    bool *emitted;
+
+    float cache_scores[FORSYTH_CACHE_SIZE];
+    float valence_scores[FORSYTH_VALENCE_SCORES];
+};
+
+/// @param[in] forsyth
+/// @param[in] vertex
+/// @return Score from the position of `vertex` in the cache, and a boost for
+/// few remaining triangles so that no lonely triangles are left behind
+static float forsyth_vertex_score(
+    const struct forsyth *forsyth, const struct forsyth_vertex *vertex
+) {
+    if (vertex->remaining == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (vertex->cache_position >= 0) {
+        score = forsyth->cache_scores[vertex->cache_position];
+    }
+
+    if (vertex->remaining < FORSYTH_VALENCE_SCORES) {
+        score += forsyth->valence_scores[vertex->remaining];
+    } else {
+        score += 2.0f / sqrtf((float) vertex->remaining);
+    }
+
+    return score;
+}
+
+/// @param[in,out] forsyth
+/// @param[in] indices
+/// @param[in] triangle
+static void forsyth_triangle_score(
+    struct forsyth *forsyth, const uint32_t *indices, uint32_t triangle
+) {
+    const uint32_t *corners = &indices[triangle * 3];
+    forsyth->triangle_scores[triangle] = (
+        forsyth->vertices[corners[0]].score +
+        forsyth->vertices[corners[1]].score +
+        forsyth->vertices[corners[2]].score
+    );
+}
+
+bool meshoptimize_vertexcache(
+    uint32_t *indices, size_t indices_count, uint32_t vertices_count
+) {
+    uint32_t triangles_count = (uint32_t) (indices_count / 3);
+    if (triangles_count == 0) {
+        return true;
+    }
+
+    bool success = false;
+    // Three more entries than the cache holds for the vertices pushed out by
+    // each emitted triangle
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    struct forsyth forsyth = {
+        .vertices = calloc(vertices_count, sizeof(forsyth.vertices[0])),
+        .adjacency = malloc(sizeof(forsyth.adjacency[0]) * triangles_count * 3),
+        .triangle_scores = malloc(sizeof(forsyth.triangle_scores[0]) * triangles_count),
+        .emitted = calloc(triangles_count, sizeof(forsyth.emitted[0])),
+    };
+    uint32_t *output = malloc(sizeof(output[0]) * triangles_count * 3);
+    if (
+        forsyth.vertices == nullptr ||
+        forsyth.adjacency == nullptr ||
+        forsyth.triangle_scores == nullptr ||
+        forsyth.emitted == nullptr ||
+        output == nullptr
+    ) {
+        fprintf(stderr, "meshoptimize_vertexcache: malloc failed\n");
+        goto cleanup;
+    }
+
+    // The vertices of the last triangle get a fixed lower score, so that the
+    // next triangle does not just reuse the edge of the last one and leave
+    // long strips behind
+    for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; i++) {
+        if (i < 3) {
+            forsyth.cache_scores[i] = 0.75f;
+        } else {
+            float scaler = 1.0f / (float) (FORSYTH_CACHE_SIZE - 3);
+            forsyth.cache_scores[i] = powf(1.0f - (float) (i - 3) * scaler, 1.5f);
+        }
+    }
+    for (uint32_t i = 1; i < FORSYTH_VALENCE_SCORES; i++) {
+        forsyth.valence_scores[i] = 2.0f / sqrtf((float) i);
+    }
+
+    for (size_t i = 0; i < (size_t) triangles_count * 3; i++) {
+        forsyth.vertices[indices[i]].remaining++;
+    }
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < vertices_count; i++) {
+        forsyth.vertices[i].adjacency_offset = offset;
+        offset += forsyth.vertices[i].remaining;
+        forsyth.vertices[i].remaining = 0;
+        forsyth.vertices[i].cache_position = -1;
+    }
+    for (uint32_t i = 0; i < triangles_count; i++) {
+        for (uint32_t j = 0; j < 3; j++) {
+            struct forsyth_vertex *vertex = &forsyth.vertices[indices[i * 3 + j]];
+            forsyth.adjacency[vertex->adjacency_offset + vertex->remaining] = i;
+            vertex->remaining++;
+        }
+    }
+    for (uint32_t i = 0; i < vertices_count; i++) {
+        forsyth.vertices[i].score = forsyth_vertex_score(&forsyth, &forsyth.vertices[i]);
+    }
+
+    uint32_t best = UINT32_MAX;
+    float best_score = -1.0f;
+    for (uint32_t i = 0; i < triangles_count; i++) {
+        forsyth_triangle_score(&forsyth, indices, i);
+        if (forsyth.triangle_scores[i] > best_score) {
+            best = i;
+            best_score = forsyth.triangle_scores[i];
+        }
+    }
+
+    uint32_t cache_count = 0;
+    uint32_t cursor = 0;
+
+    for (uint32_t emitted = 0; emitted < triangles_count; emitted++) {
+        // Nothing in the cache has triangles left, continue anywhere
+        if (best == UINT32_MAX) {
+            while (forsyth.emitted[cursor]) {
+                cursor++;
+            }
+            best = cursor;
+        }
+
+        const uint32_t *corners = &indices[best * 3];
+        memcpy(&output[emitted * 3], corners, sizeof(corners[0]) * 3);
+        forsyth.emitted[best] = true;
+
+        uint32_t new_cache[FORSYTH_CACHE_SIZE + 3];
+        uint32_t new_cache_count = 0;
+        for (uint32_t j = 0; j < 3; j++) {
+            struct forsyth_vertex *vertex = &forsyth.vertices[corners[j]];
+
+            uint32_t *adjacency = &forsyth.adjacency[vertex->adjacency_offset];
+            for (uint32_t k = 0; k < vertex->remaining; k++) {
+                if (adjacency[k] == best) {
+                    adjacency[k] = adjacency[vertex->remaining - 1];
+                    break;
+                }
+            }
+            vertex->remaining--;
+
+            // Degenerate triangles name a vertex more than once
+            if (j == 0 || corners[j] != corners[0]) {
+                if (j < 2 || corners[j] != corners[1]) {
+                    new_cache[new_cache_count++] = corners[j];
+                }
+            }
+        }
+        for (uint32_t j = 0; j < cache_count; j++) {
+            uint32_t cached = cache[j];
+            if (cached != corners[0] && cached != corners[1] && cached != corners[2]) {
+                new_cache[new_cache_count++] = cached;
+            }
+        }
+
+        memcpy(cache, new_cache, sizeof(cache[0]) * new_cache_count);
+        cache_count = new_cache_count;
+        if (cache_count > FORSYTH_CACHE_SIZE) {
+            for (uint32_t j = FORSYTH_CACHE_SIZE; j < cache_count; j++) {
+                struct forsyth_vertex *vertex = &forsyth.vertices[cache[j]];
+                vertex->cache_position = -1;
+                vertex->score = forsyth_vertex_score(&forsyth, vertex);
+            }
+        }
+        for (uint32_t j = 0; j < cache_count && j < FORSYTH_CACHE_SIZE; j++) {
+            struct forsyth_vertex *vertex = &forsyth.vertices[cache[j]];
+            vertex->cache_position = (int32_t) j;
+            vertex->score = forsyth_vertex_score(&forsyth, vertex);
+        }
+
+        // Only triangles around cached and evicted vertices changed score
+        best = UINT32_MAX;
+        best_score = -1.0f;
+        for (uint32_t j = 0; j < cache_count; j++) {
+            const struct forsyth_vertex *vertex = &forsyth.vertices[cache[j]];
+            const uint32_t *adjacency = &forsyth.adjacency[vertex->adjacency_offset];
+            for (uint32_t k = 0; k < vertex->remaining; k++) {
+                uint32_t triangle = adjacency[k];
+                forsyth_triangle_score(&forsyth, indices, triangle);
+                if (forsyth.triangle_scores[triangle] > best_score) {
+                    best = triangle;
+                    best_score = forsyth.triangle_scores[triangle];
+                }
+            }
+        }
+        if (cache_count > FORSYTH_CACHE_SIZE) {
+            cache_count = FORSYTH_CACHE_SIZE;
+        }
+    }
+
+    memcpy(indices, output, sizeof(indices[0]) * triangles_count * 3);
+
+    success = true;
+
+cleanup:
+    free(output);
+    free(forsyth.emitted);
+    free(forsyth.triangle_scores);
+    free(forsyth.adjacency);
+    free(forsyth.vertices);
+
+    return success;
+}
+
+/// FIFO post-transform cache, a vertex is cached while fewer than `size`
+/// other vertices have been transformed since it was
+struct meshoptimize_fifo {
+    uint32_t *timestamps;
+    uint32_t time;
+    uint32_t size;
+};
+
+/// @param[out] fifo
+/// @param[in] vertices_count
+/// @param[in] size
+/// @return `true` on success and `false` otherwise
+static bool meshoptimize_fifo_create(
+    struct meshoptimize_fifo *fifo, uint32_t vertices_count, uint32_t size
+) {
+    // Starting past `size` makes the zeroed timestamps read as evicted
+    *fifo = (struct meshoptimize_fifo){
+        .timestamps = calloc(vertices_count, sizeof(fifo->timestamps[0])),
+        .time = size + 1,
+        .size = size,
+    };
+
+    return fifo->timestamps != nullptr;
+}
+
+/// @param[in,out] fifo
+/// @param[in] vertex
+/// @return `true` if `vertex` had to be transformed
+static bool meshoptimize_fifo_miss(struct meshoptimize_fifo *fifo, uint32_t vertex) {
+    if (fifo->time - fifo->timestamps[vertex] <= fifo->size) {
+        return false;
+    }
+
+    fifo->timestamps[vertex] = fifo->time;
+    fifo->time++;
+
+    return true;
+}
+
+/// Consecutive triangles of `meshoptimize_overdraw`
+struct meshoptimize_cluster {
+    size_t begin;
+    size_t end;
+    float score;
+};
+
+/// @param[in] a
+/// @param[in] b
+/// @return Order of descending score, ties in order of appearance
+static int meshoptimize_cluster_compare(const void *a, const void *b) {
+    const struct meshoptimize_cluster *cluster_a = a;
+    const struct meshoptimize_cluster *cluster_b = b;
+
+    if (cluster_a->score != cluster_b->score) {
+        return cluster_a->score > cluster_b->score ? -1 : 1;
+    }
+
+    return (cluster_a->begin > cluster_b->begin) - (cluster_a->begin < cluster_b->begin);
+}
+
+bool meshoptimize_overdraw(
+    uint32_t *indices,
+    size_t indices_count,
+    const struct vertexformat_vertex *vertices,
+    uint32_t vertices_count
+) {
+    size_t triangles_count = indices_count / 3;
+    if (triangles_count == 0) {
+        return true;
+    }
+
+    bool success = false;
+    struct meshoptimize_fifo fifo = {};
+    struct meshoptimize_cluster *clusters = malloc(
+        sizeof(clusters[0]) * triangles_count
+    );
+    uint32_t *output = malloc(sizeof(output[0]) * triangles_count * 3);
+    if (
+        !meshoptimize_fifo_create(&fifo, vertices_count, MESHOPTIMIZE_FIFO_SIZE) ||
+        clusters == nullptr ||
+        output == nullptr
+    ) {
+        fprintf(stderr, "meshoptimize_overdraw: malloc failed\n");
+        goto cleanup;
+    }
+
+    // A cluster starts wherever a triangle misses with all of its vertices,
+    // the cache holds nothing the triangles before it could share
+    size_t clusters_count = 0;
+    float center[3] = {};
+    for (size_t i = 0; i < triangles_count; i++) {
+        const uint32_t *corners = &indices[i * 3];
+        uint32_t misses = 0;
+        for (size_t j = 0; j < 3; j++) {
+            misses += meshoptimize_fifo_miss(&fifo, corners[j]);
+        }
+        if (misses == 3 || i == 0) {
+            if (clusters_count > 0) {
+                clusters[clusters_count - 1].end = i;
+            }
+            clusters[clusters_count++] = (struct meshoptimize_cluster){.begin = i};
+        }
+
+        for (size_t j = 0; j < 3; j++) {
+            for (size_t k = 0; k < 3; k++) {
+                center[k] += vertices[corners[j]].position[k];
+            }
+        }
+    }
+    clusters[clusters_count - 1].end = triangles_count;
+    for (size_t k = 0; k < 3; k++) {
+        center[k] /= (float) (triangles_count * 3);
+    }
+
+    // Area weighted normal and centroid of each cluster
+    float orientation = 0.0f;
+    for (size_t i = 0; i < clusters_count; i++) {
+        struct meshoptimize_cluster *cluster = &clusters[i];
+        float normal[3] = {};
+        float centroid[3] = {};
+        for (size_t t = cluster->begin; t < cluster->end; t++) {
+            const float *a = vertices[indices[t * 3 + 0]].position;
+            const float *b = vertices[indices[t * 3 + 1]].position;
+            const float *c = vertices[indices[t * 3 + 2]].position;
+            float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+            normal[0] += ab[1] * ac[2] - ab[2] * ac[1];
+            normal[1] += ab[2] * ac[0] - ab[0] * ac[2];
+            normal[2] += ab[0] * ac[1] - ab[1] * ac[0];
+            for (size_t k = 0; k < 3; k++) {
+                centroid[k] += (a[k] + b[k] + c[k]) / 3.0f;
+            }
+        }
+
+        float length = sqrtf(
+            normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]
+        );
+        float triangles = (float) (cluster->end - cluster->begin);
+        cluster->score = 0.0f;
+        for (size_t k = 0; k < 3; k++) {
+            float outward = centroid[k] / triangles - center[k];
+            if (length > 0.0f) {
+                cluster->score += outward * normal[k] / length;
+            }
+        }
+        orientation += cluster->score;
+    }
+
+    // Which way the normals point depends on the winding convention of the
+    // mesh, which is taken to be whatever most clusters agree on
+    if (orientation < 0.0f) {
+        for (size_t i = 0; i < clusters_count; i++) {
+            clusters[i].score = -clusters[i].score;
+        }
+    }
+
+    qsort(clusters, clusters_count, sizeof(clusters[0]), meshoptimize_cluster_compare);
+
+    size_t written = 0;
+    for (size_t i = 0; i < clusters_count; i++) {
+        size_t count = (clusters[i].end - clusters[i].begin) * 3;
+        memcpy(
+            &output[written], &indices[clusters[i].begin * 3], sizeof(output[0]) * count
+        );
+        written += count;
+    }
+    memcpy(indices, output, sizeof(indices[0]) * triangles_count * 3);
+
+    success = true;
+
+cleanup:
+    free(output);
+    free(clusters);
+    free(fifo.timestamps);
+
+    return success;
+}
+
+bool meshoptimize_vertexfetch(
+    struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    uint32_t *indices,
+    size_t indices_count,
+    uint32_t *used_count
+) {
+    if (vertices_count == 0) {
+        *used_count = 0;
+        return true;
+    }
+
+    uint32_t *remap = malloc(sizeof(remap[0]) * vertices_count);
+    struct vertexformat_vertex *reordered = malloc(
+        sizeof(reordered[0]) * vertices_count
+    );
+    if (remap == nullptr || reordered == nullptr) {
+        fprintf(stderr, "meshoptimize_vertexfetch: malloc failed\n");
+        free(reordered);
+        free(remap);
+        return false;
+    }
+    memset(remap, 0xff, sizeof(remap[0]) * vertices_count);
+
+    uint32_t used = 0;
+    for (size_t i = 0; i < indices_count; i++) {
+        uint32_t vertex = indices[i];
+        if (remap[vertex] == UINT32_MAX) {
+            remap[vertex] = used;
+            reordered[used] = vertices[vertex];
+            used++;
+        }
+        indices[i] = remap[vertex];
+    }
+
+    memcpy(vertices, reordered, sizeof(vertices[0]) * used);
+    *used_count = used;
+
+    free(reordered);
+    free(remap);
+
+    return true;
+}
+
+bool meshoptimize_analyze(
+    const uint32_t *indices,
+    size_t indices_count,
+    uint32_t vertices_count,
+    struct meshoptimize_stats *stats
+) {
+    *stats = (struct meshoptimize_stats){};
+    if (indices_count < 3) {
+        return true;
+    }
+
+    struct meshoptimize_fifo fifo;
+    bool *referenced = calloc(vertices_count, sizeof(referenced[0]));
+    if (
+        !meshoptimize_fifo_create(&fifo, vertices_count, MESHOPTIMIZE_FIFO_SIZE) ||
+        referenced == nullptr
+    ) {
+        fprintf(stderr, "meshoptimize_analyze: malloc failed\n");
+        free(referenced);
+        free(fifo.timestamps);
+        return false;
+    }
+
+    size_t misses = 0;
+    size_t referenced_count = 0;
+    for (size_t i = 0; i < indices_count; i++) {
+        misses += meshoptimize_fifo_miss(&fifo, indices[i]);
+        if (!referenced[indices[i]]) {
+            referenced[indices[i]] = true;
+            referenced_count++;
+        }
+    }
+
+    *stats = (struct meshoptimize_stats){
+        .acmr = (float) misses / (float) (indices_count / 3),
+        .atvr = (float) misses / (float) referenced_count,
+    };
+
+    free(referenced);
+    free(fifo.timestamps);
+
+    return true;
+}
@@ -0,0 +1,92 @@
+#ifndef MESHOPTIMIZE_H
+#define MESHOPTIMIZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vertexformat.h"
+
+/// Size of the FIFO post-transform cache `meshoptimize_analyze` simulates
+constexpr uint32_t MESHOPTIMIZE_FIFO_SIZE = 16;
+
+/// Post-transform cache efficiency of an index buffer
+struct meshoptimize_stats {
+    /// Average cache miss ratio, vertex shader invocations per triangle
+    float acmr;
+    /// Average transform to vertex ratio, vertex shader invocations per
+    /// vertex, 1 is optimal
+    float atvr;
+};
+
+/// Merges vertices that are identical bit for bit
+/// @param[in,out] vertices Compacted to the unique vertices in order of
+/// first appearance
+/// @param[in] vertices_count
+/// @param[in,out] indices Remapped to the compacted `vertices`
+/// @param[in] indices_count
+/// @param[out] unique_count Number of `vertices` left
+/// @return `true` on success and `false` otherwise
+bool meshoptimize_deduplicate(
+    struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    uint32_t *indices,
+    size_t indices_count,
+    uint32_t *unique_count
+);
+
+/// Reorders triangles for a post-transform vertex cache with Tom Forsyth's
+/// linear-speed algorithm, which works well for any cache size up to its own
+/// simulated LRU cache of 32 entries
+/// @param[in,out] indices Triangle list
+/// @param[in] indices_count
+/// @param[in] vertices_count
+/// @return `true` on success and `false` otherwise
+bool meshoptimize_vertexcache(
+    uint32_t *indices, size_t indices_count, uint32_t vertices_count
+);
+
+/// Reorders clusters of triangles so that those facing away from the center
+/// of the mesh, which are likely in front, are drawn first. Clusters start
+/// where the cache is flushed anyway, so run this after
+/// `meshoptimize_vertexcache` to keep its cache efficiency.
+/// @param[in,out] indices Triangle list
+/// @param[in] indices_count
+/// @param[in] vertices
+/// @param[in] vertices_count
+/// @return `true` on success and `false` otherwise
+bool meshoptimize_overdraw(
+    uint32_t *indices,
+    size_t indices_count,
+    const struct vertexformat_vertex *vertices,
+    uint32_t vertices_count
+);
+
+/// Reorders vertices by first use in `indices`, so that vertex fetches
+/// stream through memory, and drops vertices no triangle references
+/// @param[in,out] vertices
+/// @param[in] vertices_count
+/// @param[in,out] indices Remapped to the reordered `vertices`
+/// @param[in] indices_count
+/// @param[out] used_count Number of `vertices` left
+/// @return `true` on success and `false` otherwise
+bool meshoptimize_vertexfetch(
+    struct vertexformat_vertex *vertices,
+    uint32_t vertices_count,
+    uint32_t *indices,
+    size_t indices_count,
+    uint32_t *used_count
+);
+
+/// @param[in] indices Triangle list
+/// @param[in] indices_count
+/// @param[in] vertices_count
+/// @param[out] stats Simulated on a `MESHOPTIMIZE_FIFO_SIZE` entry FIFO cache
+/// @return `true` on success and `false` otherwise
+bool meshoptimize_analyze(
+    const uint32_t *indices,
+    size_t indices_count,
+    uint32_t vertices_count,
+    struct meshoptimize_stats *stats
+);
+
+#endif
@@ -0,0 +1,636 @@
+#include <stdio.h>
+
+#include "mipgen.h"
+#include "spirv.h"
+
+/// Bindings of `shaders/downsample.glsl`
+enum mipgen_binding {
+    MIPGEN_BINDING_SOURCE,
+    MIPGEN_BINDING_LEVELS,
+    MIPGEN_BINDING_INTERMEDIATE,
+    MIPGEN_BINDING_COUNTERS,
+    MIPGEN_BINDINGS_COUNT,
+};
+
+/// Texels of level 6 per layer, one per workgroup
+constexpr VkDeviceSize MIPGEN_INTERMEDIATE_TEXELS = (
+    MIPGEN_MAX_WORKGROUPS * MIPGEN_MAX_WORKGROUPS
+);
+
+/// Stages that sample textures once their mips are generated
+constexpr VkPipelineStageFlags MIPGEN_SHADER_STAGES = (
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+);
+
+/// @param[in] size
+/// @param[in] level
+/// @return Size of `level` in a chain starting at `size`
+static uint32_t mipgen_level_extent(uint32_t size, uint32_t level) {
+    return size >> level > 0 ? size >> level : 1;
+}
+
+/// @param[in] size
+/// @return Workgroups along an axis of `size` texels
+static uint32_t mipgen_workgroups(uint32_t size) {
+    return (size + 63) / 64;
+}
+
+/// @param[in,out] mipgen
+/// @param[in,out] layoutcache
+/// @param[in] code
+/// @param[in] code_size
+/// @return `true` on success and `false` otherwise
+static bool mipgen_pipeline_create(
+    struct mipgen *mipgen,
+    struct layoutcache *layoutcache,
+    const uint8_t *code,
+    size_t code_size
+) {
+    struct spirv_reflection reflection;
+    if (!spirv_reflect(code, code_size, &reflection)) {
+        fprintf(stderr, "mipgen_pipeline_create: spirv_reflect failed\n");
+        return false;
+    }
+    if (
+        reflection.stages != VK_SHADER_STAGE_COMPUTE_BIT ||
+        reflection.bindings_count != MIPGEN_BINDINGS_COUNT ||
+        reflection.push_constants.size != sizeof(struct mipgen_image)
+    ) {
+        fprintf(stderr, "mipgen_pipeline_create: unexpected shader interface\n");
+        return false;
+    }
+
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS];
+    uint32_t setlayouts_count;
+    if (!layoutcache_pipelinelayout_get(
+        layoutcache, &reflection, &mipgen->layout, setlayouts, &setlayouts_count
+    )) {
+        fprintf(
+            stderr, "mipgen_pipeline_create: layoutcache_pipelinelayout_get failed\n"
+        );
+        return false;
+    }
+    mipgen->setlayout = setlayouts[0];
+
+    VkShaderModuleCreateInfo shadermodule_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pCode = (const uint32_t *) code,
+        .codeSize = code_size,
+    };
+    if (vkCreateShaderModule(
+        mipgen->device, &shadermodule_info, nullptr, &mipgen->shadermodule
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "mipgen_pipeline_create: vkCreateShaderModule failed\n");
+        return false;
+    }
+
+    VkComputePipelineCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = mipgen->shadermodule,
+            .pName = "main",
+        },
+        .layout = mipgen->layout,
+    };
+    if (vkCreateComputePipelines(
+        mipgen->device, VK_NULL_HANDLE, 1, &create_info, nullptr, &mipgen->pipeline
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "mipgen_pipeline_create: vkCreateComputePipelines failed\n");
+        mipgen->pipeline = VK_NULL_HANDLE;
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] mipgen
+/// @param[in] memory_properties
+/// @return `true` on success and `false` otherwise
+static bool mipgen_resources_create(
+    struct mipgen *mipgen, const VkPhysicalDeviceMemoryProperties *memory_properties
+) {
+    if (!buffer_create(
+        mipgen->device,
+        memory_properties,
+        sizeof(float[4]) * MIPGEN_INTERMEDIATE_TEXELS * MIPGEN_MAX_LAYERS,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        0,
+        &mipgen->intermediate
+    )) {
+        fprintf(stderr, "mipgen_resources_create: buffer_create failed\n");
+        return false;
+    }
+
+    if (!buffer_create(
+        mipgen->device,
+        memory_properties,
+        sizeof(uint32_t) * MIPGEN_MAX_LAYERS,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        0,
+        &mipgen->counters
+    )) {
+        fprintf(stderr, "mipgen_resources_create: buffer_create failed\n");
+        return false;
+    }
+
+    VkDescriptorPoolSize pool_sizes[] = {
+        {
+            .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = MIPGEN_MAX_IMAGES,
+        },
+        {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = MIPGEN_MAX_IMAGES * (MIPGEN_MAX_LEVELS - 1),
+        },
+        {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = MIPGEN_MAX_IMAGES * 2,
+        },
+    };
+    VkDescriptorPoolCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = MIPGEN_MAX_IMAGES,
+        .pPoolSizes = pool_sizes,
+        .poolSizeCount = sizeof(pool_sizes) / sizeof(pool_sizes[0]),
+    };
+    if (vkCreateDescriptorPool(
+        mipgen->device, &create_info, nullptr, &mipgen->pool
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "mipgen_resources_create: vkCreateDescriptorPool failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool mipgen_create(
+    VkDevice device,
+    VkPhysicalDevice physicaldevice,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    struct layoutcache *layoutcache,
+    const uint8_t *code,
+    size_t code_size,
+    struct mipgen *mipgen
+) {
+    *mipgen = (struct mipgen){
+        .device = device,
+        .physicaldevice = physicaldevice,
+    };
+
+    if (code == nullptr) {
+        return true;
+    }
+
+    if (!mipgen_pipeline_create(mipgen, layoutcache, code, code_size)) {
+        fprintf(stderr, "mipgen_create: mipgen_pipeline_create failed\n");
+        goto cleanup;
+    }
+
+    if (!mipgen_resources_create(mipgen, memory_properties)) {
+        fprintf(stderr, "mipgen_create: mipgen_resources_create failed\n");
+        goto cleanup;
+    }
+
+    return true;
+
+cleanup:
+    mipgen_destroy(mipgen);
+
+    return false;
+}
+
+void mipgen_destroy(struct mipgen *mipgen) {
+    mipgen_reset(mipgen);
+    vkDestroyDescriptorPool(mipgen->device, mipgen->pool, nullptr);
+    buffer_destroy(mipgen->device, &mipgen->counters);
+    buffer_destroy(mipgen->device, &mipgen->intermediate);
+    vkDestroyPipeline(mipgen->device, mipgen->pipeline, nullptr);
+    vkDestroyShaderModule(mipgen->device, mipgen->shadermodule, nullptr);
+
+    *mipgen = (struct mipgen){};
+}
+
+VkImageUsageFlags mipgen_usage(const struct mipgen *mipgen, VkFormat format) {
+    if (mipgen->pipeline == VK_NULL_HANDLE) {
+        return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(mipgen->physicaldevice, format, &properties);
+
+    VkFormatFeatureFlags features = (
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT
+    );
+    if ((properties.optimalTilingFeatures & features) != features) {
+        return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+
+    return VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+}
+
+/// @param[in] mipgen
+/// @param[in] texture
+/// @return Whether one dispatch can write every level of `texture`
+static bool mipgen_dispatch_supported(
+    const struct mipgen *mipgen, const struct texture *texture
+) {
+    return (
+        mipgen->pipeline != VK_NULL_HANDLE &&
+        mipgen->images_count < MIPGEN_MAX_IMAGES &&
+        (texture->usage & VK_IMAGE_USAGE_STORAGE_BIT) != 0 &&
+        texture->extent.depth == 1 &&
+        texture->levels_count <= MIPGEN_MAX_LEVELS &&
+        texture->layers_count <= MIPGEN_MAX_LAYERS &&
+        mipgen_workgroups(texture->extent.width) <= MIPGEN_MAX_WORKGROUPS &&
+        mipgen_workgroups(texture->extent.height) <= MIPGEN_MAX_WORKGROUPS
+    );
+}
+
+/// @param[in,out] mipgen
+/// @param[in] texture
+/// @param[out] set Reading the base level of `texture` and writing the others
+/// @return `true` on success and `false` otherwise
+static bool mipgen_set_allocate(
+    struct mipgen *mipgen, const struct texture *texture, VkDescriptorSet *set
+) {
+    size_t views_first = mipgen->views_count;
+    VkDescriptorImageInfo level_infos[MIPGEN_MAX_LEVELS - 1];
+
+    // Every level gets a view of its own, as storage views hold one level
+    for (uint32_t level = 0; level < texture->levels_count; level++) {
+        VkImageViewCreateInfo view_info = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = texture->image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+            .format = texture->format,
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = level,
+                .levelCount = 1,
+                .layerCount = texture->layers_count,
+            },
+        };
+        if (vkCreateImageView(
+            mipgen->device, &view_info, nullptr, &mipgen->views[mipgen->views_count]
+        ) != VK_SUCCESS) {
+            fprintf(stderr, "mipgen_set_allocate: vkCreateImageView failed\n");
+            goto cleanup;
+        }
+        mipgen->views_count++;
+    }
+
+    VkDescriptorSetAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = mipgen->pool,
+        .pSetLayouts = &mipgen->setlayout,
+        .descriptorSetCount = 1,
+    };
+    if (vkAllocateDescriptorSets(mipgen->device, &allocate_info, set) != VK_SUCCESS) {
+        fprintf(stderr, "mipgen_set_allocate: vkAllocateDescriptorSets failed\n");
+        goto cleanup;
+    }
+
+    // Elements past the last level repeat it, the shader never writes them
+    const VkImageView *views = &mipgen->views[views_first];
+    VkDescriptorImageInfo source_info = {
+        .imageView = views[0],
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+    };
+    for (uint32_t i = 0; i < MIPGEN_MAX_LEVELS - 1; i++) {
+        uint32_t level = i + 1 < texture->levels_count
+            ? i + 1
+            : texture->levels_count - 1;
+        level_infos[i] = (VkDescriptorImageInfo){
+            .imageView = views[level],
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+    }
+    VkDescriptorBufferInfo intermediate_info = {
+        .buffer = mipgen->intermediate.buffer,
+        .range = VK_WHOLE_SIZE,
+    };
+    VkDescriptorBufferInfo counters_info = {
+        .buffer = mipgen->counters.buffer,
+        .range = VK_WHOLE_SIZE,
+    };
+
+    VkWriteDescriptorSet writes[MIPGEN_BINDINGS_COUNT] = {
+        [MIPGEN_BINDING_SOURCE] = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = *set,
+            .dstBinding = MIPGEN_BINDING_SOURCE,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = 1,
+            .pImageInfo = &source_info,
+        },
+        [MIPGEN_BINDING_LEVELS] = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = *set,
+            .dstBinding = MIPGEN_BINDING_LEVELS,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = MIPGEN_MAX_LEVELS - 1,
+            .pImageInfo = level_infos,
+        },
+        [MIPGEN_BINDING_INTERMEDIATE] = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = *set,
+            .dstBinding = MIPGEN_BINDING_INTERMEDIATE,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .pBufferInfo = &intermediate_info,
+        },
+        [MIPGEN_BINDING_COUNTERS] = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = *set,
+            .dstBinding = MIPGEN_BINDING_COUNTERS,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .pBufferInfo = &counters_info,
+        },
+    };
+    vkUpdateDescriptorSets(mipgen->device, MIPGEN_BINDINGS_COUNT, writes, 0, nullptr);
+
+    return true;
+
+cleanup:
+    while (mipgen->views_count > views_first) {
+        mipgen->views_count--;
+        vkDestroyImageView(mipgen->device, mipgen->views[mipgen->views_count], nullptr);
+    }
+
+    return false;
+}
+
+bool mipgen_record(
+    struct mipgen *mipgen, VkCommandBuffer command_buffer, struct texture *texture
+) {
+    if (texture->levels_count <= 1) {
+        texture_transition(
+            texture, command_buffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+        return true;
+    }
+
+    if (!mipgen_dispatch_supported(mipgen, texture)) {
+        return mipgen_blit_record(mipgen, command_buffer, texture);
+    }
+
+    VkDescriptorSet set;
+    if (!mipgen_set_allocate(mipgen, texture, &set)) {
+        fprintf(stderr, "mipgen_record: mipgen_set_allocate failed\n");
+        return false;
+    }
+
+    // The counters start out zero and are reset by the last workgroup of
+    // each layer, while the intermediate texels of consecutive dispatches
+    // share the same buffer
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+    VkPipelineStageFlags src_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    if (mipgen->images_count == 0) {
+        vkCmdFillBuffer(
+            command_buffer, mipgen->counters.buffer, 0, mipgen->counters.size, 0
+        );
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    vkCmdPipelineBarrier(
+        command_buffer,
+        src_stage,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+    texture_transition(texture, command_buffer, VK_IMAGE_LAYOUT_GENERAL);
+
+    struct mipgen_image image = {
+        .width = (int32_t) texture->extent.width,
+        .height = (int32_t) texture->extent.height,
+        .levels_count = texture->levels_count,
+        .workgroups_count = (
+            mipgen_workgroups(texture->extent.width) *
+            mipgen_workgroups(texture->extent.height)
+        ),
+    };
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, mipgen->pipeline);
+    vkCmdBindDescriptorSets(
+        command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        mipgen->layout,
+        0,
+        1,
+        &set,
+        0,
+        nullptr
+    );
+    vkCmdPushConstants(
+        command_buffer,
+        mipgen->layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(image),
+        &image
+    );
+    vkCmdDispatch(
+        command_buffer,
+        mipgen_workgroups(texture->extent.width),
+        mipgen_workgroups(texture->extent.height),
+        texture->layers_count
+    );
+
+    texture_transition(
+        texture, command_buffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    );
+    mipgen->images_count++;
+
+    return true;
+}
+
+/// @param[in] texture
+/// @param[in] first_level
+/// @param[in] levels_count
+/// @param[in] old_layout
+/// @param[in] new_layout
+/// @param[in] src_access
+/// @param[in] dst_access
+/// @return Barrier for every layer of the levels
+static VkImageMemoryBarrier mipgen_barrier(
+    const struct texture *texture,
+    uint32_t first_level,
+    uint32_t levels_count,
+    VkImageLayout old_layout,
+    VkImageLayout new_layout,
+    VkAccessFlags src_access,
+    VkAccessFlags dst_access
+) {
+    return (VkImageMemoryBarrier){
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = src_access,
+        .dstAccessMask = dst_access,
+        .oldLayout = old_layout,
+        .newLayout = new_layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = texture->image,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = first_level,
+            .levelCount = levels_count,
+            .layerCount = texture->layers_count,
+        },
+    };
+}
+
+bool mipgen_blit_record(
+    const struct mipgen *mipgen, VkCommandBuffer command_buffer, struct texture *texture
+) {
+    if (texture->levels_count <= 1) {
+        texture_transition(
+            texture, command_buffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+        return true;
+    }
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(
+        mipgen->physicaldevice, texture->format, &properties
+    );
+    VkFormatFeatureFlags features = properties.optimalTilingFeatures;
+    VkFormatFeatureFlags blit = (
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT
+    );
+    if (
+        (features & blit) != blit ||
+        (texture->usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) == 0
+    ) {
+        fprintf(stderr, "mipgen_blit_record: format cannot be blitted\n");
+        return false;
+    }
+    VkFilter filter = (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+        ? VK_FILTER_LINEAR
+        : VK_FILTER_NEAREST;
+
+    texture_transition(texture, command_buffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    // Each level is read once the blit before it has written it
+    for (uint32_t level = 1; level < texture->levels_count; level++) {
+        VkImageMemoryBarrier barrier = mipgen_barrier(
+            texture,
+            level - 1,
+            1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT
+        );
+        vkCmdPipelineBarrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            1,
+            &barrier
+        );
+
+        VkImageBlit region = {
+            .srcSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = level - 1,
+                .layerCount = texture->layers_count,
+            },
+            .srcOffsets[1] = {
+                .x = (int32_t) mipgen_level_extent(texture->extent.width, level - 1),
+                .y = (int32_t) mipgen_level_extent(texture->extent.height, level - 1),
+                .z = (int32_t) mipgen_level_extent(texture->extent.depth, level - 1),
+            },
+            .dstSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = level,
+                .layerCount = texture->layers_count,
+            },
+            .dstOffsets[1] = {
+                .x = (int32_t) mipgen_level_extent(texture->extent.width, level),
+                .y = (int32_t) mipgen_level_extent(texture->extent.height, level),
+                .z = (int32_t) mipgen_level_extent(texture->extent.depth, level),
+            },
+        };
+        vkCmdBlitImage(
+            command_buffer,
+            texture->image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            texture->image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &region,
+            filter
+        );
+    }
+
+    // Every level but the last was read from
+    VkImageMemoryBarrier barriers[] = {
+        mipgen_barrier(
+            texture,
+            0,
+            texture->levels_count - 1,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_READ_BIT,
+            VK_ACCESS_SHADER_READ_BIT
+        ),
+        mipgen_barrier(
+            texture,
+            texture->levels_count - 1,
+            1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT
+        ),
+    };
+    vkCmdPipelineBarrier(
+        command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        MIPGEN_SHADER_STAGES,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        sizeof(barriers) / sizeof(barriers[0]),
+        barriers
+    );
+    texture->layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    return true;
+}
+
+void mipgen_reset(struct mipgen *mipgen) {
+    for (size_t i = 0; i < mipgen->views_count; i++) {
+        vkDestroyImageView(mipgen->device, mipgen->views[i], nullptr);
+    }
+    mipgen->views_count = 0;
+
+    if (mipgen->pool != VK_NULL_HANDLE) {
+        vkResetDescriptorPool(mipgen->device, mipgen->pool, 0);
+    }
+    mipgen->images_count = 0;
+}
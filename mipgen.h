@@ -0,0 +1,118 @@
+#ifndef MIPGEN_H
+#define MIPGEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "buffer.h"
+#include "layoutcache.h"
+#include "texture.h"
+
+/// Levels `shaders/downsample.glsl` writes, including the base level it reads
+constexpr uint32_t MIPGEN_MAX_LEVELS = 13;
+/// Layers one dispatch reduces, enough for a cube
+constexpr uint32_t MIPGEN_MAX_LAYERS = 6;
+/// Workgroups along each axis, each of which reduces 64x64 texels to one
+/// texel of level 6
+constexpr uint32_t MIPGEN_MAX_WORKGROUPS = 64;
+/// Dispatches that can be recorded between two `mipgen_reset`
+constexpr size_t MIPGEN_MAX_IMAGES = 32;
+
+/// `Image` push constant block of `shaders/downsample.glsl`
+struct mipgen_image {
+    int32_t width;
+    int32_t height;
+    uint32_t levels_count;
+    uint32_t workgroups_count;
+};
+
+/// Fills the mip chain of a texture from its base level. A compute pipeline
+/// writes every level of an image in one dispatch, without a barrier between
+/// levels. Images it cannot handle fall back to a chain of blits, one level
+/// at a time.
+struct mipgen {
+    VkDevice device;
+    VkPhysicalDevice physicaldevice;
+
+    VkShaderModule shadermodule;
+    /// Owned by the layout cache
+    VkPipelineLayout layout;
+    VkDescriptorSetLayout setlayout;
+    /// `VK_NULL_HANDLE` when only blits are available
+    VkPipeline pipeline;
+
+    /// Level 6 of every layer, read back by the last workgroup of its layer
+    struct buffer intermediate;
+    /// Workgroups of every layer that are done
+    struct buffer counters;
+
+    VkDescriptorPool pool;
+    /// Views the dispatches recorded since the last reset use
+    VkImageView views[MIPGEN_MAX_IMAGES * MIPGEN_MAX_LEVELS];
+    size_t views_count;
+    /// Dispatches recorded since the last reset
+    size_t images_count;
+};
+
+/// @param[in] device
+/// @param[in] physicaldevice
+/// @param[in] memory_properties
+/// @param[in,out] layoutcache Without set layout flags
+/// @param[in] code SPIR-V of `shaders/downsample.glsl`, or `nullptr` to only
+/// blit, e.g. when `shaderStorageImageWriteWithoutFormat` is not enabled
+/// @param[in] code_size
+/// @param[out] mipgen
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `mipgen_destroy` after successful return
+bool mipgen_create(
+    VkDevice device,
+    VkPhysicalDevice physicaldevice,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    struct layoutcache *layoutcache,
+    const uint8_t *code,
+    size_t code_size,
+    struct mipgen *mipgen
+);
+
+/// @param[in,out] mipgen
+/// @note The device must be idle
+void mipgen_destroy(struct mipgen *mipgen);
+
+/// @param[in] mipgen
+/// @param[in] format
+/// @return Usage that textures of `format` are created with to have their
+/// mips generated, storage where the pipeline can write `format`
+VkImageUsageFlags mipgen_usage(const struct mipgen *mipgen, VkFormat format);
+
+/// Records writing every level of `texture` below the base level, in one
+/// dispatch where possible and with blits otherwise
+/// @param[in,out] mipgen
+/// @param[in] command_buffer Recording, on a queue that supports graphics
+/// @param[in,out] texture With the usage of `mipgen_usage`, left in
+/// `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`
+/// @return `true` on success and `false` otherwise
+/// @note Views and descriptors of the dispatch live until `mipgen_reset`
+bool mipgen_record(
+    struct mipgen *mipgen, VkCommandBuffer command_buffer, struct texture *texture
+);
+
+/// Records writing every level of `texture` below the base level with a chain
+/// of blits
+/// @param[in] mipgen
+/// @param[in] command_buffer Recording, on a queue that supports graphics
+/// @param[in,out] texture With `VK_IMAGE_USAGE_TRANSFER_SRC_BIT`, left in
+/// `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`
+/// @return `true` on success and `false` if the format cannot be blitted
+bool mipgen_blit_record(
+    const struct mipgen *mipgen, VkCommandBuffer command_buffer, struct texture *texture
+);
+
+/// Gives back the views and descriptors of every dispatch recorded so far
+/// @param[in,out] mipgen
+/// @note The device must have finished every command buffer recorded since
+/// the last reset
+void mipgen_reset(struct mipgen *mipgen);
+
+#endif
@@ -0,0 +1,1023 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "occlusion.h"
+
+/// Triangles one job sets up and bins
+constexpr size_t OCCLUSION_JOB_TRIANGLES = 1 << 10;
+/// Objects one job tests
+constexpr size_t OCCLUSION_JOB_OBJECTS = 1 << 12;
+/// Clipping against the near plane and the four planes of the guard band adds
+/// at most one vertex per plane, and the polygon left is a fan of triangles
+constexpr size_t OCCLUSION_CLIP_PLANES = 5;
+constexpr size_t OCCLUSION_CLIP_VERTICES = 3 + OCCLUSION_CLIP_PLANES;
+constexpr size_t OCCLUSION_CLIPPED_MAX = OCCLUSION_CLIP_VERTICES - 2;
+/// Vertices are clipped to this many times the size of the screen around its
+/// center, so that edge functions keep enough precision to never cover a pixel
+/// center the triangle misses by more than a small fraction of a pixel
+constexpr float OCCLUSION_GUARD_BAND = 32.0f;
+
+/// Rasterizes a triangle into the pixels of one tile, and returns the farthest
+/// depth in it
+typedef float (*occlusion_tile_function)(
+    const struct occlusion_triangle *triangle,
+    uint32_t tile_x,
+    uint32_t tile_y,
+    float *depths
+);
+
+/// Bounds on screen of a box in front of the near plane
+struct occlusion_rect {
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+    /// Nearest depth of the box
+    float depth;
+};
+
+/// Projects the corners of a box, and returns whether every corner is in front
+/// of the camera and behind the near plane
+typedef bool (*occlusion_project_function)(
+    const struct occlusion *occlusion,
+    const float view_projection[16],
+    const float min[3],
+    const float max[3],
+    struct occlusion_rect *rect
+);
+
+struct occlusion_triangle {
+    /// Edge functions `a * x + b * y + c` of pixel centers, none of which is
+    /// negative inside
+    float edges[3][3];
+    /// Depth `a * x + b * y + c`, clamped to the depths of the corners so that
+    /// rounding never brings it nearer
+    float depth[3];
+    float depth_min;
+    float depth_max;
+    /// Tiles the bounds on screen touch, inclusive
+    uint16_t tiles_min[2];
+    uint16_t tiles_max[2];
+};
+
+/// Range of triangles one job sets up and bins
+struct occlusion_setup {
+    struct occlusion *occlusion;
+    const float *view_projection;
+    const float *positions;
+    const uint32_t *indices;
+    size_t first;
+    size_t count;
+    /// `OCCLUSION_CLIPPED_MAX` entries per triangle of the range, of which the
+    /// first `triangles_count` are written
+    struct occlusion_triangle *triangles;
+    size_t triangles_count;
+    /// Triangles added to each bin, then where the next of them is written
+    size_t *bin_counts;
+};
+
+/// Bin one job rasterizes
+struct occlusion_bin {
+    struct occlusion *occlusion;
+    uint32_t bin_x;
+    uint32_t bin_y;
+    /// Range of `references`
+    size_t first;
+    size_t count;
+};
+
+/// Range of visible objects one job tests
+struct occlusion_range {
+    const struct occlusion *occlusion;
+    const float *view_projection;
+    const struct cull_objects *objects;
+    uint32_t *visible;
+    size_t count;
+    size_t visible_count;
+};
+
+bool occlusion_create(uint32_t width, uint32_t height, struct occlusion *occlusion) {
+    *occlusion = (struct occlusion) {
+        .tiles_x = (width + OCCLUSION_TILE_WIDTH - 1) / OCCLUSION_TILE_WIDTH,
+        .tiles_y = (height + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT,
+    };
+    occlusion->width = occlusion->tiles_x * OCCLUSION_TILE_WIDTH;
+    occlusion->height = occlusion->tiles_y * OCCLUSION_TILE_HEIGHT;
+    occlusion->bins_x = (occlusion->tiles_x + OCCLUSION_BIN_TILES - 1) /
+        OCCLUSION_BIN_TILES;
+    occlusion->bins_y = (occlusion->tiles_y + OCCLUSION_BIN_TILES - 1) /
+        OCCLUSION_BIN_TILES;
+#if defined(__x86_64__) || defined(__i386__)
+    occlusion->avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    // A tile is a multiple of 32 bytes, so rows of every tile stay aligned
+    size_t tiles_count = (size_t) occlusion->tiles_x * occlusion->tiles_y;
+    occlusion->depths = aligned_alloc(
+        32, sizeof(float) * OCCLUSION_TILE_WIDTH * OCCLUSION_TILE_HEIGHT * tiles_count
+    );
+    occlusion->tile_depths = malloc(sizeof(float) * tiles_count);
+    if (occlusion->depths == nullptr || occlusion->tile_depths == nullptr) {
+        fprintf(stderr, "occlusion_create: malloc failed\n");
+        free(occlusion->tile_depths);
+        free(occlusion->depths);
+        return false;
+    }
+
+    occlusion_clear(occlusion);
+
+    return true;
+}
+
+void occlusion_destroy(struct occlusion *occlusion) {
+    free(occlusion->bin_counts);
+    free(occlusion->references);
+    free(occlusion->triangles);
+    free(occlusion->tile_depths);
+    free(occlusion->depths);
+}
+
+void occlusion_clear(struct occlusion *occlusion) {
+    size_t tiles_count = (size_t) occlusion->tiles_x * occlusion->tiles_y;
+    size_t pixels_count = (size_t) occlusion->width * occlusion->height;
+    for (size_t i = 0; i < pixels_count; i++) {
+        occlusion->depths[i] = 1.0f;
+    }
+    for (size_t i = 0; i < tiles_count; i++) {
+        occlusion->tile_depths[i] = 1.0f;
+    }
+}
+
+/// @param[in,out] array
+/// @param[in,out] capacity Entries of `array`
+/// @param[in] size Of an entry
+/// @param[in] count Entries needed
+/// @return `true` on success and `false` otherwise
+static bool occlusion_reserve(
+    void **array, size_t *capacity, size_t size, size_t count
+) {
+    if (count <= *capacity) {
+        return true;
+    }
+
+    size_t new_capacity = *capacity > 0 ? *capacity : 1024;
+    while (new_capacity < count) {
+        new_capacity *= 2;
+    }
+    void *new_array = realloc(*array, size * new_capacity);
+    if (new_array == nullptr) {
+        fprintf(stderr, "occlusion_reserve: realloc failed\n");
+        return false;
+    }
+    *array = new_array;
+    *capacity = new_capacity;
+
+    return true;
+}
+
+/// Runs a function on every argument, on jobs where there are any, and returns
+/// once all of them have run
+/// @param[in,out] jobs May be `nullptr`
+/// @param[in] function
+/// @param[in,out] arguments
+/// @param[in] size Of an argument
+/// @param[in] count Of arguments
+static void occlusion_run(
+    struct jobs *jobs, jobs_function function, void *arguments, size_t size, size_t count
+) {
+    struct jobs_counter counter = {};
+    for (size_t i = 0; i < count; i++) {
+        void *argument = (char *) arguments + size * i;
+        if (jobs == nullptr || !jobs_submit(jobs, function, argument, &counter)) {
+            function(argument);
+        }
+    }
+    if (jobs != nullptr) {
+        jobs_counter_wait(jobs, &counter);
+    }
+}
+
+/// @param[in] view_projection
+/// @param[in] position
+/// @param[out] clip
+static void occlusion_transform(
+    const float view_projection[16], const float position[3], float clip[4]
+) {
+    for (size_t r = 0; r < 4; r++) {
+        clip[r] = view_projection[r] * position[0] +
+            view_projection[4 + r] * position[1] +
+            view_projection[8 + r] * position[2] +
+            view_projection[12 + r];
+    }
+}
+
+/// @param[in] vertex In clip space
+/// @param[in] plane Near plane, then the left, right, top and bottom planes of
+/// the guard band
+/// @return Distance to the plane, negative outside of it
+static float occlusion_plane_distance(const float vertex[4], size_t plane) {
+    switch (plane) {
+    case 0:
+        return vertex[2];
+    case 1:
+        return OCCLUSION_GUARD_BAND * vertex[3] + vertex[0];
+    case 2:
+        return OCCLUSION_GUARD_BAND * vertex[3] - vertex[0];
+    case 3:
+        return OCCLUSION_GUARD_BAND * vertex[3] + vertex[1];
+    default:
+        return OCCLUSION_GUARD_BAND * vertex[3] - vertex[1];
+    }
+}
+
+/// Clips a polygon in clip space against one plane
+/// @param[in] polygon
+/// @param[in] count Vertices of `polygon`
+/// @param[in] plane
+/// @param[out] clipped
+/// @return Vertices of `clipped`
+static size_t occlusion_clip_plane(
+    const float polygon[][4], size_t count, size_t plane, float clipped[][4]
+) {
+    size_t clipped_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        const float *from = polygon[i];
+        const float *to = polygon[(i + 1) % count];
+        float from_distance = occlusion_plane_distance(from, plane);
+        float to_distance = occlusion_plane_distance(to, plane);
+        if (from_distance >= 0.0f) {
+            memcpy(clipped[clipped_count++], from, sizeof(float) * 4);
+        }
+        if ((from_distance >= 0.0f) != (to_distance >= 0.0f)) {
+            float t = from_distance / (from_distance - to_distance);
+            for (size_t c = 0; c < 4; c++) {
+                clipped[clipped_count][c] = from[c] + t * (to[c] - from[c]);
+            }
+            clipped_count++;
+        }
+    }
+
+    return clipped_count;
+}
+
+/// Sets up a triangle in clip space that is inside every clip plane
+/// @param[in] occlusion
+/// @param[in] clip
+/// @param[out] triangle
+/// @return Whether the triangle covers any pixel center
+static bool occlusion_triangle_setup(
+    const struct occlusion *occlusion,
+    const float clip[3][4],
+    struct occlusion_triangle *triangle
+) {
+    float x[3];
+    float y[3];
+    float z[3];
+    for (size_t i = 0; i < 3; i++) {
+        if (!(clip[i][3] > 0.0f)) {
+            return false;
+        }
+        x[i] = (clip[i][0] / clip[i][3] * 0.5f + 0.5f) * (float) occlusion->width;
+        y[i] = (clip[i][1] / clip[i][3] * 0.5f + 0.5f) * (float) occlusion->height;
+        z[i] = clip[i][2] / clip[i][3];
+    }
+
+    // Both windings are drawn, with the corners swapped to make the area
+    // positive
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (!(area != 0.0f)) {
+        return false;
+    }
+    if (area < 0.0f) {
+        float swap = x[1];
+        x[1] = x[2];
+        x[2] = swap;
+        swap = y[1];
+        y[1] = y[2];
+        y[2] = swap;
+        swap = z[1];
+        z[1] = z[2];
+        z[2] = swap;
+        area = -area;
+    }
+
+    float min_x = x[0] < x[1] ? x[0] : x[1];
+    float max_x = x[0] > x[1] ? x[0] : x[1];
+    float min_y = y[0] < y[1] ? y[0] : y[1];
+    float max_y = y[0] > y[1] ? y[0] : y[1];
+    min_x = min_x < x[2] ? min_x : x[2];
+    max_x = max_x > x[2] ? max_x : x[2];
+    min_y = min_y < y[2] ? min_y : y[2];
+    max_y = max_y > y[2] ? max_y : y[2];
+
+    // Pixels whose centers are inside the bounds
+    float pixel_min_x = ceilf(min_x - 0.5f);
+    float pixel_max_x = floorf(max_x - 0.5f);
+    float pixel_min_y = ceilf(min_y - 0.5f);
+    float pixel_max_y = floorf(max_y - 0.5f);
+    pixel_min_x = pixel_min_x > 0.0f ? pixel_min_x : 0.0f;
+    pixel_min_y = pixel_min_y > 0.0f ? pixel_min_y : 0.0f;
+    pixel_max_x = pixel_max_x < (float) (occlusion->width - 1)
+        ? pixel_max_x
+        : (float) (occlusion->width - 1);
+    pixel_max_y = pixel_max_y < (float) (occlusion->height - 1)
+        ? pixel_max_y
+        : (float) (occlusion->height - 1);
+    if (pixel_min_x > pixel_max_x || pixel_min_y > pixel_max_y) {
+        return false;
+    }
+    triangle->tiles_min[0] = (uint16_t) ((uint32_t) pixel_min_x / OCCLUSION_TILE_WIDTH);
+    triangle->tiles_min[1] = (uint16_t) ((uint32_t) pixel_min_y / OCCLUSION_TILE_HEIGHT);
+    triangle->tiles_max[0] = (uint16_t) ((uint32_t) pixel_max_x / OCCLUSION_TILE_WIDTH);
+    triangle->tiles_max[1] = (uint16_t) ((uint32_t) pixel_max_y / OCCLUSION_TILE_HEIGHT);
+
+    for (size_t i = 0; i < 3; i++) {
+        size_t j = (i + 1) % 3;
+        float a = y[i] - y[j];
+        float b = x[j] - x[i];
+        triangle->edges[i][0] = a;
+        triangle->edges[i][1] = b;
+        triangle->edges[i][2] = -(a * x[i] + b * y[i]);
+    }
+
+    float depth_x = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) /
+        area;
+    float depth_y = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) /
+        area;
+    triangle->depth[0] = depth_x;
+    triangle->depth[1] = depth_y;
+    triangle->depth[2] = z[0] - depth_x * x[0] - depth_y * y[0];
+    triangle->depth_min = z[0] < z[1] ? z[0] : z[1];
+    triangle->depth_min = triangle->depth_min < z[2] ? triangle->depth_min : z[2];
+    triangle->depth_max = z[0] > z[1] ? z[0] : z[1];
+    triangle->depth_max = triangle->depth_max > z[2] ? triangle->depth_max : z[2];
+
+    return true;
+}
+
+/// @param[in,out] argument `struct occlusion_setup`
+static void occlusion_setup_run(void *argument) {
+    struct occlusion_setup *setup = argument;
+    const struct occlusion *occlusion = setup->occlusion;
+    size_t bins_count = (size_t) occlusion->bins_x * occlusion->bins_y;
+
+    memset(setup->bin_counts, 0, sizeof(setup->bin_counts[0]) * bins_count);
+    setup->triangles_count = 0;
+    for (size_t t = setup->first; t < setup->first + setup->count; t++) {
+        float polygon[OCCLUSION_CLIP_VERTICES][4];
+        for (size_t i = 0; i < 3; i++) {
+            occlusion_transform(
+                setup->view_projection,
+                &setup->positions[3 * (size_t) setup->indices[3 * t + i]],
+                polygon[i]
+            );
+        }
+
+        // Most triangles are inside every plane or outside the same one, and
+        // are left as they are
+        uint32_t outside_any = 0;
+        uint32_t outside_all = (1 << OCCLUSION_CLIP_PLANES) - 1;
+        for (size_t i = 0; i < 3; i++) {
+            uint32_t outside = 0;
+            for (size_t plane = 0; plane < OCCLUSION_CLIP_PLANES; plane++) {
+                float distance = occlusion_plane_distance(polygon[i], plane);
+                outside |= (uint32_t) (distance < 0.0f) << plane;
+            }
+            outside_any |= outside;
+            outside_all &= outside;
+        }
+        if (outside_all != 0) {
+            continue;
+        }
+
+        size_t count = 3;
+        for (size_t plane = 0; plane < OCCLUSION_CLIP_PLANES; plane++) {
+            if ((outside_any & (1 << plane)) == 0) {
+                continue;
+            }
+            float clipped[OCCLUSION_CLIP_VERTICES][4];
+            count = occlusion_clip_plane(polygon, count, plane, clipped);
+            memcpy(polygon, clipped, sizeof(clipped[0]) * count);
+        }
+
+        for (size_t i = 2; i < count; i++) {
+            float fan[3][4];
+            memcpy(fan[0], polygon[0], sizeof(fan[0]));
+            memcpy(fan[1], polygon[i - 1], sizeof(fan[1]));
+            memcpy(fan[2], polygon[i], sizeof(fan[2]));
+            struct occlusion_triangle *triangle = (
+                &setup->triangles[setup->triangles_count]
+            );
+            if (!occlusion_triangle_setup(occlusion, fan, triangle)) {
+                continue;
+            }
+            setup->triangles_count++;
+
+            for (
+                uint32_t bin_y = triangle->tiles_min[1] / OCCLUSION_BIN_TILES;
+                bin_y <= triangle->tiles_max[1] / OCCLUSION_BIN_TILES;
+                bin_y++
+            ) {
+                for (
+                    uint32_t bin_x = triangle->tiles_min[0] / OCCLUSION_BIN_TILES;
+                    bin_x <= triangle->tiles_max[0] / OCCLUSION_BIN_TILES;
+                    bin_x++
+                ) {
+                    setup->bin_counts[bin_y * occlusion->bins_x + bin_x]++;
+                }
+            }
+        }
+    }
+}
+
+/// Writes the triangles of a range into the bins they touch
+/// @param[in,out] argument `struct occlusion_setup`
+static void occlusion_setup_bin(void *argument) {
+    struct occlusion_setup *setup = argument;
+    struct occlusion *occlusion = setup->occlusion;
+
+    uint32_t first = (uint32_t) (setup->triangles - occlusion->triangles);
+    for (size_t i = 0; i < setup->triangles_count; i++) {
+        const struct occlusion_triangle *triangle = &setup->triangles[i];
+        for (
+            uint32_t bin_y = triangle->tiles_min[1] / OCCLUSION_BIN_TILES;
+            bin_y <= triangle->tiles_max[1] / OCCLUSION_BIN_TILES;
+            bin_y++
+        ) {
+            for (
+                uint32_t bin_x = triangle->tiles_min[0] / OCCLUSION_BIN_TILES;
+                bin_x <= triangle->tiles_max[0] / OCCLUSION_BIN_TILES;
+                bin_x++
+            ) {
+                size_t *next = &setup->bin_counts[bin_y * occlusion->bins_x + bin_x];
+                occlusion->references[(*next)++] = first + (uint32_t) i;
+            }
+        }
+    }
+}
+
+/// Rasterizes a triangle into the pixels of one tile
+/// @param[in] triangle
+/// @param[in] tile_x
+/// @param[in] tile_y
+/// @param[in,out] depths Of the tile
+/// @return Farthest depth in the tile
+static float occlusion_tile_scalar(
+    const struct occlusion_triangle *triangle,
+    uint32_t tile_x,
+    uint32_t tile_y,
+    float *depths
+) {
+    float farthest = -INFINITY;
+    for (uint32_t row = 0; row < OCCLUSION_TILE_HEIGHT; row++) {
+        float y = (float) (tile_y * OCCLUSION_TILE_HEIGHT + row) + 0.5f;
+        float edge_rows[3];
+        for (size_t e = 0; e < 3; e++) {
+            edge_rows[e] = triangle->edges[e][1] * y + triangle->edges[e][2];
+        }
+        float depth_row = triangle->depth[1] * y + triangle->depth[2];
+
+        for (uint32_t lane = 0; lane < OCCLUSION_TILE_WIDTH; lane++) {
+            float x = (float) (tile_x * OCCLUSION_TILE_WIDTH + lane) + 0.5f;
+            bool inside = true;
+            for (size_t e = 0; e < 3; e++) {
+                inside = inside && triangle->edges[e][0] * x + edge_rows[e] >= 0.0f;
+            }
+            float depth = triangle->depth[0] * x + depth_row;
+            depth = depth > triangle->depth_min ? depth : triangle->depth_min;
+            depth = depth < triangle->depth_max ? depth : triangle->depth_max;
+
+            float *pixel = &depths[row * OCCLUSION_TILE_WIDTH + lane];
+            if (inside && depth < *pixel) {
+                *pixel = depth;
+            }
+            farthest = farthest > *pixel ? farthest : *pixel;
+        }
+    }
+
+    return farthest;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/// `occlusion_tile_scalar` a row at a time
+/// @param[in] triangle
+/// @param[in] tile_x
+/// @param[in] tile_y
+/// @param[in,out] depths Of the tile, 32 byte aligned
+/// @return Farthest depth in the tile
+__attribute__((target("avx2")))
+static float occlusion_tile_avx2(
+    const struct occlusion_triangle *triangle,
+    uint32_t tile_x,
+    uint32_t tile_y,
+    float *depths
+) {
+    __m256 x = _mm256_add_ps(
+        _mm256_set1_ps((float) (tile_x * OCCLUSION_TILE_WIDTH)),
+        _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f)
+    );
+    __m256 edges_x[3];
+    for (size_t e = 0; e < 3; e++) {
+        edges_x[e] = _mm256_mul_ps(_mm256_set1_ps(triangle->edges[e][0]), x);
+    }
+    __m256 depth_x = _mm256_mul_ps(_mm256_set1_ps(triangle->depth[0]), x);
+    __m256 depth_min = _mm256_set1_ps(triangle->depth_min);
+    __m256 depth_max = _mm256_set1_ps(triangle->depth_max);
+    __m256 zero = _mm256_setzero_ps();
+
+    __m256 farthest = _mm256_set1_ps(-INFINITY);
+    for (uint32_t row = 0; row < OCCLUSION_TILE_HEIGHT; row++) {
+        float y = (float) (tile_y * OCCLUSION_TILE_HEIGHT + row) + 0.5f;
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (size_t e = 0; e < 3; e++) {
+            float edge_row = triangle->edges[e][1] * y + triangle->edges[e][2];
+            __m256 edge = _mm256_add_ps(edges_x[e], _mm256_set1_ps(edge_row));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(edge, zero, _CMP_GE_OQ));
+        }
+        __m256 depth = _mm256_add_ps(
+            depth_x, _mm256_set1_ps(triangle->depth[1] * y + triangle->depth[2])
+        );
+        depth = _mm256_min_ps(_mm256_max_ps(depth, depth_min), depth_max);
+
+        float *row_depths = &depths[row * OCCLUSION_TILE_WIDTH];
+        __m256 pixels = _mm256_load_ps(row_depths);
+        __m256 nearer = _mm256_and_ps(inside, _mm256_cmp_ps(depth, pixels, _CMP_LT_OQ));
+        pixels = _mm256_blendv_ps(pixels, depth, nearer);
+        _mm256_store_ps(row_depths, pixels);
+        farthest = _mm256_max_ps(farthest, pixels);
+    }
+
+    __m128 half = _mm_max_ps(
+        _mm256_castps256_ps128(farthest), _mm256_extractf128_ps(farthest, 1)
+    );
+    half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half);
+}
+
+#endif
+
+/// Whether an edge function is negative at every pixel center of a tile, which
+/// it is when it is at the corner it is largest at
+/// @param[in] edge
+/// @param[in] tile_x
+/// @param[in] tile_y
+/// @return Whether the tile is outside of the edge
+static bool occlusion_tile_outside(
+    const float edge[3], uint32_t tile_x, uint32_t tile_y
+) {
+    float x = (float) (tile_x * OCCLUSION_TILE_WIDTH) +
+        (edge[0] > 0.0f ? (float) OCCLUSION_TILE_WIDTH - 0.5f : 0.5f);
+    float y = (float) (tile_y * OCCLUSION_TILE_HEIGHT) +
+        (edge[1] > 0.0f ? (float) OCCLUSION_TILE_HEIGHT - 0.5f : 0.5f);
+    return edge[0] * x + (edge[1] * y + edge[2]) < 0.0f;
+}
+
+/// @param[in,out] argument `struct occlusion_bin`
+static void occlusion_bin_rasterize(void *argument) {
+    struct occlusion_bin *bin = argument;
+    struct occlusion *occlusion = bin->occlusion;
+
+    occlusion_tile_function tile_function = occlusion_tile_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+    if (occlusion->avx2) {
+        tile_function = occlusion_tile_avx2;
+    }
+#endif
+
+    uint32_t bin_min_x = bin->bin_x * OCCLUSION_BIN_TILES;
+    uint32_t bin_min_y = bin->bin_y * OCCLUSION_BIN_TILES;
+    uint32_t bin_max_x = bin_min_x + OCCLUSION_BIN_TILES - 1;
+    uint32_t bin_max_y = bin_min_y + OCCLUSION_BIN_TILES - 1;
+    for (size_t i = bin->first; i < bin->first + bin->count; i++) {
+        const struct occlusion_triangle *triangle = (
+            &occlusion->triangles[occlusion->references[i]]
+        );
+        uint32_t min_x = triangle->tiles_min[0];
+        uint32_t min_y = triangle->tiles_min[1];
+        uint32_t max_x = triangle->tiles_max[0];
+        uint32_t max_y = triangle->tiles_max[1];
+        min_x = min_x > bin_min_x ? min_x : bin_min_x;
+        min_y = min_y > bin_min_y ? min_y : bin_min_y;
+        max_x = max_x < bin_max_x ? max_x : bin_max_x;
+        max_y = max_y < bin_max_y ? max_y : bin_max_y;
+
+        for (uint32_t tile_y = min_y; tile_y <= max_y; tile_y++) {
+            for (uint32_t tile_x = min_x; tile_x <= max_x; tile_x++) {
+                // Tiles already nearer than the whole triangle, and tiles outside
+                // an edge, are left alone
+                size_t tile = (size_t) tile_y * occlusion->tiles_x + tile_x;
+                if (
+                    triangle->depth_min >= occlusion->tile_depths[tile] ||
+                    occlusion_tile_outside(triangle->edges[0], tile_x, tile_y) ||
+                    occlusion_tile_outside(triangle->edges[1], tile_x, tile_y) ||
+                    occlusion_tile_outside(triangle->edges[2], tile_x, tile_y)
+                ) {
+                    continue;
+                }
+
+                float *depths = &occlusion->depths[
+                    tile * OCCLUSION_TILE_WIDTH * OCCLUSION_TILE_HEIGHT
+                ];
+                occlusion->tile_depths[tile] = tile_function(
+                    triangle, tile_x, tile_y, depths
+                );
+            }
+        }
+    }
+}
+
+bool occlusion_render(
+    struct jobs *jobs,
+    struct occlusion *occlusion,
+    const float view_projection[16],
+    const float *positions,
+    const uint32_t *indices,
+    size_t indices_count
+) {
+    size_t triangles_count = indices_count / 3;
+    if (triangles_count == 0) {
+        return true;
+    }
+
+    bool success = false;
+    size_t jobs_count = (triangles_count + OCCLUSION_JOB_TRIANGLES - 1) /
+        OCCLUSION_JOB_TRIANGLES;
+    size_t bins_count = (size_t) occlusion->bins_x * occlusion->bins_y;
+    struct occlusion_setup *setups = malloc(sizeof(setups[0]) * jobs_count);
+    struct occlusion_bin *bins = malloc(sizeof(bins[0]) * bins_count);
+    if (setups == nullptr || bins == nullptr) {
+        fprintf(stderr, "occlusion_render: malloc failed\n");
+        goto cleanup;
+    }
+    if (
+        !occlusion_reserve(
+            (void **) &occlusion->triangles,
+            &occlusion->triangles_capacity,
+            sizeof(occlusion->triangles[0]),
+            triangles_count * OCCLUSION_CLIPPED_MAX
+        ) ||
+        !occlusion_reserve(
+            (void **) &occlusion->bin_counts,
+            &occlusion->bin_counts_capacity,
+            sizeof(occlusion->bin_counts[0]),
+            jobs_count * bins_count
+        )
+    ) {
+        fprintf(stderr, "occlusion_render: occlusion_reserve failed\n");
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < jobs_count; i++) {
+        size_t first = i * OCCLUSION_JOB_TRIANGLES;
+        setups[i] = (struct occlusion_setup) {
+            .occlusion = occlusion,
+            .view_projection = view_projection,
+            .positions = positions,
+            .indices = indices,
+            .first = first,
+            .count = triangles_count - first < OCCLUSION_JOB_TRIANGLES
+                ? triangles_count - first
+                : OCCLUSION_JOB_TRIANGLES,
+            .triangles = &occlusion->triangles[first * OCCLUSION_CLIPPED_MAX],
+            .bin_counts = &occlusion->bin_counts[i * bins_count],
+        };
+    }
+    occlusion_run(jobs, occlusion_setup_run, setups, sizeof(setups[0]), jobs_count);
+
+    // Each bin gets the triangles of every range in turn, so that they are
+    // rasterized in the order they were given
+    size_t references_count = 0;
+    for (size_t bin = 0; bin < bins_count; bin++) {
+        bins[bin] = (struct occlusion_bin) {
+            .occlusion = occlusion,
+            .bin_x = (uint32_t) (bin % occlusion->bins_x),
+            .bin_y = (uint32_t) (bin / occlusion->bins_x),
+            .first = references_count,
+        };
+        for (size_t i = 0; i < jobs_count; i++) {
+            size_t count = setups[i].bin_counts[bin];
+            setups[i].bin_counts[bin] = references_count;
+            references_count += count;
+        }
+        bins[bin].count = references_count - bins[bin].first;
+    }
+    if (!occlusion_reserve(
+        (void **) &occlusion->references,
+        &occlusion->references_capacity,
+        sizeof(occlusion->references[0]),
+        references_count
+    )) {
+        fprintf(stderr, "occlusion_render: occlusion_reserve failed\n");
+        goto cleanup;
+    }
+    occlusion_run(jobs, occlusion_setup_bin, setups, sizeof(setups[0]), jobs_count);
+
+    // Empty bins need no job
+    size_t busy_count = 0;
+    for (size_t bin = 0; bin < bins_count; bin++) {
+        if (bins[bin].count > 0) {
+            bins[busy_count++] = bins[bin];
+        }
+    }
+    occlusion_run(jobs, occlusion_bin_rasterize, bins, sizeof(bins[0]), busy_count);
+
+    success = true;
+
+cleanup:
+    free(bins);
+    free(setups);
+
+    return success;
+}
+
+/// @param[in] occlusion
+/// @param[in] view_projection
+/// @param[in] min
+/// @param[in] max
+/// @param[out] rect
+/// @return Whether every corner is in front of the camera and behind the near
+/// plane
+static bool occlusion_box_project_scalar(
+    const struct occlusion *occlusion,
+    const float view_projection[16],
+    const float min[3],
+    const float max[3],
+    struct occlusion_rect *rect
+) {
+    *rect = (struct occlusion_rect) {
+        .min_x = INFINITY,
+        .min_y = INFINITY,
+        .max_x = -INFINITY,
+        .max_y = -INFINITY,
+        .depth = INFINITY,
+    };
+    for (uint32_t corner = 0; corner < 8; corner++) {
+        const float position[3] = {
+            corner & 1 ? max[0] : min[0],
+            corner & 2 ? max[1] : min[1],
+            corner & 4 ? max[2] : min[2],
+        };
+        float clip[4];
+        occlusion_transform(view_projection, position, clip);
+        if (!(clip[2] >= 0.0f && clip[3] > 0.0f)) {
+            return false;
+        }
+
+        float inverse_w = 1.0f / clip[3];
+        float x = (clip[0] * inverse_w * 0.5f + 0.5f) * (float) occlusion->width;
+        float y = (clip[1] * inverse_w * 0.5f + 0.5f) * (float) occlusion->height;
+        float depth = clip[2] * inverse_w;
+        rect->min_x = rect->min_x < x ? rect->min_x : x;
+        rect->min_y = rect->min_y < y ? rect->min_y : y;
+        rect->max_x = rect->max_x > x ? rect->max_x : x;
+        rect->max_y = rect->max_y > y ? rect->max_y : y;
+        rect->depth = rect->depth < depth ? rect->depth : depth;
+    }
+
+    return true;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/// `occlusion_box_project_scalar` with a corner in each lane
+/// @param[in] occlusion
+/// @param[in] view_projection
+/// @param[in] min
+/// @param[in] max
+/// @param[out] rect
+/// @return Whether every corner is in front of the camera and behind the near
+/// plane
+__attribute__((target("avx2")))
+static bool occlusion_box_project_avx2(
+    const struct occlusion *occlusion,
+    const float view_projection[16],
+    const float min[3],
+    const float max[3],
+    struct occlusion_rect *rect
+) {
+    __m256 position[3] = {
+        _mm256_setr_ps(min[0], max[0], min[0], max[0], min[0], max[0], min[0], max[0]),
+        _mm256_setr_ps(min[1], min[1], max[1], max[1], min[1], min[1], max[1], max[1]),
+        _mm256_setr_ps(min[2], min[2], min[2], min[2], max[2], max[2], max[2], max[2]),
+    };
+    __m256 clip[4];
+    for (size_t r = 0; r < 4; r++) {
+        clip[r] = _mm256_add_ps(
+            _mm256_add_ps(
+                _mm256_add_ps(
+                    _mm256_mul_ps(_mm256_set1_ps(view_projection[r]), position[0]),
+                    _mm256_mul_ps(_mm256_set1_ps(view_projection[4 + r]), position[1])
+                ),
+                _mm256_mul_ps(_mm256_set1_ps(view_projection[8 + r]), position[2])
+            ),
+            _mm256_set1_ps(view_projection[12 + r])
+        );
+    }
+    __m256 zero = _mm256_setzero_ps();
+    __m256 in_front = _mm256_and_ps(
+        _mm256_cmp_ps(clip[2], zero, _CMP_GE_OQ),
+        _mm256_cmp_ps(clip[3], zero, _CMP_GT_OQ)
+    );
+    if (_mm256_movemask_ps(in_front) != 0xff) {
+        return false;
+    }
+
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 inverse_w = _mm256_div_ps(_mm256_set1_ps(1.0f), clip[3]);
+    __m256 x = _mm256_mul_ps(
+        _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(clip[0], inverse_w), half), half),
+        _mm256_set1_ps((float) occlusion->width)
+    );
+    __m256 y = _mm256_mul_ps(
+        _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(clip[1], inverse_w), half), half),
+        _mm256_set1_ps((float) occlusion->height)
+    );
+    __m256 depth = _mm256_mul_ps(clip[2], inverse_w);
+
+    // Minimums of x, y and depth and maximums of x and y across the lanes,
+    // the maximums negated so that one reduction does all five
+    __m256 values[4] = {x, y, depth, _mm256_setzero_ps()};
+    float reduced[2][4];
+    for (size_t pass = 0; pass < 2; pass++) {
+        __m128 v[4];
+        for (size_t i = 0; i < 4; i++) {
+            __m256 value = pass == 0
+                ? values[i]
+                : _mm256_sub_ps(_mm256_setzero_ps(), values[i]);
+            v[i] = _mm_min_ps(
+                _mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1)
+            );
+        }
+        _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+        __m128 m = _mm_min_ps(_mm_min_ps(v[0], v[1]), _mm_min_ps(v[2], v[3]));
+        _mm_storeu_ps(reduced[pass], m);
+    }
+    *rect = (struct occlusion_rect) {
+        .min_x = reduced[0][0],
+        .min_y = reduced[0][1],
+        .max_x = -reduced[1][0],
+        .max_y = -reduced[1][1],
+        .depth = reduced[0][2],
+    };
+
+    return true;
+}
+
+#endif
+
+bool occlusion_box_visible(
+    const struct occlusion *occlusion,
+    const float view_projection[16],
+    const float min[3],
+    const float max[3]
+) {
+    occlusion_project_function project = occlusion_box_project_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+    if (occlusion->avx2) {
+        project = occlusion_box_project_avx2;
+    }
+#endif
+    struct occlusion_rect rect;
+    if (!project(occlusion, view_projection, min, max, &rect)) {
+        return true;
+    }
+
+    if (
+        rect.max_x < 0.0f ||
+        rect.max_y < 0.0f ||
+        rect.min_x >= (float) occlusion->width ||
+        rect.min_y >= (float) occlusion->height
+    ) {
+        return false;
+    }
+
+    // Every tile of a pixel the rectangle is in or next to, since occluders
+    // cover whole pixels whose centers they cover and a box may show past their
+    // edges within such a pixel
+    float min_x = rect.min_x - 1.0f;
+    float min_y = rect.min_y - 1.0f;
+    float max_x = rect.max_x + 1.0f;
+    float max_y = rect.max_y + 1.0f;
+    uint32_t pixel_min_x = min_x > 0.0f ? (uint32_t) min_x : 0;
+    uint32_t pixel_min_y = min_y > 0.0f ? (uint32_t) min_y : 0;
+    uint32_t pixel_max_x = max_x < (float) (occlusion->width - 1)
+        ? (uint32_t) max_x
+        : occlusion->width - 1;
+    uint32_t pixel_max_y = max_y < (float) (occlusion->height - 1)
+        ? (uint32_t) max_y
+        : occlusion->height - 1;
+    for (
+        uint32_t tile_y = pixel_min_y / OCCLUSION_TILE_HEIGHT;
+        tile_y <= pixel_max_y / OCCLUSION_TILE_HEIGHT;
+        tile_y++
+    ) {
+        const float *tile_depths = &occlusion->tile_depths[
+            (size_t) tile_y * occlusion->tiles_x
+        ];
+        for (
+            uint32_t tile_x = pixel_min_x / OCCLUSION_TILE_WIDTH;
+            tile_x <= pixel_max_x / OCCLUSION_TILE_WIDTH;
+            tile_x++
+        ) {
+            if (rect.depth <= tile_depths[tile_x]) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/// @param[in,out] argument `struct occlusion_range`
+static void occlusion_range_test(void *argument) {
+    struct occlusion_range *range = argument;
+    const struct cull_objects *objects = range->objects;
+
+    range->visible_count = 0;
+    for (size_t i = 0; i < range->count; i++) {
+        uint32_t index = range->visible[i];
+        const float center[3] = {
+            objects->center_x[index], objects->center_y[index], objects->center_z[index]
+        };
+        const float extent[3] = {
+            objects->extent_x[index], objects->extent_y[index], objects->extent_z[index]
+        };
+        float radius = objects->radius[index];
+
+        float min[3];
+        float max[3];
+        for (size_t c = 0; c < 3; c++) {
+            float half = extent[c] < radius ? extent[c] : radius;
+            min[c] = center[c] - half;
+            max[c] = center[c] + half;
+        }
+        if (occlusion_box_visible(range->occlusion, range->view_projection, min, max)) {
+            range->visible[range->visible_count++] = index;
+        }
+    }
+}
+
+bool occlusion_objects_test(
+    struct jobs *jobs,
+    const struct occlusion *occlusion,
+    const float view_projection[16],
+    const struct cull_objects *objects,
+    uint32_t *visible,
+    size_t *visible_count
+) {
+    size_t count = *visible_count;
+    size_t jobs_count = (count + OCCLUSION_JOB_OBJECTS - 1) / OCCLUSION_JOB_OBJECTS;
+    if (jobs == nullptr || jobs_count <= 1) {
+        struct occlusion_range range = {
+            .occlusion = occlusion,
+            .view_projection = view_projection,
+            .objects = objects,
+            .visible = visible,
+            .count = count,
+        };
+        occlusion_range_test(&range);
+        *visible_count = range.visible_count;
+        return true;
+    }
+
+    struct occlusion_range *ranges = malloc(sizeof(ranges[0]) * jobs_count);
+    if (ranges == nullptr) {
+        fprintf(stderr, "occlusion_objects_test: malloc failed\n");
+        return false;
+    }
+    for (size_t i = 0; i < jobs_count; i++) {
+        size_t first = i * OCCLUSION_JOB_OBJECTS;
+        ranges[i] = (struct occlusion_range) {
+            .occlusion = occlusion,
+            .view_projection = view_projection,
+            .objects = objects,
+            .visible = &visible[first],
+            .count = count - first < OCCLUSION_JOB_OBJECTS
+                ? count - first
+                : OCCLUSION_JOB_OBJECTS,
+        };
+    }
+    occlusion_run(jobs, occlusion_range_test, ranges, sizeof(ranges[0]), jobs_count);
+
+    // Every range kept its objects from its own first entry on, close the gaps
+    *visible_count = 0;
+    for (size_t i = 0; i < jobs_count; i++) {
+        memmove(
+            &visible[*visible_count],
+            ranges[i].visible,
+            sizeof(visible[0]) * ranges[i].visible_count
+        );
+        *visible_count += ranges[i].visible_count;
+    }
+    free(ranges);
+
+    return true;
+}
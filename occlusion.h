@@ -0,0 +1,118 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cull.h"
+#include "jobs.h"
+
+/// Pixels of a tile, each row of which is one AVX2 register
+constexpr uint32_t OCCLUSION_TILE_WIDTH = 8;
+constexpr uint32_t OCCLUSION_TILE_HEIGHT = 4;
+/// Tiles of a bin along each axis, bins are rasterized in parallel
+constexpr uint32_t OCCLUSION_BIN_TILES = 8;
+
+/// Triangle of an occluder set up for rasterization, private to `occlusion.c`
+struct occlusion_triangle;
+
+/// Low resolution depth buffer occluders are rasterized into on the CPU, and a
+/// level above it with the farthest depth of each tile that bounds are tested
+/// against. Depth goes from zero at the near plane to one at the far plane.
+struct occlusion {
+    /// Multiples of the tile size
+    uint32_t width;
+    uint32_t height;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    uint32_t bins_x;
+    uint32_t bins_y;
+    /// Depth of every pixel, tile after tile and row after row within a tile
+    float *depths;
+    /// Farthest depth in each tile
+    float *tile_depths;
+    /// Rasterize and test with AVX2, set where the processor supports it and
+    /// may be cleared to compare against the scalar code
+    bool avx2;
+
+    struct occlusion_triangle *triangles;
+    size_t triangles_capacity;
+    /// Triangles of each bin, bin after bin
+    uint32_t *references;
+    size_t references_capacity;
+    /// Triangles each job adds to each bin, and where the job writes them
+    size_t *bin_counts;
+    size_t bin_counts_capacity;
+};
+
+/// @param[in] width Rounded up to a multiple of the tile width
+/// @param[in] height Rounded up to a multiple of the tile height
+/// @param[out] occlusion Cleared
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `occlusion_destroy` after successful return
+bool occlusion_create(uint32_t width, uint32_t height, struct occlusion *occlusion);
+
+/// @param[in,out] occlusion
+/// @note `occlusion` will be invalid after this function has been called
+void occlusion_destroy(struct occlusion *occlusion);
+
+/// Sets every pixel to the far plane
+/// @param[in,out] occlusion
+void occlusion_clear(struct occlusion *occlusion);
+
+/// Rasterizes triangles into the depth buffer, keeping the nearer depth. Both
+/// windings are drawn and triangles are clipped to the near plane. Triangles
+/// are set up and binned by ranges in parallel, then every bin is rasterized
+/// by a job of its own.
+/// @param[in,out] jobs May be `nullptr`
+/// @param[in,out] occlusion
+/// @param[in] view_projection Column major, with depth from zero to one
+/// @param[in] positions Three floats per vertex
+/// @param[in] indices Three per triangle
+/// @param[in] indices_count
+/// @return `true` on success and `false` otherwise
+bool occlusion_render(
+    struct jobs *jobs,
+    struct occlusion *occlusion,
+    const float view_projection[16],
+    const float *positions,
+    const uint32_t *indices,
+    size_t indices_count
+);
+
+/// Tests whether any tile a box covers on screen has a farther depth than the
+/// nearest point of the box. Boxes reaching in front of the near plane are
+/// visible, and boxes entirely off screen are not.
+/// @param[in] occlusion
+/// @param[in] view_projection The occluders were rendered with
+/// @param[in] min
+/// @param[in] max
+/// @return Whether the box may be visible
+bool occlusion_box_visible(
+    const struct occlusion *occlusion,
+    const float view_projection[16],
+    const float min[3],
+    const float max[3]
+);
+
+/// Removes the objects hidden behind occluders from a list, testing the box
+/// where it meets the box around the sphere of each. Ranges of objects are
+/// tested in parallel when there are many.
+/// @param[in,out] jobs May be `nullptr`
+/// @param[in] occlusion
+/// @param[in] view_projection The occluders were rendered with
+/// @param[in] objects
+/// @param[in,out] visible Indices of objects, e.g. from `cull_objects_test`,
+/// of which the ones that may be visible are kept in the same order
+/// @param[in,out] visible_count
+/// @return `true` on success and `false` otherwise
+bool occlusion_objects_test(
+    struct jobs *jobs,
+    const struct occlusion *occlusion,
+    const float view_projection[16],
+    const struct cull_objects *objects,
+    uint32_t *visible,
+    size_t *visible_count
+);
+
+#endif
@@ -0,0 +1,454 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+#include "pipeline.h"
+
+void pipeline_program_hash(struct pipeline_program *program) {
+    uint64_t hash = HASH_SEED;
+    hash = hash_bytes(program->vertex_code, program->vertex_code_size, hash);
+    hash = hash_bytes(program->fragment_code, program->fragment_code_size, hash);
+
+    program->hash = hash;
+}
+
+void pipeline_program_destroy(VkDevice device, struct pipeline_program *program) {
+    vkDestroyShaderModule(device, program->fragment_shadermodule, nullptr);
+    vkDestroyShaderModule(device, program->vertex_shadermodule, nullptr);
+    free(program->fragment_code);
+    free(program->vertex_code);
+
+    *program = (struct pipeline_program){};
+}
+
+/// @param[in] topology
+/// @return First topology of the class `topology` belongs to
+static VkPrimitiveTopology pipeline_topology_class(VkPrimitiveTopology topology) {
+    switch (topology) {
+    case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+        return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+        return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+    case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+        return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+    default:
+        return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    }
+}
+
+void pipeline_state_dynamic_set(struct pipeline_state *state, uint32_t dynamic) {
+    state->dynamic = dynamic;
+
+    if (dynamic & PIPELINE_DYNAMIC_TOPOLOGY) {
+        state->topology = pipeline_topology_class(state->topology);
+    }
+    if (dynamic & PIPELINE_DYNAMIC_CULL_MODE) {
+        state->cull_mode = VK_CULL_MODE_NONE;
+    }
+    if (dynamic & PIPELINE_DYNAMIC_FRONT_FACE) {
+        state->front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    }
+    if (dynamic & PIPELINE_DYNAMIC_POLYGON_MODE) {
+        state->polygon_mode = VK_POLYGON_MODE_FILL;
+    }
+    if (dynamic & PIPELINE_DYNAMIC_BLEND_ENABLE) {
+        state->blend_enable = VK_FALSE;
+    }
+}
+
+uint64_t pipeline_variant_hash(const struct pipeline_variant *variant) {
+    uint64_t program_hash = variant->program != nullptr ? variant->program->hash : 0;
+
+    uint64_t hash = HASH_SEED;
+    hash = hash_bytes(&program_hash, sizeof(program_hash), hash);
+    hash = hash_bytes(
+        &variant->constants.count, sizeof(variant->constants.count), hash
+    );
+    hash = hash_bytes(
+        variant->constants.values,
+        sizeof(variant->constants.values[0]) * variant->constants.count,
+        hash
+    );
+    hash = hash_bytes(&variant->state, sizeof(variant->state), hash);
+
+    return hash;
+}
+
+bool pipeline_variant_equal(
+    const struct pipeline_variant *lhs, const struct pipeline_variant *rhs
+) {
+    if (lhs->program == nullptr || rhs->program == nullptr) {
+        if (lhs->program != rhs->program) {
+            return false;
+        }
+    } else if (
+        lhs->program->hash != rhs->program->hash ||
+        lhs->program->layout != rhs->program->layout
+    ) {
+        return false;
+    }
+
+    return (
+        lhs->constants.count == rhs->constants.count &&
+        memcmp(
+            lhs->constants.values,
+            rhs->constants.values,
+            sizeof(lhs->constants.values[0]) * lhs->constants.count
+        ) == 0 &&
+        memcmp(&lhs->state, &rhs->state, sizeof(lhs->state)) == 0
+    );
+}
+
+void pipeline_specialization_init(
+    struct pipeline_specialization *specialization,
+    const struct pipeline_constants *constants
+) {
+    memcpy(
+        specialization->constants,
+        constants->values,
+        sizeof(specialization->constants[0]) * constants->count
+    );
+    for (uint32_t i = 0; i < constants->count; i++) {
+        specialization->map_entries[i] = (VkSpecializationMapEntry){
+            .constantID = i,
+            .offset = sizeof(specialization->constants[0]) * i,
+            .size = sizeof(specialization->constants[0]),
+        };
+    }
+
+    specialization->info = (VkSpecializationInfo){
+        .pMapEntries = specialization->map_entries,
+        .mapEntryCount = constants->count,
+        .pData = specialization->constants,
+        .dataSize = sizeof(specialization->constants[0]) * constants->count,
+    };
+}
+
+void pipeline_createinfo_init(
+    struct pipeline_createinfo *createinfo,
+    VkRenderPass render_pass,
+    const struct pipeline_variant *variant
+) {
+    const struct pipeline_program *program = variant->program;
+    const struct pipeline_state *state = &variant->state;
+
+    // Both stages share the same constants, entries a stage does not declare
+    // are ignored by the implementation.
+    pipeline_specialization_init(&createinfo->specialization, &variant->constants);
+
+    // Keys of libraries without shaders carry no program
+    VkShaderModule vertex_shadermodule = VK_NULL_HANDLE;
+    VkShaderModule fragment_shadermodule = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    if (program != nullptr) {
+        vertex_shadermodule = program->vertex_shadermodule;
+        fragment_shadermodule = program->fragment_shadermodule;
+        layout = program->layout;
+    }
+
+    createinfo->stages[0] = (VkPipelineShaderStageCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .stage = VK_SHADER_STAGE_VERTEX_BIT,
+        .module = vertex_shadermodule,
+        .pName = "main",
+        .pSpecializationInfo = &createinfo->specialization.info,
+    };
+    createinfo->stages[1] = (VkPipelineShaderStageCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+        .module = fragment_shadermodule,
+        .pName = "main",
+        .pSpecializationInfo = &createinfo->specialization.info,
+    };
+
+    uint32_t dynamic_states_count = 0;
+    createinfo->dynamic_states[dynamic_states_count++] = VK_DYNAMIC_STATE_VIEWPORT;
+    createinfo->dynamic_states[dynamic_states_count++] = VK_DYNAMIC_STATE_SCISSOR;
+    if (state->dynamic & PIPELINE_DYNAMIC_TOPOLOGY) {
+        createinfo->dynamic_states[dynamic_states_count++] = (
+            VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT
+        );
+    }
+    if (state->dynamic & PIPELINE_DYNAMIC_CULL_MODE) {
+        createinfo->dynamic_states[dynamic_states_count++] = (
+            VK_DYNAMIC_STATE_CULL_MODE_EXT
+        );
+    }
+    if (state->dynamic & PIPELINE_DYNAMIC_FRONT_FACE) {
+        createinfo->dynamic_states[dynamic_states_count++] = (
+            VK_DYNAMIC_STATE_FRONT_FACE_EXT
+        );
+    }
+    if (state->dynamic & PIPELINE_DYNAMIC_POLYGON_MODE) {
+        createinfo->dynamic_states[dynamic_states_count++] = (
+            VK_DYNAMIC_STATE_POLYGON_MODE_EXT
+        );
+    }
+    if (state->dynamic & PIPELINE_DYNAMIC_BLEND_ENABLE) {
+        createinfo->dynamic_states[dynamic_states_count++] = (
+            VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT
+        );
+    }
+
+    createinfo->dynamic_state = (VkPipelineDynamicStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .pDynamicStates = createinfo->dynamic_states,
+        .dynamicStateCount = dynamic_states_count,
+    };
+
+    uint32_t vertex_attributes_count = vertexformat_input(
+        state->vertexformat, &createinfo->vertex_binding, createinfo->vertex_attributes
+    );
+
+    createinfo->vertex_input = (VkPipelineVertexInputStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .pVertexBindingDescriptions = &createinfo->vertex_binding,
+        .vertexBindingDescriptionCount = vertex_attributes_count > 0 ? 1 : 0,
+        .pVertexAttributeDescriptions = createinfo->vertex_attributes,
+        .vertexAttributeDescriptionCount = vertex_attributes_count,
+    };
+
+    createinfo->input_assembly = (VkPipelineInputAssemblyStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = state->topology,
+        .primitiveRestartEnable = VK_FALSE,
+    };
+
+    createinfo->viewport = (VkPipelineViewportStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+
+    createinfo->rasterization = (VkPipelineRasterizationStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .depthClampEnable = VK_FALSE,
+        .rasterizerDiscardEnable = VK_FALSE,
+        .polygonMode = state->polygon_mode,
+        .lineWidth = 1.0f,
+        .cullMode = state->cull_mode,
+        .frontFace = state->front_face,
+        .depthBiasEnable = VK_FALSE,
+        .depthBiasConstantFactor = 0.0f,
+        .depthBiasClamp = 0.0f,
+        .depthBiasSlopeFactor = 0.0f,
+    };
+
+    createinfo->multisample = (VkPipelineMultisampleStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .sampleShadingEnable = VK_FALSE,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .minSampleShading = 1.0f,
+        .pSampleMask = nullptr,
+        .alphaToCoverageEnable = VK_FALSE,
+        .alphaToOneEnable = VK_FALSE,
+    };
+
+    createinfo->color_blend_attachment = (VkPipelineColorBlendAttachmentState){
+        .colorWriteMask = (
+            VK_COLOR_COMPONENT_R_BIT |
+            VK_COLOR_COMPONENT_G_BIT |
+            VK_COLOR_COMPONENT_B_BIT |
+            VK_COLOR_COMPONENT_A_BIT
+        ),
+        .blendEnable = state->blend_enable,
+        .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+        .colorBlendOp = VK_BLEND_OP_ADD,
+        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .alphaBlendOp = VK_BLEND_OP_ADD,
+    };
+
+    createinfo->color_blend = (VkPipelineColorBlendStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .logicOpEnable = VK_FALSE,
+        .logicOp = VK_LOGIC_OP_COPY,
+        .pAttachments = &createinfo->color_blend_attachment,
+        .attachmentCount = 1,
+        .blendConstants = {
+            0.0f,
+            0.0f,
+            0.0f,
+            0.0f,
+        },
+    };
+
+    createinfo->info = (VkGraphicsPipelineCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .flags = state->flags,
+        .pStages = createinfo->stages,
+        .stageCount = 2,
+        .pVertexInputState = &createinfo->vertex_input,
+        .pInputAssemblyState = &createinfo->input_assembly,
+        .pViewportState = &createinfo->viewport,
+        .pRasterizationState = &createinfo->rasterization,
+        .pMultisampleState = &createinfo->multisample,
+        .pDepthStencilState = nullptr,
+        .pColorBlendState = &createinfo->color_blend,
+        .pDynamicState = &createinfo->dynamic_state,
+        .layout = layout,
+        .renderPass = render_pass,
+        .subpass = 0,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+}
+
+bool pipeline_create(
+    VkDevice device,
+    VkPipelineCache pipelinecache,
+    VkRenderPass render_pass,
+    const struct pipeline_variant *variant,
+    VkPipeline *pipeline
+) {
+    struct pipeline_createinfo createinfo;
+    pipeline_createinfo_init(&createinfo, render_pass, variant);
+
+    if (vkCreateGraphicsPipelines(
+        device, pipelinecache, 1, &createinfo.info, nullptr, pipeline
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "pipeline_create: vkCreateGraphicsPipelines failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+struct pipeline_variant pipeline_library_key(
+    const struct pipeline_variant *variant, enum pipeline_library library
+) {
+    struct pipeline_variant key = {
+        .state.dynamic = variant->state.dynamic,
+        .state.flags = variant->state.flags,
+    };
+
+    switch (library) {
+    case PIPELINE_LIBRARY_VERTEX_INPUT:
+        key.state.topology = variant->state.topology;
+        key.state.vertexformat = variant->state.vertexformat;
+        break;
+    case PIPELINE_LIBRARY_PRE_RASTERIZATION:
+        key.program = variant->program;
+        key.constants = variant->constants;
+        key.state.polygon_mode = variant->state.polygon_mode;
+        key.state.cull_mode = variant->state.cull_mode;
+        key.state.front_face = variant->state.front_face;
+        break;
+    case PIPELINE_LIBRARY_FRAGMENT_SHADER:
+        key.program = variant->program;
+        key.constants = variant->constants;
+        break;
+    case PIPELINE_LIBRARY_FRAGMENT_OUTPUT:
+        key.state.blend_enable = variant->state.blend_enable;
+        break;
+    case PIPELINE_LIBRARY_COUNT:
+        break;
+    }
+
+    return key;
+}
+
+bool pipeline_library_create(
+    VkDevice device,
+    VkPipelineCache pipelinecache,
+    VkRenderPass render_pass,
+    const struct pipeline_variant *key,
+    enum pipeline_library library,
+    VkPipeline *pipeline
+) {
+    static const VkGraphicsPipelineLibraryFlagsEXT library_flags[] = {
+        [PIPELINE_LIBRARY_VERTEX_INPUT] = (
+            VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT
+        ),
+        [PIPELINE_LIBRARY_PRE_RASTERIZATION] = (
+            VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT
+        ),
+        [PIPELINE_LIBRARY_FRAGMENT_SHADER] = (
+            VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT
+        ),
+        [PIPELINE_LIBRARY_FRAGMENT_OUTPUT] = (
+            VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT
+        ),
+    };
+
+    struct pipeline_createinfo createinfo;
+    pipeline_createinfo_init(&createinfo, render_pass, key);
+
+    VkGraphicsPipelineLibraryCreateInfoEXT library_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+        .flags = library_flags[library],
+    };
+
+    createinfo.info.pNext = &library_info;
+    createinfo.info.flags |= (
+        VK_PIPELINE_CREATE_LIBRARY_BIT_KHR |
+        VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT
+    );
+
+    // State belonging to the other parts is ignored, but the shader stages
+    // have to match the part exactly
+    switch (library) {
+    case PIPELINE_LIBRARY_PRE_RASTERIZATION:
+        createinfo.info.pStages = &createinfo.stages[0];
+        createinfo.info.stageCount = 1;
+        break;
+    case PIPELINE_LIBRARY_FRAGMENT_SHADER:
+        createinfo.info.pStages = &createinfo.stages[1];
+        createinfo.info.stageCount = 1;
+        break;
+    default:
+        createinfo.info.pStages = nullptr;
+        createinfo.info.stageCount = 0;
+        break;
+    }
+
+    if (vkCreateGraphicsPipelines(
+        device, pipelinecache, 1, &createinfo.info, nullptr, pipeline
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "pipeline_library_create: vkCreateGraphicsPipelines failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool pipeline_library_link(
+    VkDevice device,
+    VkPipelineCache pipelinecache,
+    VkPipelineLayout layout,
+    VkPipelineCreateFlags flags,
+    const VkPipeline libraries[PIPELINE_LIBRARY_COUNT],
+    bool optimize,
+    VkPipeline *pipeline
+) {
+    VkPipelineLibraryCreateInfoKHR library_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .pLibraries = libraries,
+        .libraryCount = PIPELINE_LIBRARY_COUNT,
+    };
+
+    VkGraphicsPipelineCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &library_info,
+        .flags = (
+            flags | (optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0)
+        ),
+        .layout = layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    if (vkCreateGraphicsPipelines(
+        device, pipelinecache, 1, &create_info, nullptr, pipeline
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "pipeline_library_link: vkCreateGraphicsPipelines failed\n");
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,225 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "spirv.h"
+#include "vertexformat.h"
+
+constexpr uint8_t PIPELINE_MAX_CONSTANTS = 8;
+constexpr uint8_t PIPELINE_MAX_DYNAMIC_STATES = 8;
+
+/// Members of `pipeline_state` that are set on the command buffer instead of
+/// being baked into the pipeline
+enum pipeline_dynamic {
+    /// `VK_EXT_extended_dynamic_state`
+    PIPELINE_DYNAMIC_TOPOLOGY = 1 << 0,
+    PIPELINE_DYNAMIC_CULL_MODE = 1 << 1,
+    PIPELINE_DYNAMIC_FRONT_FACE = 1 << 2,
+    /// `VK_EXT_extended_dynamic_state3`
+    PIPELINE_DYNAMIC_POLYGON_MODE = 1 << 3,
+    PIPELINE_DYNAMIC_BLEND_ENABLE = 1 << 4,
+};
+
+/// Vertex and fragment stage of a pipeline together with the SPIR-V they were
+/// created from, their merged interface and the layout generated from it
+struct pipeline_program {
+    uint8_t *vertex_code;
+    size_t vertex_code_size;
+    uint8_t *fragment_code;
+    size_t fragment_code_size;
+
+    VkShaderModule vertex_shadermodule;
+    VkShaderModule fragment_shadermodule;
+
+    struct spirv_reflection reflection;
+    /// Owned by the `layoutcache` it was taken from
+    VkPipelineLayout layout;
+
+    /// Hash of the SPIR-V of both stages
+    uint64_t hash;
+};
+
+/// Fixed-function state baked into a pipeline. Every field is 32 bits wide so
+/// the struct has no padding and can be hashed and compared bytewise.
+struct pipeline_state {
+    VkPrimitiveTopology topology;
+    VkPolygonMode polygon_mode;
+    VkCullModeFlags cull_mode;
+    VkFrontFace front_face;
+    VkBool32 blend_enable;
+    /// Mask of `pipeline_dynamic`
+    uint32_t dynamic;
+    enum vertexformat vertexformat;
+    /// Added to the flags of the pipeline and of each of its libraries, e.g.
+    /// `VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT`
+    VkPipelineCreateFlags flags;
+};
+
+/// Values of the specialization constants with `constant_id` in
+/// `[0, count)`. Every constant is 32 bits wide, booleans use `VkBool32`.
+struct pipeline_constants {
+    uint32_t values[PIPELINE_MAX_CONSTANTS];
+    uint32_t count;
+};
+
+/// Parts of a pipeline that `VK_EXT_graphics_pipeline_library` compiles on
+/// their own and links together afterwards
+enum pipeline_library {
+    PIPELINE_LIBRARY_VERTEX_INPUT,
+    PIPELINE_LIBRARY_PRE_RASTERIZATION,
+    PIPELINE_LIBRARY_FRAGMENT_SHADER,
+    PIPELINE_LIBRARY_FRAGMENT_OUTPUT,
+    PIPELINE_LIBRARY_COUNT,
+};
+
+/// Everything that is needed to build one pipeline
+struct pipeline_variant {
+    const struct pipeline_program *program;
+    struct pipeline_constants constants;
+    struct pipeline_state state;
+};
+
+/// @param[in,out] program
+/// @note Updates `program->hash` from the loaded SPIR-V
+void pipeline_program_hash(struct pipeline_program *program);
+
+/// @param[in] device
+/// @param[in,out] program
+/// @note `program` will be invalid after this function has been called
+void pipeline_program_destroy(VkDevice device, struct pipeline_program *program);
+
+/// @param[in,out] state
+/// @param[in] dynamic Mask of `pipeline_dynamic`
+/// @note Clears the members covered by `dynamic`, so that states which only
+/// differ in dynamic state share one pipeline. A dynamic topology is reduced to
+/// its topology class.
+void pipeline_state_dynamic_set(struct pipeline_state *state, uint32_t dynamic);
+
+/// @param[in] variant
+/// @return Hash of the SPIR-V, specialization data and pipeline state
+/// @note `variant->program` may be `nullptr` for library keys
+uint64_t pipeline_variant_hash(const struct pipeline_variant *variant);
+
+/// @param[in] lhs
+/// @param[in] rhs
+/// @return `true` if both variants build the same pipeline
+bool pipeline_variant_equal(
+    const struct pipeline_variant *lhs, const struct pipeline_variant *rhs
+);
+
+/// Storage for the `VkSpecializationInfo` of a set of constants. The members
+/// point into the struct itself, so it must not be copied or moved once
+/// initialized.
+struct pipeline_specialization {
+    uint32_t constants[PIPELINE_MAX_CONSTANTS];
+    VkSpecializationMapEntry map_entries[PIPELINE_MAX_CONSTANTS];
+    VkSpecializationInfo info;
+};
+
+/// @param[out] specialization
+/// @param[in] constants
+void pipeline_specialization_init(
+    struct pipeline_specialization *specialization,
+    const struct pipeline_constants *constants
+);
+
+/// Storage for a complete `VkGraphicsPipelineCreateInfo`. The members point
+/// into the struct itself, so it must not be copied or moved once initialized.
+struct pipeline_createinfo {
+    struct pipeline_specialization specialization;
+    VkPipelineShaderStageCreateInfo stages[2];
+
+    VkDynamicState dynamic_states[PIPELINE_MAX_DYNAMIC_STATES];
+    VkPipelineDynamicStateCreateInfo dynamic_state;
+
+    VkVertexInputBindingDescription vertex_binding;
+    VkVertexInputAttributeDescription vertex_attributes[VERTEXFORMAT_MAX_ATTRIBUTES];
+    VkPipelineVertexInputStateCreateInfo vertex_input;
+    VkPipelineInputAssemblyStateCreateInfo input_assembly;
+    VkPipelineViewportStateCreateInfo viewport;
+    VkPipelineRasterizationStateCreateInfo rasterization;
+    VkPipelineMultisampleStateCreateInfo multisample;
+    VkPipelineColorBlendAttachmentState color_blend_attachment;
+    VkPipelineColorBlendStateCreateInfo color_blend;
+
+    VkGraphicsPipelineCreateInfo info;
+};
+
+/// @param[out] createinfo
+/// @param[in] render_pass
+/// @param[in] variant
+/// @note `variant->program` must outlive every use of `createinfo->info`
+void pipeline_createinfo_init(
+    struct pipeline_createinfo *createinfo,
+    VkRenderPass render_pass,
+    const struct pipeline_variant *variant
+);
+
+/// @param[in] device
+/// @param[in] pipelinecache May be `VK_NULL_HANDLE`
+/// @param[in] render_pass
+/// @param[in] variant
+/// @param[out] pipeline
+/// @return `true` on success and `false` otherwise
+/// @note Safe to call from several threads at once
+/// @note Caller is responsible for freeing `pipeline` after successful return
+bool pipeline_create(
+    VkDevice device,
+    VkPipelineCache pipelinecache,
+    VkRenderPass render_pass,
+    const struct pipeline_variant *variant,
+    VkPipeline *pipeline
+);
+
+/// @param[in] variant
+/// @param[in] library
+/// @return `variant` with everything `library` does not consume cleared, so
+/// variants that can share the library have equal keys
+struct pipeline_variant pipeline_library_key(
+    const struct pipeline_variant *variant, enum pipeline_library library
+);
+
+/// @param[in] device
+/// @param[in] pipelinecache May be `VK_NULL_HANDLE`
+/// @param[in] render_pass
+/// @param[in] key Taken from `pipeline_library_key`
+/// @param[in] library
+/// @param[out] pipeline
+/// @return `true` on success and `false` otherwise
+/// @note Requires `VK_EXT_graphics_pipeline_library`
+/// @note Caller is responsible for freeing `pipeline` after successful return
+bool pipeline_library_create(
+    VkDevice device,
+    VkPipelineCache pipelinecache,
+    VkRenderPass render_pass,
+    const struct pipeline_variant *key,
+    enum pipeline_library library,
+    VkPipeline *pipeline
+);
+
+/// @param[in] device
+/// @param[in] pipelinecache May be `VK_NULL_HANDLE`
+/// @param[in] layout
+/// @param[in] flags `pipeline_state::flags` the libraries were created with
+/// @param[in] libraries One library of each kind
+/// @param[in] optimize Link with link time optimization, which is slow but
+/// gives a pipeline on par with `pipeline_create`
+/// @param[out] pipeline
+/// @return `true` on success and `false` otherwise
+/// @note Requires `VK_EXT_graphics_pipeline_library`
+/// @note Caller is responsible for freeing `pipeline` after successful return
+bool pipeline_library_link(
+    VkDevice device,
+    VkPipelineCache pipelinecache,
+    VkPipelineLayout layout,
+    VkPipelineCreateFlags flags,
+    const VkPipeline libraries[PIPELINE_LIBRARY_COUNT],
+    bool optimize,
+    VkPipeline *pipeline
+);
+
+#endif
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+#include "samplercache.h"
+
+void samplercache_create(VkDevice device, struct samplercache *samplercache) {
+    *samplercache = (struct samplercache){
+        .device = device,
+    };
+}
+
+void samplercache_destroy(struct samplercache *samplercache) {
+    for (size_t i = 0; i < samplercache->entries_count; i++) {
+        vkDestroySampler(
+            samplercache->device, samplercache->entries[i].sampler, nullptr
+        );
+    }
+    free(samplercache->entries);
+
+    *samplercache = (struct samplercache){};
+}
+
+bool samplercache_get(
+    struct samplercache *samplercache,
+    const struct samplercache_state *state,
+    VkSampler *sampler
+) {
+    uint64_t hash = hash_bytes(state, sizeof(*state), HASH_SEED);
+
+    for (size_t i = 0; i < samplercache->entries_count; i++) {
+        const struct samplercache_entry *entry = &samplercache->entries[i];
+        if (entry->hash == hash && memcmp(&entry->state, state, sizeof(*state)) == 0) {
+            *sampler = entry->sampler;
+            return true;
+        }
+    }
+
+    if (samplercache->entries_count == samplercache->entries_capacity) {
+        size_t capacity = samplercache->entries_capacity * 2 + 8;
+        struct samplercache_entry *entries = realloc(
+            samplercache->entries, sizeof(entries[0]) * capacity
+        );
+        if (entries == nullptr) {
+            fprintf(stderr, "samplercache_get: realloc failed\n");
+            return false;
+        }
+
+        samplercache->entries = entries;
+        samplercache->entries_capacity = capacity;
+    }
+
+    struct samplercache_entry *entry = (
+        &samplercache->entries[samplercache->entries_count]
+    );
+    *entry = (struct samplercache_entry){
+        .hash = hash,
+        .state = *state,
+    };
+
+    VkSamplerCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = state->mag_filter,
+        .minFilter = state->min_filter,
+        .mipmapMode = state->mipmap_mode,
+        .addressModeU = state->address_mode_u,
+        .addressModeV = state->address_mode_v,
+        .addressModeW = state->address_mode_w,
+        .mipLodBias = state->mip_lod_bias,
+        .anisotropyEnable = state->anisotropy_enable,
+        .maxAnisotropy = state->max_anisotropy,
+        .compareEnable = state->compare_enable,
+        .compareOp = state->compare_op,
+        .minLod = state->min_lod,
+        .maxLod = state->max_lod,
+        .borderColor = state->border_color,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+
+    if (vkCreateSampler(
+        samplercache->device, &create_info, nullptr, &entry->sampler
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "samplercache_get: vkCreateSampler failed\n");
+        return false;
+    }
+    samplercache->entries_count++;
+
+    *sampler = entry->sampler;
+
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef SAMPLERCACHE_H
+#define SAMPLERCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+/// Everything a sampler is created from. Every field is 32 bits wide so the
+/// struct has no padding and can be hashed and compared bytewise.
+struct samplercache_state {
+    VkFilter mag_filter;
+    VkFilter min_filter;
+    VkSamplerMipmapMode mipmap_mode;
+    VkSamplerAddressMode address_mode_u;
+    VkSamplerAddressMode address_mode_v;
+    VkSamplerAddressMode address_mode_w;
+    float mip_lod_bias;
+    /// Requires the `samplerAnisotropy` feature
+    VkBool32 anisotropy_enable;
+    float max_anisotropy;
+    VkBool32 compare_enable;
+    VkCompareOp compare_op;
+    float min_lod;
+    /// E.g. `VK_LOD_CLAMP_NONE` to sample every level
+    float max_lod;
+    VkBorderColor border_color;
+};
+
+struct samplercache_entry {
+    uint64_t hash;
+    struct samplercache_state state;
+
+    VkSampler sampler;
+};
+
+/// Samplers deduplicated by their state, so that textures sampled the same
+/// way share one of the few samplers a device can hold at once
+struct samplercache {
+    VkDevice device;
+
+    struct samplercache_entry *entries;
+    size_t entries_count;
+    size_t entries_capacity;
+};
+
+/// @param[in] device
+/// @param[out] samplercache
+/// @note Caller is responsible to call `samplercache_destroy` after
+/// `samplercache` is no longer needed
+void samplercache_create(VkDevice device, struct samplercache *samplercache);
+
+/// @param[in,out] samplercache
+/// @note Every sampler handed out by `samplercache` becomes invalid
+void samplercache_destroy(struct samplercache *samplercache);
+
+/// @param[in,out] samplercache
+/// @param[in] state
+/// @param[out] sampler
+/// @return `true` on success and `false` otherwise
+/// @note `sampler` is owned by `samplercache`
+bool samplercache_get(
+    struct samplercache *samplercache,
+    const struct samplercache_state *state,
+    VkSampler *sampler
+);
+
+#endif
@@ -0,0 +1,454 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shaderobjects.h"
+
+bool shaderobjects_create(
+    VkDevice device,
+    struct layoutcache *layoutcache,
+    const struct pipeline_program *program,
+    struct shaderobjects *shaderobjects
+) {
+    *shaderobjects = (struct shaderobjects){
+        .device = device,
+        .program = program,
+    };
+
+    VkPipelineLayout layout;
+    if (!layoutcache_pipelinelayout_get(
+        layoutcache,
+        &program->reflection,
+        &layout,
+        shaderobjects->setlayouts,
+        &shaderobjects->setlayouts_count
+    )) {
+        fprintf(
+            stderr, "shaderobjects_create: layoutcache_pipelinelayout_get failed\n"
+        );
+        return false;
+    }
+
+    // Every command comes from the extension, so they are loaded even where
+    // the core or extended dynamic state versions would be available
+    struct {
+        const char *name;
+        PFN_vkVoidFunction *function;
+    } functions[] = {
+        {
+            "vkCreateShadersEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCreateShadersEXT,
+        },
+        {
+            "vkDestroyShaderEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkDestroyShaderEXT,
+        },
+        {
+            "vkCmdBindShadersEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdBindShadersEXT,
+        },
+        {
+            "vkCmdSetViewportWithCountEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetViewportWithCountEXT,
+        },
+        {
+            "vkCmdSetScissorWithCountEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetScissorWithCountEXT,
+        },
+        {
+            "vkCmdSetVertexInputEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetVertexInputEXT,
+        },
+        {
+            "vkCmdSetPrimitiveTopologyEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetPrimitiveTopologyEXT,
+        },
+        {
+            "vkCmdSetPrimitiveRestartEnableEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetPrimitiveRestartEnableEXT,
+        },
+        {
+            "vkCmdSetRasterizerDiscardEnableEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetRasterizerDiscardEnableEXT,
+        },
+        {
+            "vkCmdSetPolygonModeEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetPolygonModeEXT,
+        },
+        {
+            "vkCmdSetCullModeEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetCullModeEXT,
+        },
+        {
+            "vkCmdSetFrontFaceEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetFrontFaceEXT,
+        },
+        {
+            "vkCmdSetDepthBiasEnableEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetDepthBiasEnableEXT,
+        },
+        {
+            "vkCmdSetDepthTestEnableEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetDepthTestEnableEXT,
+        },
+        {
+            "vkCmdSetDepthWriteEnableEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetDepthWriteEnableEXT,
+        },
+        {
+            "vkCmdSetStencilTestEnableEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetStencilTestEnableEXT,
+        },
+        {
+            "vkCmdSetRasterizationSamplesEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetRasterizationSamplesEXT,
+        },
+        {
+            "vkCmdSetSampleMaskEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetSampleMaskEXT,
+        },
+        {
+            "vkCmdSetAlphaToCoverageEnableEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetAlphaToCoverageEnableEXT,
+        },
+        {
+            "vkCmdSetColorBlendEnableEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetColorBlendEnableEXT,
+        },
+        {
+            "vkCmdSetColorBlendEquationEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetColorBlendEquationEXT,
+        },
+        {
+            "vkCmdSetColorWriteMaskEXT",
+            (PFN_vkVoidFunction *) &shaderobjects->vkCmdSetColorWriteMaskEXT,
+        },
+    };
+
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
+        *functions[i].function = vkGetDeviceProcAddr(device, functions[i].name);
+        if (*functions[i].function == nullptr) {
+            fprintf(
+                stderr, "shaderobjects_create: %s not found\n", functions[i].name
+            );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void shaderobjects_destroy(struct shaderobjects *shaderobjects) {
+    for (size_t i = 0; i < shaderobjects->entries_count; i++) {
+        const struct shaderobjects_entry *entry = &shaderobjects->entries[i];
+        shaderobjects->vkDestroyShaderEXT(shaderobjects->device, entry->vertex, nullptr);
+        shaderobjects->vkDestroyShaderEXT(
+            shaderobjects->device, entry->fragment, nullptr
+        );
+    }
+    free(shaderobjects->entries);
+
+    *shaderobjects = (struct shaderobjects){};
+}
+
+/// @param[in] lhs
+/// @param[in] rhs
+/// @return `true` if both sets of constants are the same
+static bool shaderobjects_constants_equal(
+    const struct pipeline_constants *lhs, const struct pipeline_constants *rhs
+) {
+    return (
+        lhs->count == rhs->count &&
+        memcmp(lhs->values, rhs->values, sizeof(lhs->values[0]) * lhs->count) == 0
+    );
+}
+
+/// @param[in] shaderobjects
+/// @param[in] constants
+/// @return Entry created for `constants`, or `nullptr` if there is none
+static const struct shaderobjects_entry *shaderobjects_entry_find(
+    const struct shaderobjects *shaderobjects,
+    const struct pipeline_constants *constants
+) {
+    // A handful of constant sets per program, a linear scan is enough
+    for (size_t i = 0; i < shaderobjects->entries_count; i++) {
+        if (shaderobjects_constants_equal(
+            &shaderobjects->entries[i].constants, constants
+        )) {
+            return &shaderobjects->entries[i];
+        }
+    }
+
+    return nullptr;
+}
+
+/// @param[in,out] shaderobjects
+/// @param[in] constants Distinct sets of constants that are not created yet
+/// @param[in] constants_count
+/// @return `true` on success and `false` otherwise
+static bool shaderobjects_entries_create(
+    struct shaderobjects *shaderobjects,
+    const struct pipeline_constants *constants,
+    size_t constants_count
+) {
+    size_t capacity = shaderobjects->entries_count + constants_count;
+    if (capacity > shaderobjects->entries_capacity) {
+        struct shaderobjects_entry *entries = realloc(
+            shaderobjects->entries, sizeof(entries[0]) * capacity
+        );
+        if (entries == nullptr) {
+            fprintf(stderr, "shaderobjects_entries_create: realloc failed\n");
+            return false;
+        }
+        shaderobjects->entries = entries;
+        shaderobjects->entries_capacity = capacity;
+    }
+
+    struct pipeline_specialization *specializations = malloc(
+        sizeof(specializations[0]) * constants_count
+    );
+    VkShaderCreateInfoEXT *create_infos = malloc(
+        sizeof(create_infos[0]) * constants_count * 2
+    );
+    VkShaderEXT *shaders = calloc(constants_count * 2, sizeof(shaders[0]));
+    bool result = false;
+
+    if (specializations == nullptr || create_infos == nullptr || shaders == nullptr) {
+        fprintf(stderr, "shaderobjects_entries_create: malloc failed\n");
+        goto cleanup;
+    }
+
+    const struct pipeline_program *program = shaderobjects->program;
+    const VkPushConstantRange *push_constants = &program->reflection.push_constants;
+
+    for (size_t i = 0; i < constants_count; i++) {
+        pipeline_specialization_init(&specializations[i], &constants[i]);
+
+        // Unlinked, so any vertex shader can be paired with any fragment shader
+        create_infos[i * 2] = (VkShaderCreateInfoEXT){
+            .sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .nextStage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .codeType = VK_SHADER_CODE_TYPE_SPIRV_EXT,
+            .pCode = program->vertex_code,
+            .codeSize = program->vertex_code_size,
+            .pName = "main",
+            .pSetLayouts = shaderobjects->setlayouts,
+            .setLayoutCount = shaderobjects->setlayouts_count,
+            .pPushConstantRanges = push_constants,
+            .pushConstantRangeCount = push_constants->size != 0 ? 1 : 0,
+            .pSpecializationInfo = &specializations[i].info,
+        };
+        create_infos[i * 2 + 1] = (VkShaderCreateInfoEXT){
+            .sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .nextStage = 0,
+            .codeType = VK_SHADER_CODE_TYPE_SPIRV_EXT,
+            .pCode = program->fragment_code,
+            .codeSize = program->fragment_code_size,
+            .pName = "main",
+            .pSetLayouts = shaderobjects->setlayouts,
+            .setLayoutCount = shaderobjects->setlayouts_count,
+            .pPushConstantRanges = push_constants,
+            .pushConstantRangeCount = push_constants->size != 0 ? 1 : 0,
+            .pSpecializationInfo = &specializations[i].info,
+        };
+    }
+
+    if (shaderobjects->vkCreateShadersEXT(
+        shaderobjects->device,
+        (uint32_t) constants_count * 2,
+        create_infos,
+        nullptr,
+        shaders
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "shaderobjects_entries_create: vkCreateShadersEXT failed\n");
+        for (size_t i = 0; i < constants_count * 2; i++) {
+            shaderobjects->vkDestroyShaderEXT(
+                shaderobjects->device, shaders[i], nullptr
+            );
+        }
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < constants_count; i++) {
+        shaderobjects->entries[shaderobjects->entries_count++] = (
+            (struct shaderobjects_entry){
+                .constants = constants[i],
+                .vertex = shaders[i * 2],
+                .fragment = shaders[i * 2 + 1],
+            }
+        );
+    }
+
+    result = true;
+
+cleanup:
+    free(shaders);
+    free(create_infos);
+    free(specializations);
+
+    return result;
+}
+
+bool shaderobjects_prewarm(
+    struct shaderobjects *shaderobjects,
+    const struct pipeline_variant *variants,
+    size_t variants_count
+) {
+    struct pipeline_constants *constants = malloc(sizeof(constants[0]) * variants_count);
+    if (constants == nullptr) {
+        fprintf(stderr, "shaderobjects_prewarm: malloc failed\n");
+        return false;
+    }
+
+    size_t constants_count = 0;
+    for (size_t i = 0; i < variants_count; i++) {
+        if (shaderobjects_entry_find(shaderobjects, &variants[i].constants) != nullptr) {
+            continue;
+        }
+
+        bool duplicate = false;
+        for (size_t j = 0; j < constants_count && !duplicate; j++) {
+            duplicate = shaderobjects_constants_equal(
+                &constants[j], &variants[i].constants
+            );
+        }
+        if (!duplicate) {
+            constants[constants_count++] = variants[i].constants;
+        }
+    }
+
+    bool result = true;
+    if (constants_count > 0) {
+        result = shaderobjects_entries_create(shaderobjects, constants, constants_count);
+    }
+
+    free(constants);
+
+    return result;
+}
+
+bool shaderobjects_bind(
+    struct shaderobjects *shaderobjects,
+    VkCommandBuffer command_buffer,
+    VkExtent2D extent,
+    const struct pipeline_variant *variant
+) {
+    const struct shaderobjects_entry *entry = shaderobjects_entry_find(
+        shaderobjects, &variant->constants
+    );
+    if (entry == nullptr) {
+        if (!shaderobjects_entries_create(shaderobjects, &variant->constants, 1)) {
+            fprintf(
+                stderr, "shaderobjects_bind: shaderobjects_entries_create failed\n"
+            );
+            return false;
+        }
+        entry = &shaderobjects->entries[shaderobjects->entries_count - 1];
+    }
+
+    VkShaderStageFlagBits stages[] = {
+        VK_SHADER_STAGE_VERTEX_BIT,
+        VK_SHADER_STAGE_FRAGMENT_BIT,
+    };
+    VkShaderEXT shaders[] = {
+        entry->vertex,
+        entry->fragment,
+    };
+    shaderobjects->vkCmdBindShadersEXT(command_buffer, 2, stages, shaders);
+
+    // Everything below is what `pipeline_createinfo_init` bakes into a
+    // pipeline, with shader objects all of it has to be set explicitly
+    const struct pipeline_state *state = &variant->state;
+
+    VkViewport viewport = {
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = (float) extent.width,
+        .height = (float) extent.height,
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    shaderobjects->vkCmdSetViewportWithCountEXT(command_buffer, 1, &viewport);
+
+    VkRect2D scissor = {
+        .offset = {0, 0},
+        .extent = extent,
+    };
+    shaderobjects->vkCmdSetScissorWithCountEXT(command_buffer, 1, &scissor);
+
+    VkVertexInputBindingDescription binding;
+    VkVertexInputAttributeDescription attributes[VERTEXFORMAT_MAX_ATTRIBUTES];
+    uint32_t attributes_count = vertexformat_input(
+        state->vertexformat, &binding, attributes
+    );
+
+    VkVertexInputBindingDescription2EXT binding2 = {
+        .sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT,
+        .binding = binding.binding,
+        .stride = binding.stride,
+        .inputRate = binding.inputRate,
+        .divisor = 1,
+    };
+    VkVertexInputAttributeDescription2EXT attributes2[VERTEXFORMAT_MAX_ATTRIBUTES];
+    for (uint32_t i = 0; i < attributes_count; i++) {
+        attributes2[i] = (VkVertexInputAttributeDescription2EXT){
+            .sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT,
+            .location = attributes[i].location,
+            .binding = attributes[i].binding,
+            .format = attributes[i].format,
+            .offset = attributes[i].offset,
+        };
+    }
+    shaderobjects->vkCmdSetVertexInputEXT(
+        command_buffer,
+        attributes_count > 0 ? 1 : 0,
+        &binding2,
+        attributes_count,
+        attributes2
+    );
+    shaderobjects->vkCmdSetPrimitiveTopologyEXT(command_buffer, state->topology);
+    shaderobjects->vkCmdSetPrimitiveRestartEnableEXT(command_buffer, VK_FALSE);
+
+    shaderobjects->vkCmdSetRasterizerDiscardEnableEXT(command_buffer, VK_FALSE);
+    shaderobjects->vkCmdSetPolygonModeEXT(command_buffer, state->polygon_mode);
+    shaderobjects->vkCmdSetCullModeEXT(command_buffer, state->cull_mode);
+    shaderobjects->vkCmdSetFrontFaceEXT(command_buffer, state->front_face);
+    shaderobjects->vkCmdSetDepthBiasEnableEXT(command_buffer, VK_FALSE);
+
+    shaderobjects->vkCmdSetDepthTestEnableEXT(command_buffer, VK_FALSE);
+    shaderobjects->vkCmdSetDepthWriteEnableEXT(command_buffer, VK_FALSE);
+    shaderobjects->vkCmdSetStencilTestEnableEXT(command_buffer, VK_FALSE);
+
+    VkSampleMask sample_mask = UINT32_MAX;
+    shaderobjects->vkCmdSetRasterizationSamplesEXT(
+        command_buffer, VK_SAMPLE_COUNT_1_BIT
+    );
+    shaderobjects->vkCmdSetSampleMaskEXT(
+        command_buffer, VK_SAMPLE_COUNT_1_BIT, &sample_mask
+    );
+    shaderobjects->vkCmdSetAlphaToCoverageEnableEXT(command_buffer, VK_FALSE);
+
+    VkColorBlendEquationEXT blend_equation = {
+        .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+        .colorBlendOp = VK_BLEND_OP_ADD,
+        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .alphaBlendOp = VK_BLEND_OP_ADD,
+    };
+    VkColorComponentFlags write_mask = (
+        VK_COLOR_COMPONENT_R_BIT |
+        VK_COLOR_COMPONENT_G_BIT |
+        VK_COLOR_COMPONENT_B_BIT |
+        VK_COLOR_COMPONENT_A_BIT
+    );
+    shaderobjects->vkCmdSetColorBlendEnableEXT(
+        command_buffer, 0, 1, &state->blend_enable
+    );
+    shaderobjects->vkCmdSetColorBlendEquationEXT(command_buffer, 0, 1, &blend_equation);
+    shaderobjects->vkCmdSetColorWriteMaskEXT(command_buffer, 0, 1, &write_mask);
+
+    return true;
+}
@@ -0,0 +1,100 @@
+#ifndef SHADEROBJECTS_H
+#define SHADEROBJECTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "layoutcache.h"
+#include "pipeline.h"
+
+/// Vertex and fragment `VkShaderEXT` of one set of specialization constants
+struct shaderobjects_entry {
+    struct pipeline_constants constants;
+    VkShaderEXT vertex;
+    VkShaderEXT fragment;
+};
+
+/// Pipeline-free alternative to `variantcache` built on `VK_EXT_shader_object`.
+/// Shaders are created per set of specialization constants and every piece of
+/// state a pipeline would bake in is set on the command buffer instead.
+struct shaderobjects {
+    VkDevice device;
+    const struct pipeline_program *program;
+
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS];
+    uint32_t setlayouts_count;
+
+    struct shaderobjects_entry *entries;
+    size_t entries_count;
+    size_t entries_capacity;
+
+    PFN_vkCreateShadersEXT vkCreateShadersEXT;
+    PFN_vkDestroyShaderEXT vkDestroyShaderEXT;
+    PFN_vkCmdBindShadersEXT vkCmdBindShadersEXT;
+    PFN_vkCmdSetViewportWithCountEXT vkCmdSetViewportWithCountEXT;
+    PFN_vkCmdSetScissorWithCountEXT vkCmdSetScissorWithCountEXT;
+    PFN_vkCmdSetVertexInputEXT vkCmdSetVertexInputEXT;
+    PFN_vkCmdSetPrimitiveTopologyEXT vkCmdSetPrimitiveTopologyEXT;
+    PFN_vkCmdSetPrimitiveRestartEnableEXT vkCmdSetPrimitiveRestartEnableEXT;
+    PFN_vkCmdSetRasterizerDiscardEnableEXT vkCmdSetRasterizerDiscardEnableEXT;
+    PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonModeEXT;
+    PFN_vkCmdSetCullModeEXT vkCmdSetCullModeEXT;
+    PFN_vkCmdSetFrontFaceEXT vkCmdSetFrontFaceEXT;
+    PFN_vkCmdSetDepthBiasEnableEXT vkCmdSetDepthBiasEnableEXT;
+    PFN_vkCmdSetDepthTestEnableEXT vkCmdSetDepthTestEnableEXT;
+    PFN_vkCmdSetDepthWriteEnableEXT vkCmdSetDepthWriteEnableEXT;
+    PFN_vkCmdSetStencilTestEnableEXT vkCmdSetStencilTestEnableEXT;
+    PFN_vkCmdSetRasterizationSamplesEXT vkCmdSetRasterizationSamplesEXT;
+    PFN_vkCmdSetSampleMaskEXT vkCmdSetSampleMaskEXT;
+    PFN_vkCmdSetAlphaToCoverageEnableEXT vkCmdSetAlphaToCoverageEnableEXT;
+    PFN_vkCmdSetColorBlendEnableEXT vkCmdSetColorBlendEnableEXT;
+    PFN_vkCmdSetColorBlendEquationEXT vkCmdSetColorBlendEquationEXT;
+    PFN_vkCmdSetColorWriteMaskEXT vkCmdSetColorWriteMaskEXT;
+};
+
+/// @param[in] device Created with `VK_EXT_shader_object` enabled
+/// @param[in,out] layoutcache Provides the set layouts of `program`
+/// @param[in] program
+/// @param[out] shaderobjects
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `shaderobjects_destroy` after successful
+/// return
+bool shaderobjects_create(
+    VkDevice device,
+    struct layoutcache *layoutcache,
+    const struct pipeline_program *program,
+    struct shaderobjects *shaderobjects
+);
+
+/// @param[in,out] shaderobjects
+/// @note The device must be idle
+void shaderobjects_destroy(struct shaderobjects *shaderobjects);
+
+/// @param[in,out] shaderobjects
+/// @param[in] variants
+/// @param[in] variants_count
+/// @return `true` on success and `false` otherwise
+/// @note Creates the shaders of every distinct set of constants in one call
+bool shaderobjects_prewarm(
+    struct shaderobjects *shaderobjects,
+    const struct pipeline_variant *variants,
+    size_t variants_count
+);
+
+/// @param[in,out] shaderobjects
+/// @param[in] command_buffer Inside a render pass
+/// @param[in] extent Viewport and scissor
+/// @param[in] variant
+/// @return `true` on success and `false` otherwise
+/// @note Creates the shaders of `variant` on the calling thread if they are
+/// missing
+bool shaderobjects_bind(
+    struct shaderobjects *shaderobjects,
+    VkCommandBuffer command_buffer,
+    VkExtent2D extent,
+    const struct pipeline_variant *variant
+);
+
+#endif
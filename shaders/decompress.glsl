@@ -0,0 +1,219 @@
+#version 450
+
+// Decompresses a chunked LZ4 archive blob with one workgroup per chunk. The
+// first invocation parses each sequence, then every invocation copies a share
+// of its literals and of its match.
+
+layout(local_size_x = 64) in;
+
+layout(push_constant) uniform Blob {
+    uint size;
+    uint uncompressedSize;
+    uint chunksCount;
+} blob;
+
+// The blob as stored: the size of every chunk, then the chunks
+layout(set = 0, binding = 0) readonly buffer Source {
+    uint source[];
+};
+
+// Cleared before the dispatch, bytes are set with atomicOr
+layout(set = 0, binding = 1) coherent buffer Destination {
+    uint destination[];
+};
+
+layout(set = 0, binding = 2) buffer Status {
+    uint failedChunks;
+};
+
+const uint CHUNK_SIZE = 256u << 10u;
+const uint MIN_MATCH = 4u;
+
+const uint STATE_SEQUENCE = 0u;
+const uint STATE_LAST = 1u;
+const uint STATE_FAILED = 2u;
+
+shared uint sums[gl_WorkGroupSize.x];
+shared uint literalStart;
+shared uint literalSize;
+shared uint matchOffset;
+shared uint matchSize;
+shared uint state;
+
+uint sourceByte(uint index) {
+    return (source[index >> 2u] >> ((index & 3u) * 8u)) & 0xffu;
+}
+
+uint destinationByte(uint index) {
+    return (destination[index >> 2u] >> ((index & 3u) * 8u)) & 0xffu;
+}
+
+void destinationWrite(uint index, uint value) {
+    atomicOr(destination[index >> 2u], value << ((index & 3u) * 8u));
+}
+
+// Reads a length continued in bytes of 255, returns false past `end`
+bool lengthRead(inout uint position, uint end, inout uint length) {
+    uint byte = 255u;
+    while (byte == 255u) {
+        if (position == end) {
+            return false;
+        }
+        byte = sourceByte(position);
+        position++;
+        length += byte;
+    }
+    return true;
+}
+
+// Parses the next sequence into the shared variables with the checks of
+// lz4_decompress, so that corrupt chunks fail instead of writing elsewhere
+void parse(
+    inout uint position, uint end, uint outputStart, uint outputPosition, uint outputEnd
+) {
+    state = STATE_FAILED;
+    literalStart = position;
+    literalSize = 0u;
+    matchOffset = 0u;
+    matchSize = 0u;
+
+    // The last sequence may also end after a match
+    if (position == end) {
+        if (outputPosition == outputEnd) {
+            state = STATE_LAST;
+        }
+        return;
+    }
+
+    uint token = sourceByte(position);
+    position++;
+
+    uint literals = token >> 4u;
+    if (literals == 15u && !lengthRead(position, end, literals)) {
+        return;
+    }
+    if (literals > end - position || literals > outputEnd - outputPosition) {
+        return;
+    }
+    literalStart = position;
+    literalSize = literals;
+    position += literals;
+    outputPosition += literals;
+
+    // The last sequence ends after its literals
+    if (position == end) {
+        if (outputPosition == outputEnd) {
+            state = STATE_LAST;
+        }
+        return;
+    }
+
+    if (end - position < 2u) {
+        return;
+    }
+    uint offset = sourceByte(position) | sourceByte(position + 1u) << 8u;
+    position += 2u;
+    if (offset == 0u || offset > outputPosition - outputStart) {
+        return;
+    }
+
+    uint match = token & 15u;
+    if (match == 15u && !lengthRead(position, end, match)) {
+        return;
+    }
+    match += MIN_MATCH;
+    if (match > outputEnd - outputPosition) {
+        return;
+    }
+
+    matchOffset = offset;
+    matchSize = match;
+    state = STATE_SEQUENCE;
+}
+
+void main() {
+    uint chunk = gl_WorkGroupID.x;
+    uint lane = gl_LocalInvocationID.x;
+
+    // The chunk starts behind the table and every chunk before it
+    uint sum = 0u;
+    for (uint i = lane; i < chunk; i += gl_WorkGroupSize.x) {
+        sum += source[i];
+    }
+    sums[lane] = sum;
+    barrier();
+    for (uint stride = gl_WorkGroupSize.x / 2u; stride > 0u; stride /= 2u) {
+        if (lane < stride) {
+            sums[lane] += sums[lane + stride];
+        }
+        barrier();
+    }
+
+    uint inputStart = 4u * blob.chunksCount + sums[0];
+    uint storedSize = source[chunk];
+    uint outputStart = CHUNK_SIZE * chunk;
+    uint outputSize = min(CHUNK_SIZE, blob.uncompressedSize - outputStart);
+    uint inputSize = blob.size - min(inputStart, blob.size);
+    if (storedSize > outputSize || storedSize > inputSize) {
+        if (lane == 0u) {
+            atomicAdd(failedChunks, 1u);
+        }
+        return;
+    }
+
+    // Chunks that did not compress are stored as is
+    if (storedSize == outputSize) {
+        for (uint i = lane; i < outputSize; i += gl_WorkGroupSize.x) {
+            destinationWrite(outputStart + i, sourceByte(inputStart + i));
+        }
+        return;
+    }
+
+    uint inputPosition = inputStart;
+    uint inputEnd = inputStart + storedSize;
+    uint outputPosition = outputStart;
+    uint outputEnd = outputStart + outputSize;
+
+    for (;;) {
+        if (lane == 0u) {
+            parse(inputPosition, inputEnd, outputStart, outputPosition, outputEnd);
+        }
+        barrier();
+
+        uint sequenceState = state;
+        uint sequenceLiteralStart = literalStart;
+        uint sequenceLiteralSize = literalSize;
+        uint sequenceOffset = matchOffset;
+        uint sequenceMatchSize = matchSize;
+        barrier();
+
+        if (sequenceState == STATE_FAILED) {
+            if (lane == 0u) {
+                atomicAdd(failedChunks, 1u);
+            }
+            return;
+        }
+
+        for (uint i = lane; i < sequenceLiteralSize; i += gl_WorkGroupSize.x) {
+            uint value = sourceByte(sequenceLiteralStart + i);
+            destinationWrite(outputPosition + i, value);
+        }
+        memoryBarrierBuffer();
+        barrier();
+        outputPosition += sequenceLiteralSize;
+
+        // A match that overlaps its own output repeats the last `offset`
+        // bytes, so every byte can be copied from before the match
+        for (uint i = lane; i < sequenceMatchSize; i += gl_WorkGroupSize.x) {
+            uint from = outputPosition - sequenceOffset + i % sequenceOffset;
+            destinationWrite(outputPosition + i, destinationByte(from));
+        }
+        memoryBarrierBuffer();
+        barrier();
+        outputPosition += sequenceMatchSize;
+
+        if (sequenceState == STATE_LAST) {
+            return;
+        }
+    }
+}
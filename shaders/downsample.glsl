@@ -0,0 +1,158 @@
+#version 450
+#extension GL_EXT_samplerless_texture_functions : require
+
+// Writes up to twelve levels below the base level of an image in a single
+// dispatch, in the manner of a single pass downsampler. Every workgroup
+// reduces a 64x64 tile of the base level to one texel of level 6 in shared
+// memory, and the last workgroup of each layer to finish reduces level 6 to
+// the remaining levels the same way.
+
+layout(local_size_x = 256) in;
+
+layout(push_constant) uniform Image {
+    ivec2 size;
+    // Including the base level
+    uint levelsCount;
+    // Per layer
+    uint workgroupsCount;
+} image;
+
+layout(set = 0, binding = 0) uniform texture2DArray source;
+
+// Level `i + 1` in element `i`, elements past the last level repeat it
+layout(set = 0, binding = 1) writeonly uniform image2DArray levels[12];
+
+// Level 6 of every layer, 64x64 texels each
+layout(set = 0, binding = 2) coherent buffer Intermediate {
+    vec4 intermediate[];
+};
+
+// Workgroups of every layer that are done, reset by the last one
+layout(set = 0, binding = 3) coherent buffer Counters {
+    uint counters[];
+};
+
+const int INTERMEDIATE_SIZE = 64;
+
+shared vec4 tile[16][16];
+shared bool last;
+
+ivec2 levelSize(uint level) {
+    return max(image.size >> int(level), ivec2(1));
+}
+
+vec4 load(bool fromIntermediate, ivec2 position, ivec2 size, uint layer) {
+    position = min(position, size - 1);
+    if (fromIntermediate) {
+        return intermediate[
+            layer * uint(INTERMEDIATE_SIZE * INTERMEDIATE_SIZE) +
+            uint(position.y * INTERMEDIATE_SIZE + position.x)
+        ];
+    }
+    return texelFetch(source, ivec3(position, layer), 0);
+}
+
+// Storage image arrays are only indexed with constants, which needs no
+// device feature
+void store(uint level, ivec2 position, uint layer, vec4 value) {
+    if (
+        level >= image.levelsCount ||
+        any(greaterThanEqual(position, levelSize(level)))
+    ) {
+        return;
+    }
+
+    ivec3 texel = ivec3(position, layer);
+    switch (level) {
+    case 1u: imageStore(levels[0], texel, value); break;
+    case 2u: imageStore(levels[1], texel, value); break;
+    case 3u: imageStore(levels[2], texel, value); break;
+    case 4u: imageStore(levels[3], texel, value); break;
+    case 5u: imageStore(levels[4], texel, value); break;
+    case 6u: imageStore(levels[5], texel, value); break;
+    case 7u: imageStore(levels[6], texel, value); break;
+    case 8u: imageStore(levels[7], texel, value); break;
+    case 9u: imageStore(levels[8], texel, value); break;
+    case 10u: imageStore(levels[9], texel, value); break;
+    case 11u: imageStore(levels[10], texel, value); break;
+    case 12u: imageStore(levels[11], texel, value); break;
+    }
+}
+
+// Reduces the 64x64 texels of level `firstLevel - 1` at `tilePosition` to
+// levels `firstLevel` to `firstLevel + 5`, leaving the last one in tile[0][0]
+void reduce(bool fromIntermediate, ivec2 tilePosition, uint layer, uint firstLevel) {
+    ivec2 sourceSize = fromIntermediate ? levelSize(6u) : image.size;
+    ivec2 local = ivec2(gl_LocalInvocationIndex & 15u, gl_LocalInvocationIndex >> 4u);
+
+    // Each invocation reduces 4x4 texels to 2x2 of the first level and to one
+    // of the second
+    vec4 sum = vec4(0.0);
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            ivec2 position = tilePosition * 32 + local * 2 + ivec2(x, y);
+            vec4 value = 0.25 * (
+                load(fromIntermediate, position * 2, sourceSize, layer) +
+                load(fromIntermediate, position * 2 + ivec2(1, 0), sourceSize, layer) +
+                load(fromIntermediate, position * 2 + ivec2(0, 1), sourceSize, layer) +
+                load(fromIntermediate, position * 2 + ivec2(1, 1), sourceSize, layer)
+            );
+            store(firstLevel, position, layer, value);
+            sum += value;
+        }
+    }
+    store(firstLevel + 1u, tilePosition * 16 + local, layer, 0.25 * sum);
+    tile[local.y][local.x] = 0.25 * sum;
+
+    // The rest halves the tile in shared memory, with fewer invocations each
+    // level
+    uint level = firstLevel + 2u;
+    for (int size = 8; size > 0; size >>= 1, level++) {
+        barrier();
+        bool active = all(lessThan(local, ivec2(size)));
+        vec4 value;
+        if (active) {
+            value = 0.25 * (
+                tile[local.y * 2][local.x * 2] +
+                tile[local.y * 2][local.x * 2 + 1] +
+                tile[local.y * 2 + 1][local.x * 2] +
+                tile[local.y * 2 + 1][local.x * 2 + 1]
+            );
+        }
+        barrier();
+        if (active) {
+            tile[local.y][local.x] = value;
+            store(level, tilePosition * size + local, layer, value);
+        }
+    }
+    barrier();
+}
+
+void main() {
+    uint layer = gl_WorkGroupID.z;
+
+    reduce(false, ivec2(gl_WorkGroupID.xy), layer, 1u);
+    if (image.levelsCount <= 7u) {
+        return;
+    }
+
+    if (gl_LocalInvocationIndex == 0u) {
+        ivec2 position = ivec2(gl_WorkGroupID.xy);
+        intermediate[
+            layer * uint(INTERMEDIATE_SIZE * INTERMEDIATE_SIZE) +
+            uint(position.y * INTERMEDIATE_SIZE + position.x)
+        ] = tile[0][0];
+        memoryBarrierBuffer();
+        last = atomicAdd(counters[layer], 1u) == image.workgroupsCount - 1u;
+        if (last) {
+            counters[layer] = 0u;
+        }
+        memoryBarrierBuffer();
+    }
+    barrier();
+    if (!last) {
+        return;
+    }
+
+    reduce(true, ivec2(0), layer, 7u);
+}
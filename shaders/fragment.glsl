@@ -1,9 +1,51 @@
 #version 450
 
+layout(constant_id = 0) const bool GRAYSCALE = false;
+layout(constant_id = 1) const int NOISE_OCTAVES = 0;
+
+layout(set = 0, binding = 0) uniform Material {
+    vec4 color;
+} material;
+
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUv;
 
 layout(location = 0) out vec4 outColor;
 
+float hash(vec2 p) {
+    return fract(sin(dot(p, vec2(12.9898, 78.233))) * 43758.5453);
+}
+
+float valueNoise(vec2 p) {
+    vec2 i = floor(p);
+    vec2 f = fract(p);
+    vec2 u = f * f * (3.0 - 2.0 * f);
+
+    return mix(
+        mix(hash(i), hash(i + vec2(1.0, 0.0)), u.x),
+        mix(hash(i + vec2(0.0, 1.0)), hash(i + vec2(1.0, 1.0)), u.x),
+        u.y
+    );
+}
+
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    vec3 color = fragColor * material.color.rgb;
+
+    if (NOISE_OCTAVES > 0) {
+        float noise = 0.0;
+        float amplitude = 0.5;
+        vec2 p = gl_FragCoord.xy / 64.0 + fragUv;
+        for (int i = 0; i < NOISE_OCTAVES; i++) {
+            noise += amplitude * valueNoise(p);
+            p *= 2.0;
+            amplitude *= 0.5;
+        }
+        color *= 0.75 + 0.5 * noise;
+    }
+
+    if (GRAYSCALE) {
+        color = vec3(dot(color, vec3(0.2126, 0.7152, 0.0722)));
+    }
+
+    outColor = vec4(color, 1.0);
 }
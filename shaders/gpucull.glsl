@@ -0,0 +1,166 @@
+#version 450
+#extension GL_EXT_samplerless_texture_functions : require
+
+// Culls objects against the frustum and the depth pyramid in two phases per
+// frame. The early phase emits a draw for every object in the frustum that was
+// visible the frame before. Once those are drawn and the pyramid is reduced
+// from their depth, the late phase tests every object in the frustum against
+// it, emits a draw for each that became visible, and keeps which objects are
+// visible for the next frame.
+
+layout(local_size_x = 64) in;
+
+const uint PHASE_EARLY = 0u;
+const uint PHASE_LATE = 1u;
+
+// Texels of the pyramid read along each axis at most
+const int FOOTPRINT = 4;
+
+layout(push_constant) uniform Cull {
+    uint objectsCount;
+    uint phase;
+    // Of the depth buffer the pyramid is reduced from
+    ivec2 depthSize;
+    uint levelsCount;
+} cull;
+
+layout(set = 0, binding = 0) uniform Camera {
+    mat4 viewProjection;
+    // Unit normals pointing inwards, as `cull_frustum_extract` writes them
+    vec4 planes[6];
+} camera;
+
+struct Object {
+    vec4 centerRadius;
+    // Half the size of the box along each axis
+    vec4 extent;
+};
+
+layout(set = 0, binding = 1) readonly buffer Objects {
+    Object objects[];
+};
+
+layout(set = 0, binding = 2) buffer Visibility {
+    uint visibility[];
+};
+
+struct Draw {
+    uint vertexCount;
+    uint instanceCount;
+    uint firstVertex;
+    uint firstInstance;
+};
+
+// Early draws first, late draws from `objectsCount` on
+layout(set = 0, binding = 3) writeonly buffer Draws {
+    Draw draws[];
+};
+
+layout(set = 0, binding = 4) buffer Counts {
+    uint earlyDraws;
+    uint lateDraws;
+    uint frustumCulled;
+    uint occluded;
+} counts;
+
+layout(set = 0, binding = 5) uniform texture2D pyramid;
+
+// Culled when either the sphere or the box is outside a plane
+bool inFrustum(Object object) {
+    vec3 center = object.centerRadius.xyz;
+    for (int i = 0; i < 6; i++) {
+        vec4 plane = camera.planes[i];
+        float offset = dot(plane.xyz, center) + plane.w;
+        if (
+            offset < -object.centerRadius.w ||
+            offset + dot(abs(plane.xyz), object.extent.xyz) < 0.0
+        ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether the nearest point of the box is behind the farthest depth of every
+// texel it covers on screen. Boxes reaching in front of the near plane are
+// never hidden.
+bool occluded(Object object) {
+    vec2 minimum = vec2(1.0);
+    vec2 maximum = vec2(-1.0);
+    float nearest = 1.0;
+    for (uint corner = 0u; corner < 8u; corner++) {
+        vec3 direction = vec3(
+            corner & 1u, (corner >> 1u) & 1u, (corner >> 2u) & 1u
+        ) * 2.0 - 1.0;
+        vec4 clip = camera.viewProjection * vec4(
+            object.centerRadius.xyz + direction * object.extent.xyz, 1.0
+        );
+        if (clip.w <= 0.0 || clip.z < 0.0) {
+            return false;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        minimum = min(minimum, ndc.xy);
+        maximum = max(maximum, ndc.xy);
+        nearest = min(nearest, ndc.z);
+    }
+
+    vec2 size = vec2(cull.depthSize);
+    ivec2 first = ivec2(floor(clamp(minimum * 0.5 + 0.5, 0.0, 1.0) * size));
+    ivec2 last = ivec2(ceil(clamp(maximum * 0.5 + 0.5, 0.0, 1.0) * size)) - 1;
+    first = min(first, cull.depthSize - 1);
+    last = clamp(last, first, cull.depthSize - 1);
+
+    // Down to the first level where the texels covering the box fit the
+    // footprint
+    ivec2 levelSize = max(cull.depthSize >> 1, ivec2(1));
+    first = min(first >> 1, levelSize - 1);
+    last = min(last >> 1, levelSize - 1);
+    int level = 0;
+    while (
+        any(greaterThanEqual(last - first, ivec2(FOOTPRINT))) &&
+        level + 1 < int(cull.levelsCount)
+    ) {
+        levelSize = max(levelSize >> 1, ivec2(1));
+        first = min(first >> 1, levelSize - 1);
+        last = min(last >> 1, levelSize - 1);
+        level++;
+    }
+
+    float farthest = 0.0;
+    for (int y = first.y; y <= last.y; y++) {
+        for (int x = first.x; x <= last.x; x++) {
+            farthest = max(farthest, texelFetch(pyramid, ivec2(x, y), level).r);
+        }
+    }
+    return nearest > farthest;
+}
+
+void emit(uint slot, uint index) {
+    draws[slot] = Draw(36u, 1u, 0u, index);
+}
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= cull.objectsCount) {
+        return;
+    }
+
+    Object object = objects[index];
+    bool visible = inFrustum(object);
+    if (cull.phase == PHASE_EARLY) {
+        if (visible && visibility[index] != 0u) {
+            emit(atomicAdd(counts.earlyDraws, 1u), index);
+        }
+        return;
+    }
+
+    if (!visible) {
+        atomicAdd(counts.frustumCulled, 1u);
+    } else if (occluded(object)) {
+        atomicAdd(counts.occluded, 1u);
+        visible = false;
+    } else if (visibility[index] == 0u) {
+        emit(cull.objectsCount + atomicAdd(counts.lateDraws, 1u), index);
+    }
+    visibility[index] = visible ? 1u : 0u;
+}
@@ -0,0 +1,40 @@
+#version 450
+
+// Draws the box of the object `gl_InstanceIndex` refers to, with 36 vertices
+// and no vertex buffer
+
+layout(push_constant) uniform Camera {
+    mat4 viewProjection;
+} camera;
+
+struct Object {
+    vec4 centerRadius;
+    vec4 extent;
+};
+
+layout(set = 0, binding = 0) readonly buffer Objects {
+    Object objects[];
+};
+
+layout(location = 0) flat out vec4 fragColor;
+
+// Corners of each face, with bit `i` of a corner set on the positive side of
+// axis `i`, facing -z, +z, -y, +y, -x and +x in turn
+const uint CORNERS[36] = uint[](
+    0u, 1u, 3u, 0u, 3u, 2u, 4u, 6u, 7u, 4u, 7u, 5u, 0u, 4u, 5u, 0u, 5u, 1u,
+    2u, 3u, 7u, 2u, 7u, 6u, 0u, 2u, 6u, 0u, 6u, 4u, 1u, 5u, 7u, 1u, 7u, 3u
+);
+
+void main() {
+    Object object = objects[gl_InstanceIndex];
+    uint corner = CORNERS[gl_VertexIndex];
+    vec3 direction = vec3(corner & 1u, (corner >> 1u) & 1u, (corner >> 2u) & 1u);
+    gl_Position = camera.viewProjection * vec4(
+        object.centerRadius.xyz + (direction * 2.0 - 1.0) * object.extent.xyz, 1.0
+    );
+
+    // Objects are told apart by hue and faces by brightness
+    vec3 hue = fract(float(gl_InstanceIndex) * vec3(0.618034, 0.381966, 0.236068));
+    float shade = 0.5 + 0.25 * float(gl_VertexIndex / 12);
+    fragColor = vec4((0.25 + 0.75 * hue) * shade, 1.0);
+}
@@ -0,0 +1,43 @@
+#version 450
+#extension GL_EXT_samplerless_texture_functions : require
+
+// Reduces the depth buffer, or a level of the pyramid built from it, into the
+// next level, keeping the farthest depth. Levels are half the size of the one
+// above rounded down, and the last row and column of a level also cover the
+// odd row and column left over above them, so that every texel is covered by
+// the one at half its position clamped to the level below.
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(push_constant) uniform Level {
+    ivec2 sourceSize;
+    ivec2 size;
+} level;
+
+layout(set = 0, binding = 0) uniform texture2D source;
+
+layout(set = 0, binding = 1, r32f) writeonly uniform image2D destination;
+
+void main() {
+    ivec2 position = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(position, level.size))) {
+        return;
+    }
+
+    ivec2 first = position * 2;
+    ivec2 last = min(first + 1, level.sourceSize - 1);
+    if (position.x == level.size.x - 1) {
+        last.x = level.sourceSize.x - 1;
+    }
+    if (position.y == level.size.y - 1) {
+        last.y = level.sourceSize.y - 1;
+    }
+
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; y++) {
+        for (int x = first.x; x <= last.x; x++) {
+            depth = max(depth, texelFetch(source, ivec2(x, y), 0).r);
+        }
+    }
+    imageStore(destination, position, vec4(depth));
+}
@@ -0,0 +1,26 @@
+#version 450
+
+// Reads the alpha of the texels as a signed distance field, see
+// `SPRITES_BLEND_SDF`
+layout(constant_id = 0) const bool SDF = false;
+
+layout(set = 0, binding = 0) uniform sampler2D page;
+
+layout(location = 0) in vec2 fragUv;
+layout(location = 1) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec4 texel = texture(page, fragUv);
+
+    if (SDF) {
+        // Antialiased over about a pixel whatever the scale, and never a
+        // zero width step where the field is flat
+        float width = max(fwidth(texel.a), 1.0 / 255.0);
+        float coverage = smoothstep(0.5 - width, 0.5 + width, texel.a);
+        outColor = vec4(fragColor.rgb * texel.rgb, fragColor.a * coverage);
+    } else {
+        outColor = fragColor * texel;
+    }
+}
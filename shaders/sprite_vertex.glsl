@@ -0,0 +1,28 @@
+#version 450
+
+// Every sprite is one instance, expanded into a quad of four vertices that
+// are drawn as a triangle strip
+
+layout(push_constant) uniform Viewport {
+    // Two over the extent in pixels
+    vec2 scale;
+} viewport;
+
+// Top left corner and size in pixels
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inSize;
+// Top left and bottom right corner in the atlas page
+layout(location = 2) in vec4 inUv;
+layout(location = 3) in vec4 inColor;
+
+layout(location = 0) out vec2 fragUv;
+layout(location = 1) out vec4 fragColor;
+
+void main() {
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    vec2 position = inPosition + corner * inSize;
+
+    gl_Position = vec4(position * viewport.scale - 1.0, 0.0, 1.0);
+    fragUv = mix(inUv.xy, inUv.zw, corner);
+    fragColor = inColor;
+}
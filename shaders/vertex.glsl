@@ -1,20 +1,35 @@
 #version 450
 
-layout(location = 0) out vec3 fragColor;
+layout(constant_id = 2) const bool QUANTIZED_VERTICES = false;
+
+layout(push_constant) uniform Decode {
+    vec4 offset;
+    vec4 scale;
+} decode;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUv;
+layout(location = 3) in vec4 inColor;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUv;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+vec3 octahedralDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    // Quantized positions are relative to the mesh bounds, float positions
+    // come with an identity decode
+    vec3 position = decode.offset.xyz + decode.scale.xyz * inPosition;
+    vec3 normal = QUANTIZED_VERTICES ? octahedralDecode(inNormal.xy) : inNormal;
+
+    gl_Position = vec4(position, 1.0);
+    // Lit from the viewer, who looks down the positive z axis
+    fragColor = inColor.rgb * (0.5 + 0.5 * max(-normal.z, 0.0));
+    fragUv = inUv;
 }
@@ -0,0 +1,910 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spirv.h"
+
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+constexpr size_t SPIRV_HEADER_WORDS = 5;
+/// Types nested deeper than this are taken to refer back to themselves, which a
+/// valid module cannot do
+constexpr uint32_t SPIRV_MAX_TYPE_DEPTH = 64;
+
+enum spirv_op {
+    SPIRV_OP_ENTRY_POINT = 15,
+    SPIRV_OP_TYPE_BOOL = 20,
+    SPIRV_OP_TYPE_INT = 21,
+    SPIRV_OP_TYPE_FLOAT = 22,
+    SPIRV_OP_TYPE_VECTOR = 23,
+    SPIRV_OP_TYPE_MATRIX = 24,
+    SPIRV_OP_TYPE_IMAGE = 25,
+    SPIRV_OP_TYPE_SAMPLER = 26,
+    SPIRV_OP_TYPE_SAMPLED_IMAGE = 27,
+    SPIRV_OP_TYPE_ARRAY = 28,
+    SPIRV_OP_TYPE_RUNTIME_ARRAY = 29,
+    SPIRV_OP_TYPE_STRUCT = 30,
+    SPIRV_OP_TYPE_POINTER = 32,
+    SPIRV_OP_CONSTANT = 43,
+    SPIRV_OP_SPEC_CONSTANT = 50,
+    SPIRV_OP_VARIABLE = 59,
+    SPIRV_OP_DECORATE = 71,
+    SPIRV_OP_MEMBER_DECORATE = 72,
+    SPIRV_OP_TYPE_ACCELERATION_STRUCTURE = 5341,
+};
+
+enum spirv_decoration {
+    SPIRV_DECORATION_BLOCK = 2,
+    SPIRV_DECORATION_BUFFER_BLOCK = 3,
+    SPIRV_DECORATION_ARRAY_STRIDE = 6,
+    SPIRV_DECORATION_MATRIX_STRIDE = 7,
+    SPIRV_DECORATION_BUILTIN = 11,
+    SPIRV_DECORATION_LOCATION = 30,
+    SPIRV_DECORATION_BINDING = 33,
+    SPIRV_DECORATION_DESCRIPTOR_SET = 34,
+    SPIRV_DECORATION_OFFSET = 35,
+};
+
+enum spirv_storage_class {
+    SPIRV_STORAGE_CLASS_UNIFORM_CONSTANT = 0,
+    SPIRV_STORAGE_CLASS_INPUT = 1,
+    SPIRV_STORAGE_CLASS_UNIFORM = 2,
+    SPIRV_STORAGE_CLASS_PUSH_CONSTANT = 9,
+    SPIRV_STORAGE_CLASS_STORAGE_BUFFER = 12,
+};
+
+enum spirv_execution_model {
+    SPIRV_EXECUTION_MODEL_VERTEX = 0,
+    SPIRV_EXECUTION_MODEL_TESSELLATION_CONTROL = 1,
+    SPIRV_EXECUTION_MODEL_TESSELLATION_EVALUATION = 2,
+    SPIRV_EXECUTION_MODEL_GEOMETRY = 3,
+    SPIRV_EXECUTION_MODEL_FRAGMENT = 4,
+    SPIRV_EXECUTION_MODEL_GL_COMPUTE = 5,
+};
+
+enum spirv_dim {
+    SPIRV_DIM_BUFFER = 5,
+    SPIRV_DIM_SUBPASS_DATA = 6,
+};
+
+/// What the parser remembers about a single result id
+struct spirv_id {
+    /// Defining instruction of types, constants and variables
+    const uint32_t *instruction;
+
+    uint32_t set;
+    uint32_t binding;
+    uint32_t location;
+    uint32_t array_stride;
+    bool builtin;
+    bool block;
+    bool buffer_block;
+};
+
+struct spirv_member_decoration {
+    uint32_t struct_id;
+    uint32_t member;
+    uint32_t decoration;
+    uint32_t value;
+};
+
+struct spirv_parser {
+    struct spirv_id *ids;
+    uint32_t ids_count;
+
+    struct spirv_member_decoration *member_decorations;
+    size_t member_decorations_count;
+    size_t member_decorations_capacity;
+};
+
+/// @param[in] parser
+/// @param[in] id
+/// @param[in] words_count Words of the instruction the caller reads
+/// @return Instruction defining `id`, or `nullptr` if `id` is out of bounds,
+/// unknown or defined by an instruction shorter than `words_count`
+static const uint32_t *spirv_instruction(
+    const struct spirv_parser *parser, uint32_t id, uint32_t words_count
+) {
+    if (id >= parser->ids_count || parser->ids[id].instruction == nullptr) {
+        return nullptr;
+    }
+
+    const uint32_t *instruction = parser->ids[id].instruction;
+    return (instruction[0] >> 16) >= words_count ? instruction : nullptr;
+}
+
+/// @param[in] parser
+/// @param[in] id
+/// @return Opcode of the instruction defining `id`, or zero if unknown
+static uint32_t spirv_opcode(const struct spirv_parser *parser, uint32_t id) {
+    const uint32_t *instruction = spirv_instruction(parser, id, 1);
+    if (instruction == nullptr) {
+        return 0;
+    }
+
+    return instruction[0] & 0xffff;
+}
+
+/// @param[in] parser
+/// @param[in] struct_id
+/// @param[in] member
+/// @param[in] decoration
+/// @param[out] value
+/// @return `true` if the member carries `decoration`
+static bool spirv_member_decoration_find(
+    const struct spirv_parser *parser,
+    uint32_t struct_id,
+    uint32_t member,
+    uint32_t decoration,
+    uint32_t *value
+) {
+    for (size_t i = 0; i < parser->member_decorations_count; i++) {
+        const struct spirv_member_decoration *entry = &parser->member_decorations[i];
+        if (
+            entry->struct_id == struct_id &&
+            entry->member == member &&
+            entry->decoration == decoration
+        ) {
+            *value = entry->value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// @param[in] parser
+/// @param[in] array_id
+/// @param[out] length Length of a fixed-size array type, one if it is not a
+/// constant
+/// @return `true` on success and `false` if the type is malformed
+static bool spirv_array_length(
+    const struct spirv_parser *parser, uint32_t array_id, uint32_t *length
+) {
+    const uint32_t *array = spirv_instruction(parser, array_id, 4);
+    if (array == nullptr) {
+        fprintf(stderr, "spirv_array_length: %%%u is malformed\n", array_id);
+        return false;
+    }
+
+    const uint32_t *constant = spirv_instruction(parser, array[3], 4);
+    uint32_t opcode = constant == nullptr ? 0 : constant[0] & 0xffff;
+    *length = opcode == SPIRV_OP_CONSTANT || opcode == SPIRV_OP_SPEC_CONSTANT
+        ? constant[3]
+        : 1;
+
+    return true;
+}
+
+/// @param[in] parser
+/// @param[in] type_id
+/// @param[in] depth Types `type_id` is nested in
+/// @param[out] size Size in bytes of `type_id` as laid out in a block, zero
+/// for types without one
+/// @return `true` on success and `false` if the type is malformed
+static bool spirv_type_size(
+    const struct spirv_parser *parser, uint32_t type_id, uint32_t depth, uint32_t *size
+) {
+    const uint32_t *instruction = spirv_instruction(parser, type_id, 1);
+    if (instruction == nullptr) {
+        fprintf(stderr, "spirv_type_size: %%%u is not a type\n", type_id);
+        return false;
+    }
+    if (depth == SPIRV_MAX_TYPE_DEPTH) {
+        fprintf(stderr, "spirv_type_size: %%%u is nested too deeply\n", type_id);
+        return false;
+    }
+    uint32_t words_count = instruction[0] >> 16;
+
+    switch (instruction[0] & 0xffff) {
+    case SPIRV_OP_TYPE_BOOL:
+        *size = 4;
+        return true;
+    case SPIRV_OP_TYPE_INT:
+    case SPIRV_OP_TYPE_FLOAT:
+        if (words_count < 3) {
+            break;
+        }
+        *size = instruction[2] / 8;
+        return true;
+    case SPIRV_OP_TYPE_VECTOR:
+    case SPIRV_OP_TYPE_MATRIX: {
+        uint32_t component_size;
+        if (words_count < 4) {
+            break;
+        }
+        if (!spirv_type_size(parser, instruction[2], depth + 1, &component_size)) {
+            return false;
+        }
+        *size = instruction[3] * component_size;
+        return true;
+    }
+    case SPIRV_OP_TYPE_POINTER:
+        *size = 8;
+        return true;
+    case SPIRV_OP_TYPE_ARRAY: {
+        uint32_t length;
+        if (words_count < 4 || !spirv_array_length(parser, type_id, &length)) {
+            break;
+        }
+        uint32_t stride = parser->ids[type_id].array_stride;
+        if (
+            stride == 0 &&
+            !spirv_type_size(parser, instruction[2], depth + 1, &stride)
+        ) {
+            return false;
+        }
+        *size = length * stride;
+        return true;
+    }
+    case SPIRV_OP_TYPE_STRUCT: {
+        if (words_count < 2) {
+            break;
+        }
+        *size = 0;
+        uint32_t members_count = words_count - 2;
+        for (uint32_t i = 0; i < members_count; i++) {
+            uint32_t member_type = instruction[2 + i];
+
+            uint32_t offset = 0;
+            spirv_member_decoration_find(
+                parser, type_id, i, SPIRV_DECORATION_OFFSET, &offset
+            );
+
+            uint32_t member_size;
+            if (!spirv_type_size(parser, member_type, depth + 1, &member_size)) {
+                return false;
+            }
+            // A matrix has its size checked above, so it has a column count
+            uint32_t matrix_stride;
+            if (
+                spirv_opcode(parser, member_type) == SPIRV_OP_TYPE_MATRIX &&
+                spirv_member_decoration_find(
+                    parser, type_id, i, SPIRV_DECORATION_MATRIX_STRIDE, &matrix_stride
+                )
+            ) {
+                member_size = parser->ids[member_type].instruction[3] * matrix_stride;
+            }
+
+            if (offset + member_size > *size) {
+                *size = offset + member_size;
+            }
+        }
+        return true;
+    }
+    default:
+        *size = 0;
+        return true;
+    }
+
+    fprintf(stderr, "spirv_type_size: %%%u is malformed\n", type_id);
+    return false;
+}
+
+/// @param[in] parser
+/// @param[in] struct_id
+/// @return Smallest member offset of a block, zero if `struct_id` is not one
+static uint32_t spirv_struct_offset(const struct spirv_parser *parser, uint32_t struct_id) {
+    const uint32_t *instruction = spirv_instruction(parser, struct_id, 2);
+    if (instruction == nullptr) {
+        return 0;
+    }
+    uint32_t members_count = (instruction[0] >> 16) - 2;
+
+    uint32_t offset_min = UINT32_MAX;
+    for (uint32_t i = 0; i < members_count; i++) {
+        uint32_t offset;
+        if (
+            spirv_member_decoration_find(
+                parser, struct_id, i, SPIRV_DECORATION_OFFSET, &offset
+            ) &&
+            offset < offset_min
+        ) {
+            offset_min = offset;
+        }
+    }
+
+    return offset_min == UINT32_MAX ? 0 : offset_min;
+}
+
+/// @param[in] parser
+/// @param[in] type_id Type the variable points to
+/// @param[in] storage_class
+/// @param[out] binding Filled in if the variable is a descriptor
+/// @param[out] descriptor Whether the variable is a descriptor
+/// @return `true` on success and `false` if a type is malformed
+static bool spirv_descriptor_describe(
+    const struct spirv_parser *parser,
+    uint32_t type_id,
+    uint32_t storage_class,
+    struct spirv_binding *binding,
+    bool *descriptor
+) {
+    *descriptor = false;
+
+    binding->count = 1;
+    for (uint32_t depth = 0;; depth++) {
+        uint32_t opcode = spirv_opcode(parser, type_id);
+        if (opcode == SPIRV_OP_TYPE_ARRAY) {
+            uint32_t length;
+            if (!spirv_array_length(parser, type_id, &length)) {
+                return false;
+            }
+            binding->count *= length;
+        } else if (opcode == SPIRV_OP_TYPE_RUNTIME_ARRAY) {
+            binding->count = 0;
+        } else {
+            break;
+        }
+
+        const uint32_t *array = spirv_instruction(parser, type_id, 3);
+        if (array == nullptr || depth == SPIRV_MAX_TYPE_DEPTH) {
+            fprintf(stderr, "spirv_descriptor_describe: %%%u is malformed\n", type_id);
+            return false;
+        }
+        type_id = array[2];
+    }
+
+    const uint32_t *instruction = spirv_instruction(parser, type_id, 1);
+    if (instruction == nullptr) {
+        fprintf(stderr, "spirv_descriptor_describe: %%%u is not a type\n", type_id);
+        return false;
+    }
+
+    switch (storage_class) {
+    case SPIRV_STORAGE_CLASS_UNIFORM_CONSTANT:
+        switch (instruction[0] & 0xffff) {
+        case SPIRV_OP_TYPE_SAMPLER:
+            binding->type = VK_DESCRIPTOR_TYPE_SAMPLER;
+            break;
+        case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+            binding->type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            break;
+        case SPIRV_OP_TYPE_IMAGE: {
+            if ((instruction[0] >> 16) < 9) {
+                fprintf(
+                    stderr, "spirv_descriptor_describe: %%%u is malformed\n", type_id
+                );
+                return false;
+            }
+            uint32_t dim = instruction[3];
+            bool storage = instruction[7] == 2;
+            if (dim == SPIRV_DIM_SUBPASS_DATA) {
+                binding->type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            } else if (dim == SPIRV_DIM_BUFFER) {
+                binding->type = storage
+                    ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+                    : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            } else {
+                binding->type = storage
+                    ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                    : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            }
+            break;
+        }
+        case SPIRV_OP_TYPE_ACCELERATION_STRUCTURE:
+            binding->type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+            break;
+        default:
+            return true;
+        }
+        break;
+    case SPIRV_STORAGE_CLASS_UNIFORM:
+        binding->type = parser->ids[type_id].buffer_block
+            ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+            : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        break;
+    case SPIRV_STORAGE_CLASS_STORAGE_BUFFER:
+        binding->type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        break;
+    default:
+        return true;
+    }
+
+    *descriptor = true;
+    return true;
+}
+
+/// @param[in] parser
+/// @param[in] type_id
+/// @param[out] input Receives format and size of one location
+/// @param[out] locations_count Locations taken by `type_id`
+/// @return `true` if `type_id` can be fed from a vertex buffer
+static bool spirv_input_describe(
+    const struct spirv_parser *parser,
+    uint32_t type_id,
+    struct spirv_input *input,
+    uint32_t *locations_count
+) {
+    static const VkFormat float_formats[] = {
+        VK_FORMAT_R32_SFLOAT,
+        VK_FORMAT_R32G32_SFLOAT,
+        VK_FORMAT_R32G32B32_SFLOAT,
+        VK_FORMAT_R32G32B32A32_SFLOAT,
+    };
+    static const VkFormat sint_formats[] = {
+        VK_FORMAT_R32_SINT,
+        VK_FORMAT_R32G32_SINT,
+        VK_FORMAT_R32G32B32_SINT,
+        VK_FORMAT_R32G32B32A32_SINT,
+    };
+    static const VkFormat uint_formats[] = {
+        VK_FORMAT_R32_UINT,
+        VK_FORMAT_R32G32_UINT,
+        VK_FORMAT_R32G32B32_UINT,
+        VK_FORMAT_R32G32B32A32_UINT,
+    };
+
+    *locations_count = 1;
+    if (spirv_opcode(parser, type_id) == SPIRV_OP_TYPE_MATRIX) {
+        const uint32_t *matrix = spirv_instruction(parser, type_id, 4);
+        if (matrix == nullptr) {
+            return false;
+        }
+        *locations_count = matrix[3];
+        type_id = matrix[2];
+    }
+
+    uint32_t components_count = 1;
+    if (spirv_opcode(parser, type_id) == SPIRV_OP_TYPE_VECTOR) {
+        const uint32_t *vector = spirv_instruction(parser, type_id, 4);
+        if (vector == nullptr) {
+            return false;
+        }
+        components_count = vector[3];
+        type_id = vector[2];
+    }
+    if (components_count < 1 || components_count > 4) {
+        return false;
+    }
+
+    const uint32_t *scalar = spirv_instruction(parser, type_id, 3);
+    if (scalar == nullptr) {
+        return false;
+    }
+    switch (scalar[0] & 0xffff) {
+    case SPIRV_OP_TYPE_FLOAT:
+        if (scalar[2] != 32) {
+            return false;
+        }
+        input->format = float_formats[components_count - 1];
+        break;
+    case SPIRV_OP_TYPE_INT:
+        if ((scalar[0] >> 16) < 4 || scalar[2] != 32) {
+            return false;
+        }
+        input->format = scalar[3] != 0
+            ? sint_formats[components_count - 1]
+            : uint_formats[components_count - 1];
+        break;
+    default:
+        return false;
+    }
+    input->size = components_count * 4;
+
+    return true;
+}
+
+/// @param[in,out] parser
+/// @param[in] instruction `OpMemberDecorate` of at least four words
+/// @return `true` on success and `false` otherwise
+static bool spirv_member_decoration_add(
+    struct spirv_parser *parser, const uint32_t *instruction
+) {
+    if (parser->member_decorations_count == parser->member_decorations_capacity) {
+        size_t capacity = parser->member_decorations_capacity * 2 + 16;
+        struct spirv_member_decoration *member_decorations = realloc(
+            parser->member_decorations, sizeof(member_decorations[0]) * capacity
+        );
+        if (member_decorations == nullptr) {
+            return false;
+        }
+        parser->member_decorations = member_decorations;
+        parser->member_decorations_capacity = capacity;
+    }
+
+    parser->member_decorations[parser->member_decorations_count++] = (
+        (struct spirv_member_decoration){
+            .struct_id = instruction[1],
+            .member = instruction[2],
+            .decoration = instruction[3],
+            .value = (instruction[0] >> 16) > 4 ? instruction[4] : 0,
+        }
+    );
+
+    return true;
+}
+
+static int spirv_binding_compare(const void *a, const void *b) {
+    const struct spirv_binding *lhs = a;
+    const struct spirv_binding *rhs = b;
+
+    if (lhs->set != rhs->set) {
+        return lhs->set < rhs->set ? -1 : 1;
+    }
+
+    return (lhs->binding > rhs->binding) - (lhs->binding < rhs->binding);
+}
+
+static int spirv_input_compare(const void *a, const void *b) {
+    const struct spirv_input *lhs = a;
+    const struct spirv_input *rhs = b;
+
+    return (lhs->location > rhs->location) - (lhs->location < rhs->location);
+}
+
+/// @param[in] parser
+/// @param[in] variable_id
+/// @param[in,out] reflection
+/// @return `true` on success and `false` otherwise
+static bool spirv_variable_reflect(
+    const struct spirv_parser *parser,
+    uint32_t variable_id,
+    struct spirv_reflection *reflection
+) {
+    const struct spirv_id *variable = &parser->ids[variable_id];
+    uint32_t pointer_id = variable->instruction[1];
+    uint32_t storage_class = variable->instruction[3];
+
+    const uint32_t *pointer = spirv_instruction(parser, pointer_id, 4);
+    if (pointer == nullptr || (pointer[0] & 0xffff) != SPIRV_OP_TYPE_POINTER) {
+        fprintf(stderr, "spirv_variable_reflect: %%%u is not a pointer\n", variable_id);
+        return false;
+    }
+    uint32_t type_id = pointer[3];
+    if (type_id >= parser->ids_count) {
+        fprintf(stderr, "spirv_variable_reflect: id %u is out of bounds\n", type_id);
+        return false;
+    }
+
+    switch (storage_class) {
+    case SPIRV_STORAGE_CLASS_PUSH_CONSTANT: {
+        uint32_t offset = spirv_struct_offset(parser, type_id);
+        uint32_t size;
+        if (!spirv_type_size(parser, type_id, 0, &size)) {
+            fprintf(stderr, "spirv_variable_reflect: spirv_type_size failed\n");
+            return false;
+        }
+        reflection->push_constants = (VkPushConstantRange){
+            .stageFlags = reflection->stages,
+            .offset = offset,
+            .size = size - offset,
+        };
+        return true;
+    }
+    case SPIRV_STORAGE_CLASS_INPUT: {
+        if (
+            reflection->stages != VK_SHADER_STAGE_VERTEX_BIT ||
+            variable->builtin ||
+            parser->ids[type_id].block
+        ) {
+            return true;
+        }
+
+        struct spirv_input input;
+        uint32_t locations_count;
+        if (!spirv_input_describe(parser, type_id, &input, &locations_count)) {
+            fprintf(
+                stderr,
+                "spirv_variable_reflect: unsupported vertex input at location %u\n",
+                variable->location
+            );
+            return false;
+        }
+
+        for (uint32_t i = 0; i < locations_count; i++) {
+            if (reflection->inputs_count == SPIRV_MAX_INPUTS) {
+                fprintf(stderr, "spirv_variable_reflect: too many vertex inputs\n");
+                return false;
+            }
+            input.location = variable->location + i;
+            reflection->inputs[reflection->inputs_count++] = input;
+        }
+        return true;
+    }
+    default: {
+        struct spirv_binding binding = {
+            .set = variable->set,
+            .binding = variable->binding,
+            .stages = reflection->stages,
+        };
+        bool descriptor;
+        if (!spirv_descriptor_describe(
+            parser, type_id, storage_class, &binding, &descriptor
+        )) {
+            fprintf(
+                stderr, "spirv_variable_reflect: spirv_descriptor_describe failed\n"
+            );
+            return false;
+        }
+        if (!descriptor) {
+            return true;
+        }
+
+        if (reflection->bindings_count == SPIRV_MAX_BINDINGS) {
+            fprintf(stderr, "spirv_variable_reflect: too many bindings\n");
+            return false;
+        }
+        reflection->bindings[reflection->bindings_count++] = binding;
+        return true;
+    }
+    }
+}
+
+/// @param[in] opcode
+/// @return Words `spirv_reflect` reads of an instruction with `opcode`, zero
+/// for instructions it skips
+static uint32_t spirv_instruction_words(uint32_t opcode) {
+    switch (opcode) {
+    case SPIRV_OP_ENTRY_POINT:
+    case SPIRV_OP_TYPE_BOOL:
+    case SPIRV_OP_TYPE_INT:
+    case SPIRV_OP_TYPE_FLOAT:
+    case SPIRV_OP_TYPE_VECTOR:
+    case SPIRV_OP_TYPE_MATRIX:
+    case SPIRV_OP_TYPE_IMAGE:
+    case SPIRV_OP_TYPE_SAMPLER:
+    case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+    case SPIRV_OP_TYPE_ARRAY:
+    case SPIRV_OP_TYPE_RUNTIME_ARRAY:
+    case SPIRV_OP_TYPE_STRUCT:
+    case SPIRV_OP_TYPE_POINTER:
+    case SPIRV_OP_TYPE_ACCELERATION_STRUCTURE:
+        return 2;
+    case SPIRV_OP_DECORATE:
+        return 3;
+    case SPIRV_OP_CONSTANT:
+    case SPIRV_OP_SPEC_CONSTANT:
+    case SPIRV_OP_VARIABLE:
+    case SPIRV_OP_MEMBER_DECORATE:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+bool spirv_reflect(
+    const uint8_t *code, size_t code_size, struct spirv_reflection *reflection
+) {
+    bool success = false;
+
+    struct spirv_parser parser = {};
+    *reflection = (struct spirv_reflection){};
+
+    const uint32_t *words = (const uint32_t *) code;
+    size_t words_count = code_size / sizeof(uint32_t);
+
+    if (words_count < SPIRV_HEADER_WORDS || words[0] != SPIRV_MAGIC) {
+        fprintf(stderr, "spirv_reflect: not a SPIR-V module\n");
+        goto cleanup;
+    }
+
+    parser.ids_count = words[3];
+    parser.ids = calloc(parser.ids_count, sizeof(parser.ids[0]));
+    if (parser.ids == nullptr) {
+        fprintf(stderr, "spirv_reflect: calloc failed\n");
+        goto cleanup;
+    }
+
+    for (size_t i = SPIRV_HEADER_WORDS; i < words_count;) {
+        const uint32_t *instruction = &words[i];
+        uint32_t opcode = instruction[0] & 0xffff;
+        uint32_t instruction_words = instruction[0] >> 16;
+
+        if (instruction_words == 0 || i + instruction_words > words_count) {
+            fprintf(stderr, "spirv_reflect: truncated instruction at word %zu\n", i);
+            goto cleanup;
+        }
+
+        uint32_t words_required = spirv_instruction_words(opcode);
+        if (instruction_words < words_required) {
+            fprintf(stderr, "spirv_reflect: malformed instruction at word %zu\n", i);
+            goto cleanup;
+        }
+
+        // The first operand of every opcode handled below but the entry point
+        // is an id, other opcodes may have anything there
+        uint32_t result_id = words_required > 0 ? instruction[1] : 0;
+        if (result_id >= parser.ids_count && opcode != SPIRV_OP_ENTRY_POINT) {
+            fprintf(stderr, "spirv_reflect: id %u is out of bounds\n", result_id);
+            goto cleanup;
+        }
+
+        switch (opcode) {
+        case SPIRV_OP_ENTRY_POINT:
+            switch (instruction[1]) {
+            case SPIRV_EXECUTION_MODEL_VERTEX:
+                reflection->stages |= VK_SHADER_STAGE_VERTEX_BIT;
+                break;
+            case SPIRV_EXECUTION_MODEL_TESSELLATION_CONTROL:
+                reflection->stages |= VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+                break;
+            case SPIRV_EXECUTION_MODEL_TESSELLATION_EVALUATION:
+                reflection->stages |= VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+                break;
+            case SPIRV_EXECUTION_MODEL_GEOMETRY:
+                reflection->stages |= VK_SHADER_STAGE_GEOMETRY_BIT;
+                break;
+            case SPIRV_EXECUTION_MODEL_FRAGMENT:
+                reflection->stages |= VK_SHADER_STAGE_FRAGMENT_BIT;
+                break;
+            case SPIRV_EXECUTION_MODEL_GL_COMPUTE:
+                reflection->stages |= VK_SHADER_STAGE_COMPUTE_BIT;
+                break;
+            }
+            break;
+        case SPIRV_OP_TYPE_BOOL:
+        case SPIRV_OP_TYPE_INT:
+        case SPIRV_OP_TYPE_FLOAT:
+        case SPIRV_OP_TYPE_VECTOR:
+        case SPIRV_OP_TYPE_MATRIX:
+        case SPIRV_OP_TYPE_IMAGE:
+        case SPIRV_OP_TYPE_SAMPLER:
+        case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+        case SPIRV_OP_TYPE_ARRAY:
+        case SPIRV_OP_TYPE_RUNTIME_ARRAY:
+        case SPIRV_OP_TYPE_STRUCT:
+        case SPIRV_OP_TYPE_POINTER:
+        case SPIRV_OP_TYPE_ACCELERATION_STRUCTURE:
+            parser.ids[result_id].instruction = instruction;
+            break;
+        case SPIRV_OP_CONSTANT:
+        case SPIRV_OP_SPEC_CONSTANT:
+        case SPIRV_OP_VARIABLE:
+            if (instruction[2] >= parser.ids_count) {
+                fprintf(stderr, "spirv_reflect: malformed instruction at word %zu\n", i);
+                goto cleanup;
+            }
+            parser.ids[instruction[2]].instruction = instruction;
+            break;
+        case SPIRV_OP_DECORATE: {
+            struct spirv_id *target = &parser.ids[result_id];
+            uint32_t value = instruction_words > 3 ? instruction[3] : 0;
+            switch (instruction[2]) {
+            case SPIRV_DECORATION_BLOCK:
+                target->block = true;
+                break;
+            case SPIRV_DECORATION_BUFFER_BLOCK:
+                target->buffer_block = true;
+                break;
+            case SPIRV_DECORATION_ARRAY_STRIDE:
+                target->array_stride = value;
+                break;
+            case SPIRV_DECORATION_BUILTIN:
+                target->builtin = true;
+                break;
+            case SPIRV_DECORATION_LOCATION:
+                target->location = value;
+                break;
+            case SPIRV_DECORATION_BINDING:
+                target->binding = value;
+                break;
+            case SPIRV_DECORATION_DESCRIPTOR_SET:
+                target->set = value;
+                break;
+            }
+            break;
+        }
+        case SPIRV_OP_MEMBER_DECORATE:
+            if (!spirv_member_decoration_add(&parser, instruction)) {
+                fprintf(stderr, "spirv_reflect: spirv_member_decoration_add failed\n");
+                goto cleanup;
+            }
+            if (instruction[3] == SPIRV_DECORATION_BUILTIN) {
+                parser.ids[result_id].builtin = true;
+            }
+            break;
+        }
+
+        i += instruction_words;
+    }
+
+    for (uint32_t id = 0; id < parser.ids_count; id++) {
+        if (spirv_opcode(&parser, id) != SPIRV_OP_VARIABLE) {
+            continue;
+        }
+        if (!spirv_variable_reflect(&parser, id, reflection)) {
+            fprintf(stderr, "spirv_reflect: spirv_variable_reflect(%%%u) failed\n", id);
+            goto cleanup;
+        }
+    }
+
+    qsort(
+        reflection->bindings,
+        reflection->bindings_count,
+        sizeof(reflection->bindings[0]),
+        spirv_binding_compare
+    );
+    qsort(
+        reflection->inputs,
+        reflection->inputs_count,
+        sizeof(reflection->inputs[0]),
+        spirv_input_compare
+    );
+
+    success = true;
+
+cleanup:
+    free(parser.member_decorations);
+    free(parser.ids);
+
+    return success;
+}
+
+bool spirv_reflection_merge(
+    struct spirv_reflection *merged, const struct spirv_reflection *reflection
+) {
+    merged->stages |= reflection->stages;
+
+    for (uint32_t i = 0; i < reflection->bindings_count; i++) {
+        const struct spirv_binding *binding = &reflection->bindings[i];
+
+        bool found = false;
+        for (uint32_t j = 0; j < merged->bindings_count; j++) {
+            struct spirv_binding *existing = &merged->bindings[j];
+            if (existing->set != binding->set || existing->binding != binding->binding) {
+                continue;
+            }
+
+            if (existing->type != binding->type || existing->count != binding->count) {
+                fprintf(
+                    stderr,
+                    "spirv_reflection_merge: stages disagree on set %u binding %u\n",
+                    binding->set,
+                    binding->binding
+                );
+                return false;
+            }
+            existing->stages |= binding->stages;
+            found = true;
+            break;
+        }
+        if (found) {
+            continue;
+        }
+
+        if (merged->bindings_count == SPIRV_MAX_BINDINGS) {
+            fprintf(stderr, "spirv_reflection_merge: too many bindings\n");
+            return false;
+        }
+        merged->bindings[merged->bindings_count++] = *binding;
+    }
+
+    qsort(
+        merged->bindings,
+        merged->bindings_count,
+        sizeof(merged->bindings[0]),
+        spirv_binding_compare
+    );
+
+    // A single range visible to every stage that declares push constants keeps
+    // overlapping blocks valid without tracking them per stage
+    if (reflection->push_constants.size != 0) {
+        if (merged->push_constants.size == 0) {
+            merged->push_constants = reflection->push_constants;
+        } else {
+            uint32_t begin = merged->push_constants.offset;
+            uint32_t end = begin + merged->push_constants.size;
+            uint32_t other_begin = reflection->push_constants.offset;
+            uint32_t other_end = other_begin + reflection->push_constants.size;
+
+            begin = other_begin < begin ? other_begin : begin;
+            end = other_end > end ? other_end : end;
+
+            merged->push_constants = (VkPushConstantRange){
+                .stageFlags = (
+                    merged->push_constants.stageFlags |
+                    reflection->push_constants.stageFlags
+                ),
+                .offset = begin,
+                .size = end - begin,
+            };
+        }
+    }
+
+    if (reflection->stages & VK_SHADER_STAGE_VERTEX_BIT) {
+        memcpy(merged->inputs, reflection->inputs, sizeof(merged->inputs));
+        merged->inputs_count = reflection->inputs_count;
+    }
+
+    return true;
+}
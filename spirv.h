@@ -0,0 +1,61 @@
+#ifndef SPIRV_H
+#define SPIRV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+constexpr uint8_t SPIRV_MAX_BINDINGS = 32;
+constexpr uint8_t SPIRV_MAX_INPUTS = 16;
+
+struct spirv_binding {
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType type;
+    /// Array length, zero for runtime-sized arrays
+    uint32_t count;
+    VkShaderStageFlags stages;
+};
+
+/// Vertex shader input, one per location
+struct spirv_input {
+    uint32_t location;
+    VkFormat format;
+    uint32_t size;
+};
+
+/// Interface of one or more shader stages as declared in their SPIR-V
+struct spirv_reflection {
+    VkShaderStageFlags stages;
+
+    struct spirv_binding bindings[SPIRV_MAX_BINDINGS];
+    uint32_t bindings_count;
+
+    /// Union of the push constant blocks of all stages, `size` is zero when
+    /// there are none
+    VkPushConstantRange push_constants;
+
+    /// Sorted by location
+    struct spirv_input inputs[SPIRV_MAX_INPUTS];
+    uint32_t inputs_count;
+};
+
+/// @param[in] code
+/// @param[in] code_size Size of `code` in bytes
+/// @param[out] reflection
+/// @return `true` on success and `false` otherwise
+bool spirv_reflect(
+    const uint8_t *code, size_t code_size, struct spirv_reflection *reflection
+);
+
+/// @param[in,out] merged
+/// @param[in] reflection
+/// @return `true` on success and `false` if the stages disagree about a binding
+/// @note Bindings used by several stages are merged into one entry with the
+/// stage flags combined
+bool spirv_reflection_merge(
+    struct spirv_reflection *merged, const struct spirv_reflection *reflection
+);
+
+#endif
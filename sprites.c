@@ -0,0 +1,710 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spirv.h"
+#include "sprites.h"
+
+/// Vertex inputs of `shaders/sprite_vertex.glsl`
+enum sprites_input {
+    SPRITES_INPUT_POSITION,
+    SPRITES_INPUT_SIZE,
+    SPRITES_INPUT_UV,
+    SPRITES_INPUT_COLOR,
+    SPRITES_INPUTS_COUNT,
+};
+
+/// `Viewport` push constant block of `shaders/sprite_vertex.glsl`
+struct sprites_viewport {
+    float scale[2];
+};
+
+/// @param[in,out] sprites
+/// @param[in,out] layoutcache
+/// @param[in] vertex_code
+/// @param[in] vertex_code_size
+/// @param[in] fragment_code
+/// @param[in] fragment_code_size
+/// @return `true` on success and `false` otherwise
+static bool sprites_layout_create(
+    struct sprites *sprites,
+    struct layoutcache *layoutcache,
+    const uint8_t *vertex_code,
+    size_t vertex_code_size,
+    const uint8_t *fragment_code,
+    size_t fragment_code_size
+) {
+    struct spirv_reflection vertex_reflection;
+    struct spirv_reflection fragment_reflection;
+    if (
+        !spirv_reflect(vertex_code, vertex_code_size, &vertex_reflection) ||
+        !spirv_reflect(fragment_code, fragment_code_size, &fragment_reflection)
+    ) {
+        fprintf(stderr, "sprites_layout_create: spirv_reflect failed\n");
+        return false;
+    }
+
+    struct spirv_reflection reflection = {};
+    if (
+        !spirv_reflection_merge(&reflection, &vertex_reflection) ||
+        !spirv_reflection_merge(&reflection, &fragment_reflection)
+    ) {
+        fprintf(stderr, "sprites_layout_create: spirv_reflection_merge failed\n");
+        return false;
+    }
+    if (
+        reflection.bindings_count != 1 ||
+        reflection.inputs_count != SPRITES_INPUTS_COUNT ||
+        reflection.push_constants.size != sizeof(struct sprites_viewport)
+    ) {
+        fprintf(stderr, "sprites_layout_create: unexpected shader interface\n");
+        return false;
+    }
+
+    VkDescriptorSetLayout setlayouts[LAYOUTCACHE_MAX_SETS];
+    uint32_t setlayouts_count;
+    if (!layoutcache_pipelinelayout_get(
+        layoutcache,
+        &reflection,
+        &sprites->layout,
+        setlayouts,
+        &setlayouts_count
+    )) {
+        fprintf(
+            stderr, "sprites_layout_create: layoutcache_pipelinelayout_get failed\n"
+        );
+        return false;
+    }
+    sprites->setlayout = setlayouts[0];
+
+    VkShaderModuleCreateInfo vertex_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pCode = (const uint32_t *) vertex_code,
+        .codeSize = vertex_code_size,
+    };
+    if (vkCreateShaderModule(
+        sprites->device, &vertex_info, nullptr, &sprites->vertex_shadermodule
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "sprites_layout_create: vkCreateShaderModule failed\n");
+        return false;
+    }
+
+    VkShaderModuleCreateInfo fragment_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pCode = (const uint32_t *) fragment_code,
+        .codeSize = fragment_code_size,
+    };
+    if (vkCreateShaderModule(
+        sprites->device, &fragment_info, nullptr, &sprites->fragment_shadermodule
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "sprites_layout_create: vkCreateShaderModule failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] sprites
+/// @param[in] render_pass
+/// @return `true` on success and `false` otherwise
+static bool sprites_pipelines_create(struct sprites *sprites, VkRenderPass render_pass) {
+    // `SDF` of `shaders/sprite_fragment.glsl`
+    static const VkBool32 sdf_values[SPRITES_BLEND_COUNT] = {
+        [SPRITES_BLEND_SDF] = VK_TRUE,
+    };
+    VkSpecializationMapEntry sdf_entry = {
+        .constantID = 0,
+        .size = sizeof(sdf_values[0]),
+    };
+    VkSpecializationInfo specializations[SPRITES_BLEND_COUNT];
+    VkPipelineShaderStageCreateInfo stages[SPRITES_BLEND_COUNT][2];
+    for (size_t i = 0; i < SPRITES_BLEND_COUNT; i++) {
+        specializations[i] = (VkSpecializationInfo){
+            .pMapEntries = &sdf_entry,
+            .mapEntryCount = 1,
+            .pData = &sdf_values[i],
+            .dataSize = sizeof(sdf_values[i]),
+        };
+        stages[i][0] = (VkPipelineShaderStageCreateInfo){
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = sprites->vertex_shadermodule,
+            .pName = "main",
+        };
+        stages[i][1] = (VkPipelineShaderStageCreateInfo){
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = sprites->fragment_shadermodule,
+            .pName = "main",
+            .pSpecializationInfo = &specializations[i],
+        };
+    }
+
+    VkVertexInputBindingDescription binding = {
+        .binding = 0,
+        .stride = sizeof(struct sprites_instance),
+        .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+    };
+    VkVertexInputAttributeDescription attributes[SPRITES_INPUTS_COUNT] = {
+        [SPRITES_INPUT_POSITION] = {
+            .location = SPRITES_INPUT_POSITION,
+            .format = VK_FORMAT_R32G32_SFLOAT,
+            .offset = offsetof(struct sprites_instance, position),
+        },
+        [SPRITES_INPUT_SIZE] = {
+            .location = SPRITES_INPUT_SIZE,
+            .format = VK_FORMAT_R32G32_SFLOAT,
+            .offset = offsetof(struct sprites_instance, size),
+        },
+        [SPRITES_INPUT_UV] = {
+            .location = SPRITES_INPUT_UV,
+            .format = VK_FORMAT_R16G16B16A16_UNORM,
+            .offset = offsetof(struct sprites_instance, uv),
+        },
+        [SPRITES_INPUT_COLOR] = {
+            .location = SPRITES_INPUT_COLOR,
+            .format = VK_FORMAT_R8G8B8A8_UNORM,
+            .offset = offsetof(struct sprites_instance, color),
+        },
+    };
+    VkPipelineVertexInputStateCreateInfo vertex_input = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .pVertexBindingDescriptions = &binding,
+        .vertexBindingDescriptionCount = 1,
+        .pVertexAttributeDescriptions = attributes,
+        .vertexAttributeDescriptionCount = SPRITES_INPUTS_COUNT,
+    };
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+    };
+    VkPipelineViewportStateCreateInfo viewport = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+    VkPipelineRasterizationStateCreateInfo rasterization = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = VK_CULL_MODE_NONE,
+        .frontFace = VK_FRONT_FACE_CLOCKWISE,
+        .lineWidth = 1.0f,
+    };
+    VkPipelineMultisampleStateCreateInfo multisample = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .minSampleShading = 1.0f,
+    };
+
+    VkDynamicState dynamic_states[] = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+    };
+    VkPipelineDynamicStateCreateInfo dynamic_state = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .pDynamicStates = dynamic_states,
+        .dynamicStateCount = sizeof(dynamic_states) / sizeof(dynamic_states[0]),
+    };
+
+    // Texels are not premultiplied, alpha only scales them
+    static const VkBlendFactor dst_factors[SPRITES_BLEND_COUNT] = {
+        [SPRITES_BLEND_ALPHA] = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+        [SPRITES_BLEND_ADDITIVE] = VK_BLEND_FACTOR_ONE,
+        [SPRITES_BLEND_SDF] = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+    };
+    VkPipelineColorBlendAttachmentState blend_attachments[SPRITES_BLEND_COUNT];
+    VkPipelineColorBlendStateCreateInfo color_blends[SPRITES_BLEND_COUNT];
+    VkGraphicsPipelineCreateInfo create_infos[SPRITES_BLEND_COUNT];
+    for (size_t i = 0; i < SPRITES_BLEND_COUNT; i++) {
+        blend_attachments[i] = (VkPipelineColorBlendAttachmentState){
+            .colorWriteMask = (
+                VK_COLOR_COMPONENT_R_BIT |
+                VK_COLOR_COMPONENT_G_BIT |
+                VK_COLOR_COMPONENT_B_BIT |
+                VK_COLOR_COMPONENT_A_BIT
+            ),
+            .blendEnable = VK_TRUE,
+            .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+            .dstColorBlendFactor = dst_factors[i],
+            .colorBlendOp = VK_BLEND_OP_ADD,
+            .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+            .alphaBlendOp = VK_BLEND_OP_ADD,
+        };
+        color_blends[i] = (VkPipelineColorBlendStateCreateInfo){
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .pAttachments = &blend_attachments[i],
+            .attachmentCount = 1,
+        };
+        create_infos[i] = (VkGraphicsPipelineCreateInfo){
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pStages = stages[i],
+            .stageCount = sizeof(stages[i]) / sizeof(stages[i][0]),
+            .pVertexInputState = &vertex_input,
+            .pInputAssemblyState = &input_assembly,
+            .pViewportState = &viewport,
+            .pRasterizationState = &rasterization,
+            .pMultisampleState = &multisample,
+            .pColorBlendState = &color_blends[i],
+            .pDynamicState = &dynamic_state,
+            .layout = sprites->layout,
+            .renderPass = render_pass,
+            .subpass = 0,
+            .basePipelineIndex = -1,
+        };
+    }
+
+    if (vkCreateGraphicsPipelines(
+        sprites->device,
+        VK_NULL_HANDLE,
+        SPRITES_BLEND_COUNT,
+        create_infos,
+        nullptr,
+        sprites->pipelines
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "sprites_pipelines_create: vkCreateGraphicsPipelines failed\n");
+        for (size_t i = 0; i < SPRITES_BLEND_COUNT; i++) {
+            sprites->pipelines[i] = VK_NULL_HANDLE;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] sprites
+/// @param[in,out] samplercache
+/// @return `true` on success and `false` otherwise
+static bool sprites_resources_create(
+    struct sprites *sprites, struct samplercache *samplercache
+) {
+    // Pages have no mips, sprites are drawn at about the size they are
+    struct samplercache_state sampler_state = {
+        .mag_filter = VK_FILTER_LINEAR,
+        .min_filter = VK_FILTER_LINEAR,
+        .mipmap_mode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .address_mode_u = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .address_mode_v = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .address_mode_w = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+    };
+    if (!samplercache_get(samplercache, &sampler_state, &sprites->sampler)) {
+        fprintf(stderr, "sprites_resources_create: samplercache_get failed\n");
+        return false;
+    }
+
+    VkDescriptorPoolSize pool_size = {
+        .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = SPRITES_MAX_PAGES,
+    };
+    VkDescriptorPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = SPRITES_MAX_PAGES,
+        .pPoolSizes = &pool_size,
+        .poolSizeCount = 1,
+    };
+    if (vkCreateDescriptorPool(
+        sprites->device, &pool_info, nullptr, &sprites->pool
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "sprites_resources_create: vkCreateDescriptorPool failed\n");
+        return false;
+    }
+
+    VkDescriptorSetLayout setlayouts[SPRITES_MAX_PAGES];
+    for (size_t i = 0; i < SPRITES_MAX_PAGES; i++) {
+        setlayouts[i] = sprites->setlayout;
+    }
+    VkDescriptorSetAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = sprites->pool,
+        .pSetLayouts = setlayouts,
+        .descriptorSetCount = SPRITES_MAX_PAGES,
+    };
+    if (vkAllocateDescriptorSets(
+        sprites->device, &allocate_info, sprites->sets
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "sprites_resources_create: vkAllocateDescriptorSets failed\n");
+        return false;
+    }
+
+    if (!buffer_create(
+        sprites->device,
+        sprites->memory_properties,
+        sizeof(struct sprites_instance) * sprites->capacity * sprites->frames_count,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &sprites->ring
+    )) {
+        fprintf(stderr, "sprites_resources_create: buffer_create failed\n");
+        return false;
+    }
+
+    sprites->instances = malloc(sizeof(sprites->instances[0]) * sprites->capacity);
+    sprites->batches = malloc(sizeof(sprites->batches[0]) * sprites->capacity);
+    if (sprites->instances == nullptr || sprites->batches == nullptr) {
+        fprintf(stderr, "sprites_resources_create: malloc failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool sprites_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    VkRenderPass render_pass,
+    struct layoutcache *layoutcache,
+    struct samplercache *samplercache,
+    const uint8_t *vertex_code,
+    size_t vertex_code_size,
+    const uint8_t *fragment_code,
+    size_t fragment_code_size,
+    size_t capacity,
+    uint32_t frames_count,
+    struct sprites *sprites
+) {
+    *sprites = (struct sprites){
+        .device = device,
+        .memory_properties = memory_properties,
+        .capacity = capacity,
+        .frames_count = frames_count,
+    };
+    atlas_create(SPRITES_PAGE_SIZE, SPRITES_PAGE_SIZE, 1, &sprites->atlas);
+
+    if (!sprites_layout_create(
+        sprites,
+        layoutcache,
+        vertex_code,
+        vertex_code_size,
+        fragment_code,
+        fragment_code_size
+    )) {
+        fprintf(stderr, "sprites_create: sprites_layout_create failed\n");
+        goto cleanup;
+    }
+
+    if (!sprites_pipelines_create(sprites, render_pass)) {
+        fprintf(stderr, "sprites_create: sprites_pipelines_create failed\n");
+        goto cleanup;
+    }
+
+    if (!sprites_resources_create(sprites, samplercache)) {
+        fprintf(stderr, "sprites_create: sprites_resources_create failed\n");
+        goto cleanup;
+    }
+
+    return true;
+
+cleanup:
+    sprites_destroy(sprites);
+
+    return false;
+}
+
+void sprites_destroy(struct sprites *sprites) {
+    free(sprites->batches);
+    free(sprites->instances);
+    buffer_destroy(sprites->device, &sprites->ring);
+    free(sprites->images);
+    for (size_t i = 0; i < SPRITES_MAX_PAGES; i++) {
+        texture_destroy(sprites->device, &sprites->pages[i]);
+        free(sprites->texels[i]);
+    }
+    atlas_destroy(&sprites->atlas);
+    vkDestroyDescriptorPool(sprites->device, sprites->pool, nullptr);
+    for (size_t i = 0; i < SPRITES_BLEND_COUNT; i++) {
+        vkDestroyPipeline(sprites->device, sprites->pipelines[i], nullptr);
+    }
+    vkDestroyShaderModule(sprites->device, sprites->fragment_shadermodule, nullptr);
+    vkDestroyShaderModule(sprites->device, sprites->vertex_shadermodule, nullptr);
+
+    *sprites = (struct sprites){};
+}
+
+/// @param[in] offset In texels
+/// @return `offset` in a page as a 16 bit normalized coordinate
+static uint16_t sprites_uv(uint32_t offset) {
+    return (uint16_t) (((uint64_t) offset * UINT16_MAX) / SPRITES_PAGE_SIZE);
+}
+
+bool sprites_image_add(
+    struct sprites *sprites,
+    uint32_t width,
+    uint32_t height,
+    const uint8_t *rgba,
+    uint32_t *image
+) {
+    if (sprites->images_count == sprites->images_capacity) {
+        size_t capacity = sprites->images_capacity * 2 + 8;
+        struct sprites_image *images = realloc(
+            sprites->images, sizeof(images[0]) * capacity
+        );
+        if (images == nullptr) {
+            fprintf(stderr, "sprites_image_add: realloc failed\n");
+            return false;
+        }
+        sprites->images = images;
+        sprites->images_capacity = capacity;
+    }
+
+    struct atlas_rect rect;
+    if (!atlas_insert(&sprites->atlas, width, height, &rect)) {
+        fprintf(stderr, "sprites_image_add: atlas_insert failed\n");
+        return false;
+    }
+    // The atlas could hold more pages, which would need more descriptors
+    if (rect.page >= SPRITES_MAX_PAGES) {
+        fprintf(stderr, "sprites_image_add: out of pages\n");
+        return false;
+    }
+
+    uint64_t row_size = 4 * (uint64_t) SPRITES_PAGE_SIZE;
+    if (sprites->texels[rect.page] == nullptr) {
+        sprites->texels[rect.page] = calloc(SPRITES_PAGE_SIZE, row_size);
+        if (sprites->texels[rect.page] == nullptr) {
+            fprintf(stderr, "sprites_image_add: malloc failed\n");
+            return false;
+        }
+    }
+
+    uint8_t *texels = sprites->texels[rect.page] + row_size * rect.y + 4 * rect.x;
+    for (uint32_t y = 0; y < height; y++) {
+        memcpy(texels + row_size * y, rgba + 4 * (size_t) width * y, 4 * (size_t) width);
+    }
+    sprites->pages_dirty[rect.page] = true;
+
+    *image = (uint32_t) sprites->images_count;
+    sprites->images[sprites->images_count++] = (struct sprites_image){
+        .page = rect.page,
+        .uv = {
+            sprites_uv(rect.x),
+            sprites_uv(rect.y),
+            sprites_uv(rect.x + width),
+            sprites_uv(rect.y + height),
+        },
+    };
+
+    return true;
+}
+
+/// @param[in,out] sprites
+/// @param[in] ktx2 Description of every page
+/// @param[in] page
+/// @return `true` on success and `false` otherwise
+static bool sprites_page_create(
+    struct sprites *sprites, const struct ktx2 *ktx2, uint32_t page
+) {
+    if (!texture_create(
+        sprites->device, sprites->memory_properties, ktx2, 0, &sprites->pages[page]
+    )) {
+        fprintf(stderr, "sprites_page_create: texture_create failed\n");
+        return false;
+    }
+
+    // The set has not been bound yet, so it can be written right away
+    VkDescriptorImageInfo image_info = {
+        .sampler = sprites->sampler,
+        .imageView = sprites->pages[page].view,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+    VkWriteDescriptorSet write = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = sprites->sets[page],
+        .dstBinding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .pImageInfo = &image_info,
+    };
+    vkUpdateDescriptorSets(sprites->device, 1, &write, 0, nullptr);
+
+    return true;
+}
+
+bool sprites_upload(
+    struct sprites *sprites, struct staging *staging, VkCommandBuffer command_buffer
+) {
+    // Pages are uploaded from their copy on the host as if from a file
+    struct ktx2 ktx2 = {
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .width = SPRITES_PAGE_SIZE,
+        .height = SPRITES_PAGE_SIZE,
+        .depth = 1,
+        .faces_count = 1,
+        .levels_count = 1,
+        .levels = {
+            {
+                .size = 4 * (uint64_t) SPRITES_PAGE_SIZE * SPRITES_PAGE_SIZE,
+            },
+        },
+    };
+    ktx2_format_block(ktx2.format, &ktx2.block);
+
+    struct ktx2 pages_ktx2[SPRITES_MAX_PAGES];
+    struct texture_upload uploads[SPRITES_MAX_PAGES];
+    size_t uploads_count = 0;
+    for (uint32_t page = 0; page < SPRITES_MAX_PAGES; page++) {
+        if (!sprites->pages_dirty[page]) {
+            continue;
+        }
+
+        if (
+            sprites->pages[page].image == VK_NULL_HANDLE &&
+            !sprites_page_create(sprites, &ktx2, page)
+        ) {
+            fprintf(stderr, "sprites_upload: sprites_page_create failed\n");
+            return false;
+        }
+
+        pages_ktx2[uploads_count] = ktx2;
+        pages_ktx2[uploads_count].content = sprites->texels[page];
+        pages_ktx2[uploads_count].content_size = ktx2.levels[0].size;
+        uploads[uploads_count] = (struct texture_upload){
+            .texture = &sprites->pages[page],
+            .ktx2 = &pages_ktx2[uploads_count],
+        };
+        uploads_count++;
+    }
+
+    if (!texture_upload(staging, command_buffer, uploads, uploads_count)) {
+        fprintf(stderr, "sprites_upload: texture_upload failed\n");
+        return false;
+    }
+
+    for (size_t i = 0; i < SPRITES_MAX_PAGES; i++) {
+        sprites->pages_dirty[i] = false;
+    }
+
+    return true;
+}
+
+bool sprites_draw(
+    struct sprites *sprites,
+    uint32_t image,
+    float x,
+    float y,
+    float width,
+    float height,
+    uint32_t color,
+    enum sprites_blend blend
+) {
+    if (sprites->instances_count == sprites->capacity) {
+        return false;
+    }
+    if (image >= sprites->images_count) {
+        fprintf(stderr, "sprites_draw: image %u is out of bounds\n", image);
+        return false;
+    }
+    if (blend >= SPRITES_BLEND_COUNT) {
+        fprintf(stderr, "sprites_draw: blend %u is out of bounds\n", (unsigned) blend);
+        return false;
+    }
+
+    const struct sprites_image *entry = &sprites->images[image];
+    size_t index = sprites->instances_count++;
+    sprites->instances[index] = (struct sprites_instance){
+        .position = {x, y},
+        .size = {width, height},
+        .uv = {entry->uv[0], entry->uv[1], entry->uv[2], entry->uv[3]},
+        .color = color,
+    };
+    sprites->batches[index] = (uint8_t) (blend * SPRITES_MAX_PAGES + entry->page);
+
+    return true;
+}
+
+void sprites_record(
+    struct sprites *sprites, VkCommandBuffer command_buffer, VkExtent2D extent
+) {
+    sprites->draws_count = 0;
+    if (sprites->instances_count == 0) {
+        return;
+    }
+
+    // A counting sort by batch, which keeps the order sprites were appended
+    // in within each batch and writes the ring front to back once
+    size_t counts[SPRITES_BATCHES_COUNT] = {};
+    for (size_t i = 0; i < sprites->instances_count; i++) {
+        counts[sprites->batches[i]]++;
+    }
+    size_t firsts[SPRITES_BATCHES_COUNT];
+    size_t cursors[SPRITES_BATCHES_COUNT];
+    size_t first = 0;
+    for (size_t i = 0; i < SPRITES_BATCHES_COUNT; i++) {
+        firsts[i] = first;
+        cursors[i] = first;
+        first += counts[i];
+    }
+
+    VkDeviceSize ring_offset = (
+        sizeof(struct sprites_instance) * sprites->capacity * sprites->frame
+    );
+    struct sprites_instance *ring = (struct sprites_instance *) (
+        (uint8_t *) sprites->ring.mapped + ring_offset
+    );
+    for (size_t i = 0; i < sprites->instances_count; i++) {
+        ring[cursors[sprites->batches[i]]++] = sprites->instances[i];
+    }
+
+    VkViewport viewport = {
+        .width = (float) extent.width,
+        .height = (float) extent.height,
+        .maxDepth = 1.0f,
+    };
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    VkRect2D scissor = {
+        .extent = extent,
+    };
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+    struct sprites_viewport viewport_constants = {
+        .scale = {2.0f / (float) extent.width, 2.0f / (float) extent.height},
+    };
+    vkCmdPushConstants(
+        command_buffer,
+        sprites->layout,
+        VK_SHADER_STAGE_VERTEX_BIT,
+        0,
+        sizeof(viewport_constants),
+        &viewport_constants
+    );
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &sprites->ring.buffer, &ring_offset);
+
+    size_t bound_blend = SIZE_MAX;
+    size_t bound_page = SIZE_MAX;
+    for (size_t i = 0; i < SPRITES_BATCHES_COUNT; i++) {
+        size_t blend = i / SPRITES_MAX_PAGES;
+        size_t page = i % SPRITES_MAX_PAGES;
+        if (counts[i] == 0 || sprites->pages[page].image == VK_NULL_HANDLE) {
+            continue;
+        }
+
+        if (blend != bound_blend) {
+            vkCmdBindPipeline(
+                command_buffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                sprites->pipelines[blend]
+            );
+            bound_blend = blend;
+        }
+        if (page != bound_page) {
+            vkCmdBindDescriptorSets(
+                command_buffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                sprites->layout,
+                0,
+                1,
+                &sprites->sets[page],
+                0,
+                nullptr
+            );
+            bound_page = page;
+        }
+
+        vkCmdDraw(command_buffer, 4, (uint32_t) counts[i], 0, (uint32_t) firsts[i]);
+        sprites->draws_count++;
+    }
+
+    sprites->instances_count = 0;
+    sprites->frame = (sprites->frame + 1) % sprites->frames_count;
+}
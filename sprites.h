@@ -0,0 +1,201 @@
+#ifndef SPRITES_H
+#define SPRITES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "atlas.h"
+#include "buffer.h"
+#include "layoutcache.h"
+#include "samplercache.h"
+#include "staging.h"
+#include "texture.h"
+
+/// Width and height of every atlas page
+constexpr uint32_t SPRITES_PAGE_SIZE = 1024;
+/// Atlas pages, each with a texture and descriptor set of its own
+constexpr size_t SPRITES_MAX_PAGES = 8;
+
+/// How sprites are blended into the color attachment
+enum sprites_blend {
+    /// Over what is below by their alpha
+    SPRITES_BLEND_ALPHA,
+    /// Added to what is below, scaled by their alpha
+    SPRITES_BLEND_ADDITIVE,
+    /// Over what is below, with the alpha of the texels read as a signed
+    /// distance field whose edge is at one half, for text that stays sharp
+    /// at any scale
+    SPRITES_BLEND_SDF,
+    SPRITES_BLEND_COUNT,
+};
+
+/// Every combination of blend mode and atlas page, drawn in this order
+constexpr size_t SPRITES_BATCHES_COUNT = SPRITES_BLEND_COUNT * SPRITES_MAX_PAGES;
+
+/// Per-instance vertex attributes of `shaders/sprite_vertex.glsl`
+struct sprites_instance {
+    float position[2];
+    float size[2];
+    /// `VK_FORMAT_R16G16B16A16_UNORM` top left and bottom right corner in the
+    /// atlas page
+    uint16_t uv[4];
+    /// `VK_FORMAT_R8G8B8A8_UNORM`, multiplied with the texels
+    uint32_t color;
+};
+
+/// Image packed into the atlas
+struct sprites_image {
+    uint32_t page;
+    uint16_t uv[4];
+};
+
+/// Draws many small images from a few atlas pages. Images are packed into the
+/// atlas as they are added and uploaded with the next frame. Sprites appended
+/// during a frame are sorted by blend mode and page into a persistently mapped
+/// ring of instances, and drawn with one instanced draw per combination that
+/// is used.
+struct sprites {
+    VkDevice device;
+    const VkPhysicalDeviceMemoryProperties *memory_properties;
+
+    VkShaderModule vertex_shadermodule;
+    VkShaderModule fragment_shadermodule;
+    /// Owned by the layout cache
+    VkPipelineLayout layout;
+    VkDescriptorSetLayout setlayout;
+    VkPipeline pipelines[SPRITES_BLEND_COUNT];
+    /// Owned by the sampler cache
+    VkSampler sampler;
+
+    VkDescriptorPool pool;
+    VkDescriptorSet sets[SPRITES_MAX_PAGES];
+
+    struct atlas atlas;
+    /// RGBA8 texels of every page, kept to upload pages again as they fill up
+    uint8_t *texels[SPRITES_MAX_PAGES];
+    /// Created with the first upload of their page
+    struct texture pages[SPRITES_MAX_PAGES];
+    /// Pages with images added since their last upload
+    bool pages_dirty[SPRITES_MAX_PAGES];
+
+    struct sprites_image *images;
+    size_t images_count;
+    size_t images_capacity;
+
+    /// `capacity` instances for each of `frames_count` frames
+    struct buffer ring;
+    size_t capacity;
+    uint32_t frames_count;
+    /// Part of `ring` the next frame writes
+    uint32_t frame;
+
+    /// Appended since the last `sprites_record`, in the order they were
+    /// appended
+    struct sprites_instance *instances;
+    /// Batch of each instance, its blend mode times `SPRITES_MAX_PAGES` plus
+    /// its page
+    uint8_t *batches;
+    size_t instances_count;
+
+    /// Draws the last `sprites_record` recorded
+    size_t draws_count;
+};
+
+/// @param[in] device
+/// @param[in] memory_properties Must outlive `sprites`
+/// @param[in] render_pass Subpass 0 is drawn into
+/// @param[in,out] layoutcache Without set layout flags
+/// @param[in,out] samplercache
+/// @param[in] vertex_code SPIR-V of `shaders/sprite_vertex.glsl`
+/// @param[in] vertex_code_size
+/// @param[in] fragment_code SPIR-V of `shaders/sprite_fragment.glsl`
+/// @param[in] fragment_code_size
+/// @param[in] capacity Sprites per frame
+/// @param[in] frames_count Frames that can be in flight at once
+/// @param[out] sprites
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `sprites_destroy` after successful
+/// return
+bool sprites_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    VkRenderPass render_pass,
+    struct layoutcache *layoutcache,
+    struct samplercache *samplercache,
+    const uint8_t *vertex_code,
+    size_t vertex_code_size,
+    const uint8_t *fragment_code,
+    size_t fragment_code_size,
+    size_t capacity,
+    uint32_t frames_count,
+    struct sprites *sprites
+);
+
+/// @param[in,out] sprites
+/// @note The device must be idle
+void sprites_destroy(struct sprites *sprites);
+
+/// Packs an image into the atlas
+/// @param[in,out] sprites
+/// @param[in] width
+/// @param[in] height
+/// @param[in] rgba Texels of 4 bytes, rows tightly packed
+/// @param[out] image Passed to `sprites_draw`
+/// @return `true` on success and `false` if the image does not fit into any
+/// of the `SPRITES_MAX_PAGES` pages
+bool sprites_image_add(
+    struct sprites *sprites,
+    uint32_t width,
+    uint32_t height,
+    const uint8_t *rgba,
+    uint32_t *image
+);
+
+/// Records the uploads of every page with images added since its last upload
+/// @param[in,out] sprites
+/// @param[in,out] staging
+/// @param[in] command_buffer Outside a render pass
+/// @return `true` on success and `false` otherwise
+/// @note The staging space belongs to the next `staging_submit`
+bool sprites_upload(
+    struct sprites *sprites, struct staging *staging, VkCommandBuffer command_buffer
+);
+
+/// Appends a sprite to the current frame
+/// @param[in,out] sprites
+/// @param[in] image
+/// @param[in] x Left edge in pixels
+/// @param[in] y Top edge in pixels
+/// @param[in] width
+/// @param[in] height
+/// @param[in] color RGBA8 with red in the lowest byte
+/// @param[in] blend
+/// @return `true` on success and `false` if the frame has `capacity` sprites
+/// already, `image` was not added or `blend` is out of bounds
+bool sprites_draw(
+    struct sprites *sprites,
+    uint32_t image,
+    float x,
+    float y,
+    float width,
+    float height,
+    uint32_t color,
+    enum sprites_blend blend
+);
+
+/// Writes the sprites appended since the last call into the ring, sorted by
+/// blend mode and page and otherwise in the order they were appended, and
+/// records their draws
+/// @param[in,out] sprites
+/// @param[in] command_buffer Inside subpass 0 of the render pass
+/// @param[in] extent Of the framebuffer
+/// @note Sprites on pages still waiting for their first upload are skipped
+/// @note The part of the ring written must not be in use by the device, which
+/// holds when no more than `frames_count` frames are in flight
+void sprites_record(
+    struct sprites *sprites, VkCommandBuffer command_buffer, VkExtent2D extent
+);
+
+#endif
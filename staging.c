@@ -0,0 +1,113 @@
+#include <stdio.h>
+
+#include "staging.h"
+
+bool staging_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    VkDeviceSize size,
+    struct staging *staging
+) {
+    *staging = (struct staging){
+        .device = device,
+    };
+
+    // Written once by the host and read once by the device, so memory the
+    // host does not have to flush is preferred over device local memory
+    if (!buffer_create(
+        device,
+        memory_properties,
+        size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        0,
+        &staging->buffer
+    )) {
+        fprintf(stderr, "staging_create: buffer_create failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+void staging_destroy(struct staging *staging) {
+    buffer_destroy(staging->device, &staging->buffer);
+
+    *staging = (struct staging){};
+}
+
+bool staging_allocate(
+    struct staging *staging,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    VkDeviceSize *offset
+) {
+    VkDeviceSize capacity = staging->buffer.size;
+
+    // An empty ring starts over at the front, which keeps large allocations
+    // from failing only because of where the last one ended
+    if (staging->used == 0) {
+        staging->head = 0;
+    }
+
+    VkDeviceSize start = (staging->head + alignment - 1) / alignment * alignment;
+    if (start > capacity || size > capacity - start) {
+        start = 0;
+    }
+    if (size > capacity - start) {
+        return false;
+    }
+
+    // Skipping to the front gives up the rest of the buffer until the
+    // submission is released
+    VkDeviceSize end = start + size;
+    VkDeviceSize consumed = start >= staging->head
+        ? end - staging->head
+        : capacity - staging->head + end;
+    if (consumed > capacity - staging->used) {
+        return false;
+    }
+
+    staging->head = end;
+    staging->used += consumed;
+    staging->pending += consumed;
+    *offset = start;
+
+    return true;
+}
+
+bool staging_submit(struct staging *staging, uint64_t *serial) {
+    if (staging->submissions_count == STAGING_MAX_SUBMISSIONS) {
+        fprintf(stderr, "staging_submit: too many submissions\n");
+        return false;
+    }
+
+    size_t index = (staging->submissions_first + staging->submissions_count) %
+        STAGING_MAX_SUBMISSIONS;
+    staging->submissions[index] = (struct staging_submission){
+        .serial = staging->next_serial,
+        .size = staging->pending,
+    };
+    staging->submissions_count++;
+    staging->pending = 0;
+
+    *serial = staging->next_serial++;
+
+    return true;
+}
+
+void staging_release(struct staging *staging, uint64_t serial) {
+    while (staging->submissions_count > 0) {
+        const struct staging_submission *submission = (
+            &staging->submissions[staging->submissions_first]
+        );
+        if (submission->serial > serial) {
+            break;
+        }
+
+        staging->used -= submission->size;
+        staging->submissions_first = (staging->submissions_first + 1) %
+            STAGING_MAX_SUBMISSIONS;
+        staging->submissions_count--;
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef STAGING_H
+#define STAGING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "buffer.h"
+
+/// Submissions whose space can be waited for at the same time
+constexpr size_t STAGING_MAX_SUBMISSIONS = 16;
+
+/// Space handed out between two `staging_submit`
+struct staging_submission {
+    uint64_t serial;
+    VkDeviceSize size;
+};
+
+/// Host visible ring buffer that uploads are written into before the device
+/// copies them where they belong. Space is handed out front to back and wraps
+/// around, and is given back a whole submission at a time once the device has
+/// finished reading it.
+struct staging {
+    VkDevice device;
+    struct buffer buffer;
+
+    /// Next byte handed out
+    VkDeviceSize head;
+    /// Bytes handed out and not given back, including the padding skipped for
+    /// alignment and at the end of the buffer
+    VkDeviceSize used;
+    /// Part of `used` handed out since the last `staging_submit`
+    VkDeviceSize pending;
+
+    /// Oldest first
+    struct staging_submission submissions[STAGING_MAX_SUBMISSIONS];
+    size_t submissions_first;
+    size_t submissions_count;
+    uint64_t next_serial;
+};
+
+/// @param[in] device
+/// @param[in] memory_properties
+/// @param[in] size
+/// @param[out] staging
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `staging_destroy` after successful
+/// return
+bool staging_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    VkDeviceSize size,
+    struct staging *staging
+);
+
+/// @param[in,out] staging
+/// @note The device must be done with every submission
+void staging_destroy(struct staging *staging);
+
+/// @param[in,out] staging
+/// @param[in] size
+/// @param[in] alignment Of the returned offset, non-zero
+/// @param[out] offset Into `staging->buffer`, whose mapping is written at the
+/// same offset
+/// @return `true` on success and `false` if the ring has no room until
+/// earlier submissions are released
+bool staging_allocate(
+    struct staging *staging,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    VkDeviceSize *offset
+);
+
+/// Closes the space handed out since the previous call into one submission
+/// @param[in,out] staging
+/// @param[out] serial Passed to `staging_release` once the device has
+/// finished every command reading the space
+/// @return `true` on success and `false` if `STAGING_MAX_SUBMISSIONS` are
+/// still waiting to be released
+bool staging_submit(struct staging *staging, uint64_t *serial);
+
+/// @param[in,out] staging
+/// @param[in] serial
+/// @note Gives back the space of the submission `serial` and of every one
+/// before it
+void staging_release(struct staging *staging, uint64_t serial);
+
+#endif
@@ -0,0 +1,84 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stats.h"
+
+uint64_t stats_time_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+void stats_series_record(struct stats_series *series, uint64_t value) {
+    series->samples[series->samples_count % STATS_SERIES_CAPACITY] = value;
+    series->samples_count++;
+}
+
+static int stats_sample_compare(const void *a, const void *b) {
+    uint64_t lhs = *(const uint64_t *) a;
+    uint64_t rhs = *(const uint64_t *) b;
+
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+/// @param[in] sorted
+/// @param[in] sorted_count
+/// @param[in] percentile
+/// @return Nearest-rank percentile in milliseconds
+static double stats_percentile(
+    const uint64_t *sorted, size_t sorted_count, double percentile
+) {
+    size_t rank = (size_t) (percentile / 100.0 * (double) sorted_count);
+    if (rank >= sorted_count) {
+        rank = sorted_count - 1;
+    }
+
+    return (double) sorted[rank] / 1e6;
+}
+
+uint64_t stats_series_median(const struct stats_series *series) {
+    size_t sorted_count = series->samples_count;
+    if (sorted_count > STATS_SERIES_CAPACITY) {
+        sorted_count = STATS_SERIES_CAPACITY;
+    }
+    if (sorted_count == 0) {
+        return 0;
+    }
+
+    uint64_t sorted[STATS_SERIES_CAPACITY];
+    memcpy(sorted, series->samples, sizeof(sorted[0]) * sorted_count);
+    qsort(sorted, sorted_count, sizeof(sorted[0]), stats_sample_compare);
+
+    return sorted[sorted_count / 2];
+}
+
+void stats_series_report(const struct stats_series *series, FILE *stream) {
+    size_t sorted_count = series->samples_count;
+    if (sorted_count > STATS_SERIES_CAPACITY) {
+        sorted_count = STATS_SERIES_CAPACITY;
+    }
+    if (sorted_count == 0) {
+        fprintf(stream, "%-28s n=0\n", series->name);
+        return;
+    }
+
+    uint64_t sorted[STATS_SERIES_CAPACITY];
+    memcpy(sorted, series->samples, sizeof(sorted[0]) * sorted_count);
+    qsort(sorted, sorted_count, sizeof(sorted[0]), stats_sample_compare);
+
+    fprintf(
+        stream,
+        "%-28s n=%zu min=%.3f p50=%.3f p90=%.3f p99=%.3f max=%.3f (ms)\n",
+        series->name,
+        sorted_count,
+        (double) sorted[0] / 1e6,
+        stats_percentile(sorted, sorted_count, 50.0),
+        stats_percentile(sorted, sorted_count, 90.0),
+        stats_percentile(sorted, sorted_count, 99.0),
+        (double) sorted[sorted_count - 1] / 1e6
+    );
+}
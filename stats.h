@@ -0,0 +1,37 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+constexpr size_t STATS_SERIES_CAPACITY = 4096;
+
+/// Ring of the most recent samples of a single measurement. Samples are stored
+/// in nanoseconds and reported as a distribution in milliseconds.
+struct stats_series {
+    const char *name;
+
+    uint64_t samples[STATS_SERIES_CAPACITY];
+    size_t samples_count;
+};
+
+/// @return Monotonic time in nanoseconds
+uint64_t stats_time_now(void);
+
+/// @param[in,out] series
+/// @param[in] value
+/// @note Once the series is full the oldest sample is overwritten
+void stats_series_record(struct stats_series *series, uint64_t value);
+
+/// @param[in] series
+/// @return Median of the retained samples in nanoseconds, zero if there are
+/// none
+uint64_t stats_series_median(const struct stats_series *series);
+
+/// @param[in] series
+/// @param[in] stream
+/// @note Writes count, min, p50, p90, p99 and max of the retained samples
+void stats_series_report(const struct stats_series *series, FILE *stream);
+
+#endif
@@ -0,0 +1,927 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+
+#include "streaming.h"
+
+constexpr size_t STREAMING_INITIAL_CAPACITY = 64;
+/// Largest single read, so that cancellation and priorities take effect
+/// within large files too
+constexpr size_t STREAMING_CHUNK_SIZE = 4 << 20;
+/// `user_data` of the read on `wake_fd`, other reads carry their slot index
+constexpr uint64_t STREAMING_WAKE = UINT64_MAX;
+/// `user_data` of the cancellations of reads when the ring stopped working
+constexpr uint64_t STREAMING_CANCEL = UINT64_MAX - 1;
+
+/// @param[in] a
+/// @param[in] b
+/// @return `true` if `a` is started before `b`
+static bool streaming_read_before(
+    const struct streaming_read *a, const struct streaming_read *b
+) {
+    if (a->priority != b->priority) {
+        return a->priority > b->priority;
+    }
+
+    return a->id < b->id;
+}
+
+/// @param[in,out] streaming
+/// @param[in] index
+/// @note Caller must hold `streaming->mutex`
+static void streaming_pending_up(struct streaming *streaming, size_t index) {
+    struct streaming_read *pending = streaming->pending;
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!streaming_read_before(&pending[index], &pending[parent])) {
+            break;
+        }
+
+        struct streaming_read read = pending[index];
+        pending[index] = pending[parent];
+        pending[parent] = read;
+        index = parent;
+    }
+}
+
+/// @param[in,out] streaming
+/// @param[in] index
+/// @note Caller must hold `streaming->mutex`
+static void streaming_pending_down(struct streaming *streaming, size_t index) {
+    struct streaming_read *pending = streaming->pending;
+    for (;;) {
+        size_t first = index;
+        for (size_t child = index * 2 + 1; child <= index * 2 + 2; child++) {
+            if (
+                child < streaming->pending_count &&
+                streaming_read_before(&pending[child], &pending[first])
+            ) {
+                first = child;
+            }
+        }
+        if (first == index) {
+            break;
+        }
+
+        struct streaming_read read = pending[index];
+        pending[index] = pending[first];
+        pending[first] = read;
+        index = first;
+    }
+}
+
+/// @param[in,out] streaming
+/// @param[in] index
+/// @param[out] read
+/// @note Caller must hold `streaming->mutex`
+static void streaming_pending_remove(
+    struct streaming *streaming, size_t index, struct streaming_read *read
+) {
+    *read = streaming->pending[index];
+
+    streaming->pending_count--;
+    if (index == streaming->pending_count) {
+        return;
+    }
+
+    streaming->pending[index] = streaming->pending[streaming->pending_count];
+    streaming_pending_down(streaming, index);
+    streaming_pending_up(streaming, index);
+}
+
+/// @param[in,out] array
+/// @param[in] element_size
+/// @param[in] count Elements that have to fit
+/// @param[in,out] capacity
+/// @return `true` on success and `false` otherwise
+static bool streaming_reserve(
+    void **array, size_t element_size, size_t count, size_t *capacity
+) {
+    if (count <= *capacity) {
+        return true;
+    }
+
+    size_t new_capacity = *capacity * 2 + 8;
+    void *new_array = realloc(*array, element_size * new_capacity);
+    if (new_array == nullptr) {
+        return false;
+    }
+
+    *array = new_array;
+    *capacity = new_capacity;
+
+    return true;
+}
+
+/// @param[in,out] streaming
+/// @param[in] completion
+/// @note Caller must hold `streaming->mutex`. `streaming_read` reserved room
+/// for every outstanding read, so this cannot fail.
+static void streaming_complete(
+    struct streaming *streaming, const struct streaming_completion *completion
+) {
+    streaming->completed[streaming->completed_count] = *completion;
+    streaming->completed_count++;
+
+    cnd_broadcast(&streaming->completed_available);
+}
+
+/// Moves the highest priority pending read into a free slot
+/// @param[in,out] streaming
+/// @param[out] slot
+/// @return `true` if a read was started
+static bool streaming_next(struct streaming *streaming, struct streaming_slot **slot) {
+    bool started = false;
+
+    mtx_lock(&streaming->mutex);
+    if (
+        !streaming->stopping &&
+        streaming->pending_count > 0 &&
+        streaming->slots_count < STREAMING_MAX_INFLIGHT
+    ) {
+        for (size_t i = 0; i < STREAMING_MAX_INFLIGHT; i++) {
+            if (!streaming->slots[i].used) {
+                *slot = &streaming->slots[i];
+                break;
+            }
+        }
+
+        **slot = (struct streaming_slot){
+            .used = true,
+            .fd = -1,
+        };
+        streaming_pending_remove(streaming, 0, &(*slot)->read);
+        streaming->slots_count++;
+        started = true;
+    }
+    mtx_unlock(&streaming->mutex);
+
+    return started;
+}
+
+/// @param[in,out] streaming
+/// @param[in] slot
+/// @return `true` if `slot` was cancelled since it started
+static bool streaming_slot_cancelled(
+    struct streaming *streaming, const struct streaming_slot *slot
+) {
+    mtx_lock(&streaming->mutex);
+    bool cancelled = slot->cancelled;
+    mtx_unlock(&streaming->mutex);
+
+    return cancelled;
+}
+
+/// @param[in,out] slot
+/// @return `true` on success and `false` otherwise
+static bool streaming_slot_open(struct streaming_slot *slot) {
+    const struct streaming_read *read = &slot->read;
+
+    slot->fd = open(read->filename, O_RDONLY | O_CLOEXEC);
+    if (slot->fd == -1) {
+        fprintf(stderr, "streaming_slot_open: open(\"%s\") failed\n", read->filename);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(slot->fd, &status) == -1) {
+        fprintf(stderr, "streaming_slot_open: fstat failed\n");
+        return false;
+    }
+
+    uint64_t file_size = (uint64_t) status.st_size;
+    uint64_t size = read->size;
+    if (size == 0 && read->offset <= file_size) {
+        size = file_size - read->offset;
+    }
+    if (read->offset > file_size || size > file_size - read->offset) {
+        fprintf(
+            stderr, "streaming_slot_open: \"%s\" is too small\n", read->filename
+        );
+        return false;
+    }
+
+    // One spare byte so that empty reads still get an allocation
+    slot->data = malloc(size + 1);
+    if (slot->data == nullptr) {
+        fprintf(stderr, "streaming_slot_open: malloc failed\n");
+        return false;
+    }
+    slot->size = size;
+
+    return true;
+}
+
+/// Frees `slot` and delivers its completion
+/// @param[in,out] streaming
+/// @param[in,out] slot
+/// @param[in] status
+static void streaming_slot_finish(
+    struct streaming *streaming,
+    struct streaming_slot *slot,
+    enum streaming_status status
+) {
+    if (slot->fd != -1) {
+        close(slot->fd);
+    }
+
+    mtx_lock(&streaming->mutex);
+    if (slot->cancelled) {
+        status = STREAMING_STATUS_CANCELLED;
+    }
+    if (status != STREAMING_STATUS_DONE) {
+        free(slot->data);
+    }
+
+    streaming_complete(streaming, &(struct streaming_completion){
+        .id = slot->read.id,
+        .user = slot->read.user,
+        .status = status,
+        .data = status == STREAMING_STATUS_DONE ? slot->data : nullptr,
+        .size = status == STREAMING_STATUS_DONE ? slot->size : 0,
+    });
+
+    *slot = (struct streaming_slot){.fd = -1};
+    streaming->slots_count--;
+    mtx_unlock(&streaming->mutex);
+}
+
+/// Runs one pending read to completion on the pread fallback
+/// @param[in,out] argument `struct streaming`
+static void streaming_worker(void *argument) {
+    struct streaming *streaming = argument;
+
+    struct streaming_slot *slot;
+    if (!streaming_next(streaming, &slot)) {
+        return;
+    }
+
+    if (!streaming_slot_open(slot)) {
+        streaming_slot_finish(streaming, slot, STREAMING_STATUS_FAILED);
+        return;
+    }
+
+    while (slot->done < slot->size) {
+        if (streaming_slot_cancelled(streaming, slot)) {
+            streaming_slot_finish(streaming, slot, STREAMING_STATUS_CANCELLED);
+            return;
+        }
+
+        size_t size = slot->size - slot->done;
+        ssize_t result = pread(
+            slot->fd,
+            slot->data + slot->done,
+            size < STREAMING_CHUNK_SIZE ? size : STREAMING_CHUNK_SIZE,
+            (off_t) (slot->read.offset + slot->done)
+        );
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            fprintf(
+                stderr, "streaming_worker: pread(\"%s\") failed\n", slot->read.filename
+            );
+            streaming_slot_finish(streaming, slot, STREAMING_STATUS_FAILED);
+            return;
+        }
+        slot->done += (size_t) result;
+    }
+
+    streaming_slot_finish(streaming, slot, STREAMING_STATUS_DONE);
+}
+
+/// Queues a read without submitting it
+/// @param[in,out] streaming
+/// @param[in] fd
+/// @param[out] data
+/// @param[in] size
+/// @param[in] offset
+/// @param[in] user_data
+static void streaming_uring_prepare(
+    struct streaming *streaming,
+    int fd,
+    void *data,
+    uint32_t size,
+    uint64_t offset,
+    uint64_t user_data
+) {
+    uint32_t tail = *streaming->sq_tail;
+    uint32_t index = tail & streaming->sq_mask;
+
+    struct io_uring_sqe *sqes = streaming->sqes;
+    sqes[index] = (struct io_uring_sqe){
+        .opcode = IORING_OP_READ,
+        .fd = fd,
+        .off = offset,
+        .addr = (uint64_t) (uintptr_t) data,
+        .len = size,
+        .user_data = user_data,
+    };
+    streaming->sq_array[index] = index;
+
+    atomic_store_explicit(
+        (_Atomic uint32_t *) streaming->sq_tail, tail + 1, memory_order_release
+    );
+}
+
+/// @param[in,out] streaming
+/// @param[in] slot
+static void streaming_uring_chunk_prepare(
+    struct streaming *streaming, struct streaming_slot *slot
+) {
+    size_t size = slot->size - slot->done;
+    streaming_uring_prepare(
+        streaming,
+        slot->fd,
+        slot->data + slot->done,
+        (uint32_t) (size < STREAMING_CHUNK_SIZE ? size : STREAMING_CHUNK_SIZE),
+        slot->read.offset + slot->done,
+        (uint64_t) (slot - streaming->slots)
+    );
+}
+
+/// @param[in,out] streaming
+static void streaming_uring_wake_prepare(struct streaming *streaming) {
+    streaming_uring_prepare(
+        streaming,
+        streaming->wake_fd,
+        &streaming->wake_value,
+        sizeof(streaming->wake_value),
+        0,
+        STREAMING_WAKE
+    );
+}
+
+/// @param[in,out] streaming
+/// @param[in] cqe
+static void streaming_uring_complete(
+    struct streaming *streaming, const struct io_uring_cqe *cqe
+) {
+    if (cqe->user_data == STREAMING_WAKE) {
+        streaming_uring_wake_prepare(streaming);
+        return;
+    }
+
+    struct streaming_slot *slot = &streaming->slots[cqe->user_data];
+    if (cqe->res == -EINTR || cqe->res == -EAGAIN) {
+        streaming_uring_chunk_prepare(streaming, slot);
+        return;
+    }
+    if (cqe->res <= 0) {
+        fprintf(
+            stderr,
+            "streaming_uring_complete: read(\"%s\") failed\n",
+            slot->read.filename
+        );
+        streaming_slot_finish(streaming, slot, STREAMING_STATUS_FAILED);
+        return;
+    }
+
+    slot->done += (size_t) cqe->res;
+    if (slot->done == slot->size) {
+        streaming_slot_finish(streaming, slot, STREAMING_STATUS_DONE);
+    } else if (streaming_slot_cancelled(streaming, slot)) {
+        streaming_slot_finish(streaming, slot, STREAMING_STATUS_CANCELLED);
+    } else {
+        streaming_uring_chunk_prepare(streaming, slot);
+    }
+}
+
+/// Queues a cancellation of the request with `user_data` without submitting it
+/// @param[in,out] streaming
+/// @param[in] user_data
+static void streaming_uring_cancel_prepare(
+    struct streaming *streaming, uint64_t user_data
+) {
+    uint32_t tail = *streaming->sq_tail;
+    uint32_t index = tail & streaming->sq_mask;
+
+    struct io_uring_sqe *sqes = streaming->sqes;
+    sqes[index] = (struct io_uring_sqe){
+        .opcode = IORING_OP_ASYNC_CANCEL,
+        .fd = -1,
+        .addr = user_data,
+        .user_data = STREAMING_CANCEL,
+    };
+    streaming->sq_array[index] = index;
+
+    atomic_store_explicit(
+        (_Atomic uint32_t *) streaming->sq_tail, tail + 1, memory_order_release
+    );
+}
+
+/// Cancels the reads the kernel still holds and waits for their completions,
+/// after which no read writes into the buffers of the slots anymore
+/// @param[in,out] streaming
+/// @param[out] inflight Whether the read of each slot may still complete
+/// @return `true` if every read completed and `false` if the ring stopped
+/// responding before
+static bool streaming_uring_drain(
+    struct streaming *streaming, bool inflight[STREAMING_MAX_INFLIGHT + 1]
+) {
+    // Every used slot has one read queued or in the kernel, as has the
+    // eventfd, which takes the last entry
+    size_t inflight_count = 1;
+    for (size_t i = 0; i < STREAMING_MAX_INFLIGHT; i++) {
+        inflight[i] = streaming->slots[i].used;
+        inflight_count += inflight[i] ? 1 : 0;
+    }
+    inflight[STREAMING_MAX_INFLIGHT] = true;
+
+    // Cancellations go after the reads still queued, as room frees up
+    size_t cancelled = 0;
+    while (inflight_count > 0) {
+        uint32_t head = atomic_load_explicit(
+            (_Atomic uint32_t *) streaming->sq_head, memory_order_acquire
+        );
+        for (; cancelled <= STREAMING_MAX_INFLIGHT
+               && *streaming->sq_tail - head <= streaming->sq_mask;
+             cancelled++) {
+            if (inflight[cancelled]) {
+                streaming_uring_cancel_prepare(
+                    streaming,
+                    cancelled == STREAMING_MAX_INFLIGHT ? STREAMING_WAKE
+                                                        : (uint64_t) cancelled
+                );
+            }
+        }
+
+        if (syscall(
+            __NR_io_uring_enter,
+            streaming->ring_fd,
+            *streaming->sq_tail - head,
+            1,
+            IORING_ENTER_GETEVENTS,
+            nullptr,
+            0
+        ) == -1 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            return false;
+        }
+
+        uint32_t cq_head = *streaming->cq_head;
+        uint32_t cq_tail = atomic_load_explicit(
+            (_Atomic uint32_t *) streaming->cq_tail, memory_order_acquire
+        );
+        const struct io_uring_cqe *cqes = streaming->cqes;
+        for (; cq_head != cq_tail; cq_head++) {
+            uint64_t user_data = cqes[cq_head & streaming->cq_mask].user_data;
+            size_t index = user_data == STREAMING_WAKE ? STREAMING_MAX_INFLIGHT
+                                                       : (size_t) user_data;
+            // Whether a cancellation found its read does not matter, only the
+            // completion of the read itself does
+            if (user_data != STREAMING_CANCEL && inflight[index]) {
+                inflight[index] = false;
+                inflight_count--;
+            }
+        }
+        atomic_store_explicit(
+            (_Atomic uint32_t *) streaming->cq_head, cq_head, memory_order_release
+        );
+    }
+
+    return true;
+}
+
+/// Fails every read after the ring stopped working
+/// @param[in,out] streaming
+static void streaming_uring_fail(struct streaming *streaming) {
+    // Closing the ring only cancels the reads the kernel holds, which may
+    // still write into their buffers afterwards, so the reads are cancelled
+    // and reaped first. Buffers of reads that could not be reaped are leaked.
+    bool inflight[STREAMING_MAX_INFLIGHT + 1];
+    if (!streaming_uring_drain(streaming, inflight)) {
+        fprintf(stderr, "streaming_uring_fail: reads could not be cancelled\n");
+    }
+    close(streaming->ring_fd);
+    streaming->ring_fd = -1;
+
+    for (size_t i = 0; i < STREAMING_MAX_INFLIGHT; i++) {
+        struct streaming_slot *slot = &streaming->slots[i];
+        if (slot->used) {
+            if (inflight[i]) {
+                slot->data = nullptr;
+            }
+            streaming_slot_finish(streaming, slot, STREAMING_STATUS_FAILED);
+        }
+    }
+
+    mtx_lock(&streaming->mutex);
+    streaming->failed = true;
+    while (streaming->pending_count > 0) {
+        struct streaming_read read;
+        streaming_pending_remove(streaming, 0, &read);
+        streaming_complete(streaming, &(struct streaming_completion){
+            .id = read.id,
+            .user = read.user,
+            .status = STREAMING_STATUS_FAILED,
+        });
+    }
+    mtx_unlock(&streaming->mutex);
+}
+
+static int streaming_uring_main(void *argument) {
+    struct streaming *streaming = argument;
+
+    streaming_uring_wake_prepare(streaming);
+
+    for (;;) {
+        // Everything queued here goes to the kernel in a single call
+        struct streaming_slot *slot;
+        while (streaming_next(streaming, &slot)) {
+            if (!streaming_slot_open(slot)) {
+                streaming_slot_finish(streaming, slot, STREAMING_STATUS_FAILED);
+            } else if (slot->size == 0) {
+                streaming_slot_finish(streaming, slot, STREAMING_STATUS_DONE);
+            } else {
+                streaming_uring_chunk_prepare(streaming, slot);
+            }
+        }
+
+        mtx_lock(&streaming->mutex);
+        bool stopped = streaming->stopping && streaming->slots_count == 0;
+        mtx_unlock(&streaming->mutex);
+        if (stopped) {
+            return 0;
+        }
+
+        uint32_t submit_count = *streaming->sq_tail - atomic_load_explicit(
+            (_Atomic uint32_t *) streaming->sq_head, memory_order_acquire
+        );
+        if (syscall(
+            __NR_io_uring_enter,
+            streaming->ring_fd,
+            submit_count,
+            1,
+            IORING_ENTER_GETEVENTS,
+            nullptr,
+            0
+        ) == -1 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            fprintf(stderr, "streaming_uring_main: io_uring_enter failed\n");
+            streaming_uring_fail(streaming);
+            return 0;
+        }
+
+        uint32_t head = *streaming->cq_head;
+        uint32_t tail = atomic_load_explicit(
+            (_Atomic uint32_t *) streaming->cq_tail, memory_order_acquire
+        );
+        const struct io_uring_cqe *cqes = streaming->cqes;
+        for (; head != tail; head++) {
+            streaming_uring_complete(streaming, &cqes[head & streaming->cq_mask]);
+        }
+        atomic_store_explicit(
+            (_Atomic uint32_t *) streaming->cq_head, head, memory_order_release
+        );
+    }
+}
+
+/// @param[in,out] streaming
+static void streaming_uring_destroy(struct streaming *streaming) {
+    if (streaming->sqes != nullptr) {
+        munmap(streaming->sqes, streaming->sqes_size);
+    }
+    if (streaming->ring != nullptr) {
+        munmap(streaming->ring, streaming->ring_size);
+    }
+    if (streaming->ring_fd != -1) {
+        close(streaming->ring_fd);
+    }
+    if (streaming->wake_fd != -1) {
+        close(streaming->wake_fd);
+    }
+
+    streaming->sqes = nullptr;
+    streaming->ring = nullptr;
+    streaming->ring_fd = -1;
+    streaming->wake_fd = -1;
+}
+
+/// @param[in,out] streaming
+/// @return `true` if an io_uring could be set up
+static bool streaming_uring_create(struct streaming *streaming) {
+    // Room for a read in every slot and the one on `wake_fd`
+    struct io_uring_params params = {};
+    int ring_fd = (int) syscall(
+        __NR_io_uring_setup, (unsigned) STREAMING_MAX_INFLIGHT + 1, &params
+    );
+    if (ring_fd == -1) {
+        return false;
+    }
+    streaming->ring_fd = ring_fd;
+
+    // Reads of the eventfd must be polled rather than block a kernel worker
+    constexpr uint32_t required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_FAST_POLL;
+    if ((params.features & required) != required) {
+        streaming_uring_destroy(streaming);
+        return false;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    size_t cq_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    streaming->ring_size = sq_size > cq_size ? sq_size : cq_size;
+    void *ring = mmap(
+        nullptr,
+        streaming->ring_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED,
+        ring_fd,
+        IORING_OFF_SQ_RING
+    );
+    if (ring == MAP_FAILED) {
+        streaming_uring_destroy(streaming);
+        return false;
+    }
+    streaming->ring = ring;
+
+    streaming->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(
+        nullptr,
+        streaming->sqes_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED,
+        ring_fd,
+        IORING_OFF_SQES
+    );
+    if (sqes == MAP_FAILED) {
+        streaming_uring_destroy(streaming);
+        return false;
+    }
+    streaming->sqes = sqes;
+
+    uint8_t *bytes = ring;
+    streaming->sq_head = (uint32_t *) (bytes + params.sq_off.head);
+    streaming->sq_tail = (uint32_t *) (bytes + params.sq_off.tail);
+    streaming->sq_mask = *(uint32_t *) (bytes + params.sq_off.ring_mask);
+    streaming->sq_array = (uint32_t *) (bytes + params.sq_off.array);
+    streaming->cq_head = (uint32_t *) (bytes + params.cq_off.head);
+    streaming->cq_tail = (uint32_t *) (bytes + params.cq_off.tail);
+    streaming->cq_mask = *(uint32_t *) (bytes + params.cq_off.ring_mask);
+    streaming->cqes = bytes + params.cq_off.cqes;
+
+    streaming->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (streaming->wake_fd == -1) {
+        streaming_uring_destroy(streaming);
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in] streaming
+static void streaming_uring_wake(const struct streaming *streaming) {
+    uint64_t value = 1;
+    if (write(streaming->wake_fd, &value, sizeof(value)) != sizeof(value)) {
+        fprintf(stderr, "streaming_uring_wake: write failed\n");
+    }
+}
+
+bool streaming_create(struct streaming *streaming) {
+    *streaming = (struct streaming){
+        .next_id = 1,
+        .ring_fd = -1,
+        .wake_fd = -1,
+    };
+
+    streaming->pending = malloc(
+        sizeof(streaming->pending[0]) * STREAMING_INITIAL_CAPACITY
+    );
+    streaming->completed = malloc(
+        sizeof(streaming->completed[0]) * STREAMING_INITIAL_CAPACITY
+    );
+    if (streaming->pending == nullptr || streaming->completed == nullptr) {
+        fprintf(stderr, "streaming_create: malloc failed\n");
+        goto cleanup;
+    }
+    streaming->pending_capacity = STREAMING_INITIAL_CAPACITY;
+    streaming->completed_capacity = STREAMING_INITIAL_CAPACITY;
+
+    if (mtx_init(&streaming->mutex, mtx_plain) != thrd_success) {
+        fprintf(stderr, "streaming_create: mtx_init failed\n");
+        goto cleanup;
+    }
+    if (cnd_init(&streaming->completed_available) != thrd_success) {
+        fprintf(stderr, "streaming_create: cnd_init failed\n");
+        mtx_destroy(&streaming->mutex);
+        goto cleanup;
+    }
+
+    if (streaming_uring_create(streaming)) {
+        if (thrd_create(
+            &streaming->thread, streaming_uring_main, streaming
+        ) == thrd_success) {
+            streaming->uring = true;
+            return true;
+        }
+        streaming_uring_destroy(streaming);
+    }
+
+    if (!jobs_create(&streaming->jobs, STREAMING_THREADS)) {
+        fprintf(stderr, "streaming_create: jobs_create failed\n");
+        cnd_destroy(&streaming->completed_available);
+        mtx_destroy(&streaming->mutex);
+        goto cleanup;
+    }
+
+    return true;
+
+cleanup:
+    free(streaming->completed);
+    free(streaming->pending);
+    *streaming = (struct streaming){};
+
+    return false;
+}
+
+void streaming_destroy(struct streaming *streaming) {
+    if (streaming->pending == nullptr) {
+        return;
+    }
+
+    mtx_lock(&streaming->mutex);
+    streaming->stopping = true;
+    for (size_t i = 0; i < STREAMING_MAX_INFLIGHT; i++) {
+        streaming->slots[i].cancelled = true;
+    }
+    mtx_unlock(&streaming->mutex);
+
+    if (streaming->uring) {
+        streaming_uring_wake(streaming);
+        thrd_join(streaming->thread, nullptr);
+        streaming_uring_destroy(streaming);
+    } else {
+        jobs_destroy(&streaming->jobs);
+    }
+
+    for (size_t i = 0; i < streaming->completed_count; i++) {
+        free(streaming->completed[i].data);
+    }
+    free(streaming->completed);
+    free(streaming->pending);
+    cnd_destroy(&streaming->completed_available);
+    mtx_destroy(&streaming->mutex);
+
+    *streaming = (struct streaming){};
+}
+
+bool streaming_read(
+    struct streaming *streaming, const struct streaming_request *request, uint64_t *id
+) {
+    size_t filename_size = strlen(request->filename);
+    if (filename_size >= STREAMING_MAX_FILENAME) {
+        fprintf(stderr, "streaming_read: filename is too long\n");
+        return false;
+    }
+
+    mtx_lock(&streaming->mutex);
+
+    if (streaming->failed) {
+        mtx_unlock(&streaming->mutex);
+        fprintf(stderr, "streaming_read: the backend has failed\n");
+        return false;
+    }
+
+    // Reserving the completion now means delivering it cannot fail
+    if (
+        !streaming_reserve(
+            (void **) &streaming->pending,
+            sizeof(streaming->pending[0]),
+            streaming->pending_count + 1,
+            &streaming->pending_capacity
+        ) ||
+        !streaming_reserve(
+            (void **) &streaming->completed,
+            sizeof(streaming->completed[0]),
+            streaming->outstanding_count + 1,
+            &streaming->completed_capacity
+        )
+    ) {
+        mtx_unlock(&streaming->mutex);
+        fprintf(stderr, "streaming_read: realloc failed\n");
+        return false;
+    }
+
+    struct streaming_read *read = &streaming->pending[streaming->pending_count];
+    *read = (struct streaming_read){
+        .id = streaming->next_id,
+        .offset = request->offset,
+        .size = request->size,
+        .priority = request->priority,
+        .user = request->user,
+    };
+    memcpy(read->filename, request->filename, filename_size + 1);
+    if (id != nullptr) {
+        *id = read->id;
+    }
+
+    streaming->next_id++;
+    streaming->pending_count++;
+    streaming->outstanding_count++;
+    streaming_pending_up(streaming, streaming->pending_count - 1);
+
+    mtx_unlock(&streaming->mutex);
+
+    if (streaming->uring) {
+        streaming_uring_wake(streaming);
+    } else if (!jobs_submit(&streaming->jobs, streaming_worker, streaming, nullptr)) {
+        streaming_worker(streaming);
+    }
+
+    return true;
+}
+
+bool streaming_cancel(struct streaming *streaming, uint64_t id) {
+    bool found = false;
+
+    mtx_lock(&streaming->mutex);
+
+    for (size_t i = 0; i < streaming->pending_count; i++) {
+        if (streaming->pending[i].id != id) {
+            continue;
+        }
+
+        struct streaming_read read;
+        streaming_pending_remove(streaming, i, &read);
+        streaming_complete(streaming, &(struct streaming_completion){
+            .id = read.id,
+            .user = read.user,
+            .status = STREAMING_STATUS_CANCELLED,
+        });
+        found = true;
+        break;
+    }
+
+    for (size_t i = 0; !found && i < STREAMING_MAX_INFLIGHT; i++) {
+        struct streaming_slot *slot = &streaming->slots[i];
+        if (slot->used && slot->read.id == id && !slot->cancelled) {
+            slot->cancelled = true;
+            found = true;
+        }
+    }
+
+    mtx_unlock(&streaming->mutex);
+
+    return found;
+}
+
+/// @param[in,out] streaming
+/// @param[out] completions
+/// @param[in] capacity
+/// @return Number of completions taken from the upload queue
+/// @note Caller must hold `streaming->mutex`
+static size_t streaming_take(
+    struct streaming *streaming,
+    struct streaming_completion *completions,
+    size_t capacity
+) {
+    size_t count = streaming->completed_count < capacity
+        ? streaming->completed_count
+        : capacity;
+    memcpy(completions, streaming->completed, sizeof(completions[0]) * count);
+    memmove(
+        streaming->completed,
+        streaming->completed + count,
+        sizeof(streaming->completed[0]) * (streaming->completed_count - count)
+    );
+    streaming->completed_count -= count;
+    streaming->outstanding_count -= count;
+
+    return count;
+}
+
+size_t streaming_poll(
+    struct streaming *streaming,
+    struct streaming_completion *completions,
+    size_t capacity
+) {
+    mtx_lock(&streaming->mutex);
+    size_t count = streaming_take(streaming, completions, capacity);
+    mtx_unlock(&streaming->mutex);
+
+    return count;
+}
+
+bool streaming_wait(
+    struct streaming *streaming, struct streaming_completion *completion
+) {
+    mtx_lock(&streaming->mutex);
+    while (streaming->outstanding_count > 0 && streaming->completed_count == 0) {
+        cnd_wait(&streaming->completed_available, &streaming->mutex);
+    }
+    size_t count = streaming_take(streaming, completion, 1);
+    mtx_unlock(&streaming->mutex);
+
+    return count == 1;
+}
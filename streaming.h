@@ -0,0 +1,169 @@
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <threads.h>
+
+#include "jobs.h"
+
+/// Reads the backend works on at the same time
+constexpr size_t STREAMING_MAX_INFLIGHT = 32;
+/// Workers of the pread fallback
+constexpr size_t STREAMING_THREADS = 4;
+constexpr size_t STREAMING_MAX_FILENAME = 256;
+
+enum streaming_status {
+    STREAMING_STATUS_DONE,
+    STREAMING_STATUS_FAILED,
+    STREAMING_STATUS_CANCELLED,
+};
+
+struct streaming_request {
+    const char *filename;
+    uint64_t offset;
+    /// Zero reads from `offset` to the end of the file
+    uint64_t size;
+    /// Higher priorities are started first, equal ones in submission order
+    int32_t priority;
+    /// Handed back in the completion
+    void *user;
+};
+
+/// Finished read waiting in the upload queue
+struct streaming_completion {
+    uint64_t id;
+    void *user;
+    enum streaming_status status;
+    /// `nullptr` unless `status` is `STREAMING_STATUS_DONE`, freed by the caller
+    uint8_t *data;
+    size_t size;
+};
+
+/// Read that has not been started yet
+struct streaming_read {
+    uint64_t id;
+    char filename[STREAMING_MAX_FILENAME];
+    uint64_t offset;
+    uint64_t size;
+    int32_t priority;
+    void *user;
+};
+
+/// Read the backend is working on
+struct streaming_slot {
+    bool used;
+    /// Set by `streaming_cancel`, the read is dropped at its next completion
+    bool cancelled;
+    struct streaming_read read;
+
+    int fd;
+    uint8_t *data;
+    size_t size;
+    size_t done;
+};
+
+/// Reads files off the calling thread. Requests wait in a priority queue
+/// until a slot is free, then one backend thread submits them in batches to
+/// an io_uring, or where io_uring is unavailable a small pool of workers
+/// reads them with pread. Finished reads are delivered into an upload queue
+/// that the render thread drains without blocking.
+struct streaming {
+    mtx_t mutex;
+    /// Signalled whenever a completion is delivered
+    cnd_t completed_available;
+    bool stopping;
+    /// Set when the ring broke, further reads are refused
+    bool failed;
+    uint64_t next_id;
+
+    /// Max-heap on priority, then on age
+    struct streaming_read *pending;
+    size_t pending_count;
+    size_t pending_capacity;
+
+    struct streaming_slot slots[STREAMING_MAX_INFLIGHT];
+    size_t slots_count;
+
+    /// The upload queue, oldest first
+    struct streaming_completion *completed;
+    size_t completed_count;
+    size_t completed_capacity;
+
+    /// Reads submitted and not yet taken from the upload queue
+    size_t outstanding_count;
+
+    /// Backend in use, the pread fallback uses `jobs`
+    bool uring;
+    thrd_t thread;
+    int ring_fd;
+    /// eventfd with a read always queued on the ring, written to wake the
+    /// backend thread when requests arrive
+    int wake_fd;
+    uint64_t wake_value;
+    /// Submission and completion rings share one mapping
+    void *ring;
+    size_t ring_size;
+    void *sqes;
+    size_t sqes_size;
+    uint32_t *sq_head;
+    uint32_t *sq_tail;
+    uint32_t sq_mask;
+    uint32_t *sq_array;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    uint32_t cq_mask;
+    void *cqes;
+
+    struct jobs jobs;
+};
+
+/// @param[out] streaming
+/// @return `true` on success and `false` otherwise
+/// @note Falls back to pread when the kernel has no io_uring or does not
+/// allow it
+/// @note Caller is responsible to call `streaming_destroy` after successful
+/// return
+bool streaming_create(struct streaming *streaming);
+
+/// @param[in,out] streaming
+/// @note Reads not started yet are cancelled, reads in flight are waited
+/// for, and completions still in the upload queue are freed
+void streaming_destroy(struct streaming *streaming);
+
+/// @param[in,out] streaming
+/// @param[in] request Copied, `filename` does not have to outlive the call
+/// @param[out] id Identifies the read in `streaming_cancel` and in its
+/// completion, may be `nullptr`
+/// @return `true` on success and `false` otherwise
+/// @note Every successful call results in exactly one completion
+bool streaming_read(
+    struct streaming *streaming, const struct streaming_request *request, uint64_t *id
+);
+
+/// @param[in,out] streaming
+/// @param[in] id
+/// @return `true` if the read was still pending or in flight, its completion
+/// then has `STREAMING_STATUS_CANCELLED`
+bool streaming_cancel(struct streaming *streaming, uint64_t id);
+
+/// Drains the upload queue without blocking
+/// @param[in,out] streaming
+/// @param[out] completions
+/// @param[in] capacity
+/// @return Number of completions written to `completions`
+size_t streaming_poll(
+    struct streaming *streaming,
+    struct streaming_completion *completions,
+    size_t capacity
+);
+
+/// @param[in,out] streaming
+/// @param[out] completion
+/// @return `true` once a completion was taken from the upload queue, `false`
+/// right away if no reads are outstanding
+bool streaming_wait(
+    struct streaming *streaming, struct streaming_completion *completion
+);
+
+#endif
@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "buffer.h"
+#include "texture.h"
+
+/// @param[in] ktx2
+/// @return View type that covers every layer and face of `ktx2`
+static VkImageViewType texture_viewtype(const struct ktx2 *ktx2) {
+    if (ktx2->faces_count == 6) {
+        return ktx2->layers_count > 0
+            ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY
+            : VK_IMAGE_VIEW_TYPE_CUBE;
+    }
+    if (ktx2->depth > 1) {
+        return VK_IMAGE_VIEW_TYPE_3D;
+    }
+
+    return ktx2->layers_count > 0 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+}
+
+/// @param[in] size
+/// @param[in] level
+/// @return Size of `level` in a chain starting at `size`
+static uint32_t texture_level_extent(uint32_t size, uint32_t level) {
+    return size >> level > 0 ? size >> level : 1;
+}
+
+/// @param[in] layout
+/// @param[out] stages That access subresources in `layout`
+/// @param[out] access
+static void texture_layout_access(
+    VkImageLayout layout, VkPipelineStageFlags *stages, VkAccessFlags *access
+) {
+    switch (layout) {
+    case VK_IMAGE_LAYOUT_UNDEFINED:
+        *stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        *access = 0;
+        break;
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+        *stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        *access = VK_ACCESS_TRANSFER_WRITE_BIT;
+        break;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+        *stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        *access = VK_ACCESS_TRANSFER_READ_BIT;
+        break;
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        *stages = (
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+        );
+        *access = VK_ACCESS_SHADER_READ_BIT;
+        break;
+    case VK_IMAGE_LAYOUT_GENERAL:
+        *stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        *access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        break;
+    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+        *stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        *access = (
+            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+        );
+        break;
+    default:
+        *stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        *access = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        break;
+    }
+}
+
+/// @param[in,out] texture
+/// @param[in] layout
+/// @param[out] barrier From `texture->layout` to `layout`, which becomes the
+/// tracked layout
+/// @param[in,out] src_stages Stages the barrier waits for are added
+/// @param[in,out] dst_stages Stages waiting for the barrier are added
+static void texture_barrier_init(
+    struct texture *texture,
+    VkImageLayout layout,
+    VkImageMemoryBarrier *barrier,
+    VkPipelineStageFlags *src_stages,
+    VkPipelineStageFlags *dst_stages
+) {
+    VkPipelineStageFlags src_stage;
+    VkAccessFlags src_access;
+    texture_layout_access(texture->layout, &src_stage, &src_access);
+    VkPipelineStageFlags dst_stage;
+    VkAccessFlags dst_access;
+    texture_layout_access(layout, &dst_stage, &dst_access);
+
+    *barrier = (VkImageMemoryBarrier){
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = src_access,
+        .dstAccessMask = dst_access,
+        .oldLayout = texture->layout,
+        .newLayout = layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = texture->image,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .levelCount = texture->levels_count,
+            .layerCount = texture->layers_count,
+        },
+    };
+    *src_stages |= src_stage;
+    *dst_stages |= dst_stage;
+
+    texture->layout = layout;
+}
+
+bool texture_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    const struct ktx2 *ktx2,
+    VkImageUsageFlags usage,
+    struct texture *texture
+) {
+    *texture = (struct texture){
+        .format = ktx2->format,
+        .extent = {
+            .width = ktx2->width,
+            .height = ktx2->height,
+            .depth = ktx2->depth,
+        },
+        .levels_count = ktx2->mips_generate ? ktx2_levels_max(ktx2) : ktx2->levels_count,
+        .layers_count = (
+            (ktx2->layers_count > 0 ? ktx2->layers_count : 1) * ktx2->faces_count
+        ),
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | usage,
+        .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    VkImageCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .flags = ktx2->faces_count == 6 ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0,
+        .imageType = ktx2->depth > 1 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D,
+        .format = texture->format,
+        .extent = texture->extent,
+        .mipLevels = texture->levels_count,
+        .arrayLayers = texture->layers_count,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = texture->usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    if (vkCreateImage(device, &create_info, nullptr, &texture->image) != VK_SUCCESS) {
+        fprintf(stderr, "texture_create: vkCreateImage failed\n");
+        return false;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, texture->image, &requirements);
+
+    uint32_t type_index;
+    if (
+        !buffer_memorytype_find(
+            memory_properties,
+            requirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            &type_index
+        ) &&
+        !buffer_memorytype_find(
+            memory_properties, requirements.memoryTypeBits, 0, &type_index
+        )
+    ) {
+        fprintf(stderr, "texture_create: no suitable memory type\n");
+        goto cleanup;
+    }
+
+    VkMemoryAllocateInfo allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = requirements.size,
+        .memoryTypeIndex = type_index,
+    };
+
+    if (vkAllocateMemory(
+        device, &allocate_info, nullptr, &texture->memory
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "texture_create: vkAllocateMemory failed\n");
+        goto cleanup;
+    }
+
+    if (vkBindImageMemory(device, texture->image, texture->memory, 0) != VK_SUCCESS) {
+        fprintf(stderr, "texture_create: vkBindImageMemory failed\n");
+        goto cleanup;
+    }
+
+    VkImageViewCreateInfo view_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = texture->image,
+        .viewType = texture_viewtype(ktx2),
+        .format = texture->format,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .levelCount = texture->levels_count,
+            .layerCount = texture->layers_count,
+        },
+    };
+
+    if (vkCreateImageView(device, &view_info, nullptr, &texture->view) != VK_SUCCESS) {
+        fprintf(stderr, "texture_create: vkCreateImageView failed\n");
+        goto cleanup;
+    }
+
+    return true;
+
+cleanup:
+    texture_destroy(device, texture);
+
+    return false;
+}
+
+void texture_destroy(VkDevice device, struct texture *texture) {
+    vkDestroyImageView(device, texture->view, nullptr);
+    vkDestroyImage(device, texture->image, nullptr);
+    vkFreeMemory(device, texture->memory, nullptr);
+
+    *texture = (struct texture){};
+}
+
+void texture_transition(
+    struct texture *texture, VkCommandBuffer command_buffer, VkImageLayout layout
+) {
+    if (texture->layout == layout) {
+        return;
+    }
+
+    VkImageMemoryBarrier barrier;
+    VkPipelineStageFlags src_stages = 0;
+    VkPipelineStageFlags dst_stages = 0;
+    texture_barrier_init(texture, layout, &barrier, &src_stages, &dst_stages);
+
+    vkCmdPipelineBarrier(
+        command_buffer, src_stages, dst_stages, 0, 0, nullptr, 0, nullptr, 1, &barrier
+    );
+}
+
+bool texture_upload(
+    struct staging *staging,
+    VkCommandBuffer command_buffer,
+    const struct texture_upload *uploads,
+    size_t uploads_count
+) {
+    if (uploads_count == 0) {
+        return true;
+    }
+
+    // Every texture gets one run of `KTX2_MAX_LEVELS` regions
+    VkBufferImageCopy *regions = malloc(
+        sizeof(regions[0]) * KTX2_MAX_LEVELS * uploads_count
+    );
+    VkImageMemoryBarrier *barriers = malloc(sizeof(barriers[0]) * uploads_count);
+    if (regions == nullptr || barriers == nullptr) {
+        fprintf(stderr, "texture_upload: malloc failed\n");
+        free(barriers);
+        free(regions);
+        return false;
+    }
+
+    bool success = false;
+
+    // Everything is staged before anything is recorded, so that running out
+    // of staging space leaves the command buffer untouched
+    for (size_t i = 0; i < uploads_count; i++) {
+        const struct ktx2 *ktx2 = uploads[i].ktx2;
+        const struct texture *texture = uploads[i].texture;
+        uint64_t alignment = ktx2_level_alignment(&ktx2->block);
+
+        for (uint32_t level = 0; level < ktx2->levels_count; level++) {
+            VkDeviceSize offset;
+            if (!staging_allocate(
+                staging, ktx2->levels[level].size, alignment, &offset
+            )) {
+                fprintf(stderr, "texture_upload: staging_allocate failed\n");
+                goto cleanup;
+            }
+            memcpy(
+                (uint8_t *) staging->buffer.mapped + offset,
+                ktx2->content + ktx2->levels[level].offset,
+                ktx2->levels[level].size
+            );
+
+            regions[KTX2_MAX_LEVELS * i + level] = (VkBufferImageCopy){
+                .bufferOffset = offset,
+                .imageSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level,
+                    .layerCount = texture->layers_count,
+                },
+                .imageExtent = {
+                    .width = texture_level_extent(texture->extent.width, level),
+                    .height = texture_level_extent(texture->extent.height, level),
+                    .depth = texture_level_extent(texture->extent.depth, level),
+                },
+            };
+        }
+    }
+
+    VkPipelineStageFlags src_stages = 0;
+    VkPipelineStageFlags dst_stages = 0;
+    for (size_t i = 0; i < uploads_count; i++) {
+        texture_barrier_init(
+            uploads[i].texture,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            &barriers[i],
+            &src_stages,
+            &dst_stages
+        );
+    }
+    vkCmdPipelineBarrier(
+        command_buffer,
+        src_stages,
+        dst_stages,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        (uint32_t) uploads_count,
+        barriers
+    );
+
+    for (size_t i = 0; i < uploads_count; i++) {
+        vkCmdCopyBufferToImage(
+            command_buffer,
+            staging->buffer.buffer,
+            uploads[i].texture->image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            uploads[i].ktx2->levels_count,
+            &regions[KTX2_MAX_LEVELS * i]
+        );
+    }
+
+    src_stages = 0;
+    dst_stages = 0;
+    for (size_t i = 0; i < uploads_count; i++) {
+        texture_barrier_init(
+            uploads[i].texture,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            &barriers[i],
+            &src_stages,
+            &dst_stages
+        );
+    }
+    vkCmdPipelineBarrier(
+        command_buffer,
+        src_stages,
+        dst_stages,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        (uint32_t) uploads_count,
+        barriers
+    );
+
+    success = true;
+
+cleanup:
+    free(barriers);
+    free(regions);
+
+    return success;
+}
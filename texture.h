@@ -0,0 +1,93 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "ktx2.h"
+#include "staging.h"
+
+/// Image with the format, extent, mip chain and layers of a KTX2 file, and the
+/// layout its subresources are left in by the commands recorded so far
+struct texture {
+    VkImage image;
+    VkDeviceMemory memory;
+    /// Every level and layer
+    VkImageView view;
+
+    VkFormat format;
+    VkExtent3D extent;
+    uint32_t levels_count;
+    /// Array layers times faces
+    uint32_t layers_count;
+    /// Every usage the image was created with
+    VkImageUsageFlags usage;
+
+    /// Layout every subresource is in after the commands recorded so far.
+    /// Only correct when command buffers execute in the order they were
+    /// recorded in.
+    VkImageLayout layout;
+};
+
+/// KTX2 file whose levels are copied into a texture created from it
+struct texture_upload {
+    struct texture *texture;
+    const struct ktx2 *ktx2;
+};
+
+/// @param[in] device
+/// @param[in] memory_properties
+/// @param[in] ktx2
+/// @param[in] usage Added to `VK_IMAGE_USAGE_SAMPLED_BIT` and
+/// `VK_IMAGE_USAGE_TRANSFER_DST_BIT`, e.g. `mipgen_usage` to generate mips
+/// @param[out] texture In `VK_IMAGE_LAYOUT_UNDEFINED`
+/// @return `true` on success and `false` otherwise
+/// @note With `ktx2->mips_generate` the image gets a full mip chain, of which
+/// only the base level is uploaded
+/// @note Caller is responsible to call `texture_destroy` after successful
+/// return
+bool texture_create(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties *memory_properties,
+    const struct ktx2 *ktx2,
+    VkImageUsageFlags usage,
+    struct texture *texture
+);
+
+/// @param[in] device
+/// @param[in,out] texture
+/// @note `texture` will be invalid after this function has been called
+void texture_destroy(VkDevice device, struct texture *texture);
+
+/// Records a barrier that moves every subresource from `texture->layout` to
+/// `layout`, waiting for the accesses the old layout implies
+/// @param[in,out] texture
+/// @param[in] command_buffer
+/// @param[in] layout
+/// @note Nothing is recorded if `texture` is in `layout` already, so writes in
+/// `VK_IMAGE_LAYOUT_GENERAL` need barriers of their own
+void texture_transition(
+    struct texture *texture, VkCommandBuffer command_buffer, VkImageLayout layout
+);
+
+/// Copies the levels of every upload into staging memory, then records one
+/// barrier for all textures, one copy per texture and one more barrier that
+/// leaves all of them in `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`
+/// @param[in,out] staging
+/// @param[in] command_buffer
+/// @param[in] uploads
+/// @param[in] uploads_count
+/// @return `true` on success and `false` otherwise
+/// @note Nothing is recorded on failure. Staging space taken before the
+/// failure is given back with the next submission.
+/// @note The staging space belongs to the next `staging_submit`
+bool texture_upload(
+    struct staging *staging,
+    VkCommandBuffer command_buffer,
+    const struct texture_upload *uploads,
+    size_t uploads_count
+);
+
+#endif
@@ -0,0 +1,819 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file.h"
+#include "hash.h"
+#include "stats.h"
+#include "variantcache.h"
+
+constexpr size_t VARIANTCACHE_INITIAL_CAPACITY = 64;
+
+/// @param[in] device
+/// @param[in] physicaldevice_properties
+/// @param[in] cache_filename
+/// @param[out] pipelinecache
+/// @return `true` on success and `false` otherwise
+static bool variantcache_pipelinecache_create(
+    VkDevice device,
+    const VkPhysicalDeviceProperties *physicaldevice_properties,
+    const char *cache_filename,
+    VkPipelineCache *pipelinecache
+) {
+    uint8_t *data = nullptr;
+    size_t data_size = 0;
+
+    if (
+        cache_filename != nullptr &&
+        file_exists(cache_filename) &&
+        file_read(cache_filename, &data, &data_size)
+    ) {
+        VkPipelineCacheHeaderVersionOne header;
+        bool compatible = data_size >= sizeof(header);
+        if (compatible) {
+            memcpy(&header, data, sizeof(header));
+            compatible = (
+                header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                header.vendorID == physicaldevice_properties->vendorID &&
+                header.deviceID == physicaldevice_properties->deviceID &&
+                memcmp(
+                    header.pipelineCacheUUID,
+                    physicaldevice_properties->pipelineCacheUUID,
+                    VK_UUID_SIZE
+                ) == 0
+            );
+        }
+        if (!compatible) {
+            fprintf(
+                stderr,
+                "variantcache_pipelinecache_create: ignoring stale \"%s\"\n",
+                cache_filename
+            );
+            free(data);
+            data = nullptr;
+            data_size = 0;
+        }
+    }
+
+    VkPipelineCacheCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pInitialData = data,
+        .initialDataSize = data_size,
+    };
+
+    VkResult result = vkCreatePipelineCache(device, &create_info, nullptr, pipelinecache);
+    free(data);
+    if (result != VK_SUCCESS) {
+        fprintf(
+            stderr,
+            "variantcache_pipelinecache_create: vkCreatePipelineCache failed\n"
+        );
+        return false;
+    }
+
+    return true;
+}
+
+bool variantcache_create(
+    VkDevice device,
+    const VkPhysicalDeviceProperties *physicaldevice_properties,
+    VkRenderPass render_pass,
+    bool libraries_supported,
+    uint32_t dynamic,
+    struct jobs *jobs,
+    const char *cache_filename,
+    struct variantcache *variantcache
+) {
+    *variantcache = (struct variantcache){
+        .device = device,
+        .libraries_supported = libraries_supported,
+        .dynamic = dynamic,
+        .render_pass = render_pass,
+        .jobs = jobs,
+    };
+
+    variantcache->entries = calloc(
+        VARIANTCACHE_INITIAL_CAPACITY, sizeof(variantcache->entries[0])
+    );
+    if (variantcache->entries == nullptr) {
+        fprintf(stderr, "variantcache_create: calloc failed\n");
+        return false;
+    }
+    variantcache->entries_capacity = VARIANTCACHE_INITIAL_CAPACITY;
+
+    if (!variantcache_pipelinecache_create(
+        device, physicaldevice_properties, cache_filename, &variantcache->pipelinecache
+    )) {
+        fprintf(
+            stderr, "variantcache_create: variantcache_pipelinecache_create failed\n"
+        );
+        free(variantcache->entries);
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in] device
+/// @param[in] pipelinecache
+/// @param[out] data
+/// @param[out] data_size
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible for freeing `data` after successful return
+static bool variantcache_pipelinecache_data(
+    VkDevice device, VkPipelineCache pipelinecache, uint8_t **data, size_t *data_size
+) {
+    if (vkGetPipelineCacheData(
+        device, pipelinecache, data_size, nullptr
+    ) != VK_SUCCESS) {
+        fprintf(
+            stderr, "variantcache_pipelinecache_data: vkGetPipelineCacheData failed\n"
+        );
+        return false;
+    }
+
+    *data = malloc(*data_size);
+    if (*data == nullptr) {
+        fprintf(stderr, "variantcache_pipelinecache_data: malloc failed\n");
+        return false;
+    }
+
+    if (vkGetPipelineCacheData(
+        device, pipelinecache, data_size, *data
+    ) != VK_SUCCESS) {
+        fprintf(
+            stderr, "variantcache_pipelinecache_data: vkGetPipelineCacheData failed\n"
+        );
+        free(*data);
+        return false;
+    }
+
+    return true;
+}
+
+/// @param[in,out] variantcache
+/// @note Every job of the batch must have run
+static void variantcache_batch_finish(struct variantcache *variantcache) {
+    if (vkMergePipelineCaches(
+        variantcache->device,
+        variantcache->pipelinecache,
+        (uint32_t) variantcache->batch_pipelinecaches_count,
+        variantcache->batch_pipelinecaches
+    ) != VK_SUCCESS) {
+        fprintf(stderr, "variantcache_batch_finish: vkMergePipelineCaches failed\n");
+    }
+
+    for (size_t i = 0; i < variantcache->batch_pipelinecaches_count; i++) {
+        vkDestroyPipelineCache(
+            variantcache->device, variantcache->batch_pipelinecaches[i], nullptr
+        );
+        variantcache->batch_pipelinecaches[i] = VK_NULL_HANDLE;
+    }
+
+    fprintf(
+        stderr,
+        "variantcache: built %zu pipelines on %zu threads in %.2f ms\n",
+        variantcache->batch_count,
+        variantcache->batch_pipelinecaches_count,
+        (double) (stats_time_now() - variantcache->batch_start_time) / 1e6
+    );
+
+    free(variantcache->batch_createinfos);
+    variantcache->batch_createinfos = nullptr;
+    variantcache->batch_pipelinecaches_count = 0;
+    variantcache->batch_count = 0;
+}
+
+void variantcache_wait(struct variantcache *variantcache) {
+    for (size_t i = 0; i < variantcache->entries_capacity; i++) {
+        struct variantcache_entry *entry = variantcache->entries[i];
+        if (entry != nullptr) {
+            jobs_counter_wait(variantcache->jobs, &entry->built);
+        }
+    }
+}
+
+void variantcache_destroy(struct variantcache *variantcache, const char *cache_filename) {
+    if (variantcache->entries == nullptr) {
+        return;
+    }
+
+    variantcache_wait(variantcache);
+
+    if (variantcache->batch_pipelinecaches_count > 0) {
+        variantcache_batch_finish(variantcache);
+    }
+
+    for (size_t i = 0; i < variantcache->entries_capacity; i++) {
+        struct variantcache_entry *entry = variantcache->entries[i];
+        if (entry == nullptr) {
+            continue;
+        }
+
+        vkDestroyPipeline(variantcache->device, entry->pipeline, nullptr);
+        vkDestroyPipeline(variantcache->device, entry->linked, nullptr);
+        free(entry);
+    }
+    free(variantcache->entries);
+
+    uint8_t *data;
+    size_t data_size;
+    if (
+        cache_filename != nullptr &&
+        variantcache_pipelinecache_data(
+            variantcache->device, variantcache->pipelinecache, &data, &data_size
+        )
+    ) {
+        file_write(cache_filename, data, data_size);
+        free(data);
+    }
+    vkDestroyPipelineCache(variantcache->device, variantcache->pipelinecache, nullptr);
+
+    *variantcache = (struct variantcache){};
+}
+
+/// @param[in] variant
+/// @param[in] library
+/// @return Hash of `variant` as a complete pipeline or as one of its libraries
+static uint64_t variantcache_hash(
+    const struct pipeline_variant *variant, enum pipeline_library library
+) {
+    uint64_t hash = pipeline_variant_hash(variant);
+    hash = hash_bytes(&library, sizeof(library), hash);
+
+    return hash;
+}
+
+/// @param[in] variantcache
+/// @param[in] variant
+/// @param[in] library
+/// @param[in] hash
+/// @return Slot holding `variant`, or the empty slot where it belongs
+static size_t variantcache_slot_find(
+    const struct variantcache *variantcache,
+    const struct pipeline_variant *variant,
+    enum pipeline_library library,
+    uint64_t hash
+) {
+    size_t mask = variantcache->entries_capacity - 1;
+    size_t slot = hash & mask;
+
+    for (;;) {
+        const struct variantcache_entry *entry = variantcache->entries[slot];
+        if (
+            entry == nullptr ||
+            (
+                entry->hash == hash &&
+                entry->library == library &&
+                pipeline_variant_equal(&entry->variant, variant)
+            )
+        ) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+/// @param[in,out] variantcache
+/// @return `true` on success and `false` otherwise
+static bool variantcache_grow(struct variantcache *variantcache) {
+    size_t capacity = variantcache->entries_capacity * 2;
+    struct variantcache_entry **entries = calloc(capacity, sizeof(entries[0]));
+    if (entries == nullptr) {
+        fprintf(stderr, "variantcache_grow: calloc failed\n");
+        return false;
+    }
+
+    for (size_t i = 0; i < variantcache->entries_capacity; i++) {
+        struct variantcache_entry *entry = variantcache->entries[i];
+        if (entry == nullptr) {
+            continue;
+        }
+
+        size_t slot = entry->hash & (capacity - 1);
+        while (entries[slot] != nullptr) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        entries[slot] = entry;
+    }
+
+    free(variantcache->entries);
+    variantcache->entries = entries;
+    variantcache->entries_capacity = capacity;
+
+    return true;
+}
+
+/// @param[in] entry
+/// @return Best pipeline built for `entry` so far, or `VK_NULL_HANDLE`
+static VkPipeline variantcache_entry_pipeline(const struct variantcache_entry *entry) {
+    switch (atomic_load_explicit(&entry->status, memory_order_acquire)) {
+    case VARIANTCACHE_STATUS_READY:
+        return entry->pipeline;
+    case VARIANTCACHE_STATUS_LINKED:
+        return entry->linked;
+    default:
+        return VK_NULL_HANDLE;
+    }
+}
+
+/// @param[in] entry
+/// @return `true` if every library of `entry` has been built
+static bool variantcache_entry_libraries_ready(const struct variantcache_entry *entry) {
+    for (size_t i = 0; i < PIPELINE_LIBRARY_COUNT; i++) {
+        if (
+            atomic_load_explicit(&entry->libraries[i]->status, memory_order_acquire) ==
+            VARIANTCACHE_STATUS_PENDING
+        ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @param[in,out] entry Complete pipeline that is still pending
+/// @note Waits for the libraries of `entry` and fast-links them
+static void variantcache_entry_link(struct variantcache_entry *entry) {
+    const struct variantcache *variantcache = entry->variantcache;
+
+    VkPipeline libraries[PIPELINE_LIBRARY_COUNT];
+    for (size_t i = 0; i < PIPELINE_LIBRARY_COUNT; i++) {
+        struct variantcache_entry *library = entry->libraries[i];
+        jobs_counter_wait(variantcache->jobs, &library->built);
+
+        if (atomic_load(&library->status) != VARIANTCACHE_STATUS_READY) {
+            fprintf(stderr, "variantcache_entry_link: library failed to compile\n");
+            atomic_store(&entry->status, VARIANTCACHE_STATUS_FAILED);
+            return;
+        }
+        libraries[i] = library->pipeline;
+    }
+
+    int status = VARIANTCACHE_STATUS_FAILED;
+    if (pipeline_library_link(
+        variantcache->device,
+        VK_NULL_HANDLE,
+        entry->variant.program->layout,
+        entry->variant.state.flags,
+        libraries,
+        false,
+        &entry->linked
+    )) {
+        status = VARIANTCACHE_STATUS_LINKED;
+    } else {
+        fprintf(stderr, "variantcache_entry_link: pipeline_library_link failed\n");
+    }
+
+    atomic_store_explicit(&entry->status, status, memory_order_release);
+}
+
+/// @param[in,out] entry
+/// @param[in] pipelinecache
+static void variantcache_entry_build(
+    struct variantcache_entry *entry, VkPipelineCache pipelinecache
+) {
+    const struct variantcache *variantcache = entry->variantcache;
+
+    int status = VARIANTCACHE_STATUS_FAILED;
+    if (entry->library != PIPELINE_LIBRARY_COUNT) {
+        if (pipeline_library_create(
+            variantcache->device,
+            pipelinecache,
+            variantcache->render_pass,
+            &entry->variant,
+            entry->library,
+            &entry->pipeline
+        )) {
+            status = VARIANTCACHE_STATUS_READY;
+        } else {
+            fprintf(
+                stderr, "variantcache_entry_build: pipeline_library_create failed\n"
+            );
+        }
+    } else if (variantcache->libraries_supported) {
+        if (atomic_load(&entry->status) == VARIANTCACHE_STATUS_PENDING) {
+            variantcache_entry_link(entry);
+        }
+        if (atomic_load(&entry->status) != VARIANTCACHE_STATUS_LINKED) {
+            return;
+        }
+
+        VkPipeline libraries[PIPELINE_LIBRARY_COUNT];
+        for (size_t i = 0; i < PIPELINE_LIBRARY_COUNT; i++) {
+            libraries[i] = entry->libraries[i]->pipeline;
+        }
+
+        // The fast-linked pipeline stays usable if optimizing fails
+        status = VARIANTCACHE_STATUS_LINKED;
+        if (pipeline_library_link(
+            variantcache->device,
+            pipelinecache,
+            entry->variant.program->layout,
+            entry->variant.state.flags,
+            libraries,
+            true,
+            &entry->pipeline
+        )) {
+            status = VARIANTCACHE_STATUS_READY;
+        } else {
+            fprintf(stderr, "variantcache_entry_build: pipeline_library_link failed\n");
+        }
+    } else if (entry->createinfo != nullptr) {
+        if (vkCreateGraphicsPipelines(
+            variantcache->device,
+            pipelinecache,
+            1,
+            &entry->createinfo->info,
+            nullptr,
+            &entry->pipeline
+        ) == VK_SUCCESS) {
+            status = VARIANTCACHE_STATUS_READY;
+        } else {
+            fprintf(
+                stderr, "variantcache_entry_build: vkCreateGraphicsPipelines failed\n"
+            );
+        }
+    } else if (pipeline_create(
+        variantcache->device,
+        pipelinecache,
+        variantcache->render_pass,
+        &entry->variant,
+        &entry->pipeline
+    )) {
+        status = VARIANTCACHE_STATUS_READY;
+    } else {
+        fprintf(stderr, "variantcache_entry_build: pipeline_create failed\n");
+    }
+
+    atomic_store_explicit(&entry->status, status, memory_order_release);
+}
+
+static void variantcache_compile_job(void *argument) {
+    struct variantcache_entry *entry = argument;
+    struct variantcache *variantcache = entry->variantcache;
+
+    variantcache_entry_build(entry, variantcache->pipelinecache);
+    atomic_fetch_sub_explicit(&variantcache->compiling, 1, memory_order_release);
+}
+
+static void variantcache_prewarm_job(void *argument) {
+    struct variantcache_entry *entry = argument;
+    struct variantcache *variantcache = entry->variantcache;
+
+    // Each thread only ever touches its own cache, so the partial caches need
+    // no locking and do not contend on the shared one
+    variantcache_entry_build(
+        entry, variantcache->batch_pipelinecaches[jobs_worker_index()]
+    );
+    atomic_fetch_sub_explicit(&variantcache->batch_remaining, 1, memory_order_release);
+}
+
+/// @param[in,out] variantcache
+/// @param[in] variant
+/// @param[in] library
+/// @param[in] hash
+/// @return New `VARIANTCACHE_STATUS_PENDING` entry for `variant`, or `nullptr`
+/// on failure
+static struct variantcache_entry *variantcache_entry_insert(
+    struct variantcache *variantcache,
+    const struct pipeline_variant *variant,
+    enum pipeline_library library,
+    uint64_t hash
+) {
+    // Keep the load factor at or below one half
+    if ((variantcache->entries_count + 1) * 2 > variantcache->entries_capacity) {
+        if (!variantcache_grow(variantcache)) {
+            return nullptr;
+        }
+    }
+    size_t slot = variantcache_slot_find(variantcache, variant, library, hash);
+
+    struct variantcache_entry *entry = malloc(sizeof(*entry));
+    if (entry == nullptr) {
+        fprintf(stderr, "variantcache_entry_insert: malloc failed\n");
+        return nullptr;
+    }
+    *entry = (struct variantcache_entry){
+        .variantcache = variantcache,
+        .hash = hash,
+        .variant = *variant,
+        .library = library,
+        .createinfo = nullptr,
+        .pipeline = VK_NULL_HANDLE,
+        .linked = VK_NULL_HANDLE,
+    };
+    atomic_init(&entry->status, VARIANTCACHE_STATUS_PENDING);
+    atomic_init(&entry->built.pending, 0);
+
+    variantcache->entries[slot] = entry;
+    variantcache->entries_count++;
+
+    return entry;
+}
+
+/// @param[in,out] variantcache
+/// @param[in] variant
+/// @param[in] library
+/// @return Entry for `library` of `variant`, queued for compilation if it is
+/// new, or `nullptr` on failure
+static struct variantcache_entry *variantcache_library_get(
+    struct variantcache *variantcache,
+    const struct pipeline_variant *variant,
+    enum pipeline_library library
+) {
+    struct pipeline_variant key = pipeline_library_key(variant, library);
+    uint64_t hash = variantcache_hash(&key, library);
+
+    size_t slot = variantcache_slot_find(variantcache, &key, library, hash);
+    if (variantcache->entries[slot] != nullptr) {
+        return variantcache->entries[slot];
+    }
+
+    struct variantcache_entry *entry = variantcache_entry_insert(
+        variantcache, &key, library, hash
+    );
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    atomic_fetch_add_explicit(&variantcache->compiling, 1, memory_order_relaxed);
+    if (!jobs_submit(
+        variantcache->jobs, variantcache_compile_job, entry, &entry->built
+    )) {
+        fprintf(stderr, "variantcache_library_get: jobs_submit failed\n");
+        atomic_store(&entry->status, VARIANTCACHE_STATUS_FAILED);
+        atomic_fetch_sub(&variantcache->compiling, 1);
+    }
+
+    return entry;
+}
+
+/// @param[in,out] variantcache
+/// @param[in] variant
+/// @param[in] compile_now Compile on the calling thread instead of a worker
+/// @return Entry for `variant`, or `nullptr` on failure
+static struct variantcache_entry *variantcache_entry_get(
+    struct variantcache *variantcache,
+    const struct pipeline_variant *variant,
+    bool compile_now
+) {
+    struct pipeline_variant key = *variant;
+    pipeline_state_dynamic_set(&key.state, variantcache->dynamic);
+    variant = &key;
+
+    uint64_t hash = variantcache_hash(variant, PIPELINE_LIBRARY_COUNT);
+
+    size_t slot = variantcache_slot_find(
+        variantcache, variant, PIPELINE_LIBRARY_COUNT, hash
+    );
+    if (variantcache->entries[slot] != nullptr) {
+        return variantcache->entries[slot];
+    }
+
+    struct variantcache_entry *entry = variantcache_entry_insert(
+        variantcache, variant, PIPELINE_LIBRARY_COUNT, hash
+    );
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    atomic_fetch_add_explicit(&variantcache->compiling, 1, memory_order_relaxed);
+
+    if (variantcache->libraries_supported) {
+        for (size_t i = 0; i < PIPELINE_LIBRARY_COUNT; i++) {
+            entry->libraries[i] = variantcache_library_get(variantcache, variant, i);
+            if (entry->libraries[i] == nullptr) {
+                atomic_store(&entry->status, VARIANTCACHE_STATUS_FAILED);
+                atomic_fetch_sub(&variantcache->compiling, 1);
+                return entry;
+            }
+        }
+
+        // Fast-linking is cheap enough to do right away, only the optimized
+        // pipeline is left to the workers
+        if (compile_now || variantcache_entry_libraries_ready(entry)) {
+            variantcache_entry_link(entry);
+        }
+        compile_now = false;
+    }
+
+    if (compile_now) {
+        variantcache_compile_job(entry);
+    } else if (!jobs_submit(
+        variantcache->jobs, variantcache_compile_job, entry, &entry->built
+    )) {
+        fprintf(stderr, "variantcache_entry_get: jobs_submit failed\n");
+        atomic_store(&entry->status, VARIANTCACHE_STATUS_FAILED);
+        atomic_fetch_sub(&variantcache->compiling, 1);
+    }
+
+    return entry;
+}
+
+bool variantcache_prewarm(
+    struct variantcache *variantcache,
+    const struct pipeline_variant *variants,
+    size_t variants_count
+) {
+    if (variantcache->batch_pipelinecaches_count > 0) {
+        fprintf(stderr, "variantcache_prewarm: previous batch is still pending\n");
+        return false;
+    }
+
+    variantcache->batch_start_time = stats_time_now();
+
+    struct pipeline_createinfo *createinfos = malloc(
+        sizeof(createinfos[0]) * variants_count
+    );
+    struct variantcache_entry **entries = malloc(
+        sizeof(entries[0]) * variants_count * PIPELINE_LIBRARY_COUNT
+    );
+    size_t entries_count = 0;
+    uint8_t *data = nullptr;
+    size_t data_size = 0;
+    bool result = false;
+
+    if (createinfos == nullptr || entries == nullptr) {
+        fprintf(stderr, "variantcache_prewarm: malloc failed\n");
+        goto cleanup;
+    }
+
+    // Gather every create info up front on this thread, the table is not
+    // safe to touch from the workers
+    for (size_t i = 0; i < variants_count; i++) {
+        struct pipeline_variant variant = variants[i];
+        pipeline_state_dynamic_set(&variant.state, variantcache->dynamic);
+
+        if (variantcache->libraries_supported) {
+            for (size_t j = 0; j < PIPELINE_LIBRARY_COUNT; j++) {
+                struct pipeline_variant key = pipeline_library_key(&variant, j);
+                uint64_t hash = variantcache_hash(&key, j);
+                size_t slot = variantcache_slot_find(variantcache, &key, j, hash);
+                if (variantcache->entries[slot] != nullptr) {
+                    continue;
+                }
+
+                struct variantcache_entry *entry = variantcache_entry_insert(
+                    variantcache, &key, j, hash
+                );
+                if (entry == nullptr) {
+                    goto cleanup;
+                }
+                entries[entries_count++] = entry;
+            }
+            continue;
+        }
+
+        uint64_t hash = variantcache_hash(&variant, PIPELINE_LIBRARY_COUNT);
+        size_t slot = variantcache_slot_find(
+            variantcache, &variant, PIPELINE_LIBRARY_COUNT, hash
+        );
+        if (variantcache->entries[slot] != nullptr) {
+            continue;
+        }
+
+        struct variantcache_entry *entry = variantcache_entry_insert(
+            variantcache, &variant, PIPELINE_LIBRARY_COUNT, hash
+        );
+        if (entry == nullptr) {
+            goto cleanup;
+        }
+
+        pipeline_createinfo_init(
+            &createinfos[entries_count], variantcache->render_pass, &entry->variant
+        );
+        entry->createinfo = &createinfos[entries_count];
+        entries[entries_count++] = entry;
+    }
+
+    if (entries_count == 0) {
+        result = true;
+        goto cleanup;
+    }
+
+    // Seed every partial cache with what the shared cache already knows, so
+    // pipelines from the cache file are still hits
+    if (!variantcache_pipelinecache_data(
+        variantcache->device, variantcache->pipelinecache, &data, &data_size
+    )) {
+        data = nullptr;
+        data_size = 0;
+    }
+
+    VkPipelineCacheCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pInitialData = data,
+        .initialDataSize = data_size,
+    };
+
+    size_t pipelinecaches_count = variantcache->jobs->threads_count + 1;
+    for (size_t i = 0; i < pipelinecaches_count; i++) {
+        if (vkCreatePipelineCache(
+            variantcache->device,
+            &create_info,
+            nullptr,
+            &variantcache->batch_pipelinecaches[i]
+        ) != VK_SUCCESS) {
+            fprintf(stderr, "variantcache_prewarm: vkCreatePipelineCache failed\n");
+            for (size_t j = 0; j < i; j++) {
+                vkDestroyPipelineCache(
+                    variantcache->device, variantcache->batch_pipelinecaches[j], nullptr
+                );
+            }
+            goto cleanup;
+        }
+    }
+
+    variantcache->batch_pipelinecaches_count = pipelinecaches_count;
+    variantcache->batch_createinfos = createinfos;
+    variantcache->batch_count = entries_count;
+    atomic_store(&variantcache->batch_remaining, entries_count);
+    createinfos = nullptr;
+
+    for (size_t i = 0; i < entries_count; i++) {
+        if (!jobs_submit(
+            variantcache->jobs, variantcache_prewarm_job, entries[i], &entries[i]->built
+        )) {
+            fprintf(stderr, "variantcache_prewarm: jobs_submit failed\n");
+            atomic_store(&entries[i]->status, VARIANTCACHE_STATUS_FAILED);
+            atomic_fetch_sub(&variantcache->batch_remaining, 1);
+        }
+    }
+
+    result = true;
+
+cleanup:
+    // Entries that were never queued would otherwise stay pending forever
+    if (!result) {
+        for (size_t i = 0; i < entries_count; i++) {
+            entries[i]->createinfo = nullptr;
+            atomic_store(&entries[i]->status, VARIANTCACHE_STATUS_FAILED);
+        }
+    }
+
+    free(data);
+    free(entries);
+    free(createinfos);
+
+    return result;
+}
+
+void variantcache_update(struct variantcache *variantcache) {
+    // The merge destination must not be in use, so wait until on demand
+    // compilations have drained as well
+    if (
+        variantcache->batch_pipelinecaches_count > 0 &&
+        atomic_load_explicit(&variantcache->batch_remaining, memory_order_acquire) == 0 &&
+        atomic_load_explicit(&variantcache->compiling, memory_order_acquire) == 0
+    ) {
+        variantcache_batch_finish(variantcache);
+    }
+}
+
+bool variantcache_fallback_set(
+    struct variantcache *variantcache, const struct pipeline_variant *variant
+) {
+    struct variantcache_entry *entry = variantcache_entry_get(
+        variantcache, variant, true
+    );
+    if (entry == nullptr) {
+        fprintf(stderr, "variantcache_fallback_set: variantcache_entry_get failed\n");
+        return false;
+    }
+
+    // The variant may already have been queued on a worker
+    while (
+        atomic_load_explicit(&entry->status, memory_order_acquire) ==
+        VARIANTCACHE_STATUS_PENDING
+    ) {
+        jobs_counter_wait(variantcache->jobs, &entry->built);
+    }
+
+    if (variantcache_entry_pipeline(entry) == VK_NULL_HANDLE) {
+        fprintf(stderr, "variantcache_fallback_set: fallback failed to compile\n");
+        return false;
+    }
+
+    variantcache->fallback = entry;
+
+    return true;
+}
+
+VkPipeline variantcache_get(
+    struct variantcache *variantcache, const struct pipeline_variant *variant
+) {
+    const struct variantcache_entry *entry = variantcache_entry_get(
+        variantcache, variant, false
+    );
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (entry != nullptr) {
+        pipeline = variantcache_entry_pipeline(entry);
+    }
+    if (pipeline == VK_NULL_HANDLE) {
+        pipeline = variantcache_entry_pipeline(variantcache->fallback);
+    }
+
+    return pipeline;
+}
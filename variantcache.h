@@ -0,0 +1,159 @@
+#ifndef VARIANTCACHE_H
+#define VARIANTCACHE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "jobs.h"
+#include "pipeline.h"
+
+enum variantcache_status {
+    VARIANTCACHE_STATUS_PENDING,
+    /// Fast-linked from libraries, the optimized pipeline is still being built
+    VARIANTCACHE_STATUS_LINKED,
+    VARIANTCACHE_STATUS_READY,
+    VARIANTCACHE_STATUS_FAILED,
+};
+
+struct variantcache;
+
+struct variantcache_entry {
+    struct variantcache *variantcache;
+
+    uint64_t hash;
+    struct pipeline_variant variant;
+    /// Part of a pipeline this entry holds, `PIPELINE_LIBRARY_COUNT` for
+    /// complete pipelines
+    enum pipeline_library library;
+    /// Parts a complete pipeline is linked from when libraries are supported
+    struct variantcache_entry *libraries[PIPELINE_LIBRARY_COUNT];
+
+    /// Gathered by `variantcache_prewarm`, `nullptr` for variants compiled on
+    /// demand. Only valid until the entry is built.
+    const struct pipeline_createinfo *createinfo;
+
+    /// Only valid once `status` is `VARIANTCACHE_STATUS_READY`
+    VkPipeline pipeline;
+    /// Only valid once `status` is `VARIANTCACHE_STATUS_LINKED` or later, kept
+    /// until destruction since frames in flight may still use it
+    VkPipeline linked;
+    atomic_int status;
+    /// Done once `status` has left `VARIANTCACHE_STATUS_PENDING`
+    struct jobs_counter built;
+};
+
+/// Pipelines keyed by `pipeline_variant_hash`. Variants that are not in the
+/// cache yet are compiled on the job system against a shared
+/// `VkPipelineCache` while the fallback variant is drawn in their place.
+///
+/// With `VK_EXT_graphics_pipeline_library` the parts of each variant are
+/// compiled up front instead, new variants are fast-linked from them on demand
+/// and replaced by a link time optimized pipeline once that has been built.
+struct variantcache {
+    VkDevice device;
+    bool libraries_supported;
+    /// Mask of `pipeline_dynamic` applied to every variant, variants that
+    /// only differ in dynamic state share one pipeline
+    uint32_t dynamic;
+    VkRenderPass render_pass;
+    VkPipelineCache pipelinecache;
+    struct jobs *jobs;
+    /// On demand compilations in flight against `pipelinecache`
+    atomic_size_t compiling;
+
+    /// One cache per thread for the `variantcache_prewarm` batch, indexed by
+    /// `jobs_worker_index`, merged into `pipelinecache` once it is done
+    VkPipelineCache batch_pipelinecaches[JOBS_MAX_THREADS + 1];
+    size_t batch_pipelinecaches_count;
+    struct pipeline_createinfo *batch_createinfos;
+    size_t batch_count;
+    atomic_size_t batch_remaining;
+    uint64_t batch_start_time;
+
+    /// Open addressing table, `entries_capacity` is a power of two
+    struct variantcache_entry **entries;
+    size_t entries_capacity;
+    size_t entries_count;
+
+    const struct variantcache_entry *fallback;
+};
+
+/// @param[in] device
+/// @param[in] physicaldevice_properties Used to validate the cache file
+/// @param[in] render_pass
+/// @param[in] libraries_supported `VK_EXT_graphics_pipeline_library` is
+/// enabled on `device`
+/// @param[in] dynamic Mask of `pipeline_dynamic` supported by `device`
+/// @param[in] jobs
+/// @param[in] cache_filename Initial `VkPipelineCache` data, ignored if it is
+/// missing or was written by a different device or driver
+/// @param[out] variantcache
+/// @return `true` on success and `false` otherwise
+/// @note Caller is responsible to call `variantcache_destroy` after successful
+/// return
+bool variantcache_create(
+    VkDevice device,
+    const VkPhysicalDeviceProperties *physicaldevice_properties,
+    VkRenderPass render_pass,
+    bool libraries_supported,
+    uint32_t dynamic,
+    struct jobs *jobs,
+    const char *cache_filename,
+    struct variantcache *variantcache
+);
+
+/// @param[in,out] variantcache
+/// @note Blocks until every compilation in flight has finished, the calling
+/// thread helps running them
+void variantcache_wait(struct variantcache *variantcache);
+
+/// @param[in,out] variantcache
+/// @param[in] cache_filename Receives the `VkPipelineCache` data, may be
+/// `nullptr`
+/// @note Waits for compilations in flight before destroying their pipelines
+void variantcache_destroy(struct variantcache *variantcache, const char *cache_filename);
+
+/// @param[in,out] variantcache
+/// @param[in] variants
+/// @param[in] variants_count
+/// @return `true` on success and `false` otherwise
+/// @note Gathers the create info of every variant that is not in the cache yet
+/// and compiles them across the job system. Only the libraries are compiled
+/// when they are supported. Must not be called again before
+/// `variantcache_update` has merged the previous batch.
+bool variantcache_prewarm(
+    struct variantcache *variantcache,
+    const struct pipeline_variant *variants,
+    size_t variants_count
+);
+
+/// @param[in,out] variantcache
+/// @note Merges the caches of a finished `variantcache_prewarm` batch into the
+/// shared cache, call once per frame from the thread that calls
+/// `variantcache_get`
+void variantcache_update(struct variantcache *variantcache);
+
+/// @param[in,out] variantcache
+/// @param[in] variant
+/// @return `true` on success and `false` otherwise
+/// @note Compiles `variant` on the calling thread if it is not ready yet, and
+/// only waits for `variant` if it is already queued
+bool variantcache_fallback_set(
+    struct variantcache *variantcache, const struct pipeline_variant *variant
+);
+
+/// @param[in,out] variantcache
+/// @param[in] variant
+/// @return Pipeline for `variant` if it is ready, otherwise the fallback
+/// pipeline while `variant` is compiled in the background
+/// @note The state of `variant` covered by `dynamic` must still be set on the
+/// command buffer
+/// @note Must only be called from one thread
+VkPipeline variantcache_get(
+    struct variantcache *variantcache, const struct pipeline_variant *variant
+);
+
+#endif
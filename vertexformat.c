@@ -0,0 +1,233 @@
+#include <math.h>
+#include <string.h>
+
+#include "vertexformat.h"
+
+/// Vertex input of each format, `location` is the index into `attributes`
+static const struct {
+    size_t stride;
+    uint32_t attributes_count;
+    VkFormat formats[VERTEXFORMAT_MAX_ATTRIBUTES];
+    uint32_t offsets[VERTEXFORMAT_MAX_ATTRIBUTES];
+} vertexformat_layouts[VERTEXFORMAT_COUNT] = {
+    [VERTEXFORMAT_NONE] = {},
+    [VERTEXFORMAT_FLOAT32] = {
+        .stride = sizeof(struct vertexformat_vertex),
+        .attributes_count = 4,
+        .formats = {
+            VK_FORMAT_R32G32B32_SFLOAT,
+            VK_FORMAT_R32G32B32_SFLOAT,
+            VK_FORMAT_R32G32_SFLOAT,
+            VK_FORMAT_R32G32B32A32_SFLOAT,
+        },
+        .offsets = {
+            offsetof(struct vertexformat_vertex, position),
+            offsetof(struct vertexformat_vertex, normal),
+            offsetof(struct vertexformat_vertex, uv),
+            offsetof(struct vertexformat_vertex, color),
+        },
+    },
+    [VERTEXFORMAT_QUANTIZED] = {
+        .stride = sizeof(struct vertexformat_quantized),
+        .attributes_count = 4,
+        .formats = {
+            VK_FORMAT_R16G16B16A16_UNORM,
+            VK_FORMAT_R16G16_SNORM,
+            VK_FORMAT_R16G16_SFLOAT,
+            VK_FORMAT_R8G8B8A8_UNORM,
+        },
+        .offsets = {
+            offsetof(struct vertexformat_quantized, position),
+            offsetof(struct vertexformat_quantized, normal),
+            offsetof(struct vertexformat_quantized, uv),
+            offsetof(struct vertexformat_quantized, color),
+        },
+    },
+};
+
+size_t vertexformat_stride(enum vertexformat format) {
+    return vertexformat_layouts[format].stride;
+}
+
+uint32_t vertexformat_input(
+    enum vertexformat format,
+    VkVertexInputBindingDescription *binding,
+    VkVertexInputAttributeDescription attributes[VERTEXFORMAT_MAX_ATTRIBUTES]
+) {
+    *binding = (VkVertexInputBindingDescription){
+        .binding = 0,
+        .stride = (uint32_t) vertexformat_layouts[format].stride,
+        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+    };
+
+    uint32_t attributes_count = vertexformat_layouts[format].attributes_count;
+    for (uint32_t i = 0; i < attributes_count; i++) {
+        attributes[i] = (VkVertexInputAttributeDescription){
+            .location = i,
+            .binding = 0,
+            .format = vertexformat_layouts[format].formats[i],
+            .offset = vertexformat_layouts[format].offsets[i],
+        };
+    }
+
+    return attributes_count;
+}
+
+void vertexformat_decode_compute(
+    enum vertexformat format,
+    const struct vertexformat_vertex *vertices,
+    size_t vertices_count,
+    struct vertexformat_decode *decode
+) {
+    *decode = (struct vertexformat_decode){
+        .offset = {0.0f, 0.0f, 0.0f, 0.0f},
+        .scale = {1.0f, 1.0f, 1.0f, 1.0f},
+    };
+
+    if (format != VERTEXFORMAT_QUANTIZED || vertices_count == 0) {
+        return;
+    }
+
+    float min[3];
+    float max[3];
+    for (size_t j = 0; j < 3; j++) {
+        min[j] = vertices[0].position[j];
+        max[j] = vertices[0].position[j];
+    }
+    for (size_t i = 1; i < vertices_count; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            min[j] = fminf(min[j], vertices[i].position[j]);
+            max[j] = fmaxf(max[j], vertices[i].position[j]);
+        }
+    }
+
+    for (size_t j = 0; j < 3; j++) {
+        decode->offset[j] = min[j];
+        decode->scale[j] = max[j] - min[j];
+    }
+}
+
+/// @param[in] value
+/// @param[in] max Largest encoded value
+/// @return `value` clamped to `[0, 1]` and rounded to the nearest step
+static uint32_t vertexformat_unorm(float value, float max) {
+    return (uint32_t) lroundf(fminf(fmaxf(value, 0.0f), 1.0f) * max);
+}
+
+/// @param[in] vertex
+/// @param[in] decode
+/// @param[out] quantized
+static void vertexformat_quantize(
+    const struct vertexformat_vertex *vertex,
+    const struct vertexformat_decode *decode,
+    struct vertexformat_quantized *quantized
+) {
+    *quantized = (struct vertexformat_quantized){};
+
+    for (size_t j = 0; j < 3; j++) {
+        // A flat axis keeps every vertex at the offset
+        float relative = 0.0f;
+        if (decode->scale[j] > 0.0f) {
+            relative = (vertex->position[j] - decode->offset[j]) / decode->scale[j];
+        }
+        quantized->position[j] = (uint16_t) vertexformat_unorm(relative, 65535.0f);
+    }
+
+    vertexformat_octahedral(vertex->normal, quantized->normal);
+
+    quantized->uv[0] = vertexformat_half(vertex->uv[0]);
+    quantized->uv[1] = vertexformat_half(vertex->uv[1]);
+
+    for (size_t j = 0; j < 4; j++) {
+        quantized->color[j] = (uint8_t) vertexformat_unorm(vertex->color[j], 255.0f);
+    }
+}
+
+void vertexformat_encode(
+    enum vertexformat format,
+    const struct vertexformat_vertex *vertices,
+    size_t vertices_count,
+    const struct vertexformat_decode *decode,
+    void *data
+) {
+    switch (format) {
+    case VERTEXFORMAT_FLOAT32:
+        memcpy(data, vertices, sizeof(vertices[0]) * vertices_count);
+        break;
+    case VERTEXFORMAT_QUANTIZED: {
+        struct vertexformat_quantized *quantized = data;
+        for (size_t i = 0; i < vertices_count; i++) {
+            vertexformat_quantize(&vertices[i], decode, &quantized[i]);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+uint16_t vertexformat_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t biased = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (biased == 0xff) {
+        // Infinity stays infinity, NaN stays a quiet NaN
+        return (uint16_t) (sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+    }
+
+    int32_t exponent = (int32_t) biased - 127 + 15;
+    if (exponent >= 31) {
+        return (uint16_t) (sign | 0x7c00);
+    }
+
+    uint32_t half;
+    uint32_t remainder;
+    uint32_t halfway;
+    if (exponent <= 0) {
+        // Subnormal, or zero once the value is below half the smallest one
+        if (exponent < -10) {
+            return (uint16_t) sign;
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t) (14 - exponent);
+        half = mantissa >> shift;
+        remainder = mantissa & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    } else {
+        half = ((uint32_t) exponent << 10) | (mantissa >> 13);
+        remainder = mantissa & 0x1fff;
+        halfway = 0x1000;
+    }
+
+    // A carry out of the mantissa correctly bumps the exponent, up to infinity
+    if (remainder > halfway || (remainder == halfway && (half & 1) != 0)) {
+        half++;
+    }
+
+    return (uint16_t) (sign | half);
+}
+
+void vertexformat_octahedral(const float normal[3], int16_t encoded[2]) {
+    float length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+    float x = 0.0f;
+    float y = 0.0f;
+    if (length > 0.0f) {
+        x = normal[0] / length;
+        y = normal[1] / length;
+    }
+
+    // The lower hemisphere is folded over the diagonals of the upper one
+    if (normal[2] < 0.0f) {
+        float folded_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float folded_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    encoded[0] = (int16_t) lroundf(fminf(fmaxf(x, -1.0f), 1.0f) * 32767.0f);
+    encoded[1] = (int16_t) lroundf(fminf(fmaxf(y, -1.0f), 1.0f) * 32767.0f);
+}
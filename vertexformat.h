@@ -0,0 +1,98 @@
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+constexpr uint32_t VERTEXFORMAT_MAX_ATTRIBUTES = 4;
+
+/// Layout of the vertex buffer a pipeline reads. Attributes are bound to
+/// locations 0 to 3 as position, normal, UV and color, and every format
+/// decodes them to the same shader types.
+enum vertexformat {
+    /// No vertex buffer, the vertex shader generates its vertices
+    VERTEXFORMAT_NONE,
+    /// `vertexformat_vertex` as it is, 48 bytes per vertex
+    VERTEXFORMAT_FLOAT32,
+    /// `vertexformat_quantized`, 20 bytes per vertex
+    VERTEXFORMAT_QUANTIZED,
+    VERTEXFORMAT_COUNT,
+};
+
+/// Unquantized vertex as meshes are built or imported
+struct vertexformat_vertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+    float color[4];
+};
+
+/// Position as 16-bit unsigned normalized values relative to the bounds of the
+/// mesh, normal octahedrally encoded as two 16-bit signed normalized values,
+/// UV as half floats and color as 8-bit unsigned normalized values
+struct vertexformat_quantized {
+    /// The fourth component only pads the position to a widely supported
+    /// format
+    uint16_t position[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+    uint8_t color[4];
+};
+
+/// Push constants the vertex shader turns decoded positions into model space
+/// with: `position * scale + offset`
+struct vertexformat_decode {
+    float offset[4];
+    float scale[4];
+};
+
+/// @param[in] format
+/// @return Size of one vertex in bytes, zero for `VERTEXFORMAT_NONE`
+size_t vertexformat_stride(enum vertexformat format);
+
+/// @param[in] format
+/// @param[out] binding Binding 0
+/// @param[out] attributes
+/// @return Number of `attributes` written, zero for `VERTEXFORMAT_NONE`
+uint32_t vertexformat_input(
+    enum vertexformat format,
+    VkVertexInputBindingDescription *binding,
+    VkVertexInputAttributeDescription attributes[VERTEXFORMAT_MAX_ATTRIBUTES]
+);
+
+/// @param[in] format
+/// @param[in] vertices
+/// @param[in] vertices_count
+/// @param[out] decode The bounds of `vertices` for `VERTEXFORMAT_QUANTIZED`,
+/// identity otherwise
+void vertexformat_decode_compute(
+    enum vertexformat format,
+    const struct vertexformat_vertex *vertices,
+    size_t vertices_count,
+    struct vertexformat_decode *decode
+);
+
+/// @param[in] format
+/// @param[in] vertices
+/// @param[in] vertices_count
+/// @param[in] decode Taken from `vertexformat_decode_compute`
+/// @param[out] data `vertexformat_stride(format) * vertices_count` bytes
+void vertexformat_encode(
+    enum vertexformat format,
+    const struct vertexformat_vertex *vertices,
+    size_t vertices_count,
+    const struct vertexformat_decode *decode,
+    void *data
+);
+
+/// @param[in] value
+/// @return `value` as IEEE 754 half float, rounded to nearest even
+uint16_t vertexformat_half(float value);
+
+/// @param[in] normal Unit length
+/// @param[out] encoded Octahedral encoding as signed normalized values
+void vertexformat_octahedral(const float normal[3], int16_t encoded[2]);
+
+#endif